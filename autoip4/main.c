@@ -104,7 +104,7 @@ main(int argc, char **argv)
 				"  --log-level level\n"
 				"        Set log level to <error|warning|notice|info|debug>.\n"
 				"  --log-target target\n"
-				"        Set log destination to <stderr|syslog>.\n"
+				"        Set log destination to <stderr|syslog|journal|file>.\n"
 				"  --foreground\n"
 				"        Do not background the service.\n"
 				"  --recover\n"
@@ -260,6 +260,7 @@ autoip4_register_services(ni_dbus_server_t *server)
 
 	/* Register the root object /org/opensuse/Network/AUTO4 */
 	ni_dbus_object_register_service(root_object, &__wicked_dbus_autoip4_interface);
+	ni_objectmodel_metrics_init(server);
 
 	/* Register /org/opensuse/Network/AUTO4/Interface */
 	object = ni_dbus_server_register_object(server, "Interface", &ni_dbus_anonymous_class, NULL);
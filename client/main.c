@@ -147,7 +147,7 @@ main(int argc, char **argv)
 				"  --config filename\n"
 				"        Use alternative configuration file.\n"
 				"  --log-target target\n"
-				"        Set log destination to <stderr|syslog>.\n"
+				"        Set log destination to <stderr|syslog|journal|file>.\n"
 				"  --log-level level\n"
 				"        Set log level to <error|warning|notice|info|debug>.\n"
 				"  --debug facility\n"
@@ -181,6 +181,7 @@ main(int argc, char **argv)
 				"  iaid        <action> ...\n"
 				"  duid        <action> ...\n"
 				"  arp         <action> ...\n"
+				"  stats       [options]\n"
 				"\n"
 				, program);
 			goto done;
@@ -333,6 +334,9 @@ main(int argc, char **argv)
 	if (!strcmp(cmd, "ethtool")) {
 		status = ni_do_ethtool(program, argc - optind, argv + optind);
 	} else
+	if (!strcmp(cmd, "stats")) {
+		status = ni_do_stats(program, argc - optind, argv + optind);
+	} else
 	if (!strcmp(cmd, "bootstrap")) {
 		 status = ni_do_ifup(argc - optind, argv + optind);
 	} else {
@@ -407,7 +411,7 @@ struct ni_dbus_dict_entry {
 	ni_dbus_variant_t       datum;
 };
 
-static void	__dump_fake_xml(const ni_dbus_variant_t *, unsigned int, const char **);
+static void	__dump_fake_xml(xml_stream_t *, const ni_dbus_variant_t *, const char **);
 
 static const char *
 __fake_dbus_scalar_type(unsigned int type)
@@ -431,41 +435,32 @@ __fake_dbus_scalar_type(unsigned int type)
 }
 
 static void
-__dump_fake_xml_element(const ni_dbus_variant_t *var, unsigned int indent,
-				const char *open_tag, const char *close_tag,
+__dump_fake_xml_element(xml_stream_t *ws, const ni_dbus_variant_t *var,
+				const char *tag, const char *attr, const char *value,
 				const char **dict_elements)
 {
+	xml_stream_element_begin(ws, tag);
+	if (attr)
+		xml_stream_element_attr(ws, attr, value);
+
 	if (var->type == DBUS_TYPE_STRUCT) {
 		unsigned int i;
 
 		/* Must be a struct or union */
-		printf("%*.*s<%s>\n", indent, indent, "", open_tag);
 		for (i = 0; i < var->array.len; ++i) {
 			ni_dbus_variant_t *member = &var->struct_value[i];
-			char open_tag_buf[128], *member_open_tag;
 			const char *basic_type;
 
 			basic_type = __fake_dbus_scalar_type(member->type);
-			if (basic_type == NULL) {
-				member_open_tag = "member";
-			} else {
-				snprintf(open_tag_buf, sizeof(open_tag_buf), "member type=\"%s\"", basic_type);
-				member_open_tag = open_tag_buf;
-			}
-
-			__dump_fake_xml_element(member, indent + 2, member_open_tag, "member", NULL);
+			__dump_fake_xml_element(ws, member, "member",
+					basic_type ? "type" : NULL, basic_type, NULL);
 		}
-		printf("%*.*s</%s>\n", indent, indent, "", close_tag);
 	} else
 	if (var->type != DBUS_TYPE_ARRAY) {
 		/* Must be some type of scalar */
-		printf("%*.*s<%s>%s</%s>\n",
-				indent, indent, "",
-				open_tag,
-				ni_dbus_variant_sprint(var),
-				close_tag);
+		xml_stream_element_cdata(ws, ni_dbus_variant_sprint(var));
 	} else if(var->array.len == 0) {
-		printf("%*.*s<%s />\n", indent, indent, "", open_tag);
+		/* empty element */
 	} else if (ni_dbus_variant_is_byte_array(var)) {
 		unsigned char value[64];
 		unsigned int num_bytes;
@@ -477,20 +472,16 @@ __dump_fake_xml_element(const ni_dbus_variant_t *var, unsigned int indent,
 		} else {
 			display = ni_format_hex(value, num_bytes, display_buffer, sizeof(display_buffer));
 		}
-		printf("%*.*s<%s>%s</%s>\n",
-				indent, indent, "",
-				open_tag,
-				display,
-				close_tag);
+		xml_stream_element_cdata(ws, display);
 	} else {
-		printf("%*.*s<%s>\n", indent, indent, "", open_tag);
-		__dump_fake_xml(var, indent + 2, dict_elements);
-		printf("%*.*s</%s>\n", indent, indent, "", close_tag);
+		__dump_fake_xml(ws, var, dict_elements);
 	}
+
+	xml_stream_element_end(ws);
 }
 
 static void
-__dump_fake_xml(const ni_dbus_variant_t *variant, unsigned int indent, const char **dict_elements)
+__dump_fake_xml(xml_stream_t *ws, const ni_dbus_variant_t *variant, const char **dict_elements)
 {
 	ni_dbus_dict_entry_t *entry;
 	unsigned int index;
@@ -502,35 +493,35 @@ __dump_fake_xml(const ni_dbus_variant_t *variant, unsigned int indent, const cha
 			dict_element_tag = *dict_elements++;
 		for (entry = variant->dict_array_value, index = 0; index < variant->array.len; ++index, ++entry) {
 			const ni_dbus_variant_t *child = &entry->datum;
-			const char *open_tag, *close_tag;
-			char namebuf[256];
 
 			if (dict_element_tag) {
-				snprintf(namebuf, sizeof(namebuf), "%s name=\"%s\"", dict_element_tag, entry->key);
-				open_tag = namebuf;
-				close_tag = dict_element_tag;
+				__dump_fake_xml_element(ws, child, dict_element_tag,
+						"name", entry->key, dict_elements);
 			} else {
-				open_tag = close_tag = entry->key;
+				__dump_fake_xml_element(ws, child, entry->key,
+						NULL, NULL, dict_elements);
 			}
-
-			__dump_fake_xml_element(child, indent, open_tag, close_tag, dict_elements);
 		}
 	} else if (ni_dbus_variant_is_dict_array(variant)) {
 		const ni_dbus_variant_t *child;
 
 		for (child = variant->variant_array_value, index = 0; index < variant->array.len; ++index, ++child) {
-			printf("%*.*s<e>\n", indent, indent, "");
-			__dump_fake_xml(child, indent + 2, NULL);
-			printf("%*.*s</e>\n", indent, indent, "");
+			xml_stream_element_begin(ws, "e");
+			__dump_fake_xml(ws, child, NULL);
+			xml_stream_element_end(ws);
 		}
 	} else {
 		ni_trace("%s: %s", __func__, ni_dbus_variant_signature(variant));
 	}
 }
 
+/*
+ * Objects are printed one by one as they're converted,
+ * instead of collecting all of them in a single tree.
+ */
 static ni_bool_t
 __dump_object_xml(const char *object_path, const ni_dbus_variant_t *variant,
-	ni_xs_scope_t *schema, xml_node_t *parent, const ni_string_array_t *filter)
+	ni_xs_scope_t *schema, xml_stream_t *ws, const ni_string_array_t *filter)
 {
 	xml_node_t *object_node;
 	ni_dbus_dict_entry_t *entry;
@@ -566,33 +557,29 @@ __dump_object_xml(const char *object_path, const ni_dbus_variant_t *variant,
 	}
 
 	if (object_node->children)
-		xml_node_add_child(parent, object_node);
-	else
-		xml_node_free(object_node);
+		xml_stream_node(ws, object_node);
+	xml_node_free(object_node);
 	return TRUE;
 }
 
-static xml_node_t *
-__dump_schema_xml(const ni_dbus_variant_t *variant, ni_xs_scope_t *schema, const ni_string_array_t *filter)
+static ni_bool_t
+__dump_schema_xml(const ni_dbus_variant_t *variant, ni_xs_scope_t *schema,
+		xml_stream_t *ws, const ni_string_array_t *filter)
 {
-	xml_node_t *root = xml_node_new(NULL, NULL);
 	ni_dbus_dict_entry_t *entry;
 	unsigned int index;
 
 	if (!ni_dbus_variant_is_dict(variant)) {
 		ni_error("%s: dbus data is not a dict", __func__);
-		xml_node_free(root);
-		return NULL;
+		return FALSE;
 	}
 
 	for (entry = variant->dict_array_value, index = 0; index < variant->array.len; ++index, ++entry) {
-		if (!__dump_object_xml(entry->key, &entry->datum, schema, root, filter)) {
-			xml_node_free(root);
-			return NULL;
-		}
+		if (!__dump_object_xml(entry->key, &entry->datum, schema, ws, filter))
+			return FALSE;
 	}
 
-	return root;
+	return TRUE;
 }
 
 int
@@ -616,6 +603,7 @@ do_show_xml(int argc, char **argv)
 	ni_dbus_object_t *list_object, *object;
 	ni_dbus_variant_t result = NI_DBUS_VARIANT_INIT;
 	DBusError error = DBUS_ERROR_INIT;
+	xml_stream_t *ws = NULL;
 	int opt_raw = FALSE;
 #ifdef MODEM
 	int opt_modems = 0;
@@ -691,29 +679,29 @@ do_show_xml(int argc, char **argv)
 		goto out;
 	}
 
+	if (!(ws = xml_stream_open_file(stdout)))
+		goto out;
+
 	if (opt_raw) {
 		static const char *dict_element_tags[] = {
 			"object", "interface", NULL
 		};
 
-		__dump_fake_xml(&result, 0, dict_element_tags);
+		__dump_fake_xml(ws, &result, dict_element_tags);
 	} else {
 		ni_xs_scope_t *schema = ni_objectmodel_init(NULL);
-		xml_node_t *tree;
 
-		tree = __dump_schema_xml(&result, schema, &ifnames);
-		if (tree == NULL) {
+		if (!__dump_schema_xml(&result, schema, ws, &ifnames)) {
 			ni_error("unable to represent properties as xml");
 			goto out;
 		}
-
-		xml_node_print(tree, NULL);
-		xml_node_free(tree);
 	}
 
 	rv = 0;
 
 out:
+	if (ws && xml_stream_close(ws) < 0)
+		rv = 1;
 	ni_dbus_variant_destroy(&result);
 	return rv;
 }
@@ -0,0 +1,269 @@
+/*
+ *	wicked client runtime metrics command
+ *
+ *	Copyright (C) 2026 SUSE Linux GmbH, Nuernberg, Germany.
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	This program is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <getopt.h>
+#include <inttypes.h>
+
+#include <wicked/types.h>
+#include <wicked/util.h>
+#include <wicked/netinfo.h>
+#include <wicked/logging.h>
+#include <wicked/dbus.h>
+#include <wicked/dbus-errors.h>
+#include <wicked/objectmodel.h>
+#include "wicked-client.h"
+#include "main.h"
+
+static const struct ni_stats_service {
+	const char *	name;
+	const char *	bus_name;
+	const char *	object_path;
+} ni_stats_services[] = {
+	{ "wickedd",	NI_OBJECTMODEL_DBUS_BUS_NAME,		NI_OBJECTMODEL_OBJECT_PATH		},
+	{ "nanny",	NI_OBJECTMODEL_DBUS_BUS_NAME_NANNY,	NI_OBJECTMODEL_NANNY_PATH		},
+	{ "dhcp4",	NI_OBJECTMODEL_DBUS_BUS_NAME_DHCP4,	NI_OBJECTMODEL_OBJECT_ROOT "/DHCP4"	},
+	{ "dhcp6",	NI_OBJECTMODEL_DBUS_BUS_NAME_DHCP6,	NI_OBJECTMODEL_OBJECT_ROOT "/DHCP6"	},
+	{ "auto4",	NI_OBJECTMODEL_DBUS_BUS_NAME_AUTO4,	NI_OBJECTMODEL_OBJECT_ROOT "/AUTO4"	},
+	{ NULL,		NULL,					NULL					}
+};
+
+static const char *
+ni_stats_format_usec(uint64_t usec, char *buf, size_t size)
+{
+	if (usec < 1000)
+		snprintf(buf, size, "%"PRIu64"us", usec);
+	else
+	if (usec < 1000000)
+		snprintf(buf, size, "%.1fms", usec / 1000.0);
+	else
+		snprintf(buf, size, "%.2fs", usec / 1000000.0);
+	return buf;
+}
+
+/*
+ * Upper bound of the bucket containing the given percentile
+ */
+static const char *
+ni_stats_percentile(const ni_dbus_variant_t *buckets, uint64_t count,
+			unsigned int percent, char *buf, size_t size)
+{
+	const ni_dbus_variant_t *entry;
+	uint64_t seen = 0, hits, bound;
+	const char *name;
+	unsigned int i;
+
+	for (i = 0; (entry = ni_dbus_dict_get_entry(buckets, i, &name)); ++i) {
+		if (!ni_dbus_variant_get_uint64(entry, &hits))
+			continue;
+
+		seen += hits;
+		if (seen * 100 < count * percent)
+			continue;
+
+		if (ni_parse_uint64(name, &bound, 10) < 0)
+			return ">max";
+		snprintf(buf, size, "<=");
+		ni_stats_format_usec(bound, buf + 2, size - 2);
+		return buf;
+	}
+	return "-";
+}
+
+static void
+ni_stats_print(const char *service, const ni_dbus_variant_t *result)
+{
+	const ni_dbus_variant_t *metrics, *metric, *buckets;
+	const char *name, *type;
+	dbus_bool_t enabled = FALSE;
+	uint64_t value, sum;
+	unsigned int i;
+
+	ni_dbus_dict_get_bool(result, "enabled", &enabled);
+	printf("%s metrics are %s\n", service, enabled ? "enabled" : "disabled");
+
+	if (!(metrics = ni_dbus_dict_get(result, "metrics")))
+		return;
+
+	for (i = 0; (metric = ni_dbus_dict_get_entry(metrics, i, &name)); ++i) {
+		char avg[32], p50[32], p99[32];
+
+		if (!ni_dbus_dict_get_string(metric, "type", &type) ||
+		    !ni_dbus_dict_get_uint64(metric, "value", &value))
+			continue;
+
+		if (!ni_string_eq(type, "histogram")) {
+			printf("  %-28s %"PRIu64"\n", name, value);
+			continue;
+		}
+
+		sum = 0;
+		ni_dbus_dict_get_uint64(metric, "sum-usec", &sum);
+		buckets = ni_dbus_dict_get(metric, "buckets");
+		if (!value || !buckets) {
+			printf("  %-28s count 0\n", name);
+			continue;
+		}
+
+		printf("  %-28s count %-8"PRIu64" avg %-8s p50 %-10s p99 %s\n",
+				name, value,
+				ni_stats_format_usec(sum / value, avg, sizeof(avg)),
+				ni_stats_percentile(buckets, value, 50, p50, sizeof(p50)),
+				ni_stats_percentile(buckets, value, 99, p99, sizeof(p99)));
+	}
+}
+
+int
+ni_do_stats(const char *caller, int argc, char **argv)
+{
+	enum {	OPT_HELP = 'h', OPT_SERVICE = 's', OPT_OPENMETRICS = 'o',
+		OPT_RESET = 'r', OPT_ENABLE = 'e', OPT_DISABLE = 'd' };
+	static struct option	options[] = {
+		{ "help",	no_argument,		NULL,	OPT_HELP	},
+		{ "service",	required_argument,	NULL,	OPT_SERVICE	},
+		{ "openmetrics",no_argument,		NULL,	OPT_OPENMETRICS	},
+		{ "reset",	no_argument,		NULL,	OPT_RESET	},
+		{ "enable",	no_argument,		NULL,	OPT_ENABLE	},
+		{ "disable",	no_argument,		NULL,	OPT_DISABLE	},
+		{ NULL,		no_argument,		NULL,	0		}
+	};
+	const struct ni_stats_service *service = &ni_stats_services[0];
+	ni_dbus_variant_t result = NI_DBUS_VARIANT_INIT;
+	ni_dbus_variant_t arg = NI_DBUS_VARIANT_INIT;
+	DBusError error = DBUS_ERROR_INIT;
+	ni_bool_t openmetrics = FALSE, reset = FALSE;
+	ni_tristate_t enable = NI_TRISTATE_DEFAULT;
+	int opt = 0, status = NI_WICKED_RC_USAGE;
+	ni_dbus_client_t *client = NULL;
+	ni_dbus_object_t *object = NULL;
+	char *program = NULL;
+	const char *text;
+
+	ni_string_printf(&program, "%s %s", caller  ? caller  : "wicked",
+					    argv[0] ? argv[0] : "stats");
+	optind = 1;
+	argv[0] = program;
+	while ((opt = getopt_long(argc, argv, "+hs:ored", options, NULL)) != EOF) {
+		switch (opt) {
+		case OPT_SERVICE:
+			for (service = ni_stats_services; service->name; ++service) {
+				if (ni_string_eq(service->name, optarg))
+					break;
+			}
+			if (!service->name) {
+				fprintf(stderr, "%s: unknown service '%s'\n", program, optarg);
+				goto usage;
+			}
+			break;
+		case OPT_OPENMETRICS:
+			openmetrics = TRUE;
+			break;
+		case OPT_RESET:
+			reset = TRUE;
+			break;
+		case OPT_ENABLE:
+			ni_tristate_set(&enable, TRUE);
+			break;
+		case OPT_DISABLE:
+			ni_tristate_set(&enable, FALSE);
+			break;
+		case OPT_HELP:
+			status = NI_WICKED_RC_SUCCESS;
+			/* fall through */
+		default:
+		usage:
+			fprintf(stderr,
+				"\nUsage:\n"
+				"  %s [options]\n"
+				"\n"
+				"Options:\n"
+				"  --help, -h           show this help text and exit.\n"
+				"  --service, -s <name> query <wickedd|nanny|dhcp4|dhcp6|auto4>,\n"
+				"                       default is wickedd.\n"
+				"  --openmetrics, -o    print the metrics in OpenMetrics text format.\n"
+				"  --reset, -r          reset the metrics after printing them.\n"
+				"  --enable, -e         enable metrics collection in the service.\n"
+				"  --disable, -d        disable metrics collection in the service.\n"
+				"\n", program);
+			goto cleanup;
+		}
+	}
+	if (optind != argc)
+		goto usage;
+
+	status = NI_WICKED_RC_ERROR;
+	if (!(client = ni_create_dbus_client(service->bus_name))) {
+		fprintf(stderr, "%s: unable to connect to %s\n", program, service->bus_name);
+		goto cleanup;
+	}
+	object = ni_dbus_client_object_new(client, &ni_dbus_anonymous_class,
+				service->object_path, NI_OBJECTMODEL_METRICS_INTERFACE, NULL);
+	if (!object)
+		goto cleanup;
+
+	if (ni_tristate_is_set(enable)) {
+		ni_dbus_variant_set_bool(&arg, ni_tristate_is_enabled(enable));
+		if (!ni_dbus_object_call_variant(object, NULL, "setEnabled",
+						1, &arg, 0, NULL, &error)) {
+			ni_dbus_print_error(&error, "%s: unable to change metrics state", program);
+			goto cleanup;
+		}
+	}
+
+	if (openmetrics) {
+		if (!ni_dbus_object_call_variant(object, NULL, "getOpenMetrics",
+						0, NULL, 1, &result, &error) ||
+		    !ni_dbus_variant_get_string(&result, &text)) {
+			ni_dbus_print_error(&error, "%s: unable to get metrics", program);
+			goto cleanup;
+		}
+		fputs(text, stdout);
+	} else {
+		if (!ni_dbus_object_call_variant(object, NULL, "getMetrics",
+						0, NULL, 1, &result, &error)) {
+			ni_dbus_print_error(&error, "%s: unable to get metrics", program);
+			goto cleanup;
+		}
+		ni_stats_print(service->name, &result);
+	}
+
+	if (reset && !ni_dbus_object_call_variant(object, NULL, "reset",
+						0, NULL, 0, NULL, &error)) {
+		ni_dbus_print_error(&error, "%s: unable to reset metrics", program);
+		goto cleanup;
+	}
+	status = NI_WICKED_RC_SUCCESS;
+
+cleanup:
+	dbus_error_free(&error);
+	ni_dbus_variant_destroy(&arg);
+	ni_dbus_variant_destroy(&result);
+	if (object)
+		ni_dbus_object_free(object);
+	if (client)
+		ni_dbus_client_free(client);
+	argv[0] = NULL;
+	ni_string_free(&program);
+	return status;
+}
@@ -123,7 +123,7 @@ main(int argc, char **argv)
 				"  --log-level level\n"
 				"        Set log level to <error|warning|notice|info|debug>.\n"
 				"  --log-target target\n"
-				"        Set log destination to <stderr|syslog>.\n"
+				"        Set log destination to <stderr|syslog|journal|file>.\n"
 				"  --debug facility\n"
 				"        Enable debugging for debug <facility>.\n"
 				"        Use '--debug help' for a list of facilities.\n"
@@ -361,6 +361,7 @@ dhcp4_register_services(ni_dbus_server_t *server)
 
 	/* Register the root object /org/opensuse/Network/DHCP4 */
 	ni_dbus_object_register_service(root_object, &__ni_objectmodel_dhcp4_interface);
+	ni_objectmodel_metrics_init(server);
 
 	/* Register /org/opensuse/Network/DHCP4/Interface */
 	object = ni_dbus_server_register_object(server, "Interface", &ni_dbus_anonymous_class, NULL);
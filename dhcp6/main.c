@@ -142,7 +142,7 @@ main(int argc, char **argv)
 				"  --log-level level\n"
 				"        Set log level to <error|warning|notice|info|debug>.\n"
 				"  --log-target target\n"
-				"        Set log destination to <stderr|syslog>.\n"
+				"        Set log destination to <stderr|syslog|journal|file>.\n"
 				"  --foreground\n"
 				"        Do not background the service.\n"
 				"  --recover\n"
@@ -329,6 +329,7 @@ dhcp6_register_services(ni_dbus_server_t *server)
 
 	/*  Register the root object (org.opensuse.Network.DHCP6) */
 	ni_dbus_object_register_service(root_object, &__ni_objectmodel_dhcp6_interface);
+	ni_objectmodel_metrics_init(server);
 
 	/* Register /org/opensuse/Network/DHCP6/Interface */
 	object = ni_dbus_server_register_object(server, "Interface", &ni_dbus_anonymous_class, NULL);
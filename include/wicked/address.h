@@ -63,6 +63,15 @@ typedef struct ni_address_array {
 
 #define NI_ADDRESS_ARRAY_INIT	{ .count = 0, .data = NULL }
 
+typedef struct ni_address_index {
+	unsigned int		count;
+	ni_address_t **		data;		/* in the order added */
+	unsigned int		mask;
+	unsigned int *		slot;		/* data index + 1, 0 if empty */
+} ni_address_index_t;
+
+#define NI_ADDRESS_INDEX_INIT	{ .count = 0, .data = NULL, .mask = 0, .slot = NULL }
+
 extern ni_bool_t	ni_sockaddr_is_ipv4_loopback(const ni_sockaddr_t *);
 extern ni_bool_t	ni_sockaddr_is_ipv4_linklocal(const ni_sockaddr_t *);
 extern ni_bool_t	ni_sockaddr_is_ipv4_broadcast(const ni_sockaddr_t *);
@@ -162,6 +171,12 @@ extern unsigned int	ni_address_array_index(const ni_address_array_t *, const ni_
 extern ni_address_t *	ni_address_array_find_match(ni_address_array_t *, const ni_address_t *, unsigned int *,
 					ni_bool_t (*match)(const ni_address_t *, const ni_address_t *));
 
+extern void		ni_address_index_init(ni_address_index_t *);
+extern void		ni_address_index_destroy(ni_address_index_t *);
+extern void		ni_address_index_add(ni_address_index_t *, ni_address_t *);
+extern void		ni_address_index_add_list(ni_address_index_t *, ni_address_t *);
+extern ni_address_t *	ni_address_index_find(const ni_address_index_t *, const ni_sockaddr_t *, unsigned int *);
+
 extern const char *	ni_lifetime_print_valid(ni_stringbuf_t *, unsigned int);
 extern const char *	ni_lifetime_print_preferred(ni_stringbuf_t *, unsigned int);
 extern unsigned int	ni_lifetime_left(unsigned int, const struct timeval *, const struct timeval *);
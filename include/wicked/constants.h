@@ -39,6 +39,7 @@ enum {
 	NI_IFF_ARP_ENABLED		= 0x00000040,
 	NI_IFF_BROADCAST_ENABLED	= 0x00000080,
 	NI_IFF_MULTICAST_ENABLED	= 0x00000100,
+	NI_IFF_DETAILS_PENDING		= 0x00000200,
 };
 
 /*
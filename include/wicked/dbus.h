@@ -59,6 +59,9 @@ struct ni_dbus_variant {
 	};
 
 	ni_dbus_message_t *	__message;
+
+	/* key index of large dicts, built on demand by ni_dbus_dict_get */
+	struct ni_dbus_dict_index *__dict_index;
 };
 
 #define NI_DBUS_VARIANT_MAGIC	0x1234babe
@@ -350,6 +353,7 @@ extern void			ni_dbus_client_set_error_map(ni_dbus_client_t *, const ni_intmap_t
 extern int			ni_dbus_client_translate_error(ni_dbus_client_t *, const DBusError *);
 extern ni_dbus_message_t *	ni_dbus_client_call(ni_dbus_client_t *client, ni_dbus_message_t *call,
 					DBusError *error);
+extern int			ni_dbus_client_wait(ni_dbus_client_t *, unsigned int timeout);
 extern ni_dbus_object_t *	ni_dbus_client_object_new(ni_dbus_client_t *client,
 					const ni_dbus_class_t *,
 					const char *object_path,
@@ -39,6 +39,8 @@ extern unsigned int	ni_log_level_get(void);
 extern ni_bool_t	ni_log_destination(const char *program, const char *destination);
 extern void		ni_log_reopen(void);
 extern void		ni_log_close(void);
+extern int		ni_log_flush(void);
+extern unsigned long	ni_log_dropped(void);
 
 enum {
 	NI_LOG_ERROR,
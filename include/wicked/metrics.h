@@ -0,0 +1,108 @@
+/*
+ * Runtime metrics for the wicked daemons
+ *
+ * Copyright (C) 2026 SUSE Linux GmbH, Nuernberg, Germany.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/> or write
+ * to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ */
+#ifndef __WICKED_METRICS_H__
+#define __WICKED_METRICS_H__
+
+#include <stdint.h>
+#include <sys/time.h>
+#include <wicked/types.h>
+#include <wicked/util.h>
+#include <wicked/socket.h>
+
+/*
+ * The metrics are a fixed set of counters, gauges and latency
+ * histograms. The hooks cost a single flag test while disabled.
+ */
+typedef enum {
+	NI_METRIC_SOCKET_DISPATCH,
+	NI_METRIC_TIMER_CALLBACK,
+	NI_METRIC_RTEVENT_PROCESS,
+	NI_METRIC_NETLINK_TALK,
+	NI_METRIC_DBUS_DISPATCH,
+	NI_METRIC_PROCESS_START,
+	NI_METRIC_DHCP4_TRANSITIONS,
+	NI_METRIC_DHCP6_TRANSITIONS,
+	NI_METRIC_UPDATER_CALLS,
+	NI_METRIC_UPDATER_MERGED,
+	NI_METRIC_LOG_DROPPED,
+
+	__NI_METRIC_MAX
+} ni_metric_id_t;
+
+typedef enum {
+	NI_METRIC_COUNTER,
+	NI_METRIC_GAUGE,
+	NI_METRIC_HISTOGRAM,
+} ni_metric_type_t;
+
+/* log2 histogram buckets in usec: <=1us, <=2us, ... <=8.4s, +Inf */
+#define NI_METRIC_BUCKETS	24
+
+typedef struct ni_metric {
+	const char *		name;
+	ni_metric_type_t	type;
+	const char *		help;
+
+	uint64_t		value;		/* counter, gauge or histogram count */
+	uint64_t		sum;		/* histogram sum in usec */
+	uint64_t		bucket[NI_METRIC_BUCKETS + 1];
+} ni_metric_t;
+
+extern ni_bool_t		ni_metrics_enabled;
+
+extern void			ni_metrics_init(void);
+extern void			ni_metrics_enable(ni_bool_t);
+extern void			ni_metrics_reset(void);
+extern const ni_metric_t *	ni_metrics_get(ni_metric_id_t);
+extern const char *		ni_metric_type_to_name(ni_metric_type_t);
+extern uint64_t			ni_metric_bucket_bound(unsigned int);
+
+extern void			ni_metrics_add(ni_metric_id_t, uint64_t);
+extern void			ni_metrics_set(ni_metric_id_t, uint64_t);
+extern void			ni_metrics_observe(ni_metric_id_t, uint64_t usec);
+extern void			ni_metrics_observe_since(ni_metric_id_t, const struct timeval *);
+
+extern ni_bool_t		ni_metrics_format_openmetrics(ni_stringbuf_t *, const char *prefix);
+
+static inline void
+ni_metrics_begin(struct timeval *start)
+{
+	if (ni_metrics_enabled)
+		ni_timer_get_time(start);
+	else
+		timerclear(start);
+}
+
+static inline void
+ni_metrics_end(ni_metric_id_t id, const struct timeval *start)
+{
+	if (ni_metrics_enabled && timerisset(start))
+		ni_metrics_observe_since(id, start);
+}
+
+static inline void
+ni_metrics_count(ni_metric_id_t id)
+{
+	if (ni_metrics_enabled)
+		ni_metrics_add(id, 1);
+}
+
+#endif /* __WICKED_METRICS_H__ */
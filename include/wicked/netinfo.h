@@ -26,6 +26,7 @@ struct ni_slaveinfo {
 
 	union {
 	    ni_bonding_slave_info_t *	bond;
+	    ni_bridge_port_t *		bridge;
 	};
 };
 
@@ -139,6 +140,7 @@ extern int		ni_server_enable_interface_nduseropt_events(void (*handler)(ni_netde
 extern int		ni_server_enable_route_events(void (*handler)(ni_netconfig_t *, ni_event_t, const ni_route_t *));
 extern int		ni_server_enable_rule_events(void (*handler)(ni_netconfig_t *, ni_event_t, const ni_rule_t *));
 extern int		ni_server_enable_interface_uevents(void);
+extern int		ni_server_enable_ethtool_events(void);
 extern void		ni_server_disable_interface_uevents(void);
 extern void		ni_server_trace_interface_addr_events(ni_netdev_t *, ni_event_t, const ni_address_t *);
 extern void		ni_server_trace_interface_prefix_events(ni_netdev_t *, ni_event_t, const ni_ipv6_ra_pinfo_t *);
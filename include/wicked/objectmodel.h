@@ -25,6 +25,7 @@ extern ni_bool_t		ni_objectmodel_save_state(const char *);
 extern ni_bool_t		ni_objectmodel_recover_state(const char *, const char **);
 
 extern dbus_bool_t		ni_objectmodel_create_initial_objects(ni_dbus_server_t *);
+extern dbus_bool_t		ni_objectmodel_metrics_init(ni_dbus_server_t *);
 extern ni_dbus_object_t *	ni_objectmodel_register_netif(ni_dbus_server_t *, ni_netdev_t *ifp,
 					const ni_dbus_class_t *override_class);
 extern dbus_bool_t		ni_objectmodel_unregister_netif(ni_dbus_server_t *, ni_netdev_t *ifp);
@@ -103,6 +104,7 @@ extern ni_dbus_class_t *	ni_objectmodel_class_new(const char *, const ni_dbus_cl
 #define NI_OBJECTMODEL_MANAGED_NETIF_INTERFACE	NI_OBJECTMODEL_INTERFACE ".ManagedInterface"
 #define NI_OBJECTMODEL_MANAGED_MODEM_INTERFACE	NI_OBJECTMODEL_INTERFACE ".ManagedModem"
 #define NI_OBJECTMODEL_MANAGED_POLICY_INTERFACE	NI_OBJECTMODEL_INTERFACE ".ManagedPolicy"
+#define NI_OBJECTMODEL_METRICS_INTERFACE	NI_OBJECTMODEL_INTERFACE ".Metrics"
 
 /*
  * Signals emitted by addrconf services
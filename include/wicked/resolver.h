@@ -28,5 +28,13 @@ extern int			ni_resolve_hostnames_timed(int af, unsigned int count, const char *
 
 extern int			ni_resolve_reverse_timed(const ni_sockaddr_t *addr, char **name, unsigned int timeout);
 
+typedef struct ni_resolve_reverse	ni_resolve_reverse_t;
+typedef void			ni_resolve_reverse_callback_t(ni_resolve_reverse_t *, const char *hostname, void *user_data);
+
+extern ni_resolve_reverse_t *	ni_resolve_reverse_start(const ni_sockaddr_t *addr, unsigned int timeout,
+					ni_resolve_reverse_callback_t *callback, void *user_data);
+extern void			ni_resolve_reverse_cancel(ni_resolve_reverse_t *);
+extern void			ni_resolve_reverse_set_config(const char *resolv_conf, const char *hosts, unsigned int port);
+
 #endif /* __WICKED_RESOLVER_H__ */
 
@@ -99,6 +99,7 @@ extern int		ni_system_tunnel_change(ni_netconfig_t *, ni_netdev_t *,
 extern int		ni_system_tunnel_delete(ni_netdev_t *, unsigned int);
 
 extern int		ni_system_update_from_lease(const ni_addrconf_lease_t *, const unsigned int, const char *);
+extern ni_bool_t	ni_system_updater_stats(unsigned int, unsigned long *, unsigned long *);
 
 #endif /* __WICKED_SYSTEM_H__ */
 
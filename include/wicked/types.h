@@ -96,6 +96,7 @@ typedef struct xml_document		xml_document_t;
 typedef struct xml_document_array	xml_document_array_t;
 typedef struct xml_node			xml_node_t;
 typedef struct xml_location		xml_location_t;
+typedef struct xml_stream		xml_stream_t;
 
 typedef struct ni_xs_type		ni_xs_type_t;
 typedef struct ni_xs_scope		ni_xs_scope_t;
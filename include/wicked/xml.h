@@ -170,6 +170,23 @@ extern void		xml_node_array_free(xml_node_array_t *);
 extern xml_node_t*	xml_node_create(xml_node_t *, const char *);
 extern void		xml_node_dict_set(xml_node_t *, const char *, const char *);
 
+/*
+ * Buffered output stream; nodes are written as-is, elements can
+ * also be emitted directly without building a node tree first.
+ */
+extern xml_stream_t *	xml_stream_open_fd(int fd);
+extern xml_stream_t *	xml_stream_open_file(FILE *);
+extern xml_stream_t *	xml_stream_open_buffer(void);
+extern int		xml_stream_flush(xml_stream_t *);
+extern int		xml_stream_close(xml_stream_t *);
+extern char *		xml_stream_close_string(xml_stream_t *);
+extern void		xml_stream_document(xml_stream_t *, const xml_document_t *);
+extern void		xml_stream_node(xml_stream_t *, const xml_node_t *);
+extern void		xml_stream_element_begin(xml_stream_t *, const char *);
+extern void		xml_stream_element_attr(xml_stream_t *, const char *, const char *);
+extern void		xml_stream_element_cdata(xml_stream_t *, const char *);
+extern void		xml_stream_element_end(xml_stream_t *);
+
 /*
  * Static inline functions
  */
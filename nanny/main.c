@@ -113,7 +113,7 @@ main(int argc, char **argv)
 				"  --log-devel level\n"
 				"        Set log level to <error|warning|notice|info|debug>.\n"
 				"  --log-target target\n"
-				"        Set log destination to <stderr|syslog>.\n"
+				"        Set log destination to <stderr|syslog|journal|file>.\n"
 				"  --foreground\n"
 				"        Run as a foreground process, rather than as a daemon.\n"
 				"  --log-target target\n"
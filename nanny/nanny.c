@@ -58,6 +58,7 @@ ni_objectmodel_nanny_init(ni_nanny_t *mgr)
 	root_object->handle = mgr;
 	root_object->class = &ni_objectmodel_nanny_class;
 	ni_objectmodel_bind_compatible_interfaces(root_object);
+	ni_objectmodel_metrics_init(mgr->server);
 
 	{
 		unsigned int i;
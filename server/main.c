@@ -88,6 +88,7 @@ static ni_dbus_server_t *dbus_server;
 
 static void		run_interface_server(void);
 static void		discover_state(ni_dbus_server_t *);
+static void		discover_details_schedule(void);
 static void		recover_state(const char *filename);
 static void		handle_interface_event(ni_netdev_t *, ni_event_t);
 static void		handle_interface_addr_events(ni_netdev_t *, ni_event_t, const ni_address_t *);
@@ -125,7 +126,7 @@ main(int argc, char **argv)
 				"  --log-level level\n"
 				"        Set log level to <error|warning|notice|info|debug>.\n"
 				"  --log-target target\n"
-				"        Set log destination to <stderr|syslog>.\n"
+				"        Set log destination to <stderr|syslog|journal|file>.\n"
 				"  --foreground\n"
 				"        Tell the daemon to not background itself at startup.\n"
 				"  --recover\n"
@@ -254,6 +255,8 @@ run_interface_server(void)
 		ni_fatal("unable to initialize netlink prefix listener");
 	if (ni_server_enable_interface_nduseropt_events(handle_interface_nduseropt_events) < 0)
 		ni_fatal("unable to initialize netlink nduseropt listener");
+	if (ni_server_enable_ethtool_events() < 0)
+		ni_debug_events("ethtool netlink monitor not available, using ioctl");
 
 	if (ni_udev_is_active() && ni_udev_net_subsystem_available()) {
 		if (ni_server_enable_interface_uevents() < 0)
@@ -327,8 +330,51 @@ discover_udev_netdev_state(ni_netdev_t *dev)
 	/* query ethtool settings which are guarded by ready
 	 * flag (rules processed / already renamed by udev)
 	 * as ethtool is a query by ifname...
+	 * Deferred with the other link details at startup.
 	 */
-	ni_system_ethtool_refresh(dev);
+	if (!(dev->link.ifflags & NI_IFF_DETAILS_PENDING))
+		ni_system_ethtool_refresh(dev);
+}
+
+/*
+ * The link details (ethtool, wireless, teamd, ovs, ...) are not
+ * discovered at startup, but in batches from the main loop, after
+ * the dbus objects are registered. A method call on a device with
+ * pending details discovers them first, see netif class refresh.
+ */
+#define DISCOVER_DETAILS_BATCH		8
+
+static const ni_timer_t *		discover_details_timer;
+
+static void
+discover_details_run(void *user_data, const ni_timer_t *timer)
+{
+	ni_netconfig_t *nc = ni_global_state_handle(0);
+	unsigned int count = 0;
+	ni_netdev_t *dev;
+
+	if (discover_details_timer != timer)
+		return;
+	discover_details_timer = NULL;
+
+	for (dev = ni_netconfig_devlist(nc); dev; dev = dev->next) {
+		if (!(dev->link.ifflags & NI_IFF_DETAILS_PENDING))
+			continue;
+
+		if (count++ >= DISCOVER_DETAILS_BATCH) {
+			discover_details_schedule();
+			return;
+		}
+		ni_system_refresh_details(nc, dev);
+	}
+	ni_debug_events("deferred link details discovery finished");
+}
+
+static void
+discover_details_schedule(void)
+{
+	if (!discover_details_timer)
+		discover_details_timer = ni_timer_register(0, discover_details_run, NULL);
 }
 
 void
@@ -340,9 +386,14 @@ discover_state(ni_dbus_server_t *server)
 	ni_modem_t *modem;
 #endif
 
-	nc = ni_global_state_handle(1);
+	/* inventory of links and addresses first, details later */
+	if ((nc = ni_global_state_handle(0)) != NULL) {
+		ni_netconfig_set_discover_filter(nc, NI_NETCONFIG_DISCOVER_LINK_DEFER);
+		nc = ni_global_state_handle(1);
+	}
 	if (nc == NULL)
 		ni_fatal("failed to discover interface state");
+	ni_netconfig_clear_discover_filter(nc, NI_NETCONFIG_DISCOVER_LINK_DEFER);
 
 	if (server) {
 		for (ifp = ni_netconfig_devlist(nc); ifp; ifp = ifp->next) {
@@ -358,6 +409,7 @@ discover_state(ni_dbus_server_t *server)
 			ni_objectmodel_register_modem(server, modem);
 #endif
 	}
+	discover_details_schedule();
 }
 
 /*
@@ -670,6 +670,136 @@ ni_address_array_find_match(ni_address_array_t *array, const ni_address_t *ap, u
 }
 
 
+/*
+ * Address index: an open addressing hash of the addresses keyed by their
+ * local address. Used to match the addresses of a device against long
+ * lease address lists without walking the lists for every address.
+ * The index doesn't hold references; the indexed list must not change
+ * while the index is in use.
+ */
+static unsigned int
+ni_address_index_hash(const ni_sockaddr_t *ss)
+{
+	unsigned int hash = 2166136261U;	/* FNV-1a */
+	const unsigned char *data;
+	unsigned int len;
+
+	hash ^= ss->ss_family;
+	hash *= 16777619U;
+	if ((data = __ni_sockaddr_data(ss, &len)) != NULL) {
+		while (len--) {
+			hash ^= *data++;
+			hash *= 16777619U;
+		}
+	}
+	return hash;
+}
+
+/*
+ * Without deletions, linear probing keeps addresses with the same key
+ * in the order they've been added; rehashing them in that order too.
+ */
+static void
+ni_address_index_insert(ni_address_index_t *index, unsigned int i)
+{
+	unsigned int pos = ni_address_index_hash(&index->data[i]->local_addr) & index->mask;
+
+	while (index->slot[pos])
+		pos = (pos + 1) & index->mask;
+	index->slot[pos] = i + 1;
+}
+
+static void
+ni_address_index_realloc(ni_address_index_t *index, unsigned int count)
+{
+	unsigned int size, i;
+
+	for (size = NI_ADDRESS_ARRAY_CHUNK; size < 2 * count; size <<= 1)
+		;
+
+	free(index->slot);
+	index->mask = size - 1;
+	index->slot = xcalloc(size, sizeof(index->slot[0]));
+	index->data = xrealloc(index->data, (size / 2) * sizeof(index->data[0]));
+
+	for (i = 0; i < index->count; ++i)
+		ni_address_index_insert(index, i);
+}
+
+void
+ni_address_index_init(ni_address_index_t *index)
+{
+	memset(index, 0, sizeof(*index));
+}
+
+void
+ni_address_index_destroy(ni_address_index_t *index)
+{
+	free(index->data);
+	free(index->slot);
+	memset(index, 0, sizeof(*index));
+}
+
+void
+ni_address_index_add(ni_address_index_t *index, ni_address_t *ap)
+{
+	if (!ap)
+		return;
+
+	if (!index->slot || 2 * (index->count + 1) > index->mask + 1)
+		ni_address_index_realloc(index, index->count + 1);
+
+	index->data[index->count] = ap;
+	ni_address_index_insert(index, index->count++);
+}
+
+void
+ni_address_index_add_list(ni_address_index_t *index, ni_address_t *list)
+{
+	unsigned int count = index->count + ni_address_list_count(list);
+
+	if (!index->slot || 2 * count > index->mask + 1)
+		ni_address_index_realloc(index, count);
+
+	for ( ; list; list = list->next) {
+		index->data[index->count] = list;
+		ni_address_index_insert(index, index->count++);
+	}
+}
+
+/*
+ * Return the next indexed address with the given local address, in the
+ * order they've been added. *pos is the iteration state and has to be
+ * set to 0 to get the first match.
+ */
+ni_address_t *
+ni_address_index_find(const ni_address_index_t *index, const ni_sockaddr_t *addr, unsigned int *pos)
+{
+	unsigned int hash, step = pos ? *pos : 0;
+	ni_address_t *ap;
+
+	if (!index || !index->slot || !addr)
+		return NULL;
+
+	hash = ni_address_index_hash(addr);
+	for (; step <= index->mask; ++step) {
+		unsigned int i = index->slot[(hash + step) & index->mask];
+
+		if (!i)
+			break;
+
+		ap = index->data[i - 1];
+		if (ni_sockaddr_equal(&ap->local_addr, addr)) {
+			if (pos)
+				*pos = step + 1;
+			return ap;
+		}
+	}
+	if (pos)
+		*pos = step;
+	return NULL;
+}
+
 /*
  * ni_af_sockaddr functions
  */
@@ -26,6 +26,8 @@ struct ni_c_binding {
 	char *			symbol;
 };
 
+typedef struct ni_extension_worker ni_extension_worker_t;
+
 typedef struct ni_config_fslocation {
 	char *			path;
 	unsigned int		mode;
@@ -43,9 +45,16 @@ struct ni_extension {
 	/* Format type. Only in use by system-updater. */
 	char *			format;
 
+	/* Settle window in msec. Only in use by system-updater. */
+	unsigned int		settle;
+
 	/* Shell commands */
 	ni_script_action_t *	actions;
 
+	/* Persistent worker serving the shell command actions */
+	ni_shellcmd_t *		worker_cmd;
+	ni_extension_worker_t *	worker;
+
 	/* C bindings */
 	ni_c_binding_t *	c_bindings;
 
@@ -227,6 +236,12 @@ extern void		ni_extension_free(ni_extension_t *);
 extern void		ni_c_binding_free(ni_c_binding_t *);
 extern void *		ni_c_binding_get_address(const ni_c_binding_t *);
 
+typedef void		ni_extension_worker_callback_t(void *, const xml_node_t *);
+
+extern ni_bool_t	ni_extension_worker_call(ni_extension_t *, xml_node_t *,
+				ni_extension_worker_callback_t *, void *);
+extern void		ni_extension_worker_stop(ni_extension_t *);
+
 extern ni_shellcmd_t *	ni_extension_script_new(ni_extension_t *, const char *name, const char *command);
 extern ni_shellcmd_t *	ni_extension_script_find(ni_extension_t *, const char *);
 extern const ni_c_binding_t *ni_extension_find_c_binding(const ni_extension_t *, const char *name);
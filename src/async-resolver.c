@@ -12,15 +12,26 @@
 #include <wicked/logging.h>
 #include <wicked/socket.h>
 #include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
 
 #include <sys/types.h>
-#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/nameser.h>
+#include <resolv.h>
 #include <unistd.h>
-#include <signal.h>
+#include <net/if.h>
 #include <netdb.h>
 #include <errno.h>
-#include <poll.h>
+#ifdef HAVE_GETRANDOM
+#include <sys/random.h>
+#endif
+
+#include "socket_priv.h"
+#include "util_priv.h"
 
 
 /*
@@ -234,154 +245,865 @@ __ni_resolve_reverse(const ni_sockaddr_t *addr, char **hostname)
 	return ret;
 }
 
-static void
-__ni_resolve_reverse_sigchild(int sig)
+
+/*
+ * In-process reverse resolver.
+ *
+ * getnameinfo does not accept any timeout, so we look up the address
+ * in the hosts file first and then send PTR queries over UDP to the
+ * nameservers from resolv.conf ourselves. As the answer may end up as
+ * the system hostname, each query is sent from a socket of its own, so
+ * it gets a fresh random source port from the kernel, and uses a query
+ * id from getrandom; both have to be guessed by an off-path spoofer.
+ * The sockets are watched by the socket event loop; a query is
+ * retransmitted to the next nameserver when no reply arrived within
+ * its share of the timeout. Replies are matched by query id, server
+ * address and question. The callback is invoked from the event loop.
+ * To not overrun the nameservers when many leases arrive at once, the
+ * number of queries in flight is limited; further requests are queued
+ * and their timeout starts when they are sent.
+ */
+#define NI_RESOLVE_REVERSE_ATTEMPTS	2	/* tries per nameserver */
+#define NI_RESOLVE_REVERSE_RETRANS_MIN	100	/* msec */
+#define NI_RESOLVE_REVERSE_INFLIGHT_MAX	64
+#define NI_RESOLVE_REVERSE_REPLY_MAX	4096
+
+typedef struct ni_resolve_reverse_ctx	ni_resolve_reverse_ctx_t;
+
+struct ni_resolve_reverse_ctx {
+	ni_socket_array_t *		array;
+	unsigned int			inflight;
+	ni_resolve_reverse_t *		requests;
+};
+
+struct ni_resolve_reverse {
+	ni_resolve_reverse_t *		next;
+	ni_resolve_reverse_ctx_t *	ctx;
+	ni_socket_t *			sock;
+	int				family;
+
+	ni_sockaddr_t			addr;
+	char *				hostname;
+	ni_bool_t			queued;
+	ni_bool_t			inflight;
+	ni_bool_t			done;
+
+	uint16_t			id;
+	unsigned char			query[PACKETSZ];
+	size_t				qlen;
+
+	unsigned int			nservers;
+	ni_sockaddr_t			servers[MAXNS];
+	unsigned int			tries;
+	unsigned int			max_tries;
+	unsigned int			timeout;
+	unsigned int			retrans;
+	struct timeval			resend;
+	struct timeval			deadline;
+
+	ni_resolve_reverse_callback_t *	callback;
+	void *				user_data;
+};
+
+static struct {
+	char *				resolv_conf;
+	char *				hosts;
+	uint16_t			port;
+
+	ni_bool_t			loaded;
+	struct stat			stat;
+	unsigned int			count;
+	ni_sockaddr_t			servers[MAXNS];
+} ni_resolve_reverse_conf = {
+	.port				= NAMESERVER_PORT,
+};
+
+static ni_resolve_reverse_ctx_t		ni_resolve_reverse_global;
+
+/*
+ * Override the resolv.conf and hosts files and the nameserver port;
+ * NULL and 0 select the defaults.
+ */
+void
+ni_resolve_reverse_set_config(const char *resolv_conf, const char *hosts, unsigned int port)
 {
-	(void)sig;
+	ni_string_dup(&ni_resolve_reverse_conf.resolv_conf, resolv_conf);
+	ni_string_dup(&ni_resolve_reverse_conf.hosts, hosts);
+	ni_resolve_reverse_conf.port = port && port <= 0xffff ? port : NAMESERVER_PORT;
+	ni_resolve_reverse_conf.loaded = FALSE;
 }
 
-static int
-__ni_resolve_reverse_exec(const ni_sockaddr_t *addr)
+static ni_bool_t
+ni_resolve_reverse_parse_server(ni_sockaddr_t *ss, const char *string, uint16_t port)
+{
+	char *addr = NULL, *scope;
+	ni_bool_t ret = FALSE;
+
+	if (!ni_string_dup(&addr, string) || !addr)
+		return FALSE;
+
+	if ((scope = strchr(addr, '%')))
+		*scope++ = '\0';
+
+	if (ni_sockaddr_parse(ss, addr, AF_UNSPEC) == 0) {
+		switch (ss->ss_family) {
+		case AF_INET:
+			ss->sin.sin_port = htons(port);
+			ret = TRUE;
+			break;
+		case AF_INET6:
+			ss->six.sin6_port = htons(port);
+			if (scope && !(ss->six.sin6_scope_id = if_nametoindex(scope)))
+				ss->six.sin6_scope_id = strtoul(scope, NULL, 10);
+			ret = TRUE;
+			break;
+		default:
+			break;
+		}
+	}
+	ni_string_free(&addr);
+	return ret;
+}
+
+/*
+ * Return the nameservers to query, re-reading resolv.conf when it
+ * has been changed. Without any, the local host is asked (as the
+ * libc resolver does).
+ */
+static unsigned int
+ni_resolve_reverse_servers(ni_sockaddr_t *servers)
 {
-	char *hostname = NULL;
+	const char *filename = ni_resolve_reverse_conf.resolv_conf ?
+				ni_resolve_reverse_conf.resolv_conf : _PATH_RESOLV_CONF;
+	uint16_t port = ni_resolve_reverse_conf.port;
+	ni_resolver_info_t *resolv = NULL;
+	struct stat st;
+	unsigned int i;
+
+	if (stat(filename, &st) < 0)
+		memset(&st, 0, sizeof(st));
+
+	if (!ni_resolve_reverse_conf.loaded ||
+	    st.st_dev   != ni_resolve_reverse_conf.stat.st_dev   ||
+	    st.st_ino   != ni_resolve_reverse_conf.stat.st_ino   ||
+	    st.st_size  != ni_resolve_reverse_conf.stat.st_size  ||
+	    st.st_mtime != ni_resolve_reverse_conf.stat.st_mtime ||
+	    st.st_mtim.tv_nsec != ni_resolve_reverse_conf.stat.st_mtim.tv_nsec) {
+		ni_resolve_reverse_conf.stat = st;
+		ni_resolve_reverse_conf.loaded = TRUE;
+		ni_resolve_reverse_conf.count = 0;
+
+		if (st.st_ino && (resolv = ni_resolver_parse_resolv_conf(filename))) {
+			for (i = 0; i < resolv->dns_servers.count; ++i) {
+				ni_sockaddr_t *ss;
+
+				if (ni_resolve_reverse_conf.count >= MAXNS)
+					break;
+
+				ss = &ni_resolve_reverse_conf.servers[ni_resolve_reverse_conf.count];
+				if (ni_resolve_reverse_parse_server(ss, resolv->dns_servers.data[i], port))
+					ni_resolve_reverse_conf.count++;
+			}
+			ni_resolver_info_free(resolv);
+		}
+		if (!ni_resolve_reverse_conf.count) {
+			struct in_addr loopback = { .s_addr = htonl(INADDR_LOOPBACK) };
+
+			ni_sockaddr_set_ipv4(&ni_resolve_reverse_conf.servers[0], loopback, port);
+			ni_resolve_reverse_conf.count = 1;
+		}
+	}
 
-	if (__ni_resolve_reverse(addr, &hostname) == 0) {
-		fputs(hostname, stdout);
-		fflush(stdout);
-		ni_string_free(&hostname);
+	for (i = 0; i < ni_resolve_reverse_conf.count; ++i)
+		servers[i] = ni_resolve_reverse_conf.servers[i];
+	return ni_resolve_reverse_conf.count;
+}
+
+/*
+ * Look up the (first) name of the address in the hosts file
+ */
+static ni_bool_t
+ni_resolve_reverse_hosts(const ni_sockaddr_t *addr, char **hostname)
+{
+	const char *filename = ni_resolve_reverse_conf.hosts ?
+				ni_resolve_reverse_conf.hosts : _PATH_HOSTS;
+	ni_bool_t found = FALSE;
+	char buffer[1024];
+	FILE *fp;
+
+	if ((fp = fopen(filename, "re")) == NULL)
+		return FALSE;
+
+	while (!found && fgets(buffer, sizeof(buffer), fp) != NULL) {
+		char *address, *name;
+		ni_sockaddr_t ss;
+
+		buffer[strcspn(buffer, "#\r\n")] = '\0';
+		if (!(address = strtok(buffer, " \t")) || !(name = strtok(NULL, " \t")))
+			continue;
+
+		address[strcspn(address, "%")] = '\0';
+		if (ni_sockaddr_parse(&ss, address, addr->ss_family) < 0)
+			continue;
+		if (!ni_sockaddr_equal(&ss, addr))
+			continue;
+
+		if (ni_check_domain_name(name, strlen(name), 0))
+			found = ni_string_dup(hostname, name);
+	}
+	fclose(fp);
+	return found;
+}
+
+/*
+ * Build the PTR query message for the address
+ */
+static size_t
+ni_resolve_reverse_build_query(const ni_sockaddr_t *addr, uint16_t id,
+				unsigned char *msg, size_t size)
+{
+	ni_stringbuf_t name = NI_STRINGBUF_INIT_DYNAMIC;
+	const unsigned char *ap;
+	char *label, *dot;
+	size_t len;
+	int i;
+
+	switch (addr->ss_family) {
+	case AF_INET:
+		ap = (const unsigned char *)&addr->sin.sin_addr;
+		for (i = 3; i >= 0; --i)
+			ni_stringbuf_printf(&name, "%u.", ap[i]);
+		ni_stringbuf_puts(&name, "in-addr.arpa");
+		break;
+	case AF_INET6:
+		ap = (const unsigned char *)&addr->six.sin6_addr;
+		for (i = 15; i >= 0; --i)
+			ni_stringbuf_printf(&name, "%x.%x.", ap[i] & 0x0f, ap[i] >> 4);
+		ni_stringbuf_puts(&name, "ip6.arpa");
+		break;
+	default:
 		return 0;
 	}
-	return 2;
+
+	/* header: id, recursion desired, one question */
+	memset(msg, 0, HFIXEDSZ);
+	msg[0] = id >> 8;
+	msg[1] = id & 0xff;
+	msg[2] = 0x01;
+	msg[5] = 1;
+	len = HFIXEDSZ;
+
+	/* question: name labels, type PTR, class IN */
+	for (label = name.string; label; label = dot) {
+		size_t n;
+
+		if ((dot = strchr(label, '.')))
+			*dot++ = '\0';
+		n = strlen(label);
+		msg[len++] = n;
+		memcpy(msg + len, label, n);
+		len += n;
+	}
+	ni_stringbuf_destroy(&name);
+	msg[len++] = 0;
+	msg[len++] = T_PTR >> 8;
+	msg[len++] = T_PTR & 0xff;
+	msg[len++] = C_IN >> 8;
+	msg[len++] = C_IN & 0xff;
+
+	return len <= size ? len : 0;
 }
 
-static int
-__ni_resolve_reverse_read(int fd, char **hostname, unsigned int timeout)
+/*
+ * Expand a (compressed) domain name in a reply; without a buffer,
+ * the name is just skipped.
+ */
+static ni_bool_t
+ni_resolve_reverse_get_name(const unsigned char *msg, size_t len, size_t *pos,
+				char *name, size_t size)
 {
-	char hbuf[NI_MAXHOST+1] = {'\0'};
-	struct pollfd pfd[1] = { { fd, POLLIN, 0 } };
-	struct timeval now, tv;
-	ssize_t len;
-	int rc;
+	unsigned int jumps = 0;
+	size_t p = *pos, end = 0, n = 0;
+	unsigned char l;
+
+	while (TRUE) {
+		if (p >= len)
+			return FALSE;
+
+		l = msg[p];
+		if ((l & 0xc0) == 0xc0) {
+			if (p + 1 >= len || ++jumps > 64)
+				return FALSE;
+			if (!end)
+				end = p + 2;
+			p = ((l & 0x3f) << 8) | msg[p + 1];
+			continue;
+		}
+		if (l & 0xc0)
+			return FALSE;
 
-	ni_timer_get_time(&tv);
-	tv.tv_sec += timeout;
-	timeout *= 1000;
+		p++;
+		if (l == 0)
+			break;
+		if (p + l > len)
+			return FALSE;
+
+		if (name) {
+			if (n + l + 2 > size)
+				return FALSE;
+			if (memchr(msg + p, '.', l) || memchr(msg + p, '\0', l))
+				return FALSE;
+			if (n)
+				name[n++] = '.';
+			memcpy(name + n, msg + p, l);
+			n += l;
+		}
+		p += l;
+	}
+	if (name)
+		name[n] = '\0';
 
-	while ((rc = poll(pfd, 1, timeout)) == -1 && errno == EINTR) {
-		ni_timer_get_time(&now);
-		if (timercmp(&tv, &now, <)) {
-			timeout = 0;
-		} else {
-			struct timeval delta;
-			long delta_ms;
+	*pos = end ? end : p;
+	return TRUE;
+}
 
-			timersub(&tv, &now, &delta);
-			delta_ms = 1000 * delta.tv_sec + delta.tv_usec / 1000;
-			if (delta_ms < timeout)
-				timeout = delta_ms;
+static inline unsigned int
+ni_resolve_reverse_get16(const unsigned char *p)
+{
+	return (p[0] << 8) | p[1];
+}
+
+/* names in the question are case insensitive, the binary parts equal */
+static ni_bool_t
+ni_resolve_reverse_question_eq(const unsigned char *q1, const unsigned char *q2, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; ++i) {
+		if (q1[i] != q2[i] && tolower(q1[i]) != tolower(q2[i]))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+static void
+ni_resolve_reverse_complete(ni_resolve_reverse_t *req, const char *hostname)
+{
+	if (hostname)
+		ni_string_dup(&req->hostname, hostname);
+	req->done = TRUE;
+	ni_timer_get_time(&req->deadline);
+	req->resend = req->deadline;
+}
+
+/*
+ * Map a nameserver to the socket address family and back
+ */
+static ni_bool_t
+ni_resolve_reverse_server_dest(int family, const ni_sockaddr_t *server,
+				ni_sockaddr_t *dest, socklen_t *alen)
+{
+	if (server->ss_family == family) {
+		*dest = *server;
+	} else
+	if (server->ss_family == AF_INET && family == AF_INET6) {
+		struct in6_addr mapped = IN6ADDR_ANY_INIT;
+
+		mapped.s6_addr[10] = mapped.s6_addr[11] = 0xff;
+		memcpy(&mapped.s6_addr[12], &server->sin.sin_addr, 4);
+		ni_sockaddr_set_ipv6(dest, mapped, ntohs(server->sin.sin_port));
+	} else {
+		return FALSE;
+	}
+	*alen = family == AF_INET6 ? sizeof(dest->six) : sizeof(dest->sin);
+	return TRUE;
+}
+
+static ni_bool_t
+ni_resolve_reverse_from_server(const ni_resolve_reverse_t *req, const ni_sockaddr_t *from)
+{
+	ni_sockaddr_t addr = *from;
+	unsigned int i;
+
+	if (addr.ss_family == AF_INET6 && IN6_IS_ADDR_V4MAPPED(&from->six.sin6_addr)) {
+		struct in_addr ipv4;
+
+		memcpy(&ipv4, &from->six.sin6_addr.s6_addr[12], 4);
+		ni_sockaddr_set_ipv4(&addr, ipv4, ntohs(from->six.sin6_port));
+	}
+
+	for (i = 0; i < req->nservers; ++i) {
+		const ni_sockaddr_t *server = &req->servers[i];
+
+		if (!ni_sockaddr_equal(server, &addr))
+			continue;
+		if (addr.ss_family == AF_INET && server->sin.sin_port == addr.sin.sin_port)
+			return TRUE;
+		if (addr.ss_family == AF_INET6 && server->six.sin6_port == addr.six.sin6_port)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/*
+ * (Re)transmit the query to the next nameserver
+ */
+static ni_bool_t
+ni_resolve_reverse_send(ni_resolve_reverse_t *req)
+{
+	while (req->tries < req->max_tries && req->sock) {
+		const ni_sockaddr_t *server = &req->servers[req->tries++ % req->nservers];
+		ni_sockaddr_t dest;
+		socklen_t alen;
+
+		if (!ni_resolve_reverse_server_dest(req->family, server, &dest, &alen))
+			continue;
+
+		if (sendto(req->sock->__fd, req->query, req->qlen, 0, &dest.sa, alen) < 0) {
+			ni_debug_socket("unable to send reverse query for %s to %s: %m",
+					ni_sockaddr_print(&req->addr), ni_sockaddr_print(server));
+			continue;
+		}
+
+		ni_timer_get_time(&req->resend);
+		req->resend.tv_sec  += req->retrans / 1000;
+		req->resend.tv_usec += (req->retrans % 1000) * 1000;
+		if (req->resend.tv_usec >= 1000000) {
+			req->resend.tv_sec++;
+			req->resend.tv_usec -= 1000000;
 		}
+		return TRUE;
+	}
+	return FALSE;
+}
+
+static void
+ni_resolve_reverse_reply(ni_resolve_reverse_t *req, const unsigned char *msg,
+				size_t len, const ni_sockaddr_t *from)
+{
+	char name[NS_MAXDNAME];
+	unsigned int id, flags, ancount, i;
+	size_t pos;
+
+	if (len < HFIXEDSZ)
+		return;
+
+	id = ni_resolve_reverse_get16(msg);
+	flags = ni_resolve_reverse_get16(msg + 2);
+	ancount = ni_resolve_reverse_get16(msg + 6);
+
+	/* a standard query response to a single question */
+	if (!(flags & 0x8000) || (flags & 0x7800) || ni_resolve_reverse_get16(msg + 4) != 1)
+		return;
+
+	if (req->done || req->id != id || len < req->qlen)
+		return;
+	if (!ni_resolve_reverse_question_eq(msg + HFIXEDSZ, req->query + HFIXEDSZ,
+				req->qlen - HFIXEDSZ))
+		return;
+	if (!ni_resolve_reverse_from_server(req, from))
+		return;
+
+	switch (flags & 0x000f) {
+	case NOERROR:
+		for (i = 0, pos = req->qlen; i < ancount; ++i) {
+			unsigned int type, class, rdlen;
+			size_t rpos;
+
+			if (!ni_resolve_reverse_get_name(msg, len, &pos, NULL, 0))
+				break;
+			if (pos + RRFIXEDSZ > len)
+				break;
+
+			type  = ni_resolve_reverse_get16(msg + pos);
+			class = ni_resolve_reverse_get16(msg + pos + 2);
+			rdlen = ni_resolve_reverse_get16(msg + pos + 8);
+			pos  += RRFIXEDSZ;
+			if (pos + rdlen > len)
+				break;
+
+			rpos = pos;
+			pos += rdlen;
+			if (type != T_PTR || class != C_IN)
+				continue;
+
+			if (!ni_resolve_reverse_get_name(msg, len, &rpos, name, sizeof(name)))
+				continue;
+			if (!ni_check_domain_name(name, strlen(name), 0))
+				continue;
+
+			ni_resolve_reverse_complete(req, name);
+			return;
+		}
+		/* a truncated reply may have lost the answer, ask the next server */
+		if (flags & 0x0200)
+			break;
+		/* fall through */
+	case NXDOMAIN:
+		ni_resolve_reverse_complete(req, NULL);
+		return;
+
+	default:
+		break;
 	}
-	if (rc == 1 && pfd[0].revents & POLLIN) {
-		len = read(pfd[0].fd, hbuf, sizeof(hbuf) - 1);
-		if (len > 0 && ni_check_domain_name(hbuf, len, 0)) {
-			ni_string_dup(hostname, hbuf);
-			return 0;
+
+	/* server failure, refused, ... try the next one right away */
+	ni_timer_get_time(&req->resend);
+}
+
+static void
+ni_resolve_reverse_recv(ni_socket_t *sock)
+{
+	ni_resolve_reverse_t *req = sock->user_data;
+	unsigned char msg[NI_RESOLVE_REVERSE_REPLY_MAX];
+	ni_sockaddr_t from;
+	socklen_t alen;
+	ssize_t len;
+
+	while (TRUE) {
+		memset(&from, 0, sizeof(from));
+		alen = sizeof(from);
+		len = recvfrom(sock->__fd, msg, sizeof(msg), 0, &from.sa, &alen);
+		if (len < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno != EAGAIN && errno != EWOULDBLOCK)
+				ni_debug_socket("reverse resolver receive error: %m");
+			break;
 		}
+		ni_resolve_reverse_reply(req, msg, len, &from);
 	}
-	return -1;
 }
 
-int
-__ni_resolve_reverse_reap(pid_t pid)
-{
-	int status = -1;
-	int count = 4;
-
-	while (count--) {
-		if (waitpid(pid, &status, WNOHANG) == pid) {
-			if (WIFEXITED(status))
-				return WEXITSTATUS(status);
-			else
-				return -1;
-		} else if (count == 2) {
-			kill(pid, SIGHUP);
-		} else if (count == 1) {
-			if (kill(pid, SIGKILL) < 0) {
-				ni_error("Unable to kill reverse resolver");
-			}
+static ni_bool_t	ni_resolve_reverse_open(ni_resolve_reverse_t *);
+
+static void
+ni_resolve_reverse_close(ni_resolve_reverse_t *req)
+{
+	if (req->sock) {
+		req->sock->user_data = NULL;
+		ni_socket_close(req->sock);
+		req->sock = NULL;
+	}
+}
+
+static void
+ni_resolve_reverse_free(ni_resolve_reverse_t *req)
+{
+	ni_resolve_reverse_close(req);
+	ni_string_free(&req->hostname);
+	free(req);
+}
+
+static void
+ni_resolve_reverse_unlink(ni_resolve_reverse_t *req)
+{
+	ni_resolve_reverse_t **pos;
+
+	for (pos = &req->ctx->requests; *pos; pos = &(*pos)->next) {
+		if (*pos == req) {
+			*pos = req->next;
+			break;
 		}
-		usleep(10000);
 	}
-	ni_error("Unable to reap reverse resolver");
-	return -1;
+	req->next = NULL;
+
+	if (req->inflight) {
+		req->inflight = FALSE;
+		req->ctx->inflight--;
+	}
 }
 
 /*
- * Timed IP address reverse resolve hack (see bnc#861476)
- * Unfortunately getnameinfo does not accept any timeout...
- * Any better ideas how to implement this?
+ * Send the queued requests (oldest first) while below the limit
  */
-int
-ni_resolve_reverse_timed(const ni_sockaddr_t *addr, char **hostname, unsigned int timeout)
+static void
+ni_resolve_reverse_dispatch(ni_resolve_reverse_ctx_t *ctx)
 {
-	struct sigaction old, new;
-	int fd[2], fds, rc;
-	pid_t pid;
+	ni_resolve_reverse_t *req;
 
-	if (!timeout)
-		return __ni_resolve_reverse(addr, hostname);
+	for (req = ctx->requests; req; req = req->next) {
+		if (ctx->inflight >= NI_RESOLVE_REVERSE_INFLIGHT_MAX)
+			break;
+		if (!req->queued)
+			continue;
 
-	rc = socketpair(AF_UNIX, SOCK_STREAM, PF_LOCAL, fd);
-	if (rc < 0)
-		return -1;
+		/* no socket now, retried when the next request starts or ends */
+		if (!ni_resolve_reverse_open(req))
+			break;
 
-	new.sa_flags   = 0;
-	new.sa_handler = __ni_resolve_reverse_sigchild;
-	sigemptyset (&new.sa_mask);
-	sigaction (SIGCHLD, &new, &old);
-
-	rc = 2;
-	do {
-		pid = fork();
-	} while (pid == -1 && errno == EAGAIN && --rc);
-
-	rc = -1;
-	switch (pid) {
-	case -1:
-		close(fd[0]);
-		close(fd[1]);
-		break;
+		req->queued = FALSE;
+		req->inflight = TRUE;
+		ctx->inflight++;
 
-	case 0:
-		close(fd[0]);
-		if (!freopen("/dev/null", "r", stdin) ||
-		    !freopen("/dev/null", "w", stderr)) {
-			close(fd[1]);
-			exit(1);
-		}
-		if (dup2(fd[1], fileno(stdout)) < 0) {
-			close(fd[1]);
-			exit(1);
+		ni_timer_get_time(&req->deadline);
+		req->deadline.tv_sec  += req->timeout / 1000;
+		req->deadline.tv_usec += (req->timeout % 1000) * 1000;
+		if (req->deadline.tv_usec >= 1000000) {
+			req->deadline.tv_sec++;
+			req->deadline.tv_usec -= 1000000;
 		}
 
-		fds = getdtablesize();
-		for (fd[0] = 3; fd[0] < fds; ++fd[0])
-			close(fd[0]);
+		if (!req->done && (!req->qlen || !ni_resolve_reverse_send(req)))
+			ni_resolve_reverse_complete(req, NULL);
+	}
+}
+
+static int
+ni_resolve_reverse_get_timeout(const ni_socket_t *sock, struct timeval *tv)
+{
+	ni_resolve_reverse_t *req = sock->user_data;
 
-		rc = __ni_resolve_reverse_exec(addr);
-		exit(rc);
+	timerclear(tv);
+	if (!req)
+		return -1;
 
-	default:
-		close(fd[1]);
-		rc = __ni_resolve_reverse_read(fd[0], hostname, timeout);
-		close(fd[0]);
-		if (rc < 0)
-			kill(pid, SIGTERM);
+	*tv = req->deadline;
+	if (timercmp(&req->resend, tv, <))
+		*tv = req->resend;
+	return 0;
+}
 
-		__ni_resolve_reverse_reap(pid);
+/*
+ * Report a finished request. The callback may start or cancel other
+ * requests, so the request is unlinked and its socket closed before.
+ */
+static void
+ni_resolve_reverse_finish(ni_resolve_reverse_t *req)
+{
+	ni_resolve_reverse_ctx_t *ctx = req->ctx;
+
+	ni_resolve_reverse_unlink(req);
+	ni_resolve_reverse_close(req);
+	ni_resolve_reverse_dispatch(ctx);
+
+	ni_debug_socket("reverse lookup of %s %s%s",
+			ni_sockaddr_print(&req->addr),
+			req->hostname ? "resolved to " : "failed",
+			req->hostname ? req->hostname : "");
+	if (req->callback)
+		req->callback(req, req->hostname, req->user_data);
+	ni_resolve_reverse_free(req);
+}
+
+/*
+ * Retransmit the query without a reply in time, report it when done
+ */
+static void
+ni_resolve_reverse_check_timeout(ni_socket_t *sock, const struct timeval *now)
+{
+	ni_resolve_reverse_t *req = sock->user_data;
+
+	if (!req)
+		return;
+
+	if (!req->done && timercmp(&req->deadline, now, >)) {
+		if (timercmp(&req->resend, now, >))
+			return;
+		if (ni_resolve_reverse_send(req))
+			return;
 	}
+	ni_resolve_reverse_finish(req);
+}
+
+static void
+ni_resolve_reverse_handle_error(ni_socket_t *sock)
+{
+	ni_resolve_reverse_t *req = sock->user_data;
 
-	sigaction (SIGCHLD, &old, &new);
-	return rc;
+	/* deactivated already -- replace it, the query is resent */
+	sock->error = 1;
+	if (!req)
+		return;
+
+	ni_resolve_reverse_close(req);
+	if (!ni_resolve_reverse_open(req))
+		ni_resolve_reverse_finish(req);
+	else
+		ni_timer_get_time(&req->resend);
+}
+
+static ni_bool_t
+ni_resolve_reverse_open(ni_resolve_reverse_t *req)
+{
+	ni_resolve_reverse_ctx_t *ctx = req->ctx;
+	ni_socket_t *sock;
+	int fd, off = 0;
+
+	/* IPv4 nameservers are v4-mapped on a dual stack socket */
+	req->family = AF_INET6;
+	fd = socket(AF_INET6, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
+	if (fd >= 0 && setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off)) < 0) {
+		close(fd);
+		fd = -1;
+	}
+	if (fd < 0) {
+		req->family = AF_INET;
+		fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
+	}
+	if (fd < 0) {
+		ni_error("Cannot open reverse resolver socket: %m");
+		return FALSE;
+	}
+
+	if (!(sock = ni_socket_wrap(fd, SOCK_DGRAM))) {
+		close(fd);
+		return FALSE;
+	}
+	sock->user_data = req;
+	sock->receive = ni_resolve_reverse_recv;
+	sock->get_timeout = ni_resolve_reverse_get_timeout;
+	sock->check_timeout = ni_resolve_reverse_check_timeout;
+	sock->handle_error = ni_resolve_reverse_handle_error;
+
+	if (!(ctx->array ? ni_socket_array_activate(ctx->array, sock) : ni_socket_activate(sock))) {
+		ni_socket_close(sock);
+		return FALSE;
+	}
+	req->sock = sock;
+	return TRUE;
+}
+
+static uint16_t
+ni_resolve_reverse_new_id(void)
+{
+	uint16_t id;
+
+#ifdef HAVE_GETRANDOM
+	if (getrandom(&id, sizeof(id), GRND_NONBLOCK) == sizeof(id))
+		return id;
+#endif
+	id = random() & 0xffff;
+	return id;
+}
+
+static void
+ni_resolve_reverse_ctx_close(ni_resolve_reverse_ctx_t *ctx)
+{
+	ni_resolve_reverse_t *req;
+
+	while ((req = ctx->requests)) {
+		ctx->requests = req->next;
+		ni_resolve_reverse_free(req);
+	}
+	ctx->inflight = 0;
+}
+
+static ni_resolve_reverse_t *
+ni_resolve_reverse_ctx_start(ni_resolve_reverse_ctx_t *ctx, const ni_sockaddr_t *addr,
+		unsigned int timeout, ni_resolve_reverse_callback_t *callback, void *user_data)
+{
+	ni_resolve_reverse_t *req, **pos;
+
+	if (!addr || !ni_sockaddr_is_specified(addr) || !timeout)
+		return NULL;
+	if (addr->ss_family != AF_INET && addr->ss_family != AF_INET6)
+		return NULL;
+
+	req = xcalloc(1, sizeof(*req));
+	req->ctx = ctx;
+	req->addr = *addr;
+	req->callback = callback;
+	req->user_data = user_data;
+	req->id = ni_resolve_reverse_new_id();
+	req->qlen = ni_resolve_reverse_build_query(addr, req->id, req->query, sizeof(req->query));
+
+	req->timeout = timeout;
+
+	/* a hosts file match is reported via the socket event loop as well */
+	if (ni_resolve_reverse_hosts(addr, &req->hostname)) {
+		ni_resolve_reverse_complete(req, NULL);
+	} else {
+		req->nservers  = ni_resolve_reverse_servers(req->servers);
+		req->max_tries = req->nservers * NI_RESOLVE_REVERSE_ATTEMPTS;
+		req->retrans   = timeout / req->max_tries;
+		if (req->retrans < NI_RESOLVE_REVERSE_RETRANS_MIN)
+			req->retrans = NI_RESOLVE_REVERSE_RETRANS_MIN;
+	}
+	req->queued = TRUE;
+
+	for (pos = &ctx->requests; *pos; pos = &(*pos)->next)
+		;
+	*pos = req;
+
+	ni_resolve_reverse_dispatch(ctx);
+	if (req->queued && !ctx->inflight) {
+		/* unable to open a socket and nothing in flight to retry */
+		ni_resolve_reverse_unlink(req);
+		ni_resolve_reverse_free(req);
+		return NULL;
+	}
+	return req;
+}
+
+/*
+ * Start a reverse lookup of the address, taking at most <timeout> msec.
+ * The callback is invoked from the socket event loop with the hostname
+ * or NULL on failure; the request is freed when it returns.
+ */
+ni_resolve_reverse_t *
+ni_resolve_reverse_start(const ni_sockaddr_t *addr, unsigned int timeout,
+		ni_resolve_reverse_callback_t *callback, void *user_data)
+{
+	return ni_resolve_reverse_ctx_start(&ni_resolve_reverse_global, addr,
+						timeout, callback, user_data);
+}
+
+/*
+ * Discard a running request without invoking its callback
+ */
+void
+ni_resolve_reverse_cancel(ni_resolve_reverse_t *req)
+{
+	if (req) {
+		ni_resolve_reverse_ctx_t *ctx = req->ctx;
+
+		ni_resolve_reverse_unlink(req);
+		ni_resolve_reverse_free(req);
+		ni_resolve_reverse_dispatch(ctx);
+	}
+}
+
+static void
+ni_resolve_reverse_timed_done(ni_resolve_reverse_t *req, const char *hostname, void *user_data)
+{
+	char **result = user_data;
+
+	(void)req;
+	ni_string_dup(result, hostname);
 }
 
+/*
+ * Timed IP address reverse resolve (see bnc#861476), waiting for
+ * the reply on a private socket without dispatching other events.
+ */
+int
+ni_resolve_reverse_timed(const ni_sockaddr_t *addr, char **hostname, unsigned int timeout)
+{
+	ni_socket_array_t array = NI_SOCKET_ARRAY_INIT;
+	ni_resolve_reverse_ctx_t ctx;
+	char *result = NULL;
+
+	if (!timeout)
+		return __ni_resolve_reverse(addr, hostname);
+
+	if (!hostname)
+		return -1;
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.array = &array;
+	if (ni_resolve_reverse_ctx_start(&ctx, addr, timeout * 1000,
+				ni_resolve_reverse_timed_done, &result)) {
+		while (ctx.requests && ni_socket_array_wait(&array, -1) == 0)
+			;
+	}
+	ni_resolve_reverse_ctx_close(&ctx);
+	ni_socket_array_destroy(&array);
+
+	if (!result)
+		return -1;
+
+	ni_string_free(hostname);
+	*hostname = result;
+	return 0;
+}
@@ -166,7 +166,7 @@ ni_bonding_load(const char *options)
 	if (options == NULL)
 		options = BONDING_MODULE_OPTS;
 
-	return ni_modprobe(BONDING_MODULE_NAME, options);
+	return ni_modprobe_load(BONDING_MODULE_NAME, options);
 }
 
 /*
@@ -284,6 +284,20 @@ ni_bridge_port_status_destroy(ni_bridge_port_status_t *ps)
 	ni_string_free(&ps->designated_bridge);
 }
 
+void
+ni_bridge_port_status_copy(ni_bridge_port_status_t *dst, const ni_bridge_port_status_t *src)
+{
+	if (dst == src)
+		return;
+
+	ni_bridge_port_status_destroy(dst);
+	*dst = *src;
+	dst->designated_root = NULL;
+	dst->designated_bridge = NULL;
+	ni_string_dup(&dst->designated_root, src->designated_root);
+	ni_string_dup(&dst->designated_bridge, src->designated_bridge);
+}
+
 void
 ni_bridge_ports_destroy(ni_bridge_t *bridge)
 {
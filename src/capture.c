@@ -28,6 +28,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/time.h>
+#include <sys/mman.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -57,6 +58,16 @@
 #define	AFPACKET_MODULE_NAME	"af_packet"
 #define AFPACKET_MODULE_OPTS	NULL
 
+/*
+ * TPACKET_V3 receive ring geometry: each block is large enough
+ * to hold NI_CAPTURE_RING_BLOCK_FRAMES mtu sized frames and is
+ * retired to user space when full or after the block timeout.
+ */
+#define NI_CAPTURE_RING_BLOCK_NR	4
+#define NI_CAPTURE_RING_BLOCK_FRAMES	8
+#define NI_CAPTURE_RING_BLOCK_TMO	8	/* msec */
+#define NI_CAPTURE_RING_FRAME_SLACK	128
+
 /* in case we have old headers files */
 #if defined(PACKET_AUXDATA) && !defined(HAVE_STRUCT_TPACKET_AUXDATA)
 struct tpacket_auxdata {
@@ -123,6 +134,19 @@ struct ni_capture {
 	void *			buffer;
 	size_t			mtu;
 
+#if defined(HAVE_TPACKET_V3)
+	struct {
+		unsigned char *		map;
+		size_t			size;
+		unsigned int		block_size;
+		unsigned int		block_nr;
+		unsigned int		block_cur;
+
+		const struct tpacket3_hdr *frame;
+		void			(*receive)(ni_socket_t *);
+	} ring;
+#endif
+
 	struct {
 		struct timeval		deadline;
 		const ni_buffer_t *	buffer;
@@ -494,15 +518,43 @@ ni_capture_from_hwaddr_print(const ni_sockaddr_t *from)
 	return ni_link_address_print(&hwaddr);
 }
 
+#if defined(HAVE_TPACKET_V3)
+/*
+ * Return the ring frame the receive callback has been invoked for
+ */
+static ssize_t
+__ni_capture_ring_recv(ni_capture_t *capture, void **data, ni_bool_t *partial_csum, ni_sockaddr_t *from)
+{
+	const struct tpacket3_hdr *frame = capture->ring.frame;
+	const struct sockaddr_ll *sll;
+
+	*partial_csum = !!(frame->tp_status & TP_STATUS_CSUMNOTREADY);
+	*data = (unsigned char *)frame + frame->tp_mac;
+
+	if (from) {
+		sll = (void *)((unsigned char *)frame + TPACKET_ALIGN(sizeof(*frame)));
+		memset(from, 0, sizeof(*from));
+		memcpy(&from->ss, sll, sizeof(*sll));
+	}
+	return frame->tp_snaplen;
+}
+#endif
+
 int
 ni_capture_recv(ni_capture_t *capture, ni_buffer_t *bp, ni_sockaddr_t *from, const char *hint)
 {
+	void *data = capture->buffer;
 	void *payload;
 	size_t payload_len;
 	ssize_t bytes;
 	ni_bool_t partial_checksum = FALSE;
 	const char *lladdr;
 
+#if defined(HAVE_TPACKET_V3)
+	if (capture->ring.frame)
+		bytes = __ni_capture_ring_recv(capture, &data, &partial_checksum, from);
+	else
+#endif
 	bytes = __ni_capture_recv(capture->sock->__fd, capture->buffer,
 				  capture->mtu, &partial_checksum, from);
 
@@ -522,7 +574,7 @@ ni_capture_recv(ni_capture_t *capture, ni_buffer_t *bp, ni_sockaddr_t *from, con
 	switch (capture->protocol) {
 	case ETHERTYPE_IP:
 		/* Make sure IP and UDP header are sane */
-		payload = ni_capture_inspect_udp_header(capture->buffer, bytes,
+		payload = ni_capture_inspect_udp_header(data, bytes,
 						&payload_len, partial_checksum);
 		if (payload == NULL) {
 			ni_debug_socket("%s: bad IP/UDP %s%spacket header",
@@ -534,7 +586,7 @@ ni_capture_recv(ni_capture_t *capture, ni_buffer_t *bp, ni_sockaddr_t *from, con
 
 	case ETHERTYPE_ARP:
 	case ETHERTYPE_LLDP:
-		payload = capture->buffer;
+		payload = data;
 		payload_len = bytes;
 		break;
 
@@ -663,6 +715,110 @@ __ni_capture_enable_packet_auxdata(int fd)
 #endif
 }
 
+#if defined(HAVE_TPACKET_V3)
+/*
+ * Memory mapped TPACKET_V3 receive ring.
+ *
+ * The kernel hands over whole blocks of frames, so a single poll
+ * wakeup lets us process a burst of packets without a recvmsg per
+ * frame. The receive callback is invoked once per frame, exactly as
+ * in the recvmsg case; ni_capture_recv then returns the current frame.
+ */
+static void
+__ni_capture_ring_receive(ni_socket_t *sock)
+{
+	ni_capture_t *capture = sock->user_data;
+	struct tpacket_block_desc *block;
+	const struct tpacket3_hdr *frame;
+	const struct sockaddr_ll *sll;
+	unsigned int n, i;
+
+	for (n = 0; n < capture->ring.block_nr; ++n) {
+		block = (void *)(capture->ring.map + capture->ring.block_cur *
+						capture->ring.block_size);
+		if (!(block->hdr.bh1.block_status & TP_STATUS_USER))
+			break;
+
+		frame = (void *)((unsigned char *)block + block->hdr.bh1.offset_to_first_pkt);
+		for (i = 0; i < block->hdr.bh1.num_pkts; ++i) {
+			sll = (void *)((unsigned char *)frame + TPACKET_ALIGN(sizeof(*frame)));
+
+			/* ring is set up before bind, skip strays */
+			if (sll->sll_ifindex == capture->addr.sll.sll_ifindex) {
+				capture->ring.frame = frame;
+				capture->ring.receive(sock);
+
+				/* callback may have freed the capture and unmapped the ring */
+				if (sock->__fd < 0)
+					return;
+				capture->ring.frame = NULL;
+			}
+			frame = (void *)((unsigned char *)frame + frame->tp_next_offset);
+		}
+
+		block->hdr.bh1.block_status = TP_STATUS_KERNEL;
+		__sync_synchronize();
+
+		capture->ring.block_cur = (capture->ring.block_cur + 1) % capture->ring.block_nr;
+	}
+}
+
+static ni_bool_t
+__ni_capture_ring_setup(ni_capture_t *capture, int fd)
+{
+	struct tpacket_req3 req;
+	unsigned int frame_size;
+	unsigned int block_size;
+	int version = TPACKET_V3;
+	void *map;
+
+	if (setsockopt(fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0) {
+		ni_debug_socket("%s: cannot enable TPACKET_V3: %m", capture->ifname);
+		return FALSE;
+	}
+
+	frame_size = TPACKET_ALIGN(TPACKET3_HDRLEN + capture->mtu + NI_CAPTURE_RING_FRAME_SLACK);
+	block_size = getpagesize();
+	while (block_size < frame_size * NI_CAPTURE_RING_BLOCK_FRAMES)
+		block_size <<= 1;
+
+	memset(&req, 0, sizeof(req));
+	req.tp_block_size = block_size;
+	req.tp_block_nr = NI_CAPTURE_RING_BLOCK_NR;
+	req.tp_frame_size = frame_size;
+	req.tp_frame_nr = (block_size / frame_size) * NI_CAPTURE_RING_BLOCK_NR;
+	req.tp_retire_blk_tov = NI_CAPTURE_RING_BLOCK_TMO;
+
+	if (setsockopt(fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0) {
+		ni_debug_socket("%s: cannot setup packet rx ring: %m", capture->ifname);
+		goto failed;
+	}
+
+	map = mmap(NULL, (size_t)block_size * NI_CAPTURE_RING_BLOCK_NR,
+			PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (map == MAP_FAILED) {
+		ni_debug_socket("%s: cannot map packet rx ring: %m", capture->ifname);
+		memset(&req, 0, sizeof(req));
+		setsockopt(fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req));
+		goto failed;
+	}
+
+	capture->ring.map = map;
+	capture->ring.size = (size_t)block_size * NI_CAPTURE_RING_BLOCK_NR;
+	capture->ring.block_size = block_size;
+	capture->ring.block_nr = NI_CAPTURE_RING_BLOCK_NR;
+	capture->ring.block_cur = 0;
+	ni_debug_socket("%s: using packet rx ring with %u blocks of %u bytes",
+			capture->ifname, capture->ring.block_nr, capture->ring.block_size);
+	return TRUE;
+
+failed:
+	version = TPACKET_V1;
+	setsockopt(fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version));
+	return FALSE;
+}
+#endif
+
 static void
 __ni_capture_init_once(void)
 {
@@ -673,7 +829,7 @@ __ni_capture_init_once(void)
 	done = TRUE;
 
 	/* load af_packet module we need for capturing */
-	ni_modprobe(AFPACKET_MODULE_NAME, AFPACKET_MODULE_OPTS);
+	ni_modprobe_load(AFPACKET_MODULE_NAME, AFPACKET_MODULE_OPTS);
 }
 
 ni_capture_t *
@@ -727,6 +883,18 @@ ni_capture_open(const ni_capture_devinfo_t *devinfo, const ni_capture_protinfo_t
 	if (ni_capture_set_filter(capture, protinfo) < 0)
 		goto failed;
 
+	capture->mtu = devinfo->mtu;
+	if (capture->mtu == 0)
+		capture->mtu = MTU_MAX;
+
+#if defined(HAVE_TPACKET_V3)
+	/* fall back to recvmsg when the kernel does not provide rings */
+	if (__ni_capture_ring_setup(capture, fd)) {
+		capture->ring.receive = receive;
+		receive = __ni_capture_ring_receive;
+	}
+#endif
+
 	memset(&addr, 0, sizeof(addr));
 	addr.sll.sll_family = PF_PACKET;
 	addr.sll.sll_protocol = htons(protinfo->eth_protocol);
@@ -739,9 +907,6 @@ ni_capture_open(const ni_capture_devinfo_t *devinfo, const ni_capture_protinfo_t
 
 	__ni_capture_enable_packet_auxdata(fd);
 
-	capture->mtu = devinfo->mtu;
-	if (capture->mtu == 0)
-		capture->mtu = MTU_MAX;
 	capture->buffer = xmalloc(capture->mtu);
 
 	capture->sock->receive = receive;
@@ -840,6 +1005,10 @@ ni_capture_free(ni_capture_t *capture)
 {
 	if (!capture)
 		return;
+#if defined(HAVE_TPACKET_V3)
+	if (capture->ring.map)
+		munmap(capture->ring.map, capture->ring.size);
+#endif
 	if (capture->sock)
 		ni_socket_close(capture->sock);
 	if (capture->buffer)
@@ -25,6 +25,7 @@
 #include "netinfo_priv.h"
 #include "util_priv.h"
 #include "appconfig.h"
+#include "process.h"
 #include "xml-schema.h"
 #include "dhcp.h"
 #include "duid.h"
@@ -1356,6 +1357,19 @@ ni_config_parse_extension(ni_extension_t *ex, xml_node_t *node)
 			if (!ni_extension_script_new(ex, name, command))
 				return FALSE;
 		} else
+		if (!strcmp(child->name, "worker")) {
+			const char *command;
+
+			if (!(command = xml_node_get_attr(child, "command"))) {
+				ni_error("%s: <worker> element without command attribute",
+						xml_node_location(child));
+				return FALSE;
+			}
+
+			ni_shellcmd_release(ex->worker_cmd);
+			if (!(ex->worker_cmd = ni_shellcmd_parse(command)))
+				return FALSE;
+		} else
 		if (!strcmp(child->name, "builtin")) {
 			const char *name, *library, *symbol;
 
@@ -1430,7 +1444,7 @@ ni_config_parse_objectmodel_firmware_discovery(ni_extension_t **list, xml_node_t
  * Another class of extensions helps with updating system files such as resolv.conf
  * This expects scripts for install, backup and restore (named accordingly).
  *
- * <system-updater name="resolver">
+ * <system-updater name="resolver" settle="msec">
  *  <script name="install" command="/some/crazy/path/to/script install" />
  *  <script name="backup" command="/some/crazy/path/to/script backup" />
  *  <script name="restore" command="/some/crazy/path/to/script restore" />
@@ -1454,6 +1468,14 @@ ni_config_parse_system_updater(ni_extension_t **list, xml_node_t *node)
 	/* If the updater has a format type, extract. */
 	ni_string_dup(&ex->format, xml_node_get_attr(node, "format"));
 
+	/* Time to wait for further leases to merge into a batch call */
+	if (xml_node_get_attr(node, "settle") &&
+	    !xml_node_get_attr_uint(node, "settle", &ex->settle)) {
+		ni_error("%s: <%s> element has invalid settle attribute",
+				xml_node_location(node), node->name);
+		return FALSE;
+	}
+
 	return ni_config_parse_extension(ex, node);
 }
 
@@ -199,6 +199,15 @@ ni_dbus_client_set_call_timeout(ni_dbus_client_t *dbc, unsigned int msec)
 	dbc->call_timeout = msec;
 }
 
+/*
+ * Wait up to timeout msec for replies and signals on the client connection
+ */
+int
+ni_dbus_client_wait(ni_dbus_client_t *client, unsigned int timeout)
+{
+	return ni_dbus_connection_wait(client->connection, timeout);
+}
+
 /*
  * Place a synchronous call
  */
@@ -788,6 +788,8 @@ ni_dbus_variant_destroy(ni_dbus_variant_t *var)
 	if (var->__message)
 		dbus_message_unref(var->__message);
 
+	free(var->__dict_index);
+
 	memset(var, 0, sizeof(*var));
 	var->type = DBUS_TYPE_INVALID;
 	var->__magic = NI_DBUS_VARIANT_MAGIC;
@@ -1333,6 +1335,105 @@ ni_dbus_dict_add_byte_array(ni_dbus_variant_t *dict, const char *key,
 	return TRUE;
 }
 
+/*
+ * Property dicts received from the server may have many hundreds of
+ * entries, which callers then probe key by key. Above a small size,
+ * ni_dbus_dict_get uses an open addressing hash of entry positions.
+ * It is built on first lookup, extended when entries have been
+ * appended since, and dropped when entries are deleted.
+ */
+#define NI_DBUS_DICT_INDEX_MIN		16
+
+struct ni_dbus_dict_index {
+	unsigned int		count;		/* number of entries hashed */
+	unsigned int		mask;
+	unsigned int		slot[];		/* entry position + 1, 0 if empty */
+};
+
+unsigned int
+__ni_dbus_hash_name(const char *name)
+{
+	unsigned int hash = 2166136261U;	/* FNV-1a */
+
+	while (*name) {
+		hash ^= (unsigned char)*name++;
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+static void
+ni_dbus_dict_index_drop(ni_dbus_variant_t *dict)
+{
+	free(dict->__dict_index);
+	dict->__dict_index = NULL;
+}
+
+/*
+ * Hash the entries not indexed yet. Like the linear lookup, the
+ * first entry with a given key wins; later duplicates are skipped.
+ */
+static struct ni_dbus_dict_index *
+ni_dbus_dict_index_update(ni_dbus_variant_t *dict)
+{
+	struct ni_dbus_dict_index *index = dict->__dict_index;
+	unsigned int i, pos, size;
+
+	if (index && index->count > dict->array.len)
+		ni_dbus_dict_index_drop(dict);
+
+	index = dict->__dict_index;
+	if (index == NULL || 2 * dict->array.len > index->mask + 1) {
+		for (size = 2 * NI_DBUS_DICT_INDEX_MIN; size < 4 * dict->array.len; size <<= 1)
+			;
+		ni_dbus_dict_index_drop(dict);
+		index = xcalloc(1, sizeof(*index) + size * sizeof(index->slot[0]));
+		index->mask = size - 1;
+		dict->__dict_index = index;
+	}
+
+	for (i = index->count; i < dict->array.len; ++i) {
+		const char *key = dict->dict_array_value[i].key;
+
+		if (key == NULL)
+			continue;
+
+		pos = __ni_dbus_hash_name(key) & index->mask;
+		while (index->slot[pos]) {
+			if (!strcmp(dict->dict_array_value[index->slot[pos] - 1].key, key))
+				break;
+			pos = (pos + 1) & index->mask;
+		}
+		if (!index->slot[pos])
+			index->slot[pos] = i + 1;
+	}
+	index->count = dict->array.len;
+	return index;
+}
+
+static ni_dbus_variant_t *
+ni_dbus_dict_index_find(const ni_dbus_variant_t *dict, const char *key)
+{
+	const struct ni_dbus_dict_index *index;
+	ni_dbus_dict_entry_t *entry;
+	unsigned int pos;
+
+	index = dict->__dict_index;
+	if (index == NULL || index->count != dict->array.len) {
+		/* the index is a lookup cache owned by the dict */
+		index = ni_dbus_dict_index_update((ni_dbus_variant_t *) dict);
+	}
+
+	pos = __ni_dbus_hash_name(key) & index->mask;
+	while (index->slot[pos]) {
+		entry = &dict->dict_array_value[index->slot[pos] - 1];
+		if (!strcmp(entry->key, key))
+			return &entry->datum;
+		pos = (pos + 1) & index->mask;
+	}
+	return NULL;
+}
+
 ni_dbus_variant_t *
 ni_dbus_dict_get(const ni_dbus_variant_t *dict, const char *key)
 {
@@ -1342,6 +1443,9 @@ ni_dbus_dict_get(const ni_dbus_variant_t *dict, const char *key)
 	if (!ni_dbus_variant_is_dict(dict))
 		return NULL;
 
+	if (dict->array.len >= NI_DBUS_DICT_INDEX_MIN && key)
+		return ni_dbus_dict_index_find(dict, key);
+
 	for (i = 0; i < dict->array.len; ++i) {
 		entry = &dict->dict_array_value[i];
 		if (entry->key && !strcmp(entry->key, key))
@@ -1527,6 +1631,7 @@ ni_dbus_dict_delete_entry(ni_dbus_variant_t *dict, const char *key)
 	for (i = 0; i < dict->array.len; ++i, ++entry) {
 		if (entry->key && !strcmp(entry->key, key)) {
 			ni_dbus_variant_destroy(&entry->datum);
+			ni_dbus_dict_index_drop(dict);
 			dict->array.len--;
 
 			/* Shift down all entries */
@@ -35,6 +35,7 @@ extern dbus_bool_t		ni_dbus_message_iter_append_byte_array(DBusMessageIter *iter
 						const unsigned char *value, unsigned int len);
 
 extern const ni_dbus_property_t *__ni_dbus_service_get_property(const ni_dbus_property_t *, const char *);
+extern unsigned int		__ni_dbus_hash_name(const char *);
 
 
 /*
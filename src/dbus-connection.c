@@ -13,6 +13,7 @@
 #include <wicked/util.h>
 #include <wicked/logging.h>
 #include <wicked/dbus-errors.h>
+#include <wicked/metrics.h>
 #include "socket_priv.h"
 #include "dbus-connection.h"
 #include "dbus-dict.h"
@@ -389,6 +390,23 @@ __ni_dbus_notify_async(DBusPendingCall *pending, void *call_data)
 	__ni_dbus_process_pending(conn, pending);
 }
 
+/*
+ * Wait for incoming messages on this connection only and dispatch
+ * them, e.g. the replies to async calls and the signals they cause.
+ * Returns -1 when the connection has been closed.
+ */
+int
+ni_dbus_connection_wait(ni_dbus_connection_t *connection, unsigned int timeout)
+{
+	if (!dbus_connection_read_write(connection->conn, timeout))
+		return -1;
+
+	if (!connection->dispatching)
+		__ni_dbus_connection_dispatch(connection);
+
+	return dbus_connection_get_is_connected(connection->conn) ? 0 : -1;
+}
+
 /*
  * Send a message out
  */
@@ -900,10 +918,14 @@ __ni_dbus_remove_watch(DBusWatch *watch, void *dummy)
 void
 __ni_dbus_connection_dispatch(ni_dbus_connection_t *connection)
 {
+	struct timeval start;
+
 	ni_assert(!connection->dispatching);
 
+	ni_metrics_begin(&start);
 	connection->dispatching = TRUE;
 	while (dbus_connection_dispatch(connection->conn) == DBUS_DISPATCH_DATA_REMAINS)
 		;
 	connection->dispatching = FALSE;
+	ni_metrics_end(NI_METRIC_DBUS_DISPATCH, &start);
 }
@@ -545,17 +545,123 @@ ni_dbus_service_get_signal(const ni_dbus_service_t *service, const char *name)
 
 /*
  * Find the named property
+ *
+ * Setting properties from a dict and refreshing client objects look up
+ * every dict key in the service's property table (or the table of a
+ * dict property's children), so we keep a hash of each table that has
+ * been searched. The tables are static and never freed, so the hashes
+ * are registered by table address and kept for the process lifetime.
  */
+typedef struct ni_dbus_property_index {
+	const ni_dbus_property_t *	list;
+	unsigned int			mask;
+	const ni_dbus_property_t **	slot;
+} ni_dbus_property_index_t;
+
+static struct ni_dbus_property_indexes {
+	unsigned int			count;
+	unsigned int			mask;
+	ni_dbus_property_index_t **	slot;
+} __ni_dbus_property_indexes;
+
+static inline unsigned int
+__ni_dbus_property_list_hash(const ni_dbus_property_t *list)
+{
+	return ((unsigned long) list >> 4) * 2654435761U;
+}
+
+static void
+__ni_dbus_property_indexes_insert(struct ni_dbus_property_indexes *indexes,
+				ni_dbus_property_index_t *index)
+{
+	unsigned int pos = __ni_dbus_property_list_hash(index->list) & indexes->mask;
+
+	while (indexes->slot[pos])
+		pos = (pos + 1) & indexes->mask;
+	indexes->slot[pos] = index;
+	indexes->count++;
+}
+
+static ni_dbus_property_index_t *
+__ni_dbus_property_index_new(const ni_dbus_property_t *property_list)
+{
+	struct ni_dbus_property_indexes *indexes = &__ni_dbus_property_indexes;
+	const ni_dbus_property_t *property;
+	ni_dbus_property_index_t *index;
+	unsigned int count = 0, size, pos;
+
+	if (2 * (indexes->count + 1) > indexes->mask + 1) {
+		struct ni_dbus_property_indexes grown;
+		unsigned int i;
+
+		grown.count = 0;
+		grown.mask = indexes->mask ? 2 * indexes->mask + 1 : 63;
+		grown.slot = xcalloc(grown.mask + 1, sizeof(grown.slot[0]));
+		for (i = 0; indexes->slot && i <= indexes->mask; ++i) {
+			if (indexes->slot[i])
+				__ni_dbus_property_indexes_insert(&grown, indexes->slot[i]);
+		}
+		free(indexes->slot);
+		*indexes = grown;
+	}
+
+	for (property = property_list; property->name; ++property)
+		count++;
+	for (size = 8; size < 2 * count; size <<= 1)
+		;
+
+	index = xcalloc(1, sizeof(*index));
+	index->list = property_list;
+	index->mask = size - 1;
+	index->slot = xcalloc(size, sizeof(index->slot[0]));
+
+	/* As with a linear search, the first property of a name wins */
+	for (property = property_list; property->name; ++property) {
+		pos = __ni_dbus_hash_name(property->name) & index->mask;
+		while (index->slot[pos] && strcmp(index->slot[pos]->name, property->name))
+			pos = (pos + 1) & index->mask;
+		if (!index->slot[pos])
+			index->slot[pos] = property;
+	}
+
+	__ni_dbus_property_indexes_insert(indexes, index);
+	return index;
+}
+
+static const ni_dbus_property_index_t *
+__ni_dbus_property_index(const ni_dbus_property_t *property_list)
+{
+	const struct ni_dbus_property_indexes *indexes = &__ni_dbus_property_indexes;
+	ni_dbus_property_index_t *index;
+	unsigned int pos;
+
+	if (indexes->slot) {
+		pos = __ni_dbus_property_list_hash(property_list) & indexes->mask;
+		while ((index = indexes->slot[pos])) {
+			if (index->list == property_list)
+				return index;
+			pos = (pos + 1) & indexes->mask;
+		}
+	}
+	return __ni_dbus_property_index_new(property_list);
+}
+
 const ni_dbus_property_t *
 __ni_dbus_service_get_property(const ni_dbus_property_t *property_list, const char *name)
 {
+	const ni_dbus_property_index_t *index;
 	const ni_dbus_property_t *property;
+	unsigned int pos;
 
-	if (property_list == NULL)
+	if (property_list == NULL || name == NULL)
 		return NULL;
-	for (property = property_list; property->name; ++property) {
+
+	index = __ni_dbus_property_index(property_list);
+	pos = __ni_dbus_hash_name(name) & index->mask;
+	while ((property = index->slot[pos])) {
 		if (!strcmp(property->name, name))
 			return property;
+		pos = (pos + 1) & index->mask;
 	}
 	return NULL;
 }
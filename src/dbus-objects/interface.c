@@ -34,11 +34,13 @@ extern dbus_bool_t	ni_objectmodel_netif_list_refresh(ni_dbus_object_t *);
 static void		ni_objectmodel_register_netif_factory_service(ni_dbus_service_t *);
 static void		ni_objectmodel_netif_initialize(ni_dbus_object_t *object);
 static void		ni_objectmodel_netif_destroy(ni_dbus_object_t *object);
+static dbus_bool_t	ni_objectmodel_netif_refresh(ni_dbus_object_t *object);
 
 const ni_dbus_class_t		ni_objectmodel_netif_class = {
 	.name		= NI_OBJECTMODEL_NETIF_CLASS,
 	.initialize	= ni_objectmodel_netif_initialize,
 	.destroy	= ni_objectmodel_netif_destroy,
+	.refresh	= ni_objectmodel_netif_refresh,
 };
 static ni_dbus_class_t		ni_objectmodel_ifreq_class = {
 	.name		= NI_OBJECTMODEL_NETIF_REQUEST_CLASS,
@@ -1360,6 +1362,24 @@ ni_objectmodel_netif_destroy(ni_dbus_object_t *object)
 	ni_netdev_put(ifp);
 }
 
+/*
+ * Called prior to invoking any method of a netif object. A device
+ * still waiting for its deferred link details discovery is served
+ * first, so the request operates on the complete device state.
+ */
+static dbus_bool_t
+ni_objectmodel_netif_refresh(ni_dbus_object_t *object)
+{
+	ni_netdev_t *dev;
+
+	if (!(dev = ni_objectmodel_unwrap_netif(object, NULL)))
+		return TRUE;
+
+	if (dev->link.ifflags & NI_IFF_DETAILS_PENDING)
+		ni_system_refresh_details(ni_global_state_handle(0), dev);
+	return TRUE;
+}
+
 static ni_dbus_method_t		ni_objectmodel_netif_methods[] = {
 	{ "linkUp",		"a{sv}",	.handler = ni_objectmodel_netif_link_up },
 	{ "linkDown",		"",		.handler = ni_objectmodel_netif_link_down },
@@ -0,0 +1,190 @@
+/*
+ *	DBus encapsulation of the runtime metrics
+ *
+ *	Copyright (C) 2026 SUSE Linux GmbH, Nuernberg, Germany.
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	This program is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along
+ *	with this program; if not, see <http://www.gnu.org/licenses/> or write
+ *	to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *	Boston, MA 02110-1301 USA.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <inttypes.h>
+
+#include <wicked/netinfo.h>
+#include <wicked/logging.h>
+#include <wicked/metrics.h>
+#include <wicked/dbus-errors.h>
+#include <wicked/objectmodel.h>
+#include "dbus-common.h"
+#include "model.h"
+
+static dbus_bool_t
+ni_objectmodel_metric_to_dict(const ni_metric_t *m, ni_dbus_variant_t *dict)
+{
+	ni_dbus_variant_t *buckets;
+	char bound[32];
+	unsigned int n;
+
+	ni_dbus_dict_add_string(dict, "type", ni_metric_type_to_name(m->type));
+	ni_dbus_dict_add_string(dict, "help", m->help);
+	ni_dbus_dict_add_uint64(dict, "value", m->value);
+	if (m->type != NI_METRIC_HISTOGRAM)
+		return TRUE;
+
+	ni_dbus_dict_add_uint64(dict, "sum-usec", m->sum);
+	if (!(buckets = ni_dbus_dict_add(dict, "buckets")))
+		return FALSE;
+
+	/* non-empty buckets only, keyed by their upper bound in usec */
+	ni_dbus_variant_init_dict(buckets);
+	for (n = 0; n <= NI_METRIC_BUCKETS; ++n) {
+		if (!m->bucket[n])
+			continue;
+
+		if (n < NI_METRIC_BUCKETS)
+			snprintf(bound, sizeof(bound), "%"PRIu64, ni_metric_bucket_bound(n));
+		else
+			snprintf(bound, sizeof(bound), "inf");
+		ni_dbus_dict_add_uint64(buckets, bound, m->bucket[n]);
+	}
+	return TRUE;
+}
+
+/*
+ * Metrics.getMetrics()
+ */
+static dbus_bool_t
+ni_objectmodel_metrics_get(ni_dbus_object_t *object, const ni_dbus_method_t *method,
+			unsigned int argc, const ni_dbus_variant_t *argv,
+			ni_dbus_message_t *reply, DBusError *error)
+{
+	ni_dbus_variant_t result = NI_DBUS_VARIANT_INIT;
+	ni_dbus_variant_t *metrics, *dict;
+	const ni_metric_t *m;
+	unsigned int id;
+	dbus_bool_t rv;
+
+	if (argc != 0)
+		return ni_dbus_error_invalid_args(error, object->path, method->name);
+
+	ni_dbus_variant_init_dict(&result);
+	ni_dbus_dict_add_bool(&result, "enabled", ni_metrics_enabled);
+	if (!(metrics = ni_dbus_dict_add(&result, "metrics")))
+		goto failed;
+
+	ni_dbus_variant_init_dict(metrics);
+	for (id = 0; id < __NI_METRIC_MAX; ++id) {
+		if (!(m = ni_metrics_get(id)))
+			continue;
+
+		if (!(dict = ni_dbus_dict_add(metrics, m->name)))
+			goto failed;
+		ni_dbus_variant_init_dict(dict);
+		if (!ni_objectmodel_metric_to_dict(m, dict))
+			goto failed;
+	}
+
+	rv = ni_dbus_message_serialize_variants(reply, 1, &result, error);
+	ni_dbus_variant_destroy(&result);
+	return rv;
+
+failed:
+	ni_dbus_variant_destroy(&result);
+	dbus_set_error(error, DBUS_ERROR_FAILED, "Unable to serialize metrics");
+	return FALSE;
+}
+
+/*
+ * Metrics.getOpenMetrics()
+ */
+static dbus_bool_t
+ni_objectmodel_metrics_get_openmetrics(ni_dbus_object_t *object, const ni_dbus_method_t *method,
+			unsigned int argc, const ni_dbus_variant_t *argv,
+			ni_dbus_message_t *reply, DBusError *error)
+{
+	ni_stringbuf_t buf = NI_STRINGBUF_INIT_DYNAMIC;
+	dbus_bool_t rv;
+
+	if (argc != 0)
+		return ni_dbus_error_invalid_args(error, object->path, method->name);
+
+	ni_metrics_format_openmetrics(&buf, "wicked");
+	rv = ni_dbus_message_append_string(reply, buf.string ? buf.string : "");
+	ni_stringbuf_destroy(&buf);
+	return rv;
+}
+
+/*
+ * Metrics.reset()
+ */
+static dbus_bool_t
+ni_objectmodel_metrics_reset(ni_dbus_object_t *object, const ni_dbus_method_t *method,
+			unsigned int argc, const ni_dbus_variant_t *argv,
+			ni_dbus_message_t *reply, DBusError *error)
+{
+	if (argc != 0)
+		return ni_dbus_error_invalid_args(error, object->path, method->name);
+
+	ni_metrics_reset();
+	return TRUE;
+}
+
+/*
+ * Metrics.setEnabled(bool)
+ */
+static dbus_bool_t
+ni_objectmodel_metrics_set_enabled(ni_dbus_object_t *object, const ni_dbus_method_t *method,
+			unsigned int argc, const ni_dbus_variant_t *argv,
+			ni_dbus_message_t *reply, DBusError *error)
+{
+	dbus_bool_t enable;
+
+	if (argc != 1 || !ni_dbus_variant_get_bool(&argv[0], &enable))
+		return ni_dbus_error_invalid_args(error, object->path, method->name);
+
+	ni_debug_dbus("%s: %s metrics", object->path, enable ? "enabling" : "disabling");
+	ni_metrics_enable(enable);
+	return TRUE;
+}
+
+static ni_dbus_method_t		ni_objectmodel_metrics_methods[] = {
+	{ "getMetrics",		"",		.handler = ni_objectmodel_metrics_get },
+	{ "getOpenMetrics",	"",		.handler = ni_objectmodel_metrics_get_openmetrics },
+	{ "reset",		"",		.handler = ni_objectmodel_metrics_reset },
+	{ "setEnabled",		"b",		.handler = ni_objectmodel_metrics_set_enabled },
+	{ NULL }
+};
+
+static ni_dbus_service_t	ni_objectmodel_metrics_service = {
+	.name		= NI_OBJECTMODEL_METRICS_INTERFACE,
+	.methods	= ni_objectmodel_metrics_methods,
+};
+
+/*
+ * Every daemon provides the metrics on its root object
+ */
+dbus_bool_t
+ni_objectmodel_metrics_init(ni_dbus_server_t *server)
+{
+	ni_dbus_object_t *root;
+
+	if (!server || !(root = ni_dbus_server_get_root_object(server)))
+		return FALSE;
+
+	return ni_dbus_object_register_service(root, &ni_objectmodel_metrics_service);
+}
@@ -131,6 +131,7 @@ ni_objectmodel_create_initial_objects(ni_dbus_server_t *server)
 	/* Register root interface with the root of the object hierarchy */
 	object = ni_dbus_server_get_root_object(server);
 	ni_dbus_object_register_service(object, &ni_objectmodel_netif_root_interface);
+	ni_objectmodel_metrics_init(server);
 
 	ni_objectmodel_create_netif_list(server);
 #ifdef MODEM
@@ -420,7 +421,7 @@ static ni_dbus_service_t	ni_objectmodel_netif_root_interface = {
  * This should probably go with the objectmodel code.
  */
 static int
-ni_objectmodel_expand_environment(const ni_dbus_object_t *object, const ni_var_array_t *env, ni_process_t *process)
+ni_objectmodel_expand_environment(const ni_dbus_object_t *object, const ni_var_array_t *env, ni_var_array_t *vars)
 {
 	const ni_var_t *var;
 	unsigned int i;
@@ -442,7 +443,7 @@ ni_objectmodel_expand_environment(const ni_dbus_object_t *object, const ni_var_a
 		}
 
 		ni_debug_dbus("%s: expanded %s=%s -> \"%s\"", object->path, var->name, var->value, value);
-		ni_process_setenv(process, var->name, value);
+		ni_var_array_set(vars, var->name, value);
 
 		ni_dbus_variant_destroy(&variant);
 	}
@@ -451,32 +452,43 @@ ni_objectmodel_expand_environment(const ni_dbus_object_t *object, const ni_var_a
 }
 
 /*
- * Write dbus message to a temporary file
+ * Deserialize the dbus message arguments into xml
  */
-static char *
-__ni_objectmodel_write_message(ni_dbus_message_t *msg, const ni_dbus_method_t *method, ni_tempstate_t *temp_state)
+static xml_node_t *
+__ni_objectmodel_message_arguments(ni_dbus_message_t *msg, const ni_dbus_method_t *method,
+				xml_node_t *parent, ni_tempstate_t *temp_state)
 {
 	ni_dbus_variant_t argv[16];
-	char *tempname = NULL;
 	xml_node_t *xmlnode;
 	int argc = 0;
-	FILE *fp;
 
-	/* Deserialize dbus message */
 	memset(argv, 0, sizeof(argv));
 	argc = ni_dbus_message_get_args_variants(msg, argv, 16);
 	if (argc < 0)
 		return NULL;
 
-	xmlnode = ni_dbus_xml_deserialize_arguments(method, argc, argv, NULL, temp_state);
+	xmlnode = ni_dbus_xml_deserialize_arguments(method, argc, argv, parent, temp_state);
 
 	while (argc--)
 		ni_dbus_variant_destroy(&argv[argc]);
 
-	if (xmlnode == NULL) {
+	if (xmlnode == NULL)
 		ni_error("%s: unable to build XML from arguments", method->name);
+	return xmlnode;
+}
+
+/*
+ * Write dbus message to a temporary file
+ */
+static char *
+__ni_objectmodel_write_message(ni_dbus_message_t *msg, const ni_dbus_method_t *method, ni_tempstate_t *temp_state)
+{
+	char *tempname = NULL;
+	xml_node_t *xmlnode;
+	FILE *fp;
+
+	if (!(xmlnode = __ni_objectmodel_message_arguments(msg, method, NULL, temp_state)))
 		return NULL;
-	}
 
 	if ((fp = ni_mkstemp(&tempname)) == NULL) {
 		ni_error("%s: unable to create tempfile for script arguments", __func__);
@@ -513,6 +525,151 @@ __ni_objectmodel_empty_tempfile(ni_tempstate_t *temp_state)
 	return tempname;
 }
 
+/*
+ * Build the dbus reply from the return data of an extension
+ */
+static void
+__ni_objectmodel_extension_reply(ni_dbus_connection_t *connection, const ni_dbus_method_t *method,
+				ni_dbus_message_t *call, ni_bool_t okay, const xml_node_t *retdata)
+{
+	const char *interface_name = dbus_message_get_interface(call);
+	DBusError error = DBUS_ERROR_INIT;
+	ni_dbus_message_t *reply;
+
+	if (okay) {
+		ni_dbus_variant_t result = NI_DBUS_VARIANT_INIT;
+		xml_node_t *retnode = NULL;
+		int nres;
+
+		/* if the method returns anything, read it from the response file
+		 * and encode it. */
+		if (retdata == NULL
+		 || (retnode = xml_node_get_child(retdata, "return")) == NULL) {
+			nres = 0;
+		} else if ((nres = ni_dbus_serialize_return(method, &result, retnode)) < 0) {
+			dbus_set_error(&error, NI_DBUS_ERROR_CANNOT_MARSHAL,
+					"%s.%s: unable to serialize returned data",
+					interface_name, method->name);
+			ni_dbus_variant_destroy(&result);
+			goto send_error;
+		}
+
+		/* Build the response message */
+		reply = dbus_message_new_method_return(call);
+		if (!ni_dbus_message_serialize_variants(reply, nres, &result, &error)) {
+			ni_dbus_variant_destroy(&result);
+			dbus_message_unref(reply);
+			goto send_error;
+		}
+		ni_dbus_variant_destroy(&result);
+	} else {
+		xml_node_t *errnode = NULL;
+
+		if (retdata != NULL)
+			errnode = xml_node_get_child(retdata, "error");
+
+		if (errnode)
+			ni_dbus_serialize_error(&error, errnode);
+		else
+			dbus_set_error(&error, DBUS_ERROR_FAILED, "dbus extension script returns error");
+
+send_error:
+		reply = dbus_message_new_error(call, error.name, error.message);
+	}
+
+	if (ni_dbus_connection_send_message(connection, reply) < 0)
+		ni_error("unable to send reply (out of memory)");
+
+	dbus_message_unref(reply);
+	dbus_error_free(&error);
+}
+
+/*
+ * Pass the call to a persistent extension worker
+ */
+typedef struct ni_objectmodel_worker_call {
+	ni_dbus_connection_t *	connection;
+	const ni_dbus_method_t *method;
+	ni_dbus_message_t *	call;
+	ni_tempstate_t *	temp_state;
+} ni_objectmodel_worker_call_t;
+
+static void
+ni_objectmodel_worker_call_free(ni_objectmodel_worker_call_t *wc)
+{
+	if (wc->call)
+		dbus_message_unref(wc->call);
+	if (wc->temp_state)
+		ni_tempstate_finish(wc->temp_state);
+	free(wc);
+}
+
+static void
+ni_objectmodel_extension_worker_reply(void *user_data, const xml_node_t *reply)
+{
+	ni_objectmodel_worker_call_t *wc = user_data;
+	unsigned int status = -1U;
+
+	if (reply == NULL) {
+		ni_error("%s.%s: extension worker failed to process the call",
+				dbus_message_get_interface(wc->call), wc->method->name);
+	} else
+	if (!xml_node_get_attr_uint(reply, "status", &status)) {
+		status = -1U;
+	}
+
+	__ni_objectmodel_extension_reply(wc->connection, wc->method, wc->call,
+						status == 0, reply);
+	ni_objectmodel_worker_call_free(wc);
+}
+
+static dbus_bool_t
+ni_objectmodel_extension_worker_call(ni_dbus_connection_t *connection,
+				ni_dbus_object_t *object, ni_extension_t *extension,
+				const ni_dbus_method_t *method, ni_dbus_message_t *call)
+{
+	ni_var_array_t env = NI_VAR_ARRAY_INIT;
+	ni_objectmodel_worker_call_t *wc;
+	xml_node_t *request, *node;
+	unsigned int i;
+
+	request = xml_node_new("call", NULL);
+	xml_node_add_attr(request, "interface", dbus_message_get_interface(call));
+	xml_node_add_attr(request, "method", method->name);
+	xml_node_add_attr(request, "object-path", object->path);
+
+	node = xml_node_new("environment", request);
+	ni_objectmodel_expand_environment(object, &extension->environment, &env);
+	for (i = 0; i < env.count; ++i) {
+		xml_node_t *var = xml_node_new("putenv", node);
+
+		xml_node_add_attr(var, "name", env.data[i].name);
+		xml_node_add_attr(var, "value", env.data[i].value);
+	}
+	ni_var_array_destroy(&env);
+
+	wc = xcalloc(1, sizeof(*wc));
+	wc->temp_state = ni_tempstate_new(NULL);
+	if (!__ni_objectmodel_message_arguments(call, method, request, wc->temp_state)) {
+		ni_objectmodel_worker_call_free(wc);
+		xml_node_free(request);
+		return FALSE;
+	}
+
+	wc->connection = connection;
+	wc->method = method;
+	wc->call = dbus_message_ref(call);
+	if (!ni_extension_worker_call(extension, request,
+				ni_objectmodel_extension_worker_reply, wc)) {
+		ni_objectmodel_worker_call_free(wc);
+		xml_node_free(request);
+		return FALSE;
+	}
+
+	xml_node_free(request);
+	return TRUE;
+}
+
 dbus_bool_t
 ni_objectmodel_extension_call(ni_dbus_connection_t *connection,
 				ni_dbus_object_t *object, const ni_dbus_method_t *method,
@@ -520,11 +677,13 @@ ni_objectmodel_extension_call(ni_dbus_connection_t *connection,
 {
 	DBusError error = DBUS_ERROR_INIT;
 	const char *interface = dbus_message_get_interface(call);
+	ni_var_array_t env = NI_VAR_ARRAY_INIT;
 	ni_tempstate_t *temp_state = NULL;
 	ni_extension_t *extension;
 	ni_shellcmd_t *command;
 	ni_process_t *process;
 	char *tempname = NULL;
+	unsigned int i;
 
 	NI_TRACE_ENTER_ARGS("object=%s, interface=%s, method=%s", object->path, interface, method->name);
 
@@ -543,12 +702,20 @@ ni_objectmodel_extension_call(ni_dbus_connection_t *connection,
 		return FALSE;
 	}
 
+	/* Prefer the persistent worker, fall back to run the script */
+	if (extension->worker_cmd &&
+	    ni_objectmodel_extension_worker_call(connection, object, extension, method, call))
+		return TRUE;
+
 	ni_debug_extension("preparing to run extension script \"%s\"", command->command);
 
 	/* Create an instance of this command */
 	process = ni_process_new(command);
 
-	ni_objectmodel_expand_environment(object, &extension->environment, process);
+	ni_objectmodel_expand_environment(object, &extension->environment, &env);
+	for (i = 0; i < env.count; ++i)
+		ni_process_setenv(process, env.data[i].name, env.data[i].value);
+	ni_var_array_destroy(&env);
 	temp_state = ni_process_tempstate(process);
 
 	/* Build the argument blob and store it in a file */
@@ -602,8 +769,6 @@ ni_objectmodel_extension_completion(ni_dbus_connection_t *connection, const ni_d
 				ni_dbus_message_t *call, const ni_process_t *process)
 {
 	const char *interface_name = dbus_message_get_interface(call);
-	DBusError error = DBUS_ERROR_INIT;
-	ni_dbus_message_t *reply;
 	const char *filename;
 	xml_document_t *doc = NULL;
 
@@ -613,51 +778,11 @@ ni_objectmodel_extension_completion(ni_dbus_connection_t *connection, const ni_d
 					interface_name, method->name);
 	}
 
-	if (ni_process_exit_status_okay(process)) {
-		ni_dbus_variant_t result = NI_DBUS_VARIANT_INIT;
-		xml_node_t *retnode = NULL;
-		int nres;
-
-		/* if the method returns anything, read it from the response file
-		 * and encode it. */
-		if (doc == NULL
-		 || (retnode = xml_node_get_child(xml_document_root(doc), "return")) == NULL) {
-			nres = 0;
-		} else if ((nres = ni_dbus_serialize_return(method, &result, retnode)) < 0) {
-			dbus_set_error(&error, NI_DBUS_ERROR_CANNOT_MARSHAL,
-					"%s.%s: unable to serialize returned data",
-					interface_name, method->name);
-			ni_dbus_variant_destroy(&result);
-			goto send_error;
-		}
-
-		/* Build the response message */
-		reply = dbus_message_new_method_return(call);
-		if (!ni_dbus_message_serialize_variants(reply, nres, &result, &error)) {
-			ni_dbus_variant_destroy(&result);
-			dbus_message_unref(reply);
-			goto send_error;
-		}
-		ni_dbus_variant_destroy(&result);
-	} else {
-		xml_node_t *errnode = NULL;
-
-		if (doc != NULL)
-			errnode = xml_node_get_child(xml_document_root(doc), "error");
-
-		if (errnode)
-			ni_dbus_serialize_error(&error, errnode);
-		else
-			dbus_set_error(&error, DBUS_ERROR_FAILED, "dbus extension script returns error");
-
-send_error:
-		reply = dbus_message_new_error(call, error.name, error.message);
-	}
-
-	if (ni_dbus_connection_send_message(connection, reply) < 0)
-		ni_error("unable to send reply (out of memory)");
+	__ni_objectmodel_extension_reply(connection, method, call,
+			ni_process_exit_status_okay(process),
+			doc ? xml_document_root(doc) : NULL);
 
-	dbus_message_unref(reply);
+	xml_document_free(doc);
 	return TRUE;
 }
 
@@ -35,19 +35,19 @@ static dbus_bool_t	ni_dbus_validate_xml_union(xml_node_t *, const ni_xs_type_t *
 static dbus_bool_t	ni_dbus_validate_xml_array(xml_node_t *, const ni_xs_type_t *, const ni_dbus_xml_validate_context_t *);
 static dbus_bool_t	ni_dbus_validate_xml_dict(xml_node_t *, const ni_xs_type_t *, const ni_dbus_xml_validate_context_t *);
 static dbus_bool_t	ni_dbus_serialize_xml(xml_node_t *, const ni_xs_type_t *, ni_dbus_variant_t *);
-static dbus_bool_t	ni_dbus_serialize_xml_scalar(xml_node_t *, const ni_xs_type_t *, ni_dbus_variant_t *);
-static dbus_bool_t	ni_dbus_serialize_xml_struct(xml_node_t *, const ni_xs_type_t *, ni_dbus_variant_t *);
-static dbus_bool_t	ni_dbus_serialize_xml_union(xml_node_t *, const ni_xs_type_t *, ni_dbus_variant_t *);
-static dbus_bool_t	ni_dbus_serialize_xml_array(xml_node_t *, const ni_xs_type_t *, ni_dbus_variant_t *);
-static dbus_bool_t	ni_dbus_serialize_xml_dict(xml_node_t *, const ni_xs_type_t *, ni_dbus_variant_t *);
-static dbus_bool_t	ni_dbus_serialize_xml_bitmask(const xml_node_t *, const ni_xs_scalar_info_t *, unsigned long *);
-static dbus_bool_t	ni_dbus_serialize_xml_bitmap(const xml_node_t *, const ni_xs_scalar_info_t *, unsigned long *);
+static dbus_bool_t	ni_dbus_serialize_xml_scalar(xml_node_t *, const ni_dbus_xml_prog_t *, ni_dbus_variant_t *);
+static dbus_bool_t	ni_dbus_serialize_xml_struct(xml_node_t *, const ni_dbus_xml_prog_t *, ni_dbus_variant_t *);
+static dbus_bool_t	ni_dbus_serialize_xml_union(xml_node_t *, const ni_dbus_xml_prog_t *, ni_dbus_variant_t *);
+static dbus_bool_t	ni_dbus_serialize_xml_array(xml_node_t *, const ni_dbus_xml_prog_t *, ni_dbus_variant_t *);
+static dbus_bool_t	ni_dbus_serialize_xml_dict(xml_node_t *, const ni_dbus_xml_prog_t *, ni_dbus_variant_t *);
+static dbus_bool_t	ni_dbus_serialize_xml_bitmask(const xml_node_t *, const ni_dbus_xml_prog_t *, unsigned long *);
+static dbus_bool_t	ni_dbus_serialize_xml_bitmap(const xml_node_t *, const ni_dbus_xml_prog_t *, unsigned long *);
 static dbus_bool_t	ni_dbus_deserialize_xml(const ni_dbus_variant_t *, const ni_xs_type_t *, xml_node_t *);
-static dbus_bool_t	ni_dbus_deserialize_xml_scalar(const ni_dbus_variant_t *, const ni_xs_type_t *, xml_node_t *);
-static dbus_bool_t	ni_dbus_deserialize_xml_struct(const ni_dbus_variant_t *, const ni_xs_type_t *, xml_node_t *);
-static dbus_bool_t	ni_dbus_deserialize_xml_union(const ni_dbus_variant_t *, const ni_xs_type_t *, xml_node_t *);
-static dbus_bool_t	ni_dbus_deserialize_xml_array(const ni_dbus_variant_t *, const ni_xs_type_t *, xml_node_t *);
-static dbus_bool_t	ni_dbus_deserialize_xml_dict(const ni_dbus_variant_t *, const ni_xs_type_t *, xml_node_t *);
+static dbus_bool_t	ni_dbus_deserialize_xml_scalar(const ni_dbus_variant_t *, const ni_dbus_xml_prog_t *, xml_node_t *);
+static dbus_bool_t	ni_dbus_deserialize_xml_struct(const ni_dbus_variant_t *, const ni_dbus_xml_prog_t *, xml_node_t *);
+static dbus_bool_t	ni_dbus_deserialize_xml_union(const ni_dbus_variant_t *, const ni_dbus_xml_prog_t *, xml_node_t *);
+static dbus_bool_t	ni_dbus_deserialize_xml_array(const ni_dbus_variant_t *, const ni_dbus_xml_prog_t *, xml_node_t *);
+static dbus_bool_t	ni_dbus_deserialize_xml_dict(const ni_dbus_variant_t *, const ni_dbus_xml_prog_t *, xml_node_t *);
 static char *		__ni_xs_type_to_dbus_signature(const ni_xs_type_t *, char *, size_t);
 static char *		ni_xs_type_to_dbus_signature(const ni_xs_type_t *);
 static ni_xs_service_t *ni_dbus_xml_get_service_schema(const ni_xs_scope_t *, const char *);
@@ -457,126 +457,419 @@ ni_dbus_validate_xml(xml_node_t *node, const ni_xs_type_t *type, const ni_dbus_x
 }
 
 /*
- * Convert an XML tree to a dbus data object for serialization
+ * Schema types are compiled into a flat conversion program on first use.
+ * It holds the dbus signature and the member and enum/bit name tables
+ * sorted for binary search, so converting a node doesn't walk the type
+ * tree and its name lists over and over again.
  */
-static dbus_bool_t
-ni_dbus_serialize_xml(xml_node_t *node, const ni_xs_type_t *type, ni_dbus_variant_t *var)
-{
-	switch (type->class) {
-		case NI_XS_TYPE_VOID:
-			return TRUE;
+enum {
+	NI_DBUS_XML_OP_VOID,
+	NI_DBUS_XML_OP_FLAG,
+	NI_DBUS_XML_OP_SCALAR,
+	NI_DBUS_XML_OP_ENUM,
+	NI_DBUS_XML_OP_BITMAP,
+	NI_DBUS_XML_OP_BITMASK,
+	NI_DBUS_XML_OP_STRUCT,
+	NI_DBUS_XML_OP_UNION,
+	NI_DBUS_XML_OP_ARRAY,
+	NI_DBUS_XML_OP_DICT,
+};
 
-		case NI_XS_TYPE_SCALAR:
-			return ni_dbus_serialize_xml_scalar(node, type, var);
+typedef struct ni_dbus_xml_member {
+	const char *		name;
+	const ni_xs_type_t *	type;
+} ni_dbus_xml_member_t;
+
+struct ni_dbus_xml_prog {
+	const ni_xs_type_t *	type;
+	unsigned int		op;
+	char *			signature;
+
+	/* dict and union members, sorted by name */
+	unsigned int		nmembers;
+	ni_dbus_xml_member_t *	members;
+
+	/* enum, bitmap and bitmask names, sorted by name and by value */
+	const ni_intmap_t *	bits;
+	unsigned int		nnames;
+	ni_intmap_t *		by_name;
+	unsigned int		nvalues;
+	ni_intmap_t *		by_value;
+
+	/* array element node name */
+	const char *		element_name;
+};
 
-		case NI_XS_TYPE_STRUCT:
-			return ni_dbus_serialize_xml_struct(node, type, var);
+static int
+ni_dbus_xml_member_cmp(const void *a, const void *b)
+{
+	const ni_dbus_xml_member_t *ma = a, *mb = b;
 
-		case NI_XS_TYPE_UNION:
-			return ni_dbus_serialize_xml_union(node, type, var);
+	return strcmp(ma->name, mb->name);
+}
 
-		case NI_XS_TYPE_ARRAY:
-			return ni_dbus_serialize_xml_array(node, type, var);
+static int
+ni_dbus_xml_name_cmp(const void *a, const void *b)
+{
+	const ni_intmap_t *ma = a, *mb = b;
 
-		case NI_XS_TYPE_DICT:
-			return ni_dbus_serialize_xml_dict(node, type, var);
+	return strcasecmp(ma->name, mb->name);
+}
 
-		default:
-			ni_error("unsupported xml type class %u", type->class);
-			return FALSE;
-	}
+static int
+ni_dbus_xml_value_cmp(const void *a, const void *b)
+{
+	const ni_intmap_t *ma = a, *mb = b;
 
-	return TRUE;
+	return ma->value < mb->value ? -1 : ma->value > mb->value;
 }
 
 /*
- * Create XML from a dbus data object
+ * Duplicates are dropped; as in the list lookups, the first one wins.
  */
-dbus_bool_t
-ni_dbus_deserialize_xml(const ni_dbus_variant_t *var, const ni_xs_type_t *type, xml_node_t *node)
+static void
+ni_dbus_xml_prog_set_members(ni_dbus_xml_prog_t *prog, const ni_xs_name_type_array_t *children)
 {
-#if 0
-	int depth = 0;
+	const ni_xs_name_type_t *child;
+	unsigned int i, j;
 
-	{
-		xml_node_t *p;
-		for (p = node->parent; p; p = p->parent)
-			depth++;
+	prog->members = xcalloc(children->count + 1, sizeof(prog->members[0]));
+	for (i = 0, child = children->data; i < children->count; ++i, ++child) {
+		if (child->name == NULL)
+			continue;
+		for (j = 0; j < prog->nmembers; ++j) {
+			if (!strcmp(prog->members[j].name, child->name))
+				break;
+		}
+		if (j < prog->nmembers)
+			continue;
+
+		prog->members[prog->nmembers].name = child->name;
+		prog->members[prog->nmembers].type = child->type;
+		prog->nmembers++;
 	}
+	qsort(prog->members, prog->nmembers, sizeof(prog->members[0]), ni_dbus_xml_member_cmp);
+}
 
-	ni_trace("%*.*sdeserialize <%s>", depth, depth, "", node->name);
-#endif
+static void
+ni_dbus_xml_prog_set_names(ni_dbus_xml_prog_t *prog, const ni_xs_intmap_t *map)
+{
+	const ni_intmap_t *bits, *p, *q;
+	unsigned int count = 0;
 
-	switch (type->class) {
-	case NI_XS_TYPE_VOID:
-		return TRUE;
+	if (!map || !(bits = map->bits))
+		return;
+
+	for (p = bits; p->name; ++p)
+		count++;
+
+	prog->bits = bits;
+	prog->by_name = xcalloc(count + 1, sizeof(prog->by_name[0]));
+	prog->by_value = xcalloc(count + 1, sizeof(prog->by_value[0]));
+	for (p = bits; p->name; ++p) {
+		for (q = bits; q != p && strcasecmp(q->name, p->name); ++q)
+			;
+		if (q == p)
+			prog->by_name[prog->nnames++] = *p;
+
+		for (q = bits; q != p && q->value != p->value; ++q)
+			;
+		if (q == p)
+			prog->by_value[prog->nvalues++] = *p;
+	}
+	qsort(prog->by_name, prog->nnames, sizeof(prog->by_name[0]), ni_dbus_xml_name_cmp);
+	qsort(prog->by_value, prog->nvalues, sizeof(prog->by_value[0]), ni_dbus_xml_value_cmp);
+}
+
+static ni_dbus_xml_prog_t *
+ni_dbus_xml_prog_compile(const ni_xs_type_t *type)
+{
+	ni_dbus_xml_prog_t *prog;
+	ni_xs_scalar_info_t *scalar_info;
+	ni_xs_array_info_t *array_info;
+	char sigbuf[32];
 
+	prog = xcalloc(1, sizeof(*prog));
+	prog->type = type;
+	if (__ni_xs_type_to_dbus_signature(type, sigbuf, sizeof(sigbuf)))
+		prog->signature = xstrdup(sigbuf);
+
+	switch (type->class) {
 	case NI_XS_TYPE_SCALAR:
-		return ni_dbus_deserialize_xml_scalar(var, type, node);
+		scalar_info = ni_xs_scalar_info(type);
+		if (scalar_info->type == DBUS_TYPE_INVALID) {
+			prog->op = NI_DBUS_XML_OP_FLAG;
+		} else
+		if (scalar_info->constraint.bitmap) {
+			prog->op = NI_DBUS_XML_OP_BITMAP;
+			ni_dbus_xml_prog_set_names(prog, scalar_info->constraint.bitmap);
+		} else
+		if (scalar_info->constraint.bitmask) {
+			prog->op = NI_DBUS_XML_OP_BITMASK;
+			ni_dbus_xml_prog_set_names(prog, scalar_info->constraint.bitmask);
+		} else
+		if (scalar_info->constraint.enums) {
+			prog->op = NI_DBUS_XML_OP_ENUM;
+			ni_dbus_xml_prog_set_names(prog, scalar_info->constraint.enums);
+		} else {
+			prog->op = NI_DBUS_XML_OP_SCALAR;
+		}
+		break;
 
 	case NI_XS_TYPE_STRUCT:
-		return ni_dbus_deserialize_xml_struct(var, type, node);
+		prog->op = NI_DBUS_XML_OP_STRUCT;
+		break;
 
 	case NI_XS_TYPE_UNION:
-		return ni_dbus_deserialize_xml_union(var, type, node);
+		prog->op = NI_DBUS_XML_OP_UNION;
+		ni_dbus_xml_prog_set_members(prog, &ni_xs_union_info(type)->children);
+		break;
 
 	case NI_XS_TYPE_ARRAY:
-		return ni_dbus_deserialize_xml_array(var, type, node);
+		prog->op = NI_DBUS_XML_OP_ARRAY;
+		array_info = ni_xs_array_info(type);
+		if (array_info->element_name != NULL)
+			prog->element_name = array_info->element_name;
+		else if (array_info->element_type->origdef.name != NULL)
+			prog->element_name = array_info->element_type->origdef.name;
+		else
+			prog->element_name = "e";
+		break;
 
 	case NI_XS_TYPE_DICT:
-		return ni_dbus_deserialize_xml_dict(var, type, node);
+		prog->op = NI_DBUS_XML_OP_DICT;
+		ni_dbus_xml_prog_set_members(prog, &ni_xs_dict_info(type)->children);
+		break;
 
 	default:
-		ni_error("unsupported xml type class %u", type->class);
-		return FALSE;
+		prog->op = NI_DBUS_XML_OP_VOID;
+		break;
+	}
+
+	return prog;
+}
+
+void
+ni_dbus_xml_prog_free(ni_dbus_xml_prog_t *prog)
+{
+	if (prog) {
+		free(prog->signature);
+		free(prog->members);
+		free(prog->by_name);
+		free(prog->by_value);
+		free(prog);
 	}
+}
+
+static inline const ni_dbus_xml_prog_t *
+ni_dbus_xml_prog(const ni_xs_type_t *type)
+{
+	/* the program is a cache owned by the type */
+	if (type->dbus_prog == NULL)
+		((ni_xs_type_t *)type)->dbus_prog = ni_dbus_xml_prog_compile(type);
+	return type->dbus_prog;
+}
 
+static const ni_xs_type_t *
+ni_dbus_xml_prog_member(const ni_dbus_xml_prog_t *prog, const char *name)
+{
+	ni_dbus_xml_member_t key, *member;
+
+	if (!name || !prog->nmembers)
+		return NULL;
+
+	key.name = name;
+	member = bsearch(&key, prog->members, prog->nmembers, sizeof(key), ni_dbus_xml_member_cmp);
+	return member ? member->type : NULL;
+}
+
+static ni_bool_t
+ni_dbus_xml_prog_parse_name(const ni_dbus_xml_prog_t *prog, const char *name, unsigned int *value)
+{
+	ni_intmap_t key, *sym;
+
+	if (!name || !prog->nnames)
+		return FALSE;
+
+	key.name = name;
+	if (!(sym = bsearch(&key, prog->by_name, prog->nnames, sizeof(key), ni_dbus_xml_name_cmp)))
+		return FALSE;
+
+	*value = sym->value;
 	return TRUE;
 }
 
+static const char *
+ni_dbus_xml_prog_format_value(const ni_dbus_xml_prog_t *prog, unsigned int value)
+{
+	ni_intmap_t key, *sym;
+
+	if (!prog->nvalues)
+		return NULL;
+
+	key.value = value;
+	sym = bsearch(&key, prog->by_value, prog->nvalues, sizeof(key), ni_dbus_xml_value_cmp);
+	return sym ? sym->name : NULL;
+}
+
+/*
+ * Get the next name from a bitmap or bitmask list, using buf if it's
+ * large enough and a malloc'ed copy otherwise.
+ */
+static char *
+ni_dbus_xml_next_name(const char **pos, char *buf, size_t size)
+{
+	static const char *sep = " ,|\t\n";
+	const char *name;
+	size_t len;
+
+	if (*pos == NULL)
+		return NULL;
+
+	name = *pos + strspn(*pos, sep);
+	if (!(len = strcspn(name, sep)))
+		return NULL;
+	*pos = name + len;
+
+	if (len >= size)
+		buf = xmalloc(len + 1);
+	memcpy(buf, name, len);
+	buf[len] = '\0';
+	return buf;
+}
+
+/*
+ * Convert an XML tree to a dbus data object for serialization
+ */
+static dbus_bool_t
+ni_dbus_serialize_xml(xml_node_t *node, const ni_xs_type_t *type, ni_dbus_variant_t *var)
+{
+	const ni_dbus_xml_prog_t *prog = ni_dbus_xml_prog(type);
+
+	switch (prog->op) {
+		case NI_DBUS_XML_OP_VOID:
+			if (type->class != NI_XS_TYPE_VOID)
+				break;
+			return TRUE;
+
+		case NI_DBUS_XML_OP_FLAG:
+		case NI_DBUS_XML_OP_SCALAR:
+		case NI_DBUS_XML_OP_ENUM:
+		case NI_DBUS_XML_OP_BITMAP:
+		case NI_DBUS_XML_OP_BITMASK:
+			return ni_dbus_serialize_xml_scalar(node, prog, var);
+
+		case NI_DBUS_XML_OP_STRUCT:
+			return ni_dbus_serialize_xml_struct(node, prog, var);
+
+		case NI_DBUS_XML_OP_UNION:
+			return ni_dbus_serialize_xml_union(node, prog, var);
+
+		case NI_DBUS_XML_OP_ARRAY:
+			return ni_dbus_serialize_xml_array(node, prog, var);
+
+		case NI_DBUS_XML_OP_DICT:
+			return ni_dbus_serialize_xml_dict(node, prog, var);
+	}
+
+	ni_error("unsupported xml type class %u", type->class);
+	return FALSE;
+}
+
+/*
+ * Create XML from a dbus data object
+ */
+dbus_bool_t
+ni_dbus_deserialize_xml(const ni_dbus_variant_t *var, const ni_xs_type_t *type, xml_node_t *node)
+{
+	const ni_dbus_xml_prog_t *prog = ni_dbus_xml_prog(type);
+
+	switch (prog->op) {
+	case NI_DBUS_XML_OP_VOID:
+		if (type->class != NI_XS_TYPE_VOID)
+			break;
+		return TRUE;
+
+	case NI_DBUS_XML_OP_FLAG:
+	case NI_DBUS_XML_OP_SCALAR:
+	case NI_DBUS_XML_OP_ENUM:
+	case NI_DBUS_XML_OP_BITMAP:
+	case NI_DBUS_XML_OP_BITMASK:
+		return ni_dbus_deserialize_xml_scalar(var, prog, node);
+
+	case NI_DBUS_XML_OP_STRUCT:
+		return ni_dbus_deserialize_xml_struct(var, prog, node);
+
+	case NI_DBUS_XML_OP_UNION:
+		return ni_dbus_deserialize_xml_union(var, prog, node);
+
+	case NI_DBUS_XML_OP_ARRAY:
+		return ni_dbus_deserialize_xml_array(var, prog, node);
+
+	case NI_DBUS_XML_OP_DICT:
+		return ni_dbus_deserialize_xml_dict(var, prog, node);
+	}
+
+	ni_error("unsupported xml type class %u", type->class);
+	return FALSE;
+}
+
 /*
  * XML -> dbus_variant conversion for scalars
  */
 static dbus_bool_t
-ni_dbus_serialize_xml_bitmask(const xml_node_t *node, const ni_xs_scalar_info_t *scalar_info, unsigned long *result)
+ni_dbus_serialize_xml_bitmask(const xml_node_t *node, const ni_dbus_xml_prog_t *prog, unsigned long *result)
 {
-	ni_string_array_t bit_name_arr = NI_STRING_ARRAY_INIT;
-	const ni_intmap_t *bits;
+	const char *pos;
+	char buf[64], *name;
 	unsigned long value = 0, v;
-	unsigned int i, bv;
+	unsigned int bv;
 
-	if (!node || !result || !scalar_info || !scalar_info->constraint.bitmask->bits)
+	if (!node || !result || !prog || !prog->bits)
 		return FALSE;
 
-	bits = scalar_info->constraint.bitmask->bits;
-	ni_string_split(&bit_name_arr, node->cdata, " ,|\t\n", 0);
-	for (i = 0; i < bit_name_arr.count; ++i) {
-		if (ni_parse_ulong(bit_name_arr.data[i], &v, 16) == 0) {
+	for (pos = node->cdata; (name = ni_dbus_xml_next_name(&pos, buf, sizeof(buf))); ) {
+		if (ni_parse_ulong(name, &v, 16) == 0) {
 			value |= v;
 		} else
-		if (ni_parse_uint_mapped(bit_name_arr.data[i], bits, &bv) == 0) {
+		if (ni_dbus_xml_prog_parse_name(prog, name, &bv)) {
 			value |= bv;
 		} else {
 			ni_error("%s: unknown bitmask value name <%s>",
-				xml_node_location(node),
-				bit_name_arr.data[i]);
+				xml_node_location(node), name);
+			if (name != buf)
+				free(name);
 			return FALSE;
 		}
+		if (name != buf)
+			free(name);
 	}
 
 	*result = value;
 	return TRUE;
 }
 
+static ni_bool_t
+ni_dbus_serialize_xml_bit(const xml_node_t *node, const ni_dbus_xml_prog_t *prog,
+				const char *name, unsigned long *value)
+{
+	unsigned int bb;
+
+	if (!ni_dbus_xml_prog_parse_name(prog, name, &bb) || bb >= 32) {
+		ni_error("%s: unknown or bad bit value <%s>",
+			xml_node_location(node), name);
+		return FALSE;
+	}
+
+	*value |= NI_BIT(bb);
+	return TRUE;
+}
+
 static dbus_bool_t
-ni_dbus_serialize_xml_bitmap(const xml_node_t *node, const ni_xs_scalar_info_t *scalar_info, unsigned long *result)
+ni_dbus_serialize_xml_bitmap(const xml_node_t *node, const ni_dbus_xml_prog_t *prog, unsigned long *result)
 {
-	const ni_intmap_t *bits = scalar_info->constraint.bitmap->bits;
-	ni_string_array_t bit_name_arr = NI_STRING_ARRAY_INIT;
 	unsigned long value = 0;
-	unsigned int i;
-	unsigned int bb;
-	xml_node_t *child;
+	const xml_node_t *child;
 	dbus_bool_t ret = TRUE;
 
 	if (!node)
@@ -586,7 +879,14 @@ ni_dbus_serialize_xml_bitmap(const xml_node_t *node, const ni_xs_scalar_info_t *
 		/* Data is of the form:
 		 *   <node>flag1,...,flagN</node>
 		 */
-		ni_string_split(&bit_name_arr, node->cdata, " ,|\t\n", 0);
+		const char *pos = node->cdata;
+		char buf[64], *name;
+
+		while (ret && (name = ni_dbus_xml_next_name(&pos, buf, sizeof(buf)))) {
+			ret = ni_dbus_serialize_xml_bit(node, prog, name, &value);
+			if (name != buf)
+				free(name);
+		}
 	} else {
 		/* Data is of the form:
 		 *   <node>
@@ -595,37 +895,22 @@ ni_dbus_serialize_xml_bitmap(const xml_node_t *node, const ni_xs_scalar_info_t *
 		 *     <flagN/>
 		 *   </node>
 		 */
-		for (child = node->children; child; child = child->next)
-			ni_string_array_append(&bit_name_arr, child->name);
-	}
-
-	for (i = 0; i < bit_name_arr.count && ret; ++i) {
-		if (ni_parse_uint_mapped(bit_name_arr.data[i], bits, &bb) < 0 ||
-			bb >= 32) {
-			ni_error("%s: unknown or bad bit value <%s>",
-				xml_node_location(node),
-				bit_name_arr.data[i]);
-			ret = FALSE;
-		}
-
-		/* May left shift past width of value if bb >= 32, but as ret
-		 * will be FALSE assignment to result will not happen. */
-		value |= NI_BIT(bb);
+		for (child = node->children; child && ret; child = child->next)
+			ret = ni_dbus_serialize_xml_bit(node, prog, child->name, &value);
 	}
 
-	ni_string_array_destroy(&bit_name_arr);
 	*result = ret ? value : *result;
 
 	return ret;
 }
 
 static dbus_bool_t
-ni_dbus_serialize_xml_enum(const xml_node_t *node, const ni_xs_scalar_info_t *scalar_info, unsigned long *result)
+ni_dbus_serialize_xml_enum(const xml_node_t *node, const ni_dbus_xml_prog_t *prog, unsigned long *result)
 {
-	const ni_intmap_t *names = scalar_info->constraint.enums->bits;
 	unsigned int value;
 
-	if (ni_parse_uint_maybe_mapped(node->cdata, names, &value, 0) < 0) {
+	if (!ni_dbus_xml_prog_parse_name(prog, node->cdata, &value)
+	 && ni_parse_uint(node->cdata, &value, 0) < 0) {
 		ni_error("%s: unknown enum value \"%s\"", xml_node_location(node), node->cdata);
 		return FALSE;
 	}
@@ -663,13 +948,14 @@ dbus_bool_t
 ni_dbus_validate_xml_scalar(xml_node_t *node, const ni_xs_type_t *type, const ni_dbus_xml_validate_context_t *ctx)
 {
 	ni_xs_scalar_info_t *scalar_info = ni_xs_scalar_info(type);
+	const ni_dbus_xml_prog_t *prog = ni_dbus_xml_prog(type);
 	unsigned long value;
 
 	if (scalar_info->constraint.bitmap)
-		return ni_dbus_serialize_xml_bitmap(node, scalar_info, &value);
+		return ni_dbus_serialize_xml_bitmap(node, prog, &value);
 
 	if (scalar_info->constraint.bitmask)
-		return ni_dbus_serialize_xml_bitmask(node, scalar_info, &value);
+		return ni_dbus_serialize_xml_bitmask(node, prog, &value);
 
 	/* This signals a "flag" type element, ie we simply test for its presence or
 	 * absence. */
@@ -687,40 +973,38 @@ ni_dbus_validate_xml_scalar(xml_node_t *node, const ni_xs_type_t *type, const ni
 	}
 
 	if (scalar_info->constraint.enums)
-		return ni_dbus_serialize_xml_enum(node, scalar_info, &value);
+		return ni_dbus_serialize_xml_enum(node, prog, &value);
 
 	/* FIXME: validate whether scalar value can be parsed! */
 	return TRUE;
 }
 
 dbus_bool_t
-ni_dbus_serialize_xml_scalar(xml_node_t *node, const ni_xs_type_t *type, ni_dbus_variant_t *var)
+ni_dbus_serialize_xml_scalar(xml_node_t *node, const ni_dbus_xml_prog_t *prog, ni_dbus_variant_t *var)
 {
-	ni_xs_scalar_info_t *scalar_info = ni_xs_scalar_info(type);
+	unsigned long value;
 
-	/* This signals a "flag" type element, ie we simply test for its presence or
-	 * absence. We encode it as a BYTE value. */
-	if (scalar_info->type == DBUS_TYPE_INVALID) {
+	switch (prog->op) {
+	case NI_DBUS_XML_OP_FLAG:
+		/* This signals a "flag" type element, ie we simply test for its presence or
+		 * absence. We encode it as a BYTE value. */
 		ni_dbus_variant_set_byte(var, 0);
 		return TRUE;
-	}
-
-	if (scalar_info->constraint.bitmap) {
-		unsigned long value;
 
-		if (!ni_dbus_serialize_xml_bitmap(node, scalar_info, &value)
-		 || !ni_dbus_variant_init_signature(var, ni_xs_type_to_dbus_signature(type)))
+	case NI_DBUS_XML_OP_BITMAP:
+		if (!ni_dbus_serialize_xml_bitmap(node, prog, &value)
+		 || !ni_dbus_variant_init_signature(var, prog->signature))
 			return FALSE;
 		return ni_dbus_variant_set_ulong(var, value);
-	}
-
-	if (scalar_info->constraint.bitmask) {
-		unsigned long value;
 
-		if (!ni_dbus_serialize_xml_bitmask(node, scalar_info, &value)
-		 || !ni_dbus_variant_init_signature(var, ni_xs_type_to_dbus_signature(type)))
+	case NI_DBUS_XML_OP_BITMASK:
+		if (!ni_dbus_serialize_xml_bitmask(node, prog, &value)
+		 || !ni_dbus_variant_init_signature(var, prog->signature))
 			return FALSE;
 		return ni_dbus_variant_set_ulong(var, value);
+
+	default:
+		break;
 	}
 
 	if (node->cdata == NULL) {
@@ -728,17 +1012,15 @@ ni_dbus_serialize_xml_scalar(xml_node_t *node, const ni_xs_type_t *type, ni_dbus
 		return FALSE;
 	}
 
-	if (scalar_info->constraint.enums) {
-		unsigned long value;
-
-		if (!ni_dbus_serialize_xml_enum(node, scalar_info, &value)
-		 || !ni_dbus_variant_init_signature(var, ni_xs_type_to_dbus_signature(type)))
+	if (prog->op == NI_DBUS_XML_OP_ENUM) {
+		if (!ni_dbus_serialize_xml_enum(node, prog, &value)
+		 || !ni_dbus_variant_init_signature(var, prog->signature))
 			return FALSE;
 		return ni_dbus_variant_set_uint(var, value);
 	}
 
 	/* TBD: handle constants defined in the schema? */
-	if (!ni_dbus_variant_parse(var, node->cdata, ni_xs_type_to_dbus_signature(type))) {
+	if (!ni_dbus_variant_parse(var, node->cdata, prog->signature)) {
 		ni_error("unable to serialize node %s - cannot parse value", node->name);
 		return FALSE;
 	}
@@ -750,9 +1032,8 @@ ni_dbus_serialize_xml_scalar(xml_node_t *node, const ni_xs_type_t *type, ni_dbus
  * XML from dbus variant for scalars
  */
 dbus_bool_t
-ni_dbus_deserialize_xml_scalar(const ni_dbus_variant_t *var, const ni_xs_type_t *type, xml_node_t *node)
+ni_dbus_deserialize_xml_scalar(const ni_dbus_variant_t *var, const ni_dbus_xml_prog_t *prog, xml_node_t *node)
 {
-	ni_xs_scalar_info_t *scalar_info = ni_xs_scalar_info(type);
 	const char *value;
 
 	if (var->type == DBUS_TYPE_ARRAY) {
@@ -762,7 +1043,7 @@ ni_dbus_deserialize_xml_scalar(const ni_dbus_variant_t *var, const ni_xs_type_t
 
 	/* This signals a "flag" type element, ie we simply test for its presence or
 	 * absence. We encode it as a BYTE value. */
-	if (scalar_info->type == DBUS_TYPE_INVALID) {
+	if (prog->op == NI_DBUS_XML_OP_FLAG) {
 		if (var->type != DBUS_TYPE_BYTE) {
 			ni_error("%s: <%s> flag element encoded incorrectly",
 					__func__, node->name);
@@ -771,9 +1052,9 @@ ni_dbus_deserialize_xml_scalar(const ni_dbus_variant_t *var, const ni_xs_type_t
 		return TRUE;
 	}
 
-	if (scalar_info->constraint.bitmask) {
-		const ni_intmap_t *bits = scalar_info->constraint.bitmask->bits;
-		ni_string_array_t bit_name_arr = NI_STRING_ARRAY_INIT;
+	if (prog->op == NI_DBUS_XML_OP_BITMASK) {
+		ni_stringbuf_t buf = NI_STRINGBUF_INIT_DYNAMIC;
+		const ni_intmap_t *bits = prog->bits;
 		unsigned long value = 0;
 
 		if (!ni_dbus_variant_get_ulong(var, &value))
@@ -783,23 +1064,24 @@ ni_dbus_deserialize_xml_scalar(const ni_dbus_variant_t *var, const ni_xs_type_t
 			if ((value & bits->value) != bits->value)
 				continue;
 
-			ni_string_array_append(&bit_name_arr, bits->name);
+			if (buf.len)
+				ni_stringbuf_puts(&buf, " | ");
+			ni_stringbuf_puts(&buf, bits->name);
 			value &= ~(bits->value);
 		}
 		if (value) {
-			char num[64] = { '\0' };
-			snprintf(num, sizeof(num), "0x%lx", value);
-			ni_string_array_append(&bit_name_arr, num);
+			if (buf.len)
+				ni_stringbuf_puts(&buf, " | ");
+			ni_stringbuf_printf(&buf, "0x%lx", value);
 		}
 
-		ni_string_join(&node->cdata, &bit_name_arr, " | ");
-		ni_string_array_destroy(&bit_name_arr);
+		ni_string_free(&node->cdata);
+		node->cdata = buf.string;
 		return TRUE;
 	}
 
-	if (scalar_info->constraint.bitmap) {
-		const ni_intmap_t *bits = scalar_info->constraint.bitmap->bits;
-		ni_string_array_t bit_name_arr = NI_STRING_ARRAY_INIT;
+	if (prog->op == NI_DBUS_XML_OP_BITMAP) {
+		ni_stringbuf_t buf = NI_STRINGBUF_INIT_DYNAMIC;
 		unsigned long value = 0;
 		unsigned int bb;
 
@@ -812,21 +1094,24 @@ ni_dbus_deserialize_xml_scalar(const ni_dbus_variant_t *var, const ni_xs_type_t
 			if ((value & (1 << bb)) == 0)
 				continue;
 
-			if ((bit_name = ni_format_uint_mapped(bb, bits)) != NULL)
-				ni_string_array_append(&bit_name_arr, bit_name);
-			else
+			if ((bit_name = ni_dbus_xml_prog_format_value(prog, bb)) != NULL) {
+				if (buf.len)
+					ni_stringbuf_puts(&buf, ", ");
+				ni_stringbuf_puts(&buf, bit_name);
+			} else {
 				ni_warn("unable to represent bit%u in <%s>", bb, node->name);
+			}
 		}
 
-		if (!ni_string_join(&node->cdata, &bit_name_arr, ", "))
+		if (!buf.len)
 			ni_debug_dbus("Empty bit names string obtained.");
 
-		ni_string_array_destroy(&bit_name_arr);
-
+		ni_string_free(&node->cdata);
+		node->cdata = buf.string;
 		return TRUE;
 	}
 
-	if (scalar_info->constraint.enums) {
+	if (prog->op == NI_DBUS_XML_OP_ENUM) {
 		const char *enum_name;
 		unsigned int value;
 
@@ -835,7 +1120,7 @@ ni_dbus_deserialize_xml_scalar(const ni_dbus_variant_t *var, const ni_xs_type_t
 			return FALSE;
 		}
 
-		enum_name = ni_format_uint_mapped(value, scalar_info->constraint.enums->bits);
+		enum_name = ni_dbus_xml_prog_format_value(prog, value);
 		if (enum_name != NULL) {
 			xml_node_set_cdata(node, enum_name);
 		} else {
@@ -916,9 +1201,9 @@ ni_dbus_validate_xml_array(xml_node_t *node, const ni_xs_type_t *type, const ni_
  * Serialize an array
  */
 dbus_bool_t
-ni_dbus_serialize_xml_array(xml_node_t *node, const ni_xs_type_t *type, ni_dbus_variant_t *var)
+ni_dbus_serialize_xml_array(xml_node_t *node, const ni_dbus_xml_prog_t *prog, ni_dbus_variant_t *var)
 {
-	ni_xs_array_info_t *array_info = ni_xs_array_info(type);
+	ni_xs_array_info_t *array_info = ni_xs_array_info(prog->type);
 	ni_xs_type_t *element_type = array_info->element_type;
 	xml_node_t *child;
 
@@ -927,7 +1212,7 @@ ni_dbus_serialize_xml_array(xml_node_t *node, const ni_xs_type_t *type, ni_dbus_
 		return ni_dbus_serialize_byte_array_notation(node, array_info, &var->byte_array_value, &var->array.len);
 	}
 
-	if (!ni_dbus_variant_init_signature(var, ni_xs_type_to_dbus_signature(type)))
+	if (!ni_dbus_variant_init_signature(var, prog->signature))
 		return FALSE;
 
 	for (child = node->children; child; child = child->next) {
@@ -972,9 +1257,9 @@ ni_dbus_serialize_xml_array(xml_node_t *node, const ni_xs_type_t *type, ni_dbus_
  * XML from dbus variant for arrays
  */
 dbus_bool_t
-ni_dbus_deserialize_xml_array(const ni_dbus_variant_t *var, const ni_xs_type_t *type, xml_node_t *node)
+ni_dbus_deserialize_xml_array(const ni_dbus_variant_t *var, const ni_dbus_xml_prog_t *prog, xml_node_t *node)
 {
-	ni_xs_array_info_t *array_info = ni_xs_array_info(type);
+	ni_xs_array_info_t *array_info = ni_xs_array_info(prog->type);
 	ni_xs_type_t *element_type = array_info->element_type;
 	unsigned int i, array_len;
 
@@ -1011,7 +1296,7 @@ ni_dbus_deserialize_xml_array(const ni_dbus_variant_t *var, const ni_xs_type_t *
 		}
 
 		for (i = 0; i < array_len; ++i) {
-			const char *string, *name = "e";
+			const char *string;
 			xml_node_t *child;
 
 			if (!(string = ni_dbus_variant_array_print_element(var, i))) {
@@ -1019,12 +1304,7 @@ ni_dbus_deserialize_xml_array(const ni_dbus_variant_t *var, const ni_xs_type_t *
 				return FALSE;
 			}
 
-			if (array_info->element_name != NULL)
-				name = array_info->element_name;
-			else if (element_type->origdef.name != NULL)
-				name = element_type->origdef.name;
-
-			child = xml_node_new(name, node);
+			child = xml_node_new(prog->element_name, node);
 			xml_node_set_cdata(child, string);
 		}
 	} else if (element_type->class == NI_XS_TYPE_DICT) {
@@ -1038,14 +1318,8 @@ ni_dbus_deserialize_xml_array(const ni_dbus_variant_t *var, const ni_xs_type_t *
 		for (i = 0; i < array_len; ++i) {
 			ni_dbus_variant_t *element = &var->variant_array_value[i];
 			xml_node_t *child;
-			const char *name = "e";
-
-			if (array_info->element_name != NULL)
-				name = array_info->element_name;
-			else if (element_type->origdef.name != NULL)
-				name = element_type->origdef.name;
 
-			child = xml_node_new(name, node);
+			child = xml_node_new(prog->element_name, node);
 			if (!ni_dbus_deserialize_xml(element, element_type, child))
 				return FALSE;
 		}
@@ -1061,14 +1335,13 @@ ni_dbus_deserialize_xml_array(const ni_dbus_variant_t *var, const ni_xs_type_t *
  * Serialize a dict
  */
 dbus_bool_t
-ni_dbus_serialize_xml_dict(xml_node_t *node, const ni_xs_type_t *type, ni_dbus_variant_t *dict)
+ni_dbus_serialize_xml_dict(xml_node_t *node, const ni_dbus_xml_prog_t *prog, ni_dbus_variant_t *dict)
 {
-	ni_xs_dict_info_t *dict_info = ni_xs_dict_info(type);
 	xml_node_t *child;
 
 	ni_dbus_variant_init_dict(dict);
 	for (child = node->children; child; child = child->next) {
-		const ni_xs_type_t *child_type = ni_xs_dict_info_find(dict_info, child->name);
+		const ni_xs_type_t *child_type = ni_dbus_xml_prog_member(prog, child->name);
 		ni_dbus_variant_t *child_var;
 
 		if (child_type == NULL) {
@@ -1086,6 +1359,7 @@ dbus_bool_t
 ni_dbus_validate_xml_dict(xml_node_t *node, const ni_xs_type_t *type, const ni_dbus_xml_validate_context_t *ctx)
 {
 	ni_xs_dict_info_t *dict_info = ni_xs_dict_info(type);
+	const ni_dbus_xml_prog_t *prog = ni_dbus_xml_prog(type);
 	xml_node_t *child;
 	unsigned int i;
 
@@ -1094,7 +1368,7 @@ ni_dbus_validate_xml_dict(xml_node_t *node, const ni_xs_type_t *type, const ni_d
 	/* First, validate all child nodes. This gives us an opportunity to fix up things
 	 * inside the callback */
 	for (child = node->children; child; child = child->next) {
-		const ni_xs_type_t *child_type = ni_xs_dict_info_find(dict_info, child->name);
+		const ni_xs_type_t *child_type = ni_dbus_xml_prog_member(prog, child->name);
 
 		if (child_type == NULL)
 			continue;
@@ -1142,7 +1416,7 @@ ni_dbus_validate_xml_dict(xml_node_t *node, const ni_xs_type_t *type, const ni_d
 			dict_info->groups.data[i]->count = 0;
 
 		for (child = node->children; child; child = child->next) {
-			const ni_xs_type_t *child_type = ni_xs_dict_info_find(dict_info, child->name);
+			const ni_xs_type_t *child_type = ni_dbus_xml_prog_member(prog, child->name);
 
 			if (child_type == NULL) {
 				ni_warn("%s: ignoring unknown dict element \"%s\"", __func__, child->name);
@@ -1184,9 +1458,8 @@ ni_dbus_validate_xml_dict(xml_node_t *node, const ni_xs_type_t *type, const ni_d
  * Deserialize a dict
  */
 dbus_bool_t
-ni_dbus_deserialize_xml_dict(const ni_dbus_variant_t *var, const ni_xs_type_t *type, xml_node_t *node)
+ni_dbus_deserialize_xml_dict(const ni_dbus_variant_t *var, const ni_dbus_xml_prog_t *prog, xml_node_t *node)
 {
-	ni_xs_dict_info_t *dict_info = ni_xs_dict_info(type);
 	ni_dbus_dict_entry_t *entry;
 	unsigned int i;
 
@@ -1201,7 +1474,7 @@ ni_dbus_deserialize_xml_dict(const ni_dbus_variant_t *var, const ni_xs_type_t *t
 		xml_node_t *child;
 
 		/* Silently ignore dict entries we have no schema information for */
-		if (!(child_type = ni_xs_dict_info_find(dict_info, entry->key))) {
+		if (!(child_type = ni_dbus_xml_prog_member(prog, entry->key))) {
 			ni_debug_dbus("%s: ignoring unknown dict entry %s in node <%s>",
 					__func__, entry->key, node->name);
 			continue;
@@ -1225,14 +1498,14 @@ ni_dbus_validate_xml_struct(xml_node_t *node, const ni_xs_type_t *type, const ni
 }
 
 dbus_bool_t
-ni_dbus_serialize_xml_struct(xml_node_t *node, const ni_xs_type_t *type, ni_dbus_variant_t *var)
+ni_dbus_serialize_xml_struct(xml_node_t *node, const ni_dbus_xml_prog_t *prog, ni_dbus_variant_t *var)
 {
 	ni_error("%s: not implemented yet", __func__);
 	return FALSE;
 }
 
 static dbus_bool_t
-ni_dbus_deserialize_xml_struct(const ni_dbus_variant_t *var, const ni_xs_type_t *type, xml_node_t *node)
+ni_dbus_deserialize_xml_struct(const ni_dbus_variant_t *var, const ni_dbus_xml_prog_t *prog, xml_node_t *node)
 {
 	ni_error("%s: not implemented yet", __func__);
 	return FALSE;
@@ -1260,7 +1533,7 @@ __ni_dbus_xml_union_type(xml_node_t *node, const ni_xs_type_t *type, const char
 	if (kind_p)
 		*kind_p = kind;
 
-	child_type = ni_xs_union_info_find(union_info, kind);
+	child_type = ni_dbus_xml_prog_member(ni_dbus_xml_prog(type), kind);
 	if (child_type == NULL) {
 		ni_error("%s: <%s> invalid attribute %s=\"%s\": discriminant type not known",
 				xml_node_location(node),
@@ -1283,13 +1556,13 @@ ni_dbus_validate_xml_union(xml_node_t *node, const ni_xs_type_t *type, const ni_
 }
 
 dbus_bool_t
-ni_dbus_serialize_xml_union(xml_node_t *node, const ni_xs_type_t *type, ni_dbus_variant_t *var)
+ni_dbus_serialize_xml_union(xml_node_t *node, const ni_dbus_xml_prog_t *prog, ni_dbus_variant_t *var)
 {
 	const ni_xs_type_t *child_type;
 	ni_dbus_variant_t *child;
 	const char *kind;
 
-	child_type = __ni_dbus_xml_union_type(node, type, &kind);
+	child_type = __ni_dbus_xml_union_type(node, prog->type, &kind);
 	if (child_type == NULL)
 		return FALSE;
 
@@ -1309,9 +1582,9 @@ ni_dbus_serialize_xml_union(xml_node_t *node, const ni_xs_type_t *type, ni_dbus_
 }
 
 static dbus_bool_t
-ni_dbus_deserialize_xml_union(const ni_dbus_variant_t *var, const ni_xs_type_t *type, xml_node_t *node)
+ni_dbus_deserialize_xml_union(const ni_dbus_variant_t *var, const ni_dbus_xml_prog_t *prog, xml_node_t *node)
 {
-	ni_xs_union_info_t *union_info = ni_xs_union_info(type);
+	ni_xs_union_info_t *union_info = ni_xs_union_info(prog->type);
 	const ni_xs_type_t *child_type;
 	ni_dbus_variant_t *child;
 	const char *kind;
@@ -1322,7 +1595,7 @@ ni_dbus_deserialize_xml_union(const ni_dbus_variant_t *var, const ni_xs_type_t *
 	xml_node_add_attr(node, union_info->discriminant, kind);
 
 	/* Now we can look up the child type based on the discriminant */
-	child_type = __ni_dbus_xml_union_type(node, type, NULL);
+	child_type = __ni_dbus_xml_union_type(node, prog->type, NULL);
 	if (child_type == NULL)
 		return FALSE;
 
@@ -1906,5 +2179,5 @@ ni_dbus_xml_get_method_metadata(const ni_dbus_method_t *method, const char *name
 const char *
 ni_dbus_xml_type_signature(const ni_xs_type_t *type)
 {
-	return ni_xs_type_to_dbus_signature(type);
+	return ni_dbus_xml_prog(type)->signature;
 }
@@ -378,7 +378,7 @@ ni_dhcp4_acquire(ni_dhcp4_device_t *dev, const ni_dhcp4_request_t *info)
 			dev->notify = 1;
 		} else {
 			/* Lease may be good */
-			dev->fsm.state = NI_DHCP4_STATE_REBOOT;
+			ni_dhcp4_fsm_set_state(dev, NI_DHCP4_STATE_REBOOT);
 		}
 	}
 
@@ -546,7 +546,7 @@ ni_dhcp4_release(ni_dhcp4_device_t *dev, const ni_uuid_t *req_uuid)
 
 	dev->lease->uuid = *req_uuid;
 	dev->config->uuid = *req_uuid;
-	dev->fsm.state = NI_DHCP4_STATE_INIT;
+	ni_dhcp4_fsm_set_state(dev, NI_DHCP4_STATE_INIT);
 	ni_dhcp4_device_disarm_retransmit(dev);
 	if (dev->fsm.timer) {
 		ni_timer_cancel(dev->fsm.timer);
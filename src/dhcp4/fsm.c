@@ -20,6 +20,7 @@
 #include <wicked/netinfo.h>
 #include <wicked/logging.h>
 #include <wicked/route.h>
+#include <wicked/metrics.h>
 #include <netlink/netlink.h>
 #include "netinfo_priv.h"
 #include "buffer.h"
@@ -340,7 +341,7 @@ out:
 static void
 ni_dhcp4_fsm_restart(ni_dhcp4_device_t *dev)
 {
-	dev->fsm.state = NI_DHCP4_STATE_INIT;
+	ni_dhcp4_fsm_set_state(dev, NI_DHCP4_STATE_INIT);
 
 	ni_dhcp4_device_disarm_retransmit(dev);
 	if (dev->fsm.timer) {
@@ -393,7 +394,7 @@ __ni_dhcp4_fsm_discover(ni_dhcp4_device_t *dev, int scan_offers)
 	lease->fqdn.qualify = dev->config->fqdn.qualify;
 	ni_string_free(&lease->hostname);
 
-	dev->fsm.state = NI_DHCP4_STATE_SELECTING;
+	ni_dhcp4_fsm_set_state(dev, NI_DHCP4_STATE_SELECTING);
 	dev->dhcp4.accept_any_offer = 1;
 
 	ni_debug_dhcp("valid lease: %d; have prefs: %d",
@@ -420,7 +421,7 @@ __ni_dhcp4_fsm_discover(ni_dhcp4_device_t *dev, int scan_offers)
 static void
 ni_dhcp4_fsm_discover_init(ni_dhcp4_device_t *dev)
 {
-	dev->fsm.state = NI_DHCP4_STATE_SELECTING;
+	ni_dhcp4_fsm_set_state(dev, NI_DHCP4_STATE_SELECTING);
 	ni_dhcp4_new_xid(dev);
 
 	ni_timer_get_time(&dev->start_time);
@@ -431,7 +432,7 @@ ni_dhcp4_fsm_discover_init(ni_dhcp4_device_t *dev)
 static void
 ni_dhcp4_fsm_request(ni_dhcp4_device_t *dev, const ni_addrconf_lease_t *lease)
 {
-	dev->fsm.state = NI_DHCP4_STATE_REQUESTING;
+	ni_dhcp4_fsm_set_state(dev, NI_DHCP4_STATE_REQUESTING);
 
 	dev->config->capture_timeout = dev->config->capture_max_timeout;
 	if (dev->config->acquire_timeout && dev->config->acquire_timeout - dev->config->elapsed_timeout < dev->config->capture_max_timeout)
@@ -469,7 +470,7 @@ ni_dhcp4_fsm_renewal(ni_dhcp4_device_t *dev, ni_bool_t oneshot)
 static void
 ni_dhcp4_fsm_renewal_init(ni_dhcp4_device_t *dev)
 {
-	dev->fsm.state = NI_DHCP4_STATE_RENEWING;
+	ni_dhcp4_fsm_set_state(dev, NI_DHCP4_STATE_RENEWING);
 	ni_dhcp4_new_xid(dev);
 
 	ni_timer_get_time(&dev->start_time);
@@ -505,7 +506,7 @@ ni_dhcp4_fsm_rebind(ni_dhcp4_device_t *dev, ni_bool_t oneshot)
 static void
 ni_dhcp4_fsm_rebind_init(ni_dhcp4_device_t *dev)
 {
-	dev->fsm.state = NI_DHCP4_STATE_REBINDING;
+	ni_dhcp4_fsm_set_state(dev, NI_DHCP4_STATE_REBINDING);
 	ni_dhcp4_new_xid(dev);
 
 	ni_timer_get_time(&dev->start_time);
@@ -522,7 +523,7 @@ ni_dhcp4_fsm_reboot(ni_dhcp4_device_t *dev)
 	/* RFC 2131, 3.2 (see also 3.1) */
 	ni_debug_dhcp("trying to confirm lease for %s", dev->ifname);
 
-	dev->fsm.state = NI_DHCP4_STATE_REBOOT;
+	ni_dhcp4_fsm_set_state(dev, NI_DHCP4_STATE_REBOOT);
 	ni_dhcp4_new_xid(dev);
 	dev->config->elapsed_timeout = 0;
 
@@ -549,7 +550,7 @@ ni_dhcp4_fsm_decline(ni_dhcp4_device_t *dev)
 	ni_warn("%s: Declining DHCPv4 lease with address %s", dev->ifname,
 		inet_ntoa(dev->lease->dhcp4.address));
 
-	dev->fsm.state = NI_DHCP4_STATE_INIT;
+	ni_dhcp4_fsm_set_state(dev, NI_DHCP4_STATE_INIT);
 
 	ni_timer_get_time(&dev->start_time);
 	ni_dhcp4_device_send_message(dev, DHCP4_DECLINE, dev->lease);
@@ -582,7 +583,7 @@ void
 ni_dhcp4_fsm_release_init(ni_dhcp4_device_t *dev)
 {
 	/* there is currently no releasing state... */
-	dev->fsm.state = NI_DHCP4_STATE_INIT;
+	ni_dhcp4_fsm_set_state(dev, NI_DHCP4_STATE_INIT);
 	ni_dhcp4_new_xid(dev);
 
 	ni_timer_get_time(&dev->start_time);
@@ -893,7 +894,7 @@ ni_dhcp4_fsm_commit_lease(ni_dhcp4_device_t *dev, ni_addrconf_lease_t *lease)
 		}
 
 		ni_dhcp4_device_set_lease(dev, lease);
-		dev->fsm.state = NI_DHCP4_STATE_BOUND;
+		ni_dhcp4_fsm_set_state(dev, NI_DHCP4_STATE_BOUND);
 
 		ni_note("%s: Committed DHCPv4 lease with address %s "
 			"(lease time %u sec, renew in %u sec, rebind in %u sec)",
@@ -1054,7 +1055,7 @@ ni_dhcp4_fsm_validate_lease(ni_dhcp4_device_t *dev, ni_addrconf_lease_t *lease)
 		return -1;
 	}
 
-	dev->fsm.state = NI_DHCP4_STATE_VALIDATING;
+	ni_dhcp4_fsm_set_state(dev, NI_DHCP4_STATE_VALIDATING);
 	return 0;
 }
 
@@ -1226,6 +1227,14 @@ static const char *__dhcp4_state_name[__NI_DHCP4_STATE_MAX] = {
  [NI_DHCP4_STATE_REBOOT]	= "REBOOT",
 };
 
+void
+ni_dhcp4_fsm_set_state(ni_dhcp4_device_t *dev, enum fsm_state state)
+{
+	if (dev->fsm.state != state)
+		ni_metrics_count(NI_METRIC_DHCP4_TRANSITIONS);
+	dev->fsm.state = state;
+}
+
 const char *
 ni_dhcp4_fsm_state_name(enum fsm_state state)
 {
@@ -28,6 +28,7 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <stdio.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -139,14 +140,33 @@ ni_dhcp4_socket_recv(ni_socket_t *sock)
 }
 
 /*
- * Inline functions for setting/retrieving options from a buffer
+ * Functions for setting/retrieving options from a buffer
+ *
+ * The message buffer is preallocated to the device mtu; each option
+ * is reserved in one step and options longer than 255 bytes are split
+ * into multiple instances as specified by RFC 3396. Running out of
+ * space sets the buffer overflow flag, checked once the message is
+ * complete.
  */
-static inline void
+void
 ni_dhcp4_option_put(ni_buffer_t *bp, int code, const void *data, size_t len)
 {
-	ni_buffer_putc(bp, code);
-	ni_buffer_putc(bp, len);
-	ni_buffer_put(bp, data, len);
+	const unsigned char *ptr = data;
+	unsigned char *opt;
+	size_t chunk;
+
+	do {
+		chunk = len > 255 ? 255 : len;
+		if (!(opt = ni_buffer_push_tail(bp, 2 + chunk)))
+			return;
+
+		opt[0] = code;
+		opt[1] = chunk;
+		if (chunk)
+			memcpy(opt + 2, ptr, chunk);
+		ptr += chunk;
+		len -= chunk;
+	} while (len);
 }
 
 static inline void
@@ -187,7 +207,7 @@ ni_dhcp4_option_puts(ni_buffer_t *bp, int code, const char *string)
 	ni_dhcp4_option_put(bp, code, string, strlen(string));
 }
 
-static inline unsigned int
+unsigned int
 ni_dhcp4_option_begin(ni_buffer_t *bp, int code)
 {
 	ni_buffer_putc(bp, code);
@@ -195,14 +215,45 @@ ni_dhcp4_option_begin(ni_buffer_t *bp, int code)
 	return bp->tail;
 }
 
-static inline void
+void
 ni_dhcp4_option_end(ni_buffer_t *bp, unsigned int pos)
 {
-	if (pos == 0 || pos > bp->size) {
+	unsigned int len, chunks, extra, n;
+	unsigned char code, *src, *dst;
+
+	if (pos < 2 || pos > bp->tail) {
 		ni_error("ni_dhcp4_option_end: bad offset!");
-	} else {
-		bp->base[pos-1] = bp->tail - pos;
+		return;
 	}
+
+	len = bp->tail - pos;
+	if (len <= 255) {
+		bp->base[pos-1] = len;
+		return;
+	}
+
+	/* RFC 3396: split into 255 byte chunks, moving the data up
+	 * to make room for the additional option headers. */
+	code = bp->base[pos-2];
+	chunks = (len + 254) / 255;
+	extra = 2 * (chunks - 1);
+	if (!ni_buffer_push_tail(bp, extra))
+		return;
+
+	src = bp->base + pos + len;
+	dst = bp->base + bp->tail;
+	for (n = chunks; n > 1; --n) {
+		unsigned int chunk = len - (n - 1) * 255;
+
+		if (n < chunks)
+			chunk = 255;
+		src -= chunk;
+		dst -= chunk;
+		memmove(dst, src, chunk);
+		*--dst = chunk;
+		*--dst = code;
+	}
+	bp->base[pos-1] = 255;
 }
 
 static int
@@ -214,11 +265,11 @@ ni_dhcp4_option_next(ni_buffer_t *bp, ni_buffer_t *optbuf)
 		return -1;
 	if (bp->head == bp->tail)
 		return DHCP4_END;
-	if (bp->tail - bp->head < 2)
-		goto underflow;
 
 	code = bp->base[bp->head++];
 	if (code != DHCP4_PAD && code != DHCP4_END) {
+		if (bp->tail == bp->head)
+			goto underflow;
 		count = bp->base[bp->head++];
 		if (bp->tail - bp->head < count)
 			goto underflow;
@@ -1241,6 +1292,12 @@ ni_dhcp4_build_message(const ni_dhcp4_device_t *dev, unsigned int msg_code,
 	ni_buffer_pad(msgbuf, BOOTP_MESSAGE_LENGTH_MIN, DHCP4_PAD);
 #endif
 
+	if (msgbuf->overflow) {
+		ni_error("%s: %s message does not fit into %zu bytes", dev->ifname,
+				ni_dhcp4_message_name(msg_code), msgbuf->size);
+		goto failed;
+	}
+
 	if (!renew && ni_capture_build_udp_header(msgbuf, src_addr,
 			DHCP4_CLIENT_PORT, dst_addr, DHCP4_SERVER_PORT) < 0) {
 		ni_error("%s: unable to build packet header", dev->ifname);
@@ -1802,52 +1859,188 @@ ni_dhcp4_apply_routes(ni_addrconf_lease_t *lease, ni_route_array_t *routes)
 }
 
 /*
- * Parse a DHCP4 response.
+ * Declarative DHCP4 option table.
+ *
+ * The response parser indexes all options of a message in a single
+ * pass as slices of the receive buffer, then walks this table and
+ * decodes each known option straight into its target field.
+ * Options not listed here are kept as raw options in the lease.
  */
-int
-ni_dhcp4_parse_response(const ni_dhcp4_config_t *config, const ni_dhcp4_message_t *message,
-			ni_buffer_t *options, ni_addrconf_lease_t **leasep)
-{
-	ni_buffer_t overload_buf;
-	ni_addrconf_lease_t *lease;
-	ni_route_array_t default_routes = NI_ROUTE_ARRAY_INIT;
-	ni_route_array_t static_routes = NI_ROUTE_ARRAY_INIT;
-	ni_route_array_t classless_routes = NI_ROUTE_ARRAY_INIT;
-	ni_string_array_t dns_servers = NI_STRING_ARRAY_INIT;
-	ni_string_array_t dns_search = NI_STRING_ARRAY_INIT;
-	ni_string_array_t dns_domain = NI_STRING_ARRAY_INIT;
-	ni_string_array_t nis_servers = NI_STRING_ARRAY_INIT;
-	char *nisdomain = NULL;
-	char *tmp = NULL;
-	int opt_overload = 0;
-	int msg_type = -1;
-	int use_bootserver = 1;
-	int use_bootfile = 1;
-	unsigned int pfxlen;
-	ni_dhcp_option_t *opts = NULL, *opt;
+typedef enum {
+	NI_DHCP4_OPTION_TYPE_IPV4,
+	NI_DHCP4_OPTION_TYPE_UINT16,
+	NI_DHCP4_OPTION_TYPE_UINT32,
+	NI_DHCP4_OPTION_TYPE_OPAQUE,
+	NI_DHCP4_OPTION_TYPE_ADDRESS_LIST,
+	NI_DHCP4_OPTION_TYPE_DOMAIN,
+	NI_DHCP4_OPTION_TYPE_DOMAIN_LIST,
+	NI_DHCP4_OPTION_TYPE_DNS_SEARCH,
+	NI_DHCP4_OPTION_TYPE_PATHNAME,
+	NI_DHCP4_OPTION_TYPE_PRINTABLE,
+	NI_DHCP4_OPTION_TYPE_PRINTABLE_LIST,
+	NI_DHCP4_OPTION_TYPE_FQDN,
+	NI_DHCP4_OPTION_TYPE_NETBIOS_TYPE,
+	NI_DHCP4_OPTION_TYPE_SIP_SERVERS,
+	NI_DHCP4_OPTION_TYPE_ROUTERS,
+	NI_DHCP4_OPTION_TYPE_STATIC_ROUTES,
+	NI_DHCP4_OPTION_TYPE_CLASSLESS_ROUTES,
+} ni_dhcp4_option_type_t;
+
+enum {
+	NI_DHCP4_OPTION_REPEAT		= NI_BIT(0),	/* rfc3396 concatenation	*/
+	NI_DHCP4_OPTION_PARSER		= NI_BIT(1),	/* target is in the parser ctx	*/
+};
 
-	lease = ni_addrconf_lease_new(NI_ADDRCONF_DHCP, AF_INET);
+typedef struct ni_dhcp4_option_desc {
+	uint8_t			code;
+	uint8_t			type;
+	uint8_t			flags;
+	uint16_t		min_len;
+	uint16_t		max_len;
+	size_t			offset;
+	const char *		what;
+} ni_dhcp4_option_desc_t;
+
+typedef struct ni_dhcp4_option_parser {
+	ni_addrconf_lease_t *	lease;
+
+	char *			hostname;
+	char *			nisdomain;
+	ni_string_array_t	nis_servers;
+	ni_string_array_t	dns_servers;
+	ni_string_array_t	dns_search;
+	ni_string_array_t	dns_domain;
+	ni_route_array_t	default_routes;
+	ni_route_array_t	static_routes;
+	ni_route_array_t	classless_routes;
+} ni_dhcp4_option_parser_t;
+
+#define NI_DHCP4_OPTION_SLICES_MAX	1024
+
+typedef struct ni_dhcp4_option_slice {
+	unsigned char *		data;
+	unsigned int		len;
+	unsigned int		next;
+} ni_dhcp4_option_slice_t;
+
+typedef struct ni_dhcp4_option_index {
+	unsigned int		count;
+	struct {
+		unsigned int	first;
+		unsigned int	last;
+	}			code[256];
+	ni_dhcp4_option_slice_t	slice[NI_DHCP4_OPTION_SLICES_MAX];
+} ni_dhcp4_option_index_t;
+
+#define __lease(member)		offsetof(ni_addrconf_lease_t, member)
+#define __parser(member)	offsetof(ni_dhcp4_option_parser_t, member)
+
+/* the table order is the order options are applied in */
+static const ni_dhcp4_option_desc_t	ni_dhcp4_option_table[] = {
+	{ DHCP4_ADDRESS,		NI_DHCP4_OPTION_TYPE_IPV4,		0,
+	  4, 4,		__lease(dhcp4.address),		"address"			},
+	{ DHCP4_NETMASK,		NI_DHCP4_OPTION_TYPE_IPV4,		0,
+	  4, 4,		__lease(dhcp4.netmask),		"netmask"			},
+	{ DHCP4_BROADCAST,		NI_DHCP4_OPTION_TYPE_IPV4,		0,
+	  4, 4,		__lease(dhcp4.broadcast),	"broadcast"			},
+	{ DHCP4_SERVERIDENTIFIER,	NI_DHCP4_OPTION_TYPE_IPV4,		0,
+	  4, 4,		__lease(dhcp4.server_id),	"server-id"			},
+	{ DHCP4_CLIENTID,		NI_DHCP4_OPTION_TYPE_OPAQUE,		0,
+	  1, 0,		__lease(dhcp4.client_id),	"client-id"			},
+	{ DHCP4_LEASETIME,		NI_DHCP4_OPTION_TYPE_UINT32,		0,
+	  4, 4,		__lease(dhcp4.lease_time),	"lease-time"			},
+	{ DHCP4_RENEWALTIME,		NI_DHCP4_OPTION_TYPE_UINT32,		0,
+	  4, 4,		__lease(dhcp4.renewal_time),	"renewal-time"			},
+	{ DHCP4_REBINDTIME,		NI_DHCP4_OPTION_TYPE_UINT32,		0,
+	  4, 4,		__lease(dhcp4.rebind_time),	"rebind-time"			},
+	{ DHCP4_MTU,			NI_DHCP4_OPTION_TYPE_UINT16,		0,
+	  2, 2,		__lease(dhcp4.mtu),		"mtu"				},
+	{ DHCP4_FQDN,			NI_DHCP4_OPTION_TYPE_FQDN,		NI_DHCP4_OPTION_REPEAT,
+	  3, 0,		__lease(hostname),		"fqdn"				},
+	{ DHCP4_HOSTNAME,		NI_DHCP4_OPTION_TYPE_DOMAIN,		NI_DHCP4_OPTION_REPEAT|NI_DHCP4_OPTION_PARSER,
+	  1, 0,		__parser(hostname),		"hostname"			},
+	{ DHCP4_DNSDOMAIN,		NI_DHCP4_OPTION_TYPE_DOMAIN_LIST,	NI_DHCP4_OPTION_REPEAT|NI_DHCP4_OPTION_PARSER,
+	  1, 0,		__parser(dns_domain),		"dns-domain"			},
+	{ DHCP4_MESSAGE,		NI_DHCP4_OPTION_TYPE_PRINTABLE,		NI_DHCP4_OPTION_REPEAT,
+	  1, 0,		__lease(dhcp4.message),		"dhcp4-message"			},
+	{ DHCP4_ROOTPATH,		NI_DHCP4_OPTION_TYPE_PATHNAME,		NI_DHCP4_OPTION_REPEAT,
+	  1, 0,		__lease(dhcp4.root_path),	"root-path"			},
+	{ DHCP4_NISDOMAIN,		NI_DHCP4_OPTION_TYPE_DOMAIN,		NI_DHCP4_OPTION_REPEAT|NI_DHCP4_OPTION_PARSER,
+	  1, 0,		__parser(nisdomain),		"nis-domain"			},
+	{ DHCP4_NETBIOSNODETYPE,	NI_DHCP4_OPTION_TYPE_NETBIOS_TYPE,	0,
+	  1, 1,		__lease(netbios_type),		"netbios-node-type"		},
+	{ DHCP4_NETBIOSSCOPE,		NI_DHCP4_OPTION_TYPE_DOMAIN,		NI_DHCP4_OPTION_REPEAT,
+	  1, 0,		__lease(netbios_scope),		"netbios-scope"			},
+	{ DHCP4_DNSSERVER,		NI_DHCP4_OPTION_TYPE_ADDRESS_LIST,	NI_DHCP4_OPTION_REPEAT|NI_DHCP4_OPTION_PARSER,
+	  4, 0,		__parser(dns_servers),		"dns-server"			},
+	{ DHCP4_NTPSERVER,		NI_DHCP4_OPTION_TYPE_ADDRESS_LIST,	NI_DHCP4_OPTION_REPEAT,
+	  4, 0,		__lease(ntp_servers),		"ntp-server"			},
+	{ DHCP4_NISSERVER,		NI_DHCP4_OPTION_TYPE_ADDRESS_LIST,	NI_DHCP4_OPTION_REPEAT|NI_DHCP4_OPTION_PARSER,
+	  4, 0,		__parser(nis_servers),		"nis-server"			},
+	{ DHCP4_LPRSERVER,		NI_DHCP4_OPTION_TYPE_ADDRESS_LIST,	NI_DHCP4_OPTION_REPEAT,
+	  4, 0,		__lease(lpr_servers),		"lpr-server"			},
+	{ DHCP4_LOGSERVER,		NI_DHCP4_OPTION_TYPE_ADDRESS_LIST,	NI_DHCP4_OPTION_REPEAT,
+	  4, 0,		__lease(log_servers),		"log-server"			},
+	{ DHCP4_NETBIOSNAMESERVER,	NI_DHCP4_OPTION_TYPE_ADDRESS_LIST,	NI_DHCP4_OPTION_REPEAT,
+	  4, 0,		__lease(netbios_name_servers),	"netbios-name-server"		},
+	{ DHCP4_NETBIOSDDSERVER,	NI_DHCP4_OPTION_TYPE_ADDRESS_LIST,	NI_DHCP4_OPTION_REPEAT,
+	  4, 0,		__lease(netbios_dd_servers),	"netbios-dd-server"		},
+	{ DHCP4_DNSSEARCH,		NI_DHCP4_OPTION_TYPE_DNS_SEARCH,	NI_DHCP4_OPTION_REPEAT|NI_DHCP4_OPTION_PARSER,
+	  1, 0,		__parser(dns_search),		"dns-search domain"		},
+	{ DHCP4_NDS_SERVER,		NI_DHCP4_OPTION_TYPE_ADDRESS_LIST,	NI_DHCP4_OPTION_REPEAT,
+	  4, 0,		__lease(nds_servers),		"nds-server"			},
+	{ DHCP4_NDS_CTX,		NI_DHCP4_OPTION_TYPE_PRINTABLE_LIST,	NI_DHCP4_OPTION_REPEAT,
+	  1, 0,		__lease(nds_context),		"nds-context"			},
+	{ DHCP4_NDS_TREE,		NI_DHCP4_OPTION_TYPE_PRINTABLE,		NI_DHCP4_OPTION_REPEAT,
+	  1, 0,		__lease(nds_tree),		"nds-tree"			},
+	{ DHCP4_MSCSR,			NI_DHCP4_OPTION_TYPE_CLASSLESS_ROUTES,	NI_DHCP4_OPTION_REPEAT|NI_DHCP4_OPTION_PARSER,
+	  5, 0,		__parser(classless_routes),	"ms-classless-static-routes"	},
+	{ DHCP4_CSR,			NI_DHCP4_OPTION_TYPE_CLASSLESS_ROUTES,	NI_DHCP4_OPTION_REPEAT|NI_DHCP4_OPTION_PARSER,
+	  5, 0,		__parser(classless_routes),	"classless-static-routes"	},
+	{ DHCP4_SIPSERVER,		NI_DHCP4_OPTION_TYPE_SIP_SERVERS,	NI_DHCP4_OPTION_REPEAT,
+	  2, 0,		__lease(sip_servers),		"sip-server"			},
+	{ DHCP4_STATICROUTE,		NI_DHCP4_OPTION_TYPE_STATIC_ROUTES,	NI_DHCP4_OPTION_REPEAT|NI_DHCP4_OPTION_PARSER,
+	  8, 0,		__parser(static_routes),	"static-routes"			},
+	{ DHCP4_ROUTERS,		NI_DHCP4_OPTION_TYPE_ROUTERS,		NI_DHCP4_OPTION_REPEAT|NI_DHCP4_OPTION_PARSER,
+	  4, 0,		__parser(default_routes),	"routers"			},
+	{ DHCP4_POSIX_TZ_STRING,	NI_DHCP4_OPTION_TYPE_PRINTABLE,		NI_DHCP4_OPTION_REPEAT,
+	  1, 0,		__lease(posix_tz_string),	"posix-tz-string"		},
+	{ DHCP4_POSIX_TZ_DBNAME,	NI_DHCP4_OPTION_TYPE_PRINTABLE,		NI_DHCP4_OPTION_REPEAT,
+	  1, 0,		__lease(posix_tz_dbname),	"posix-tz-dbname"		},
+};
 
-	lease->state = NI_ADDRCONF_STATE_GRANTED;
-	lease->type = NI_ADDRCONF_DHCP;
-	lease->family = AF_INET;
-	ni_timer_get_time(&lease->acquired);
-	lease->fqdn.enabled = NI_TRISTATE_DEFAULT;
-	lease->fqdn.qualify = config->fqdn.qualify;
+#undef __lease
+#undef __parser
 
-	lease->dhcp4.address.s_addr = message->yiaddr;
-	lease->dhcp4.boot_saddr.s_addr = message->siaddr;
-	lease->dhcp4.relay_addr.s_addr = message->giaddr;
+static const ni_dhcp4_option_desc_t *
+ni_dhcp4_option_desc_find(unsigned int code)
+{
+	static const ni_dhcp4_option_desc_t *index[256];
+	static ni_bool_t initialized = FALSE;
+	unsigned int i;
 
-parse_more:
-	/* Loop as long as we still have data in the buffer. */
-	while (ni_buffer_count(options) && !options->underflow) {
-		ni_buffer_t buf;
-		int option;
+	if (!initialized) {
+		for (i = 0; i < sizeof(ni_dhcp4_option_table)/sizeof(ni_dhcp4_option_table[0]); ++i)
+			index[ni_dhcp4_option_table[i].code] = &ni_dhcp4_option_table[i];
+		initialized = TRUE;
+	}
+	return code < 256 ? index[code] : NULL;
+}
 
-		option = ni_dhcp4_option_next(options, &buf);
+/*
+ * Index all options in a buffer as slices, without copying them.
+ * Returns the message type or -1 when none has been seen yet.
+ */
+static int
+ni_dhcp4_option_index_scan(ni_dhcp4_option_index_t *index, ni_buffer_t *options,
+				ni_bool_t overloaded, int *opt_overload, int msg_type)
+{
+	ni_dhcp4_option_slice_t *slice;
+	ni_buffer_t buf;
+	int option;
 
-		//ni_debug_dhcp("handle option %s (%d)", ni_dhcp4_option_name(option), option);
+	while (ni_buffer_count(options) && !options->underflow) {
+		option = ni_dhcp4_option_next(options, &buf);
 		if (option == DHCP4_END || option < 0)
 			break;
 
@@ -1858,16 +2051,16 @@ parse_more:
 		case DHCP4_MESSAGETYPE:
 			option = ni_buffer_getc(&buf);
 			if (option == EOF || msg_type != -1)
-				goto error;
+				return -2;
 			msg_type = option;
 			continue;
 
 		case DHCP4_OPTIONSOVERLOADED:
-			if (options != &overload_buf) {
-				opt_overload = ni_buffer_getc(&buf);
-				if (opt_overload == EOF) {
+			if (!overloaded) {
+				*opt_overload = ni_buffer_getc(&buf);
+				if (*opt_overload == EOF) {
 					ni_debug_dhcp("DHCP4: ignoring invalid OVERLOAD option");
-					opt_overload = 0;
+					*opt_overload = 0;
 				}
 			} else if (ni_buffer_getc(&buf) == EOF) {
 				ni_debug_dhcp("DHCP4: ignoring invalid OVERLOAD option in overloaded data");
@@ -1885,229 +2078,287 @@ parse_more:
 			continue;
 		}
 
-		if ((opt = ni_dhcp_option_list_find(opts, option))) {
-			if (ni_dhcp_option_append(opt, ni_buffer_count(&buf), ni_buffer_head(&buf)))
-				ni_buffer_pull_head(&buf, ni_buffer_count(&buf));
-		} else
-		if ((opt = ni_dhcp_option_new(option, ni_buffer_count(&buf), ni_buffer_head(&buf)))) {
-			if (ni_dhcp_option_list_append(&opts, opt))
-				ni_buffer_pull_head(&buf, ni_buffer_count(&buf));
-			else
-				ni_dhcp_option_free(opt);
-		} else {
-			ni_debug_dhcp("unable to allocate DHCP4 option %s", ni_dhcp4_option_name(option));
-			continue;
+		if (index->count >= NI_DHCP4_OPTION_SLICES_MAX) {
+			ni_debug_dhcp("DHCP4: too many options in message");
+			return -2;
 		}
 
-		if (buf.underflow) {
-			ni_debug_dhcp("unable to parse DHCP4 option %s: too short",
-					ni_dhcp4_option_name(option));
-		} else if (ni_buffer_count(&buf)) {
-			ni_debug_dhcp("excess data in DHCP4 option %s - %u bytes left",
-					ni_dhcp4_option_name(option),
-					ni_buffer_count(&buf));
+		slice = &index->slice[index->count++];
+		slice->data = ni_buffer_head(&buf);
+		slice->len = ni_buffer_count(&buf);
+		slice->next = 0;
+
+		if (index->code[option].last)
+			index->slice[index->code[option].last - 1].next = index->count;
+		else
+			index->code[option].first = index->count;
+		index->code[option].last = index->count;
+	}
+	return msg_type;
+}
+
+/*
+ * Provide a reader on the option data. A single slice is used in
+ * place; rfc3396 split options are concatenated into the scratch.
+ */
+static unsigned int
+ni_dhcp4_option_index_get(const ni_dhcp4_option_index_t *index, unsigned int code,
+				ni_bool_t concat, ni_buffer_t *buf, ni_buffer_t *scratch)
+{
+	const ni_dhcp4_option_slice_t *slice;
+	unsigned int n;
+
+	if (!(n = index->code[code].first))
+		return 0;
+
+	slice = &index->slice[n - 1];
+	if (!slice->next || !concat) {
+		if (slice->next) {
+			ni_debug_dhcp("ignoring repeated DHCP4 option %s",
+					ni_dhcp4_option_name(code));
 		}
+		ni_buffer_init_reader(buf, slice->data, slice->len);
+		return slice->len;
 	}
 
-	// We should have a msg_type by now
-	if (msg_type < 0) {
-		ni_debug_dhcp("unable to parse DHCP4 response: missing msg type");
-		goto error;
+	ni_buffer_clear(scratch);
+	for (; n; n = slice->next) {
+		slice = &index->slice[n - 1];
+		ni_buffer_ensure_tailroom(scratch, slice->len);
+		ni_buffer_put(scratch, slice->data, slice->len);
 	}
+	ni_buffer_init_reader(buf, ni_buffer_head(scratch), ni_buffer_count(scratch));
+	return ni_buffer_count(scratch);
+}
 
-	if (options->underflow) {
-		ni_debug_dhcp("unable to parse DHCP4 response: truncated packet");
-		goto error;
+static int
+ni_dhcp4_option_decode(const ni_dhcp4_option_desc_t *desc, ni_buffer_t *buf,
+				ni_dhcp4_option_parser_t *parser)
+{
+	ni_addrconf_lease_t *lease = parser->lease;
+	unsigned int len = ni_buffer_count(buf);
+	char *tmp = NULL;
+	void *target;
+
+	if (len < desc->min_len || (desc->max_len && len > desc->max_len)) {
+		ni_debug_dhcp("unable to parse DHCP4 option %s (%u): invalid length %u",
+				ni_dhcp4_option_name(desc->code), desc->code, len);
+		return -1;
 	}
 
-	while ((opt = ni_dhcp_option_list_pull(&opts))) {
-		ni_buffer_t buf;
-		int option = opt->code;
+	if (desc->flags & NI_DHCP4_OPTION_PARSER)
+		target = (unsigned char *)parser + desc->offset;
+	else
+		target = (unsigned char *)lease + desc->offset;
 
-		ni_buffer_init_reader(&buf, opt->data, opt->len);
-		switch (option) {
-		case DHCP4_ADDRESS:
-			ni_dhcp4_option_get_ipv4(&buf, &lease->dhcp4.address);
-			break;
-		case DHCP4_NETMASK:
-			ni_dhcp4_option_get_ipv4(&buf, &lease->dhcp4.netmask);
-			break;
-		case DHCP4_BROADCAST:
-			ni_dhcp4_option_get_ipv4(&buf, &lease->dhcp4.broadcast);
-			break;
-		case DHCP4_SERVERIDENTIFIER:
-			ni_dhcp4_option_get_ipv4(&buf, &lease->dhcp4.server_id);
-			break;
-		case DHCP4_CLIENTID:
-			ni_dhcp4_option_get_opaque(&buf, &lease->dhcp4.client_id);
-			break;
-		case DHCP4_LEASETIME:
-			ni_dhcp4_option_get32(&buf, &lease->dhcp4.lease_time);
-			break;
-		case DHCP4_RENEWALTIME:
-			ni_dhcp4_option_get32(&buf, &lease->dhcp4.renewal_time);
-			break;
-		case DHCP4_REBINDTIME:
-			ni_dhcp4_option_get32(&buf, &lease->dhcp4.rebind_time);
-			break;
-		case DHCP4_MTU:
-			ni_dhcp4_option_get16(&buf, &lease->dhcp4.mtu);
-			/* Minimum legal mtu is 68 accoridng to
-			 * RFC 2132. In practise it's 576 which is the
-			 * minimum maximum message size. */
-			if (lease->dhcp4.mtu <= MTU_MIN) {
-				ni_debug_dhcp("MTU %u is too low, minimum is %d; ignoring",
-						lease->dhcp4.mtu, MTU_MIN);
-				lease->dhcp4.mtu = 0;
-			}
-			break;
-		case DHCP4_FQDN:
-			ni_dhcp4_option_get_fqdn(&buf, &lease->hostname, &lease->fqdn);
-			break;
-		case DHCP4_HOSTNAME:
-			if (lease->fqdn.enabled != NI_TRISTATE_ENABLE) {
-				ni_dhcp4_option_get_domain(&buf, &lease->hostname,
-								"hostname");
-			}
-			break;
-		case DHCP4_DNSDOMAIN:
-			ni_dhcp4_option_get_domain_list(&buf, &dns_domain,
-							"dns-domain");
-			break;
-		case DHCP4_MESSAGE:
-			ni_dhcp4_option_get_printable(&buf, &lease->dhcp4.message,
-							"dhcp4-message");
-			break;
-		case DHCP4_ROOTPATH:
-			ni_dhcp4_option_get_pathname(&buf, &lease->dhcp4.root_path,
-							"root-path");
-			break;
-		case DHCP4_NISDOMAIN:
-			ni_dhcp4_option_get_domain(&buf, &nisdomain,
-							"nis-domain");
-			break;
-		case DHCP4_NETBIOSNODETYPE:
-			ni_dhcp4_option_get_netbios_type(&buf, &lease->netbios_type);
-			break;
-		case DHCP4_NETBIOSSCOPE:
-			ni_dhcp4_option_get_domain(&buf, &lease->netbios_scope,
-							"netbios-scope");
-			break;
-		case DHCP4_DNSSERVER:
-			ni_dhcp4_decode_address_list(&buf, &dns_servers);
-			break;
-		case DHCP4_NTPSERVER:
-			ni_dhcp4_decode_address_list(&buf, &lease->ntp_servers);
-			break;
-		case DHCP4_NISSERVER:
-			ni_dhcp4_decode_address_list(&buf, &nis_servers);
-			break;
-		case DHCP4_LPRSERVER:
-			ni_dhcp4_decode_address_list(&buf, &lease->lpr_servers);
-			break;
-		case DHCP4_LOGSERVER:
-			ni_dhcp4_decode_address_list(&buf, &lease->log_servers);
-			break;
-		case DHCP4_NETBIOSNAMESERVER:
-			ni_dhcp4_decode_address_list(&buf, &lease->netbios_name_servers);
-			break;
-		case DHCP4_NETBIOSDDSERVER:
-			ni_dhcp4_decode_address_list(&buf, &lease->netbios_dd_servers);
-			break;
-		case DHCP4_DNSSEARCH:
-			ni_dhcp4_decode_dnssearch(&buf, &dns_search, "dns-search domain");
-			break;
+	switch (desc->type) {
+	case NI_DHCP4_OPTION_TYPE_IPV4:
+		return ni_dhcp4_option_get_ipv4(buf, target);
 
-		case DHCP4_NDS_SERVER:
-			ni_dhcp4_decode_address_list(&buf, &lease->nds_servers);
-			break;
-		case DHCP4_NDS_CTX:
-			if (!ni_dhcp4_option_get_printable(&buf, &tmp, "nds-context"))
-				ni_string_array_append(&lease->nds_context, tmp);
-			ni_string_free(&tmp);
-			break;
-		case DHCP4_NDS_TREE:
-			ni_dhcp4_option_get_printable(&buf, &lease->nds_tree,
-							"nds-tree");
-			break;
+	case NI_DHCP4_OPTION_TYPE_UINT16:
+		return ni_dhcp4_option_get16(buf, target);
 
-		case DHCP4_CSR:
-		case DHCP4_MSCSR:
-			ni_route_array_destroy(&classless_routes);
-			ni_dhcp4_decode_csr(&buf, &classless_routes);
-			break;
+	case NI_DHCP4_OPTION_TYPE_UINT32:
+		return ni_dhcp4_option_get32(buf, target);
 
-		case DHCP4_SIPSERVER:
-			ni_dhcp4_decode_sipservers(&buf, &lease->sip_servers);
-			break;
+	case NI_DHCP4_OPTION_TYPE_OPAQUE:
+		return ni_dhcp4_option_get_opaque(buf, target);
 
-		case DHCP4_STATICROUTE:
-			ni_route_array_destroy(&static_routes);
-			ni_dhcp4_decode_static_routes(&buf, &static_routes);
-			break;
+	case NI_DHCP4_OPTION_TYPE_ADDRESS_LIST:
+		return ni_dhcp4_decode_address_list(buf, target);
 
-		case DHCP4_ROUTERS:
-			ni_route_array_destroy(&default_routes);
-			ni_dhcp4_decode_routers(&buf, &default_routes);
-			break;
+	case NI_DHCP4_OPTION_TYPE_DOMAIN:
+		return ni_dhcp4_option_get_domain(buf, target, desc->what);
 
-		case DHCP4_POSIX_TZ_STRING:
-			ni_dhcp4_option_get_printable(&buf, &lease->posix_tz_string,
-							"posix-tz-string");
-			break;
+	case NI_DHCP4_OPTION_TYPE_DOMAIN_LIST:
+		return ni_dhcp4_option_get_domain_list(buf, target, desc->what);
 
-		case DHCP4_POSIX_TZ_DBNAME:
-			ni_dhcp4_option_get_printable(&buf, &lease->posix_tz_dbname,
-							"posix-tz-dbname");
-			break;
+	case NI_DHCP4_OPTION_TYPE_DNS_SEARCH:
+		return ni_dhcp4_decode_dnssearch(buf, target, desc->what);
 
-		default:
-			ni_debug_dhcp("adding unparsed DHCP4 option %s code %u len %u",
-					ni_dhcp4_option_name(option), option, opt->len);
+	case NI_DHCP4_OPTION_TYPE_PATHNAME:
+		return ni_dhcp4_option_get_pathname(buf, target, desc->what);
 
-			if (ni_dhcp_option_list_append(&lease->dhcp4.options, opt)) {
-				ni_buffer_clear(&buf);
-				opt = NULL;
-			}
-			break;
-		}
+	case NI_DHCP4_OPTION_TYPE_PRINTABLE:
+		return ni_dhcp4_option_get_printable(buf, target, desc->what);
+
+	case NI_DHCP4_OPTION_TYPE_PRINTABLE_LIST:
+		if (ni_dhcp4_option_get_printable(buf, &tmp, desc->what) < 0)
+			return -1;
+		ni_string_array_append(target, tmp);
+		ni_string_free(&tmp);
+		return 0;
+
+	case NI_DHCP4_OPTION_TYPE_FQDN:
+		return ni_dhcp4_option_get_fqdn(buf, target, &lease->fqdn);
+
+	case NI_DHCP4_OPTION_TYPE_NETBIOS_TYPE:
+		return ni_dhcp4_option_get_netbios_type(buf, target);
+
+	case NI_DHCP4_OPTION_TYPE_SIP_SERVERS:
+		return ni_dhcp4_decode_sipservers(buf, target);
+
+	case NI_DHCP4_OPTION_TYPE_ROUTERS:
+		ni_route_array_destroy(target);
+		return ni_dhcp4_decode_routers(buf, target);
+
+	case NI_DHCP4_OPTION_TYPE_STATIC_ROUTES:
+		ni_route_array_destroy(target);
+		return ni_dhcp4_decode_static_routes(buf, target);
+
+	case NI_DHCP4_OPTION_TYPE_CLASSLESS_ROUTES:
+		ni_route_array_destroy(target);
+		return ni_dhcp4_decode_csr(buf, target);
+
+	default:
+		return -1;
+	}
+}
+
+static void
+ni_dhcp4_option_parser_destroy(ni_dhcp4_option_parser_t *parser)
+{
+	ni_string_free(&parser->hostname);
+	ni_string_free(&parser->nisdomain);
+	ni_string_array_destroy(&parser->nis_servers);
+	ni_string_array_destroy(&parser->dns_servers);
+	ni_string_array_destroy(&parser->dns_search);
+	ni_string_array_destroy(&parser->dns_domain);
+	ni_route_array_destroy(&parser->default_routes);
+	ni_route_array_destroy(&parser->static_routes);
+	ni_route_array_destroy(&parser->classless_routes);
+}
+
+/*
+ * Parse a DHCP4 response.
+ */
+int
+ni_dhcp4_parse_response(const ni_dhcp4_config_t *config, const ni_dhcp4_message_t *message,
+			ni_buffer_t *options, ni_addrconf_lease_t **leasep)
+{
+	const ni_dhcp4_option_desc_t *desc;
+	ni_dhcp4_option_parser_t parser;
+	ni_dhcp4_option_index_t *index;
+	ni_buffer_t overload_buf;
+	ni_buffer_t scratch;
+	ni_addrconf_lease_t *lease;
+	int opt_overload = 0;
+	int msg_type = -1;
+	int use_bootserver = 1;
+	int use_bootfile = 1;
+	unsigned int pfxlen;
+	unsigned int code, i;
+
+	index = xcalloc(1, sizeof(*index));
+	memset(&parser, 0, sizeof(parser));
+	ni_buffer_init(&scratch, NULL, 0);
+
+	lease = ni_addrconf_lease_new(NI_ADDRCONF_DHCP, AF_INET);
+	parser.lease = lease;
+
+	lease->state = NI_ADDRCONF_STATE_GRANTED;
+	lease->type = NI_ADDRCONF_DHCP;
+	lease->family = AF_INET;
+	ni_timer_get_time(&lease->acquired);
+	lease->fqdn.enabled = NI_TRISTATE_DEFAULT;
+	lease->fqdn.qualify = config->fqdn.qualify;
+
+	lease->dhcp4.address.s_addr = message->yiaddr;
+	lease->dhcp4.boot_saddr.s_addr = message->siaddr;
+	lease->dhcp4.relay_addr.s_addr = message->giaddr;
+
+	/* Index the options field, then the rfc2131 overloaded
+	 * file and sname fields in rfc3396 concatenation order. */
+	msg_type = ni_dhcp4_option_index_scan(index, options, FALSE, &opt_overload, msg_type);
+	if (msg_type < -1)
+		goto error;
+
+	if (options->underflow) {
+		ni_debug_dhcp("unable to parse DHCP4 response: truncated packet");
+		goto error;
+	}
+
+	if (opt_overload & DHCP4_OVERLOAD_BOOTFILE) {
+		use_bootfile = 0;
+		ni_buffer_init_reader(&overload_buf, (void *)message->bootfile,
+					sizeof(message->bootfile));
+		msg_type = ni_dhcp4_option_index_scan(index, &overload_buf, TRUE,
+					&opt_overload, msg_type);
+		if (msg_type < -1 || overload_buf.underflow)
+			goto error;
+	}
+	if (opt_overload & DHCP4_OVERLOAD_SERVERNAME) {
+		use_bootserver = 0;
+		ni_buffer_init_reader(&overload_buf, (void *)message->servername,
+					sizeof(message->servername));
+		msg_type = ni_dhcp4_option_index_scan(index, &overload_buf, TRUE,
+					&opt_overload, msg_type);
+		if (msg_type < -1 || overload_buf.underflow)
+			goto error;
+	}
+
+	// We should have a msg_type by now
+	if (msg_type < 0) {
+		ni_debug_dhcp("unable to parse DHCP4 response: missing msg type");
+		goto error;
+	}
 
-		ni_dhcp_option_free(opt);
+	/* Decode the known options in table order */
+	for (i = 0; i < sizeof(ni_dhcp4_option_table)/sizeof(ni_dhcp4_option_table[0]); ++i) {
+		ni_buffer_t buf;
+
+		desc = &ni_dhcp4_option_table[i];
+		if (!ni_dhcp4_option_index_get(index, desc->code,
+				desc->flags & NI_DHCP4_OPTION_REPEAT, &buf, &scratch))
+			continue;
+
+		ni_dhcp4_option_decode(desc, &buf, &parser);
 		if (buf.underflow) {
 			ni_debug_dhcp("unable to parse DHCP4 option %s (%u): too short",
-					ni_dhcp4_option_name(option), option);
+					ni_dhcp4_option_name(desc->code), desc->code);
 		} else if (ni_buffer_count(&buf)) {
 			ni_debug_dhcp("excess data in DHCP4 option %s (%u): %u data bytes left",
-					ni_dhcp4_option_name(option), option,
+					ni_dhcp4_option_name(desc->code), desc->code,
 					ni_buffer_count(&buf));
 		}
 	}
 
-	if (opt_overload) {
-		const void *more_data = NULL;
-		size_t size = 0;
+	/* Keep all other options as raw data in the lease */
+	for (code = DHCP4_PAD + 1; code < DHCP4_END; ++code) {
+		ni_dhcp_option_t *opt;
+		ni_buffer_t buf;
 
-		if (opt_overload & DHCP4_OVERLOAD_BOOTFILE) {
-			use_bootfile = 0;
-			more_data = message->bootfile;
-			size = sizeof(message->bootfile);
-			opt_overload &= ~DHCP4_OVERLOAD_BOOTFILE;
-		} else
-		if (opt_overload & DHCP4_OVERLOAD_SERVERNAME) {
-			use_bootserver = 0;
-			more_data = message->servername;
-			size = sizeof(message->servername);
-			opt_overload &= ~DHCP4_OVERLOAD_SERVERNAME;
-		} else {
-			opt_overload = 0;
-		}
-		if (more_data) {
-			ni_buffer_init_reader(&overload_buf, (void *) more_data, size);
-			options = &overload_buf;
-			goto parse_more;
+		if (ni_dhcp4_option_desc_find(code))
+			continue;
+		if (!ni_dhcp4_option_index_get(index, code, TRUE, &buf, &scratch))
+			continue;
+
+		ni_debug_dhcp("adding unparsed DHCP4 option %s code %u len %u",
+				ni_dhcp4_option_name(code), code, ni_buffer_count(&buf));
+
+		opt = ni_dhcp_option_new(code, ni_buffer_count(&buf), ni_buffer_head(&buf));
+		if (!opt || !ni_dhcp_option_list_append(&lease->dhcp4.options, opt)) {
+			ni_debug_dhcp("unable to allocate DHCP4 option %s", ni_dhcp4_option_name(code));
+			ni_dhcp_option_free(opt);
 		}
 	}
 
+	/* Minimum legal mtu is 68 accoridng to
+	 * RFC 2132. In practise it's 576 which is the
+	 * minimum maximum message size. */
+	if (lease->dhcp4.mtu && lease->dhcp4.mtu <= MTU_MIN) {
+		ni_debug_dhcp("MTU %u is too low, minimum is %d; ignoring",
+				lease->dhcp4.mtu, MTU_MIN);
+		lease->dhcp4.mtu = 0;
+	}
+
+	/* The fqdn option has precedence over the hostname option */
+	if (parser.hostname && lease->fqdn.enabled != NI_TRISTATE_ENABLE) {
+		ni_string_free(&lease->hostname);
+		lease->hostname = parser.hostname;
+		parser.hostname = NULL;
+	}
+
 	if (use_bootserver && message->servername[0]) {
 		char tmp[sizeof(message->servername)];
 		size_t len;
@@ -2165,41 +2416,38 @@ parse_more:
 			ni_sockaddr_set_ipv4(&ap->bcast_addr, lease->dhcp4.broadcast, 0);
 	}
 
-	if (classless_routes.count) {
+	if (parser.classless_routes.count) {
 		/* if CSR or MSCSR are available, ignore other routes */
-		ni_dhcp4_apply_routes(lease, &classless_routes);
-		ni_route_array_destroy(&classless_routes);
+		ni_dhcp4_apply_routes(lease, &parser.classless_routes);
 	} else {
-		ni_dhcp4_apply_routes(lease, &static_routes);
-		ni_route_array_destroy(&static_routes);
-		ni_dhcp4_apply_routes(lease, &default_routes);
-		ni_route_array_destroy(&default_routes);
+		ni_dhcp4_apply_routes(lease, &parser.static_routes);
+		ni_dhcp4_apply_routes(lease, &parser.default_routes);
 	}
 
-	if (dns_servers.count || dns_search.count || dns_domain.count) {
+	if (parser.dns_servers.count || parser.dns_search.count || parser.dns_domain.count) {
 		ni_resolver_info_t *resolver = ni_resolver_info_new();
 
-		if (dns_domain.count)
-			ni_string_dup(&resolver->default_domain, dns_domain.data[0]);
+		if (parser.dns_domain.count)
+			ni_string_dup(&resolver->default_domain, parser.dns_domain.data[0]);
 
-		if (dns_search.count)
-			ni_string_array_move(&resolver->dns_search, &dns_search);
+		if (parser.dns_search.count)
+			ni_string_array_move(&resolver->dns_search, &parser.dns_search);
 		else
-			ni_string_array_move(&resolver->dns_search, &dns_domain);
+			ni_string_array_move(&resolver->dns_search, &parser.dns_domain);
 
-		ni_string_array_move(&resolver->dns_servers, &dns_servers);
+		ni_string_array_move(&resolver->dns_servers, &parser.dns_servers);
 		lease->resolver = resolver;
 	}
-	if (nisdomain != NULL) {
+	if (parser.nisdomain != NULL) {
 		ni_nis_info_t *nis = ni_nis_info_new();
 
-		nis->domainname = nisdomain;
-		nisdomain = NULL;
+		nis->domainname = parser.nisdomain;
+		parser.nisdomain = NULL;
 
-		if (nis_servers.count == 0)
+		if (parser.nis_servers.count == 0)
 			nis->default_binding = NI_NISCONF_BROADCAST;
 		else
-			ni_string_array_move(&nis->default_servers, &nis_servers);
+			ni_string_array_move(&nis->default_servers, &parser.nis_servers);
 		lease->nis = nis;
 	}
 
@@ -2207,15 +2455,9 @@ parse_more:
 	lease = NULL;
 
 done:
-	ni_route_array_destroy(&default_routes);
-	ni_route_array_destroy(&static_routes);
-	ni_route_array_destroy(&classless_routes);
-	ni_string_array_destroy(&dns_servers);
-	ni_string_array_destroy(&dns_search);
-	ni_string_array_destroy(&dns_domain);
-	ni_string_array_destroy(&nis_servers);
-	ni_string_free(&nisdomain);
-	ni_dhcp_option_list_destroy(&opts);
+	ni_dhcp4_option_parser_destroy(&parser);
+	ni_buffer_destroy(&scratch);
+	free(index);
 
 	return msg_type;
 
@@ -188,4 +188,8 @@ struct ni_dhcp4_message {
 extern const char *	ni_dhcp4_message_name(unsigned int);
 extern const char *	ni_dhcp4_option_name(unsigned int);
 
+extern void		ni_dhcp4_option_put(ni_buffer_t *, int, const void *, size_t);
+extern unsigned int	ni_dhcp4_option_begin(ni_buffer_t *, int);
+extern void		ni_dhcp4_option_end(ni_buffer_t *, unsigned int);
+
 #endif /* __WICKED_DHCP4_PROTOCOL_H__ */
@@ -1244,7 +1244,7 @@ ni_dhcp6_release(ni_dhcp6_device_t *dev, const ni_uuid_t *req_uuid)
 
 	ni_dhcp6_device_start_timer_cancel(dev);
 	ni_dhcp6_fsm_reset(dev);
-	dev->fsm.state = NI_DHCP6_STATE_RELEASING;
+	ni_dhcp6_fsm_set_state(dev, NI_DHCP6_STATE_RELEASING);
 	dev->fsm.timer = ni_timer_register(0, ni_dhcp6_start_release, dev);
 	return 1;
 }
@@ -1391,7 +1391,7 @@ ni_dhcp6_device_transmit(ni_dhcp6_device_t *dev)
 		return rv;
 	}
 
-	rv = ni_dhcp6_socket_send(dev->mcast.sock, &dev->message, &dev->mcast.dest);
+	rv = ni_dhcp6_socket_send(dev, &dev->message, &dev->mcast.dest);
 	if (rv <= 0 || (size_t)rv != cnt) {
 		/* Hmm... advance retrans.count here? Use stop? */
 
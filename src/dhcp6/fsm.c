@@ -29,6 +29,7 @@
 
 #include <wicked/logging.h>
 #include <wicked/resolver.h>
+#include <wicked/metrics.h>
 
 #include "dhcp6/dhcp6.h"
 #include "dhcp6/device.h"
@@ -362,7 +363,7 @@ ni_dhcp6_fsm_start(ni_dhcp6_device_t *dev)
 void
 ni_dhcp6_fsm_reset(ni_dhcp6_device_t *dev)
 {
-	dev->fsm.state = NI_DHCP6_STATE_INIT;
+	ni_dhcp6_fsm_set_state(dev, NI_DHCP6_STATE_INIT);
 
 	ni_dhcp6_fsm_timer_cancel(dev);
 	ni_dhcp6_device_retransmit_disarm(dev);
@@ -1800,7 +1801,7 @@ ni_dhcp6_fsm_solicit(ni_dhcp6_device_t *dev)
 			dev->retrans.duration = deadline * 1000;
 		}
 
-		dev->fsm.state = NI_DHCP6_STATE_SELECTING;
+		ni_dhcp6_fsm_set_state(dev, NI_DHCP6_STATE_SELECTING);
 		rv = ni_dhcp6_device_transmit_init(dev);
 	} else {
 		if (dev->best_offer.lease && dev->best_offer.weight > 0) {
@@ -1856,7 +1857,7 @@ ni_dhcp6_fsm_request_lease(ni_dhcp6_device_t *dev, const ni_addrconf_lease_t *le
 		if (ni_dhcp6_init_message(dev, NI_DHCP6_REQUEST, lease) != 0)
 			return -1;
 
-		dev->fsm.state = NI_DHCP6_STATE_REQUESTING;
+		ni_dhcp6_fsm_set_state(dev, NI_DHCP6_STATE_REQUESTING);
 		rv = ni_dhcp6_device_transmit_init(dev);
 	} else {
 		ni_debug_dhcp("%s: Retransmitting DHCPv6 Lease Request",
@@ -1884,7 +1885,7 @@ ni_dhcp6_fsm_request_info(ni_dhcp6_device_t *dev)
 		if (ni_dhcp6_init_message(dev, NI_DHCP6_INFO_REQUEST, NULL) != 0)
 			return -1;
 
-		dev->fsm.state = NI_DHCP6_STATE_REQUESTING_INFO;
+		ni_dhcp6_fsm_set_state(dev, NI_DHCP6_STATE_REQUESTING_INFO);
 
 		rv = ni_dhcp6_device_transmit_init(dev);
 	} else
@@ -1935,7 +1936,7 @@ ni_dhcp6_fsm_confirm_prefix(ni_dhcp6_device_t *dev, const ni_addrconf_lease_t *l
 
 		dev->dhcp6.xid = 0;
 		/* init rebind message, but with confirm timings */
-		dev->fsm.state = NI_DHCP6_STATE_CONFIRMING;
+		ni_dhcp6_fsm_set_state(dev, NI_DHCP6_STATE_CONFIRMING);
 		if (ni_dhcp6_init_message(dev, NI_DHCP6_REBIND, lease) != 0)
 			return -1;
 
@@ -1944,7 +1945,7 @@ ni_dhcp6_fsm_confirm_prefix(ni_dhcp6_device_t *dev, const ni_addrconf_lease_t *l
 		    (deadline * 1000) < dev->retrans.duration)
 			dev->retrans.duration = deadline * 1000;
 
-		dev->fsm.state = NI_DHCP6_STATE_REBINDING;
+		ni_dhcp6_fsm_set_state(dev, NI_DHCP6_STATE_REBINDING);
 		rv = ni_dhcp6_device_transmit_init(dev);
 	}
 	return rv;
@@ -1966,7 +1967,7 @@ ni_dhcp6_fsm_confirm_address(ni_dhcp6_device_t *dev, const ni_addrconf_lease_t *
 		if (ni_dhcp6_init_message(dev, NI_DHCP6_CONFIRM, lease) != 0)
 			return -1;
 
-		dev->fsm.state = NI_DHCP6_STATE_CONFIRMING;
+		ni_dhcp6_fsm_set_state(dev, NI_DHCP6_STATE_CONFIRMING);
 		rv = ni_dhcp6_device_transmit_init(dev);
 	} else if (dev->fsm.state == NI_DHCP6_STATE_CONFIRMING) {
 
@@ -2033,7 +2034,7 @@ ni_dhcp6_fsm_renew(ni_dhcp6_device_t *dev)
 			return -1;
 
 		dev->retrans.duration = deadline * 1000;
-		dev->fsm.state = NI_DHCP6_STATE_RENEWING;
+		ni_dhcp6_fsm_set_state(dev, NI_DHCP6_STATE_RENEWING);
 
 		rv = ni_dhcp6_device_transmit_init(dev);
 	} else {
@@ -2087,7 +2088,7 @@ ni_dhcp6_fsm_rebind(ni_dhcp6_device_t *dev)
 		if (ni_dhcp6_init_message(dev, NI_DHCP6_REBIND, dev->lease) != 0)
 			return -1;
 
-		dev->fsm.state = NI_DHCP6_STATE_REBINDING;
+		ni_dhcp6_fsm_set_state(dev, NI_DHCP6_STATE_REBINDING);
 		dev->retrans.duration = deadline * 1000;
 		rv = ni_dhcp6_device_transmit_init(dev);
 	} else {
@@ -2168,7 +2169,7 @@ ni_dhcp6_fsm_decline(ni_dhcp6_device_t *dev)
 		if (ni_dhcp6_init_message(dev, NI_DHCP6_DECLINE, dev->lease) != 0)
 			return -1;
 
-		dev->fsm.state = NI_DHCP6_STATE_DECLINING;
+		ni_dhcp6_fsm_set_state(dev, NI_DHCP6_STATE_DECLINING);
 		rv = ni_dhcp6_device_transmit_init(dev);
 	} else {
 		if (!ni_dhcp6_fsm_decline_info(dev, dev->lease->dhcp6.ia_list,
@@ -2202,7 +2203,7 @@ __ni_dhcp6_fsm_release(ni_dhcp6_device_t *dev, unsigned int nretries)
 		if (ni_dhcp6_init_message(dev, NI_DHCP6_RELEASE, dev->lease) != 0)
 			return -1;
 
-		dev->fsm.state = NI_DHCP6_STATE_RELEASING;
+		ni_dhcp6_fsm_set_state(dev, NI_DHCP6_STATE_RELEASING);
 		if (nretries < (unsigned int)dev->retrans.params.nretries)
 			dev->retrans.params.nretries = nretries;
 		rv = ni_dhcp6_device_transmit_init(dev);
@@ -2317,10 +2318,10 @@ ni_dhcp6_fsm_commit_lease(ni_dhcp6_device_t *dev, ni_addrconf_lease_t *lease)
 			ni_dhcp6_device_drop_lease(dev);
 			ni_dhcp6_device_stop(dev);
 		} else if (dev->config->mode & NI_BIT(NI_DHCP6_MODE_INFO)) {
-			dev->fsm.state = NI_DHCP6_STATE_BOUND;
+			ni_dhcp6_fsm_set_state(dev, NI_DHCP6_STATE_BOUND);
 			ni_dhcp6_fsm_bound(dev);
 		} else {
-			dev->fsm.state = NI_DHCP6_STATE_VALIDATING;
+			ni_dhcp6_fsm_set_state(dev, NI_DHCP6_STATE_VALIDATING);
 			ni_dhcp6_fsm_set_timeout_msec(dev, NI_DHCP6_WAIT_IAADDR_READY);
 		}
 
@@ -2353,7 +2354,7 @@ ni_dhcp6_fsm_bound_info(ni_dhcp6_device_t *dev)
 	unsigned int refresh;
 	struct timeval now;
 
-	dev->fsm.state = NI_DHCP6_STATE_BOUND;
+	ni_dhcp6_fsm_set_state(dev, NI_DHCP6_STATE_BOUND);
 
 	refresh = ni_dhcp6_config_info_refresh_time(dev->ifname, &range);
 	if (dev->lease->dhcp6.info_refresh) {
@@ -2397,7 +2398,7 @@ ni_dhcp6_fsm_bound(ni_dhcp6_device_t *dev)
 
 	timeout = ni_dhcp6_fsm_get_renewal_timeout(dev);
 	if (timeout > 0) {
-		dev->fsm.state = NI_DHCP6_STATE_BOUND;
+		ni_dhcp6_fsm_set_state(dev, NI_DHCP6_STATE_BOUND);
 
 		if (timeout == NI_DHCP6_INFINITE_LIFETIME) {
 			/* Hmm... */
@@ -2744,6 +2745,14 @@ static const char *__dhcp6_state_name[__NI_DHCP6_STATE_MAX] = {
 	[NI_DHCP6_STATE_REQUESTING_INFO]= "REQUESTING INFO",
 };
 
+void
+ni_dhcp6_fsm_set_state(ni_dhcp6_device_t *dev, int state)
+{
+	if (dev->fsm.state != state)
+		ni_metrics_count(NI_METRIC_DHCP6_TRANSITIONS);
+	dev->fsm.state = state;
+}
+
 const char *
 ni_dhcp6_fsm_state_name(int state)
 {
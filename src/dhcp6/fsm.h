@@ -47,6 +47,7 @@ enum {
  * -- fsm functions used in device.c and protocol.c
  */
 const char *			ni_dhcp6_fsm_state_name(int state);
+extern void			ni_dhcp6_fsm_set_state(ni_dhcp6_device_t *, int state);
 
 extern int			ni_dhcp6_fsm_process_client_message(ni_dhcp6_device_t *,
 							ni_dhcp6_message_t *, ni_buffer_t *);
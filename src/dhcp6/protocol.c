@@ -86,11 +86,71 @@ static int	ni_dhcp6_option_next(ni_buffer_t *options, ni_buffer_t *optbuf);
 static int	ni_dhcp6_option_get_duid(ni_buffer_t *bp, ni_opaque_t *duid);
 
 /*
- * Open a multicast socket bound to link-local address and dhcp6 client port.
+ * All devices share a single client socket bound to the unspecified
+ * address and the dhcp6 client port. The receiving interface is taken
+ * from the IPV6_PKTINFO control message and used to look up the device
+ * in a table indexed by ifindex. Outgoing packets carry an IPV6_PKTINFO
+ * too, selecting the egress interface and link-local source address.
+ */
+static struct {
+	ni_socket_t *		sock;
+	unsigned int		count;
+	unsigned int		size;
+	ni_dhcp6_device_t **	devs;
+} ni_dhcp6_mcast;
+
+#define NI_DHCP6_MCAST_DEVS_CHUNK	16
+
+static ni_dhcp6_device_t *
+ni_dhcp6_mcast_device_by_index(unsigned int ifindex)
+{
+	if (ifindex < ni_dhcp6_mcast.size)
+		return ni_dhcp6_mcast.devs[ifindex];
+	return NULL;
+}
+
+static void
+ni_dhcp6_mcast_device_register(ni_dhcp6_device_t *dev)
+{
+	unsigned int ifindex = dev->link.ifindex;
+
+	if (ifindex >= ni_dhcp6_mcast.size) {
+		unsigned int size = ifindex + NI_DHCP6_MCAST_DEVS_CHUNK;
+
+		ni_dhcp6_mcast.devs = xrealloc(ni_dhcp6_mcast.devs,
+					size * sizeof(ni_dhcp6_device_t *));
+		memset(ni_dhcp6_mcast.devs + ni_dhcp6_mcast.size, 0,
+			(size - ni_dhcp6_mcast.size) * sizeof(ni_dhcp6_device_t *));
+		ni_dhcp6_mcast.size = size;
+	}
+	if (ni_dhcp6_mcast.devs[ifindex] != dev) {
+		ni_dhcp6_mcast.devs[ifindex] = dev;
+		ni_dhcp6_mcast.count++;
+	}
+}
+
+static void
+ni_dhcp6_mcast_device_unregister(ni_dhcp6_device_t *dev)
+{
+	unsigned int ifindex = dev->link.ifindex;
+
+	if (ni_dhcp6_mcast_device_by_index(ifindex) != dev)
+		return;
+
+	ni_dhcp6_mcast.devs[ifindex] = NULL;
+	if (--ni_dhcp6_mcast.count == 0) {
+		free(ni_dhcp6_mcast.devs);
+		ni_dhcp6_mcast.devs = NULL;
+		ni_dhcp6_mcast.size = 0;
+	}
+}
+
+/*
+ * Open the client socket bound to the unspecified address and dhcp6 client port.
  *
  */
 static int
-__ni_dhcp6_mcast_socket_open(const struct ni_dhcp6_link *link, const char *ifname)
+__ni_dhcp6_mcast_socket_open(void)
 {
 	ni_sockaddr_t saddr;
 	int fd, on;
@@ -111,134 +171,146 @@ __ni_dhcp6_mcast_socket_open(const struct ni_dhcp6_link *link, const char *ifnam
 	 *   for which it is requesting configuration information as the source
 	 *   address in the header of the IP datagram.
 	 *   [...]
+	 *
+	 * The source address is set per packet, see ni_dhcp6_socket_send.
 	 */
 	if ((fd = socket (PF_INET6, SOCK_DGRAM, IPPROTO_UDP)) == -1) {
-		ni_error("%s: Cannot open socket(INET6, DGRAM, UDP): %m", ifname);
+		ni_error("Cannot open socket(INET6, DGRAM, UDP): %m");
 		return -1;
 	}
 
 	on = 1;
 	if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) == -1)
-		ni_error("%s: Cannot set setsockopt(SO_REUSEADDR): %m", ifname);
+		ni_error("Cannot set setsockopt(SO_REUSEADDR): %m");
 #if defined(SO_REUSEPORT)
 	if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) == -1)
-		ni_error("%s: Cannot set setsockopt(SO_REUSEPORT): %m", ifname);
+		ni_error("Cannot set setsockopt(SO_REUSEPORT): %m");
 #endif
-	if (setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &on, sizeof(on)) == -1)
-		ni_error("%s: Cannot set setsockopt(SO_RCVBUF): %m", ifname);
+	if (setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &on, sizeof(on)) == -1)
+		ni_error("Cannot set setsockopt(IPV6_V6ONLY): %m");
 
 	if (setsockopt(fd, IPPROTO_IPV6, IPV6_RECVPKTINFO, &on, sizeof(on)) != 0)
-		ni_error("%s: Cannot set setsockopt(IPV6_RECVPKTINFO): %m", ifname);
+		ni_error("Cannot set setsockopt(IPV6_RECVPKTINFO): %m");
 
 	if (fcntl(fd, F_SETFD, FD_CLOEXEC) == -1)
-		ni_error("%s: Cannot set fcntl(SETDF, CLOEXEC): %m", ifname);
+		ni_error("Cannot set fcntl(SETDF, CLOEXEC): %m");
 
-
-	ni_sockaddr_set_ipv6(&saddr, link->addr.six.sin6_addr, NI_DHCP6_CLIENT_PORT);
-	saddr.six.sin6_scope_id = link->ifindex;
+	ni_sockaddr_set_ipv6(&saddr, in6addr_any, NI_DHCP6_CLIENT_PORT);
 	if (bind(fd, &saddr.sa, sizeof(saddr.six)) == -1) {
-		ni_error("%s: Cannot bind(%s): %m", ifname, ni_sockaddr_print(&saddr));
+		ni_error("Cannot bind(%s): %m", ni_sockaddr_print(&saddr));
 		close(fd);
 		return -1;
 	}
 
-	/*
-	 * Set the device index for outgoing multicast packets on the socket.
-	 */
-	on = link->ifindex;
-	if (setsockopt(fd, IPPROTO_IPV6, IPV6_MULTICAST_IF, &on, sizeof(on)) != 0) {
-		ni_error("%s: Cannot set setsockopt(IPV6_MULTICAST_IF, %d: %m",
-			ifname, on);
+	ni_debug_dhcp("bound DHCPv6 socket to [%s]:%u",
+		ni_sockaddr_print(&saddr), ntohs(saddr.six.sin6_port));
+
+	return fd;
+}
+
+static ni_socket_t *
+ni_dhcp6_mcast_socket_get(void)
+{
+	ni_socket_t *sock;
+	int fd;
+
+	if ((sock = ni_dhcp6_mcast.sock) != NULL) {
+		if (sock->active && !sock->error)
+			return sock;
+
+		/* there were a receive error, close and open again  */
+		ni_socket_close(sock);
+		ni_dhcp6_mcast.sock = NULL;
 	}
 
-	ni_debug_dhcp("%s: bound DHCPv6 socket to [%s%%%u]:%u",
-		ifname, ni_sockaddr_print(&saddr), saddr.six.sin6_scope_id,
-		ntohs(saddr.six.sin6_port));
+	if ((fd = __ni_dhcp6_mcast_socket_open()) == -1)
+		return NULL;
 
-	return fd;
+	/* finally wrap it and allocate receive buffer */
+	if (!(sock = ni_socket_wrap(fd, SOCK_DGRAM))) {
+		ni_error("Unable to prepare DHCPv6 multicast socket");
+		close(fd);
+		return NULL;
+	}
+
+	sock->receive = ni_dhcp6_socket_recv;
+	sock->get_timeout = ni_dhcp6_socket_get_timeout;
+	sock->check_timeout = ni_dhcp6_socket_check_timeout;
+
+	/* See rfc2460#section-5, Packet Size Issues. Allocate max buffer */
+	ni_buffer_init_dynamic(&sock->rbuf, NI_DHCP6_RBUF_SIZE);
+
+	ni_socket_activate(sock);
+	ni_dhcp6_mcast.sock = sock;
+	return sock;
 }
 
 /*
- * Open a DHCP6 socket for send and receive
+ * Attach a device to the DHCP6 socket for send and receive
  */
 int
 ni_dhcp6_mcast_socket_open(ni_dhcp6_device_t *dev)
 {
-	int fd;
-
 	/*
 	 * We call this function for verification before transmission.
-	 * When the socket is open but the device not ready anymore,
-	 * close the socket as it is bound to the link-local address
-	 * and return error.
+	 * When the device is not ready anymore, we've no link-local
+	 * address to send from -- detach it and return error.
 	 */
 	if ( !ni_dhcp6_device_is_ready(dev, NULL)) {
 		ni_debug_dhcp("%s: interface is not ready", dev->ifname);
 
-		/* transient error: close the socket and wait for
+		/* transient error: detach the device and wait for
 		 * network-up and link-local address events ... */
 		ni_dhcp6_mcast_socket_close(dev);
 		return 1;
 	}
 
-	if (dev->mcast.sock != NULL) {
-		if (dev->mcast.sock->active && !dev->mcast.sock->error)
-			return 0;
+	/* the socket may have been reopened after a receive error */
+	if (!(dev->mcast.sock = ni_dhcp6_mcast_socket_get()))
+		return -1;
 
-		/* there were a receive error, close and open again  */
-		ni_dhcp6_mcast_socket_close(dev);
-	}
+	if (ni_dhcp6_mcast_device_by_index(dev->link.ifindex) == dev)
+		return 0;
 
 	/* prepare the all servers and relay agents multicast address */
 	if (ni_sockaddr_parse(&dev->mcast.dest, NI_DHCP6_ALL_RAGENTS, AF_INET6) < 0) {
 		memset(&dev->mcast.dest, 0, sizeof(dev->mcast.dest));
 		ni_error("%s: Unable to prepare DHCPv6 destination address %s",
 			dev->ifname, NI_DHCP6_ALL_RAGENTS);
+		ni_dhcp6_mcast_socket_close(dev);
 		return -1;
 	}
 	dev->mcast.dest.six.sin6_port = htons(NI_DHCP6_SERVER_PORT);
 	dev->mcast.dest.six.sin6_scope_id = dev->link.ifindex;
 
-	/* open the socket an bind to the link-local address */
-	if ((fd = __ni_dhcp6_mcast_socket_open(&dev->link, dev->ifname)) == -1)
-		return -1;
-
-	/* finally wrap it and allocate receive buffer */
-	if ((dev->mcast.sock = ni_socket_wrap(fd, SOCK_DGRAM)) != NULL) {
-		dev->mcast.sock->user_data = dev;
-		dev->mcast.sock->receive = ni_dhcp6_socket_recv;
-		dev->mcast.sock->get_timeout = ni_dhcp6_socket_get_timeout;
-		dev->mcast.sock->check_timeout = ni_dhcp6_socket_check_timeout;
-
-		/* See rfc2460#section-5, Packet Size Issues. Allocate max buffer */
-		ni_buffer_init_dynamic(&dev->mcast.sock->rbuf, NI_DHCP6_RBUF_SIZE);
-
-		ni_socket_activate(dev->mcast.sock);
-		return 0;
-	} else {
-		ni_error("%s: Unable to prepare DHCPv6 multicast socket",
-			dev->ifname);
-		close(fd);
-		return -1;
-	}
+	ni_dhcp6_mcast_device_register(dev);
+	return 0;
 }
 
 void
 ni_dhcp6_mcast_socket_close(ni_dhcp6_device_t *dev)
 {
-	if (dev->mcast.sock)
-		ni_socket_close(dev->mcast.sock);
+	ni_dhcp6_mcast_device_unregister(dev);
+	if (!ni_dhcp6_mcast.count && ni_dhcp6_mcast.sock) {
+		ni_socket_close(ni_dhcp6_mcast.sock);
+		ni_dhcp6_mcast.sock = NULL;
+	}
 	dev->mcast.sock = NULL;
 	memset(&dev->mcast.dest, 0, sizeof(dev->mcast.dest));
 }
 
 ssize_t
-ni_dhcp6_socket_send(ni_socket_t *sock, const ni_buffer_t *mesg, const ni_sockaddr_t *dest)
+ni_dhcp6_socket_send(ni_dhcp6_device_t *dev, const ni_buffer_t *mesg, const ni_sockaddr_t *dest)
 {
+	unsigned char cbuf[CMSG_SPACE(sizeof(struct in6_pktinfo))];
+	struct in6_pktinfo *pinfo;
+	struct cmsghdr *cm;
+	struct iovec iov;
+	struct msghdr msg;
 	int flags = 0;
 	size_t cnt;
 
-	if (!sock) {
+	if (!dev || !dev->mcast.sock) {
 		errno = ENOTSOCK;
 		return -1;
 	}
@@ -257,8 +329,28 @@ ni_dhcp6_socket_send(ni_socket_t *sock, const ni_buffer_t *mesg, const ni_sockad
 	    ni_sockaddr_is_ipv6_linklocal(dest))
 		flags |= MSG_DONTROUTE;
 
-	return sendto(sock->__fd, ni_buffer_head(mesg), cnt,
-			flags, &dest->sa, sizeof(dest->six));
+	iov.iov_base = ni_buffer_head(mesg);
+	iov.iov_len = cnt;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_name = (void *)&dest->six;
+	msg.msg_namelen = sizeof(dest->six);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = cbuf;
+	msg.msg_controllen = sizeof(cbuf);
+
+	/* send via the device using its link-local address as source */
+	memset(&cbuf, 0, sizeof(cbuf));
+	cm = CMSG_FIRSTHDR(&msg);
+	cm->cmsg_level = IPPROTO_IPV6;
+	cm->cmsg_type = IPV6_PKTINFO;
+	cm->cmsg_len = CMSG_LEN(sizeof(struct in6_pktinfo));
+	pinfo = (struct in6_pktinfo *)(CMSG_DATA(cm));
+	pinfo->ipi6_addr = dev->link.addr.six.sin6_addr;
+	pinfo->ipi6_ifindex = dev->link.ifindex;
+
+	return sendmsg(dev->mcast.sock->__fd, &msg, flags);
 }
 
 
@@ -280,7 +372,7 @@ ni_dhcp6_socket_recv(ni_socket_t *sock)
 #ifdef	NI_DHCP6_HEXDUMP_LEVEL
 	ni_stringbuf_t hexbuf = NI_STRINGBUF_INIT_DYNAMIC;
 #endif
-	ni_dhcp6_device_t * dev = sock->user_data;
+	ni_dhcp6_device_t * dev;
 	ni_buffer_t * rbuf = &sock->rbuf;
 	unsigned char cbuf[CMSG_SPACE(sizeof(struct in6_pktinfo))];
 	ni_sockaddr_t saddr;
@@ -307,14 +399,14 @@ ni_dhcp6_socket_recv(ni_socket_t *sock)
 	bytes = recvmsg(sock->__fd, &msg, 0);
 	if(bytes < 0) {
 		if (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) {
-			ni_error("%s: recvmsg error on socket %d: %m",
-				dev->ifname, sock->__fd);
+			ni_error("recvmsg error on DHCPv6 socket %d: %m",
+				sock->__fd);
 			ni_socket_deactivate(sock);
 		}
 		return;
 	} else if (bytes == 0) {
-		ni_error("%s: recvmsg didn't returned any data on socket %d",
-			dev->ifname, sock->__fd);
+		ni_error("recvmsg didn't returned any data on DHCPv6 socket %d",
+			sock->__fd);
 		return;
 	}
 
@@ -327,13 +419,13 @@ ni_dhcp6_socket_recv(ni_socket_t *sock)
 	}
 
 	if (pinfo == NULL) {
-		ni_error("%s: discarding packet without packet info on socket %d",
-			dev->ifname, sock->__fd);
+		ni_error("discarding packet without packet info on DHCPv6 socket %d",
+			sock->__fd);
 		return;
 	}
-	if(dev->link.ifindex != pinfo->ipi6_ifindex) {
-		ni_error("%s: discarding packet with interface index %u instead %u",
-			dev->ifname, pinfo->ipi6_ifindex, dev->link.ifindex);
+	if (!(dev = ni_dhcp6_mcast_device_by_index(pinfo->ipi6_ifindex))) {
+		ni_debug_dhcp("discarding packet received on interface index %u"
+			" without active DHCPv6 device", pinfo->ipi6_ifindex);
 		return;
 	}
 
@@ -426,25 +518,28 @@ ni_dhcp6_address_print(const struct in6_addr *ipv6)
 	return ni_sockaddr_print(&addr);
 }
 
+/*
+ * The retransmission deadlines of all devices attached to the
+ * shared socket are checked by its timeout callbacks.
+ */
 static int
 ni_dhcp6_socket_get_timeout(const ni_socket_t *sock, struct timeval *tv)
 {
-	ni_dhcp6_device_t * dev = sock->user_data;
-	if( !(dev = sock->user_data)) {
-		ni_error("check_timeout: socket without capture object?!");
-		return -1;
-	}
+	ni_dhcp6_device_t *dev;
+	unsigned int i;
+
+	(void)sock;
 
 	timerclear(tv);
-	if (timerisset(&dev->retrans.deadline)) {
-		*tv = dev->retrans.deadline;
-#if 0
-		ni_trace("%s: get socket timeout for socket [fd=%d]: deadline %s",
-				dev->ifname, sock->__fd, ni_dhcp6_print_timeval(tv));
-	} else {
-		ni_trace("%s: get socket timeout for socket [fd=%d]: no deadline",
-				dev->ifname, sock->__fd);
-#endif
+	for (i = 0; i < ni_dhcp6_mcast.size; ++i) {
+		if (!(dev = ni_dhcp6_mcast.devs[i]))
+			continue;
+
+		if (!timerisset(&dev->retrans.deadline))
+			continue;
+
+		if (!timerisset(tv) || timercmp(&dev->retrans.deadline, tv, <))
+			*tv = dev->retrans.deadline;
 	}
 	return timerisset(tv) ? 0 : -1;
 }
@@ -452,26 +547,20 @@ ni_dhcp6_socket_get_timeout(const ni_socket_t *sock, struct timeval *tv)
 static void
 ni_dhcp6_socket_check_timeout(ni_socket_t *sock, const struct timeval *now)
 {
-	ni_dhcp6_device_t * dev;
-	struct tm;
+	ni_dhcp6_device_t *dev;
+	unsigned int i;
 
-	if (!(dev = sock->user_data)) {
-		ni_error("check_timeout: socket without device object?!");
-		return;
-	}
+	/*
+	 * A retransmit may detach devices or even close the socket,
+	 * so we check the table size again in every iteration.
+	 */
+	for (i = 0; i < ni_dhcp6_mcast.size && sock->__fd >= 0; ++i) {
+		if (!(dev = ni_dhcp6_mcast.devs[i]))
+			continue;
 
-	if (timerisset(&dev->retrans.deadline) && timercmp(&dev->retrans.deadline, now, <)) {
-#if 0
-		ni_trace("%s: check socket timeout for socket [fd=%d]: deadline %s",
-				dev->ifname, sock->__fd,
-				ni_dhcp6_print_timeval(&dev->retrans.deadline));
-#endif
-		ni_dhcp6_device_retransmit(dev);
-#if 0
-	} else {
-		ni_trace("%s: check socket timeout for socket [fd=%d]: no deadline",
-				dev->ifname, sock->__fd);
-#endif
+		if (timerisset(&dev->retrans.deadline) &&
+		    timercmp(&dev->retrans.deadline, now, <))
+			ni_dhcp6_device_retransmit(dev);
 	}
 }
 
@@ -1964,7 +2053,7 @@ ni_dhcp6_init_message(ni_dhcp6_device_t *dev, unsigned int msg_code, const ni_ad
 			ni_dhcp6_message_name(msg_code));
 		return -1;
 	}
-	dev->fsm.state = NI_DHCP6_STATE_REBINDING;
+	ni_dhcp6_fsm_set_state(dev, NI_DHCP6_STATE_REBINDING);
 
 	/*
 	 * Set the transmission start after the initial message is build,
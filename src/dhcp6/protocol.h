@@ -262,7 +262,7 @@ extern int		ni_dhcp6_parse_client_options(ni_dhcp6_device_t *dev, ni_dhcp6_messa
 
 extern int		ni_dhcp6_mcast_socket_open(ni_dhcp6_device_t *);
 extern void		ni_dhcp6_mcast_socket_close(ni_dhcp6_device_t *);
-extern ssize_t		ni_dhcp6_socket_send(ni_socket_t *, const ni_buffer_t *, const ni_sockaddr_t *);
+extern ssize_t		ni_dhcp6_socket_send(ni_dhcp6_device_t *, const ni_buffer_t *, const ni_sockaddr_t *);
 
 
 /* FIXME: cleanup */
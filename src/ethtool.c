@@ -27,12 +27,20 @@
 
 #include <net/if_arp.h>
 #include <linux/ethtool.h>
+#ifdef HAVE_ETHTOOL_NETLINK
+#include <linux/genetlink.h>
+#include <linux/ethtool_netlink.h>
+#include <netlink/msg.h>
+#include <netlink/attr.h>
+#endif
+#include <stddef.h>
 #include <errno.h>
 
 #include <wicked/util.h>
 #include <wicked/ethtool.h>
 #include "netinfo_priv.h"
 #include "util_priv.h"
+#include "socket_priv.h"
 #include "kernel.h"
 
 /*
@@ -82,6 +90,12 @@ enum {
 
 	NI_ETHTOOL_SUPPORT_MAX
 };
+
+/*
+ * not a support flag: set while the netlink monitor
+ * events keep the device ethtool data up to date.
+ */
+#define NI_ETHTOOL_NETLINK_MONITORED	NI_ETHTOOL_SUPPORT_MAX
 static inline ni_bool_t
 ni_ethtool_supported(const ni_ethtool_t *ethtool, unsigned int flag)
 {
@@ -2290,14 +2304,97 @@ ni_ethtool_get_feature_values(const ni_netdev_ref_t *ref, unsigned int count)
 	return gfeatures;
 }
 
+static void
+ni_ethtool_feature_set_value(const char *ifname, ni_ethtool_feature_t *feature,
+		const struct ethtool_get_features_block *block, unsigned int bit)
+{
+	feature->value = NI_ETHTOOL_FEATURE_OFF;
+	if (!(block->available & bit) || (block->never_changed & bit)) {
+		feature->value |= NI_ETHTOOL_FEATURE_FIXED;
+		if (block->active & bit)
+			feature->value |= NI_ETHTOOL_FEATURE_ON;
+	} else if ((block->requested & bit) ^ (block->active & bit)) {
+		feature->value |= NI_ETHTOOL_FEATURE_REQUESTED;
+		if (block->requested & bit)
+			feature->value |= NI_ETHTOOL_FEATURE_ON;
+	} else {
+		if (block->active & bit)
+			feature->value |= NI_ETHTOOL_FEATURE_ON;
+	}
+	ni_debug_verbose(NI_LOG_DEBUG2, NI_TRACE_IFCONFIG,
+			"%s: get ethtool feature[%u] %s: %s%s",
+			ifname, feature->index, feature->map.name,
+			feature->value & NI_ETHTOOL_FEATURE_ON ? "on" : "off",
+			feature->value & NI_ETHTOOL_FEATURE_FIXED ? " fixed" :
+			feature->value & NI_ETHTOOL_FEATURE_REQUESTED ? " requested" : "");
+}
+
+static void
+ni_ethtool_features_init_from(const char *ifname, ni_ethtool_features_t *features,
+		const struct ethtool_gfeatures *gfeatures,
+		const struct ethtool_gstrings *gstrings, ni_bool_t unavailable)
+{
+	ni_ethtool_feature_t *feature;
+	unsigned int i, count;
+
+	count = gfeatures->size * 32U;
+	if (count > gstrings->len)
+		count = gstrings->len;
+
+	for (i = 0; i < count; ++i) {
+		const struct ethtool_get_features_block *block;
+		const char *name;
+		unsigned int bit;
+
+		name = (const char *)(gstrings->data + i * ETH_GSTRING_LEN);
+		block = &gfeatures->features[i/32U];
+		bit = NI_BIT(i % 32U);
+
+		/* don't store unavailable features except requested */
+		if (!((block->available & bit) || unavailable))
+			continue;
+
+		if (!(feature = ni_ethtool_feature_new(name, i)))
+			continue;
+
+		ni_ethtool_feature_set_value(ifname, feature, block, bit);
+
+		if (!ni_ethtool_features_add(features, feature)) {
+			ni_warn("%s: unable to store feature %s: %m", ifname, feature->map.name);
+			ni_ethtool_feature_free(feature);
+		}
+	}
+}
+
+static void
+ni_ethtool_features_update_from(const char *ifname, ni_ethtool_features_t *features,
+		const struct ethtool_gfeatures *gfeatures)
+{
+	ni_ethtool_feature_t *feature;
+	unsigned int i, count;
+
+	count = gfeatures->size * 32U;
+	for (i = 0; i < features->count; ++i) {
+		feature = features->data[i];
+		if (!feature || feature->index == -1U || feature->index >= count) {
+			ni_debug_verbose(NI_LOG_DEBUG2, NI_TRACE_IFCONFIG,
+				"%s: get ethtool feature[%u] %s: invalid index",
+				ifname, i, feature ? feature->map.name : NULL);
+			continue;
+		}
+
+		ni_ethtool_feature_set_value(ifname, feature,
+				&gfeatures->features[feature->index/32U],
+				NI_BIT(feature->index % 32U));
+	}
+}
+
 static int
 ni_ethtool_get_features_init(const ni_netdev_ref_t *ref, ni_ethtool_t *ethtool, ni_bool_t unavailable)
 {
 	struct ethtool_gfeatures *gfeatures;
 	struct ethtool_gstrings *gstrings;
 	ni_ethtool_features_t *features;
-	ni_ethtool_feature_t *feature;
-	unsigned int i, count;
 
 	if (!ethtool->features && !(ethtool->features = ni_ethtool_features_new()))
 		return -ENOMEM;
@@ -2327,51 +2424,7 @@ ni_ethtool_get_features_init(const ni_netdev_ref_t *ref, ni_ethtool_t *ethtool,
 		return errno;
 	}
 
-	count = gfeatures->size * 32U;
-	if (count > gstrings->len)
-		count = gstrings->len;
-
-	for (i = 0; i < count; ++i) {
-		struct ethtool_get_features_block *block;
-		const char *name;
-		unsigned int bit;
-
-		name = (const char *)(gstrings->data + i * ETH_GSTRING_LEN);
-		block = &gfeatures->features[i/32U];
-		bit = NI_BIT(i % 32U);
-
-		/* don't store unavailable features except requested */
-		if (!((block->available & bit) || unavailable))
-			continue;
-
-		if (!(feature = ni_ethtool_feature_new(name, i)))
-			continue;
-
-		feature->value = NI_ETHTOOL_FEATURE_OFF;
-		if (!(block->available & bit) || (block->never_changed & bit)) {
-			feature->value |= NI_ETHTOOL_FEATURE_FIXED;
-			if (block->active & bit)
-				feature->value |= NI_ETHTOOL_FEATURE_ON;
-		} else if ((block->requested & bit) ^ (block->active & bit)) {
-			feature->value |= NI_ETHTOOL_FEATURE_REQUESTED;
-			if (block->requested & bit)
-				feature->value |= NI_ETHTOOL_FEATURE_ON;
-		} else {
-			if (block->active & bit)
-				feature->value |= NI_ETHTOOL_FEATURE_ON;
-		}
-		ni_debug_verbose(NI_LOG_DEBUG2, NI_TRACE_IFCONFIG,
-				"%s: get ethtool feature[%u] %s: %s%s",
-				ref->name, feature->index, feature->map.name,
-				feature->value & NI_ETHTOOL_FEATURE_ON ? "on" : "off",
-				feature->value & NI_ETHTOOL_FEATURE_FIXED ? " fixed" :
-				feature->value & NI_ETHTOOL_FEATURE_REQUESTED ? " requested" : "");
-
-		if (!ni_ethtool_features_add(features, feature)) {
-			ni_warn("%s: unable to store feature %s: %m", ref->name, feature->map.name);
-			ni_ethtool_feature_free(feature);
-		}
-	}
+	ni_ethtool_features_init_from(ref->name, features, gfeatures, gstrings, unavailable);
 
 	free(gstrings);
 	free(gfeatures);
@@ -2383,8 +2436,6 @@ ni_ethtool_get_features_update(const ni_netdev_ref_t *ref, ni_ethtool_t *ethtool
 {
 	struct ethtool_gfeatures *gfeatures;
 	ni_ethtool_features_t *features;
-	ni_ethtool_feature_t *feature;
-	unsigned int i, count;
 
 	if (!ethtool || !(features = ethtool->features) || !features->total)
 		return -EINVAL;
@@ -2397,42 +2448,7 @@ ni_ethtool_get_features_update(const ni_netdev_ref_t *ref, ni_ethtool_t *ethtool
 		return errno;
 	}
 
-	count = gfeatures->size * 32U;
-	for (i = 0; i < features->count; ++i) {
-		struct ethtool_get_features_block *block;
-		unsigned int bit;
-
-		feature = features->data[i];
-		if (!feature || feature->index == -1U || feature->index >= count) {
-			ni_debug_verbose(NI_LOG_DEBUG2, NI_TRACE_IFCONFIG,
-				"%s: get ethtool feature[%u] %s: invalid index",
-				ref->name, i, feature ? feature->map.name : NULL);
-			continue;
-		}
-
-		block = &gfeatures->features[feature->index/32U];
-		bit = NI_BIT(feature->index % 32U);
-
-		feature->value = NI_ETHTOOL_FEATURE_OFF;
-		if (!(block->available & bit) || (block->never_changed & bit)) {
-			feature->value |= NI_ETHTOOL_FEATURE_FIXED;
-			if (block->active & bit)
-				feature->value |= NI_ETHTOOL_FEATURE_ON;
-		} else if ((block->requested & bit) ^ (block->active & bit)) {
-			feature->value |= NI_ETHTOOL_FEATURE_REQUESTED;
-			if (block->requested & bit)
-				feature->value |= NI_ETHTOOL_FEATURE_ON;
-		} else {
-			if (block->active & bit)
-				feature->value |= NI_ETHTOOL_FEATURE_ON;
-		}
-		ni_debug_verbose(NI_LOG_DEBUG2, NI_TRACE_IFCONFIG,
-				"%s: get ethtool feature[%u] %s: %s%s",
-				ref->name, feature->index, feature->map.name,
-				feature->value & NI_ETHTOOL_FEATURE_ON ? "on" : "off",
-				feature->value & NI_ETHTOOL_FEATURE_FIXED ? " fixed" :
-				feature->value & NI_ETHTOOL_FEATURE_REQUESTED ? " requested" : "");
-	}
+	ni_ethtool_features_update_from(ref->name, features, gfeatures);
 
 	free(gfeatures);
 	return 0;
@@ -3606,60 +3622,1109 @@ ni_ethtool_set_pause(const ni_netdev_ref_t *ref, ni_ethtool_t *ethtool, const ni
 }
 
 
+#ifdef HAVE_ETHTOOL_NETLINK
 /*
- * main system refresh and setup functions
+ * ethtool generic netlink interface
+ *
+ * Kernels providing the "ethtool" genetlink family (linux >= 5.6) are
+ * queried via netlink: a full refresh of all devices requests each of
+ * the categories below in one NLM_F_DUMP for all devices, and wickedd
+ * receives the *_NTF notifications on the monitor multicast group to
+ * keep them up to date.
+ * Driver info, permanent address and link settings, as well as all
+ * set operations, are still using the ioctl interface, which is also
+ * the fallback on older kernels.
+ */
+typedef struct ni_ethtool_nl_cmd {
+	const char *		name;
+	uint8_t			get;
+	uint8_t			reply;
+	uint8_t			ntf;
+	unsigned int		supp;
+	unsigned int		flags;
+	int			maxattr;
+	void			(*reset)(ni_ethtool_t *);
+	int			(*parse)(const char *, ni_ethtool_t *, struct nlattr **);
+} ni_ethtool_nl_cmd_t;
+
+typedef struct ni_ethtool_nl_request {
+	const ni_ethtool_nl_cmd_t *	cmd;
+	ni_netconfig_t *		nc;
+	ni_netdev_t *			dev;
+	unsigned int			count;
+	int				err;
+} ni_ethtool_nl_request_t;
+
+#define NI_ETHTOOL_NL_ATTR_MAX		64
+
+static struct {
+	ni_netlink_t *		nl;
+	int			family;
+	unsigned int		monitor;
+	ni_socket_t *		sock;
+	ni_bool_t		batch;
+} ni_ethtool_nl;
+
+static int
+ni_ethtool_nl_family_parse(struct nl_msg *msg, void *user_data)
+{
+	struct nlmsghdr *nlh = nlmsg_hdr(msg);
+	struct nlattr *tb[CTRL_ATTR_MAX + 1];
+	struct nlattr *grp;
+	int rem;
+
+	(void)user_data;
+	if (nlmsg_parse(nlh, GENL_HDRLEN, tb, CTRL_ATTR_MAX, NULL) < 0)
+		return NL_SKIP;
+
+	if (tb[CTRL_ATTR_FAMILY_ID])
+		ni_ethtool_nl.family = nla_get_u16(tb[CTRL_ATTR_FAMILY_ID]);
+
+	if (tb[CTRL_ATTR_MCAST_GROUPS]) {
+		nla_for_each_nested(grp, tb[CTRL_ATTR_MCAST_GROUPS], rem) {
+			struct nlattr *gb[CTRL_ATTR_MCAST_GRP_MAX + 1];
+
+			if (nla_parse_nested(gb, CTRL_ATTR_MCAST_GRP_MAX, grp, NULL) < 0)
+				continue;
+			if (!gb[CTRL_ATTR_MCAST_GRP_NAME] || !gb[CTRL_ATTR_MCAST_GRP_ID])
+				continue;
+			if (ni_string_eq(nla_get_string(gb[CTRL_ATTR_MCAST_GRP_NAME]),
+						ETHTOOL_MCGRP_MONITOR_NAME))
+				ni_ethtool_nl.monitor = nla_get_u32(gb[CTRL_ATTR_MCAST_GRP_ID]);
+		}
+	}
+	return NL_OK;
+}
+
+static int
+ni_ethtool_nl_error_handler(struct sockaddr_nl *sender, struct nlmsgerr *err, void *arg)
+{
+	ni_ethtool_nl_request_t *req = arg;
+
+	(void)sender;
+	req->err = err->error;
+	return NL_STOP;
+}
+
+/*
+ * Send a request and receive the reply; dumps are multipart messages
+ * until NLMSG_DONE, a plain get is answered by one reply or an error.
  */
+static int
+ni_ethtool_nl_talk(struct nl_msg *msg, int (*handler)(struct nl_msg *, void *),
+		ni_ethtool_nl_request_t *req)
+{
+	struct nl_sock *sock = ni_ethtool_nl.nl->nl_sock;
+	struct nl_cb *cb;
+	int ret;
+
+	if (nl_send_auto(sock, msg) < 0)
+		return -EIO;
+
+	if (!(cb = nl_cb_clone(ni_ethtool_nl.nl->nl_cb)))
+		return -ENOMEM;
+
+	nl_cb_err(cb, NL_CB_CUSTOM, ni_ethtool_nl_error_handler, req);
+	nl_cb_set(cb, NL_CB_VALID, NL_CB_CUSTOM, handler, req);
+
+	ret = nl_recvmsgs(sock, cb);
+	nl_cb_put(cb);
+
+	/* prefer the errno reported by the kernel over libnl's code */
+	if (req->err)
+		return req->err;
+	return ret < 0 ? -EIO : 0;
+}
+
 static ni_bool_t
-ni_ethtool_refresh(ni_netdev_t *dev)
+ni_ethtool_nl_resolve(void)
 {
-	ni_ethtool_t *ethtool;
-	ni_netdev_ref_t ref;
+	ni_ethtool_nl_request_t req;
+	struct genlmsghdr ghdr;
+	struct nl_msg *msg;
+	int ret;
 
-	if (!dev || !(ethtool = ni_netdev_get_ethtool(dev)))
+	memset(&ghdr, 0, sizeof(ghdr));
+	ghdr.cmd = CTRL_CMD_GETFAMILY;
+	ghdr.version = 1;
+
+	if (!(msg = nlmsg_alloc_simple(GENL_ID_CTRL, NLM_F_REQUEST)))
 		return FALSE;
 
-	ref.name = dev->name;
-	ref.index = dev->link.ifindex;
-	if (!ethtool->driver_info)
-		ni_ethtool_get_driver_info(&ref, ethtool);
-	ni_ethtool_get_priv_flags(&ref, ethtool);
-	ni_ethtool_get_link_detected(&ref, ethtool);
-	ni_ethtool_get_link_settings(&ref, ethtool);
-	ni_ethtool_get_wake_on_lan(&ref, ethtool);
-	ni_ethtool_get_features(&ref, ethtool, FALSE);
-	ni_ethtool_get_eee(&ref, ethtool);
-	ni_ethtool_get_ring(&ref, ethtool);
-	ni_ethtool_get_channels(&ref, ethtool);
-	ni_ethtool_get_coalesce(&ref, ethtool);
-	ni_ethtool_get_pause(&ref, ethtool);
+	if (nlmsg_append(msg, &ghdr, sizeof(ghdr), NLMSG_ALIGNTO) < 0 ||
+	    nla_put_string(msg, CTRL_ATTR_FAMILY_NAME, ETHTOOL_GENL_NAME) < 0) {
+		nlmsg_free(msg);
+		return FALSE;
+	}
+
+	memset(&req, 0, sizeof(req));
+	ret = ni_ethtool_nl_talk(msg, ni_ethtool_nl_family_parse, &req);
+	nlmsg_free(msg);
+
+	if (ret < 0 || ni_ethtool_nl.family <= 0) {
+		ni_debug_ifconfig("ethtool netlink family not available, using ioctl");
+		return FALSE;
+	}
+	ni_debug_ifconfig("ethtool netlink family %d, monitor group %u",
+			ni_ethtool_nl.family, ni_ethtool_nl.monitor);
+	return TRUE;
+}
+
+static ni_bool_t
+ni_ethtool_nl_open(void)
+{
+	if (ni_ethtool_nl.family < 0)
+		return FALSE;
+	if (ni_ethtool_nl.family > 0)
+		return TRUE;
+
+	ni_ethtool_nl.family = -1;
+	if (!(ni_ethtool_nl.nl = __ni_netlink_open(NETLINK_GENERIC)))
+		return FALSE;
+
+	nl_socket_disable_auto_ack(ni_ethtool_nl.nl->nl_sock);
+	nl_socket_enable_msg_peek(ni_ethtool_nl.nl->nl_sock);
 
+	if (!ni_ethtool_nl_resolve()) {
+		__ni_netlink_close(ni_ethtool_nl.nl);
+		ni_ethtool_nl.nl = NULL;
+		ni_ethtool_nl.family = -1;
+		return FALSE;
+	}
 	return TRUE;
 }
 
-void
-ni_system_ethtool_refresh(ni_netdev_t *dev)
+/*
+ * attribute helpers
+ */
+static inline ni_bool_t
+ni_ethtool_nl_get_u8(const struct nlattr *nla, uint8_t *val)
 {
-	if (!ni_netdev_device_is_ready(dev) || !dev->link.ifindex)
-		return;
+	const uint8_t *ptr;
 
-	ni_ethtool_refresh(dev);
+	if (!(ptr = __ni_nla_get_data(sizeof(*ptr), nla)))
+		return FALSE;
+	*val = *ptr;
+	return TRUE;
 }
 
-int
-ni_system_ethtool_setup(ni_netconfig_t *nc, ni_netdev_t *dev, const ni_netdev_t *cfg)
+static inline ni_bool_t
+ni_ethtool_nl_get_u32(const struct nlattr *nla, uint32_t *val)
 {
-	ni_netdev_ref_t ref;
+	const uint32_t *ptr;
 
-	if (!ni_netdev_device_is_ready(dev) || !dev->link.ifindex)
+	if (!(ptr = __ni_nla_get_data(sizeof(*ptr), nla)))
+		return FALSE;
+	*val = *ptr;
+	return TRUE;
+}
+
+/* omitted (unsupported) values are reported as 0 by the ioctls */
+static inline unsigned int
+ni_ethtool_nl_get_uint(const struct nlattr *nla)
+{
+	uint32_t val;
+
+	return ni_ethtool_nl_get_u32(nla, &val) ? val : 0;
+}
+
+static inline void
+ni_ethtool_nl_get_tristate(const struct nlattr *nla, ni_tristate_t *val)
+{
+	uint8_t u8;
+
+	if (ni_ethtool_nl_get_u8(nla, &u8))
+		ni_tristate_set(val, !!u8);
+}
+
+static unsigned int
+ni_ethtool_nl_bitset_size(struct nlattr *bitset)
+{
+	struct nlattr *tb[ETHTOOL_A_BITSET_MAX + 1];
+	uint32_t size = 0;
+
+	if (!bitset || nla_parse_nested(tb, ETHTOOL_A_BITSET_MAX, bitset, NULL) < 0)
+		return 0;
+
+	ni_ethtool_nl_get_u32(tb[ETHTOOL_A_BITSET_SIZE], &size);
+	return size;
+}
+
+/*
+ * Decode a bitset into value and mask words, the kernel sends compact
+ * bitsets (value/mask arrays) or verbose ones (a list of named bits).
+ * The bit names of a verbose bitset are stored in the names array.
+ */
+static int
+ni_ethtool_nl_bitset_get(struct nlattr *bitset, unsigned int nbits,
+		uint32_t *value, uint32_t *mask, char (*names)[ETH_GSTRING_LEN])
+{
+	struct nlattr *tb[ETHTOOL_A_BITSET_MAX + 1];
+	unsigned int words = (nbits + 31U) / 32U;
+	ni_bool_t nomask;
+
+	if (!bitset || nla_parse_nested(tb, ETHTOOL_A_BITSET_MAX, bitset, NULL) < 0)
 		return -1;
 
-	if (!dev->ethtool && !ni_ethtool_refresh(dev))
+	nomask = tb[ETHTOOL_A_BITSET_NOMASK] != NULL;
+	if (value)
+		memset(value, 0, words * sizeof(*value));
+	if (mask)
+		memset(mask, 0, words * sizeof(*mask));
+
+	if (tb[ETHTOOL_A_BITSET_VALUE]) {
+		unsigned int len;
+
+		len = min_t(unsigned int, nla_len(tb[ETHTOOL_A_BITSET_VALUE]),
+				words * sizeof(uint32_t));
+		if (value)
+			memcpy(value, nla_data(tb[ETHTOOL_A_BITSET_VALUE]), len);
+
+		if (mask && tb[ETHTOOL_A_BITSET_MASK]) {
+			len = min_t(unsigned int, nla_len(tb[ETHTOOL_A_BITSET_MASK]),
+					words * sizeof(uint32_t));
+			memcpy(mask, nla_data(tb[ETHTOOL_A_BITSET_MASK]), len);
+		}
+	} else if (tb[ETHTOOL_A_BITSET_BITS]) {
+		struct nlattr *bit;
+		int rem;
+
+		nla_for_each_nested(bit, tb[ETHTOOL_A_BITSET_BITS], rem) {
+			struct nlattr *bb[ETHTOOL_A_BITSET_BIT_MAX + 1];
+			uint32_t index;
+
+			if (nla_type(bit) != ETHTOOL_A_BITSET_BITS_BIT)
+				continue;
+			if (nla_parse_nested(bb, ETHTOOL_A_BITSET_BIT_MAX, bit, NULL) < 0)
+				continue;
+			if (!ni_ethtool_nl_get_u32(bb[ETHTOOL_A_BITSET_BIT_INDEX], &index))
+				continue;
+			if (index >= nbits)
+				continue;
+
+			if (value && (nomask || bb[ETHTOOL_A_BITSET_BIT_VALUE]))
+				value[index / 32U] |= NI_BIT(index % 32U);
+			if (mask)
+				mask[index / 32U] |= NI_BIT(index % 32U);
+			if (names && bb[ETHTOOL_A_BITSET_BIT_NAME])
+				strncpy(names[index], nla_get_string(bb[ETHTOOL_A_BITSET_BIT_NAME]),
+						ETH_GSTRING_LEN - 1);
+		}
+	}
+	return 0;
+}
+
+/*
+ * category parsers
+ */
+static void
+ni_ethtool_nl_reset_linkstate(ni_ethtool_t *ethtool)
+{
+	ethtool->link_detected = NI_TRISTATE_DEFAULT;
+}
+
+static int
+ni_ethtool_nl_parse_linkstate(const char *ifname, ni_ethtool_t *ethtool, struct nlattr **tb)
+{
+	(void)ifname;
+	ni_ethtool_nl_get_tristate(tb[ETHTOOL_A_LINKSTATE_LINK], &ethtool->link_detected);
+	return 0;
+}
+
+static void
+ni_ethtool_nl_reset_wol(ni_ethtool_t *ethtool)
+{
+	ni_ethtool_wake_on_lan_free(ethtool->wake_on_lan);
+	ethtool->wake_on_lan = NULL;
+}
+
+static int
+ni_ethtool_nl_parse_wol(const char *ifname, ni_ethtool_t *ethtool, struct nlattr **tb)
+{
+	ni_ethtool_wake_on_lan_t *wol;
+	uint32_t value = 0, mask = 0;
+
+	(void)ifname;
+	if (ni_ethtool_nl_bitset_get(tb[ETHTOOL_A_WOL_MODES], 32, &value, &mask, NULL) < 0)
 		return -1;
 
-	ref.name = dev->name;
-	ref.index = dev->link.ifindex;
-	if (cfg && cfg->ethtool) {
-		ni_ethtool_set_priv_flags(&ref, dev->ethtool, cfg->ethtool->priv_flags);
+	ni_ethtool_nl_reset_wol(ethtool);
+	if (!(wol = ni_ethtool_wake_on_lan_new()))
+		return -1;
+
+	wol->support = mask;
+	wol->options = value;
+	if ((wol->options & NI_BIT(NI_ETHTOOL_WOL_SECUREON)) && tb[ETHTOOL_A_WOL_SOPASS] &&
+	    nla_len(tb[ETHTOOL_A_WOL_SOPASS]) == SOPASS_MAX && NI_MAXHWADDRLEN > SOPASS_MAX) {
+		wol->sopass.type = ARPHRD_ETHER;
+		wol->sopass.len = SOPASS_MAX;
+		memcpy(&wol->sopass.data, nla_data(tb[ETHTOOL_A_WOL_SOPASS]), SOPASS_MAX);
+	}
+
+	ethtool->wake_on_lan = wol;
+	return 0;
+}
+
+static int
+ni_ethtool_nl_parse_features(const char *ifname, ni_ethtool_t *ethtool, struct nlattr **tb)
+{
+	struct ethtool_gfeatures *gfeatures = NULL;
+	struct ethtool_gstrings *gstrings = NULL;
+	ni_ethtool_features_t *features;
+	unsigned int size, words, i;
+	uint32_t *hw, *wanted, *active, *nochange;
+	int ret = -1;
+
+	if (!(size = ni_ethtool_nl_bitset_size(tb[ETHTOOL_A_FEATURES_HW])))
+		return -1;
+
+	words = (size + 31U) / 32U;
+	if (!(hw = calloc(4 * words, sizeof(uint32_t))))
+		return -1;
+	wanted   = hw + words;
+	active   = hw + 2 * words;
+	nochange = hw + 3 * words;
+
+	gfeatures = calloc(1, sizeof(*gfeatures) + words * sizeof(gfeatures->features[0]));
+	gstrings  = calloc(1, sizeof(*gstrings) + size * ETH_GSTRING_LEN);
+	if (!gfeatures || !gstrings)
+		goto cleanup;
+
+	if (ni_ethtool_nl_bitset_get(tb[ETHTOOL_A_FEATURES_HW], size, hw, NULL,
+				(char (*)[ETH_GSTRING_LEN])gstrings->data) < 0 ||
+	    ni_ethtool_nl_bitset_get(tb[ETHTOOL_A_FEATURES_WANTED], size, wanted, NULL, NULL) < 0 ||
+	    ni_ethtool_nl_bitset_get(tb[ETHTOOL_A_FEATURES_ACTIVE], size, active, NULL, NULL) < 0 ||
+	    ni_ethtool_nl_bitset_get(tb[ETHTOOL_A_FEATURES_NOCHANGE], size, nochange, NULL, NULL) < 0)
+		goto cleanup;
+
+	gfeatures->size = words;
+	gstrings->len = size;
+	for (i = 0; i < words; ++i) {
+		gfeatures->features[i].available     = hw[i];
+		gfeatures->features[i].requested     = wanted[i];
+		gfeatures->features[i].active        = active[i];
+		gfeatures->features[i].never_changed = nochange[i];
+	}
+
+	features = ethtool->features;
+	if (features && features->total == size) {
+		ni_ethtool_features_update_from(ifname, features, gfeatures);
+	} else {
+		ni_ethtool_features_free(ethtool->features);
+		if (!(ethtool->features = features = ni_ethtool_features_new()))
+			goto cleanup;
+		features->total = size;
+		ni_ethtool_features_init_from(ifname, features, gfeatures, gstrings, FALSE);
+	}
+	ret = 0;
+
+cleanup:
+	free(gstrings);
+	free(gfeatures);
+	free(hw);
+	return ret;
+}
+
+static void
+ni_ethtool_nl_reset_priv_flags(ni_ethtool_t *ethtool)
+{
+	ni_ethtool_priv_flags_free(ethtool->priv_flags);
+	ethtool->priv_flags = NULL;
+}
+
+static int
+ni_ethtool_nl_parse_priv_flags(const char *ifname, ni_ethtool_t *ethtool, struct nlattr **tb)
+{
+	char names[32][ETH_GSTRING_LEN];
+	ni_ethtool_priv_flags_t *priv;
+	uint32_t value = 0, mask = 0;
+	unsigned int size, i;
+	ni_stringbuf_t buf;
+
+	(void)ifname;
+	if (!(size = ni_ethtool_nl_bitset_size(tb[ETHTOOL_A_PRIVFLAGS_FLAGS])))
+		return -1;
+	if (size > 32)
+		size = 32;
+
+	memset(names, 0, sizeof(names));
+	if (ni_ethtool_nl_bitset_get(tb[ETHTOOL_A_PRIVFLAGS_FLAGS], size, &value, &mask, names) < 0)
+		return -1;
+
+	ni_ethtool_nl_reset_priv_flags(ethtool);
+	if (!(priv = ni_ethtool_priv_flags_new()))
+		return -1;
+
+	ni_stringbuf_init(&buf);
+	for (i = 0; i < size; ++i) {
+		ni_stringbuf_put(&buf, names[i], ETH_GSTRING_LEN);
+		ni_stringbuf_trim_head(&buf, " \t\n");
+		ni_stringbuf_trim_tail(&buf, " \t\n");
+		ni_string_array_append(&priv->names, buf.string);
+		ni_stringbuf_destroy(&buf);
+	}
+	priv->bitmap = value;
+
+	ethtool->priv_flags = priv;
+	return 0;
+}
+
+static void
+ni_ethtool_nl_reset_ring(ni_ethtool_t *ethtool)
+{
+	ni_ethtool_ring_free(ethtool->ring);
+	ethtool->ring = NULL;
+}
+
+static int
+ni_ethtool_nl_parse_ring(const char *ifname, ni_ethtool_t *ethtool, struct nlattr **tb)
+{
+	ni_ethtool_ring_t *ring;
+
+	(void)ifname;
+	ni_ethtool_nl_reset_ring(ethtool);
+	if (!(ring = ni_ethtool_ring_new()))
+		return -1;
+
+	ring->tx        = ni_ethtool_nl_get_uint(tb[ETHTOOL_A_RINGS_TX]);
+	ring->rx        = ni_ethtool_nl_get_uint(tb[ETHTOOL_A_RINGS_RX]);
+	ring->rx_mini   = ni_ethtool_nl_get_uint(tb[ETHTOOL_A_RINGS_RX_MINI]);
+	ring->rx_jumbo  = ni_ethtool_nl_get_uint(tb[ETHTOOL_A_RINGS_RX_JUMBO]);
+
+	ethtool->ring = ring;
+	return 0;
+}
+
+static void
+ni_ethtool_nl_reset_channels(ni_ethtool_t *ethtool)
+{
+	ni_ethtool_channels_free(ethtool->channels);
+	ethtool->channels = NULL;
+}
+
+static int
+ni_ethtool_nl_parse_channels(const char *ifname, ni_ethtool_t *ethtool, struct nlattr **tb)
+{
+	ni_ethtool_channels_t *channels;
+
+	(void)ifname;
+	ni_ethtool_nl_reset_channels(ethtool);
+	if (!(channels = ni_ethtool_channels_new()))
+		return -1;
+
+	channels->tx       = ni_ethtool_nl_get_uint(tb[ETHTOOL_A_CHANNELS_TX_COUNT]);
+	channels->rx       = ni_ethtool_nl_get_uint(tb[ETHTOOL_A_CHANNELS_RX_COUNT]);
+	channels->other    = ni_ethtool_nl_get_uint(tb[ETHTOOL_A_CHANNELS_OTHER_COUNT]);
+	channels->combined = ni_ethtool_nl_get_uint(tb[ETHTOOL_A_CHANNELS_COMBINED_COUNT]);
+
+	ethtool->channels = channels;
+	return 0;
+}
+
+static void
+ni_ethtool_nl_reset_coalesce(ni_ethtool_t *ethtool)
+{
+	ni_ethtool_coalesce_free(ethtool->coalesce);
+	ethtool->coalesce = NULL;
+}
+
+static int
+ni_ethtool_nl_parse_coalesce(const char *ifname, ni_ethtool_t *ethtool, struct nlattr **tb)
+{
+	static const struct {
+		int		attr;
+		size_t		offset;
+	} map[] = {
+		{ ETHTOOL_A_COALESCE_PKT_RATE_LOW,	offsetof(ni_ethtool_coalesce_t, pkt_rate_low)		},
+		{ ETHTOOL_A_COALESCE_PKT_RATE_HIGH,	offsetof(ni_ethtool_coalesce_t, pkt_rate_high)		},
+		{ ETHTOOL_A_COALESCE_RATE_SAMPLE_INTERVAL, offsetof(ni_ethtool_coalesce_t, sample_interval)	},
+		{ ETHTOOL_A_COALESCE_STATS_BLOCK_USECS,	offsetof(ni_ethtool_coalesce_t, stats_block_usecs)	},
+		{ ETHTOOL_A_COALESCE_TX_USECS,		offsetof(ni_ethtool_coalesce_t, tx_usecs)		},
+		{ ETHTOOL_A_COALESCE_TX_USECS_IRQ,	offsetof(ni_ethtool_coalesce_t, tx_usecs_irq)		},
+		{ ETHTOOL_A_COALESCE_TX_USECS_LOW,	offsetof(ni_ethtool_coalesce_t, tx_usecs_low)		},
+		{ ETHTOOL_A_COALESCE_TX_USECS_HIGH,	offsetof(ni_ethtool_coalesce_t, tx_usecs_high)		},
+		{ ETHTOOL_A_COALESCE_TX_MAX_FRAMES,	offsetof(ni_ethtool_coalesce_t, tx_frames)		},
+		{ ETHTOOL_A_COALESCE_TX_MAX_FRAMES_IRQ,	offsetof(ni_ethtool_coalesce_t, tx_frames_irq)		},
+		{ ETHTOOL_A_COALESCE_TX_MAX_FRAMES_LOW,	offsetof(ni_ethtool_coalesce_t, tx_frames_low)		},
+		{ ETHTOOL_A_COALESCE_TX_MAX_FRAMES_HIGH, offsetof(ni_ethtool_coalesce_t, tx_frames_high)	},
+		{ ETHTOOL_A_COALESCE_RX_USECS,		offsetof(ni_ethtool_coalesce_t, rx_usecs)		},
+		{ ETHTOOL_A_COALESCE_RX_USECS_IRQ,	offsetof(ni_ethtool_coalesce_t, rx_usecs_irq)		},
+		{ ETHTOOL_A_COALESCE_RX_USECS_LOW,	offsetof(ni_ethtool_coalesce_t, rx_usecs_low)		},
+		{ ETHTOOL_A_COALESCE_RX_USECS_HIGH,	offsetof(ni_ethtool_coalesce_t, rx_usecs_high)		},
+		{ ETHTOOL_A_COALESCE_RX_MAX_FRAMES,	offsetof(ni_ethtool_coalesce_t, rx_frames)		},
+		{ ETHTOOL_A_COALESCE_RX_MAX_FRAMES_IRQ,	offsetof(ni_ethtool_coalesce_t, rx_frames_irq)		},
+		{ ETHTOOL_A_COALESCE_RX_MAX_FRAMES_LOW,	offsetof(ni_ethtool_coalesce_t, rx_frames_low)		},
+		{ ETHTOOL_A_COALESCE_RX_MAX_FRAMES_HIGH, offsetof(ni_ethtool_coalesce_t, rx_frames_high)	},
+	};
+	ni_ethtool_coalesce_t *coalesce;
+	unsigned int i;
+
+	(void)ifname;
+	ni_ethtool_nl_reset_coalesce(ethtool);
+	if (!(coalesce = ni_ethtool_coalesce_new()))
+		return -1;
+
+	ni_ethtool_nl_get_tristate(tb[ETHTOOL_A_COALESCE_USE_ADAPTIVE_TX], &coalesce->adaptive_tx);
+	ni_ethtool_nl_get_tristate(tb[ETHTOOL_A_COALESCE_USE_ADAPTIVE_RX], &coalesce->adaptive_rx);
+	for (i = 0; i < sizeof(map)/sizeof(map[0]); ++i) {
+		unsigned int *val = (unsigned int *)((char *)coalesce + map[i].offset);
+
+		*val = ni_ethtool_nl_get_uint(tb[map[i].attr]);
+	}
+
+	ethtool->coalesce = coalesce;
+	return 0;
+}
+
+static void
+ni_ethtool_nl_reset_pause(ni_ethtool_t *ethtool)
+{
+	ni_ethtool_pause_free(ethtool->pause);
+	ethtool->pause = NULL;
+}
+
+static int
+ni_ethtool_nl_parse_pause(const char *ifname, ni_ethtool_t *ethtool, struct nlattr **tb)
+{
+	ni_ethtool_pause_t *pause;
+
+	(void)ifname;
+	ni_ethtool_nl_reset_pause(ethtool);
+	if (!(pause = ni_ethtool_pause_new()))
+		return -1;
+
+	ni_ethtool_nl_get_tristate(tb[ETHTOOL_A_PAUSE_TX],      &pause->tx);
+	ni_ethtool_nl_get_tristate(tb[ETHTOOL_A_PAUSE_RX],      &pause->rx);
+	ni_ethtool_nl_get_tristate(tb[ETHTOOL_A_PAUSE_AUTONEG], &pause->autoneg);
+
+	ethtool->pause = pause;
+	return 0;
+}
+
+static void
+ni_ethtool_nl_reset_eee(ni_ethtool_t *ethtool)
+{
+	ni_ethtool_eee_free(ethtool->eee);
+	ethtool->eee = NULL;
+}
+
+static int
+ni_ethtool_nl_parse_eee(const char *ifname, ni_ethtool_t *ethtool, struct nlattr **tb)
+{
+	uint32_t advertised = 0, supported = 0, lp_advertised = 0;
+	ni_ethtool_eee_t *eee;
+	uint32_t timer = 0;
+
+	(void)ifname;
+	/* the legacy u32 link mode bits, as provided by ETHTOOL_GEEE */
+	ni_ethtool_nl_bitset_get(tb[ETHTOOL_A_EEE_MODES_OURS], 32, &advertised, &supported, NULL);
+	ni_ethtool_nl_bitset_get(tb[ETHTOOL_A_EEE_MODES_PEER], 32, &lp_advertised, NULL, NULL);
+
+	ni_ethtool_nl_reset_eee(ethtool);
+	if (!(eee = ni_ethtool_eee_new()))
+		return -1;
+
+	ni_ethtool_nl_get_tristate(tb[ETHTOOL_A_EEE_ENABLED], &eee->status.enabled);
+	ni_ethtool_nl_get_tristate(tb[ETHTOOL_A_EEE_ACTIVE],  &eee->status.active);
+	ni_ethtool_nl_get_tristate(tb[ETHTOOL_A_EEE_TX_LPI_ENABLED], &eee->tx_lpi.enabled);
+	if (ni_ethtool_nl_get_u32(tb[ETHTOOL_A_EEE_TX_LPI_TIMER], &timer))
+		eee->tx_lpi.timer = timer;
+
+	ni_bitfield_set_data(&eee->speed.supported,      &supported,     sizeof(supported));
+	ni_bitfield_set_data(&eee->speed.advertising,    &advertised,    sizeof(advertised));
+	ni_bitfield_set_data(&eee->speed.lp_advertising, &lp_advertised, sizeof(lp_advertised));
+
+	ethtool->eee = eee;
+	return 0;
+}
+
+static const ni_ethtool_nl_cmd_t	ni_ethtool_nl_cmds[] = {
+	{
+		"link-state",
+		ETHTOOL_MSG_LINKSTATE_GET, ETHTOOL_MSG_LINKSTATE_GET_REPLY, 0,
+		NI_ETHTOOL_SUPP_GET_LINK_DETECTED, ETHTOOL_FLAG_COMPACT_BITSETS,
+		ETHTOOL_A_LINKSTATE_MAX,
+		ni_ethtool_nl_reset_linkstate, ni_ethtool_nl_parse_linkstate
+	},
+	{
+		"wake-on-lan",
+		ETHTOOL_MSG_WOL_GET, ETHTOOL_MSG_WOL_GET_REPLY, ETHTOOL_MSG_WOL_NTF,
+		NI_ETHTOOL_SUPP_GET_WAKE_ON_LAN, ETHTOOL_FLAG_COMPACT_BITSETS,
+		ETHTOOL_A_WOL_MAX,
+		ni_ethtool_nl_reset_wol, ni_ethtool_nl_parse_wol
+	},
+	{	/* verbose, we need the feature names */
+		"features",
+		ETHTOOL_MSG_FEATURES_GET, ETHTOOL_MSG_FEATURES_GET_REPLY, ETHTOOL_MSG_FEATURES_NTF,
+		NI_ETHTOOL_SUPP_GET_FEATURES, 0,
+		ETHTOOL_A_FEATURES_MAX,
+		NULL, ni_ethtool_nl_parse_features
+	},
+	{	/* verbose, we need the flag names */
+		"priv-flags",
+		ETHTOOL_MSG_PRIVFLAGS_GET, ETHTOOL_MSG_PRIVFLAGS_GET_REPLY, ETHTOOL_MSG_PRIVFLAGS_NTF,
+		NI_ETHTOOL_SUPP_GET_PRIV_FLAGS, 0,
+		ETHTOOL_A_PRIVFLAGS_MAX,
+		ni_ethtool_nl_reset_priv_flags, ni_ethtool_nl_parse_priv_flags
+	},
+	{
+		"ring",
+		ETHTOOL_MSG_RINGS_GET, ETHTOOL_MSG_RINGS_GET_REPLY, ETHTOOL_MSG_RINGS_NTF,
+		NI_ETHTOOL_SUPP_GET_RING, ETHTOOL_FLAG_COMPACT_BITSETS,
+		ETHTOOL_A_RINGS_MAX,
+		ni_ethtool_nl_reset_ring, ni_ethtool_nl_parse_ring
+	},
+	{
+		"channels",
+		ETHTOOL_MSG_CHANNELS_GET, ETHTOOL_MSG_CHANNELS_GET_REPLY, ETHTOOL_MSG_CHANNELS_NTF,
+		NI_ETHTOOL_SUPP_GET_CHANNELS, ETHTOOL_FLAG_COMPACT_BITSETS,
+		ETHTOOL_A_CHANNELS_MAX,
+		ni_ethtool_nl_reset_channels, ni_ethtool_nl_parse_channels
+	},
+	{
+		"coalesce",
+		ETHTOOL_MSG_COALESCE_GET, ETHTOOL_MSG_COALESCE_GET_REPLY, ETHTOOL_MSG_COALESCE_NTF,
+		NI_ETHTOOL_SUPP_GET_COALESCE, ETHTOOL_FLAG_COMPACT_BITSETS,
+		ETHTOOL_A_COALESCE_MAX,
+		ni_ethtool_nl_reset_coalesce, ni_ethtool_nl_parse_coalesce
+	},
+	{
+		"pause",
+		ETHTOOL_MSG_PAUSE_GET, ETHTOOL_MSG_PAUSE_GET_REPLY, ETHTOOL_MSG_PAUSE_NTF,
+		NI_ETHTOOL_SUPP_GET_PAUSE, ETHTOOL_FLAG_COMPACT_BITSETS,
+		ETHTOOL_A_PAUSE_MAX,
+		ni_ethtool_nl_reset_pause, ni_ethtool_nl_parse_pause
+	},
+	{
+		"eee",
+		ETHTOOL_MSG_EEE_GET, ETHTOOL_MSG_EEE_GET_REPLY, ETHTOOL_MSG_EEE_NTF,
+		NI_ETHTOOL_SUPP_GET_EEE, ETHTOOL_FLAG_COMPACT_BITSETS,
+		ETHTOOL_A_EEE_MAX,
+		ni_ethtool_nl_reset_eee, ni_ethtool_nl_parse_eee
+	},
+	{
+		NULL, 0, 0, 0, 0, 0, 0, NULL, NULL
+	}
+};
+
+static const ni_ethtool_nl_cmd_t *
+ni_ethtool_nl_cmd_by_msg(uint8_t type)
+{
+	const ni_ethtool_nl_cmd_t *cmd;
+
+	for (cmd = ni_ethtool_nl_cmds; cmd->name; ++cmd) {
+		if (cmd->reply == type || (cmd->ntf && cmd->ntf == type))
+			return cmd;
+	}
+	return NULL;
+}
+
+/*
+ * Parse a reply or notification message; all categories use the
+ * same header nest attribute number (ETHTOOL_A_*_HEADER == 1).
+ */
+static int
+ni_ethtool_nl_process(struct nl_msg *msg, const ni_ethtool_nl_cmd_t *cmd,
+		ni_netconfig_t *nc, ni_netdev_t *dev)
+{
+	struct nlattr *tb[NI_ETHTOOL_NL_ATTR_MAX + 1];
+	struct nlattr *hb[ETHTOOL_A_HEADER_MAX + 1];
+	struct nlmsghdr *nlh = nlmsg_hdr(msg);
+	uint32_t ifindex = 0;
+	int maxattr;
+
+	maxattr = min_t(int, cmd->maxattr, NI_ETHTOOL_NL_ATTR_MAX);
+	if (nlmsg_parse(nlh, GENL_HDRLEN, tb, maxattr, NULL) < 0 ||
+	    !tb[ETHTOOL_A_LINKSTATE_HEADER])
+		return -1;
+
+	if (nla_parse_nested(hb, ETHTOOL_A_HEADER_MAX, tb[ETHTOOL_A_LINKSTATE_HEADER], NULL) < 0 ||
+	    !ni_ethtool_nl_get_u32(hb[ETHTOOL_A_HEADER_DEV_INDEX], &ifindex))
+		return -1;
+
+	if (dev && dev->link.ifindex != ifindex)
+		return -1;
+	if (!dev && (!nc || !(dev = ni_netdev_by_index(nc, ifindex))))
+		return 0;
+	if (!dev->ethtool)
+		return 0;
+
+	ni_debug_verbose(NI_LOG_DEBUG2, NI_TRACE_IFCONFIG,
+			"%s: get ethtool %s via netlink", dev->name, cmd->name);
+	return cmd->parse(dev->name, dev->ethtool, tb);
+}
+
+static int
+ni_ethtool_nl_reply(struct nl_msg *msg, void *user_data)
+{
+	ni_ethtool_nl_request_t *req = user_data;
+	struct genlmsghdr *ghdr = nlmsg_data(nlmsg_hdr(msg));
+
+	if (!nlmsg_valid_hdr(nlmsg_hdr(msg), GENL_HDRLEN) || ghdr->cmd != req->cmd->reply)
+		return NL_SKIP;
+
+	if (ni_ethtool_nl_process(msg, req->cmd, req->nc, req->dev) == 0)
+		req->count++;
+	return NL_OK;
+}
+
+static struct nl_msg *
+ni_ethtool_nl_request(const ni_ethtool_nl_cmd_t *cmd, int flags, unsigned int ifindex)
+{
+	struct genlmsghdr ghdr;
+	struct nlattr *nest;
+	struct nl_msg *msg;
+
+	memset(&ghdr, 0, sizeof(ghdr));
+	ghdr.cmd = cmd->get;
+	ghdr.version = ETHTOOL_GENL_VERSION;
+
+	if (!(msg = nlmsg_alloc_simple(ni_ethtool_nl.family, NLM_F_REQUEST | flags)))
+		return NULL;
+
+	if (nlmsg_append(msg, &ghdr, sizeof(ghdr), NLMSG_ALIGNTO) < 0)
+		goto nla_put_failure;
+
+	if (!(nest = nla_nest_start(msg, ETHTOOL_A_LINKSTATE_HEADER | NLA_F_NESTED)))
+		goto nla_put_failure;
+	if (ifindex)
+		NLA_PUT_U32(msg, ETHTOOL_A_HEADER_DEV_INDEX, ifindex);
+	if (cmd->flags)
+		NLA_PUT_U32(msg, ETHTOOL_A_HEADER_FLAGS, cmd->flags);
+	nla_nest_end(msg, nest);
+
+	return msg;
+
+nla_put_failure:
+	nlmsg_free(msg);
+	return NULL;
+}
+
+static int
+ni_ethtool_nl_get(ni_netdev_t *dev, const ni_ethtool_nl_cmd_t *cmd)
+{
+	ni_ethtool_nl_request_t req;
+	struct nl_msg *msg;
+	int ret;
+
+	if (!(msg = ni_ethtool_nl_request(cmd, 0, dev->link.ifindex)))
+		return -ENOMEM;
+
+	memset(&req, 0, sizeof(req));
+	req.cmd = cmd;
+	req.dev = dev;
+	ret = ni_ethtool_nl_talk(msg, ni_ethtool_nl_reply, &req);
+	nlmsg_free(msg);
+
+	if (ret < 0)
+		ni_debug_verbose(NI_LOG_DEBUG2, NI_TRACE_IFCONFIG,
+				"%s: get ethtool %s via netlink failed: %s",
+				dev->name, cmd->name, strerror(-ret));
+	return ret;
+}
+
+static int
+ni_ethtool_nl_dump(ni_netconfig_t *nc, const ni_ethtool_nl_cmd_t *cmd)
+{
+	ni_ethtool_nl_request_t req;
+	struct nl_msg *msg;
+	int ret;
+
+	if (!(msg = ni_ethtool_nl_request(cmd, NLM_F_DUMP, 0)))
+		return -ENOMEM;
+
+	memset(&req, 0, sizeof(req));
+	req.cmd = cmd;
+	req.nc = nc;
+	ret = ni_ethtool_nl_talk(msg, ni_ethtool_nl_reply, &req);
+	nlmsg_free(msg);
+
+	ni_debug_verbose(NI_LOG_DEBUG1, NI_TRACE_IFCONFIG,
+			"ethtool %s netlink dump: %u devices%s", cmd->name,
+			req.count, ret < 0 ? " (failed)" : "");
+	return ret;
+}
+
+static inline ni_bool_t
+ni_ethtool_nl_batch_device(ni_netdev_t *dev)
+{
+	return dev->ethtool && dev->link.ifindex && ni_netdev_device_is_ready(dev);
+}
+
+/*
+ * Refresh the netlink categories of a device; returns -1 when
+ * netlink is unavailable and the ioctl interface has to be used.
+ */
+static int
+ni_ethtool_nl_refresh(ni_netdev_t *dev, ni_ethtool_t *ethtool)
+{
+	const ni_ethtool_nl_cmd_t *cmd;
+	ni_bool_t monitored;
+	int ret;
+
+	if (!ni_ethtool_nl_open())
+		return -1;
+
+	/* deferred to the dump in ni_system_ethtool_refresh_end */
+	if (ni_ethtool_nl.batch)
+		return 0;
+
+	monitored = ni_bitfield_testbit(&ethtool->supported, NI_ETHTOOL_NETLINK_MONITORED);
+	for (cmd = ni_ethtool_nl_cmds; cmd->name; ++cmd) {
+		if (monitored && cmd->ntf)
+			continue;
+		if (!ni_ethtool_supported(ethtool, cmd->supp))
+			continue;
+
+		if (cmd->reset)
+			cmd->reset(ethtool);
+
+		ret = ni_ethtool_nl_get(dev, cmd);
+		if (ret == -EOPNOTSUPP)
+			ni_ethtool_set_supported(ethtool, cmd->supp, FALSE);
+	}
+
+	ni_bitfield_turnbit(&ethtool->supported, NI_ETHTOOL_NETLINK_MONITORED,
+				ni_ethtool_nl.sock != NULL);
+	return 0;
+}
+
+ni_bool_t
+ni_system_ethtool_refresh_begin(void)
+{
+	if (!ni_ethtool_nl_open())
+		return FALSE;
+
+	ni_ethtool_nl.batch = TRUE;
+	return TRUE;
+}
+
+void
+ni_system_ethtool_refresh_end(ni_netconfig_t *nc)
+{
+	const ni_ethtool_nl_cmd_t *cmd;
+	ni_netdev_t *dev;
+
+	if (!ni_ethtool_nl.batch)
+		return;
+	ni_ethtool_nl.batch = FALSE;
+
+	for (cmd = ni_ethtool_nl_cmds; cmd->name; ++cmd) {
+		for (dev = ni_netconfig_devlist(nc); dev; dev = dev->next) {
+			if (!ni_ethtool_nl_batch_device(dev) || !cmd->reset)
+				continue;
+			if (ni_ethtool_supported(dev->ethtool, cmd->supp))
+				cmd->reset(dev->ethtool);
+		}
+		ni_ethtool_nl_dump(nc, cmd);
+	}
+
+	for (dev = ni_netconfig_devlist(nc); dev; dev = dev->next) {
+		if (!ni_ethtool_nl_batch_device(dev))
+			continue;
+		ni_bitfield_turnbit(&dev->ethtool->supported, NI_ETHTOOL_NETLINK_MONITORED,
+					ni_ethtool_nl.sock != NULL);
+	}
+}
+
+/*
+ * ethtool netlink monitor events
+ */
+static void
+ni_ethtool_nl_monitor_reset(void)
+{
+	ni_netconfig_t *nc = ni_global_state_handle(0);
+	ni_netdev_t *dev;
+
+	for (dev = ni_netconfig_devlist(nc); dev; dev = dev->next) {
+		if (dev->ethtool)
+			ni_bitfield_turnbit(&dev->ethtool->supported,
+					NI_ETHTOOL_NETLINK_MONITORED, FALSE);
+	}
+}
+
+static int
+ni_ethtool_nl_event(struct nl_msg *msg, void *user_data)
+{
+	struct nlmsghdr *nlh = nlmsg_hdr(msg);
+	const ni_ethtool_nl_cmd_t *cmd;
+	struct genlmsghdr *ghdr;
+
+	(void)user_data;
+	if (!nlmsg_valid_hdr(nlh, GENL_HDRLEN) || nlh->nlmsg_type != ni_ethtool_nl.family)
+		return NL_SKIP;
+
+	ghdr = nlmsg_data(nlh);
+	if (!(cmd = ni_ethtool_nl_cmd_by_msg(ghdr->cmd)) || cmd->ntf != ghdr->cmd)
+		return NL_SKIP;
+
+	ni_ethtool_nl_process(msg, cmd, ni_global_state_handle(0), NULL);
+	return NL_OK;
+}
+
+static void
+ni_ethtool_nl_event_receive(ni_socket_t *sock)
+{
+	struct nl_sock *nlsock = sock->user_data;
+	int ret;
+
+	if (!nlsock)
+		return;
+
+	do {
+		ret = nl_recvmsgs_default(nlsock);
+	} while (ret == NLE_SUCCESS || ret == -NLE_INTR);
+
+	if (ret != NLE_SUCCESS && ret != -NLE_AGAIN) {
+		/* events lost, refresh needs to query everything again */
+		ni_error("ethtool netlink event receive error: %s (%m)", nl_geterror(ret));
+		ni_ethtool_nl_monitor_reset();
+	}
+}
+
+static void
+ni_ethtool_nl_event_close(ni_socket_t *sock)
+{
+	struct nl_sock *nlsock = sock->user_data;
+
+	if (nlsock)
+		nl_socket_free(nlsock);
+	sock->user_data = NULL;
+	if (ni_ethtool_nl.sock == sock) {
+		ni_ethtool_nl.sock = NULL;
+		ni_ethtool_nl_monitor_reset();
+	}
+}
+
+int
+ni_server_enable_ethtool_events(void)
+{
+	struct nl_sock *nlsock;
+	ni_socket_t *sock;
+	int ret;
+
+	if (ni_ethtool_nl.sock)
+		return 0;
+
+	if (!ni_ethtool_nl_open() || !ni_ethtool_nl.monitor)
+		return -1;
+
+	if (!(nlsock = nl_socket_alloc())) {
+		ni_error("Cannot allocate ethtool netlink event socket: %m");
+		return -1;
+	}
+
+	nl_socket_modify_cb(nlsock, NL_CB_VALID, NL_CB_CUSTOM, ni_ethtool_nl_event, NULL);
+	nl_socket_disable_seq_check(nlsock);
+
+	if ((ret = nl_connect(nlsock, NETLINK_GENERIC)) < 0 ||
+	    (ret = nl_socket_add_membership(nlsock, ni_ethtool_nl.monitor)) < 0) {
+		ni_error("Cannot open ethtool netlink monitor: %s", nl_geterror(ret));
+		nl_socket_free(nlsock);
+		return -1;
+	}
+	nl_socket_set_nonblocking(nlsock);
+
+	if (!(sock = ni_socket_wrap(nl_socket_get_fd(nlsock), SOCK_DGRAM))) {
+		ni_error("Cannot wrap ethtool netlink event socket: %m");
+		nl_socket_free(nlsock);
+		return -1;
+	}
+
+	sock->user_data	= nlsock;
+	sock->receive	= ni_ethtool_nl_event_receive;
+	sock->close	= ni_ethtool_nl_event_close;
+
+	ni_ethtool_nl.sock = sock;
+	ni_socket_activate(sock);
+	return 0;
+}
+
+#else
+static inline int
+ni_ethtool_nl_refresh(ni_netdev_t *dev, ni_ethtool_t *ethtool)
+{
+	(void)dev;
+	(void)ethtool;
+	return -1;
+}
+
+ni_bool_t
+ni_system_ethtool_refresh_begin(void)
+{
+	return FALSE;
+}
+
+void
+ni_system_ethtool_refresh_end(ni_netconfig_t *nc)
+{
+	(void)nc;
+}
+
+int
+ni_server_enable_ethtool_events(void)
+{
+	return -1;
+}
+#endif
+
+/*
+ * main system refresh and setup functions
+ */
+static ni_bool_t
+ni_ethtool_refresh(ni_netdev_t *dev)
+{
+	ni_ethtool_t *ethtool;
+	ni_netdev_ref_t ref;
+
+	if (!dev || !(ethtool = ni_netdev_get_ethtool(dev)))
+		return FALSE;
+
+	ref.name = dev->name;
+	ref.index = dev->link.ifindex;
+	if (!ethtool->driver_info)
+		ni_ethtool_get_driver_info(&ref, ethtool);
+	ni_ethtool_get_link_settings(&ref, ethtool);
+	if (ni_ethtool_nl_refresh(dev, ethtool) == 0)
+		return TRUE;
+
+	ni_ethtool_get_priv_flags(&ref, ethtool);
+	ni_ethtool_get_link_detected(&ref, ethtool);
+	ni_ethtool_get_wake_on_lan(&ref, ethtool);
+	ni_ethtool_get_features(&ref, ethtool, FALSE);
+	ni_ethtool_get_eee(&ref, ethtool);
+	ni_ethtool_get_ring(&ref, ethtool);
+	ni_ethtool_get_channels(&ref, ethtool);
+	ni_ethtool_get_coalesce(&ref, ethtool);
+	ni_ethtool_get_pause(&ref, ethtool);
+
+	return TRUE;
+}
+
+void
+ni_system_ethtool_refresh(ni_netdev_t *dev)
+{
+	if (!ni_netdev_device_is_ready(dev) || !dev->link.ifindex)
+		return;
+
+	ni_ethtool_refresh(dev);
+}
+
+int
+ni_system_ethtool_setup(ni_netconfig_t *nc, ni_netdev_t *dev, const ni_netdev_t *cfg)
+{
+	ni_netdev_ref_t ref;
+
+	if (!ni_netdev_device_is_ready(dev) || !dev->link.ifindex)
+		return -1;
+
+	if (!dev->ethtool && !ni_ethtool_refresh(dev))
+		return -1;
+
+	ref.name = dev->name;
+	ref.index = dev->link.ifindex;
+	if (cfg && cfg->ethtool) {
+		ni_ethtool_set_priv_flags(&ref, dev->ethtool, cfg->ethtool->priv_flags);
 		ni_ethtool_set_link_settings(&ref, dev->ethtool, cfg->ethtool->link_settings);
 		ni_ethtool_set_wake_on_lan(&ref, dev->ethtool, cfg->ethtool->wake_on_lan);
 		ni_ethtool_set_features(&ref, dev->ethtool, cfg->ethtool->features);
@@ -3668,6 +4733,10 @@ ni_system_ethtool_setup(ni_netconfig_t *nc, ni_netdev_t *dev, const ni_netdev_t
 		ni_ethtool_set_channels(&ref, dev->ethtool, cfg->ethtool->channels);
 		ni_ethtool_set_coalesce(&ref, dev->ethtool, cfg->ethtool->coalesce);
 		ni_ethtool_set_pause(&ref, dev->ethtool, cfg->ethtool->pause);
+
+		/* don't wait for the monitor events of our changes */
+		ni_bitfield_turnbit(&dev->ethtool->supported,
+				NI_ETHTOOL_NETLINK_MONITORED, FALSE);
 		ni_ethtool_refresh(dev);
 	}
 	return 0;
@@ -3690,6 +4759,7 @@ ni_ethtool_free(ni_ethtool_t *ethtool)
 		ni_ethtool_ring_free(ethtool->ring);
 		ni_ethtool_channels_free(ethtool->channels);
 		ni_ethtool_coalesce_free(ethtool->coalesce);
+		ni_ethtool_pause_free(ethtool->pause);
 		free(ethtool);
 	}
 }
@@ -10,15 +10,46 @@
 
 #include <stdlib.h>
 #include <unistd.h>
+#include <errno.h>
+#include <poll.h>
 #include <sys/wait.h>
+#include <sys/socket.h>
 #include <limits.h>
 
 #include <wicked/netinfo.h>
 #include <wicked/addrconf.h>
 #include <wicked/xpath.h>
+#include <wicked/xml.h>
 #include "netinfo_priv.h"
+#include "socket_priv.h"
 #include "appconfig.h"
 #include "process.h"
+#include "buffer.h"
+
+/* max size of a single worker reply */
+#ifndef NI_EXTENSION_WORKER_FRAME_MAX
+#define NI_EXTENSION_WORKER_FRAME_MAX	(16 * 1024 * 1024)
+#endif
+/* worker exits in a row before we fall back to scripts */
+#ifndef NI_EXTENSION_WORKER_FAILURES
+#define NI_EXTENSION_WORKER_FAILURES	3
+#endif
+
+typedef struct ni_extension_worker_call	ni_extension_worker_call_t;
+
+struct ni_extension_worker_call {
+	ni_extension_worker_call_t *	next;
+	unsigned int			id;
+	ni_extension_worker_callback_t *callback;
+	void *				user_data;
+};
+
+struct ni_extension_worker {
+	ni_process_t *			process;
+	unsigned int			next_id;
+	unsigned int			failures;
+	ni_extension_worker_call_t *	calls;
+};
 
 static void		__ni_script_action_free(ni_script_action_t *);
 
@@ -47,6 +78,12 @@ ni_extension_free(ni_extension_t *ex)
 	ni_script_action_t *act;
 	ni_c_binding_t *binding;
 
+	ni_extension_worker_stop(ex);
+	free(ex->worker);
+	ex->worker = NULL;
+	ni_shellcmd_release(ex->worker_cmd);
+	ex->worker_cmd = NULL;
+
 	ni_string_free(&ex->name);
 	ni_string_free(&ex->interface);
 
@@ -63,6 +100,7 @@ ni_extension_free(ni_extension_t *ex)
 	}
 
 	ni_var_array_destroy(&ex->environment);
+	free(ex);
 }
 
 /*
@@ -184,3 +222,351 @@ ni_extension_find_c_binding(const ni_extension_t *extension, const char *name)
 	}
 	return NULL;
 }
+
+/*
+ * Persistent extension workers.
+ *
+ * Instead of running an action script for every call, the worker command
+ * is started once and serves all calls over a socket pair connected to
+ * its stdin and stdout. Each request and reply is an XML document, which
+ * is preceded by a line with its length in bytes:
+ *
+ *   <length>\n<call id="1" interface="..." method="..." object-path="...">
+ *     <environment> <putenv name="..." value="..."/> ... </environment>
+ *     <arguments> ... </arguments>
+ *   </call>
+ *
+ *   <length>\n<reply id="1" status="0"> <return> ... </return> </reply>
+ *
+ * The reply children are the same as in the WICKED_RETFILE of a script.
+ * Several calls may be in flight and the replies may arrive in any order.
+ */
+static void
+ni_extension_worker_fail_calls(ni_extension_worker_t *worker)
+{
+	ni_extension_worker_call_t *call;
+
+	while ((call = worker->calls) != NULL) {
+		worker->calls = call->next;
+		call->callback(call->user_data, NULL);
+		free(call);
+	}
+}
+
+static ni_extension_worker_call_t *
+ni_extension_worker_take_call(ni_extension_worker_t *worker, unsigned int id)
+{
+	ni_extension_worker_call_t **pos, *call;
+
+	for (pos = &worker->calls; (call = *pos); pos = &call->next) {
+		if (call->id == id) {
+			*pos = call->next;
+			call->next = NULL;
+			return call;
+		}
+	}
+	return NULL;
+}
+
+/*
+ * Process the next reply frame in the receive buffer.
+ * Returns 1 when a frame has been consumed, 0 when more data is
+ * needed and -1 on protocol errors.
+ */
+static int
+ni_extension_worker_process_reply(ni_extension_t *ex, ni_buffer_t *rbuf)
+{
+	ni_extension_worker_t *worker = ex->worker;
+	ni_extension_worker_call_t *call;
+	unsigned long len;
+	const char *head;
+	char *nl, *end;
+	xml_document_t *doc;
+	xml_node_t *reply;
+	unsigned int id;
+	ni_buffer_t buf;
+	size_t count;
+
+	head = ni_buffer_head(rbuf);
+	count = ni_buffer_count(rbuf);
+	if (!(nl = memchr(head, '\n', count < 16 ? count : 16)))
+		return count < 16 ? 0 : -1;
+
+	len = strtoul(head, &end, 10);
+	if (end == head || end != nl || len > NI_EXTENSION_WORKER_FRAME_MAX)
+		return -1;
+
+	count -= nl + 1 - head;
+	if (count < len)
+		return 0;
+
+	ni_buffer_init_reader(&buf, nl + 1, len);
+	doc = xml_document_from_buffer(&buf, ex->name);
+	rbuf->head += nl + 1 - head + len;
+
+	reply = doc ? xml_node_get_child(xml_document_root(doc), "reply") : NULL;
+	if (!reply || !xml_node_get_attr_uint(reply, "id", &id)) {
+		xml_document_free(doc);
+		return -1;
+	}
+
+	if ((call = ni_extension_worker_take_call(worker, id))) {
+		worker->failures = 0;
+		call->callback(call->user_data, reply);
+		free(call);
+	} else {
+		ni_warn("%s: extension worker reply to unknown call id %u",
+				ex->name, id);
+	}
+
+	xml_document_free(doc);
+	return 1;
+}
+
+/*
+ * Stop a failed worker; it is restarted on the next call until
+ * it failed too often in a row.
+ */
+static void
+ni_extension_worker_abort(ni_extension_t *ex)
+{
+	if (++ex->worker->failures >= NI_EXTENSION_WORKER_FAILURES)
+		ni_warn("%s: disabling extension worker, using action scripts", ex->name);
+	ni_extension_worker_stop(ex);
+}
+
+static void
+ni_extension_worker_recv(ni_socket_t *sock)
+{
+	ni_process_t *pi = sock->user_data;
+	ni_buffer_t *rbuf = &sock->rbuf;
+	ni_extension_t *ex;
+	int cnt, ret;
+
+	if (!pi || !(ex = pi->user_data) || !ex->worker)
+		return;
+
+	if (ni_buffer_tailroom(rbuf) < 4096)
+		ni_buffer_ensure_tailroom(rbuf, 4096);
+
+	cnt = recv(sock->__fd, ni_buffer_tail(rbuf), ni_buffer_tailroom(rbuf), MSG_DONTWAIT);
+	if (cnt < 0) {
+		if (errno == EWOULDBLOCK)
+			return;
+		ni_error("%s: read error on extension worker socket: %m", ex->name);
+		ni_extension_worker_abort(ex);
+		return;
+	}
+	if (cnt == 0) {
+		/* the socket stays readable at EOF, so don't keep polling it */
+		ni_warn("%s: extension worker %s (pid %d) closed its socket",
+				ex->name, pi->process->command, pi->pid);
+		ni_extension_worker_abort(ex);
+		return;
+	}
+	rbuf->tail += cnt;
+
+	while ((ret = ni_extension_worker_process_reply(ex, rbuf)) > 0) {
+		/* the callbacks may have stopped the worker */
+		if (!ex->worker || ex->worker->process != pi)
+			return;
+	}
+	if (ret < 0) {
+		ni_error("%s: invalid reply from extension worker %s",
+				ex->name, pi->process->command);
+		ni_extension_worker_abort(ex);
+		return;
+	}
+
+	/* move an incomplete frame to the buffer start */
+	if (rbuf->head) {
+		size_t count = ni_buffer_count(rbuf);
+
+		memmove(rbuf->base, ni_buffer_head(rbuf), count);
+		rbuf->head = 0;
+		rbuf->tail = count;
+	}
+}
+
+static void
+ni_extension_worker_xmit(ni_socket_t *sock)
+{
+	ni_process_t *pi = sock->user_data;
+	ni_buffer_t *wbuf = &sock->wbuf;
+	int cnt;
+
+	if (ni_buffer_count(wbuf)) {
+		cnt = send(sock->__fd, ni_buffer_head(wbuf), ni_buffer_count(wbuf),
+				MSG_DONTWAIT | MSG_NOSIGNAL);
+		if (cnt < 0) {
+			if (errno == EWOULDBLOCK)
+				return;
+			ni_error("write error on extension worker socket: %m");
+			if (pi && pi->user_data)
+				ni_extension_worker_abort(pi->user_data);
+			return;
+		}
+		wbuf->head += cnt;
+	}
+
+	if (!ni_buffer_count(wbuf)) {
+		ni_buffer_clear(wbuf);
+		sock->poll_flags &= ~POLLOUT;
+	}
+}
+
+static void
+ni_extension_worker_error(ni_socket_t *sock)
+{
+	ni_process_t *pi = sock->user_data;
+	ni_extension_t *ex;
+
+	if (!pi || !(ex = pi->user_data) || !ex->worker)
+		return;
+
+	/* e.g. a reset when the worker died with unread calls */
+	ni_error("%s: error on extension worker %s (pid %d) socket",
+			ex->name, pi->process->command, pi->pid);
+	ni_extension_worker_abort(ex);
+}
+
+static void
+ni_extension_worker_exit(ni_process_t *pi)
+{
+	ni_extension_t *ex = pi->user_data;
+	ni_extension_worker_t *worker;
+
+	if (!ex || !(worker = ex->worker) || worker->process != pi)
+		return;
+
+	pi->user_data = NULL;
+	worker->process = NULL;
+
+	ni_warn("%s: extension worker %s (pid %d) terminated unexpectedly",
+			ex->name, pi->process->command, pi->pid);
+	ni_extension_worker_abort(ex);
+}
+
+static ni_bool_t
+ni_extension_worker_start(ni_extension_t *ex)
+{
+	ni_extension_worker_t *worker = ex->worker;
+	ni_process_t *pi;
+
+	if (worker->failures >= NI_EXTENSION_WORKER_FAILURES)
+		return FALSE;
+
+	if (!(pi = ni_process_new(ex->worker_cmd)))
+		return FALSE;
+
+	pi->duplex = TRUE;
+	if (ni_process_run(pi) != NI_PROCESS_SUCCESS) {
+		ni_process_free(pi);
+		worker->failures++;
+		return FALSE;
+	}
+
+	pi->user_data = ex;
+	pi->notify_callback = ni_extension_worker_exit;
+	pi->socket->receive = ni_extension_worker_recv;
+	pi->socket->transmit = ni_extension_worker_xmit;
+	pi->socket->handle_error = ni_extension_worker_error;
+	worker->process = pi;
+
+	ni_debug_extension("%s: started extension worker %s with pid %d",
+			ex->name, ex->worker_cmd->command, pi->pid);
+	return TRUE;
+}
+
+static ni_bool_t
+ni_extension_worker_send(ni_extension_worker_t *worker, const char *data)
+{
+	ni_socket_t *sock = worker->process->socket;
+	char head[32];
+	size_t hlen, len;
+
+	if (!sock)
+		return FALSE;
+
+	len = ni_string_len(data);
+	hlen = snprintf(head, sizeof(head), "%zu\n", len);
+
+	ni_buffer_ensure_tailroom(&sock->wbuf, hlen + len);
+	if (ni_buffer_put(&sock->wbuf, head, hlen) < 0 ||
+	    ni_buffer_put(&sock->wbuf, data, len) < 0)
+		return FALSE;
+
+	sock->poll_flags |= POLLOUT;
+	return TRUE;
+}
+
+/*
+ * Pass a call request to the extension worker, starting it as needed.
+ * The callback receives the reply node or NULL when the worker failed.
+ * Returns FALSE when there is no usable worker; the caller is expected
+ * to run the action script instead.
+ */
+ni_bool_t
+ni_extension_worker_call(ni_extension_t *ex, xml_node_t *request,
+			ni_extension_worker_callback_t *callback, void *user_data)
+{
+	ni_extension_worker_t *worker;
+	ni_extension_worker_call_t *call;
+	char *data;
+
+	if (!ex || !ex->worker_cmd || !request || !callback)
+		return FALSE;
+
+	if (!ex->worker)
+		ex->worker = xcalloc(1, sizeof(*ex->worker));
+	worker = ex->worker;
+
+	if (!worker->process && !ni_extension_worker_start(ex))
+		return FALSE;
+
+	if (++worker->next_id == 0)
+		worker->next_id = 1;
+	xml_node_del_attr(request, "id");
+	xml_node_add_attr_uint(request, "id", worker->next_id);
+
+	if (!(data = xml_node_sprint(request)))
+		return FALSE;
+
+	if (!ni_extension_worker_send(worker, data)) {
+		free(data);
+		return FALSE;
+	}
+	free(data);
+
+	call = xcalloc(1, sizeof(*call));
+	call->id = worker->next_id;
+	call->callback = callback;
+	call->user_data = user_data;
+	call->next = worker->calls;
+	worker->calls = call;
+
+	ni_debug_extension("%s: passed call %u to extension worker pid %d",
+			ex->name, call->id, worker->process->pid);
+	return TRUE;
+}
+
+/*
+ * Terminate the extension worker and fail all calls in flight.
+ */
+void
+ni_extension_worker_stop(ni_extension_t *ex)
+{
+	ni_extension_worker_t *worker;
+	ni_process_t *pi;
+
+	if (!ex || !(worker = ex->worker))
+		return;
+
+	if ((pi = worker->process)) {
+		worker->process = NULL;
+		pi->user_data = NULL;
+		pi->notify_callback = NULL;
+		ni_process_free(pi);
+	}
+	ni_extension_worker_fail_calls(worker);
+}
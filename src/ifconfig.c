@@ -136,6 +136,9 @@ static int	__ni_rtnl_link_down(const ni_netdev_t *);
 static int	__ni_rtnl_link_delete(const ni_netdev_t *);
 
 static int	__ni_rtnl_link_add_port_up(const ni_netdev_t *, const char *, unsigned int);
+static int	__ni_rtnl_link_create_bridge(const char *);
+static int	__ni_rtnl_link_change_bridge(const ni_netdev_t *, const ni_bridge_t *);
+static int	__ni_rtnl_link_change_bridge_port(const ni_netdev_t *, const ni_bridge_port_t *);
 static int	__ni_rtnl_link_add_slave_down(const ni_netdev_t *, const char *, unsigned int);
 
 static int	__ni_rtnl_send_deladdr(ni_netdev_t *, const ni_address_t *);
@@ -266,7 +269,7 @@ ni_system_interface_enslave(ni_netconfig_t *nc, ni_netdev_t *master, ni_netdev_t
 			return -1;
 		}
 
-		ret = ni_ovs_vsctl_bridge_port_add(dev->name, &req->port->ovsbr, TRUE);
+		ret = ni_ovsdb_bridge_port_add(dev->name, &req->port->ovsbr, TRUE);
 		if (ret == 0)  {
 			ni_netdev_ref_set(&dev->link.masterdev,
 					master->name, master->link.ifindex);
@@ -330,7 +333,7 @@ ni_system_interface_link_change(ni_netdev_t *dev, const ni_netdev_req_t *ifp_req
 			if (master && master->link.type == NI_IFTYPE_OVS_SYSTEM) {
 				if (ifp_req->port && ifp_req->port->type == NI_IFTYPE_OVS_BRIDGE &&
 				    !ni_string_empty(ifp_req->port->ovsbr.bridge.name)) {
-					ni_ovs_vsctl_bridge_port_add(dev->name, &ifp_req->port->ovsbr, TRUE);
+					ni_ovsdb_bridge_port_add(dev->name, &ifp_req->port->ovsbr, TRUE);
 				}
 			}
 
@@ -492,6 +495,8 @@ __ni_addrconf_action_addrs_apply(ni_netdev_t *dev, ni_addrconf_lease_t *lease)
 static int
 __ni_addrconf_action_addrs_verify_check(ni_netdev_t *dev, ni_addrconf_lease_t *lease)
 {
+	ni_address_index_t lease_addrs = NI_ADDRESS_INDEX_INIT;
+	ni_address_index_t dev_addrs = NI_ADDRESS_INDEX_INIT;
 	unsigned int duplicates = 0;
 	unsigned int tentative = 0;
 	unsigned int verified = 0;
@@ -501,6 +506,8 @@ __ni_addrconf_action_addrs_verify_check(ni_netdev_t *dev, ni_addrconf_lease_t *l
 	if (lease->family != AF_INET6)
 		return 0;
 
+	ni_address_index_add_list(&lease_addrs, lease->addrs);
+
 	/*
 	 * returns:
 	 *      1 if lease or link-local addresses are still tentative
@@ -519,7 +526,7 @@ __ni_addrconf_action_addrs_verify_check(ni_netdev_t *dev, ni_addrconf_lease_t *l
 			continue;
 
 		if (ap->owner == NI_ADDRCONF_NONE) {
-			if (!ni_address_list_find(lease->addrs, &ap->local_addr)
+			if (!ni_address_index_find(&lease_addrs, &ap->local_addr, NULL)
 			&&  !ni_address_is_linklocal(ap))
 				continue;
 		} else
@@ -534,7 +541,7 @@ __ni_addrconf_action_addrs_verify_check(ni_netdev_t *dev, ni_addrconf_lease_t *l
 					ni_addrconf_type_to_name(lease->type),
 					ni_sockaddr_print(&ap->local_addr));
 
-			if ((la = ni_address_list_find(lease->addrs, &ap->local_addr)))
+			if ((la = ni_address_index_find(&lease_addrs, &ap->local_addr, NULL)))
 				ni_address_set_duplicate(la, TRUE);
 			else	/* shouldn't happen, ...count it just in case */
 				duplicates++;
@@ -550,9 +557,12 @@ __ni_addrconf_action_addrs_verify_check(ni_netdev_t *dev, ni_addrconf_lease_t *l
 		}
 	}
 
+	ni_address_index_destroy(&lease_addrs);
+
 	if (tentative)
 		return 1;	/*  wait until dad finished for all addresses */
 
+	ni_address_index_add_list(&dev_addrs, dev->addrs);
 	for (la = lease->addrs; la; la = la->next) {
 		if (ni_address_is_duplicate(la)) {
 			ni_warn("%s: lease %s:%s address %s is duplicate",
@@ -562,11 +572,12 @@ __ni_addrconf_action_addrs_verify_check(ni_netdev_t *dev, ni_addrconf_lease_t *l
 					ni_sockaddr_print(&la->local_addr));
 			duplicates++;
 		} else {
-			ap = ni_address_list_find(dev->addrs, &la->local_addr);
+			ap = ni_address_index_find(&dev_addrs, &la->local_addr, NULL);
 			if (ap && !ni_address_is_duplicate(ap))
 				verified++;
 		}
 	}
+	ni_address_index_destroy(&dev_addrs);
 
 	if (duplicates && !verified) {
 		if (lease->type == NI_ADDRCONF_DHCP)
@@ -662,6 +673,7 @@ __ni_addrconf_action_addrs_verify(ni_netdev_t *dev, ni_addrconf_lease_t *lease)
 static int
 __ni_addrconf_action_verify_address_apply(ni_netdev_t *dev, ni_addrconf_lease_t *lease)
 {
+	ni_address_index_t dev_addrs = NI_ADDRESS_INDEX_INIT;
 	unsigned int duplicates = 0;
 	unsigned int verified = 0;
 	const ni_address_t *la, *ap;
@@ -669,15 +681,17 @@ __ni_addrconf_action_verify_address_apply(ni_netdev_t *dev, ni_addrconf_lease_t
 	if (lease->family != AF_INET6)
 		return 0;
 
+	ni_address_index_add_list(&dev_addrs, dev->addrs);
 	for (la = lease->addrs; la; la = la->next) {
 		if (ni_address_is_duplicate(la)) {
 			duplicates++;
 			continue;
 		}
-		ap = ni_address_list_find(dev->addrs, &la->local_addr);
+		ap = ni_address_index_find(&dev_addrs, &la->local_addr, NULL);
 		if (ap && !ni_address_is_duplicate(ap))
 			verified++;
 	}
+	ni_address_index_destroy(&dev_addrs);
 
 	/* when all applied addresses are duplicates, we failed */
 	if (duplicates && !verified) {
@@ -1527,7 +1541,8 @@ ni_system_dummy_create(ni_netconfig_t *nc, const ni_netdev_t *cfg,
 		return -NI_ERROR_DEVICE_EXISTS;
 	}
 
-	if (ni_modprobe(DUMMY_MODULE_NAME, DUMMY_MODULE_OPTS) < 0)
+	/* Not left to kernel autoload: it would create a dummy0 as well */
+	if (ni_modprobe_load(DUMMY_MODULE_NAME, DUMMY_MODULE_OPTS) < 0)
 		ni_warn("failed to load %s network driver module", DUMMY_MODULE_NAME);
 
 	ni_debug_ifconfig("%s: creating dummy interface", cfg->name);
@@ -1709,7 +1724,8 @@ ni_system_bridge_create(ni_netconfig_t *nc, const char *ifname,
 	}
 
 	ni_debug_ifconfig("%s: creating bridge interface", ifname);
-	if (__ni_brioctl_add_bridge(ifname) < 0) {
+	if (__ni_rtnl_link_create_bridge(ifname) < 0 &&
+	    __ni_brioctl_add_bridge(ifname) < 0) {
 		ni_error("__ni_brioctl_add_bridge(%s) failed", ifname);
 		return -1;
 	}
@@ -1732,7 +1748,9 @@ ni_system_bridge_setup(ni_netconfig_t *nc, ni_netdev_t *dev, const ni_bridge_t *
 		return -1;
 	}
 
-	if (ni_sysfs_bridge_update_config(dev->name, bcfg) < 0) {
+	/* kernels without IFLA_BR_* support are configured via sysfs */
+	if (__ni_rtnl_link_change_bridge(dev, bcfg) < 0 &&
+	    ni_sysfs_bridge_update_config(dev->name, bcfg) < 0) {
 		ni_error("%s: failed to update sysfs attributes for %s", __func__, dev->name);
 		return -1;
 	}
@@ -1852,25 +1870,23 @@ ni_system_bridge_add_port(ni_netconfig_t *nc, ni_netdev_t *brdev, const ni_bridg
 		return 0; /* part of the bridge and hopefully up now */
 	}
 
-	if (__ni_rtnl_link_add_port_up(pif, brdev->name, brdev->link.ifindex) == 0) {
-		ni_netdev_ref_set(&pif->link.masterdev, brdev->name,
-				brdev->link.ifindex);
-		return 0;
-	}
-
-	if (!ni_netdev_device_is_up(pif) && __ni_rtnl_link_up(pif, NULL) < 0) {
-		ni_warn("%s: Cannot set up link on bridge port %s",
-			brdev->name, pif->name);
-	}
+	if (__ni_rtnl_link_add_port_up(pif, brdev->name, brdev->link.ifindex) < 0) {
+		if (!ni_netdev_device_is_up(pif) && __ni_rtnl_link_up(pif, NULL) < 0) {
+			ni_warn("%s: Cannot set up link on bridge port %s",
+				brdev->name, pif->name);
+		}
 
-	if ((rv = __ni_brioctl_add_port(brdev->name, pif->link.ifindex)) < 0) {
-		ni_error("%s: cannot add port %s: %s", brdev->name, pif->name,
-				ni_strerror(rv));
-		return rv;
+		if ((rv = __ni_brioctl_add_port(brdev->name, pif->link.ifindex)) < 0) {
+			ni_error("%s: cannot add port %s: %s", brdev->name, pif->name,
+					ni_strerror(rv));
+			return rv;
+		}
 	}
+	ni_netdev_ref_set(&pif->link.masterdev, brdev->name, brdev->link.ifindex);
 
 	/* Now configure the newly added port */
-	if ((rv = ni_sysfs_bridge_port_update_config(pif->name, port)) < 0) {
+	if (__ni_rtnl_link_change_bridge_port(pif, port) < 0 &&
+	    (rv = ni_sysfs_bridge_port_update_config(pif->name, port)) < 0) {
 		ni_error("%s: failed to configure port %s: %s",
 			brdev->name, pif->name, ni_strerror(rv));
 		return rv;
@@ -1882,7 +1898,7 @@ ni_system_bridge_add_port(ni_netconfig_t *nc, ni_netdev_t *brdev, const ni_bridg
 	if (!ni_string_eq(new_port->ifname, pif->name))
 		ni_string_dup(&new_port->ifname, pif->name);
 
-	if (!ni_bridge_add_port(bridge, new_port))
+	if (ni_bridge_add_port(bridge, new_port) < 0)
 		ni_bridge_port_free(new_port);
 	return 0;
 }
@@ -1932,7 +1948,7 @@ ni_system_ovs_bridge_create(ni_netconfig_t *nc, const ni_netdev_t *cfg, ni_netde
 		}
 	}
 
-	if (ni_ovs_vsctl_bridge_add(cfg, TRUE))
+	if (ni_ovsdb_bridge_add(cfg, TRUE))
 		return -1;
 
 	/* Wait for sysfs to appear */
@@ -1969,7 +1985,7 @@ ni_system_ovs_bridge_delete(ni_netconfig_t *nc, ni_netdev_t *dev)
 	if (!dev || dev->link.type != NI_IFTYPE_OVS_BRIDGE)
 		return -1;
 
-	return ni_ovs_vsctl_bridge_del(dev->name) ? -1 : 0;
+	return ni_ovsdb_bridge_del(dev->name) ? -1 : 0;
 }
 
 /*
@@ -2482,7 +2498,7 @@ __ni_system_tunnel_load_modules(unsigned int type)
 	 */
 	switch (type) {
 	case NI_IFTYPE_GRE:
-		if (ni_modprobe(GRE_TUNNEL_MODULE_NAME, NULL) < 0) {
+		if (ni_modprobe_load(GRE_TUNNEL_MODULE_NAME, NULL) < 0) {
 			ni_error("failed to load %s module",
 				GRE_TUNNEL_MODULE_NAME);
 			mod_load_ret = -1;
@@ -2490,12 +2506,12 @@ __ni_system_tunnel_load_modules(unsigned int type)
 		break;
 
 	case NI_IFTYPE_SIT:
-		if (ni_modprobe(TUNNEL4_MODULE_NAME, NULL) < 0) {
+		if (ni_modprobe_load(TUNNEL4_MODULE_NAME, NULL) < 0) {
 			ni_error("failed to load %s module",
 				TUNNEL4_MODULE_NAME);
 			mod_load_ret = -1;
 		}
-		if (ni_modprobe(SIT_TUNNEL_MODULE_NAME, NULL) < 0) {
+		if (ni_modprobe_load(SIT_TUNNEL_MODULE_NAME, NULL) < 0) {
 			ni_error("failed to load %s module",
 				SIT_TUNNEL_MODULE_NAME);
 			mod_load_ret = -1;
@@ -2503,12 +2519,12 @@ __ni_system_tunnel_load_modules(unsigned int type)
 		break;
 
 	case NI_IFTYPE_IPIP:
-		if (ni_modprobe(TUNNEL4_MODULE_NAME, NULL) < 0) {
+		if (ni_modprobe_load(TUNNEL4_MODULE_NAME, NULL) < 0) {
 			ni_error("failed to load %s module",
 				TUNNEL4_MODULE_NAME);
 			mod_load_ret = -1;
 		}
-		if (ni_modprobe(IPIP_TUNNEL_MODULE_NAME, NULL) < 0) {
+		if (ni_modprobe_load(IPIP_TUNNEL_MODULE_NAME, NULL) < 0) {
 			ni_error("failed to load %s module",
 				IPIP_TUNNEL_MODULE_NAME);
 			mod_load_ret = -1;
@@ -2530,6 +2546,7 @@ ni_system_tunnel_create(ni_netconfig_t *nc, const ni_netdev_t *cfg,
 		ni_netdev_t **dev_ret, unsigned int type)
 {
 	ni_netdev_t *dev;
+	int err;
 
 	if (!nc || !dev_ret || !cfg || !cfg->name)
 		return -1;
@@ -2554,13 +2571,19 @@ ni_system_tunnel_create(ni_netconfig_t *nc, const ni_netdev_t *cfg,
 	ni_debug_ifconfig("%s: creating %s tunnel", cfg->name,
 			ni_linktype_type_to_name(type));
 
-	if (__ni_system_tunnel_load_modules(type) < 0) {
-		ni_error("aborting %s tunnel creation",
-			ni_linktype_type_to_name(type));
-		return -1;
+	/* The kernel requests rtnl-link-<kind> itself on RTM_NEWLINK,
+	 * modprobe is needed only when the kind is still unsupported.
+	 */
+	if ((err = __ni_rtnl_link_create(nc, cfg)) && abs(err) == NLE_OPNOTSUPP) {
+		if (__ni_system_tunnel_load_modules(type) < 0) {
+			ni_error("aborting %s tunnel creation",
+				ni_linktype_type_to_name(type));
+			return -1;
+		}
+		err = __ni_rtnl_link_create(nc, cfg);
 	}
 
-	if (__ni_rtnl_link_create(nc, cfg)) {
+	if (err) {
 		ni_error("unable to create %s tunnel %s", ni_linktype_type_to_name(type),
 			cfg->name);
 		return -1;
@@ -3681,6 +3704,49 @@ nla_put_failure:
 	return -1;
 }
 
+static int
+__ni_rtnl_link_put_bridge(struct nl_msg *msg, const ni_bridge_t *bridge)
+{
+	struct nlattr *linkinfo;
+	struct nlattr *infodata;
+
+	if (!(linkinfo = nla_nest_start(msg, IFLA_LINKINFO)))
+		goto nla_put_failure;
+
+	NLA_PUT_STRING(msg, IFLA_INFO_KIND, "bridge");
+
+	if (bridge) {
+		if (!(infodata = nla_nest_start(msg, IFLA_INFO_DATA)))
+			goto nla_put_failure;
+
+		NLA_PUT_U32(msg, IFLA_BR_STP_STATE, bridge->stp ? 1 : 0);
+
+		if (bridge->priority != NI_BRIDGE_VALUE_NOT_SET)
+			NLA_PUT_U16(msg, IFLA_BR_PRIORITY, bridge->priority);
+		if (bridge->forward_delay != NI_BRIDGE_VALUE_NOT_SET)
+			NLA_PUT_U32(msg, IFLA_BR_FORWARD_DELAY,
+					(uint32_t)(bridge->forward_delay * 100.0));
+		if (bridge->ageing_time != NI_BRIDGE_VALUE_NOT_SET)
+			NLA_PUT_U32(msg, IFLA_BR_AGEING_TIME,
+					(uint32_t)(bridge->ageing_time * 100.0));
+		if (bridge->hello_time != NI_BRIDGE_VALUE_NOT_SET)
+			NLA_PUT_U32(msg, IFLA_BR_HELLO_TIME,
+					(uint32_t)(bridge->hello_time * 100.0));
+		if (bridge->max_age != NI_BRIDGE_VALUE_NOT_SET)
+			NLA_PUT_U32(msg, IFLA_BR_MAX_AGE,
+					(uint32_t)(bridge->max_age * 100.0));
+
+		nla_nest_end(msg, infodata);
+	}
+
+	nla_nest_end(msg, linkinfo);
+
+	return 0;
+
+nla_put_failure:
+	return -1;
+}
+
 static int
 __ni_rtnl_link_put_dummy(struct nl_msg *msg, const ni_netdev_t *cfg)
 {
@@ -4307,6 +4373,129 @@ failed:
 	return -1;
 }
 
+/*
+ * Create a bridge interface
+ */
+static int
+__ni_rtnl_link_create_bridge(const char *ifname)
+{
+	struct ifinfomsg ifi;
+	struct nl_msg *msg;
+	int err = -1;
+
+	memset(&ifi, 0, sizeof(ifi));
+	ifi.ifi_family = AF_UNSPEC;
+
+	msg = nlmsg_alloc_simple(RTM_NEWLINK, NLM_F_CREATE | NLM_F_EXCL);
+	if (nlmsg_append(msg, &ifi, sizeof(ifi), NLMSG_ALIGNTO) < 0)
+		goto nla_put_failure;
+
+	if (__ni_rtnl_link_put_ifname(msg, ifname) < 0)
+		goto nla_put_failure;
+
+	if (__ni_rtnl_link_put_bridge(msg, NULL) < 0)
+		goto nla_put_failure;
+
+	if ((err = ni_nl_talk(msg, NULL)))
+		goto failed;
+
+	ni_debug_ifconfig("successfully created bridge interface %s", ifname);
+	nlmsg_free(msg);
+	return 0;
+
+nla_put_failure:
+	ni_error("failed to encode netlink message to create bridge %s", ifname);
+failed:
+	nlmsg_free(msg);
+	return err < 0 ? err : -1;
+}
+
+/*
+ * Apply the bridge options (IFLA_BR_*) to an existing bridge
+ */
+static int
+__ni_rtnl_link_change_bridge(const ni_netdev_t *dev, const ni_bridge_t *bridge)
+{
+	struct ifinfomsg ifi;
+	struct nl_msg *msg;
+
+	if (!dev || !bridge)
+		return -1;
+
+	memset(&ifi, 0, sizeof(ifi));
+	ifi.ifi_family = AF_UNSPEC;
+	ifi.ifi_index = dev->link.ifindex;
+
+	msg = nlmsg_alloc_simple(RTM_NEWLINK, NLM_F_REQUEST);
+	if (nlmsg_append(msg, &ifi, sizeof(ifi), NLMSG_ALIGNTO) < 0)
+		goto nla_put_failure;
+
+	if (__ni_rtnl_link_put_bridge(msg, bridge) < 0)
+		goto nla_put_failure;
+
+	if (ni_nl_talk(msg, NULL))
+		goto failed;
+
+	ni_debug_ifconfig("successfully modified bridge interface %s", dev->name);
+	nlmsg_free(msg);
+	return 0;
+
+nla_put_failure:
+	ni_error("failed to encode netlink message to modify bridge %s", dev->name);
+failed:
+	nlmsg_free(msg);
+	return -1;
+}
+
+/*
+ * Apply the bridge port options (IFLA_BRPORT_*) to an enslaved port
+ */
+static int
+__ni_rtnl_link_change_bridge_port(const ni_netdev_t *pif, const ni_bridge_port_t *port)
+{
+	struct ifinfomsg ifi;
+	struct nlattr *protinfo;
+	struct nl_msg *msg;
+
+	if (!pif || !port)
+		return -1;
+
+	if (port->priority == NI_BRIDGE_VALUE_NOT_SET &&
+	    port->path_cost == NI_BRIDGE_VALUE_NOT_SET)
+		return 0;
+
+	memset(&ifi, 0, sizeof(ifi));
+	ifi.ifi_family = AF_BRIDGE;
+	ifi.ifi_index = pif->link.ifindex;
+
+	msg = nlmsg_alloc_simple(RTM_SETLINK, NLM_F_REQUEST);
+	if (nlmsg_append(msg, &ifi, sizeof(ifi), NLMSG_ALIGNTO) < 0)
+		goto nla_put_failure;
+
+	if (!(protinfo = nla_nest_start(msg, IFLA_PROTINFO | NLA_F_NESTED)))
+		goto nla_put_failure;
+
+	if (port->priority != NI_BRIDGE_VALUE_NOT_SET)
+		NLA_PUT_U16(msg, IFLA_BRPORT_PRIORITY, port->priority);
+	if (port->path_cost != NI_BRIDGE_VALUE_NOT_SET)
+		NLA_PUT_U32(msg, IFLA_BRPORT_COST, port->path_cost);
+
+	nla_nest_end(msg, protinfo);
+
+	if (ni_nl_talk(msg, NULL))
+		goto failed;
+
+	ni_debug_ifconfig("successfully modified bridge port %s", pif->name);
+	nlmsg_free(msg);
+	return 0;
+
+nla_put_failure:
+	ni_error("failed to encode netlink message to modify bridge port %s", pif->name);
+failed:
+	nlmsg_free(msg);
+	return -1;
+}
+
 /*
  * Bring down an interface and enslave (bond slave) to master
  */
@@ -4414,40 +4603,26 @@ addattr_sockaddr(struct nl_msg *msg, int type, const ni_sockaddr_t *addr)
 	return nla_put(msg, type, len, ((const caddr_t) addr) + offset);
 }
 
+/*
+ * Find the lease address matching an address of the device: an IPv4
+ * address also has to have the same peer, an IPv6 address just the
+ * same local address.
+ */
 static ni_address_t *
-__ni_netdev_address_in_list(ni_address_t *list, const ni_address_t *ap)
+__ni_netdev_address_in_index(const ni_address_index_t *index, const ni_address_t *ap)
 {
+	unsigned int pos = 0;
 	ni_address_t *ap2;
 
-	if (ap->local_addr.ss_family == AF_INET) {
-		const struct sockaddr_in *sin1, *sin2;
-
-		sin1 = &ap->local_addr.sin;
-		for (ap2 = list; ap2; ap2 = ap2->next) {
-			if (ap2->local_addr.ss_family != AF_INET)
-				continue;
-			sin2 = &ap2->local_addr.sin;
-			if (sin1->sin_addr.s_addr != sin2->sin_addr.s_addr)
-				continue;
-
-			if (!ni_sockaddr_equal(&ap->peer_addr, &ap2->peer_addr))
-				continue;
+	if (ap->local_addr.ss_family != AF_INET && ap->local_addr.ss_family != AF_INET6)
+		return NULL;
 
+	while ((ap2 = ni_address_index_find(index, &ap->local_addr, &pos))) {
+		if (ap->local_addr.ss_family == AF_INET6)
 			return ap2;
-		}
-	}
 
-	if (ap->local_addr.ss_family == AF_INET6) {
-		const struct sockaddr_in6 *sin1, *sin2;
-
-		sin1 = &ap->local_addr.six;
-		for (ap2 = list; ap2; ap2 = ap2->next) {
-			if (ap2->local_addr.ss_family != AF_INET6)
-				continue;
-			sin2 = &ap2->local_addr.six;
-			if (!memcmp(&sin1->sin6_addr, &sin2->sin6_addr, 16))
-				return ap2;
-		}
+		if (ni_sockaddr_equal(&ap->peer_addr, &ap2->peer_addr))
+			return ap2;
 	}
 
 	return NULL;
@@ -5332,6 +5507,8 @@ __ni_netdev_update_addrs(ni_netdev_t *dev,
 {
 	unsigned int max_changes = NI_ADDRCONF_UPDATER_MAX_ADDR_CHANGES;
 	ni_addrconf_mode_t owner = NI_ADDRCONF_NONE;
+	ni_address_index_t new_addrs = NI_ADDRESS_INDEX_INIT;
+	ni_lease_address_index_t leases;
 	ni_address_updater_t *au;
 	unsigned int family = AF_UNSPEC;
 	ni_address_t *ap, *next;
@@ -5359,6 +5536,12 @@ __ni_netdev_update_addrs(ni_netdev_t *dev,
 		return -1;
 	}
 
+	/* Index the lease addresses once instead of searching the lists
+	 * for every address of the device. */
+	if (new_lease)
+		ni_address_index_add_list(&new_addrs, new_lease->addrs);
+	ni_lease_address_index_init(&leases, dev, family);
+
 	for (ap = dev->addrs; ap; ap = next) {
 		ni_address_t *new_addr;
 
@@ -5368,7 +5551,7 @@ __ni_netdev_update_addrs(ni_netdev_t *dev,
 
 		/* See if the config list contains the address we've found in the
 		 * system. */
-		new_addr = new_lease ? __ni_netdev_address_in_list(new_lease->addrs, ap) : NULL;
+		new_addr = new_lease ? __ni_netdev_address_in_index(&new_addrs, ap) : NULL;
 
 		/* Do not touch addresses not managed by us. */
 		if (ap->owner == NI_ADDRCONF_NONE) {
@@ -5392,7 +5575,7 @@ __ni_netdev_update_addrs(ni_netdev_t *dev,
 		if (ap->owner == owner) {
 			ni_addrconf_lease_t *other;
 
-			if ((other = __ni_netdev_address_to_lease(dev, ap, minprio)) != NULL)
+			if ((other = ni_lease_address_index_find(&leases, ap, minprio)) != NULL)
 				ap->owner = other->type;
 		}
 
@@ -5456,6 +5639,9 @@ __ni_netdev_update_addrs(ni_netdev_t *dev,
 		}
 	}
 
+	ni_lease_address_index_destroy(&leases);
+	ni_address_index_destroy(&new_addrs);
+
 	if (max_changes == 0)
 		return 1;
 
@@ -20,6 +20,7 @@
 #include <wicked/socket.h>
 #include <wicked/route.h>
 #include <wicked/ipv6.h>
+#include <wicked/metrics.h>
 
 #include "netinfo_priv.h"
 #include "socket_priv.h"
@@ -302,6 +303,8 @@ __ni_rtevent_newlink(ni_netconfig_t *nc, const struct sockaddr_nl *nladdr, struc
 		if (!ni_string_eq(old->name, ifname)) {
 			ni_debug_events("%s[%u]: device renamed to %s",
 					old->name, old->link.ifindex, ifname);
+			ni_sysfs_ifdir_cache_drop(old->name);
+			ni_sysfs_ifdir_cache_drop(ifname);
 			ni_string_dup(&old->name, ifname);
 			__ni_netdev_event(nc, old, NI_EVENT_DEVICE_RENAME);
 		}
@@ -314,6 +317,7 @@ __ni_rtevent_newlink(ni_netconfig_t *nc, const struct sockaddr_nl *nladdr, struc
 			return -1;
 		}
 		dev->created = 1;
+		ni_sysfs_ifdir_cache_drop(ifname);
 		ni_netconfig_device_append(nc, dev);
 	}
 
@@ -342,6 +346,7 @@ __ni_rtevent_newlink(ni_netconfig_t *nc, const struct sockaddr_nl *nladdr, struc
 			 */
 			char *current = if_indextoname(conflict->link.ifindex, namebuf);
 			if (current) {
+				ni_sysfs_ifdir_cache_drop(conflict->name);
 				ni_string_dup(&conflict->name, current);
 				__ni_netdev_event(nc, conflict, NI_EVENT_DEVICE_RENAME);
 			} else {
@@ -398,6 +403,7 @@ __ni_rtevent_dellink(ni_netconfig_t *nc, const struct sockaddr_nl *nladdr, struc
 		dev->deleted = 1;
 		__ni_netdev_process_events(nc, dev, old_flags);
 		ni_client_state_drop(dev->link.ifindex);
+		ni_sysfs_topology_drop(dev->link.ifindex);
 		ni_netconfig_device_remove(nc, dev);
 	}
 
@@ -905,8 +911,10 @@ static int
 __ni_rtevent_process_cb(struct nl_msg *msg, void *ptr)
 {
 	const struct sockaddr_nl *sender = nlmsg_get_src(msg);
+	struct timeval start;
 	struct nlmsghdr *nlh;
 	ni_netconfig_t *nc;
+	int rv;
 
 	if ((nc = ni_global_state_handle(0)) == NULL)
 		return NL_SKIP;
@@ -918,7 +926,10 @@ __ni_rtevent_process_cb(struct nl_msg *msg, void *ptr)
 	}
 
 	nlh = nlmsg_hdr(msg);
-	if (__ni_rtevent_process(nc, sender, nlh) < 0) {
+	ni_metrics_begin(&start);
+	rv = __ni_rtevent_process(nc, sender, nlh);
+	ni_metrics_end(NI_METRIC_RTEVENT_PROCESS, &start);
+	if (rv < 0) {
 		ni_debug_events("ignoring %s rtnetlink event",
 			ni_rtnl_msg_type_to_name(nlh->nlmsg_type, "unknown"));
 		return NL_SKIP;
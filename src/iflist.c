@@ -69,7 +69,7 @@ static int		__ni_netdev_process_newroute(ni_netdev_t *, struct nlmsghdr *,
 					struct rtmsg *, ni_netconfig_t *);
 static int		__ni_netdev_process_newrule(struct nlmsghdr *, struct fib_rule_hdr *,
 					ni_netconfig_t *);
-static int		__ni_discover_bridge(ni_netdev_t *);
+static int		__ni_discover_bridge(ni_netdev_t *, struct nlattr **, ni_netconfig_t *);
 static int		__ni_discover_bond(ni_netdev_t *, struct nlattr **, ni_netconfig_t *);
 static int		__ni_discover_addrconf(ni_netdev_t *);
 static int		__ni_discover_infiniband(ni_netdev_t *, ni_netconfig_t *);
@@ -426,6 +426,43 @@ ni_netconfig_rules_drop_by_seq(ni_netconfig_t *nc, unsigned int seq)
 	}
 }
 
+static ni_bridge_port_t *
+__ni_bridge_bind_port(ni_netdev_t *master, const ni_netdev_ref_t *ref)
+{
+	ni_bridge_t *bridge;
+	ni_bridge_port_t *port;
+
+	if (!(bridge = ni_netdev_get_bridge(master)))
+		return NULL;
+
+	if ((port = ni_bridge_port_by_index(bridge, ref->index))) {
+		if (!ni_string_eq(port->ifname, ref->name))
+			ni_string_dup(&port->ifname, ref->name);
+	} else {
+		port = ni_bridge_port_new(bridge, ref->name, ref->index);
+	}
+	return port;
+}
+
+static inline void
+__ni_bridge_port_set_info(ni_bridge_port_t *port, const ni_bridge_port_t *info)
+{
+	if (!port || !info || port == info)
+		return;
+
+	port->priority = info->priority;
+	port->path_cost = info->path_cost;
+	ni_bridge_port_status_copy(&port->status, &info->status);
+}
+
+static inline void
+__ni_refresh_bridge_master_bind(ni_netdev_t *master, ni_linkinfo_t *link, const char *ifname)
+{
+	const ni_netdev_ref_t ref = { .name = (char *)ifname, .index = link->ifindex };
+
+	__ni_bridge_port_set_info(__ni_bridge_bind_port(master, &ref), link->slave.bridge);
+}
+
 static inline void
 __ni_refresh_bonding_master_bind(ni_netdev_t *master, ni_linkinfo_t *link, const char *ifname)
 {
@@ -458,6 +495,10 @@ __ni_refresh_bind_master(ni_netconfig_t *nc, ni_netdev_t *dev)
 		__ni_refresh_bonding_master_bind(master, &dev->link, dev->name);
 		break;
 
+	case NI_IFTYPE_BRIDGE:
+		__ni_refresh_bridge_master_bind(master, &dev->link, dev->name);
+		break;
+
 	default:
 		break;
 	}
@@ -502,6 +543,11 @@ __ni_refresh_unbind_master(ni_netconfig_t *nc, ni_netdev_t *dev)
 		__ni_refresh_bonding_master_unbind(master, &dev->link, dev->name);
 		break;
 
+	case NI_IFTYPE_BRIDGE:
+		if (master->bridge)
+			ni_bridge_del_port_ifindex(master->bridge, dev->link.ifindex);
+		break;
+
 	default:
 		break;
 	}
@@ -549,6 +595,11 @@ __ni_system_refresh_all(ni_netconfig_t *nc, ni_netdev_t **del_list)
 	while ((dev = *tail) != NULL)
 		tail = &dev->next;
 
+	/* query ethtool settings of all devices at once after the links */
+	if (!ni_netconfig_discover_filtered(nc, NI_NETCONFIG_DISCOVER_LINK_EXTERN |
+						NI_NETCONFIG_DISCOVER_LINK_DEFER))
+		ni_system_ethtool_refresh_begin();
+
 	while (1) {
 		struct ifinfomsg *ifi;
 		struct nlattr *nla;
@@ -571,7 +622,7 @@ __ni_system_refresh_all(ni_netconfig_t *nc, ni_netdev_t **del_list)
 			if (!dev)
 				goto failed;
 
-			if ((pci_dev = ni_sysfs_netdev_get_pci(ifname)) != NULL)
+			if ((pci_dev = ni_sysfs_netdev_get_pci(ifname, ifi->ifi_index)) != NULL)
 				ni_netdev_set_pci(dev, pci_dev);
 
 			/* FIXME: use ni_netconfig_device_append() */
@@ -591,6 +642,8 @@ __ni_system_refresh_all(ni_netconfig_t *nc, ni_netdev_t **del_list)
 		if (__ni_netdev_process_newlink(dev, h, ifi, nc) < 0)
 			ni_error("Problem parsing RTM_NEWLINK message for %s", ifname);
 	}
+	ni_system_ethtool_refresh_end(nc);
+	ni_sysfs_topology_save();
 
 	for (dev = ni_netconfig_devlist(nc); dev; dev = dev->next) {
 		__ni_refresh_bind_master(nc, dev);
@@ -663,10 +716,31 @@ __ni_system_refresh_all(ni_netconfig_t *nc, ni_netdev_t **del_list)
 	res = 0;
 
 failed:
+	ni_system_ethtool_refresh_end(nc);
 	ni_rtnl_query_destroy(&query);
 	return res;
 }
 
+/*
+ * Complete the deferred link details discovery of an interface
+ */
+int
+ni_system_refresh_details(ni_netconfig_t *nc, ni_netdev_t *dev)
+{
+	if (!nc || !dev || !(dev->link.ifflags & NI_IFF_DETAILS_PENDING))
+		return 0;
+
+	if (ni_netconfig_discover_filtered(nc, NI_NETCONFIG_DISCOVER_LINK_DEFER))
+		return 1;
+
+	ni_debug_verbose(NI_LOG_DEBUG1, NI_TRACE_EVENTS,
+			"%s: discovering deferred link details", dev->name);
+
+	/* cleared also when the device vanished meanwhile */
+	dev->link.ifflags &= ~NI_IFF_DETAILS_PENDING;
+	return __ni_system_refresh_interface(nc, dev);
+}
+
 /*
  * Refresh one interfaces
  */
@@ -1041,7 +1115,7 @@ done:
 unsigned int
 __ni_netdev_translate_ifflags(unsigned int ifflags, unsigned int prev)
 {
-	unsigned int retval = (prev & NI_IFF_DEVICE_READY);
+	unsigned int retval = (prev & (NI_IFF_DEVICE_READY | NI_IFF_DETAILS_PENDING));
 
 	switch (ifflags & (IFF_RUNNING | IFF_LOWER_UP | IFF_UP)) {
 	case IFF_UP:
@@ -1096,7 +1170,7 @@ __ni_process_ifinfomsg_ovs_type(ni_iftype_t *type, const char *ifname, ni_netcon
 	if (ni_netconfig_discover_filtered(nc, NI_NETCONFIG_DISCOVER_LINK_EXTERN))
 		return;
 
-	if (ni_ovs_vsctl_bridge_exists(ifname) == 0)
+	if (ni_ovsdb_bridge_exists(ifname) == 0)
 		*type = NI_IFTYPE_OVS_BRIDGE;
 }
 
@@ -1252,6 +1326,13 @@ __ni_process_ifinfomsg_masterdev_unbind(ni_linkinfo_t *link, const char *ifname,
 		case NI_IFTYPE_BOND:
 			ni_bonding_unbind_slave(master->bonding, &ref, master->name);
 			break;
+		case NI_IFTYPE_BRIDGE:
+			if (master->bridge)
+				ni_bridge_del_port_ifindex(master->bridge, ref.index);
+			break;
+		case NI_IFTYPE_TEAM:
+			ni_teamd_port_changed(master->name, ifname, FALSE);
+			break;
 		default:
 			break;
 		}
@@ -1271,6 +1352,14 @@ __ni_process_ifinfomsg_masterdev_bind(ni_linkinfo_t *link, const char *ifname,
 		case NI_IFTYPE_BOND:
 			ni_bonding_bind_slave(master->bonding, &ref, master->name);
 			break;
+		case NI_IFTYPE_BRIDGE:
+			__ni_bridge_bind_port(master, &ref);
+			break;
+		case NI_IFTYPE_TEAM:
+			/* a rebind just updates the ref names */
+			if (link->masterdev.index != mindex)
+				ni_teamd_port_changed(master->name, ifname, TRUE);
+			break;
 		default:
 			break;
 		}
@@ -1400,6 +1489,93 @@ __ni_process_ifinfomsg_bond_slave_data(ni_linkinfo_t *link, const char *ifname,
 	}
 }
 
+static inline void
+__ni_process_ifinfomsg_bridge_id(char **id, const struct nlattr *aptr)
+{
+	const struct ifla_bridge_id *bid;
+
+	if (nla_len(aptr) < (int)sizeof(*bid)) {
+		ni_string_free(id);
+		return;
+	}
+
+	bid = nla_data(aptr);
+	ni_string_printf(id, "%02x%02x.%02x%02x%02x%02x%02x%02x",
+			bid->prio[0], bid->prio[1],
+			bid->addr[0], bid->addr[1], bid->addr[2],
+			bid->addr[3], bid->addr[4], bid->addr[5]);
+}
+
+static inline void
+__ni_process_ifinfomsg_bridge_port_data(ni_linkinfo_t *link, const char *ifname, struct nlattr *data)
+{
+	/* static const */ struct nla_policy	__port_policy[IFLA_BRPORT_MAX+1] = {
+		[IFLA_BRPORT_STATE]			= { .type = NLA_U8      },
+		[IFLA_BRPORT_PRIORITY]			= { .type = NLA_U16     },
+		[IFLA_BRPORT_COST]			= { .type = NLA_U32     },
+		[IFLA_BRPORT_MODE]			= { .type = NLA_U8      },
+		[IFLA_BRPORT_ROOT_ID]			= { .type = NLA_UNSPEC  },
+		[IFLA_BRPORT_BRIDGE_ID]			= { .type = NLA_UNSPEC  },
+		[IFLA_BRPORT_DESIGNATED_PORT]		= { .type = NLA_U16     },
+		[IFLA_BRPORT_DESIGNATED_COST]		= { .type = NLA_U16     },
+		[IFLA_BRPORT_ID]			= { .type = NLA_U16     },
+		[IFLA_BRPORT_NO]			= { .type = NLA_U16     },
+		[IFLA_BRPORT_TOPOLOGY_CHANGE_ACK]	= { .type = NLA_U8      },
+		[IFLA_BRPORT_CONFIG_PENDING]		= { .type = NLA_U8      },
+		[IFLA_BRPORT_MESSAGE_AGE_TIMER]		= { .type = NLA_U64     },
+		[IFLA_BRPORT_FORWARD_DELAY_TIMER]	= { .type = NLA_U64     },
+		[IFLA_BRPORT_HOLD_TIMER]		= { .type = NLA_U64     },
+	};
+	struct nlattr *tb[IFLA_BRPORT_MAX+1];
+	ni_bridge_port_status_t *ps;
+	ni_bridge_port_t *port;
+
+	memset(tb, 0, sizeof(tb));
+	if (nla_parse_nested(tb, IFLA_BRPORT_MAX, data, __port_policy) < 0) {
+		ni_warn("%s: unable to parse bridge port data", ifname);
+		return;
+	}
+
+	port = link->slave.bridge;
+	ps = &port->status;
+
+	if (tb[IFLA_BRPORT_PRIORITY])
+		port->priority = ps->priority = nla_get_u16(tb[IFLA_BRPORT_PRIORITY]);
+	if (tb[IFLA_BRPORT_COST])
+		port->path_cost = ps->path_cost = nla_get_u32(tb[IFLA_BRPORT_COST]);
+
+	if (tb[IFLA_BRPORT_STATE])
+		ps->state = nla_get_u8(tb[IFLA_BRPORT_STATE]);
+	if (tb[IFLA_BRPORT_ID])
+		ps->port_id = nla_get_u16(tb[IFLA_BRPORT_ID]);
+	if (tb[IFLA_BRPORT_NO])
+		ps->port_no = nla_get_u16(tb[IFLA_BRPORT_NO]);
+	if (tb[IFLA_BRPORT_ROOT_ID])
+		__ni_process_ifinfomsg_bridge_id(&ps->designated_root, tb[IFLA_BRPORT_ROOT_ID]);
+	if (tb[IFLA_BRPORT_BRIDGE_ID])
+		__ni_process_ifinfomsg_bridge_id(&ps->designated_bridge, tb[IFLA_BRPORT_BRIDGE_ID]);
+	if (tb[IFLA_BRPORT_DESIGNATED_PORT])
+		ps->designated_port = nla_get_u16(tb[IFLA_BRPORT_DESIGNATED_PORT]);
+	if (tb[IFLA_BRPORT_DESIGNATED_COST])
+		ps->designated_cost = nla_get_u16(tb[IFLA_BRPORT_DESIGNATED_COST]);
+	if (tb[IFLA_BRPORT_TOPOLOGY_CHANGE_ACK])
+		ps->change_ack = nla_get_u8(tb[IFLA_BRPORT_TOPOLOGY_CHANGE_ACK]);
+	if (tb[IFLA_BRPORT_MODE])
+		ps->hairpin_mode = nla_get_u8(tb[IFLA_BRPORT_MODE]);
+	if (tb[IFLA_BRPORT_CONFIG_PENDING])
+		ps->config_pending = nla_get_u8(tb[IFLA_BRPORT_CONFIG_PENDING]);
+	if (tb[IFLA_BRPORT_HOLD_TIMER])
+		ps->hold_timer = nla_get_u64(tb[IFLA_BRPORT_HOLD_TIMER]);
+	if (tb[IFLA_BRPORT_MESSAGE_AGE_TIMER])
+		ps->message_age_timer = nla_get_u64(tb[IFLA_BRPORT_MESSAGE_AGE_TIMER]);
+	if (tb[IFLA_BRPORT_FORWARD_DELAY_TIMER])
+		ps->forward_delay_timer = nla_get_u64(tb[IFLA_BRPORT_FORWARD_DELAY_TIMER]);
+
+	ni_debug_verbose(NI_LOG_DEBUG2, NI_TRACE_EVENTS,
+			"%s: bridge port state=%d priority=%u path-cost=%u port-id=%u",
+			ifname, ps->state, ps->priority, ps->path_cost, ps->port_id);
+}
+
 static inline void
 __ni_process_ifinfomsg_slave_data(ni_linkinfo_t *link, const char *ifname,
 		ni_netdev_t *master, const char *kind, struct nlattr *data)
@@ -1437,6 +1613,29 @@ __ni_process_ifinfomsg_slave_data(ni_linkinfo_t *link, const char *ifname,
 			__ni_process_ifinfomsg_bond_slave_data(link, ifname, data);
 		break;
 
+	case NI_IFTYPE_BRIDGE:
+		if (master && master->link.type != link->slave.type) {
+			ni_warn("%s: master %s link type does not match slaveinfo kind type",
+					master->name, ifname);
+			return;
+		}
+
+		if (!data) {
+			ni_debug_verbose(NI_LOG_DEBUG2, NI_TRACE_EVENTS,
+					"%s: slave info does not provide any data", ifname);
+			return;
+		}
+
+		/*
+		 * Keep the port info in the slave, so a bridge discovered
+		 * later in the same dump can pick it up when binding.
+		 */
+		link->slave.bridge = ni_bridge_port_new(NULL, ifname, link->ifindex);
+		__ni_process_ifinfomsg_bridge_port_data(link, ifname, data);
+		if (master)
+			__ni_refresh_bridge_master_bind(master, link, ifname);
+		break;
+
 	default:
 		break;
 	}
@@ -1833,6 +2032,26 @@ __ni_process_ifinfomsg_af_spec(ni_netdev_t *dev, struct nlattr *ifla_af_spec, ni
 	return 0;
 }
 
+/*
+ * Whether to discover the link details using external calls
+ * (ethtool, wireless, teamd, ovs, ...) now. While deferred, the
+ * device is marked details-pending until ni_system_refresh_details.
+ */
+static ni_bool_t
+__ni_netdev_discover_details(ni_netdev_t *dev, ni_netconfig_t *nc)
+{
+	if (ni_netconfig_discover_filtered(nc, NI_NETCONFIG_DISCOVER_LINK_EXTERN))
+		return FALSE;
+
+	if (ni_netconfig_discover_filtered(nc, NI_NETCONFIG_DISCOVER_LINK_DEFER)) {
+		dev->link.ifflags |= NI_IFF_DETAILS_PENDING;
+		return FALSE;
+	}
+
+	dev->link.ifflags &= ~NI_IFF_DETAILS_PENDING;
+	return TRUE;
+}
+
 /*
  * Refresh complete interface link info given a RTM_NEWLINK message
  */
@@ -1841,6 +2060,7 @@ __ni_netdev_process_newlink(ni_netdev_t *dev, struct nlmsghdr *h,
 				struct ifinfomsg *ifi, ni_netconfig_t *nc)
 {
 	struct nlattr *tb[IFLA_MAX+1];
+	ni_bool_t details;
 	int rv;
 
 	memset(tb, 0, sizeof(tb));
@@ -1885,12 +2105,13 @@ __ni_netdev_process_newlink(ni_netdev_t *dev, struct nlmsghdr *h,
 	if (ifi->ifi_family == AF_INET6)
 		__ni_process_ifinfomsg_ipv6info(dev, tb[IFLA_PROTINFO]);
 
-	if (!ni_netconfig_discover_filtered(nc, NI_NETCONFIG_DISCOVER_LINK_EXTERN))
+	details = __ni_netdev_discover_details(dev, nc);
+	if (details)
 		ni_system_ethtool_refresh(dev);
 
 	switch (dev->link.type) {
 	case NI_IFTYPE_ETHERNET:
-		if (ni_netconfig_discover_filtered(nc, NI_NETCONFIG_DISCOVER_LINK_EXTERN))
+		if (!details)
 			break;
 
 		__ni_system_ethernet_refresh(dev);
@@ -1902,7 +2123,7 @@ __ni_netdev_process_newlink(ni_netdev_t *dev, struct nlmsghdr *h,
 		break;
 
 	case NI_IFTYPE_BRIDGE:
-		__ni_discover_bridge(dev);
+		__ni_discover_bridge(dev, tb, nc);
 		break;
 	case NI_IFTYPE_BOND:
 		__ni_discover_bond(dev, tb, nc);
@@ -1922,7 +2143,7 @@ __ni_netdev_process_newlink(ni_netdev_t *dev, struct nlmsghdr *h,
 		break;
 
 	case NI_IFTYPE_PPP:
-		if (ni_netconfig_discover_filtered(nc, NI_NETCONFIG_DISCOVER_LINK_EXTERN))
+		if (!details)
 			break;
 
 		if (ni_netdev_device_is_ready(dev))
@@ -1935,7 +2156,7 @@ __ni_netdev_process_newlink(ni_netdev_t *dev, struct nlmsghdr *h,
 		break;
 
 	case NI_IFTYPE_WIRELESS:
-		if (ni_netconfig_discover_filtered(nc, NI_NETCONFIG_DISCOVER_LINK_EXTERN))
+		if (!details)
 			break;
 
 		rv = ni_wireless_interface_refresh(dev);
@@ -1954,20 +2175,21 @@ __ni_netdev_process_newlink(ni_netdev_t *dev, struct nlmsghdr *h,
 		break;
 
 	case NI_IFTYPE_TEAM:
-		if (ni_netconfig_discover_filtered(nc, NI_NETCONFIG_DISCOVER_LINK_EXTERN))
+		if (!details)
 			break;
 
 		/*
 		 * is using gennl, rtnl_link provides a kind only,
 		 * so we unfortunatelly have to ask teamd here and
-		 * even worser, by name...
+		 * even worser, by name... the model is cached and
+		 * refreshed on teamd signals and port changes.
 		 */
 		if (ni_config_teamd_enabled() && ni_netdev_device_is_ready(dev))
 			ni_teamd_discover(dev);
 		break;
 
 	case NI_IFTYPE_OVS_BRIDGE:
-		if (ni_netconfig_discover_filtered(nc, NI_NETCONFIG_DISCOVER_LINK_EXTERN))
+		if (!details)
 			break;
 
 		if (ni_netdev_device_is_ready(dev))
@@ -3472,17 +3694,11 @@ failure:
  * Discover bridge topology
  */
 static int
-__ni_discover_bridge(ni_netdev_t *dev)
+__ni_discover_bridge_sysfs(ni_netdev_t *dev, ni_bridge_t *bridge)
 {
-	ni_bridge_t *bridge;
 	ni_string_array_t ports;
 	unsigned int i;
 
-	if (dev->link.type != NI_IFTYPE_BRIDGE)
-		return 0;
-
-	bridge = ni_netdev_get_bridge(dev);
-
 	ni_sysfs_bridge_get_config(dev->name, bridge);
 	ni_sysfs_bridge_get_status(dev->name, &bridge->status);
 
@@ -3511,6 +3727,135 @@ __ni_discover_bridge(ni_netdev_t *dev)
 	return 0;
 }
 
+static int
+__ni_discover_bridge_netlink_master(ni_netdev_t *dev, ni_bridge_t *bridge, struct nlattr *data)
+{
+	/* static const */ struct nla_policy	__bridge_policy[IFLA_BR_MAX+1] = {
+		[IFLA_BR_FORWARD_DELAY]			= { .type = NLA_U32	},
+		[IFLA_BR_HELLO_TIME]			= { .type = NLA_U32	},
+		[IFLA_BR_MAX_AGE]			= { .type = NLA_U32	},
+		[IFLA_BR_AGEING_TIME]			= { .type = NLA_U32	},
+		[IFLA_BR_STP_STATE]			= { .type = NLA_U32	},
+		[IFLA_BR_PRIORITY]			= { .type = NLA_U16	},
+		[IFLA_BR_ROOT_ID]			= { .type = NLA_UNSPEC	},
+		[IFLA_BR_BRIDGE_ID]			= { .type = NLA_UNSPEC	},
+		[IFLA_BR_ROOT_PORT]			= { .type = NLA_U16	},
+		[IFLA_BR_ROOT_PATH_COST]		= { .type = NLA_U32	},
+		[IFLA_BR_TOPOLOGY_CHANGE]		= { .type = NLA_U8	},
+		[IFLA_BR_TOPOLOGY_CHANGE_DETECTED]	= { .type = NLA_U8	},
+		[IFLA_BR_HELLO_TIMER]			= { .type = NLA_U64	},
+		[IFLA_BR_TCN_TIMER]			= { .type = NLA_U64	},
+		[IFLA_BR_TOPOLOGY_CHANGE_TIMER]		= { .type = NLA_U64	},
+		[IFLA_BR_GC_TIMER]			= { .type = NLA_U64	},
+		[IFLA_BR_GROUP_ADDR]			= { .type = NLA_UNSPEC	},
+	};
+	struct nlattr *tb[IFLA_BR_MAX+1];
+	ni_bridge_status_t *bs = &bridge->status;
+
+	memset(tb, 0, sizeof(tb));
+	if (nla_parse_nested(tb, IFLA_BR_MAX, data, __bridge_policy) < 0) {
+		ni_error("%s: unable to parse bridge IFLA_INFO_DATA", dev->name);
+		return -1;
+	}
+
+	if (tb[IFLA_BR_STP_STATE]) {
+		bs->stp_state = nla_get_u32(tb[IFLA_BR_STP_STATE]);
+		bridge->stp = bs->stp_state ? TRUE : FALSE;
+	}
+	if (tb[IFLA_BR_PRIORITY])
+		bridge->priority = nla_get_u16(tb[IFLA_BR_PRIORITY]);
+	if (tb[IFLA_BR_FORWARD_DELAY])
+		bridge->forward_delay = (double)nla_get_u32(tb[IFLA_BR_FORWARD_DELAY]) / 100.0;
+	if (tb[IFLA_BR_AGEING_TIME])
+		bridge->ageing_time = (double)nla_get_u32(tb[IFLA_BR_AGEING_TIME]) / 100.0;
+	if (tb[IFLA_BR_HELLO_TIME])
+		bridge->hello_time = (double)nla_get_u32(tb[IFLA_BR_HELLO_TIME]) / 100.0;
+	if (tb[IFLA_BR_MAX_AGE])
+		bridge->max_age = (double)nla_get_u32(tb[IFLA_BR_MAX_AGE]) / 100.0;
+
+	if (tb[IFLA_BR_ROOT_ID])
+		__ni_process_ifinfomsg_bridge_id(&bs->root_id, tb[IFLA_BR_ROOT_ID]);
+	if (tb[IFLA_BR_BRIDGE_ID])
+		__ni_process_ifinfomsg_bridge_id(&bs->bridge_id, tb[IFLA_BR_BRIDGE_ID]);
+	if (tb[IFLA_BR_GROUP_ADDR] && nla_len(tb[IFLA_BR_GROUP_ADDR]) >= ETH_ALEN) {
+		const unsigned char *mac = nla_data(tb[IFLA_BR_GROUP_ADDR]);
+
+		ni_string_printf(&bs->group_addr, "%02x:%02x:%02x:%02x:%02x:%02x",
+				mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+	}
+	if (tb[IFLA_BR_ROOT_PORT])
+		bs->root_port = nla_get_u16(tb[IFLA_BR_ROOT_PORT]);
+	if (tb[IFLA_BR_ROOT_PATH_COST])
+		bs->root_path_cost = nla_get_u32(tb[IFLA_BR_ROOT_PATH_COST]);
+	if (tb[IFLA_BR_TOPOLOGY_CHANGE])
+		bs->topology_change = nla_get_u8(tb[IFLA_BR_TOPOLOGY_CHANGE]);
+	if (tb[IFLA_BR_TOPOLOGY_CHANGE_DETECTED])
+		bs->topology_change_detected = nla_get_u8(tb[IFLA_BR_TOPOLOGY_CHANGE_DETECTED]);
+	if (tb[IFLA_BR_GC_TIMER])
+		bs->gc_timer = nla_get_u64(tb[IFLA_BR_GC_TIMER]);
+	if (tb[IFLA_BR_TCN_TIMER])
+		bs->tcn_timer = nla_get_u64(tb[IFLA_BR_TCN_TIMER]);
+	if (tb[IFLA_BR_HELLO_TIMER])
+		bs->hello_timer = nla_get_u64(tb[IFLA_BR_HELLO_TIMER]);
+	if (tb[IFLA_BR_TOPOLOGY_CHANGE_TIMER])
+		bs->topology_change_timer = nla_get_u64(tb[IFLA_BR_TOPOLOGY_CHANGE_TIMER]);
+
+	ni_debug_verbose(NI_LOG_DEBUG2, NI_TRACE_EVENTS,
+			"%s: bridge stp=%u priority=%u bridge-id=%s root-id=%s",
+			dev->name, bs->stp_state, bridge->priority,
+			bs->bridge_id, bs->root_id);
+	return 0;
+}
+
+static int
+__ni_discover_bridge_netlink(ni_netdev_t *dev, ni_bridge_t *bridge, struct nlattr **tb)
+{
+	/* static const */ struct nla_policy	__info_data_policy[IFLA_INFO_MAX+1] = {
+		[IFLA_INFO_KIND]			= { .type = NLA_STRING	},
+		[IFLA_INFO_DATA]			= { .type = NLA_NESTED	},
+		/* _here_, we handle only these attrs */
+	};
+	struct nlattr *info[IFLA_INFO_MAX+1];
+
+	if (!tb || !tb[IFLA_LINKINFO])
+		return 1;
+
+	if (nla_parse_nested(info, IFLA_INFO_MAX, tb[IFLA_LINKINFO], __info_data_policy) < 0) {
+		ni_error("%s: Unable to parse IFLA_LINKINFO newlink attribute", dev->name);
+		return -1;
+	}
+
+	if (!info[IFLA_INFO_KIND] || !ni_string_eq("bridge", nla_get_string(info[IFLA_INFO_KIND])))
+		return 1;
+
+	/* kernels before 4.4 do not provide the bridge config in the link dump */
+	if (!info[IFLA_INFO_DATA])
+		return 1;
+
+	return __ni_discover_bridge_netlink_master(dev, bridge, info[IFLA_INFO_DATA]);
+}
+
+static int
+__ni_discover_bridge(ni_netdev_t *dev, struct nlattr **tb, ni_netconfig_t *nc)
+{
+	ni_bridge_t *bridge;
+	int ret;
+
+	if (dev->link.type != NI_IFTYPE_BRIDGE)
+		return 0;
+
+	bridge = ni_netdev_get_bridge(dev);
+
+	/*
+	 * The ports are bound to the bridge while processing their own
+	 * link messages, see __ni_process_ifinfomsg_masterdev_bind().
+	 */
+	if ((ret = __ni_discover_bridge_netlink(dev, bridge, tb)) <= 0)
+		return ret;
+
+	return __ni_discover_bridge_sysfs(dev, bridge);
+}
+
 /*
  * Discover bonding configuration
  */
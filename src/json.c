@@ -45,6 +45,16 @@
 #define	NI_JSON_OBJECT_CHUNK	4
 #define NI_JSON_ARRAY_CHUNK	4
 
+/*
+ * objects with at least this number of members get a name index
+ */
+#define NI_JSON_OBJECT_HASH_MIN	16
+
+/*
+ * maximal nesting depth accepted by the scanner
+ */
+#define NI_JSON_SCAN_DEPTH_MAX	256
+
 
 /*
  * structured types
@@ -73,6 +83,9 @@ struct ni_json_pair {
 struct ni_json_object {
 	unsigned int		count;
 	ni_json_pair_t **	data;
+
+	unsigned int		hsize;
+	ni_json_pair_t **	hash;
 };
 
 struct ni_json_array {
@@ -192,6 +205,16 @@ ni_json_string_get(ni_json_t *json, char **ret)
 	return FALSE;
 }
 
+const char *
+ni_json_string_value(ni_json_t *json)
+{
+	char **val;
+
+	if ((val = ni_json_to_string(json)))
+		return *val;
+	return NULL;
+}
+
 /*
  * json object name:value pair
  */
@@ -275,9 +298,75 @@ ni_json_object_new(void)
 	return xcalloc(1, sizeof(ni_json_object_t));
 }
 
+/*
+ * Open addressing name index of the object pairs, built on
+ * first lookup in larger objects and dropped on removal.
+ */
+static inline unsigned int
+ni_json_object_hash_name(const char *name)
+{
+	unsigned int hash = 2166136261U;	/* FNV-1a */
+
+	while (name && *name) {
+		hash ^= (unsigned char)*name++;
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+static void
+ni_json_object_hash_drop(ni_json_object_t *njo)
+{
+	free(njo->hash);
+	njo->hash = NULL;
+	njo->hsize = 0;
+}
+
+static void
+ni_json_object_hash_insert(ni_json_object_t *njo, ni_json_pair_t *pair)
+{
+	unsigned int mask = njo->hsize - 1;
+	unsigned int pos = ni_json_object_hash_name(pair->name) & mask;
+
+	while (njo->hash[pos])
+		pos = (pos + 1) & mask;
+	njo->hash[pos] = pair;
+}
+
+static void
+ni_json_object_hash_build(ni_json_object_t *njo)
+{
+	unsigned int i, size = 32;
+
+	while (size < njo->count * 2)
+		size <<= 1;
+
+	free(njo->hash);
+	njo->hash = xcalloc(size, sizeof(ni_json_pair_t *));
+	njo->hsize = size;
+	for (i = 0; i < njo->count; ++i)
+		ni_json_object_hash_insert(njo, njo->data[i]);
+}
+
+static ni_json_pair_t *
+ni_json_object_hash_find(ni_json_object_t *njo, const char *name)
+{
+	unsigned int mask = njo->hsize - 1;
+	unsigned int pos = ni_json_object_hash_name(name) & mask;
+	ni_json_pair_t *pair;
+
+	while ((pair = njo->hash[pos])) {
+		if (ni_string_eq(pair->name, name))
+			return pair;
+		pos = (pos + 1) & mask;
+	}
+	return NULL;
+}
+
 static void
 ni_json_object_free(ni_json_object_t *njo)
 {
+	ni_json_object_hash_drop(njo);
 	while (njo->count) {
 		njo->count--;
 		ni_json_pair_free(njo->data[njo->count]);
@@ -297,6 +386,12 @@ ni_json_object_get_pair(ni_json_t *json, const char *name)
 	if (!(njo = ni_json_to_object(json)))
 		return NULL;
 
+	if (njo->count >= NI_JSON_OBJECT_HASH_MIN) {
+		if (!njo->hash)
+			ni_json_object_hash_build(njo);
+		return ni_json_object_hash_find(njo, name);
+	}
+
 	for (i = 0; i < njo->count; ++i) {
 		ni_json_pair_t *pair = njo->data[i];
 
@@ -372,6 +467,13 @@ ni_json_object_append(ni_json_t *json, const char *name, ni_json_t *value)
 		ni_json_object_realloc(njo, njo->count);
 
 	njo->data[njo->count++] = pair;
+
+	if (njo->hash) {
+		if (njo->count * 2 > njo->hsize)
+			ni_json_object_hash_build(njo);
+		else
+			ni_json_object_hash_insert(njo, pair);
+	}
 	return TRUE;
 }
 
@@ -419,6 +521,7 @@ ni_json_object_remove_at(ni_json_t *json, unsigned int pos)
 	if (!(njo = ni_json_to_object(json)) || pos >= njo->count)
 		return NULL;
 
+	ni_json_object_hash_drop(njo);
 	ret = ni_json_ref(njo->data[pos]->value);
 	ni_json_pair_free(njo->data[pos]);
 	njo->count--;
@@ -449,6 +552,9 @@ ni_json_object_remove(ni_json_t *json, const char *name)
 	if (!(njo = ni_json_to_object(json)))
 		return NULL;
 
+	if (njo->hash && !ni_json_object_hash_find(njo, name))
+		return NULL;
+
 	for (i = 0; i < njo->count; ++i) {
 		ni_json_pair_t *pair = njo->data[i];
 
@@ -1067,6 +1173,7 @@ ni_json_reader_stack_pop(ni_json_reader_t *jr)
 		stack->parent = NULL;
 		ni_string_free(&stack->name);
 		ni_json_free(stack->value);
+		free(stack);
 	}
 	return jr->stack;
 }
@@ -1669,6 +1776,7 @@ ni_json_reader_parse_pair(ni_json_reader_t *jr)
 		ni_json_reader_set_error(jr, "unexpected object pair token");
 		break;
 	}
+	ni_stringbuf_clear(&tokenValue);
 }
 
 static void
@@ -1718,6 +1826,7 @@ ni_json_reader_parse_initial(ni_json_reader_t *jr)
 		ni_json_reader_set_error(jr, "unexpected token");
 		break;
 	}
+	ni_stringbuf_clear(&tokenValue);
 }
 
 static ni_json_t *
@@ -1787,3 +1896,421 @@ ni_json_parse_string(const char *str)
 	return ni_json_parse_buffer(&buf);
 }
 
+
+/*
+ * event based scanning, without building a tree
+ */
+typedef struct ni_json_scanner {
+	ni_json_reader_t		reader;
+	ni_stringbuf_t			token;
+	ni_stringbuf_t			names;
+	ni_stringbuf_t			path;
+
+	ni_json_scan_fn_t		func;
+	void *				user_data;
+	ni_bool_t			stop;
+} ni_json_scanner_t;
+
+static int				ni_json_scanner_parse_value(ni_json_scanner_t *,
+						ni_json_token_type_t, int, unsigned int);
+
+static ni_json_token_type_t
+ni_json_scanner_next(ni_json_scanner_t *sc)
+{
+	ni_json_token_type_t token;
+
+	ni_stringbuf_truncate(&sc->token, 0);
+	ni_json_reader_skip_spaces(&sc->reader);
+	token = ni_json_get_token(&sc->reader, &sc->token);
+	if (ni_json_reader_get_state(&sc->reader) == Error)
+		return None;
+	return token;
+}
+
+static inline int
+ni_json_scanner_error(ni_json_scanner_t *sc, const char *what)
+{
+	ni_json_reader_set_error(&sc->reader, "%s at '%s'", what,
+			sc->path.string ? sc->path.string : "");
+	return -1;
+}
+
+static int
+ni_json_scanner_emit(ni_json_scanner_t *sc, ni_json_event_type_t event,
+		ni_json_type_t type, const char *value, int name, unsigned int depth)
+{
+	ni_json_event_t ev;
+
+	ev.event = event;
+	ev.type  = type;
+	ev.value = value;
+	ev.name  = name < 0 ? NULL : sc->names.string + name;
+	ev.path  = sc->path.string ? sc->path.string : "";
+	ev.depth = depth;
+
+	if (!sc->func(&ev, sc->user_data))
+		sc->stop = TRUE;
+	return sc->stop ? 1 : 0;
+}
+
+static void
+ni_json_scanner_path_add_name(ni_json_scanner_t *sc, const char *name)
+{
+	/* RFC 6901 json pointer reference token */
+	ni_stringbuf_putc(&sc->path, '/');
+	for ( ; *name; ++name) {
+		switch (*name) {
+		case '~':
+			ni_stringbuf_puts(&sc->path, "~0");
+			break;
+		case '/':
+			ni_stringbuf_puts(&sc->path, "~1");
+			break;
+		default:
+			ni_stringbuf_putc(&sc->path, *name);
+			break;
+		}
+	}
+}
+
+static int
+ni_json_scanner_parse_array(ni_json_scanner_t *sc, unsigned int depth)
+{
+	ni_json_token_type_t token;
+	unsigned int index;
+	size_t plen;
+	int rv;
+
+	if ((token = ni_json_scanner_next(sc)) == ArrayEnd)
+		return 0;
+
+	for (index = 0; ; ++index) {
+		plen = sc->path.len;
+		ni_stringbuf_printf(&sc->path, "/%u", index);
+		rv = ni_json_scanner_parse_value(sc, token, -1, depth);
+		ni_stringbuf_truncate(&sc->path, plen);
+		if (rv)
+			return rv;
+
+		switch (ni_json_scanner_next(sc)) {
+		case ArrayEnd:
+			return 0;
+		case Comma:
+			token = ni_json_scanner_next(sc);
+			break;
+		case EndOfFile:
+			return ni_json_scanner_error(sc, "unexpected end of file");
+		default:
+			return ni_json_scanner_error(sc, "missed array element separator");
+		}
+	}
+}
+
+static int
+ni_json_scanner_parse_object(ni_json_scanner_t *sc, unsigned int depth)
+{
+	ni_json_token_type_t token;
+	size_t plen, nlen;
+	int rv;
+
+	if ((token = ni_json_scanner_next(sc)) == ObjectEnd)
+		return 0;
+
+	for (;;) {
+		if (token != String)
+			return ni_json_scanner_error(sc, "expected object pair name");
+
+		/* keep the name while the value reuses the token buffer */
+		nlen = sc->names.len;
+		ni_stringbuf_put(&sc->names, sc->token.string, sc->token.len + 1);
+		plen = sc->path.len;
+		ni_json_scanner_path_add_name(sc, sc->token.string);
+
+		if (ni_json_scanner_next(sc) != Colon)
+			rv = ni_json_scanner_error(sc, "expected colon after object pair name");
+		else
+			rv = ni_json_scanner_parse_value(sc, ni_json_scanner_next(sc), nlen, depth);
+
+		ni_stringbuf_truncate(&sc->path, plen);
+		ni_stringbuf_truncate(&sc->names, nlen);
+		if (rv)
+			return rv;
+
+		switch (ni_json_scanner_next(sc)) {
+		case ObjectEnd:
+			return 0;
+		case Comma:
+			token = ni_json_scanner_next(sc);
+			break;
+		case EndOfFile:
+			return ni_json_scanner_error(sc, "unexpected end of file");
+		default:
+			return ni_json_scanner_error(sc, "missed object member separator or end");
+		}
+	}
+}
+
+static int
+ni_json_scanner_parse_value(ni_json_scanner_t *sc, ni_json_token_type_t token,
+				int name, unsigned int depth)
+{
+	ni_json_type_t type;
+	int rv;
+
+	switch (token) {
+	case Literal:
+		if (ni_string_eq(sc->token.string, "null"))
+			type = NI_JSON_TYPE_NULL;
+		else
+		if (ni_string_eq(sc->token.string, "true") ||
+		    ni_string_eq(sc->token.string, "false"))
+			type = NI_JSON_TYPE_BOOL;
+		else
+			return ni_json_scanner_error(sc, "invalid literal");
+		return ni_json_scanner_emit(sc, NI_JSON_EVENT_VALUE, type,
+					sc->token.string, name, depth);
+
+	case Number:
+		/* same as ni_json_new_number */
+		if (ni_string_contains(sc->token.string, "."))
+			type = NI_JSON_TYPE_DOUBLE;
+		else
+			type = NI_JSON_TYPE_INT64;
+		return ni_json_scanner_emit(sc, NI_JSON_EVENT_VALUE, type,
+					sc->token.string, name, depth);
+
+	case String:
+		return ni_json_scanner_emit(sc, NI_JSON_EVENT_VALUE, NI_JSON_TYPE_STRING,
+					sc->token.string ? sc->token.string : "", name, depth);
+
+	case ArrayBegin:
+		if (depth >= NI_JSON_SCAN_DEPTH_MAX)
+			return ni_json_scanner_error(sc, "nesting too deep");
+		if ((rv = ni_json_scanner_emit(sc, NI_JSON_EVENT_ARRAY_BEGIN,
+					NI_JSON_TYPE_ARRAY, NULL, name, depth)))
+			return rv;
+		if ((rv = ni_json_scanner_parse_array(sc, depth + 1)))
+			return rv;
+		return ni_json_scanner_emit(sc, NI_JSON_EVENT_ARRAY_END,
+					NI_JSON_TYPE_ARRAY, NULL, name, depth);
+
+	case ObjectBegin:
+		if (depth >= NI_JSON_SCAN_DEPTH_MAX)
+			return ni_json_scanner_error(sc, "nesting too deep");
+		if ((rv = ni_json_scanner_emit(sc, NI_JSON_EVENT_OBJECT_BEGIN,
+					NI_JSON_TYPE_OBJECT, NULL, name, depth)))
+			return rv;
+		if ((rv = ni_json_scanner_parse_object(sc, depth + 1)))
+			return rv;
+		return ni_json_scanner_emit(sc, NI_JSON_EVENT_OBJECT_END,
+					NI_JSON_TYPE_OBJECT, NULL, name, depth);
+
+	case EndOfFile:
+		return ni_json_scanner_error(sc, "unexpected end of file");
+
+	default:
+		return ni_json_scanner_error(sc, "unexpected token");
+	}
+}
+
+/*
+ * Scan a json document and report each value to func as it is seen.
+ * The path of the events is a RFC 6901 json pointer ("/ports/eth0").
+ * Scanning stops early when func returns FALSE.
+ *
+ * Returns 0 on success or early stop, -1 on parse errors.
+ */
+int
+ni_json_scan_buffer(ni_buffer_t *buf, ni_json_scan_fn_t func, void *user_data)
+{
+	ni_json_scanner_t sc;
+	int rv;
+
+	if (!func || !ni_json_reader_init_buffer(&sc.reader, buf))
+		return -1;
+
+	ni_stringbuf_init(&sc.token);
+	ni_stringbuf_init(&sc.names);
+	ni_stringbuf_init(&sc.path);
+	sc.func = func;
+	sc.user_data = user_data;
+	sc.stop = FALSE;
+
+	ni_json_reader_stack_new(&sc.reader, Initial);
+	rv = ni_json_scanner_parse_value(&sc, ni_json_scanner_next(&sc), -1, 0);
+	if (rv == 0 && ni_json_scanner_next(&sc) != EndOfFile)
+		rv = ni_json_scanner_error(&sc, "unexpected data after the value");
+
+	ni_stringbuf_destroy(&sc.token);
+	ni_stringbuf_destroy(&sc.names);
+	ni_stringbuf_destroy(&sc.path);
+	ni_json_reader_destroy(&sc.reader);
+	return rv < 0 ? -1 : 0;
+}
+
+int
+ni_json_scan_string(const char *str, ni_json_scan_fn_t func, void *user_data)
+{
+	ni_buffer_t buf;
+
+	if (ni_string_empty(str))
+		return -1;
+
+	ni_buffer_init_reader(&buf, (char *)str, ni_string_len(str));
+	return ni_json_scan_buffer(&buf, func, user_data);
+}
+
+/*
+ * Extract the values of selected paths, building just their subtrees
+ */
+typedef struct ni_json_extract {
+	const char * const *		paths;
+	ni_json_t **			values;
+	unsigned int			count;
+	unsigned int			found;
+
+	unsigned int			current;
+	unsigned int			depth;
+	unsigned int			size;
+	ni_json_t **			stack;
+	ni_bool_t			error;
+} ni_json_extract_t;
+
+static void
+ni_json_extract_push(ni_json_extract_t *ex, ni_json_t *value)
+{
+	if (ex->depth == ex->size) {
+		ex->size += 16;
+		ex->stack = xrealloc(ex->stack, ex->size * sizeof(ni_json_t *));
+	}
+	ex->stack[ex->depth++] = value;
+}
+
+static ni_json_t *
+ni_json_extract_new_value(const ni_json_event_t *ev)
+{
+	switch (ev->type) {
+	case NI_JSON_TYPE_NULL:
+	case NI_JSON_TYPE_BOOL:
+		return ni_json_new_literal(ev->value);
+	case NI_JSON_TYPE_INT64:
+	case NI_JSON_TYPE_DOUBLE:
+		return ni_json_new_number(ev->value);
+	case NI_JSON_TYPE_STRING:
+		return ni_json_new_string(ev->value);
+	case NI_JSON_TYPE_OBJECT:
+		return ni_json_new_object();
+	case NI_JSON_TYPE_ARRAY:
+		return ni_json_new_array();
+	default:
+		return NULL;
+	}
+}
+
+static ni_bool_t
+ni_json_extract_event(const ni_json_event_t *ev, void *user_data)
+{
+	ni_json_extract_t *ex = user_data;
+	ni_json_t *value, *parent;
+	unsigned int i;
+
+	if (ev->event == NI_JSON_EVENT_OBJECT_END || ev->event == NI_JSON_EVENT_ARRAY_END) {
+		if (!ex->depth)
+			return TRUE;
+
+		if (--ex->depth == 0) {
+			ex->values[ex->current] = ex->stack[0];
+			ex->stack[0] = NULL;
+			ex->found++;
+		}
+		return ex->found < ex->count;
+	}
+
+	if (!ex->depth) {
+		for (i = 0; i < ex->count; ++i) {
+			if (!ex->values[i] && ni_string_eq(ex->paths[i], ev->path))
+				break;
+		}
+		if (i == ex->count)
+			return TRUE;
+
+		if (!(value = ni_json_extract_new_value(ev))) {
+			ex->error = TRUE;
+			return FALSE;
+		}
+
+		if (ev->event == NI_JSON_EVENT_VALUE) {
+			ex->values[i] = value;
+			ex->found++;
+			return ex->found < ex->count;
+		}
+
+		ex->current = i;
+		ni_json_extract_push(ex, value);
+		return TRUE;
+	}
+
+	if (!(value = ni_json_extract_new_value(ev))) {
+		ex->error = TRUE;
+		return FALSE;
+	}
+
+	parent = ex->stack[ex->depth - 1];
+	if (!(ev->name ? ni_json_object_set(parent, ev->name, value) :
+			 ni_json_array_append(parent, value))) {
+		ni_json_free(value);
+		ex->error = TRUE;
+		return FALSE;
+	}
+
+	if (ev->event != NI_JSON_EVENT_VALUE)
+		ni_json_extract_push(ex, value);
+	return TRUE;
+}
+
+/*
+ * Extract the values of the NULL terminated list of json pointer
+ * paths, e.g. { "/runner/name", "/ports", NULL }, into the values
+ * array (with the same number of entries). Paths not found in the
+ * document are set to NULL.
+ *
+ * Returns the number of values found or -1 on error.
+ */
+int
+ni_json_extract_string(const char *str, const char * const *paths, ni_json_t **values)
+{
+	ni_json_extract_t ex;
+	unsigned int i;
+	int rv;
+
+	if (!paths || !values)
+		return -1;
+
+	memset(&ex, 0, sizeof(ex));
+	ex.paths = paths;
+	ex.values = values;
+	while (paths[ex.count])
+		values[ex.count++] = NULL;
+
+	if (ex.count == 0)
+		return 0;
+
+	rv = ni_json_scan_string(str, ni_json_extract_event, &ex);
+	if (ex.depth) {
+		/* stopped on an error while building a subtree */
+		ni_json_free(ex.stack[0]);
+		rv = -1;
+	}
+	free(ex.stack);
+	if (ex.error)
+		rv = -1;
+
+	if (rv < 0) {
+		for (i = 0; i < ex.count; ++i) {
+			ni_json_free(values[i]);
+			values[i] = NULL;
+		}
+		return -1;
+	}
+	return ex.found;
+}
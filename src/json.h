@@ -74,6 +74,7 @@ extern	ni_bool_t			ni_json_bool_get(ni_json_t *, ni_bool_t *);
 extern	ni_bool_t			ni_json_int64_get(ni_json_t *, int64_t *);
 extern	ni_bool_t			ni_json_double_get(ni_json_t *, double *);
 extern	ni_bool_t			ni_json_string_get(ni_json_t *, char **);
+extern	const char *			ni_json_string_value(ni_json_t *);
 
 extern	ni_json_t *			ni_json_array_get(ni_json_t *, unsigned int);
 extern	ni_json_t *			ni_json_array_ref(ni_json_t *, unsigned int);
@@ -118,4 +119,33 @@ extern	const char *			ni_json_format_string(ni_stringbuf_t *buf,
 
 extern	ni_json_t *			ni_json_parse_string(const char *str);
 
+/*
+ * event based scanning and path extraction without a complete tree
+ */
+typedef enum {
+	NI_JSON_EVENT_VALUE = 0U,
+	NI_JSON_EVENT_OBJECT_BEGIN,
+	NI_JSON_EVENT_OBJECT_END,
+	NI_JSON_EVENT_ARRAY_BEGIN,
+	NI_JSON_EVENT_ARRAY_END,
+} ni_json_event_type_t;
+
+typedef struct ni_json_event {
+	ni_json_event_type_t		event;
+	ni_json_type_t			type;	/* of the value			*/
+	const char *			value;	/* scalar value text		*/
+	const char *			name;	/* object member name		*/
+	const char *			path;	/* RFC 6901 json pointer	*/
+	unsigned int			depth;
+} ni_json_event_t;
+
+typedef ni_bool_t			(*ni_json_scan_fn_t)(const ni_json_event_t *, void *);
+
+extern	int				ni_json_scan_string(const char *str,
+							ni_json_scan_fn_t func,
+							void *user_data);
+extern	int				ni_json_extract_string(const char *str,
+							const char * const *paths,
+							ni_json_t **values);
+
 #endif /* NI_JSON_H */
@@ -33,6 +33,7 @@
 #include "kernel.h"
 #include <wicked/ppp.h>
 #include <wicked/tuntap.h>
+#include <wicked/metrics.h>
 
 /* FIXME: we should really make this configurable */
 #ifndef CONFIG_TUNTAP_CHRDEV_PATH
@@ -593,22 +594,27 @@ retry:
 int
 ni_nl_talk(struct nl_msg *msg, struct ni_nlmsg_list *list)
 {
+	struct timeval start;
+	int rv;
 
 	if (!__ni_global_netlink) {
 		ni_error("%s: no netlink socket", __func__);
 		return -NLE_BAD_SOCK;
 	}
 
+	ni_metrics_begin(&start);
 	if (list == NULL) {
-		return __ni_nl_talk(__ni_global_netlink, msg, NULL, NULL);
+		rv = __ni_nl_talk(__ni_global_netlink, msg, NULL, NULL);
 	} else {
 		struct __ni_nl_dump_state data = {
 			.msg_type = -1,
 			.list = list,
 		};
 
-		return __ni_nl_talk(__ni_global_netlink, msg, __ni_nl_dump_valid, &data);
+		rv = __ni_nl_talk(__ni_global_netlink, msg, __ni_nl_dump_valid, &data);
 	}
+	ni_metrics_end(NI_METRIC_NETLINK_TALK, &start);
+	return rv;
 }
 
 #define ni_t2n(x)	[x] = #x
@@ -13,7 +13,14 @@
 #include <string.h>
 #include <syslog.h>
 #include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <paths.h>
+#include <endian.h>
 #include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
 #include <time.h>
 
 #include <wicked/logging.h>
@@ -35,6 +42,46 @@ static unsigned int	ni_log_syslog;
 static const char *	ni_log_ident;
 static unsigned int	ni_log_opts;
 
+/*
+ * Log records and the optional asynchronous ring.
+ *
+ * The message is formatted when it is logged (the arguments are often
+ * temporary buffers), but writing it to the sink may be deferred: the
+ * records are queued in the ring and written in batches by ni_log_flush,
+ * which the main loop calls before it goes to sleep. A sink that is
+ * backed up makes the records wait in the ring; when the ring is full,
+ * new messages are counted as dropped instead of blocking the daemon.
+ */
+#define NI_LOG_RECORD_MAX	1024
+#define NI_LOG_RING_SIZE	1024
+#define NI_LOG_RING_MIN		16
+#define NI_LOG_JOURNAL_SOCKET	"/run/systemd/journal/socket"
+
+typedef struct ni_log_record {
+	struct timeval		time;
+	int			prio;
+	const char *		tag;
+	const char *		end;
+	char			msg[NI_LOG_RECORD_MAX];
+} ni_log_record_t;
+
+typedef int			ni_log_sink_t(const ni_log_record_t *);
+
+static struct ni_log_ring {
+	ni_log_record_t *	records;
+	unsigned int		size;
+	unsigned int		head;
+	unsigned int		count;
+	unsigned long		dropped;
+	pid_t			owner;
+} ni_log_ring;
+
+static unsigned int	ni_log_async;
+static unsigned long	ni_log_drops;
+static ni_log_sink_t *	ni_log_sink;
+static int		ni_log_fd = -1;
+static char *		ni_log_file;
+
 static void		__ni_log_level_set(unsigned int level);
 
 /*
@@ -251,6 +298,16 @@ ni_log_init(void)
 	if ((var = getenv("WICKED_LOG_LEVEL"))) {
 		ni_log_level_set(var);
 	}
+
+	if (!ni_string_empty(var = getenv("WICKED_LOG_ASYNC"))) {
+		ni_bool_t enable;
+
+		if (ni_parse_boolean(var, &enable) == 0)
+			ni_log_async = enable ? NI_LOG_RING_SIZE : 0;
+		else
+		if (ni_parse_uint(var, &ni_log_async, 0) == 0 && ni_log_async)
+			ni_log_async = max_t(unsigned int, ni_log_async, NI_LOG_RING_MIN);
+	}
 }
 
 unsigned int
@@ -306,6 +363,18 @@ ni_log_level_set(const char *name)
 void
 ni_log_close(void)
 {
+	ni_log_flush();
+	if (ni_log_ring.records) {
+		free(ni_log_ring.records);
+		memset(&ni_log_ring, 0, sizeof(ni_log_ring));
+	}
+	if (ni_log_fd >= 0) {
+		close(ni_log_fd);
+		ni_log_fd = -1;
+	}
+	ni_string_free(&ni_log_file);
+	ni_log_sink = NULL;
+
 	if (ni_log_syslog) {
 		closelog();
 	}
@@ -314,9 +383,34 @@ ni_log_close(void)
 	ni_log_opts = 0;
 }
 
+static ni_bool_t
+__ni_log_file_open(void)
+{
+	int fd;
+
+	fd = open(ni_log_file, O_WRONLY | O_CREAT | O_APPEND | O_NONBLOCK | O_CLOEXEC, 0640);
+	if (fd < 0)
+		return FALSE;
+
+	if (ni_log_fd >= 0)
+		close(ni_log_fd);
+	ni_log_fd = fd;
+	return TRUE;
+}
+
 void
 ni_log_reopen(void)
 {
+	ni_log_flush();
+	if (ni_log_file) {
+		/* e.g. after logrotate moved the file away */
+		__ni_log_file_open();
+	} else
+	if (ni_log_fd >= 0) {
+		close(ni_log_fd);
+		ni_log_fd = -1;
+	}
+
 	if (ni_log_syslog) {
 		closelog();
 		openlog(ni_log_ident, ni_log_opts, ni_log_syslog);
@@ -410,6 +504,307 @@ __ni_syslog_parse_args(const char *args, unsigned int *options, unsigned int *fa
 	return TRUE;
 }
 
+/*
+ * Log sinks used for log records. They return 0 when the record has
+ * been written (or cannot be written at all, in which case it is
+ * counted as dropped when the sink returns -1), and 1 when the sink
+ * would block and the record should be retried later.
+ */
+static size_t
+__ni_log_prefix(char *buf, size_t size, const struct timeval *tv, unsigned int opts)
+{
+	size_t len = 0;
+	int n = 0;
+
+	*buf = '\0';
+
+	/* rfc5424 / rfc3339 timestamp with ms precision, e.g.:
+	 * 	2013-11-07T19:29:38.663870+01:00
+	 */
+	if (opts & NI_LOG_TIME) {
+		struct tm lt;
+		char tzsign;
+
+		localtime_r(&tv->tv_sec, &lt);
+		if (lt.tm_gmtoff < 0) {
+			lt.tm_gmtoff *= -1;
+			tzsign = '-';
+		} else {
+			tzsign = '+';
+		}
+		n = snprintf(buf, size, "%04d-%02d-%02dT%02d:%02d:%02d.%06ld%c%02ld:%02ld ",
+				lt.tm_year + 1900, lt.tm_mon + 1, lt.tm_mday,
+				lt.tm_hour, lt.tm_min, lt.tm_sec, (long)tv->tv_usec,
+				tzsign, lt.tm_gmtoff/3600, (lt.tm_gmtoff%3600)/60);
+		if (n < 0 || (size_t)n >= size)
+			return len;
+		len += n;
+	}
+
+	if (opts & NI_LOG_PID) {
+		if (opts & NI_LOG_IDENT)
+			n = snprintf(buf + len, size - len, "%s[%d]: ", ni_log_ident, getpid());
+		else
+			n = snprintf(buf + len, size - len, "[%d]: ", getpid());
+	} else if (opts & NI_LOG_IDENT) {
+		n = snprintf(buf + len, size - len, "%s: ", ni_log_ident);
+	} else {
+		n = 0;
+	}
+	if (n > 0 && (size_t)n < size - len)
+		len += n;
+	return len;
+}
+
+static int
+__ni_log_sink_stderr(const ni_log_record_t *rec)
+{
+	char prefix[128];
+
+	__ni_log_prefix(prefix, sizeof(prefix), &rec->time, ni_log_opts);
+	fprintf(stderr, "%s%s%s%s\n", prefix, rec->tag, rec->msg, rec->end);
+	return 0;
+}
+
+static int
+__ni_log_sink_file(const ni_log_record_t *rec)
+{
+	char prefix[128];
+	struct iovec iov[5];
+
+	if (ni_log_fd < 0)
+		return -1;
+
+	iov[0].iov_len = __ni_log_prefix(prefix, sizeof(prefix), &rec->time,
+					NI_LOG_TIME | NI_LOG_PID | NI_LOG_IDENT);
+	iov[0].iov_base = prefix;
+	iov[1].iov_base = (char *)rec->tag;
+	iov[1].iov_len = strlen(rec->tag);
+	iov[2].iov_base = (char *)rec->msg;
+	iov[2].iov_len = strlen(rec->msg);
+	iov[3].iov_base = (char *)rec->end;
+	iov[3].iov_len = strlen(rec->end);
+	iov[4].iov_base = "\n";
+	iov[4].iov_len = 1;
+
+	if (writev(ni_log_fd, iov, 5) >= 0)
+		return 0;
+	return errno == EAGAIN || errno == EWOULDBLOCK ? 1 : -1;
+}
+
+static int
+__ni_log_send(const char *path, struct iovec *iov, size_t iovlen)
+{
+	struct sockaddr_un sun;
+	struct msghdr msg;
+
+	if (ni_log_fd < 0) {
+		ni_log_fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		if (ni_log_fd < 0)
+			return -1;
+	}
+
+	/* unconnected, so a restarted log daemon is picked up transparently */
+	memset(&sun, 0, sizeof(sun));
+	sun.sun_family = AF_UNIX;
+	strncpy(sun.sun_path, path, sizeof(sun.sun_path) - 1);
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_name = &sun;
+	msg.msg_namelen = sizeof(sun);
+	msg.msg_iov = iov;
+	msg.msg_iovlen = iovlen;
+
+	if (sendmsg(ni_log_fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL) >= 0)
+		return 0;
+	return errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS ? 1 : -1;
+}
+
+static int
+__ni_log_sink_syslog(const ni_log_record_t *rec)
+{
+	char header[128], stamp[32];
+	struct iovec iov[2];
+	struct tm lt;
+	int rv, n;
+
+	/* rfc3164 message as sent by syslog(3), but without blocking */
+	localtime_r(&rec->time.tv_sec, &lt);
+	strftime(stamp, sizeof(stamp), "%b %e %H:%M:%S", &lt);
+	if (ni_log_opts & LOG_PID)
+		n = snprintf(header, sizeof(header), "<%d>%s %s[%d]: ", ni_log_syslog | rec->prio,
+				stamp, ni_log_ident, getpid());
+	else
+		n = snprintf(header, sizeof(header), "<%d>%s %s: ", ni_log_syslog | rec->prio,
+				stamp, ni_log_ident);
+	if (n < 0 || (size_t)n >= sizeof(header))
+		return -1;
+
+	iov[0].iov_base = header;
+	iov[0].iov_len = n;
+	iov[1].iov_base = (char *)rec->msg;
+	iov[1].iov_len = strlen(rec->msg);
+
+	if ((rv = __ni_log_send(_PATH_LOG, iov, 2)) == 0 && (ni_log_opts & LOG_PERROR))
+		fprintf(stderr, "%s: %s\n", ni_log_ident, rec->msg);
+	return rv;
+}
+
+static int
+__ni_log_sink_journal(const ni_log_record_t *rec)
+{
+	char header[256];
+	struct iovec iov[4];
+	uint64_t size;
+	size_t len;
+	int n;
+
+	/* native journal protocol, see systemd's "Native Journal Protocol" */
+	n = snprintf(header, sizeof(header),
+			"PRIORITY=%d\nSYSLOG_FACILITY=%d\nSYSLOG_IDENTIFIER=%s\n",
+			rec->prio, LOG_DAEMON >> 3, ni_log_ident ? ni_log_ident : "wicked");
+	if (n < 0 || (size_t)n >= sizeof(header))
+		return -1;
+
+	iov[0].iov_base = header;
+	iov[0].iov_len = n;
+	len = strlen(rec->msg);
+	if (!memchr(rec->msg, '\n', len)) {
+		iov[1].iov_base = "MESSAGE=";
+		iov[1].iov_len = sizeof("MESSAGE=") - 1;
+		iov[2].iov_base = (char *)rec->msg;
+		iov[2].iov_len = len;
+		iov[3].iov_base = "\n";
+		iov[3].iov_len = 1;
+		return __ni_log_send(NI_LOG_JOURNAL_SOCKET, iov, 4);
+	} else {
+		/* multi-line: "MESSAGE\n", 64bit LE length, data, "\n" */
+		char field[sizeof("MESSAGE\n") - 1 + sizeof(size)];
+
+		size = htole64(len);
+		memcpy(field, "MESSAGE\n", sizeof("MESSAGE\n") - 1);
+		memcpy(field + sizeof("MESSAGE\n") - 1, &size, sizeof(size));
+		iov[1].iov_base = field;
+		iov[1].iov_len = sizeof(field);
+		iov[2].iov_base = (char *)rec->msg;
+		iov[2].iov_len = len;
+		iov[3].iov_base = "\n";
+		iov[3].iov_len = 1;
+		return __ni_log_send(NI_LOG_JOURNAL_SOCKET, iov, 4);
+	}
+}
+
+static void
+__ni_log_atexit(void)
+{
+	ni_log_flush();
+}
+
+static void
+__ni_log_ring_init(unsigned int size)
+{
+	static ni_bool_t atexit_done;
+	struct ni_log_ring *ring = &ni_log_ring;
+
+	if (!size || ring->records)
+		return;
+
+	if (!(ring->records = calloc(size, sizeof(ring->records[0]))))
+		return;
+	ring->size = size;
+	ring->owner = getpid();
+
+	if (!atexit_done) {
+		atexit(__ni_log_atexit);
+		atexit_done = TRUE;
+	}
+}
+
+/*
+ * Write queued records to the sink. Returns the number of records
+ * still waiting because the sink would block.
+ */
+int
+ni_log_flush(void)
+{
+	struct ni_log_ring *ring = &ni_log_ring;
+	ni_log_record_t note;
+	int rv;
+
+	if (!ring->records || !ni_log_sink || ring->owner != getpid())
+		return 0;
+
+	while (ring->count) {
+		if ((rv = ni_log_sink(&ring->records[ring->head])) > 0)
+			return ring->count;
+		if (rv < 0)
+			ni_log_drops++;
+
+		ring->head = (ring->head + 1) % ring->size;
+		ring->count--;
+	}
+
+	if (ring->dropped) {
+		gettimeofday(&note.time, NULL);
+		note.prio = LOG_WARNING;
+		note.tag = "Warning: ";
+		note.end = "";
+		snprintf(note.msg, sizeof(note.msg),
+				"log sink was too slow, %lu messages dropped",
+				ring->dropped);
+		if (ni_log_sink(&note) > 0)
+			return 1;
+		ring->dropped = 0;
+	}
+	return 0;
+}
+
+unsigned long
+ni_log_dropped(void)
+{
+	return ni_log_drops;
+}
+
+static void
+__ni_log_record(int prio, const char *tag, const char *fmt, va_list ap, const char *end)
+{
+	struct ni_log_ring *ring = &ni_log_ring;
+	ni_log_record_t single, *rec = &single;
+
+	if (ring->records) {
+		if (ring->owner != getpid()) {
+			/* forked child: the queued records belong to the parent */
+			ring->owner = getpid();
+			ring->head = ring->count = 0;
+			ring->dropped = 0;
+		}
+		if (ring->count == ring->size && prio <= LOG_ERR)
+			ni_log_flush();
+		if (ring->count == ring->size) {
+			ring->dropped++;
+			ni_log_drops++;
+			return;
+		}
+		rec = &ring->records[(ring->head + ring->count) % ring->size];
+	}
+
+	gettimeofday(&rec->time, NULL);
+	rec->prio = prio;
+	rec->tag = tag;
+	rec->end = end;
+	vsnprintf(rec->msg, sizeof(rec->msg), fmt, ap);
+
+	if (rec != &single) {
+		ring->count++;
+		/* errors are not held back */
+		if (prio <= LOG_ERR)
+			ni_log_flush();
+	} else
+	if (ni_log_sink(rec) != 0) {
+		ni_log_drops++;
+	}
+}
+
 static ni_bool_t
 ni_log_destination_syslog(const char *progname, const char *args)
 {
@@ -421,6 +816,10 @@ ni_log_destination_syslog(const char *progname, const char *args)
 
 	ni_log_ident = progname;
 	openlog(ni_log_ident, ni_log_opts, ni_log_syslog);
+	if (ni_log_async) {
+		ni_log_sink = __ni_log_sink_syslog;
+		__ni_log_ring_init(ni_log_async);
+	}
 	return TRUE;
 }
 
@@ -432,6 +831,43 @@ ni_log_destination_stderr(const char *progname, const char *args)
 	ni_log_ident = progname;
 	if (!__ni_stderr_parse_args(args ? args : "", &ni_log_opts))
 		return FALSE;
+	if (ni_log_async) {
+		ni_log_sink = __ni_log_sink_stderr;
+		__ni_log_ring_init(ni_log_async);
+	}
+	return TRUE;
+}
+
+static ni_bool_t
+ni_log_destination_journal(const char *progname, const char *args)
+{
+	ni_log_close();
+
+	if (!ni_string_empty(args))
+		return FALSE;
+
+	ni_log_ident = progname;
+	ni_log_sink = __ni_log_sink_journal;
+	__ni_log_ring_init(ni_log_async);
+	return TRUE;
+}
+
+static ni_bool_t
+ni_log_destination_file(const char *progname, const char *args)
+{
+	ni_log_close();
+
+	if (ni_string_empty(args) || *args != '/')
+		return FALSE;
+
+	ni_log_ident = progname;
+	ni_string_dup(&ni_log_file, args);
+	if (!__ni_log_file_open()) {
+		ni_string_free(&ni_log_file);
+		return FALSE;
+	}
+	ni_log_sink = __ni_log_sink_file;
+	__ni_log_ring_init(ni_log_async);
 	return TRUE;
 }
 
@@ -442,9 +878,11 @@ ni_log_destination(const char *progname, const char *destination)
 		const char *name;
 		ni_bool_t (*func)(const char *, const char *);
 	} *dest, destination_map[] = {
-		{ "stderr", ni_log_destination_stderr },
-		{ "syslog", ni_log_destination_syslog },
-		{ NULL,     NULL                      }
+		{ "stderr",  ni_log_destination_stderr  },
+		{ "syslog",  ni_log_destination_syslog  },
+		{ "journal", ni_log_destination_journal },
+		{ "file",    ni_log_destination_file    },
+		{ NULL,      NULL                       }
 	};
 	const char *options = "";
 	size_t len;
@@ -455,6 +893,8 @@ ni_log_destination(const char *progname, const char *destination)
 	/*
 	 * stderr[:[options]]
 	 * syslog[:[facility]:[options]]
+	 * journal
+	 * file:<path>
 	 */
 	len = strcspn(destination, ":");
 	if (destination[len] == ':') {
@@ -472,42 +912,30 @@ ni_log_destination(const char *progname, const char *destination)
 static inline void
 __ni_log_stderr(const char *tag, const char *fmt, va_list ap, const char *end)
 {
-	/* rfc5424 / rfc3339 timestamp with ms precision, e.g.:
-	 * 	2013-11-07T19:29:38.663870+01:00
-	 */
-	if (ni_log_opts & NI_LOG_TIME) {
-		struct timeval tv;
-		struct tm lt;
-		char tzsign;
+	char prefix[128];
+	struct timeval tv;
 
+	if (ni_log_opts & NI_LOG_TIME)
 		gettimeofday(&tv, NULL);
-		localtime_r(&tv.tv_sec, &lt);
-		if (lt.tm_gmtoff < 0) {
-			lt.tm_gmtoff *= -1;
-			tzsign = '-';
-		} else {
-			tzsign = '+';
-		}
-		fprintf(stderr, "%04d-%02d-%02dT%02d:%02d:%02d.%06ld%c%02ld:%02ld ",
-				lt.tm_year + 1900, lt.tm_mon + 1, lt.tm_mday,
-				lt.tm_hour, lt.tm_min, lt.tm_sec, tv.tv_usec,
-				tzsign, lt.tm_gmtoff/3600, (lt.tm_gmtoff%3600)/60);
-	}
+	__ni_log_prefix(prefix, sizeof(prefix), &tv, ni_log_opts);
 
-	if (ni_log_opts & NI_LOG_PID) {
-		if (ni_log_opts & NI_LOG_IDENT)
-			fprintf(stderr, "%s[%d]: ", ni_log_ident, getpid());
-		else
-			fprintf(stderr, "[%d]: ", getpid());
-	} else if (ni_log_opts & NI_LOG_IDENT) {
-		fprintf(stderr, "%s: ", ni_log_ident);
-	}
-
-	fprintf(stderr, "%s", tag);
+	fprintf(stderr, "%s%s", prefix, tag);
 	vfprintf(stderr, fmt, ap);
 	fprintf(stderr, "%s\n", end);
 }
 
+static void
+__ni_log_message(int prio, const char *tag, const char *fmt, va_list ap, const char *end)
+{
+	if (ni_log_sink) {
+		__ni_log_record(prio, tag, fmt, ap, end);
+	} else if (!ni_log_syslog) {
+		__ni_log_stderr(tag, fmt, ap, end);
+	} else {
+		vsyslog(prio, fmt, ap);
+	}
+}
+
 void
 ni_info(const char *fmt, ...)
 {
@@ -517,11 +945,7 @@ ni_info(const char *fmt, ...)
 		return;
 
 	va_start(ap, fmt);
-	if (!ni_log_syslog) {
-		__ni_log_stderr("Info: ", fmt, ap, "");
-	} else {
-		vsyslog(LOG_INFO, fmt, ap);
-	}
+	__ni_log_message(LOG_INFO, "Info: ", fmt, ap, "");
 	va_end(ap);
 }
 
@@ -534,11 +958,7 @@ ni_note(const char *fmt, ...)
 		return;
 
 	va_start(ap, fmt);
-	if (!ni_log_syslog) {
-		__ni_log_stderr("Notice: ", fmt, ap, "");
-	} else {
-		vsyslog(LOG_NOTICE, fmt, ap);
-	}
+	__ni_log_message(LOG_NOTICE, "Notice: ", fmt, ap, "");
 	va_end(ap);
 }
 
@@ -551,11 +971,7 @@ ni_warn(const char *fmt, ...)
 		return;
 
 	va_start(ap, fmt);
-	if (!ni_log_syslog) {
-		__ni_log_stderr("Warning: ", fmt, ap, "");
-	} else {
-		vsyslog(LOG_WARNING, fmt, ap);
-	}
+	__ni_log_message(LOG_WARNING, "Warning: ", fmt, ap, "");
 	va_end(ap);
 }
 
@@ -565,11 +981,7 @@ ni_error(const char *fmt, ...)
 	va_list ap;
 
 	va_start(ap, fmt);
-	if (!ni_log_syslog) {
-		__ni_log_stderr("Error: ", fmt, ap, "");
-	} else {
-		vsyslog(LOG_ERR, fmt, ap);
-	}
+	__ni_log_message(LOG_ERR, "Error: ", fmt, ap, "");
 	va_end(ap);
 }
 
@@ -583,11 +995,7 @@ ni_error_extra(const char *fmt, ...)
 	va_list ap;
 
 	va_start(ap, fmt);
-	if (!ni_log_syslog) {
-		__ni_log_stderr("       ", fmt, ap, "");
-	} else {
-		vsyslog(LOG_ERR, fmt, ap);
-	}
+	__ni_log_message(LOG_ERR, "       ", fmt, ap, "");
 	va_end(ap);
 }
 
@@ -600,11 +1008,7 @@ ni_trace(const char *fmt, ...)
 		return;
 
 	va_start(ap, fmt);
-	if (!ni_log_syslog) {
-		__ni_log_stderr("::: ", fmt, ap, "");
-	} else {
-		vsyslog(LOG_DEBUG, fmt, ap);
-	}
+	__ni_log_message(LOG_DEBUG, "::: ", fmt, ap, "");
 	va_end(ap);
 }
 
@@ -614,13 +1018,10 @@ ni_fatal(const char *fmt, ...)
 	va_list ap;
 
 	va_start(ap, fmt);
-	if (!ni_log_syslog) {
-		__ni_log_stderr("FATAL ERROR: *** ", fmt, ap, " ***");
-	} else {
-		vsyslog(LOG_CRIT, fmt, ap);
-	}
+	__ni_log_message(LOG_CRIT, "FATAL ERROR: *** ", fmt, ap, " ***");
 	va_end(ap);
 
+	ni_log_flush();
 	exit(1);
 }
 
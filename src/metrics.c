@@ -0,0 +1,267 @@
+/*
+ *	Runtime metrics for the wicked daemons
+ *
+ *	Copyright (C) 2026 SUSE Linux GmbH, Nuernberg, Germany.
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	This program is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along
+ *	with this program; if not, see <http://www.gnu.org/licenses/> or write
+ *	to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *	Boston, MA 02110-1301 USA.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include <wicked/netinfo.h>
+#include <wicked/metrics.h>
+#include <wicked/logging.h>
+#include <wicked/addrconf.h>
+#include <wicked/system.h>
+#include <wicked/util.h>
+
+ni_bool_t			ni_metrics_enabled = FALSE;
+
+static ni_metric_t		ni_metrics[__NI_METRIC_MAX] = {
+	[NI_METRIC_SOCKET_DISPATCH]	= {
+		"socket_dispatch_seconds",	NI_METRIC_HISTOGRAM,
+		"Time spent handling socket events per main loop iteration"
+	},
+	[NI_METRIC_TIMER_CALLBACK]	= {
+		"timer_callback_seconds",	NI_METRIC_HISTOGRAM,
+		"Time spent in expired timer callbacks"
+	},
+	[NI_METRIC_RTEVENT_PROCESS]	= {
+		"rtevent_process_seconds",	NI_METRIC_HISTOGRAM,
+		"Time spent processing a rtnetlink event message"
+	},
+	[NI_METRIC_NETLINK_TALK]	= {
+		"netlink_talk_seconds",		NI_METRIC_HISTOGRAM,
+		"Round trip time of netlink requests"
+	},
+	[NI_METRIC_DBUS_DISPATCH]	= {
+		"dbus_dispatch_seconds",	NI_METRIC_HISTOGRAM,
+		"Time spent dispatching incoming D-Bus messages"
+	},
+	[NI_METRIC_PROCESS_START]	= {
+		"process_start_seconds",	NI_METRIC_HISTOGRAM,
+		"Time needed to start a subprocess"
+	},
+	[NI_METRIC_DHCP4_TRANSITIONS]	= {
+		"dhcp4_state_transitions",	NI_METRIC_COUNTER,
+		"DHCPv4 state machine transitions"
+	},
+	[NI_METRIC_DHCP6_TRANSITIONS]	= {
+		"dhcp6_state_transitions",	NI_METRIC_COUNTER,
+		"DHCPv6 state machine transitions"
+	},
+	[NI_METRIC_UPDATER_CALLS]	= {
+		"updater_calls",		NI_METRIC_COUNTER,
+		"System updater script executions since start"
+	},
+	[NI_METRIC_UPDATER_MERGED]	= {
+		"updater_merged_jobs",		NI_METRIC_COUNTER,
+		"Updater jobs merged into a batch call of another job"
+	},
+	[NI_METRIC_LOG_DROPPED]		= {
+		"log_dropped_messages",		NI_METRIC_COUNTER,
+		"Log messages dropped because the log sink was too slow"
+	},
+};
+
+static const ni_intmap_t	ni_metric_type_names[] = {
+	{ "counter",	NI_METRIC_COUNTER	},
+	{ "gauge",	NI_METRIC_GAUGE		},
+	{ "histogram",	NI_METRIC_HISTOGRAM	},
+	{ NULL,		0			}
+};
+
+const char *
+ni_metric_type_to_name(ni_metric_type_t type)
+{
+	return ni_format_uint_mapped(type, ni_metric_type_names);
+}
+
+void
+ni_metrics_init(void)
+{
+	const char *var;
+	ni_bool_t enable;
+
+	if ((var = getenv("WICKED_METRICS")) && ni_parse_boolean(var, &enable) == 0)
+		ni_metrics_enabled = enable;
+}
+
+void
+ni_metrics_enable(ni_bool_t enable)
+{
+	ni_metrics_enabled = enable;
+}
+
+void
+ni_metrics_reset(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < __NI_METRIC_MAX; ++i) {
+		ni_metric_t *m = &ni_metrics[i];
+
+		m->value = 0;
+		m->sum = 0;
+		memset(m->bucket, 0, sizeof(m->bucket));
+	}
+}
+
+/*
+ * Counters maintained elsewhere are collected on demand
+ */
+static void
+__ni_metrics_collect(void)
+{
+	unsigned long calls, merged, sum_calls = 0, sum_merged = 0;
+	unsigned int kind;
+
+	for (kind = 0; kind < __NI_ADDRCONF_UPDATER_MAX; ++kind) {
+		calls = merged = 0;
+		ni_system_updater_stats(kind, &calls, &merged);
+		sum_calls += calls;
+		sum_merged += merged;
+	}
+	ni_metrics[NI_METRIC_UPDATER_CALLS].value = sum_calls;
+	ni_metrics[NI_METRIC_UPDATER_MERGED].value = sum_merged;
+	ni_metrics[NI_METRIC_LOG_DROPPED].value = ni_log_dropped();
+}
+
+const ni_metric_t *
+ni_metrics_get(ni_metric_id_t id)
+{
+	if (id >= __NI_METRIC_MAX)
+		return NULL;
+
+	__ni_metrics_collect();
+	return &ni_metrics[id];
+}
+
+/*
+ * Upper bound of the histogram bucket in usec; the last one is +Inf
+ */
+uint64_t
+ni_metric_bucket_bound(unsigned int n)
+{
+	return n < NI_METRIC_BUCKETS ? (uint64_t)1 << n : UINT64_MAX;
+}
+
+void
+ni_metrics_add(ni_metric_id_t id, uint64_t value)
+{
+	if (id < __NI_METRIC_MAX)
+		ni_metrics[id].value += value;
+}
+
+void
+ni_metrics_set(ni_metric_id_t id, uint64_t value)
+{
+	if (id < __NI_METRIC_MAX)
+		ni_metrics[id].value = value;
+}
+
+void
+ni_metrics_observe(ni_metric_id_t id, uint64_t usec)
+{
+	ni_metric_t *m;
+	unsigned int n;
+
+	if (id >= __NI_METRIC_MAX)
+		return;
+
+	m = &ni_metrics[id];
+	n = usec <= 1 ? 0 : 64 - __builtin_clzll(usec - 1);
+	if (n > NI_METRIC_BUCKETS)
+		n = NI_METRIC_BUCKETS;
+
+	m->bucket[n]++;
+	m->value++;
+	m->sum += usec;
+}
+
+void
+ni_metrics_observe_since(ni_metric_id_t id, const struct timeval *start)
+{
+	struct timeval now, delta;
+
+	ni_timer_get_time(&now);
+	if (timercmp(&now, start, <))
+		return;
+
+	timersub(&now, start, &delta);
+	ni_metrics_observe(id, (uint64_t)delta.tv_sec * 1000000 + delta.tv_usec);
+}
+
+/*
+ * Export in the OpenMetrics text format
+ */
+ni_bool_t
+ni_metrics_format_openmetrics(ni_stringbuf_t *out, const char *prefix)
+{
+	unsigned int i, n;
+
+	if (!out)
+		return FALSE;
+
+	if (ni_string_empty(prefix))
+		prefix = "wicked";
+
+	__ni_metrics_collect();
+
+	for (i = 0; i < __NI_METRIC_MAX; ++i) {
+		const ni_metric_t *m = &ni_metrics[i];
+		uint64_t count = 0;
+
+		ni_stringbuf_printf(out, "# TYPE %s_%s %s\n", prefix, m->name,
+				ni_metric_type_to_name(m->type));
+		ni_stringbuf_printf(out, "# HELP %s_%s %s.\n", prefix, m->name, m->help);
+
+		switch (m->type) {
+		case NI_METRIC_COUNTER:
+			ni_stringbuf_printf(out, "%s_%s_total %"PRIu64"\n",
+					prefix, m->name, m->value);
+			break;
+
+		case NI_METRIC_GAUGE:
+			ni_stringbuf_printf(out, "%s_%s %"PRIu64"\n",
+					prefix, m->name, m->value);
+			break;
+
+		case NI_METRIC_HISTOGRAM:
+			for (n = 0; n < NI_METRIC_BUCKETS; ++n) {
+				count += m->bucket[n];
+				ni_stringbuf_printf(out, "%s_%s_bucket{le=\"%.7g\"} %"PRIu64"\n",
+						prefix, m->name,
+						ni_metric_bucket_bound(n) / 1000000.0, count);
+			}
+			count += m->bucket[n];
+			ni_stringbuf_printf(out, "%s_%s_bucket{le=\"+Inf\"} %"PRIu64"\n",
+					prefix, m->name, count);
+			ni_stringbuf_printf(out, "%s_%s_count %"PRIu64"\n",
+					prefix, m->name, m->value);
+			ni_stringbuf_printf(out, "%s_%s_sum %g\n",
+					prefix, m->name, m->sum / 1000000.0);
+			break;
+		}
+	}
+	ni_stringbuf_printf(out, "# EOF\n");
+	return TRUE;
+}
@@ -7,7 +7,14 @@
 #include "config.h"
 #endif
 
+#include <sys/utsname.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+
 #include <wicked/util.h>
+#include <wicked/logging.h>
+#include "modprobe.h"
 #include "process.h"
 
 #ifndef NI_MODPROBE_BIN
@@ -16,6 +23,112 @@
 #ifndef NI_MODPROBE_OPT
 #define NI_MODPROBE_OPT "-qs"
 #endif
+#ifndef NI_MODULE_SYSFS_DIR
+#define NI_MODULE_SYSFS_DIR "/sys/module"
+#endif
+#ifndef NI_MODULE_LIB_DIR
+#define NI_MODULE_LIB_DIR "/lib/modules"
+#endif
+
+/*
+ * Modules we've seen loaded or built into the kernel. Only positive
+ * answers are cached -- a module does not vanish behind our back in
+ * any setup we care about, but it may appear any time.
+ */
+static ni_string_array_t	ni_modprobe_loaded = NI_STRING_ARRAY_INIT;
+static ni_string_array_t	ni_modprobe_builtin = NI_STRING_ARRAY_INIT;
+static ni_bool_t		ni_modprobe_builtin_read = FALSE;
+
+/*
+ * The kernel uses underscores in module names, modprobe accepts both.
+ */
+static const char *
+ni_modprobe_name(const char *module, char *buf, size_t size)
+{
+	char *p;
+
+	if (ni_string_len(module) == 0 || strchr(module, '/'))
+		return NULL;
+	if (snprintf(buf, size, "%s", module) >= (int)size)
+		return NULL;
+	for (p = buf; *p; ++p) {
+		if (*p == '-')
+			*p = '_';
+	}
+	return buf;
+}
+
+static void
+ni_modprobe_read_builtin(void)
+{
+	char path[PATH_MAX], line[PATH_MAX], name[NAME_MAX + 1];
+	struct utsname uts;
+	FILE *fp;
+
+	if (ni_modprobe_builtin_read)
+		return;
+	ni_modprobe_builtin_read = TRUE;
+
+	if (uname(&uts) < 0)
+		return;
+	snprintf(path, sizeof(path), "%s/%s/modules.builtin",
+			NI_MODULE_LIB_DIR, uts.release);
+	if (!(fp = fopen(path, "re")))
+		return;
+
+	/* one "kernel/net/packet/af_packet.ko" path per line */
+	while (fgets(line, sizeof(line), fp)) {
+		char *base, *ext;
+
+		line[strcspn(line, "\r\n")] = '\0';
+		base = strrchr(line, '/');
+		base = base ? base + 1 : line;
+		if ((ext = strstr(base, ".ko")))
+			*ext = '\0';
+		if (ni_modprobe_name(base, name, sizeof(name)))
+			ni_string_array_append(&ni_modprobe_builtin, name);
+	}
+	fclose(fp);
+}
+
+/*
+ * Check whether a module is loaded or built in, without forking.
+ */
+ni_bool_t
+ni_modprobe_is_loaded(const char *module)
+{
+	char name[NAME_MAX + 1];
+
+	if (!ni_modprobe_name(module, name, sizeof(name)))
+		return FALSE;
+
+	if (ni_string_array_index(&ni_modprobe_loaded, name) >= 0)
+		return TRUE;
+
+	/* loaded modules and built-ins with parameters */
+	if (!ni_file_exists_fmt(NI_MODULE_SYSFS_DIR "/%s", name)) {
+		ni_modprobe_read_builtin();
+		if (ni_string_array_index(&ni_modprobe_builtin, name) < 0)
+			return FALSE;
+	}
+
+	ni_string_array_append(&ni_modprobe_loaded, name);
+	return TRUE;
+}
+
+/*
+ * Load a module unless it is already there. The options are only
+ * applied when modprobe actually needs to run.
+ */
+int
+ni_modprobe_load(const char *module, const char *options)
+{
+	if (ni_modprobe_is_loaded(module)) {
+		ni_debug_ifconfig("module %s is already loaded", module);
+		return 0;
+	}
+	return ni_modprobe(module, options);
+}
 
 int
 ni_modprobe(const char *module, const char *options)
@@ -53,6 +166,9 @@ ni_modprobe(const char *module, const char *options)
 	rv = ni_process_run_and_wait(pi);
 	ni_process_free(pi);
 
+	if (rv == 0)
+		ni_modprobe_is_loaded(module);
+
 	return rv;
 }
 
@@ -7,6 +7,10 @@
 #ifndef __WICKED_MODPROBE_H__
 #define __WICKED_MODPROBE_H__
 
+#include <wicked/types.h>
+
 extern int	ni_modprobe(const char *module, const char *options);
+extern int	ni_modprobe_load(const char *module, const char *options);
+extern ni_bool_t	ni_modprobe_is_loaded(const char *module);
 
 #endif /* __WICKED_MODPROBE_H__ */
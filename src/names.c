@@ -682,6 +682,7 @@ static const ni_intmap_t	__ni_linkifflag_names[] = {
 	{ "broadcast",		NI_IFF_BROADCAST_ENABLED},
 	{ "multicast",		NI_IFF_MULTICAST_ENABLED},
 	{ "ready",		NI_IFF_DEVICE_READY	},
+	{ "details-pending",	NI_IFF_DETAILS_PENDING	},
 	{ NULL,			0			},
 };
 
@@ -87,6 +87,10 @@ ni_netdev_slaveinfo_destroy(ni_slaveinfo_t *slave)
 	case NI_IFTYPE_BOND:
 		ni_bonding_slave_info_free(slave->bond);
 		break;
+	case NI_IFTYPE_BRIDGE:
+		if (slave->bridge)
+			ni_bridge_port_free(slave->bridge);
+		break;
 	default:
 		break;
 	}
@@ -872,6 +876,87 @@ __ni_lease_owns_address(const ni_addrconf_lease_t *lease, const ni_address_t *ma
 	return FALSE;
 }
 
+static ni_bool_t
+__ni_address_owned(const ni_address_t *ap, const ni_address_t *match)
+{
+	return ap->prefixlen == match->prefixlen
+		&& ni_sockaddr_equal(&ap->peer_addr, &match->peer_addr)
+		&& ni_sockaddr_equal(&ap->anycast_addr, &match->anycast_addr);
+}
+
+void
+ni_lease_address_index_init(ni_lease_address_index_t *index, ni_netdev_t *dev, unsigned int family)
+{
+	struct ni_lease_address_index_entry *entry;
+	ni_addrconf_lease_t *lease;
+	unsigned int count = 0;
+
+	memset(index, 0, sizeof(*index));
+	for (lease = dev->leases; lease; lease = lease->next) {
+		if (lease->family == family)
+			count++;
+	}
+	if (!count)
+		return;
+
+	index->data = xcalloc(count, sizeof(index->data[0]));
+	for (lease = dev->leases; lease; lease = lease->next) {
+		if (lease->family != family)
+			continue;
+
+		entry = &index->data[index->count++];
+		entry->lease = lease;
+		entry->prio = ni_addrconf_lease_get_priority(lease);
+		ni_address_index_init(&entry->addrs);
+		ni_address_index_add_list(&entry->addrs, lease->addrs);
+	}
+}
+
+void
+ni_lease_address_index_destroy(ni_lease_address_index_t *index)
+{
+	unsigned int i;
+
+	for (i = 0; i < index->count; ++i)
+		ni_address_index_destroy(&index->data[i].addrs);
+	free(index->data);
+	memset(index, 0, sizeof(*index));
+}
+
+/*
+ * Same as __ni_netdev_address_to_lease, using the address index of
+ * the leases instead of walking all their address lists.
+ */
+ni_addrconf_lease_t *
+ni_lease_address_index_find(const ni_lease_address_index_t *index, const ni_address_t *match, unsigned int minprio)
+{
+	const struct ni_lease_address_index_entry *entry, *found = NULL;
+	const ni_address_t *ap;
+	unsigned int i, pos;
+
+	for (i = 0; i < index->count; ++i) {
+		entry = &index->data[i];
+		if (entry->lease->family != match->family)
+			continue;
+
+		if (entry->prio < minprio)
+			continue;
+
+		if (found && entry->prio <= found->prio)
+			continue;
+
+		pos = 0;
+		while ((ap = ni_address_index_find(&entry->addrs, &match->local_addr, &pos))) {
+			if (__ni_address_owned(ap, match))
+				break;
+		}
+		if (ap)
+			found = entry;
+	}
+
+	return found ? found->lease : NULL;
+}
+
 /*
  * Given a route, look up the lease owning it
  */
@@ -24,6 +24,7 @@
 #include <wicked/socket.h>
 #include <wicked/resolver.h>
 #include <wicked/nis.h>
+#include <wicked/metrics.h>
 #include "netinfo_priv.h"
 #include "util_priv.h"
 #include "dbus-server.h"
@@ -121,6 +122,8 @@ ni_init_ex(const char *appname, ni_init_appdata_callback_t *cb, void *appdata)
 	/* We're using randomized timeouts. Seed the RNG */
 	ni_srandom();
 
+	ni_metrics_init();
+
 	if (__ni_init_gcrypt() < 0)
 		return -1;
 
@@ -537,6 +540,16 @@ ni_netconfig_set_discover_filter(ni_netconfig_t *nc, unsigned int flag)
 	return FALSE;
 }
 
+ni_bool_t
+ni_netconfig_clear_discover_filter(ni_netconfig_t *nc, unsigned int flag)
+{
+	if (nc) {
+		nc->filter.discover &= ~flag;
+		return TRUE;
+	}
+	return FALSE;
+}
+
 ni_bool_t
 ni_netconfig_discover_filtered(ni_netconfig_t *nc, unsigned int flag)
 {
@@ -601,6 +614,7 @@ ni_netconfig_device_remove(ni_netconfig_t *nc, ni_netdev_t *dev)
 		if (cur == dev) {
 			*pos = cur->next;
 			ni_netconfig_device_unbind_slave_index(nc, cur->link.ifindex);
+			ni_sysfs_ifdir_cache_drop(cur->name);
 			ni_netdev_put(cur);
 			return;
 		}
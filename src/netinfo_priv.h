@@ -34,6 +34,8 @@ enum {
 	/* link details discover filter using external calls */
 	NI_NETCONFIG_DISCOVER_LINK_EXTERN = 1U << 0,
 	NI_NETCONFIG_DISCOVER_ROUTE_RULES = 1U << 1,
+	/* defer link details discovery, mark devices details-pending */
+	NI_NETCONFIG_DISCOVER_LINK_DEFER  = 1U << 2,
 };
 
 /*
@@ -56,6 +58,7 @@ extern ni_rule_t *	ni_netconfig_rule_find(ni_netconfig_t *, const ni_rule_t *);
 extern ni_rule_array_t *ni_netconfig_rule_array(ni_netconfig_t *);
 
 extern ni_bool_t	ni_netconfig_set_discover_filter(ni_netconfig_t *, unsigned int);
+extern ni_bool_t	ni_netconfig_clear_discover_filter(ni_netconfig_t *, unsigned int);
 extern ni_bool_t	ni_netconfig_discover_filtered(ni_netconfig_t *, unsigned int);
 extern ni_bool_t	ni_netconfig_set_family_filter(ni_netconfig_t *, unsigned int);
 extern unsigned int	ni_netconfig_get_family_filter(ni_netconfig_t *);
@@ -82,6 +85,7 @@ extern ni_bool_t	__ni_address_list_remove(ni_address_t **, ni_address_t *);
 extern int		__ni_system_refresh_all(ni_netconfig_t *nc, ni_netdev_t **del_list);
 extern int		__ni_system_refresh_interfaces(ni_netconfig_t *nc);
 extern int		__ni_system_refresh_interface(ni_netconfig_t *, ni_netdev_t *);
+extern int		ni_system_refresh_details(ni_netconfig_t *, ni_netdev_t *);
 extern int		__ni_system_refresh_interface_addrs(ni_netconfig_t *, ni_netdev_t *);
 extern int		__ni_system_refresh_interface_routes(ni_netconfig_t *, ni_netdev_t *);
 extern int		__ni_system_refresh_addrs(ni_netconfig_t *, unsigned int);
@@ -97,6 +101,8 @@ extern int		__ni_system_interface_flush_routes(ni_netconfig_t *, ni_netdev_t *);
 extern void		__ni_system_ethernet_refresh(ni_netdev_t *);
 extern void		__ni_system_ethernet_update(ni_netdev_t *, ni_ethernet_t *);
 extern void		ni_system_ethtool_refresh(ni_netdev_t *);
+extern ni_bool_t	ni_system_ethtool_refresh_begin(void);
+extern void		ni_system_ethtool_refresh_end(ni_netconfig_t *);
 
 /* FIXME: These should go elsewhere, maybe runtime.h */
 extern int		__ni_system_interface_update_lease(ni_netdev_t *, ni_addrconf_lease_t **, ni_event_t);
@@ -116,6 +122,23 @@ extern int		__ni_system_resolver_backup(void);
 extern int		__ni_system_resolver_restore(void);
 
 extern ni_bool_t	__ni_lease_owns_address(const ni_addrconf_lease_t *, const ni_address_t *);
+
+/*
+ * The addresses of a device's leases of one family, indexed to look up
+ * many addresses at once, e.g. when applying a lease.
+ */
+typedef struct ni_lease_address_index {
+	unsigned int		count;
+	struct ni_lease_address_index_entry {
+		ni_addrconf_lease_t *	lease;
+		unsigned int		prio;
+		ni_address_index_t	addrs;
+	} *			data;
+} ni_lease_address_index_t;
+
+extern void		ni_lease_address_index_init(ni_lease_address_index_t *, ni_netdev_t *, unsigned int);
+extern void		ni_lease_address_index_destroy(ni_lease_address_index_t *);
+extern ni_addrconf_lease_t *ni_lease_address_index_find(const ni_lease_address_index_t *, const ni_address_t *, unsigned int);
 extern ni_route_t *	__ni_lease_owns_route(const ni_addrconf_lease_t *, const ni_route_t *);
 
 extern int		__ni_wireless_link_event(ni_netconfig_t *, ni_netdev_t *, void *, size_t);
@@ -30,8 +30,6 @@
 #include <wicked/util.h>
 #include <wicked/netinfo.h>
 #include "ovs.h"
-#include "buffer.h"
-#include "process.h"
 #include "util_priv.h"
 
 #define NI_OVS_BRIDGE_PORT_ARRAY_CHUNK		4
@@ -195,474 +193,6 @@ ni_ovs_bridge_port_config_destroy(ni_ovs_bridge_port_config_t *conf)
 	ni_ovs_bridge_port_config_init(conf);
 }
 
-
-static const char *
-ni_ovs_vsctl_tool_path(void)
-{
-	static const char *paths[] = {
-		"/usr/bin/ovs-vsctl",
-		NULL
-	};
-	const char *path = ni_find_executable(paths);
-
-	if (!path)
-		ni_warn_once("unable to find ovs-vsctl utility");
-	return path;
-}
-
-int /* process run codes (for now) */
-ni_ovs_vsctl_bridge_exists(const char *brname)
-{
-	const char *ovs_vsctl;
-	ni_shellcmd_t *cmd;
-	ni_process_t *pi;
-	int rv = NI_PROCESS_FAILURE;
-
-	if (ni_string_empty(brname))
-		return rv;
-
-	if (!(ovs_vsctl = ni_ovs_vsctl_tool_path()))
-		return rv;
-
-	if (!(cmd = ni_shellcmd_new(NULL)))
-		return rv;
-
-	if (!ni_shellcmd_add_arg(cmd, ovs_vsctl))
-		goto failure;
-
-	if (!ni_shellcmd_add_arg(cmd, "br-exists"))
-		goto failure;
-
-	if (!ni_shellcmd_add_arg(cmd, brname))
-		goto failure;
-
-	if (!(pi = ni_process_new(cmd)))
-		goto failure;
-
-	rv = ni_process_run_and_wait(pi);
-
-	ni_process_free(pi);
-
-failure:
-	if (cmd)
-		ni_shellcmd_release(cmd);
-	return rv;
-}
-
-int /* process run codes (for now) */
-ni_ovs_vsctl_bridge_to_vlan(const char *brname, uint16_t *vlan)
-{
-	const char *ovs_vsctl;
-	ni_shellcmd_t *cmd;
-	ni_process_t *pi;
-	ni_buffer_t buf;
-	int rv = NI_PROCESS_FAILURE;
-	unsigned int value;
-	char *ptr;
-
-	if (ni_string_empty(brname) || !vlan)
-		return rv;
-
-	if (!(ovs_vsctl = ni_ovs_vsctl_tool_path()))
-		return rv;
-
-	if (!(cmd = ni_shellcmd_new(NULL)))
-		return rv;
-
-	ni_buffer_init_dynamic(&buf, 32);
-
-	if (!ni_shellcmd_add_arg(cmd, ovs_vsctl))
-		goto failure;
-
-	if (!ni_shellcmd_add_arg(cmd, "br-to-vlan"))
-		goto failure;
-
-	if (!ni_shellcmd_add_arg(cmd, brname))
-		goto failure;
-
-	if (!(pi = ni_process_new(cmd)))
-		goto failure;
-
-	rv = ni_process_run_and_capture_output(pi, &buf);
-	ni_process_free(pi);
-	if (rv) {
-		ni_error("%s: unable to query bridge vlan", brname);
-		goto failure;
-	}
-
-	ni_buffer_put(&buf, "\0", 1);
-	ptr = (char *)ni_buffer_head(&buf);
-	ptr[strcspn(ptr, "\n\r")] = '\0';
-
-	if (ni_parse_uint(ptr, &value, 10) < 0) {
-		ni_error("%s: unable to parse bridge vlan id '%s'", brname, ptr);
-		rv = NI_PROCESS_FAILURE;
-	} else
-	if (value >= 0x0fff /* VLAN_VID_MASK */) {
-		ni_error("%s: bridge vlan id %u not in range 1..%u", brname, value, 0x0fff);
-		rv = NI_PROCESS_FAILURE;
-	} else {
-		*vlan = value;
-	}
-
-failure:
-	if (cmd)
-		ni_shellcmd_release(cmd);
-	ni_buffer_destroy(&buf);
-	return rv;
-}
-
-int /* process run codes (for now) */
-ni_ovs_vsctl_bridge_to_parent(const char *brname, char **parent)
-{
-	const char *ovs_vsctl;
-	ni_shellcmd_t *cmd;
-	ni_process_t *pi;
-	ni_buffer_t buf;
-	int rv = NI_PROCESS_FAILURE;
-	char *ptr;
-
-	if (ni_string_empty(brname) || !parent)
-		return rv;
-
-	if (!(ovs_vsctl = ni_ovs_vsctl_tool_path()))
-		return rv;
-
-	if (!(cmd = ni_shellcmd_new(NULL)))
-		return rv;
-
-	ni_buffer_init_dynamic(&buf, 32);
-
-	if (!ni_shellcmd_add_arg(cmd, ovs_vsctl))
-		goto failure;
-
-	if (!ni_shellcmd_add_arg(cmd, "br-to-parent"))
-		goto failure;
-
-	if (!ni_shellcmd_add_arg(cmd, brname))
-		goto failure;
-
-	if (!(pi = ni_process_new(cmd)))
-		goto failure;
-
-	rv = ni_process_run_and_capture_output(pi, &buf);
-	ni_process_free(pi);
-	if (rv) {
-		ni_error("%s: unable to query bridge parent", brname);
-		goto failure;
-	}
-
-	ni_buffer_put(&buf, "\0", 1);
-	ptr = (char *)ni_buffer_head(&buf);
-	ptr[strcspn(ptr, "\n\r")] = '\0';
-
-	if (!ni_string_eq(brname, ptr))
-		ni_string_dup(parent, ptr);
-
-failure:
-	if (cmd)
-		ni_shellcmd_release(cmd);
-	ni_buffer_destroy(&buf);
-	return rv;
-}
-
-
-int /* process run codes (for now) */
-ni_ovs_vsctl_bridge_ports(const char *brname, ni_ovs_bridge_port_array_t *ports)
-{
-	ni_stringbuf_t pname = NI_STRINGBUF_INIT_DYNAMIC;
-	const char *ovs_vsctl;
-	ni_shellcmd_t *cmd;
-	ni_process_t *pi;
-	ni_buffer_t buf;
-	int rv = NI_PROCESS_FAILURE;
-	int cc;
-
-	if (ni_string_empty(brname) || !ports)
-		return rv;
-
-	if (!(ovs_vsctl = ni_ovs_vsctl_tool_path()))
-		return rv;
-
-	if (!(cmd = ni_shellcmd_new(NULL)))
-		return rv;
-
-	ni_buffer_init_dynamic(&buf, 256);
-
-	if (!ni_shellcmd_add_arg(cmd, ovs_vsctl))
-		goto failure;
-
-	if (!ni_shellcmd_add_arg(cmd, "list-ports"))
-		goto failure;
-
-	if (!ni_shellcmd_add_arg(cmd, brname))
-		goto failure;
-
-	if (!(pi = ni_process_new(cmd)))
-		goto failure;
-
-	rv = ni_process_run_and_capture_output(pi, &buf);
-	ni_process_free(pi);
-	if (rv) {
-		ni_error("%s: unable to query bridge ports", brname);
-		goto failure;
-	}
-
-	while ((cc = ni_buffer_getc(&buf)) != EOF) {
-		if (cc == '\n') {
-			if (pname.string)
-				pname.string[strcspn(pname.string, "\n\r")] = '\0';
-			ni_ovs_bridge_port_array_add_new(ports, pname.string);
-			ni_stringbuf_destroy(&pname);
-		} else {
-			ni_stringbuf_putc(&pname, cc);
-		}
-	}
-	if (pname.string)
-		pname.string[strcspn(pname.string, "\n\r")] = '\0';
-	ni_ovs_bridge_port_array_add_new(ports, pname.string);
-	ni_stringbuf_destroy(&pname);
-
-failure:
-	if (cmd)
-		ni_shellcmd_release(cmd);
-	ni_buffer_destroy(&buf);
-	return rv;
-}
-
-int /* process run codes (for now) */
-ni_ovs_vsctl_bridge_add(const ni_netdev_t *cfg, ni_bool_t may_exist)
-{
-	const char *ovs_vsctl;
-	ni_shellcmd_t *cmd;
-	ni_process_t *pi;
-	int rv = NI_PROCESS_FAILURE;
-
-	/* Note: seems, ovs does not check any args and
-	 * permits "anything" without to trigger errors.
-	 * Add some checks before you call this function.
-	 */
-	if (!cfg || ni_string_empty(cfg->name) || !cfg->ovsbr)
-		return rv;
-
-	if (!(ovs_vsctl = ni_ovs_vsctl_tool_path()))
-		return rv;
-
-	if (!(cmd = ni_shellcmd_new(NULL)))
-		return rv;
-
-	if (!ni_shellcmd_add_arg(cmd, ovs_vsctl))
-		goto failure;
-
-	if (may_exist && !ni_shellcmd_add_arg(cmd, "--may-exist"))
-		goto failure;
-
-	if (!ni_shellcmd_add_arg(cmd, "add-br"))
-		goto failure;
-
-	if (!ni_shellcmd_add_arg(cmd, cfg->name))
-		goto failure;
-
-	if (!ni_string_empty(cfg->ovsbr->config.vlan.parent.name)) {
-		if (!ni_shellcmd_add_arg(cmd, cfg->ovsbr->config.vlan.parent.name))
-			goto failure;
-
-		if (!ni_shellcmd_add_arg(cmd, ni_sprint_uint(cfg->ovsbr->config.vlan.tag)))
-			goto failure;
-	}
-
-	if (!(pi = ni_process_new(cmd)))
-		goto failure;
-
-	rv = ni_process_run_and_wait(pi);
-
-	ni_process_free(pi);
-
-failure:
-	if (cmd)
-		ni_shellcmd_release(cmd);
-	return rv;
-}
-
-int /* process run codes (for now) */
-ni_ovs_vsctl_bridge_del(const char *brname)
-{
-	const char *ovs_vsctl;
-	ni_shellcmd_t *cmd;
-	ni_process_t *pi;
-	int rv = NI_PROCESS_FAILURE;
-
-	if (ni_string_empty(brname))
-		return rv;
-
-	if (!(ovs_vsctl = ni_ovs_vsctl_tool_path()))
-		return rv;
-
-	if (!(cmd = ni_shellcmd_new(NULL)))
-		return rv;
-
-	if (!ni_shellcmd_add_arg(cmd, ovs_vsctl))
-		goto failure;
-
-	if (!ni_shellcmd_add_arg(cmd, "del-br"))
-		goto failure;
-
-	if (!ni_shellcmd_add_arg(cmd, brname))
-		goto failure;
-
-	if (!(pi = ni_process_new(cmd)))
-		goto failure;
-
-	rv = ni_process_run_and_wait(pi);
-
-	ni_process_free(pi);
-
-failure:
-	if (cmd)
-		ni_shellcmd_release(cmd);
-	return rv;
-}
-
-int /* process run codes (for now) */
-ni_ovs_vsctl_bridge_port_add(const char *pname, const ni_ovs_bridge_port_config_t *pconf, ni_bool_t may_exist)
-{
-	const char *ovs_vsctl;
-	ni_shellcmd_t *cmd;
-	ni_process_t *pi;
-	int rv = NI_PROCESS_FAILURE;
-
-	if (ni_string_empty(pname) || !pconf || ni_string_empty(pconf->bridge.name))
-		return rv;
-
-	if (!(ovs_vsctl = ni_ovs_vsctl_tool_path()))
-		return rv;
-
-	if (!(cmd = ni_shellcmd_new(NULL)))
-		return rv;
-
-	if (!ni_shellcmd_add_arg(cmd, ovs_vsctl))
-		goto failure;
-
-	if (may_exist && !ni_shellcmd_add_arg(cmd, "--may-exist"))
-		goto failure;
-
-	if (!ni_shellcmd_add_arg(cmd, "add-port"))
-		goto failure;
-
-	if (!ni_shellcmd_add_arg(cmd, pconf->bridge.name))
-		goto failure;
-
-	if (!ni_shellcmd_add_arg(cmd, pname))
-		goto failure;
-
-	if (!(pi = ni_process_new(cmd)))
-		goto failure;
-
-	rv = ni_process_run_and_wait(pi);
-
-	ni_process_free(pi);
-
-failure:
-	if (cmd)
-		ni_shellcmd_release(cmd);
-	return rv;
-}
-
-
-int /* process run codes (for now) */
-ni_ovs_vsctl_bridge_port_del(const char *brname, const char *pname)
-{
-	const char *ovs_vsctl;
-	ni_shellcmd_t *cmd;
-	ni_process_t *pi;
-	int rv = NI_PROCESS_FAILURE;
-
-	if (ni_string_empty(brname) || ni_string_empty(pname))
-		return rv;
-
-	if (!(ovs_vsctl = ni_ovs_vsctl_tool_path()))
-		return rv;
-
-	if (!(cmd = ni_shellcmd_new(NULL)))
-		return rv;
-
-	if (!ni_shellcmd_add_arg(cmd, ovs_vsctl))
-		goto failure;
-
-	if (!ni_shellcmd_add_arg(cmd, "del-port"))
-		goto failure;
-
-	if (!ni_shellcmd_add_arg(cmd, brname))
-		goto failure;
-
-	if (!ni_shellcmd_add_arg(cmd, pname))
-		goto failure;
-
-	if (!(pi = ni_process_new(cmd)))
-		goto failure;
-
-	rv = ni_process_run_and_wait(pi);
-
-	ni_process_free(pi);
-
-failure:
-	if (cmd)
-		ni_shellcmd_release(cmd);
-	return rv;
-}
-
-int /* process run codes (for now) */
-ni_ovs_vsctl_bridge_port_to_bridge(const char *pname, char **brname)
-{
-	const char *ovs_vsctl;
-	ni_shellcmd_t *cmd;
-	ni_process_t *pi;
-	ni_buffer_t buf;
-	int rv = NI_PROCESS_FAILURE;
-	char *ptr;
-
-	if (ni_string_empty(pname) || !brname)
-		return rv;
-
-	if (!(ovs_vsctl = ni_ovs_vsctl_tool_path()))
-		return rv;
-
-	if (!(cmd = ni_shellcmd_new(NULL)))
-		return rv;
-
-	ni_buffer_init_dynamic(&buf, 32);
-
-	if (!ni_shellcmd_add_arg(cmd, ovs_vsctl))
-		goto failure;
-
-	if (!ni_shellcmd_add_arg(cmd, "port-to-br"))
-		goto failure;
-
-	if (!ni_shellcmd_add_arg(cmd, pname))
-		goto failure;
-
-	if (!(pi = ni_process_new(cmd)))
-		goto failure;
-
-	rv = ni_process_run_and_capture_output(pi, &buf);
-	ni_process_free(pi);
-	if (rv) {
-		ni_error("%s: unable to query port bridge", pname);
-		goto failure;
-	}
-
-	ni_buffer_put(&buf, "\0", 1);
-	ptr = (char *)ni_buffer_head(&buf);
-	ptr[strcspn(ptr, "\n\r")] = '\0';
-	ni_string_dup(brname, ptr);
-
-failure:
-	if (cmd)
-		ni_shellcmd_release(cmd);
-	ni_buffer_destroy(&buf);
-	return rv;
-}
-
 int
 ni_ovs_bridge_discover(ni_netdev_t *dev, ni_netconfig_t *nc)
 {
@@ -673,9 +203,9 @@ ni_ovs_bridge_discover(ni_netdev_t *dev, ni_netconfig_t *nc)
 		return -1;
 
 	ovsbr = ni_ovs_bridge_new();
-	if (ni_ovs_vsctl_bridge_to_parent(dev->name, &ovsbr->config.vlan.parent.name) ||
-	    ni_ovs_vsctl_bridge_to_vlan(dev->name, &ovsbr->config.vlan.tag) ||
-	    ni_ovs_vsctl_bridge_ports(dev->name, &ovsbr->ports)) {
+	if (ni_ovsdb_bridge_to_parent(dev->name, &ovsbr->config.vlan.parent.name) ||
+	    ni_ovsdb_bridge_to_vlan(dev->name, &ovsbr->config.vlan.tag) ||
+	    ni_ovsdb_bridge_ports(dev->name, &ovsbr->ports)) {
 		ni_ovs_bridge_free(ovsbr);
 		return -1;
 	}
@@ -0,0 +1,1128 @@
+/*
+ *	OVSDB (RFC 7047) JSON-RPC client for the ovs bridge support
+ *
+ *	Copyright (C) 2026 SUSE Linux GmbH, Nuernberg, Germany.
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	This program is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along
+ *	with this program; if not, see <http://www.gnu.org/licenses/> or write
+ *	to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *	Boston, MA 02110-1301 USA.
+ *
+ *	The client keeps a "monitor" subscription on the Open_vSwitch,
+ *	Bridge, Port and Interface tables and answers all queries from
+ *	this cache. Changes are sent as one "transact" per operation.
+ *	The bridge/port model follows ovs-vsctl: a "fake" (vlan) bridge
+ *	is a Port of its parent bridge with fake_bridge=true and a tag;
+ *	the ports with the same tag in the parent belong to it.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <inttypes.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/time.h>
+
+#include <wicked/util.h>
+#include <wicked/logging.h>
+#include <wicked/netinfo.h>
+#include <wicked/socket.h>
+#include "ovs.h"
+#include "json.h"
+#include "util_priv.h"
+
+#define NI_OVSDB_DATABASE		"Open_vSwitch"
+#define NI_OVSDB_TIMEOUT		5000	/* msec */
+#define NI_OVSDB_RBUF_CHUNK		4096
+
+typedef struct ni_ovsdb_client {
+	int				fd;
+	int64_t				seqno;
+
+	char *				rbuf;
+	size_t				rlen;
+	size_t				rsize;
+
+	ni_json_t *			cache;	/* table -> uuid -> row */
+} ni_ovsdb_client_t;
+
+static ni_ovsdb_client_t *		ni_ovsdb_client;
+
+static const char *			ni_ovsdb_socket_paths[] = {
+	"/run/openvswitch/db.sock",
+	"/var/run/openvswitch/db.sock",
+	NULL
+};
+
+/*
+ * The monitored tables and columns
+ */
+static const struct ni_ovsdb_monitor_table {
+	const char *			name;
+	const char *			columns[5];
+} ni_ovsdb_monitor_tables[] = {
+	{ "Open_vSwitch",	{ "bridges", NULL } },
+	{ "Bridge",		{ "name", "ports", NULL } },
+	{ "Port",		{ "name", "interfaces", "tag", "fake_bridge", NULL } },
+	{ "Interface",		{ "name", "type", NULL } },
+	{ NULL,			{ NULL } }
+};
+
+/*
+ * Connection handling
+ */
+static ni_ovsdb_client_t *
+ni_ovsdb_client_new(int fd)
+{
+	ni_ovsdb_client_t *client;
+
+	client = xcalloc(1, sizeof(*client));
+	client->fd = fd;
+	client->cache = ni_json_new_object();
+	return client;
+}
+
+static void
+ni_ovsdb_client_free(ni_ovsdb_client_t *client)
+{
+	if (client) {
+		if (client->fd >= 0)
+			close(client->fd);
+		ni_json_free(client->cache);
+		free(client->rbuf);
+		free(client);
+	}
+}
+
+static int
+ni_ovsdb_socket_connect(void)
+{
+	struct sockaddr_un sun;
+	const char **path;
+	int fd;
+
+	for (path = ni_ovsdb_socket_paths; *path; ++path) {
+		if (!ni_file_exists(*path))
+			continue;
+
+		if ((fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0) {
+			ni_error("ovsdb: unable to create unix socket: %m");
+			return -1;
+		}
+
+		memset(&sun, 0, sizeof(sun));
+		sun.sun_family = AF_UNIX;
+		strncpy(sun.sun_path, *path, sizeof(sun.sun_path) - 1);
+		if (connect(fd, (struct sockaddr *)&sun, sizeof(sun)) == 0) {
+			ni_debug_ifconfig("ovsdb: connected to %s", *path);
+			return fd;
+		}
+
+		ni_debug_ifconfig("ovsdb: unable to connect to %s: %m", *path);
+		close(fd);
+	}
+	return -1;
+}
+
+/*
+ * Returns the length of the first complete json text in the buffer,
+ * including leading whitespace, or 0 when it is not complete yet.
+ */
+static size_t
+ni_ovsdb_frame_length(const char *buf, size_t len)
+{
+	ni_bool_t string = FALSE, escape = FALSE;
+	unsigned int depth = 0;
+	size_t pos;
+
+	for (pos = 0; pos < len; ++pos) {
+		char cc = buf[pos];
+
+		if (string) {
+			if (escape)
+				escape = FALSE;
+			else if (cc == '\\')
+				escape = TRUE;
+			else if (cc == '"')
+				string = FALSE;
+			continue;
+		}
+
+		switch (cc) {
+		case '"':
+			string = TRUE;
+			break;
+		case '{':
+		case '[':
+			depth++;
+			break;
+		case '}':
+		case ']':
+			if (depth && --depth == 0)
+				return pos + 1;
+			break;
+		default:
+			break;
+		}
+	}
+	return 0;
+}
+
+static int
+ni_ovsdb_client_send(ni_ovsdb_client_t *client, ni_json_t *msg)
+{
+	ni_stringbuf_t buf = NI_STRINGBUF_INIT_DYNAMIC;
+	size_t off = 0;
+	ssize_t cnt;
+	int rv = 0;
+
+	if (!ni_json_format_string(&buf, msg, NULL) || !buf.len) {
+		ni_stringbuf_destroy(&buf);
+		return -1;
+	}
+
+	while (off < buf.len) {
+		cnt = send(client->fd, buf.string + off, buf.len - off, MSG_NOSIGNAL);
+		if (cnt < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN) {
+				struct pollfd pfd = { .fd = client->fd, .events = POLLOUT };
+
+				if (poll(&pfd, 1, NI_OVSDB_TIMEOUT) > 0)
+					continue;
+			}
+			ni_error("ovsdb: unable to send request: %m");
+			rv = -1;
+			break;
+		}
+		off += cnt;
+	}
+	ni_stringbuf_destroy(&buf);
+	return rv;
+}
+
+/*
+ * Wait up to timeout msec for data; 1 when read, 0 on timeout, -1 on error
+ */
+static int
+ni_ovsdb_client_recv(ni_ovsdb_client_t *client, int timeout)
+{
+	struct pollfd pfd = { .fd = client->fd, .events = POLLIN };
+	ssize_t cnt;
+	int ret;
+
+	do {
+		ret = poll(&pfd, 1, timeout);
+	} while (ret < 0 && errno == EINTR);
+
+	if (ret < 0) {
+		ni_error("ovsdb: poll failed: %m");
+		return -1;
+	}
+	if (ret == 0)
+		return 0;
+
+	if (client->rsize - client->rlen < NI_OVSDB_RBUF_CHUNK) {
+		client->rsize += NI_OVSDB_RBUF_CHUNK;
+		client->rbuf = xrealloc(client->rbuf, client->rsize + 1);
+	}
+
+	cnt = recv(client->fd, client->rbuf + client->rlen,
+			client->rsize - client->rlen, MSG_DONTWAIT);
+	if (cnt < 0 && (errno == EINTR || errno == EAGAIN))
+		return 1;
+	if (cnt <= 0) {
+		if (cnt == 0)
+			ni_debug_ifconfig("ovsdb: connection closed by server");
+		else
+			ni_error("ovsdb: receive failed: %m");
+		return -1;
+	}
+	client->rlen += cnt;
+	return 1;
+}
+
+/*
+ * Cache maintenance from monitor replies and update notifications
+ */
+static void
+ni_ovsdb_cache_apply(ni_ovsdb_client_t *client, ni_json_t *updates)
+{
+	unsigned int t, r;
+
+	for (t = 0; t < ni_json_object_entries(updates); ++t) {
+		ni_json_pair_t *tpair = ni_json_object_get_pair_at(updates, t);
+		const char *tname = ni_json_pair_get_name(tpair);
+		ni_json_t *rows = ni_json_pair_get_value(tpair);
+		ni_json_t *table;
+
+		if (!(table = ni_json_object_get_value(client->cache, tname))) {
+			table = ni_json_new_object();
+			ni_json_object_set(client->cache, tname, table);
+		}
+
+		for (r = 0; r < ni_json_object_entries(rows); ++r) {
+			ni_json_pair_t *rpair = ni_json_object_get_pair_at(rows, r);
+			const char *uuid = ni_json_pair_get_name(rpair);
+			ni_json_t *row;
+
+			row = ni_json_object_get_value(ni_json_pair_get_value(rpair), "new");
+			if (row)
+				ni_json_object_set(table, uuid, ni_json_ref(row));
+			else
+				ni_json_object_delete(table, uuid);
+		}
+	}
+}
+
+/*
+ * Process one message; returns it when it is the reply to id
+ */
+static ni_json_t *
+ni_ovsdb_client_process(ni_ovsdb_client_t *client, ni_json_t *msg, int64_t id)
+{
+	const char *method;
+	ni_json_t *params;
+	int64_t msgid;
+
+	if ((method = ni_json_string_value(ni_json_object_get_value(msg, "method")))) {
+		params = ni_json_object_get_value(msg, "params");
+
+		if (ni_string_eq(method, "update")) {
+			ni_ovsdb_cache_apply(client, ni_json_array_get(params, 1));
+		} else
+		if (ni_string_eq(method, "echo")) {
+			ni_json_t *reply = ni_json_new_object();
+
+			ni_json_object_set(reply, "id", ni_json_ref(ni_json_object_get_value(msg, "id")));
+			ni_json_object_set(reply, "result", ni_json_ref(params));
+			ni_json_object_set(reply, "error", ni_json_new_null());
+			ni_ovsdb_client_send(client, reply);
+			ni_json_free(reply);
+		}
+		ni_json_free(msg);
+		return NULL;
+	}
+
+	if (ni_json_int64_get(ni_json_object_get_value(msg, "id"), &msgid) && msgid == id)
+		return msg;
+
+	ni_json_free(msg);
+	return NULL;
+}
+
+/*
+ * Process the complete messages in the receive buffer
+ */
+static int
+ni_ovsdb_client_dispatch(ni_ovsdb_client_t *client, int64_t id, ni_json_t **reply)
+{
+	size_t len;
+
+	while (client->rlen && (len = ni_ovsdb_frame_length(client->rbuf, client->rlen))) {
+		ni_json_t *msg;
+		char save;
+
+		save = client->rbuf[len];
+		client->rbuf[len] = '\0';
+		msg = ni_json_parse_string(client->rbuf);
+		client->rbuf[len] = save;
+
+		client->rlen -= len;
+		memmove(client->rbuf, client->rbuf + len, client->rlen);
+
+		if (!msg) {
+			ni_error("ovsdb: unable to parse server message");
+			return -1;
+		}
+
+		if ((msg = ni_ovsdb_client_process(client, msg, id))) {
+			*reply = msg;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Call a method and wait for its result
+ */
+static int
+ni_ovsdb_client_call(ni_ovsdb_client_t *client, const char *method,
+			ni_json_t *params, ni_json_t **result)
+{
+	ni_json_t *msg, *reply = NULL, *error;
+	struct timeval deadline, now, delta;
+	int64_t id;
+	int rv;
+
+	id = ++client->seqno;
+	msg = ni_json_new_object();
+	ni_json_object_set(msg, "method", ni_json_new_string(method));
+	ni_json_object_set(msg, "params", params);
+	ni_json_object_set(msg, "id", ni_json_new_int64(id));
+	rv = ni_ovsdb_client_send(client, msg);
+	ni_json_free(msg);
+	if (rv < 0)
+		return -1;
+
+	ni_timer_get_time(&deadline);
+	deadline.tv_sec += NI_OVSDB_TIMEOUT / 1000;
+
+	while ((rv = ni_ovsdb_client_dispatch(client, id, &reply)) == 0) {
+		ni_timer_get_time(&now);
+		if (!timercmp(&now, &deadline, <)) {
+			ni_error("ovsdb: timeout waiting for %s reply", method);
+			return -1;
+		}
+		timersub(&deadline, &now, &delta);
+		rv = ni_ovsdb_client_recv(client, delta.tv_sec * 1000 + delta.tv_usec / 1000);
+		if (rv < 0)
+			return -1;
+	}
+	if (rv < 0)
+		return -1;
+
+	error = ni_json_object_get_value(reply, "error");
+	if (error && !ni_json_is_null(error)) {
+		ni_stringbuf_t buf = NI_STRINGBUF_INIT_DYNAMIC;
+
+		ni_error("ovsdb: %s failed: %s", method,
+				ni_json_format_string(&buf, error, NULL));
+		ni_stringbuf_destroy(&buf);
+		ni_json_free(reply);
+		return -1;
+	}
+
+	if (result)
+		*result = ni_json_object_ref_value(reply, "result");
+	ni_json_free(reply);
+	return 0;
+}
+
+/*
+ * Process pending update notifications without blocking
+ */
+static int
+ni_ovsdb_client_sync(ni_ovsdb_client_t *client)
+{
+	ni_json_t *reply = NULL;
+	int rv;
+
+	while ((rv = ni_ovsdb_client_recv(client, 0)) > 0) {
+		if (ni_ovsdb_client_dispatch(client, 0, &reply) < 0)
+			return -1;
+	}
+	return rv;
+}
+
+static int
+ni_ovsdb_client_monitor(ni_ovsdb_client_t *client)
+{
+	const struct ni_ovsdb_monitor_table *mt;
+	ni_json_t *params, *requests, *result = NULL;
+	unsigned int i;
+
+	requests = ni_json_new_object();
+	for (mt = ni_ovsdb_monitor_tables; mt->name; ++mt) {
+		ni_json_t *request = ni_json_new_object();
+		ni_json_t *columns = ni_json_new_array();
+
+		for (i = 0; mt->columns[i]; ++i)
+			ni_json_array_append(columns, ni_json_new_string(mt->columns[i]));
+		ni_json_object_set(request, "columns", columns);
+		ni_json_object_set(requests, mt->name, request);
+	}
+
+	params = ni_json_new_array();
+	ni_json_array_append(params, ni_json_new_string(NI_OVSDB_DATABASE));
+	ni_json_array_append(params, ni_json_new_null());
+	ni_json_array_append(params, requests);
+
+	if (ni_ovsdb_client_call(client, "monitor", params, &result) < 0)
+		return -1;
+
+	ni_ovsdb_cache_apply(client, result);
+	ni_json_free(result);
+	return 0;
+}
+
+static void
+ni_ovsdb_client_reset(void)
+{
+	ni_ovsdb_client_free(ni_ovsdb_client);
+	ni_ovsdb_client = NULL;
+}
+
+/*
+ * Use an already connected socket, e.g. one end of a socketpair
+ */
+ni_bool_t
+ni_ovsdb_connect_fd(int fd)
+{
+	ni_ovsdb_client_reset();
+	if (fd < 0)
+		return FALSE;
+
+	ni_ovsdb_client = ni_ovsdb_client_new(fd);
+	if (ni_ovsdb_client_monitor(ni_ovsdb_client) < 0) {
+		ni_ovsdb_client_reset();
+		return FALSE;
+	}
+	return TRUE;
+}
+
+void
+ni_ovsdb_disconnect(void)
+{
+	ni_ovsdb_client_reset();
+}
+
+/*
+ * Returns the client with an up to date cache, (re)connecting as needed
+ */
+static ni_ovsdb_client_t *
+ni_ovsdb_client_get(void)
+{
+	int fd;
+
+	if (ni_ovsdb_client) {
+		if (ni_ovsdb_client_sync(ni_ovsdb_client) >= 0)
+			return ni_ovsdb_client;
+		ni_ovsdb_client_reset();
+	}
+
+	if ((fd = ni_ovsdb_socket_connect()) < 0) {
+		ni_debug_ifconfig("ovsdb: server socket not available");
+		return NULL;
+	}
+	if (!ni_ovsdb_connect_fd(fd))
+		return NULL;
+	return ni_ovsdb_client;
+}
+
+/*
+ * Cache access
+ */
+static ni_json_t *
+ni_ovsdb_table(ni_ovsdb_client_t *client, const char *table)
+{
+	return ni_json_object_get_value(client->cache, table);
+}
+
+static ni_json_t *
+ni_ovsdb_row(ni_ovsdb_client_t *client, const char *table, const char *uuid)
+{
+	return uuid ? ni_json_object_get_value(ni_ovsdb_table(client, table), uuid) : NULL;
+}
+
+static const char *
+ni_ovsdb_row_string(ni_json_t *row, const char *column)
+{
+	return ni_json_string_value(ni_json_object_get_value(row, column));
+}
+
+static ni_bool_t
+ni_ovsdb_row_bool(ni_json_t *row, const char *column)
+{
+	ni_bool_t value = FALSE;
+
+	ni_json_bool_get(ni_json_object_get_value(row, column), &value);
+	return value;
+}
+
+/* an optional integer is a number or an empty ["set",[]] */
+static ni_bool_t
+ni_ovsdb_row_int(ni_json_t *row, const char *column, int64_t *value)
+{
+	return ni_json_int64_get(ni_json_object_get_value(row, column), value);
+}
+
+/* a set of uuids is either ["uuid","..."] or ["set",[["uuid","..."],...]] */
+static unsigned int
+ni_ovsdb_row_uuids(ni_json_t *row, const char *column, ni_string_array_t *uuids)
+{
+	ni_json_t *value = ni_json_object_get_value(row, column);
+	ni_json_t *elems, *atom;
+	const char *type;
+	unsigned int i;
+
+	ni_string_array_destroy(uuids);
+	type = ni_json_string_value(ni_json_array_get(value, 0));
+	if (ni_string_eq(type, "uuid")) {
+		ni_string_array_append(uuids, ni_json_string_value(ni_json_array_get(value, 1)));
+	} else
+	if (ni_string_eq(type, "set")) {
+		elems = ni_json_array_get(value, 1);
+		for (i = 0; (atom = ni_json_array_get(elems, i)); ++i) {
+			if (ni_string_eq(ni_json_string_value(ni_json_array_get(atom, 0)), "uuid"))
+				ni_string_array_append(uuids, ni_json_string_value(ni_json_array_get(atom, 1)));
+		}
+	}
+	return uuids->count;
+}
+
+static const char *
+ni_ovsdb_find_by_name(ni_ovsdb_client_t *client, const char *table, const char *name, ni_json_t **row)
+{
+	ni_json_t *rows = ni_ovsdb_table(client, table);
+	unsigned int i;
+
+	for (i = 0; i < ni_json_object_entries(rows); ++i) {
+		ni_json_pair_t *pair = ni_json_object_get_pair_at(rows, i);
+
+		if (ni_string_eq(ni_ovsdb_row_string(ni_json_pair_get_value(pair), "name"), name)) {
+			if (row)
+				*row = ni_json_pair_get_value(pair);
+			return ni_json_pair_get_name(pair);
+		}
+	}
+	return NULL;
+}
+
+/*
+ * The (real) bridge a port row belongs to
+ */
+static const char *
+ni_ovsdb_port_owner(ni_ovsdb_client_t *client, const char *port_uuid, ni_json_t **bridge)
+{
+	ni_string_array_t ports = NI_STRING_ARRAY_INIT;
+	ni_json_t *rows = ni_ovsdb_table(client, "Bridge");
+	unsigned int i;
+
+	for (i = 0; i < ni_json_object_entries(rows); ++i) {
+		ni_json_pair_t *pair = ni_json_object_get_pair_at(rows, i);
+
+		ni_ovsdb_row_uuids(ni_json_pair_get_value(pair), "ports", &ports);
+		if (ni_string_array_index(&ports, port_uuid) >= 0) {
+			ni_string_array_destroy(&ports);
+			if (bridge)
+				*bridge = ni_json_pair_get_value(pair);
+			return ni_json_pair_get_name(pair);
+		}
+	}
+	ni_string_array_destroy(&ports);
+	return NULL;
+}
+
+/*
+ * Resolved view of a real or fake bridge
+ */
+typedef struct ni_ovsdb_bridge {
+	const char *		uuid;		/* real bridge row */
+	ni_json_t *		row;
+	const char *		fake_uuid;	/* fake bridge port row */
+	int64_t			tag;
+} ni_ovsdb_bridge_t;
+
+static ni_bool_t
+ni_ovsdb_fake_bridge_with_tag(ni_ovsdb_client_t *client, ni_json_t *bridge, int64_t tag)
+{
+	ni_string_array_t ports = NI_STRING_ARRAY_INIT;
+	ni_bool_t found = FALSE;
+	unsigned int i;
+	int64_t ptag;
+
+	ni_ovsdb_row_uuids(bridge, "ports", &ports);
+	for (i = 0; !found && i < ports.count; ++i) {
+		ni_json_t *port = ni_ovsdb_row(client, "Port", ports.data[i]);
+
+		if (ni_ovsdb_row_bool(port, "fake_bridge") &&
+		    ni_ovsdb_row_int(port, "tag", &ptag) && ptag == tag)
+			found = TRUE;
+	}
+	ni_string_array_destroy(&ports);
+	return found;
+}
+
+static ni_bool_t
+ni_ovsdb_bridge_lookup(ni_ovsdb_client_t *client, const char *name, ni_ovsdb_bridge_t *br)
+{
+	ni_json_t *port;
+
+	memset(br, 0, sizeof(*br));
+	if ((br->uuid = ni_ovsdb_find_by_name(client, "Bridge", name, &br->row)))
+		return TRUE;
+
+	if (!(br->fake_uuid = ni_ovsdb_find_by_name(client, "Port", name, &port)) ||
+	    !ni_ovsdb_row_bool(port, "fake_bridge") ||
+	    !ni_ovsdb_row_int(port, "tag", &br->tag))
+		return FALSE;
+
+	return (br->uuid = ni_ovsdb_port_owner(client, br->fake_uuid, &br->row)) != NULL;
+}
+
+/*
+ * Whether a port of a real bridge belongs to the given (fake) bridge
+ */
+static ni_bool_t
+ni_ovsdb_bridge_has_port(ni_ovsdb_client_t *client, const ni_ovsdb_bridge_t *br,
+			const char *brname, ni_json_t *port)
+{
+	ni_bool_t tagged;
+	int64_t tag;
+
+	if (!port || ni_ovsdb_row_bool(port, "fake_bridge"))
+		return FALSE;
+	if (ni_string_eq(ni_ovsdb_row_string(port, "name"), brname))
+		return FALSE;
+
+	tagged = ni_ovsdb_row_int(port, "tag", &tag) &&
+		ni_ovsdb_fake_bridge_with_tag(client, br->row, tag);
+	if (br->fake_uuid)
+		return tagged && tag == br->tag;
+	return !tagged;
+}
+
+/*
+ * Transaction building
+ */
+static ni_json_t *
+ni_ovsdb_uuid_new(const char *type, const char *uuid)
+{
+	ni_json_t *atom = ni_json_new_array();
+
+	ni_json_array_append(atom, ni_json_new_string(type));
+	ni_json_array_append(atom, ni_json_new_string(uuid));
+	return atom;
+}
+
+static ni_json_t *
+ni_ovsdb_set_new(ni_json_t *elems)
+{
+	ni_json_t *set = ni_json_new_array();
+
+	ni_json_array_append(set, ni_json_new_string("set"));
+	ni_json_array_append(set, elems);
+	return set;
+}
+
+static ni_json_t *
+ni_ovsdb_where_uuid(const char *uuid)
+{
+	ni_json_t *where = ni_json_new_array();
+	ni_json_t *cond = ni_json_new_array();
+
+	if (uuid) {
+		ni_json_array_append(cond, ni_json_new_string("_uuid"));
+		ni_json_array_append(cond, ni_json_new_string("=="));
+		ni_json_array_append(cond, ni_ovsdb_uuid_new("uuid", uuid));
+		ni_json_array_append(where, cond);
+	} else {
+		ni_json_free(cond);
+	}
+	return where;
+}
+
+static void
+ni_ovsdb_txn_insert(ni_json_t *txn, const char *table, ni_json_t *row, const char *uuid_name)
+{
+	ni_json_t *op = ni_json_new_object();
+
+	ni_json_object_set(op, "op", ni_json_new_string("insert"));
+	ni_json_object_set(op, "table", ni_json_new_string(table));
+	ni_json_object_set(op, "row", row);
+	ni_json_object_set(op, "uuid-name", ni_json_new_string(uuid_name));
+	ni_json_array_append(txn, op);
+}
+
+static void
+ni_ovsdb_txn_mutate(ni_json_t *txn, const char *table, const char *uuid,
+			const char *column, const char *mutator, ni_json_t *refs)
+{
+	ni_json_t *op = ni_json_new_object();
+	ni_json_t *mutations = ni_json_new_array();
+	ni_json_t *mutation = ni_json_new_array();
+
+	ni_json_array_append(mutation, ni_json_new_string(column));
+	ni_json_array_append(mutation, ni_json_new_string(mutator));
+	ni_json_array_append(mutation, ni_ovsdb_set_new(refs));
+	ni_json_array_append(mutations, mutation);
+
+	ni_json_object_set(op, "op", ni_json_new_string("mutate"));
+	ni_json_object_set(op, "table", ni_json_new_string(table));
+	ni_json_object_set(op, "where", ni_ovsdb_where_uuid(uuid));
+	ni_json_object_set(op, "mutations", mutations);
+	ni_json_array_append(txn, op);
+}
+
+/*
+ * Add an Interface and a Port row for a port device and a reference
+ * to the port into refs; the tag is set when tag >= 0.
+ */
+static void
+ni_ovsdb_txn_add_port(ni_json_t *txn, ni_json_t *refs, const char *name,
+			const char *type, int64_t tag, ni_bool_t fake_bridge)
+{
+	ni_json_t *iface = ni_json_new_object();
+	ni_json_t *port = ni_json_new_object();
+	char *iname = NULL, *pname = NULL;
+	unsigned int n = ni_json_array_entries(refs);
+
+	ni_string_printf(&iname, "iface%u", n);
+	ni_string_printf(&pname, "port%u", n);
+
+	ni_json_object_set(iface, "name", ni_json_new_string(name));
+	if (type)
+		ni_json_object_set(iface, "type", ni_json_new_string(type));
+	ni_ovsdb_txn_insert(txn, "Interface", iface, iname);
+
+	ni_json_object_set(port, "name", ni_json_new_string(name));
+	ni_json_object_set(port, "interfaces", ni_ovsdb_uuid_new("named-uuid", iname));
+	if (tag >= 0)
+		ni_json_object_set(port, "tag", ni_json_new_int64(tag));
+	if (fake_bridge)
+		ni_json_object_set(port, "fake_bridge", ni_json_new_bool(TRUE));
+	ni_ovsdb_txn_insert(txn, "Port", port, pname);
+
+	ni_json_array_append(refs, ni_ovsdb_uuid_new("named-uuid", pname));
+	ni_string_free(&iname);
+	ni_string_free(&pname);
+}
+
+/*
+ * Commit the operations in one transaction
+ */
+static int
+ni_ovsdb_transact(ni_ovsdb_client_t *client, ni_json_t *txn)
+{
+	ni_json_t *params, *result = NULL, *error;
+	unsigned int i, n;
+	int rv = 0;
+
+	n = ni_json_array_entries(txn);
+	params = ni_json_new_array();
+	ni_json_array_append(params, ni_json_new_string(NI_OVSDB_DATABASE));
+	for (i = 0; i < n; ++i)
+		ni_json_array_append(params, ni_json_array_ref(txn, i));
+
+	ni_debug_ifconfig("ovsdb: transact with %u operations", n);
+	if (ni_ovsdb_client_call(client, "transact", params, &result) < 0) {
+		ni_ovsdb_client_reset();
+		return -1;
+	}
+
+	/* error objects in the result array, e.g. on a constraint violation */
+	for (i = 0; i < ni_json_array_entries(result); ++i) {
+		error = ni_json_object_get_value(ni_json_array_get(result, i), "error");
+		if (error && !ni_json_is_null(error)) {
+			ni_error("ovsdb: transaction failed: %s",
+				ni_json_string_value(error) ?: "unknown error");
+			rv = -1;
+			break;
+		}
+	}
+	ni_json_free(result);
+	return rv;
+}
+
+/*
+ * Bridge and port operations
+ */
+int
+ni_ovsdb_bridge_exists(const char *brname)
+{
+	ni_ovsdb_client_t *client;
+	ni_ovsdb_bridge_t br;
+
+	if (ni_string_empty(brname) || !(client = ni_ovsdb_client_get()))
+		return -1;
+
+	return ni_ovsdb_bridge_lookup(client, brname, &br) ? 0 : -1;
+}
+
+int
+ni_ovsdb_bridge_to_vlan(const char *brname, uint16_t *vlan)
+{
+	ni_ovsdb_client_t *client;
+	ni_ovsdb_bridge_t br;
+
+	if (ni_string_empty(brname) || !vlan || !(client = ni_ovsdb_client_get()))
+		return -1;
+
+	if (!ni_ovsdb_bridge_lookup(client, brname, &br)) {
+		ni_error("%s: unable to query bridge vlan", brname);
+		return -1;
+	}
+	if (br.tag < 0 || br.tag >= 0x0fff /* VLAN_VID_MASK */) {
+		ni_error("%s: bridge vlan id %"PRId64" not in range 1..%u", brname, br.tag, 0x0fff);
+		return -1;
+	}
+	*vlan = br.tag;
+	return 0;
+}
+
+int
+ni_ovsdb_bridge_to_parent(const char *brname, char **parent)
+{
+	ni_ovsdb_client_t *client;
+	ni_ovsdb_bridge_t br;
+
+	if (ni_string_empty(brname) || !parent || !(client = ni_ovsdb_client_get()))
+		return -1;
+
+	if (!ni_ovsdb_bridge_lookup(client, brname, &br)) {
+		ni_error("%s: unable to query bridge parent", brname);
+		return -1;
+	}
+	if (br.fake_uuid)
+		ni_string_dup(parent, ni_ovsdb_row_string(br.row, "name"));
+	return 0;
+}
+
+int
+ni_ovsdb_bridge_ports(const char *brname, ni_ovs_bridge_port_array_t *ports)
+{
+	ni_string_array_t uuids = NI_STRING_ARRAY_INIT;
+	ni_ovsdb_client_t *client;
+	ni_ovsdb_bridge_t br;
+	unsigned int i;
+
+	if (ni_string_empty(brname) || !ports || !(client = ni_ovsdb_client_get()))
+		return -1;
+
+	if (!ni_ovsdb_bridge_lookup(client, brname, &br)) {
+		ni_error("%s: unable to query bridge ports", brname);
+		return -1;
+	}
+
+	ni_ovsdb_row_uuids(br.row, "ports", &uuids);
+	for (i = 0; i < uuids.count; ++i) {
+		ni_json_t *port = ni_ovsdb_row(client, "Port", uuids.data[i]);
+
+		if (ni_ovsdb_bridge_has_port(client, &br, brname, port))
+			ni_ovs_bridge_port_array_add_new(ports, ni_ovsdb_row_string(port, "name"));
+	}
+	ni_string_array_destroy(&uuids);
+	return 0;
+}
+
+int
+ni_ovsdb_bridge_port_to_bridge(const char *pname, char **brname)
+{
+	ni_string_array_t uuids = NI_STRING_ARRAY_INIT;
+	ni_ovsdb_client_t *client;
+	ni_json_t *port, *bridge, *fake;
+	const char *uuid;
+	unsigned int i;
+	int64_t tag;
+
+	if (ni_string_empty(pname) || !brname || !(client = ni_ovsdb_client_get()))
+		return -1;
+
+	if (!(uuid = ni_ovsdb_find_by_name(client, "Port", pname, &port)) ||
+	    !ni_ovsdb_port_owner(client, uuid, &bridge)) {
+		ni_error("%s: unable to query port bridge", pname);
+		return -1;
+	}
+
+	ni_string_dup(brname, ni_ovsdb_row_string(bridge, "name"));
+	if (!ni_ovsdb_row_int(port, "tag", &tag))
+		return 0;
+
+	/* a tagged port belongs to the fake bridge with this tag */
+	ni_ovsdb_row_uuids(bridge, "ports", &uuids);
+	for (i = 0; i < uuids.count; ++i) {
+		int64_t ftag;
+
+		fake = ni_ovsdb_row(client, "Port", uuids.data[i]);
+		if (ni_ovsdb_row_bool(fake, "fake_bridge") &&
+		    ni_ovsdb_row_int(fake, "tag", &ftag) && ftag == tag) {
+			ni_string_dup(brname, ni_ovsdb_row_string(fake, "name"));
+			break;
+		}
+	}
+	ni_string_array_destroy(&uuids);
+	return 0;
+}
+
+/*
+ * Creates the bridge together with all configured ports, which do
+ * not exist yet, in a single transaction.
+ */
+int
+ni_ovsdb_bridge_add(const ni_netdev_t *cfg, ni_bool_t may_exist)
+{
+	ni_ovsdb_client_t *client;
+	ni_ovsdb_bridge_t br, parent;
+	const char *pname, *vlan_parent;
+	ni_json_t *txn, *refs;
+	int64_t tag = -1;
+	unsigned int i;
+	int rv;
+
+	if (!cfg || ni_string_empty(cfg->name) || !cfg->ovsbr || !(client = ni_ovsdb_client_get()))
+		return -1;
+
+	if (ni_ovsdb_bridge_lookup(client, cfg->name, &br)) {
+		if (may_exist)
+			return 0;
+		ni_error("%s: ovs bridge already exists", cfg->name);
+		return -1;
+	}
+
+	vlan_parent = cfg->ovsbr->config.vlan.parent.name;
+	if (!ni_string_empty(vlan_parent)) {
+		if (!ni_ovsdb_bridge_lookup(client, vlan_parent, &parent) || parent.fake_uuid) {
+			ni_error("%s: ovs parent bridge %s does not exist", cfg->name, vlan_parent);
+			return -1;
+		}
+		tag = cfg->ovsbr->config.vlan.tag;
+	}
+
+	txn = ni_json_new_array();
+	refs = ni_json_new_array();
+	ni_ovsdb_txn_add_port(txn, refs, cfg->name, "internal", tag, tag >= 0);
+
+	for (i = 0; i < cfg->ovsbr->ports.count; ++i) {
+		pname = cfg->ovsbr->ports.data[i]->device.name;
+		if (ni_string_empty(pname) || ni_ovsdb_find_by_name(client, "Port", pname, NULL))
+			continue;
+		ni_ovsdb_txn_add_port(txn, refs, pname, NULL, tag, FALSE);
+	}
+
+	if (tag >= 0) {
+		ni_ovsdb_txn_mutate(txn, "Bridge", parent.uuid, "ports", "insert", refs);
+	} else {
+		ni_json_t *bridge = ni_json_new_object();
+		ni_json_t *brefs = ni_json_new_array();
+
+		ni_json_object_set(bridge, "name", ni_json_new_string(cfg->name));
+		ni_json_object_set(bridge, "ports", ni_ovsdb_set_new(refs));
+		ni_ovsdb_txn_insert(txn, "Bridge", bridge, "bridge");
+
+		ni_json_array_append(brefs, ni_ovsdb_uuid_new("named-uuid", "bridge"));
+		ni_ovsdb_txn_mutate(txn, "Open_vSwitch", NULL, "bridges", "insert", brefs);
+	}
+
+	rv = ni_ovsdb_transact(client, txn);
+	ni_json_free(txn);
+	return rv;
+}
+
+int
+ni_ovsdb_bridge_del(const char *brname)
+{
+	ni_string_array_t uuids = NI_STRING_ARRAY_INIT;
+	ni_ovsdb_client_t *client;
+	ni_ovsdb_bridge_t br;
+	ni_json_t *txn, *refs;
+	unsigned int i;
+	int rv;
+
+	if (ni_string_empty(brname) || !(client = ni_ovsdb_client_get()))
+		return -1;
+
+	if (!ni_ovsdb_bridge_lookup(client, brname, &br))
+		return 0;
+
+	txn = ni_json_new_array();
+	refs = ni_json_new_array();
+	if (br.fake_uuid) {
+		/* the fake bridge port and all ports with its tag */
+		ni_json_array_append(refs, ni_ovsdb_uuid_new("uuid", br.fake_uuid));
+		ni_ovsdb_row_uuids(br.row, "ports", &uuids);
+		for (i = 0; i < uuids.count; ++i) {
+			ni_json_t *port = ni_ovsdb_row(client, "Port", uuids.data[i]);
+
+			if (ni_ovsdb_bridge_has_port(client, &br, brname, port))
+				ni_json_array_append(refs, ni_ovsdb_uuid_new("uuid", uuids.data[i]));
+		}
+		ni_string_array_destroy(&uuids);
+		ni_ovsdb_txn_mutate(txn, "Bridge", br.uuid, "ports", "delete", refs);
+	} else {
+		/* unreferenced bridge, port and interface rows are garbage collected */
+		ni_json_array_append(refs, ni_ovsdb_uuid_new("uuid", br.uuid));
+		ni_ovsdb_txn_mutate(txn, "Open_vSwitch", NULL, "bridges", "delete", refs);
+	}
+
+	rv = ni_ovsdb_transact(client, txn);
+	ni_json_free(txn);
+	return rv;
+}
+
+int
+ni_ovsdb_bridge_port_add(const char *pname, const ni_ovs_bridge_port_config_t *pconf, ni_bool_t may_exist)
+{
+	ni_ovsdb_client_t *client;
+	ni_ovsdb_bridge_t br;
+	ni_json_t *txn, *refs;
+	char *owner = NULL;
+	int rv;
+
+	if (ni_string_empty(pname) || !pconf || ni_string_empty(pconf->bridge.name) ||
+	    !(client = ni_ovsdb_client_get()))
+		return -1;
+
+	if (!ni_ovsdb_bridge_lookup(client, pconf->bridge.name, &br)) {
+		ni_error("%s: ovs bridge %s does not exist", pname, pconf->bridge.name);
+		return -1;
+	}
+
+	if (ni_ovsdb_find_by_name(client, "Port", pname, NULL)) {
+		rv = -1;
+		if (ni_ovsdb_bridge_port_to_bridge(pname, &owner) == 0 &&
+		    ni_string_eq(owner, pconf->bridge.name) && may_exist)
+			rv = 0;
+		else
+			ni_error("%s: port already exists in ovs bridge %s", pname, owner ?: "");
+		ni_string_free(&owner);
+		return rv;
+	}
+
+	txn = ni_json_new_array();
+	refs = ni_json_new_array();
+	ni_ovsdb_txn_add_port(txn, refs, pname, NULL, br.fake_uuid ? br.tag : -1, FALSE);
+	ni_ovsdb_txn_mutate(txn, "Bridge", br.uuid, "ports", "insert", refs);
+
+	rv = ni_ovsdb_transact(client, txn);
+	ni_json_free(txn);
+	return rv;
+}
+
+int
+ni_ovsdb_bridge_port_del(const char *brname, const char *pname)
+{
+	ni_ovsdb_client_t *client;
+	ni_ovsdb_bridge_t br;
+	ni_json_t *txn, *refs, *port;
+	const char *uuid;
+	int rv;
+
+	if (ni_string_empty(brname) || ni_string_empty(pname) || !(client = ni_ovsdb_client_get()))
+		return -1;
+
+	if (!ni_ovsdb_bridge_lookup(client, brname, &br) ||
+	    !(uuid = ni_ovsdb_find_by_name(client, "Port", pname, &port)) ||
+	    !ni_ovsdb_bridge_has_port(client, &br, brname, port)) {
+		ni_error("%s: not a port of ovs bridge %s", pname, brname);
+		return -1;
+	}
+
+	txn = ni_json_new_array();
+	refs = ni_json_new_array();
+	ni_json_array_append(refs, ni_ovsdb_uuid_new("uuid", uuid));
+	ni_ovsdb_txn_mutate(txn, "Bridge", br.uuid, "ports", "delete", refs);
+
+	rv = ni_ovsdb_transact(client, txn);
+	ni_json_free(txn);
+	return rv;
+}
@@ -14,9 +14,12 @@
 #include <unistd.h>
 #include <errno.h>
 #include <signal.h>
+#include <spawn.h>
+#include <string.h>
 
 #include <wicked/logging.h>
 #include <wicked/socket.h>
+#include <wicked/metrics.h>
 #include "socket_priv.h"
 #include "process.h"
 
@@ -493,24 +496,16 @@ ni_process_run_and_capture_output(ni_process_t *pi, ni_buffer_t *out_buffer)
 	return __ni_process_run_info(pi);
 }
 
-int
-__ni_process_run(ni_process_t *pi, int *pfd)
+/*
+ * Start the child using fork, needed for in-process exec callbacks
+ * and when posix_spawn lacks the file actions we rely on.
+ */
+static int
+__ni_process_fork(ni_process_t *pi, int *pfd)
 {
-	const char *arg0 = pi->argv.data[0];
+	const char *arg0;
 	pid_t pid;
 
-	if (pi->pid != 0) {
-		ni_error("Cannot execute process instance twice (%s)", pi->process->command);
-		return NI_PROCESS_FAILURE;
-	}
-
-	if (!pi->exec && !ni_file_executable(arg0)) {
-		ni_error("Unable to run %s; does not exist or is not executable", arg0);
-		return NI_PROCESS_COMMAND;
-	}
-
-	signal(SIGCHLD, ni_process_sigchild);
-
 	if ((pid = fork()) < 0) {
 		ni_error("%s: unable to fork child process: %m", __func__);
 		return NI_PROCESS_FAILURE;
@@ -527,14 +522,19 @@ __ni_process_run(ni_process_t *pi, int *pfd)
 			ni_warn("%s: unable to chdir to /: %m", __func__);
 
 		close(0);
-		if ((fd = open("/dev/null", O_RDONLY)) < 0)
-			ni_warn("%s: unable to open /dev/null: %m", __func__);
-		else if (dup2(fd, 0) < 0)
-			ni_warn("%s: cannot dup null descriptor: %m", __func__);
-
-		if (pfd) {
-			if (dup2(pfd[1], 1) < 0 || dup2(pfd[1], 2) < 0)
-				ni_warn("%s: cannot dup pipe out descriptor: %m", __func__);
+		if (pfd && pi->duplex) {
+			if (dup2(pfd[1], 0) < 0 || dup2(pfd[1], 1) < 0)
+				ni_warn("%s: cannot dup socket descriptor: %m", __func__);
+		} else {
+			if ((fd = open("/dev/null", O_RDONLY)) < 0)
+				ni_warn("%s: unable to open /dev/null: %m", __func__);
+			else if (dup2(fd, 0) < 0)
+				ni_warn("%s: cannot dup null descriptor: %m", __func__);
+
+			if (pfd) {
+				if (dup2(pfd[1], 1) < 0 || dup2(pfd[1], 2) < 0)
+					ni_warn("%s: cannot dup pipe out descriptor: %m", __func__);
+			}
 		}
 
 		maxfd = getdtablesize();
@@ -562,6 +562,99 @@ __ni_process_run(ni_process_t *pi, int *pfd)
 	return NI_PROCESS_SUCCESS;
 }
 
+#if defined(HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCHDIR_NP) && \
+    defined(HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP)
+/*
+ * Start the child using posix_spawn, which uses a vfork-like clone and
+ * does not copy the page tables of the (potentially large) daemon.
+ * The file actions set up the same child environment as the fork code.
+ */
+static int
+__ni_process_spawn(ni_process_t *pi, int *pfd)
+{
+	static char *empty[] = { NULL };
+	posix_spawn_file_actions_t actions;
+	char **argv, **envp;
+	pid_t pid;
+	int err;
+
+	/* string arrays keep a NULL slot behind the last element */
+	argv = pi->argv.data;
+	envp = pi->environ.count ? pi->environ.data : empty;
+
+	if ((err = posix_spawn_file_actions_init(&actions))) {
+		ni_error("%s: unable to init spawn file actions: %s",
+				__func__, strerror(err));
+		return NI_PROCESS_FAILURE;
+	}
+
+	if (pfd && pi->duplex) {
+		err = posix_spawn_file_actions_adddup2(&actions, pfd[1], 0);
+		if (!err)
+			err = posix_spawn_file_actions_adddup2(&actions, pfd[1], 1);
+	} else {
+		err = posix_spawn_file_actions_addopen(&actions, 0, "/dev/null", O_RDONLY, 0);
+		if (!err && pfd)
+			err = posix_spawn_file_actions_adddup2(&actions, pfd[1], 1);
+		if (!err && pfd)
+			err = posix_spawn_file_actions_adddup2(&actions, pfd[1], 2);
+	}
+	if (err ||
+	    (err = posix_spawn_file_actions_addchdir_np(&actions, "/")) ||
+	    (err = posix_spawn_file_actions_addclosefrom_np(&actions, 3))) {
+		ni_error("%s: unable to prepare spawn file actions: %s",
+				__func__, strerror(err));
+		posix_spawn_file_actions_destroy(&actions);
+		return NI_PROCESS_FAILURE;
+	}
+
+	err = posix_spawn(&pid, argv[0], &actions, NULL, argv, envp);
+	posix_spawn_file_actions_destroy(&actions);
+	if (err) {
+		ni_error("%s: cannot execute %s: %s", __func__, argv[0], strerror(err));
+		return NI_PROCESS_FAILURE;
+	}
+
+	pi->pid = pid;
+	pi->status = -1;
+	ni_timer_get_time(&pi->started);
+	return NI_PROCESS_SUCCESS;
+}
+#endif
+
+int
+__ni_process_run(ni_process_t *pi, int *pfd)
+{
+	const char *arg0 = pi->argv.data[0];
+	struct timeval start;
+	int rv;
+
+	if (pi->pid != 0) {
+		ni_error("Cannot execute process instance twice (%s)", pi->process->command);
+		return NI_PROCESS_FAILURE;
+	}
+
+	if (!pi->exec && !ni_file_executable(arg0)) {
+		ni_error("Unable to run %s; does not exist or is not executable", arg0);
+		return NI_PROCESS_COMMAND;
+	}
+
+	signal(SIGCHLD, ni_process_sigchild);
+
+	ni_metrics_begin(&start);
+#if defined(HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCHDIR_NP) && \
+    defined(HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP)
+	if (!pi->exec)
+		rv = __ni_process_spawn(pi, pfd);
+	else
+#endif
+		rv = __ni_process_fork(pi, pfd);
+
+	if (rv >= NI_PROCESS_SUCCESS)
+		ni_metrics_end(NI_METRIC_PROCESS_START, &start);
+	return rv;
+}
+
 /*
  * Collect the exit status of the child process
  */
@@ -34,6 +34,7 @@ struct ni_process {
 	ni_string_array_t	environ;
 
 	ni_socket_t *		socket;
+	ni_bool_t		duplex;		/* socket is stdin and stdout */
 	ni_tempstate_t *	temp_state;
 
 	void			(*notify_callback)(ni_process_t *);
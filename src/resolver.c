@@ -104,7 +104,11 @@ ni_resolver_info_new(void)
 void
 ni_resolver_info_free(ni_resolver_info_t *resolv)
 {
+	if (!resolv)
+		return;
+
 	ni_string_free(&resolv->default_domain);
 	ni_string_array_destroy(&resolv->dns_search);
 	ni_string_array_destroy(&resolv->dns_servers);
+	free(resolv);
 }
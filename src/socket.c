@@ -24,11 +24,13 @@
 #include <wicked/logging.h>
 #include <wicked/xml.h>
 #include <wicked/socket.h>
+#include <wicked/metrics.h>
 #include "netinfo_priv.h"
 #include "socket_priv.h"
 #include "appconfig.h"
 
 #define	NI_SOCKET_ARRAY_CHUNK	16
+#define	NI_SOCKET_LOG_RETRY	100	/* msec */
 
 static void			__ni_socket_close(ni_socket_t *);
 static void			__ni_default_error_handler(ni_socket_t *);
@@ -117,7 +119,7 @@ int
 ni_socket_array_wait(ni_socket_array_t *array, long timeout)
 {
 	struct pollfd pfd[array->count];
-	struct timeval now, expires;
+	struct timeval now, expires, start;
 	unsigned int i, socket_count;
 
 	/* First step - cleanup empty socket slots from the array. */
@@ -171,6 +173,8 @@ ni_socket_array_wait(ni_socket_array_t *array, long timeout)
 		return -1;
 	}
 
+	ni_metrics_begin(&start);
+
 	for (i = 0; i < socket_count; ++i) {
 		ni_socket_t *sock = array->data[i];
 
@@ -234,12 +238,18 @@ done_with_this_socket:
 	/* Finally cleanup deactivated/released sockets */
 	ni_socket_array_cleanup(array);
 
+	ni_metrics_end(NI_METRIC_SOCKET_DISPATCH, &start);
 	return 0;
 }
 
 int
 ni_socket_wait(long timeout)
 {
+	/* Write out deferred log messages before we go to sleep. If the
+	 * log sink is backed up, come back soon to retry. */
+	if (ni_log_flush() && (timeout < 0 || timeout > NI_SOCKET_LOG_RETRY))
+		timeout = NI_SOCKET_LOG_RETRY;
+
 	return ni_socket_array_wait(&__ni_sockets, timeout);
 }
 
@@ -58,6 +58,7 @@ extern unsigned int	ni_socket_array_find(ni_socket_array_t *, ni_socket_t *);
 
 extern ni_bool_t	ni_socket_array_activate(ni_socket_array_t *, ni_socket_t *);
 extern ni_bool_t	ni_socket_array_deactivate(ni_socket_array_t *, ni_socket_t *);
+extern int		ni_socket_array_wait(ni_socket_array_t *, long);
 
 #endif /* __WICKED_SOCKET_PRIV_H__ */
 
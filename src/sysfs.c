@@ -7,13 +7,17 @@
 #include "config.h"
 #endif
 
+#include <sys/uio.h>
 #include <unistd.h>
 #include <limits.h>
+#include <fcntl.h>
+#include <errno.h>
 #include <net/if_arp.h>
 
 #include <wicked/netinfo.h>
 #include <wicked/logging.h>
 #include <wicked/pci.h>
+#include <wicked/xml.h>
 #include "util_priv.h"
 #include "sysfs.h"
 #include "ibft.h"
@@ -48,11 +52,314 @@
 static const char *	__ni_sysfs_netif_attrpath(const char *ifname, const char *attr);
 static const char *	__ni_sysfs_netif_get_attr(const char *ifname, const char *attr);
 static int		__ni_sysfs_netif_put_attr(const char *, const char *, const char *);
+static int		__ni_sysfs_netif_put_setting(const char *, const char *, const char *, ...);
 static int		__ni_sysfs_printf(const char *, const char *, ...);
 static int		__ni_sysfs_read_list(const char *, ni_string_array_t *);
 static int		__ni_sysfs_read_string(const char *, char **);
 
 
+/*
+ * Per-interface directory cache
+ *
+ * Setting up an interface reads and writes a bunch of attributes in
+ * its sysfs and ipv4/ipv6 conf sysctl directories. We keep an open
+ * directory descriptor of the recently used ones to access them using
+ * openat, and remember the last value written to the sysfs settings
+ * to skip writes which would not change anything.
+ * The ipv4/ipv6 conf values are not remembered: their callers compare
+ * against the devconf discovered via netlink, which also reflects any
+ * change made by the admin using sysctl.
+ * Entries are kept per interface name in a hash table, so the cache
+ * grows with the number of devices; only the descriptors are limited
+ * to the most recently used ones. Entries are dropped when the interface
+ * is renamed or deleted and a stale descriptor is detected by a failing
+ * openat and reopened.
+ */
+enum {
+	NI_SYSFS_IFDIR_NETIF,
+	NI_SYSFS_IFDIR_IPV4_CONF,
+	NI_SYSFS_IFDIR_IPV6_CONF,
+
+	__NI_SYSFS_IFDIR_MAX
+};
+
+static const char *	ni_sysfs_ifdir_base[__NI_SYSFS_IFDIR_MAX] = {
+	[NI_SYSFS_IFDIR_NETIF]		= _PATH_SYS_CLASS_NET,
+	[NI_SYSFS_IFDIR_IPV4_CONF]	= "/proc/sys/net/ipv4/conf",
+	[NI_SYSFS_IFDIR_IPV6_CONF]	= "/proc/sys/net/ipv6/conf",
+};
+
+#define NI_SYSFS_IFDIR_HASH_SIZE	1024
+#define NI_SYSFS_IFDIR_OPEN_MAX		64
+
+typedef struct ni_sysfs_ifdir	ni_sysfs_ifdir_t;
+
+struct ni_sysfs_ifdir {
+	ni_sysfs_ifdir_t *	next;		/* hash chain */
+	ni_sysfs_ifdir_t *	lru_prev;	/* entries with an open dirfd */
+	ni_sysfs_ifdir_t *	lru_next;
+	char *			ifname;
+	unsigned int		kind;
+	int			dirfd;
+	ni_var_array_t		values;
+};
+
+static ni_sysfs_ifdir_t *	ni_sysfs_ifdir_hash[NI_SYSFS_IFDIR_HASH_SIZE];
+static struct {
+	ni_sysfs_ifdir_t *	head;
+	ni_sysfs_ifdir_t *	tail;
+	unsigned int		count;
+} ni_sysfs_ifdir_lru;
+
+static unsigned int
+__ni_sysfs_ifdir_hash(unsigned int kind, const char *ifname)
+{
+	unsigned int hash = 2166136261U;	/* FNV-1a */
+
+	while (*ifname) {
+		hash ^= (unsigned char)*ifname++;
+		hash *= 16777619U;
+	}
+	hash ^= kind;
+	hash *= 16777619U;
+	return hash % NI_SYSFS_IFDIR_HASH_SIZE;
+}
+
+static ni_sysfs_ifdir_t *
+__ni_sysfs_ifdir_find(unsigned int kind, const char *ifname)
+{
+	ni_sysfs_ifdir_t *dir;
+
+	if (ni_string_empty(ifname))
+		return NULL;
+
+	dir = ni_sysfs_ifdir_hash[__ni_sysfs_ifdir_hash(kind, ifname)];
+	for ( ; dir; dir = dir->next) {
+		if (dir->kind == kind && ni_string_eq(dir->ifname, ifname))
+			return dir;
+	}
+	return NULL;
+}
+
+static void
+__ni_sysfs_ifdir_lru_unlink(ni_sysfs_ifdir_t *dir)
+{
+	if (dir->lru_prev)
+		dir->lru_prev->lru_next = dir->lru_next;
+	else
+		ni_sysfs_ifdir_lru.head = dir->lru_next;
+	if (dir->lru_next)
+		dir->lru_next->lru_prev = dir->lru_prev;
+	else
+		ni_sysfs_ifdir_lru.tail = dir->lru_prev;
+	dir->lru_prev = dir->lru_next = NULL;
+}
+
+static void
+__ni_sysfs_ifdir_lru_push(ni_sysfs_ifdir_t *dir)
+{
+	dir->lru_prev = NULL;
+	dir->lru_next = ni_sysfs_ifdir_lru.head;
+	if (dir->lru_next)
+		dir->lru_next->lru_prev = dir;
+	else
+		ni_sysfs_ifdir_lru.tail = dir;
+	ni_sysfs_ifdir_lru.head = dir;
+}
+
+static void
+__ni_sysfs_ifdir_close(ni_sysfs_ifdir_t *dir)
+{
+	if (dir->dirfd < 0)
+		return;
+
+	__ni_sysfs_ifdir_lru_unlink(dir);
+	ni_sysfs_ifdir_lru.count--;
+	close(dir->dirfd);
+	dir->dirfd = -1;
+}
+
+static void
+__ni_sysfs_ifdir_free(ni_sysfs_ifdir_t *dir)
+{
+	ni_sysfs_ifdir_t **pos;
+
+	pos = &ni_sysfs_ifdir_hash[__ni_sysfs_ifdir_hash(dir->kind, dir->ifname)];
+	for ( ; *pos; pos = &(*pos)->next) {
+		if (*pos == dir) {
+			*pos = dir->next;
+			break;
+		}
+	}
+
+	__ni_sysfs_ifdir_close(dir);
+	ni_string_free(&dir->ifname);
+	ni_var_array_destroy(&dir->values);
+	free(dir);
+}
+
+static ni_sysfs_ifdir_t *
+__ni_sysfs_ifdir_open(unsigned int kind, const char *ifname)
+{
+	ni_sysfs_ifdir_t *dir;
+	char pathbuf[PATH_MAX];
+	unsigned int hash;
+	int fd;
+
+	if (ni_string_empty(ifname) || strchr(ifname, '/'))
+		return NULL;
+
+	if ((dir = __ni_sysfs_ifdir_find(kind, ifname)) && dir->dirfd >= 0) {
+		if (dir != ni_sysfs_ifdir_lru.head) {
+			__ni_sysfs_ifdir_lru_unlink(dir);
+			__ni_sysfs_ifdir_lru_push(dir);
+		}
+		return dir;
+	}
+
+	snprintf(pathbuf, sizeof(pathbuf), "%s/%s", ni_sysfs_ifdir_base[kind], ifname);
+	if ((fd = open(pathbuf, O_PATH | O_DIRECTORY | O_CLOEXEC)) < 0) {
+		if (dir)
+			__ni_sysfs_ifdir_free(dir);
+		return NULL;
+	}
+
+	if (!dir) {
+		dir = xcalloc(1, sizeof(*dir));
+		dir->ifname = xstrdup(ifname);
+		dir->kind = kind;
+		hash = __ni_sysfs_ifdir_hash(kind, ifname);
+		dir->next = ni_sysfs_ifdir_hash[hash];
+		ni_sysfs_ifdir_hash[hash] = dir;
+	}
+
+	if (ni_sysfs_ifdir_lru.count >= NI_SYSFS_IFDIR_OPEN_MAX)
+		__ni_sysfs_ifdir_close(ni_sysfs_ifdir_lru.tail);
+
+	dir->dirfd = fd;
+	__ni_sysfs_ifdir_lru_push(dir);
+	ni_sysfs_ifdir_lru.count++;
+	return dir;
+}
+
+static int
+__ni_sysfs_ifdir_openat(unsigned int kind, const char *ifname, const char *attr,
+			int flags, ni_sysfs_ifdir_t **dirp)
+{
+	ni_sysfs_ifdir_t *dir;
+	int fd;
+
+	if (!(dir = __ni_sysfs_ifdir_open(kind, ifname)))
+		return -1;
+
+	if ((fd = openat(dir->dirfd, attr, flags | O_CLOEXEC)) < 0 && errno == ENOENT) {
+		/* the directory may be gone: reopen it and retry once */
+		__ni_sysfs_ifdir_free(dir);
+		if (!(dir = __ni_sysfs_ifdir_open(kind, ifname)))
+			return -1;
+		fd = openat(dir->dirfd, attr, flags | O_CLOEXEC);
+	}
+	*dirp = dir;
+	return fd;
+}
+
+static int
+__ni_sysfs_ifdir_read(unsigned int kind, const char *ifname, const char *attr,
+			char *buf, size_t size)
+{
+	ni_sysfs_ifdir_t *dir = NULL;
+	ssize_t len;
+	int fd;
+
+	if ((fd = __ni_sysfs_ifdir_openat(kind, ifname, attr, O_RDONLY, &dir)) < 0)
+		return -1;
+
+	while ((len = read(fd, buf, size - 1)) < 0 && errno == EINTR)
+		;
+	close(fd);
+	if (len < 0)
+		return -1;
+
+	buf[len] = '\0';
+	buf[strcspn(buf, "\n")] = '\0';
+
+	/* refresh a remembered setting, status attributes aren't worth it */
+	if (ni_var_array_get(&dir->values, attr))
+		ni_var_array_set(&dir->values, attr, buf);
+	return 0;
+}
+
+static int
+__ni_sysfs_ifdir_write(unsigned int kind, const char *ifname, const char *attr,
+			const char *value, ni_bool_t newline, ni_bool_t cached)
+{
+	ni_sysfs_ifdir_t *dir = NULL;
+	struct iovec iov[2];
+	ni_var_t *var;
+	ssize_t len;
+	int fd, err;
+
+	if (cached && (dir = __ni_sysfs_ifdir_find(kind, ifname)) &&
+	    (var = ni_var_array_get(&dir->values, attr)) &&
+	    ni_string_eq(var->value, value)) {
+		ni_debug_verbose(NI_LOG_DEBUG2, NI_TRACE_IFCONFIG,
+				"%s: %s/%s already set to %s",
+				ifname, ni_sysfs_ifdir_base[kind], attr, value);
+		return 0;
+	}
+
+	if ((fd = __ni_sysfs_ifdir_openat(kind, ifname, attr, O_WRONLY, &dir)) < 0)
+		return -1;
+
+	iov[0].iov_base = (char *)value;
+	iov[0].iov_len = strlen(value);
+	iov[1].iov_base = "\n";
+	iov[1].iov_len = newline ? 1 : 0;
+	while ((len = writev(fd, iov, 2)) < 0 && errno == EINTR)
+		;
+	err = errno;
+	close(fd);
+
+	if (len < 0) {
+		ni_var_array_remove(&dir->values, attr);
+		errno = err;
+		return -1;
+	}
+
+	if (cached)
+		ni_var_array_set(&dir->values, attr, value);
+	else
+		ni_var_array_remove(&dir->values, attr);
+	return 0;
+}
+
+static int
+__ni_sysfs_ifdir_read_string(unsigned int kind, const char *ifname, const char *attr,
+			char **result)
+{
+	char buffer[256];
+
+	if (__ni_sysfs_ifdir_read(kind, ifname, attr, buffer, sizeof(buffer)) < 0)
+		return -1;
+
+	ni_string_free(result);
+	if (*buffer)
+		ni_string_dup(result, buffer);
+	return 0;
+}
+
+void
+ni_sysfs_ifdir_cache_drop(const char *ifname)
+{
+	ni_sysfs_ifdir_t *dir;
+	unsigned int kind;
+
+	for (kind = 0; kind < __NI_SYSFS_IFDIR_MAX; ++kind) {
+		if ((dir = __ni_sysfs_ifdir_find(kind, ifname)))
+			__ni_sysfs_ifdir_free(dir);
+	}
+}
+
 /*
  * Functions for reading and writing sysfs attributes
  */
@@ -199,45 +506,50 @@ static const char *
 __ni_sysfs_netif_get_attr(const char *ifname, const char *attr_name)
 {
 	static char buffer[256];
-	const char *filename;
-	char *result = NULL;
-	FILE *fp;
 
-	filename = __ni_sysfs_netif_attrpath(ifname, attr_name);
-	if (!(fp = fopen(filename, "r")))
+	if (__ni_sysfs_ifdir_read(NI_SYSFS_IFDIR_NETIF, ifname, attr_name,
+					buffer, sizeof(buffer)) < 0)
 		return NULL;
+	return buffer;
+}
 
-	if (fgets(buffer, sizeof(buffer), fp) != NULL) {
-		buffer[strcspn(buffer, "\n")] = '\0';
-		result = buffer;
+static int
+__ni_sysfs_netif_put_attr(const char *ifname, const char *attr_name, const char *attr_value)
+{
+	if (__ni_sysfs_ifdir_write(NI_SYSFS_IFDIR_NETIF, ifname, attr_name,
+					attr_value, TRUE, FALSE) < 0) {
+		ni_error("Unable to set %s attribute %s=%s: %m",
+				ifname, attr_name, attr_value);
+		return -1;
 	}
-	fclose(fp);
-	return result;
+	return 0;
 }
 
+/*
+ * Settings which can be written again without side effects,
+ * skipped when the value is known to be set already.
+ */
 static int
-__ni_sysfs_netif_put_attr(const char *ifname, const char *attr_name, const char *attr_value)
+__ni_sysfs_netif_put_setting(const char *ifname, const char *attr_name, const char *fmt, ...)
 {
-	const char *filename;
-	FILE *fp;
-	int rv = 0;
+	char *attr_value = NULL;
+	va_list ap;
+	int ret;
 
-	filename = __ni_sysfs_netif_attrpath(ifname, attr_name);
-	if (!(fp = fopen(filename, "w"))) {
-		ni_error("Unable to set %s attribute %s: %m",
-				ifname, attr_name);
+	va_start(ap, fmt);
+	ret = vasprintf(&attr_value, fmt, ap);
+	va_end(ap);
+
+	if (ret < 0)
 		return -1;
-	}
 
-	fprintf(fp, "%s\n", attr_value);
-	if (fflush(fp) == EOF || ferror(fp)) {
-		ni_error("Unable to set %s attribute %s=%s: %s",
-				ifname, attr_name, attr_value,
-				strerror(ferror(fp)));
-		rv = -1;
-	}
-	fclose(fp);
-	return rv;
+	ret = __ni_sysfs_ifdir_write(NI_SYSFS_IFDIR_NETIF, ifname, attr_name,
+					attr_value, TRUE, TRUE);
+	if (ret < 0)
+		ni_error("Unable to set %s attribute %s=%s: %m",
+				ifname, attr_name, attr_value);
+	free(attr_value);
+	return ret;
 }
 
 static const char *
@@ -322,19 +634,20 @@ ni_sysfs_bonding_delete_arp_target(const char *master, const char *ipaddress)
 int
 ni_sysfs_bonding_get_attr(const char *ifname, const char *attr_name, char **result)
 {
-	static char pathbuf[PATH_MAX];
+	char attrbuf[PATH_MAX];
 
-	snprintf(pathbuf, sizeof(pathbuf), "%s/%s/bonding/%s", _PATH_SYS_CLASS_NET, ifname, attr_name);
-	return __ni_sysfs_read_string(pathbuf, result);
+	snprintf(attrbuf, sizeof(attrbuf), "bonding/%s", attr_name);
+	return __ni_sysfs_ifdir_read_string(NI_SYSFS_IFDIR_NETIF, ifname, attrbuf, result);
 }
 
 int
 ni_sysfs_bonding_set_attr(const char *ifname, const char *attr_name, const char *attr_value)
 {
-	static char pathbuf[PATH_MAX];
+	char attrbuf[PATH_MAX];
 
-	snprintf(pathbuf, sizeof(pathbuf), "%s/%s/bonding/%s", _PATH_SYS_CLASS_NET, ifname, attr_name);
-	return __ni_sysfs_printf(pathbuf, "%s", attr_value);
+	snprintf(attrbuf, sizeof(attrbuf), "bonding/%s", attr_name);
+	return __ni_sysfs_ifdir_write(NI_SYSFS_IFDIR_NETIF, ifname, attrbuf,
+					attr_value ? attr_value : "", FALSE, TRUE);
 }
 
 int
@@ -425,7 +738,7 @@ ni_sysfs_bridge_get_config(const char *ifname, ni_bridge_t *bridge)
 	if (ni_sysfs_netif_get_uint(ifname, SYSFS_BRIDGE_ATTR "/forward_delay", &ui) == 0)
 		bridge->forward_delay = (double)ui / 100.0;
 	if (ni_sysfs_netif_get_ulong(ifname, SYSFS_BRIDGE_ATTR "/ageing_time", &ul) == 0)
-		bridge->ageing_time = (double)ui / 100.0;
+		bridge->ageing_time = (double)ul / 100.0;
 	if (ni_sysfs_netif_get_uint(ifname, SYSFS_BRIDGE_ATTR "/hello_time", &ui) == 0)
 		bridge->hello_time = (double)ui / 100.0;
 	if (ni_sysfs_netif_get_uint(ifname, SYSFS_BRIDGE_ATTR "/max_age", &ui) == 0)
@@ -437,30 +750,30 @@ ni_sysfs_bridge_update_config(const char *ifname, const ni_bridge_t *bridge)
 {
 	int rv = 0;
 
-	if (ni_sysfs_netif_put_uint(ifname, SYSFS_BRIDGE_ATTR "/stp_state", bridge->stp) < 0)
+	if (__ni_sysfs_netif_put_setting(ifname, SYSFS_BRIDGE_ATTR "/stp_state", "%u", bridge->stp) < 0)
 		rv = -1;
 
 	if (bridge->priority != NI_BRIDGE_VALUE_NOT_SET &&
-	    ni_sysfs_netif_put_uint(ifname, SYSFS_BRIDGE_ATTR "/priority", bridge->priority) < 0)
+	    __ni_sysfs_netif_put_setting(ifname, SYSFS_BRIDGE_ATTR "/priority", "%u", bridge->priority) < 0)
 		rv = -1;
 
 	if (bridge->forward_delay != NI_BRIDGE_VALUE_NOT_SET &&
-	    ni_sysfs_netif_put_uint(ifname, SYSFS_BRIDGE_ATTR "/forward_delay",
+	    __ni_sysfs_netif_put_setting(ifname, SYSFS_BRIDGE_ATTR "/forward_delay", "%u",
 				(unsigned int)(bridge->forward_delay * 100.0)) < 0)
 		rv = -1;
 
 	if (bridge->ageing_time != NI_BRIDGE_VALUE_NOT_SET &&
-	    ni_sysfs_netif_put_ulong(ifname, SYSFS_BRIDGE_ATTR "/ageing_time",
+	    __ni_sysfs_netif_put_setting(ifname, SYSFS_BRIDGE_ATTR "/ageing_time", "%lu",
 				(unsigned long)(bridge->ageing_time * 100.0)) < 0)
 		rv = -1;
 
 	if (bridge->hello_time != NI_BRIDGE_VALUE_NOT_SET &&
-	    ni_sysfs_netif_put_uint(ifname, SYSFS_BRIDGE_ATTR "/hello_time",
+	    __ni_sysfs_netif_put_setting(ifname, SYSFS_BRIDGE_ATTR "/hello_time", "%u",
 				(unsigned int)(bridge->hello_time * 100.0)) < 0)
 		rv = -1;
 
 	if (bridge->max_age != NI_BRIDGE_VALUE_NOT_SET &&
-	    ni_sysfs_netif_put_uint(ifname, SYSFS_BRIDGE_ATTR "/max_age",
+	    __ni_sysfs_netif_put_setting(ifname, SYSFS_BRIDGE_ATTR "/max_age", "%u",
 				(unsigned int)(bridge->max_age * 100.0)) < 0)
 		rv = -1;
 
@@ -503,11 +816,11 @@ ni_sysfs_bridge_port_update_config(const char *ifname, const ni_bridge_port_t *p
 	int rv = 0;
 
 	if (port->priority != NI_BRIDGE_VALUE_NOT_SET
-	 && ni_sysfs_netif_put_uint(ifname, SYSFS_BRIDGE_PORT_ATTR "/priority", port->priority) < 0)
+	 && __ni_sysfs_netif_put_setting(ifname, SYSFS_BRIDGE_PORT_ATTR "/priority", "%u", port->priority) < 0)
 		rv = -1;
 
 	if (port->path_cost != NI_BRIDGE_VALUE_NOT_SET
-	 && ni_sysfs_netif_put_uint(ifname, SYSFS_BRIDGE_PORT_ATTR "/path_cost", port->path_cost) < 0)
+	 && __ni_sysfs_netif_put_setting(ifname, SYSFS_BRIDGE_PORT_ATTR "/path_cost", "%u", port->path_cost) < 0)
 		rv = -1;
 
 	return rv;
@@ -561,10 +874,10 @@ ni_sysctl_ipv4_ifconfig_is_present(const char *ifname)
 int
 ni_sysctl_ipv4_ifconfig_get(const char *ifname, const char *ctl_name, char **result)
 {
-	const char *pathname = __ni_sysctl_ipv4_ifconfig_path(ifname, ctl_name);
-
-	if (!result || __ni_sysfs_read_string(pathname, result) < 0 || !*result) {
-		ni_error("%s: unable to read file: %m", pathname);
+	if (!result || __ni_sysfs_ifdir_read_string(NI_SYSFS_IFDIR_IPV4_CONF,
+					ifname, ctl_name, result) < 0 || !*result) {
+		ni_error("%s: unable to read file: %m",
+				__ni_sysctl_ipv4_ifconfig_path(ifname, ctl_name));
 		return -1;
 	}
 	return 0;
@@ -603,19 +916,26 @@ ni_sysctl_ipv4_ifconfig_get_uint(const char *ifname, const char *ctl_name, unsig
 int
 ni_sysctl_ipv4_ifconfig_set(const char *ifname, const char *ctl_name, const char *newval)
 {
-	return __ni_sysfs_printf(__ni_sysctl_ipv4_ifconfig_path(ifname, ctl_name), "%s", newval ? newval : "");
+	return __ni_sysfs_ifdir_write(NI_SYSFS_IFDIR_IPV4_CONF, ifname, ctl_name,
+					newval ? newval : "", FALSE, FALSE);
 }
 
 int
 ni_sysctl_ipv4_ifconfig_set_int(const char *ifname, const char *ctl_name, int newval)
 {
-	return __ni_sysfs_printf(__ni_sysctl_ipv4_ifconfig_path(ifname, ctl_name), "%d", newval);
+	char buf[32];
+
+	snprintf(buf, sizeof(buf), "%d", newval);
+	return ni_sysctl_ipv4_ifconfig_set(ifname, ctl_name, buf);
 }
 
 int
 ni_sysctl_ipv4_ifconfig_set_uint(const char *ifname, const char *ctl_name, unsigned int newval)
 {
-	return __ni_sysfs_printf(__ni_sysctl_ipv4_ifconfig_path(ifname, ctl_name), "%u", newval);
+	char buf[32];
+
+	snprintf(buf, sizeof(buf), "%u", newval);
+	return ni_sysctl_ipv4_ifconfig_set(ifname, ctl_name, buf);
 }
 
 /*
@@ -644,10 +964,10 @@ ni_sysctl_ipv6_ifconfig_is_present(const char *ifname)
 int
 ni_sysctl_ipv6_ifconfig_get(const char *ifname, const char *ctl_name, char **result)
 {
-	const char *pathname = __ni_sysctl_ipv6_ifconfig_path(ifname, ctl_name);
-
-	if (!result || __ni_sysfs_read_string(pathname, result) < 0 || !*result) {
-		ni_error("%s: unable to read file: %m", pathname);
+	if (!result || __ni_sysfs_ifdir_read_string(NI_SYSFS_IFDIR_IPV6_CONF,
+					ifname, ctl_name, result) < 0 || !*result) {
+		ni_error("%s: unable to read file: %m",
+				__ni_sysctl_ipv6_ifconfig_path(ifname, ctl_name));
 		return -1;
 	}
 	return 0;
@@ -704,19 +1024,26 @@ ni_sysctl_ipv6_ifconfig_get_ipv6(const char *ifname, const char *ctl_name, struc
 int
 ni_sysctl_ipv6_ifconfig_set(const char *ifname, const char *ctl_name, const char *newval)
 {
-	return __ni_sysfs_printf(__ni_sysctl_ipv6_ifconfig_path(ifname, ctl_name), "%s", newval ? newval : "");
+	return __ni_sysfs_ifdir_write(NI_SYSFS_IFDIR_IPV6_CONF, ifname, ctl_name,
+					newval ? newval : "", FALSE, FALSE);
 }
 
 int
 ni_sysctl_ipv6_ifconfig_set_int(const char *ifname, const char *ctl_name, int newval)
 {
-	return __ni_sysfs_printf(__ni_sysctl_ipv6_ifconfig_path(ifname, ctl_name), "%d", newval);
+	char buf[32];
+
+	snprintf(buf, sizeof(buf), "%d", newval);
+	return ni_sysctl_ipv6_ifconfig_set(ifname, ctl_name, buf);
 }
 
 int
 ni_sysctl_ipv6_ifconfig_set_uint(const char *ifname, const char *ctl_name, unsigned int newval)
 {
-	return __ni_sysfs_printf(__ni_sysctl_ipv6_ifconfig_path(ifname, ctl_name), "%u", newval);
+	char buf[32];
+
+	snprintf(buf, sizeof(buf), "%u", newval);
+	return ni_sysctl_ipv6_ifconfig_set(ifname, ctl_name, buf);
 }
 
 int
@@ -1064,16 +1391,240 @@ ni_pci_dev_free(ni_pci_dev_t *pci_dev)
 	free(pci_dev);
 }
 
+/*
+ * Network device topology cache
+ *
+ * The bus information of a network device does not change for the
+ * lifetime of its ifindex, so we read the sysfs device link and pci
+ * ids once and cache them with the ifindex and sysfs device path as
+ * key. Entries are dropped on device removal (uevent remove/move or
+ * rtnetlink dellink) and the cache is stored into the state directory
+ * with the kernel boot id, so a daemon restart can reuse it.
+ */
+#define NI_SYSFS_TOPOLOGY_FILE		"sysfs-topology.xml"
+#define NI_SYSFS_TOPOLOGY_NODE		"sysfs-topology"
+#define NI_SYSFS_BOOT_ID_PATH		"/proc/sys/kernel/random/boot_id"
+
+typedef struct ni_sysfs_topology {
+	unsigned int		ifindex;
+	char *			devpath;	/* path relative to /sys/devices */
+	ni_bool_t		pci;
+	uint16_t		vendor;
+	uint16_t		device;
+	ni_bool_t		seen;
+} ni_sysfs_topology_t;
+
+static struct {
+	ni_bool_t		loaded;
+	ni_bool_t		dirty;
+	unsigned int		count;
+	ni_sysfs_topology_t *	data;
+} ni_sysfs_topology;
+
+static const char *
+__ni_sysfs_topology_file(void)
+{
+	static char path[PATH_MAX];
+
+	snprintf(path, sizeof(path), "%s/%s", ni_config_statedir(), NI_SYSFS_TOPOLOGY_FILE);
+	return path;
+}
+
+static ni_sysfs_topology_t *
+__ni_sysfs_topology_find(unsigned int ifindex)
+{
+	unsigned int i;
+
+	for (i = 0; i < ni_sysfs_topology.count; ++i) {
+		if (ni_sysfs_topology.data[i].ifindex == ifindex)
+			return &ni_sysfs_topology.data[i];
+	}
+	return NULL;
+}
+
+static ni_sysfs_topology_t *
+__ni_sysfs_topology_add(unsigned int ifindex, const char *devpath)
+{
+	ni_sysfs_topology_t *entry;
+
+	if ((entry = __ni_sysfs_topology_find(ifindex))) {
+		ni_string_dup(&entry->devpath, devpath);
+	} else {
+		entry = realloc(ni_sysfs_topology.data,
+				(ni_sysfs_topology.count + 1) * sizeof(*entry));
+		if (!entry)
+			return NULL;
+		ni_sysfs_topology.data = entry;
+		entry += ni_sysfs_topology.count++;
+
+		memset(entry, 0, sizeof(*entry));
+		entry->ifindex = ifindex;
+		ni_string_dup(&entry->devpath, devpath);
+	}
+	entry->pci = FALSE;
+	entry->vendor = entry->device = 0;
+	return entry;
+}
+
+static void
+__ni_sysfs_topology_load(void)
+{
+	char *boot_id = NULL;
+	xml_document_t *doc;
+	xml_node_t *root, *node;
+	const char *file;
+
+	ni_sysfs_topology.loaded = TRUE;
+
+	file = __ni_sysfs_topology_file();
+	if (!ni_file_exists(file))
+		return;
+
+	if (!(doc = xml_document_read(file)))
+		return;
+
+	root = xml_node_get_child(xml_document_root(doc), NI_SYSFS_TOPOLOGY_NODE);
+	if (!root || __ni_sysfs_read_string(NI_SYSFS_BOOT_ID_PATH, &boot_id) < 0 ||
+	    !ni_string_eq(boot_id, xml_node_get_attr(root, "boot-id"))) {
+		ni_debug_readwrite("ignoring stale device topology cache %s", file);
+		goto done;
+	}
+
+	for (node = root->children; node; node = node->next) {
+		ni_sysfs_topology_t *entry;
+		unsigned int ifindex, vendor, device;
+		const char *devpath;
+
+		if (!ni_string_eq(node->name, "device"))
+			continue;
+		if (!xml_node_get_attr_uint(node, "ifindex", &ifindex) || !ifindex)
+			continue;
+		if (ni_string_empty(devpath = xml_node_get_attr(node, "path")))
+			continue;
+		if (!(entry = __ni_sysfs_topology_add(ifindex, devpath)))
+			break;
+
+		if (xml_node_get_attr_uint(node, "vendor", &vendor) &&
+		    xml_node_get_attr_uint(node, "device", &device)) {
+			entry->pci = TRUE;
+			entry->vendor = vendor;
+			entry->device = device;
+		}
+	}
+	ni_debug_readwrite("loaded %u entries from device topology cache %s",
+			ni_sysfs_topology.count, file);
+
+done:
+	ni_string_free(&boot_id);
+	xml_document_free(doc);
+}
+
+/*
+ * Store the devices looked up by this process, the cache
+ * doesn't grow with entries of devices which are gone.
+ */
+void
+ni_sysfs_topology_save(void)
+{
+	char temp[PATH_MAX + sizeof(".XXXXXX")];
+	char *boot_id = NULL;
+	xml_node_t *root, *node;
+	const char *file;
+	unsigned int i;
+	FILE *fp;
+	int fd;
+
+	if (!ni_sysfs_topology.dirty)
+		return;
+	ni_sysfs_topology.dirty = FALSE;
+
+	if (__ni_sysfs_read_string(NI_SYSFS_BOOT_ID_PATH, &boot_id) < 0 || !boot_id)
+		return;
+
+	root = xml_node_new(NI_SYSFS_TOPOLOGY_NODE, NULL);
+	xml_node_add_attr(root, "boot-id", boot_id);
+	ni_string_free(&boot_id);
+
+	for (i = 0; i < ni_sysfs_topology.count; ++i) {
+		const ni_sysfs_topology_t *entry = &ni_sysfs_topology.data[i];
+
+		if (!entry->seen)
+			continue;
+
+		node = xml_node_new("device", root);
+		xml_node_add_attr_uint(node, "ifindex", entry->ifindex);
+		xml_node_add_attr(node, "path", entry->devpath);
+		if (entry->pci) {
+			xml_node_add_attr_uint(node, "vendor", entry->vendor);
+			xml_node_add_attr_uint(node, "device", entry->device);
+		}
+	}
+
+	file = __ni_sysfs_topology_file();
+	snprintf(temp, sizeof(temp), "%s.XXXXXX", file);
+	if ((fd = mkstemp(temp)) < 0) {
+		ni_debug_readwrite("cannot create device topology cache %s: %m", file);
+		xml_node_free(root);
+		return;
+	}
+	if (!(fp = fdopen(fd, "we"))) {
+		close(fd);
+		unlink(temp);
+		xml_node_free(root);
+		return;
+	}
+
+	if (xml_node_print(root, fp) < 0 || fflush(fp) != 0 || rename(temp, file) < 0) {
+		ni_debug_readwrite("cannot write device topology cache %s: %m", file);
+		unlink(temp);
+	}
+	fclose(fp);
+	xml_node_free(root);
+}
+
+void
+ni_sysfs_topology_drop(unsigned int ifindex)
+{
+	ni_sysfs_topology_t *entry;
+	unsigned int pos;
+
+	if (!(entry = __ni_sysfs_topology_find(ifindex)))
+		return;
+
+	ni_string_free(&entry->devpath);
+	pos = entry - ni_sysfs_topology.data;
+	ni_sysfs_topology.count--;
+	memmove(entry, entry + 1, (ni_sysfs_topology.count - pos) * sizeof(*entry));
+	ni_sysfs_topology.dirty = TRUE;
+}
+
+static ni_bool_t
+__ni_sysfs_netdev_read_pci_ids(const char *ifname, uint16_t *vendor, uint16_t *device)
+{
+	const char *attr;
+
+	if ((attr = __ni_sysfs_netif_get_attr(ifname, "device/vendor")) == NULL)
+		return FALSE;
+	*vendor = strtoul(attr, NULL, 0);
+
+	if ((attr = __ni_sysfs_netif_get_attr(ifname, "device/device")) == NULL)
+		return FALSE;
+	*device = strtoul(attr, NULL, 0);
+	return TRUE;
+}
+
 ni_pci_dev_t *
-ni_sysfs_netdev_get_pci(const char *ifname)
+ni_sysfs_netdev_get_pci(const char *ifname, unsigned int ifindex)
 {
 	char pathbuf[PATH_MAX], device_link[PATH_MAX], *pci_path, *s;
-	ni_pci_dev_t *pci = NULL;
-	const char *attr;
+	ni_sysfs_topology_t *entry, temp;
+	ni_pci_dev_t *pci;
+	ssize_t len;
 
 	snprintf(pathbuf, sizeof(pathbuf), "%s/%s", _PATH_SYS_CLASS_NET, ifname);
-	if (readlink(pathbuf, device_link, sizeof(device_link)) < 0)
+	if ((len = readlink(pathbuf, device_link, sizeof(device_link) - 1)) < 0)
 		return NULL;
+	device_link[len] = '\0';
 
 	if (strncmp(device_link, "../../devices/", 14))
 		return NULL;
@@ -1081,20 +1632,27 @@ ni_sysfs_netdev_get_pci(const char *ifname)
 	if ((s = strstr(pci_path, "/net/")) == NULL)
 		return NULL;
 	*s = '\0';
-	pci = ni_pci_dev_new(pci_path);
 
-	if ((attr = __ni_sysfs_netif_get_attr(ifname, "device/vendor")) == NULL)
-		goto failed;
-	pci->vendor = strtoul(attr, NULL, 0);
+	if (!ni_sysfs_topology.loaded)
+		__ni_sysfs_topology_load();
 
-	if ((attr = __ni_sysfs_netif_get_attr(ifname, "device/device")) == NULL)
-		goto failed;
-	pci->device = strtoul(attr, NULL, 0);
+	entry = ifindex ? __ni_sysfs_topology_find(ifindex) : NULL;
+	if (!entry || !ni_string_eq(entry->devpath, pci_path)) {
+		if (!ifindex || !(entry = __ni_sysfs_topology_add(ifindex, pci_path))) {
+			memset(&temp, 0, sizeof(temp));
+			entry = &temp;
+		}
+		entry->pci = __ni_sysfs_netdev_read_pci_ids(ifname,
+					&entry->vendor, &entry->device);
+		ni_sysfs_topology.dirty = TRUE;
+	}
+	entry->seen = TRUE;
 
-	return pci;
+	if (!entry->pci)
+		return NULL;
 
-failed:
-	if (pci)
-		ni_pci_dev_free(pci);
-	return NULL;
+	pci = ni_pci_dev_new(pci_path);
+	pci->vendor = entry->vendor;
+	pci->device = entry->device;
+	return pci;
 }
@@ -45,7 +45,10 @@ extern int	ni_sysfs_bridge_get_port_names(const char *, ni_string_array_t *);
 extern void	ni_sysfs_bridge_port_get_config(const char *, ni_bridge_port_t *);
 extern int	ni_sysfs_bridge_port_update_config(const char *, const ni_bridge_port_t *);
 extern void	ni_sysfs_bridge_port_get_status(const char *, ni_bridge_port_status_t *);
-extern ni_pci_dev_t *ni_sysfs_netdev_get_pci(const char *ifname);
+extern ni_pci_dev_t *ni_sysfs_netdev_get_pci(const char *ifname, unsigned int ifindex);
+extern void	ni_sysfs_topology_drop(unsigned int ifindex);
+extern void	ni_sysfs_topology_save(void);
+extern void	ni_sysfs_ifdir_cache_drop(const char *ifname);
 
 extern int	ni_sysctl_ipv6_ifconfig_is_present(const char *ifname);
 extern int	ni_sysctl_ipv6_ifconfig_get(const char *, const char *, char **);
@@ -1,5 +1,5 @@
 /*
- *	Interfacing with systemd using systemctl
+ *	Interfacing with systemd using its D-Bus manager API
  *
  *	Copyright (C) 2016 SUSE Linux GmbH, Nuernberg, Germany.
  *
@@ -25,182 +25,393 @@
 #include "config.h"
 #endif
 
+#include <sys/time.h>
+
 #include <wicked/util.h>
 #include <wicked/logging.h>
+#include <wicked/netinfo.h>
+#include <wicked/socket.h>
+#include <wicked/dbus.h>
+
+#include "systemctl.h"
+#include "dbus-common.h"
+#include "util_priv.h"
+
+#define NI_SYSTEMD_BUS_NAME		"org.freedesktop.systemd1"
+#define NI_SYSTEMD_OBJECT_PATH		"/org/freedesktop/systemd1"
+#define NI_SYSTEMD_MANAGER_INTERFACE	NI_SYSTEMD_BUS_NAME ".Manager"
+#define NI_SYSTEMD_UNIT_INTERFACE	NI_SYSTEMD_BUS_NAME ".Unit"
+#define NI_SYSTEMD_SERVICE_INTERFACE	NI_SYSTEMD_BUS_NAME ".Service"
+
+#define NI_SYSTEMCTL_CALL_TIMEOUT	(25 * 1000)
+#define NI_SYSTEMCTL_JOB_TIMEOUT	(120 * 1000)
+
+typedef enum {
+	NI_SYSTEMCTL_JOB_CALLING,	/* Start/StopUnit call pending	*/
+	NI_SYSTEMCTL_JOB_QUEUED,	/* waiting for JobRemoved	*/
+	NI_SYSTEMCTL_JOB_DONE,
+	NI_SYSTEMCTL_JOB_FAILED,
+} ni_systemctl_job_state_t;
+
+typedef struct ni_systemctl_job {
+	const char *			unit;
+	char *				path;
+	ni_systemctl_job_state_t	state;
+	ni_dbus_object_t *		proxy;
+} ni_systemctl_job_t;
+
+typedef struct ni_systemctl {
+	ni_dbus_client_t *		dbus;
+	ni_dbus_object_t *		manager;
+
+	/* jobs of the running batch */
+	ni_systemctl_job_t *		jobs;
+	unsigned int			count;
+
+	/* jobs removed before we've seen the Start/StopUnit reply */
+	ni_var_array_t			removed;
+} ni_systemctl_t;
+
+static ni_systemctl_t *			ni_systemctl;
+
+static ni_dbus_class_t			ni_systemctl_manager_class = {
+	.name = "systemd-manager",
+};
+
+static void				ni_systemctl_signal(ni_dbus_connection_t *,
+						ni_dbus_message_t *, void *);
 
-#include "buffer.h"
-#include "process.h"
-
-
-static const char *
-ni_systemctl_tool_path(void)
+/*
+ * Manager connection, opened on first use
+ */
+static void
+ni_systemctl_close(void)
 {
-	static const char *paths[] = {
-		"/usr/bin/systemctl",
-		"/bin/systemctl",
-		NULL
-	};
-
-	return ni_find_executable(paths);
+	ni_systemctl_t *sc = ni_systemctl;
+
+	if (!sc)
+		return;
+
+	ni_systemctl = NULL;
+	/* cancels pending calls referring the job proxies */
+	if (sc->dbus)
+		ni_dbus_client_free(sc->dbus);
+	if (sc->manager)
+		ni_dbus_object_free(sc->manager);
+	ni_var_array_destroy(&sc->removed);
+	free(sc);
 }
 
-/*
- * systemd instance service methods
- */
-int
-ni_systemctl_service_start(const char *service)
+static ni_systemctl_t *
+ni_systemctl_open(void)
 {
-	const char *systemctl;
-	ni_shellcmd_t *cmd;
-	ni_process_t *pi;
+	ni_systemctl_t *sc;
 	int rv;
 
-	if (ni_string_empty(service))
-		return -1;
+	if (ni_systemctl)
+		return ni_systemctl;
 
-	if (!(systemctl = ni_systemctl_tool_path()))
-		return -1;
+	sc = xcalloc(1, sizeof(*sc));
+	if (!(sc->dbus = ni_dbus_client_open("system", NI_SYSTEMD_BUS_NAME))) {
+		free(sc);
+		return NULL;
+	}
+	ni_dbus_client_set_call_timeout(sc->dbus, NI_SYSTEMCTL_CALL_TIMEOUT);
+
+	sc->manager = ni_dbus_client_object_new(sc->dbus, &ni_systemctl_manager_class,
+				NI_SYSTEMD_OBJECT_PATH, NI_SYSTEMD_MANAGER_INTERFACE, sc);
+	ni_systemctl = sc;
+
+	ni_dbus_client_add_signal_handler(sc->dbus,
+				NI_SYSTEMD_BUS_NAME,		/* sender */
+				NI_SYSTEMD_OBJECT_PATH,		/* object path */
+				NI_SYSTEMD_MANAGER_INTERFACE,	/* object interface */
+				ni_systemctl_signal,
+				sc);
+
+	/* systemd emits the job signals to subscribed clients only */
+	rv = ni_dbus_object_call_simple(sc->manager, NULL, "Subscribe",
+				DBUS_TYPE_INVALID, NULL, DBUS_TYPE_INVALID, NULL);
+	if (rv < 0) {
+		ni_error("unable to subscribe to systemd manager signals: %s",
+				ni_strerror(rv));
+		ni_systemctl_close();
+		return NULL;
+	}
+	return sc;
+}
 
-	if (!(cmd = ni_shellcmd_new(NULL)))
-		return -1;
+static ni_systemctl_job_t *
+ni_systemctl_job_by_path(ni_systemctl_t *sc, const char *path)
+{
+	unsigned int i;
 
-	if (!ni_shellcmd_add_arg(cmd, systemctl))
-		goto failure;
+	for (i = 0; i < sc->count; ++i) {
+		if (ni_string_eq(sc->jobs[i].path, path))
+			return &sc->jobs[i];
+	}
+	return NULL;
+}
 
-	if (!ni_shellcmd_add_arg(cmd, "start"))
-		goto failure;
+static void
+ni_systemctl_job_finish(ni_systemctl_job_t *job, const char *result)
+{
+	if (ni_string_eq(result, "done")) {
+		ni_debug_application("systemd: %s job %s done", job->unit, job->path);
+		job->state = NI_SYSTEMCTL_JOB_DONE;
+	} else {
+		ni_error("systemd: %s job %s finished with result '%s'",
+				job->unit, job->path, result);
+		job->state = NI_SYSTEMCTL_JOB_FAILED;
+	}
+}
 
-	if (!ni_shellcmd_add_arg(cmd, service))
-		goto failure;
+static void
+ni_systemctl_signal(ni_dbus_connection_t *conn, ni_dbus_message_t *msg, void *user_data)
+{
+	ni_systemctl_t *sc = user_data;
+	const char *member = dbus_message_get_member(msg);
+	char *path = NULL, *unit = NULL, *result = NULL;
+	ni_systemctl_job_t *job;
+	uint32_t id;
+
+	if (!ni_string_eq(member, "JobRemoved") || sc != ni_systemctl)
+		return;
+
+	if (ni_dbus_message_get_args(msg,
+				DBUS_TYPE_UINT32, &id,
+				DBUS_TYPE_OBJECT_PATH, &path,
+				DBUS_TYPE_STRING, &unit,
+				DBUS_TYPE_STRING, &result,
+				0) < 0)
+		goto cleanup;
+
+	if ((job = ni_systemctl_job_by_path(sc, path)))
+		ni_systemctl_job_finish(job, result);
+	else if (sc->count)
+		ni_var_array_set(&sc->removed, path, result);
+
+cleanup:
+	ni_string_free(&path);
+	ni_string_free(&unit);
+	ni_string_free(&result);
+}
 
-	if (!(pi = ni_process_new(cmd)))
-		goto failure;
-	ni_shellcmd_release(cmd);
+static void
+ni_systemctl_job_queued(ni_dbus_object_t *proxy, ni_dbus_message_t *reply)
+{
+	ni_systemctl_job_t *job = ni_dbus_object_get_handle(proxy);
+	DBusError error = DBUS_ERROR_INIT;
+	ni_var_t *removed;
+
+	if (dbus_set_error_from_message(&error, reply)) {
+		ni_error("systemd: unable to queue %s job: %s", job->unit, error.message);
+		job->state = NI_SYSTEMCTL_JOB_FAILED;
+		dbus_error_free(&error);
+		return;
+	}
+
+	if (ni_dbus_message_get_args(reply, DBUS_TYPE_OBJECT_PATH, &job->path, 0) < 0 || !job->path) {
+		job->state = NI_SYSTEMCTL_JOB_FAILED;
+		return;
+	}
+
+	job->state = NI_SYSTEMCTL_JOB_QUEUED;
+	if (ni_systemctl && (removed = ni_var_array_get(&ni_systemctl->removed, job->path)))
+		ni_systemctl_job_finish(job, removed->value);
+}
 
-	rv = ni_process_run_and_wait(pi);
-	ni_process_free(pi);
+/*
+ * Issue the Start/StopUnit calls for all units and wait until
+ * systemd reports all the jobs as removed.
+ */
+static int
+ni_systemctl_services_run(const char *method, const ni_string_array_t *services)
+{
+	static const char *mode = "replace";
+	struct timeval deadline, now, delta;
+	ni_systemctl_job_t *jobs;
+	ni_systemctl_t *sc;
+	unsigned int i, pending;
+	int rv = 0;
+
+	if (!services || !services->count)
+		return 0;
+
+	for (i = 0; i < services->count; ++i) {
+		if (ni_string_empty(services->data[i]))
+			return -1;
+	}
+
+	if (!(sc = ni_systemctl_open()))
+		return -1;
 
+	sc->count = services->count;
+	sc->jobs = xcalloc(sc->count, sizeof(sc->jobs[0]));
+	for (i = 0; i < sc->count; ++i) {
+		ni_systemctl_job_t *job = &sc->jobs[i];
+
+		job->unit = services->data[i];
+		job->proxy = ni_dbus_client_object_new(sc->dbus, &ni_dbus_anonymous_class,
+					NI_SYSTEMD_OBJECT_PATH, NI_SYSTEMD_MANAGER_INTERFACE, job);
+
+		ni_debug_application("systemd: %s %s", method, job->unit);
+		if (ni_dbus_object_call_async(job->proxy, ni_systemctl_job_queued, method,
+					DBUS_TYPE_STRING, &job->unit,
+					DBUS_TYPE_STRING, &mode, 0) < 0)
+			job->state = NI_SYSTEMCTL_JOB_FAILED;
+	}
+
+	ni_timer_get_time(&deadline);
+	deadline.tv_sec += NI_SYSTEMCTL_JOB_TIMEOUT / 1000;
+	for (;;) {
+		for (i = pending = 0; i < sc->count; ++i) {
+			if (sc->jobs[i].state < NI_SYSTEMCTL_JOB_DONE)
+				pending++;
+		}
+		if (!pending)
+			break;
+
+		ni_timer_get_time(&now);
+		if (!timercmp(&now, &deadline, <)) {
+			ni_error("systemd: timeout waiting for %u %s jobs", pending, method);
+			rv = -1;
+			break;
+		}
+		timersub(&deadline, &now, &delta);
+		if (ni_dbus_client_wait(sc->dbus, delta.tv_sec * 1000 + delta.tv_usec / 1000) < 0) {
+			ni_error("systemd: lost connection to the system bus");
+			rv = -1;
+			break;
+		}
+	}
+
+	jobs = sc->jobs;
+	sc->jobs = NULL;
+	sc->count = 0;
+	ni_var_array_destroy(&sc->removed);
+
+	for (i = 0; i < services->count; ++i) {
+		if (jobs[i].state != NI_SYSTEMCTL_JOB_DONE)
+			rv = -1;
+	}
+
+	/* drop the connection with calls still pending referring our jobs */
+	if (rv < 0)
+		ni_systemctl_close();
+
+	for (i = 0; i < services->count; ++i) {
+		ni_dbus_object_free(jobs[i].proxy);
+		ni_string_free(&jobs[i].path);
+	}
+	free(jobs);
 	return rv;
+}
+
+/*
+ * systemd instance service methods
+ */
+int
+ni_systemctl_services_start(const ni_string_array_t *services)
+{
+	return ni_systemctl_services_run("StartUnit", services);
+}
 
-failure:
-	if (cmd)
-		ni_shellcmd_release(cmd);
-	return -1;
+int
+ni_systemctl_services_stop(const ni_string_array_t *services)
+{
+	return ni_systemctl_services_run("StopUnit", services);
 }
 
 int
-ni_systemctl_service_stop(const char *service)
+ni_systemctl_service_start(const char *service)
 {
-	const char *systemctl;
-	ni_shellcmd_t *cmd;
-	ni_process_t *pi;
+	ni_string_array_t services = NI_STRING_ARRAY_INIT;
 	int rv;
 
 	if (ni_string_empty(service))
 		return -1;
 
-	if (!(cmd = ni_shellcmd_new(NULL)))
-		return -1;
-
-	if (!(systemctl = ni_systemctl_tool_path()))
-		return -1;
-
-	if (!ni_shellcmd_add_arg(cmd, systemctl))
-		goto failure;
-
-	if (!ni_shellcmd_add_arg(cmd, "stop"))
-		goto failure;
-
-	if (!ni_shellcmd_add_arg(cmd, service))
-		goto failure;
+	ni_string_array_append(&services, service);
+	rv = ni_systemctl_services_start(&services);
+	ni_string_array_destroy(&services);
+	return rv;
+}
 
-	if (!(pi = ni_process_new(cmd)))
-		goto failure;
-	ni_shellcmd_release(cmd);
+int
+ni_systemctl_service_stop(const char *service)
+{
+	ni_string_array_t services = NI_STRING_ARRAY_INIT;
+	int rv;
 
-	rv = ni_process_run_and_wait(pi);
-	ni_process_free(pi);
+	if (ni_string_empty(service))
+		return -1;
 
+	ni_string_array_append(&services, service);
+	rv = ni_systemctl_services_stop(&services);
+	ni_string_array_destroy(&services);
 	return rv;
-
-failure:
-	if (cmd)
-		ni_shellcmd_release(cmd);
-	return -1;
 }
 
 const char *
 ni_systemctl_service_show_property(const char *service, const char *property, char **result)
 {
-	const char *systemctl;
-	char *complete = NULL;
-	char *ptr;
-	ni_shellcmd_t *cmd;
-	ni_process_t *pi;
-	ni_buffer_t buf;
+	static const char *interfaces[] = {
+		NI_SYSTEMD_UNIT_INTERFACE,
+		NI_SYSTEMD_SERVICE_INTERFACE,
+		NULL
+	};
+	ni_dbus_variant_t argv[2] = { NI_DBUS_VARIANT_INIT, NI_DBUS_VARIANT_INIT };
+	ni_dbus_variant_t value = NI_DBUS_VARIANT_INIT;
+	ni_dbus_object_t *unit = NULL;
+	const char **iface, *ret = NULL;
+	ni_systemctl_t *sc;
+	char *path = NULL;
 	int rv;
 
 	if (ni_string_empty(service) || ni_string_empty(property) || !result)
 		return NULL;
 
-	if (!ni_string_printf(&complete, "%s=", property))
-		return NULL;
-
-	if (!(systemctl = ni_systemctl_tool_path()))
+	if (!(sc = ni_systemctl_open()))
 		return NULL;
 
-	ni_buffer_init_dynamic(&buf, 1024);
-	if (!(cmd = ni_shellcmd_new(NULL)))
-		goto failure;
-
-	if (!ni_shellcmd_add_arg(cmd, systemctl))
-		goto failure;
-
-	if (!ni_shellcmd_add_arg(cmd, "--no-pager"))
-		goto failure;
-
-	if (!ni_shellcmd_add_arg(cmd, "-p"))
-		goto failure;
-
-	if (!ni_shellcmd_add_arg(cmd, property))
-		goto failure;
-
-	if (!ni_shellcmd_add_arg(cmd, "show"))
-		goto failure;
-
-	if (!ni_shellcmd_add_arg(cmd, service))
-		goto failure;
-
-	if (!(pi = ni_process_new(cmd)))
-		goto failure;
-
-	rv = ni_process_run_and_capture_output(pi, &buf);
-	ni_process_free(pi);
-	if (rv)
-		goto failure;
-
-	ni_buffer_putc(&buf, '\0');
-	ptr = (char *)ni_buffer_head(&buf);
-	ptr[strcspn(ptr, "\n\r")] = '\0';
-	if (!ni_string_startswith(ptr, complete))
-		goto failure;
-
-	if (!ni_buffer_pull_head(&buf, ni_string_len(complete)))
-		goto failure;
-
-	ptr = (char *)ni_buffer_head(&buf);
-	ni_string_set(result, ptr, ni_string_len(ptr));
-
-	ni_buffer_destroy(&buf);
-	ni_shellcmd_release(cmd);
-	ni_string_free(&complete);
-	return *result;
-
-failure:
-	if (complete)
-		free(complete);
-	if (cmd)
-		ni_shellcmd_release(cmd);
-	ni_buffer_destroy(&buf);
-	return NULL;
+	/* as systemctl show, load the unit when it is not loaded yet */
+	rv = ni_dbus_object_call_simple(sc->manager, NULL, "LoadUnit",
+				DBUS_TYPE_STRING, &service,
+				DBUS_TYPE_OBJECT_PATH, &path);
+	if (rv < 0 || !path) {
+		ni_debug_application("systemd: unable to load unit %s: %s",
+				service, ni_strerror(rv));
+		goto cleanup;
+	}
+
+	unit = ni_dbus_client_object_new(sc->dbus, &ni_dbus_anonymous_class,
+				path, NI_SYSTEMD_UNIT_INTERFACE, NULL);
+	ni_dbus_variant_set_string(&argv[1], property);
+	for (iface = interfaces; *iface && !ret; ++iface) {
+		DBusError error = DBUS_ERROR_INIT;
+
+		ni_dbus_variant_set_string(&argv[0], *iface);
+		if (ni_dbus_object_call_variant(unit, NI_DBUS_INTERFACE ".Properties", "Get",
+					2, argv, 1, &value, &error)) {
+			if (value.type == DBUS_TYPE_STRING || value.type == DBUS_TYPE_OBJECT_PATH)
+				ni_string_dup(result, value.string_value);
+			else
+				ni_string_dup(result, ni_dbus_variant_sprint(&value));
+			ret = *result;
+		}
+		dbus_error_free(&error);
+		ni_dbus_variant_destroy(&value);
+	}
+
+	if (!ret)
+		ni_debug_application("systemd: unit %s has no property %s", service, property);
+
+cleanup:
+	ni_dbus_variant_destroy(&argv[0]);
+	ni_dbus_variant_destroy(&argv[1]);
+	if (unit)
+		ni_dbus_object_free(unit);
+	ni_string_free(&path);
+	return ret;
 }
@@ -1,5 +1,5 @@
 /*
- *	Interfacing with systemd using systemctl
+ *	Interfacing with systemd using its D-Bus manager API
  *
  *	Copyright (C) 2016 SUSE Linux GmbH, Nuernberg, Germany.
  *
@@ -23,12 +23,17 @@
 #ifndef NI_SYSTEMCTL_H
 #define NI_SYSTEMCTL_H
 
+#include <wicked/util.h>
+
 /*
  * Systemd helpers
  */
 extern int		ni_systemctl_service_start(const char *);
 extern int		ni_systemctl_service_stop(const char *);
 
+extern int		ni_systemctl_services_start(const ni_string_array_t *);
+extern int		ni_systemctl_services_stop(const ni_string_array_t *);
+
 extern const char *	ni_systemctl_service_show_property(const char *, const char *, char **);
 
 #endif /* NI_SYSTEMCTL_H */
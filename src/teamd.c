@@ -68,6 +68,7 @@
 
 #define NI_TEAMD_CALL_PORT_ADD			"PortAdd"
 #define NI_TEAMD_CALL_PORT_CONFIG_UPDATE	"PortConfigUpdate"
+#define NI_TEAMD_CALL_PORT_CONFIG_DUMP		"PortConfigDump"
 
 
 typedef struct ni_teamd_client_ops {
@@ -78,6 +79,7 @@ typedef struct ni_teamd_client_ops {
 	int	(*ctl_state_set_item)(ni_teamd_client_t *, const char *, const char *);
 	int	(*ctl_port_add)(ni_teamd_client_t *, const char *);
 	int	(*ctl_port_config_update)(ni_teamd_client_t *, const char *, const char *);
+	int	(*ctl_port_config_dump)(ni_teamd_client_t *, const char *, char **);
 } ni_teamd_client_ops_t;
 
 struct ni_teamd_client {
@@ -92,6 +94,28 @@ struct ni_teamd_client {
 	ni_shellcmd_t *		cmd;
 };
 
+/*
+ * Discovered team model, kept per team device until teamd tells
+ * us it changed something or the device is recreated. Port master
+ * changes only refresh the affected ports.
+ */
+typedef struct ni_teamd_model	ni_teamd_model_t;
+struct ni_teamd_model {
+	ni_teamd_model_t *	next;
+
+	char *			instance;
+	unsigned int		ifindex;
+	ni_teamd_client_t *	tdc;
+
+	ni_bool_t		dirty;
+	ni_string_array_t	ports_added;
+	ni_string_array_t	ports_removed;
+};
+
+static ni_teamd_model_t *	ni_teamd_models;
+
+static void			ni_teamd_model_invalidate(const char *);
+
 static inline const char *
 ni_teamd_service_show_property(const char *ifname, const char *property, char **result)
 {
@@ -139,7 +163,7 @@ ni_teamd_dbus_client_init(ni_teamd_client_t *tdc, const char *busname)
 	if (!tdc->proxy)
 		return FALSE;
 	ni_dbus_client_add_signal_handler(tdc->dbus,
-				NI_TEAMD_BUS_NAME,	/* sender */
+				busname,		/* sender */
 				NULL,			/* object path */
 				NI_TEAMD_INTERFACE,	/* object interface */
 				ni_teamd_dbus_signal,
@@ -164,10 +188,12 @@ ni_teamd_dbus_client_destroy(ni_teamd_client_t *tdc)
 static void
 ni_teamd_dbus_signal(ni_dbus_connection_t *connection, ni_dbus_message_t *msg, void *user_data)
 {
-	/* ni_teamd_client_t *tdc = user_data; */
+	ni_teamd_client_t *tdc = user_data;
 	const char *member = dbus_message_get_member(msg);
 
-	ni_debug_dbus("teamd-client: %s signal received (not handled)", member);
+	ni_debug_dbus("teamd-client: %s signal received, %s model invalidated",
+			member, tdc->instance);
+	ni_teamd_model_invalidate(tdc->instance);
 }
 
 static int
@@ -321,6 +347,27 @@ ni_teamd_dbus_ctl_port_config_update(ni_teamd_client_t *tdc, const char *port_na
 	return rv;
 }
 
+static int
+ni_teamd_dbus_ctl_port_config_dump(ni_teamd_client_t *tdc, const char *port_name, char **result)
+{
+	int rv;
+
+	if (ni_string_empty(port_name) || !result)
+		return -NI_ERROR_INVALID_ARGS;
+
+	rv = ni_dbus_object_call_simple(tdc->proxy,
+		NI_TEAMD_INTERFACE, NI_TEAMD_CALL_PORT_CONFIG_DUMP,
+		DBUS_TYPE_STRING, &port_name,
+		DBUS_TYPE_STRING, result);
+
+	if (rv < 0) {
+		ni_debug_application("Call to %s."NI_TEAMD_CALL_PORT_CONFIG_DUMP"(%s) failed: %s",
+			ni_dbus_object_get_path(tdc->proxy), port_name, ni_strerror(rv));
+	}
+
+	return rv;
+}
+
 /*
  * === unix client ===
  */
@@ -461,6 +508,45 @@ ni_teamd_unix_ctl_port_config_update(ni_teamd_client_t *tdc, const char *port_na
 	return 0;
 }
 
+int
+ni_teamd_unix_ctl_port_config_dump(ni_teamd_client_t *tdc, const char *port_name, char **result)
+{
+	ni_buffer_t buf;
+	ni_process_t *pi;
+	int rv;
+
+	if (ni_string_empty(port_name) || !result)
+		return -1;
+
+	ni_buffer_init_dynamic(&buf, 256);
+	if (!(pi = ni_process_new(tdc->cmd)))
+		goto failure;
+
+	ni_string_array_append(&pi->argv, "port");
+	ni_string_array_append(&pi->argv, "config");
+	ni_string_array_append(&pi->argv, "dump");
+	ni_string_array_append(&pi->argv, port_name);
+
+	rv = ni_process_run_and_capture_output(pi, &buf);
+	ni_process_free(pi);
+	if (rv) {
+		ni_debug_application("%s: unable to dump team port %s config",
+				tdc->instance, port_name);
+		goto failure;
+	}
+
+	ni_buffer_put(&buf, "\0", 1);
+	ni_string_free(result);
+	*result = (char *)buf.base;
+	buf.base = NULL;
+	ni_buffer_destroy(&buf);
+	return 0;
+
+failure:
+	ni_buffer_destroy(&buf);
+	return -1;
+}
+
 /*
  *  === teamd client ===
  */
@@ -472,6 +558,7 @@ static const ni_teamd_client_ops_t	teamd_dbus_ops = {
 	.ctl_state_set_item	= ni_teamd_dbus_ctl_state_set_item,
 	.ctl_port_add		= ni_teamd_dbus_ctl_port_add,
 	.ctl_port_config_update	= ni_teamd_dbus_ctl_port_config_update,
+	.ctl_port_config_dump	= ni_teamd_dbus_ctl_port_config_dump,
 };
 
 static const ni_teamd_client_ops_t	teamd_unix_ops = {
@@ -479,6 +566,7 @@ static const ni_teamd_client_ops_t	teamd_unix_ops = {
 	.ctl_config_dump	= ni_teamd_unix_ctl_config_dump,
 	.ctl_port_add		= ni_teamd_unix_ctl_port_add,
 	.ctl_port_config_update	= ni_teamd_unix_ctl_port_config_update,
+	.ctl_port_config_dump	= ni_teamd_unix_ctl_port_config_dump,
 };
 
 ni_bool_t
@@ -650,6 +738,109 @@ ni_teamd_ctl_port_config_update(ni_teamd_client_t *tdc, const char *port_name, c
 	return tdc->ops.ctl_port_config_update(tdc, port_name, port_conf);
 }
 
+int
+ni_teamd_ctl_port_config_dump(ni_teamd_client_t *tdc, const char *port_name, char **result)
+{
+	if (!tdc || !tdc->ops.ctl_port_config_dump)
+		return -1;
+	return tdc->ops.ctl_port_config_dump(tdc, port_name, result);
+}
+
+/*
+ * teamd discovery model cache
+ */
+static ni_teamd_model_t *
+ni_teamd_model_find(const char *instance)
+{
+	ni_teamd_model_t *model;
+
+	for (model = ni_teamd_models; model; model = model->next) {
+		if (ni_string_eq(model->instance, instance))
+			return model;
+	}
+	return NULL;
+}
+
+static void
+ni_teamd_model_reset(ni_teamd_model_t *model)
+{
+	ni_teamd_client_free(model->tdc);
+	model->tdc = NULL;
+	model->dirty = TRUE;
+	ni_string_array_destroy(&model->ports_added);
+	ni_string_array_destroy(&model->ports_removed);
+}
+
+static ni_teamd_model_t *
+ni_teamd_model_get(const char *instance, unsigned int ifindex)
+{
+	ni_teamd_model_t *model;
+
+	if (!(model = ni_teamd_model_find(instance))) {
+		model = xcalloc(1, sizeof(*model));
+		ni_string_dup(&model->instance, instance);
+		model->dirty = TRUE;
+		model->next = ni_teamd_models;
+		ni_teamd_models = model;
+	}
+
+	/* teamd recreates the device when restarted */
+	if (ifindex && model->ifindex != ifindex) {
+		ni_teamd_model_reset(model);
+		model->ifindex = ifindex;
+	}
+
+	if (!model->tdc && !(model->tdc = ni_teamd_client_open(instance)))
+		return NULL;
+
+	return model;
+}
+
+static void
+ni_teamd_model_drop(const char *instance)
+{
+	ni_teamd_model_t **pos, *model;
+
+	for (pos = &ni_teamd_models; (model = *pos); pos = &model->next) {
+		if (ni_string_eq(model->instance, instance)) {
+			*pos = model->next;
+			ni_teamd_model_reset(model);
+			ni_string_free(&model->instance);
+			free(model);
+			return;
+		}
+	}
+}
+
+static void
+ni_teamd_model_invalidate(const char *instance)
+{
+	ni_teamd_model_t *model;
+
+	if ((model = ni_teamd_model_find(instance)))
+		model->dirty = TRUE;
+}
+
+/*
+ * Note a port enslave/release, so the next discovery refreshes
+ * just this port instead of dumping the complete team config.
+ */
+void
+ni_teamd_port_changed(const char *instance, const char *port_name, ni_bool_t enslaved)
+{
+	ni_teamd_model_t *model;
+
+	if (ni_string_empty(port_name) || !(model = ni_teamd_model_find(instance)))
+		return;
+
+	ni_string_array_remove_match(&model->ports_added, port_name, 0);
+	ni_string_array_remove_match(&model->ports_removed, port_name, 0);
+	if (enslaved)
+		ni_string_array_append(&model->ports_added, port_name);
+	else
+		ni_string_array_append(&model->ports_removed, port_name);
+}
+
 static ni_json_t *
 ni_teamd_port_config_json(const ni_team_port_config_t *config)
 {
@@ -675,17 +866,23 @@ int
 ni_teamd_port_enslave(const ni_netdev_t *master, const ni_netdev_t *port, const ni_team_port_config_t *config)
 {
 	ni_stringbuf_t dump = NI_STRINGBUF_INIT_DYNAMIC;
+	ni_teamd_model_t *model;
 	ni_teamd_client_t *tdc;
-	int ret = -1;
 
 	if (!master || !master->name || !port || !port->name)
 		return -1;
 
-	if (!(tdc = ni_teamd_client_open(master->name)))
+	if (!ni_teamd_enabled(master->name))
 		return -1;
 
-	if (ni_teamd_ctl_port_add(tdc, port->name) < 0)
-		goto failure;
+	if (!(model = ni_teamd_model_get(master->name, master->link.ifindex)))
+		return -1;
+	tdc = model->tdc;
+
+	if (ni_teamd_ctl_port_add(tdc, port->name) < 0) {
+		model->dirty = TRUE;
+		return -1;
+	}
 
 	if (config) {
 		ni_json_t *object = ni_teamd_port_config_json(config);
@@ -699,11 +896,8 @@ ni_teamd_port_enslave(const ni_netdev_t *master, const ni_netdev_t *port, const
 		ni_stringbuf_destroy(&dump);
 	}
 
-	ret = 0;
-
-failure:
-        ni_teamd_client_free(tdc);
-	return ret;
+	ni_teamd_port_changed(master->name, port->name, TRUE);
+	return 0;
 }
 
 
@@ -1017,10 +1211,66 @@ ni_teamd_discover_ports(ni_team_t *team, ni_json_t *conf)
 	return 0;
 }
 
+/*
+ * Apply the noted port changes to the team discovered before,
+ * reading the config of the enslaved ports only.
+ */
+static int
+ni_teamd_discover_port_changes(ni_teamd_model_t *model, ni_team_t *team)
+{
+	ni_team_port_t *port;
+	unsigned int i, j;
+	const char *name;
+	ni_json_t *conf;
+	char *val = NULL;
+
+	for (i = 0; i < model->ports_removed.count; ++i) {
+		name = model->ports_removed.data[i];
+		for (j = 0; j < team->ports.count; ++j) {
+			port = team->ports.data[j];
+			if (ni_string_eq(port->device.name, name)) {
+				ni_team_port_array_delete_at(&team->ports, j);
+				break;
+			}
+		}
+	}
+	ni_string_array_destroy(&model->ports_removed);
+
+	while (model->ports_added.count) {
+		name = model->ports_added.data[0];
+
+		if (ni_teamd_ctl_port_config_dump(model->tdc, name, &val) < 0)
+			return -1;
+
+		if (!(conf = ni_json_parse_string(val))) {
+			ni_string_free(&val);
+			return -1;
+		}
+		ni_string_free(&val);
+
+		if (!(port = ni_team_port_array_find_by_name(&team->ports, name))) {
+			port = ni_team_port_new();
+			ni_netdev_ref_set_ifname(&port->device, name);
+			if (!ni_team_port_array_append(&team->ports, port)) {
+				ni_team_port_free(port);
+				ni_json_free(conf);
+				return -1;
+			}
+		}
+		ni_team_port_config_destroy(&port->config);
+		ni_team_port_config_init(&port->config);
+		ni_teamd_discover_port_details(port, conf);
+		ni_json_free(conf);
+
+		ni_string_array_remove_index(&model->ports_added, 0);
+	}
+	return 0;
+}
+
 int
 ni_teamd_discover(ni_netdev_t *dev)
 {
-	ni_teamd_client_t *tdc = NULL;
+	ni_teamd_model_t *model;
 	ni_json_t *conf = NULL;
 	ni_team_t *team = NULL;
 	char *val = NULL;
@@ -1028,15 +1278,29 @@ ni_teamd_discover(ni_netdev_t *dev)
 	if (!dev || dev->link.type != NI_IFTYPE_TEAM)
 		return -1;
 
+	if (!ni_teamd_enabled(dev->name))
+		return -1;
+
+	if (!(model = ni_teamd_model_get(dev->name, dev->link.ifindex)))
+		return -1;
+
+	/* nothing changed since the last discovery */
+	if (!model->dirty && dev->team) {
+		if (ni_teamd_discover_port_changes(model, dev->team) == 0)
+			return 0;
+	}
+
+	/* a teamd signal received while dumping marks it dirty again */
+	model->dirty = FALSE;
+	ni_string_array_destroy(&model->ports_added);
+	ni_string_array_destroy(&model->ports_removed);
+
 	/* we are about to replace dev->team, so just
 	 * allocate new one we can drop at any time */
 	if (!(team = ni_team_new()))
 		goto failure;
 
-	if (!(tdc = ni_teamd_client_open(dev->name)))
-		goto failure;
-
-	if (ni_teamd_ctl_config_dump(tdc, TRUE, &val) < 0)
+	if (ni_teamd_ctl_config_dump(model->tdc, TRUE, &val) < 0)
 		goto failure;
 
 	if (!(conf = ni_json_parse_string(val)))
@@ -1052,15 +1316,15 @@ ni_teamd_discover(ni_netdev_t *dev)
 		goto failure;
 
 	ni_netdev_set_team(dev, team);
-	ni_teamd_client_free(tdc);
 	ni_json_free(conf);
 	ni_string_free(&val);
 	return 0;
 
 failure:
+	/* reconnect next time, teamd may be gone or restarted */
+	ni_teamd_model_drop(dev->name);
 	ni_json_free(conf);
 	ni_team_free(team);
-	ni_teamd_client_free(tdc);
 	ni_string_free(&val);
 	return -1;
 }
@@ -1486,6 +1750,8 @@ ni_teamd_service_stop(const char *ifname)
 	int rv;
 	char *service = NULL;
 
+	ni_teamd_model_drop(ifname);
+
 	ni_string_printf(&service, NI_TEAMD_SERVICE_FMT, ifname);
 	rv = ni_systemctl_service_stop(service);
 	ni_teamd_config_file_remove(ifname);
@@ -40,10 +40,12 @@ extern int				ni_teamd_ctl_state_set_item(ni_teamd_client_t *, const char *,
 											 const char *);
 extern int				ni_teamd_ctl_port_add(ni_teamd_client_t *, const char *);
 extern int				ni_teamd_ctl_port_config_update(ni_teamd_client_t *, const char *, const char *);
+extern int				ni_teamd_ctl_port_config_dump(ni_teamd_client_t *, const char *, char **);
 
 extern int				ni_teamd_port_enslave(const ni_netdev_t *, const ni_netdev_t *, const ni_team_port_config_t *);
 
 extern int				ni_teamd_discover(ni_netdev_t *);
+extern void				ni_teamd_port_changed(const char *, const char *, ni_bool_t);
 
 extern int				ni_teamd_service_start(const ni_netdev_t *);
 extern int				ni_teamd_service_stop (const char *);
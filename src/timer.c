@@ -10,6 +10,7 @@
 #include <time.h>
 #include <sys/time.h>
 #include <wicked/socket.h>
+#include <wicked/metrics.h>
 #include "netinfo_priv.h"
 #include "util_priv.h"
 
@@ -78,7 +79,7 @@ ni_timer_rearm(const ni_timer_t *handle, unsigned long timeout)
 long
 ni_timer_next_timeout(void)
 {
-	struct timeval now, delta;
+	struct timeval now, delta, start;
 	ni_timer_t *timer;
 	long timeout;
 
@@ -99,7 +100,9 @@ ni_timer_next_timeout(void)
 				(long) now.tv_sec, (long) now.tv_usec,
 				(long) timer->expires.tv_sec, (long) timer->expires.tv_usec);
 		ni_timer_list = timer->next;
+		ni_metrics_begin(&start);
 		timer->callback(timer->user_data, timer);
+		ni_metrics_end(NI_METRIC_TIMER_CALLBACK, &start);
 		free(timer);
 	}
 
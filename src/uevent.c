@@ -58,6 +58,7 @@
 #include "netinfo_priv.h"
 #include "socket_priv.h"
 #include "uevent.h"
+#include "sysfs.h"
 #include "appconfig.h"
 
 
@@ -592,10 +593,12 @@ __ni_uevent_ifevent_forwarder(const ni_var_array_t *vars, void *user_data)
 		UDEV_ACTION_SKIP = 0,
 		UDEV_ACTION_ADD  = 1,
 		UDEV_ACTION_MOVE = 2,
+		UDEV_ACTION_REMOVE = 3,
 	};
 	static ni_intmap_t      __action_map[] = {
 		{ "add",	UDEV_ACTION_ADD  },
 		{ "move",	UDEV_ACTION_MOVE },
+		{ "remove",	UDEV_ACTION_REMOVE },
 		{ NULL,		UDEV_ACTION_SKIP }
 	};
 	struct {
@@ -657,6 +660,12 @@ __ni_uevent_ifevent_forwarder(const ni_var_array_t *vars, void *user_data)
 			uinfo.ifindex,
 			uinfo.interface, uinfo.interface_old, uinfo.tags);
 
+	/* bus topology of the ifindex is obsolete now */
+	if (uinfo.action == UDEV_ACTION_MOVE || uinfo.action == UDEV_ACTION_REMOVE)
+		ni_sysfs_topology_drop(uinfo.ifindex);
+	if (uinfo.action == UDEV_ACTION_REMOVE)
+		return;
+
 	if (dev && !(dev->link.ifflags & NI_IFF_DEVICE_READY)) {
 		unsigned int old_flags = dev->link.ifflags;
 		char namebuf[IF_NAMESIZE+1] = {'\0'};
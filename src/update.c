@@ -8,6 +8,7 @@
 #endif
 
 #include <unistd.h>
+#include <sys/time.h>
 
 #include <wicked/netinfo.h>
 #include <wicked/logging.h>
@@ -80,6 +81,7 @@ struct ni_updater_job {
 
 	ni_netdev_ref_t			device;
 	const ni_addrconf_lease_t *	lease;
+	struct timeval			queued;
 
 	ni_updater_job_state_t		state;
 
@@ -89,7 +91,10 @@ struct ni_updater_job {
 
 	const ni_updater_action_t *	actions;
 	ni_process_t *			process;
+	ni_resolve_reverse_t *		lookup;
+	unsigned int			lookups;
 	int				result;
+	const ni_updater_job_t *	merged;
 
 	char *				hostname;
 };
@@ -101,6 +106,10 @@ struct ni_updater {
 	int				format;
 	ni_bool_t			enabled;
 	unsigned int			have_backup;
+	unsigned int			settle;
+
+	unsigned long			calls;
+	unsigned long			merged;
 
 	ni_shellcmd_t *			proc_backup;
 	ni_shellcmd_t *			proc_restore;
@@ -126,6 +135,7 @@ static const ni_intmap_t		ni_updater_kind_names[] = {
 };
 
 static ni_bool_t			ni_system_updater_generic_batch_test(ni_updater_t *);
+static void				ni_updater_job_release_merged(const ni_updater_job_t *);
 
 /*
  * Get the name of an updater
@@ -362,8 +372,8 @@ ni_updater_job_info(ni_stringbuf_t *out, const ni_updater_job_t *job)
 			ni_addrconf_type_to_name(job->lease->type),
 			ni_addrconf_state_to_name(job->lease->state),
 			ni_process_running(job->process) ?
-				" subprocess " : "", job->process ?
-				ni_sprint_uint(job->process->pid) : "",
+				" subprocess " : job->lookup ? " lookup" : "",
+			job->process ? ni_sprint_uint(job->process->pid) : "",
 			kind ? " kind " : "", kind ? kind : "");
 	return out->string;
 }
@@ -385,6 +395,7 @@ ni_updater_job_new(ni_updater_job_t **list, const ni_addrconf_lease_t *lease,
 
 	job->nr = job_nr++; /* for debugging purposes only */
 	job->refcount = 1;
+	ni_timer_get_time(&job->queued);
 	if (!ni_netdev_ref_set(&job->device, ifname, ifindex)) {
 		free(job);
 		return NULL;
@@ -448,6 +459,10 @@ ni_updater_job_destroy(ni_updater_job_t *job)
 		ni_process_free(job->process);
 		job->process = NULL;
 	}
+	if (job->lookup) {
+		ni_resolve_reverse_cancel(job->lookup);
+		job->lookup = NULL;
+	}
 	ni_string_free(&job->hostname);
 }
 
@@ -471,7 +486,7 @@ ni_updater_job_cancel(ni_updater_job_t *job)
 {
 	ni_stringbuf_t out = NI_STRINGBUF_INIT_DYNAMIC;
 	if (job) {
-		if (job->state != NI_UPDATER_JOB_FINISHED || job->process)
+		if (job->state != NI_UPDATER_JOB_FINISHED || job->process || job->lookup)
 			ni_debug_verbose(NI_LOG_DEBUG1, NI_TRACE_EXTENSION,
 					"cancel %s", ni_updater_job_info(&out, job));
 		else
@@ -493,6 +508,12 @@ ni_updater_job_cancel(ni_updater_job_t *job)
 			ni_process_free(job->process);
 			job->process = NULL;
 		}
+		if (job->lookup) {
+			ni_resolve_reverse_cancel(job->lookup);
+			job->lookup = NULL;
+			ni_updater_job_free(job);
+		}
+		ni_updater_job_release_merged(job);
 	}
 }
 
@@ -518,6 +539,24 @@ ni_updater_job_call_updater(ni_updater_job_t *job)
 	return FALSE;
 }
 
+/*
+ * Wake up the jobs, which were merged into the (batch) call of the
+ * given job, so they can continue with their next updater or finish.
+ */
+static void
+ni_updater_job_release_merged(const ni_updater_job_t *job)
+{
+	ni_updater_job_t *j;
+
+	for (j = job_list; j; j = j->next) {
+		if (j == job || j->merged != job)
+			continue;
+
+		j->merged = NULL;
+		ni_updater_job_call_updater(j);
+	}
+}
+
 static inline ni_bool_t
 ni_updater_job_pending(ni_updater_job_t *job)
 {
@@ -593,6 +632,7 @@ ni_system_updaters_init(void)
 		updater->proc_restore = ni_extension_script_find(ex, "restore");
 		updater->proc_install = ni_extension_script_find(ex, "install");
 		updater->proc_remove = ni_extension_script_find(ex, "remove");
+		updater->settle = ex->settle;
 		if (kind == NI_ADDRCONF_UPDATER_GENERIC) {
 			if ((updater->proc_batch = ni_extension_script_find(ex, "batch"))) {
 				if (!ni_system_updater_generic_batch_test(updater))
@@ -697,6 +737,7 @@ ni_system_updater_notify(ni_process_t *pi)
 		break;
 	}
 	ni_updater_job_call_updater(job);
+	ni_updater_job_release_merged(job);
 	ni_updater_job_free(job);
 }
 
@@ -729,6 +770,8 @@ ni_system_updater_run(ni_updater_job_t *job, ni_shellcmd_t *shellcmd, ni_string_
 		job->process = pi;
 		pi->user_data = ni_updater_job_ref(job);
 		pi->notify_callback = ni_system_updater_notify;
+		if (job->kind < __NI_ADDRCONF_UPDATER_MAX)
+			updaters[job->kind].calls++;
 		ni_debug_verbose(NI_LOG_DEBUG1, NI_TRACE_EXTENSION,
 			"%s: started lease %s:%s in state %s %s updater (%s) with pid %d",
 				job->device.name,
@@ -1106,6 +1149,7 @@ ni_system_updater_generic_batch_call(ni_updater_t *updater, ni_updater_job_t *jo
 {
 	ni_process_t *pi = NULL;
 	char *filename = NULL;
+	unsigned int merged = 0;
 	ni_updater_job_t *j;
 	const char *ident;
 	FILE *out = NULL;
@@ -1146,6 +1190,8 @@ ni_system_updater_generic_batch_call(ni_updater_t *updater, ni_updater_job_t *jo
 			break;
 
 		ni_uint_array_remove_at(&j->updater, pos);
+		j->merged = job;
+		merged++;
 	}
 
 	if (fprintf(out, "update\n") <= 0)
@@ -1161,18 +1207,24 @@ ni_system_updater_generic_batch_call(ni_updater_t *updater, ni_updater_job_t *jo
 		job->process = pi;
 		pi->user_data = ni_updater_job_ref(job);
 		pi->notify_callback = ni_system_updater_notify;
+		updater->calls++;
+		updater->merged += merged;
 		ni_debug_verbose(NI_LOG_DEBUG1, NI_TRACE_EXTENSION,
-			"%s: started lease %s:%s in state %s %s updater (%s) with pid %d",
+			"%s: started lease %s:%s in state %s %s updater (%s) with pid %d"
+			" merging %u pending jobs (%lu calls, %lu jobs merged)",
 			job->device.name,
 			ni_addrfamily_type_to_name(job->lease->family),
 			ni_addrconf_type_to_name(job->lease->type),
 			ni_addrconf_state_to_name(job->lease->state),
 			ni_updater_name(job->kind),
-			ni_basename(pi->process->command), pi->pid);
+			ni_basename(pi->process->command), pi->pid,
+			merged, updater->calls, updater->merged);
 		pi = NULL;
 	}
 
 cleanup:
+	if (ret != NI_PROCESS_SUCCESS && merged)
+		ni_updater_job_release_merged(job);
 	if (out)
 		fclose(out);
 	if (pi)
@@ -1437,48 +1489,93 @@ ni_system_updater_hostname_cleanup_wait(ni_updater_t *updater, ni_updater_job_t
 	return 0;
 }
 
-static int
-do_reverse_resolve_ip_address(int argc, char *const argv[], char *const envp[])
+/*
+ * Return the nth lease address to try a reverse lookup for
+ */
+static const ni_address_t *
+ni_system_updater_hostname_lookup_address(const ni_addrconf_lease_t *lease, unsigned int nth)
 {
-	unsigned int count = 0;
-	char *name = NULL;
-	int n;
+	const ni_address_t *ap;
 
-	if (argc < 1 || !argv)
-		return EXIT_FAILURE;
+	for (ap = lease->addrs; ap; ap = ap->next) {
+		if (ni_address_is_tentative(ap) || ni_address_is_duplicate(ap))
+			continue;
 
-	if (!freopen("/dev/null", "w", stderr))
-		{}
+		if (!ni_sockaddr_is_specified(&ap->local_addr))
+			continue;
 
-	for (n = 1; n < argc && argv[n]; ++n) {
-		ni_sockaddr_t addr;
+		if (nth-- == 0)
+			return ap;
+	}
+	return NULL;
+}
 
-		if (ni_sockaddr_parse(&addr, argv[n], AF_UNSPEC) ||
-		    !ni_sockaddr_is_specified(&addr))
-			continue;
+static void	ni_system_updater_hostname_lookup_notify(ni_resolve_reverse_t *, const char *, void *);
 
-		if (!ni_resolve_reverse_timed(&addr, &name,
-					NI_UPDATER_REVERSE_TIMEOUT)) {
-			fprintf(stdout, "%s", name);
-			fflush(stdout);
-			ni_string_free(&name);
-			return EXIT_SUCCESS;
-		}
+static ni_bool_t
+ni_system_updater_hostname_lookup_next(ni_updater_job_t *job)
+{
+	const ni_address_t *ap;
 
-		if (++count >= NI_UPDATER_REVERSE_MAX_CNT)
-			break;
+	if (job->lookups >= NI_UPDATER_REVERSE_MAX_CNT)
+		return FALSE;
+
+	ap = ni_system_updater_hostname_lookup_address(job->lease, job->lookups++);
+	if (!ap)
+		return FALSE;
+
+	job->lookup = ni_resolve_reverse_start(&ap->local_addr,
+				NI_UPDATER_REVERSE_TIMEOUT * 1000,
+				ni_system_updater_hostname_lookup_notify, job);
+	if (!job->lookup)
+		return FALSE;
+
+	ni_debug_extension("%s: started lease %s:%s state %s %s updater reverse lookup of %s",
+			job->device.name,
+			ni_addrfamily_type_to_name(job->lease->family),
+			ni_addrconf_type_to_name(job->lease->type),
+			ni_addrconf_state_to_name(job->lease->state),
+			ni_updater_name(job->kind),
+			ni_sockaddr_print(&ap->local_addr));
+	return TRUE;
+}
+
+static void
+ni_system_updater_hostname_lookup_notify(ni_resolve_reverse_t *lookup, const char *hostname, void *user_data)
+{
+	ni_updater_job_t *job = user_data;
+
+	if (!job || job->lookup != lookup)
+		return;
+
+	job->lookup = NULL;
+	if (hostname) {
+		ni_string_dup(&job->hostname, hostname);
+		job->result = 0;
+	} else {
+		/* try the next address, keeping our job reference */
+		if (ni_system_updater_hostname_lookup_next(job))
+			return;
+		job->result = 1;
 	}
-	return EXIT_FAILURE;
+
+	ni_debug_verbose(NI_LOG_DEBUG1, NI_TRACE_EXTENSION,
+		"%s: job[%lu](%u) notify for lease %s:%s in state %s %s updater reverse lookup finished: %s",
+			job->device.name, job->nr, job->refcount,
+			ni_addrfamily_type_to_name(job->lease->family),
+			ni_addrconf_type_to_name(job->lease->type),
+			ni_addrconf_state_to_name(job->lease->state),
+			ni_updater_name(job->kind),
+			hostname ? hostname : "no hostname");
+
+	ni_updater_job_call_updater(job);
+	ni_updater_job_release_merged(job);
+	ni_updater_job_free(job);
 }
 
 static int
 ni_system_updater_hostname_lookup_call(ni_updater_t *updater, ni_updater_job_t *job)
 {
-	const ni_address_t *ap;
-	ni_shellcmd_t *shellcmd;
-	ni_process_t *pi;
-	int rv;
-
 	job->result = 0;
 
 	if (!ni_string_empty(job->lease->hostname)) {
@@ -1490,53 +1587,36 @@ ni_system_updater_hostname_lookup_call(ni_updater_t *updater, ni_updater_job_t *
 	if (!can_try_reverse_lookup(job->lease))
 		return -1;
 
-	shellcmd = ni_shellcmd_parse("wickedd-resolver");
-	if (!shellcmd)
-		return -1;
-
-	pi = ni_process_new(shellcmd);
-	ni_shellcmd_free(shellcmd);
-	if (!pi)
+	if (job->lookup)
 		return -1;
 
-	for (ap = job->lease->addrs; ap; ap = ap->next) {
-		const char *addr;
-
-		if (ni_address_is_tentative(ap) || ni_address_is_duplicate(ap))
-			continue;
-
-		if (!ni_sockaddr_is_specified(&ap->local_addr))
-			continue;
-
-		if ((addr = ni_sockaddr_print(&ap->local_addr)))
-			ni_string_array_append(&pi->argv, addr);
-	}
-	if (pi->argv.count <= 1) {
-		ni_process_free(pi);
+	/* the lookup holds a job reference until it notifies us */
+	job->lookups = 0;
+	ni_updater_job_ref(job);
+	if (!ni_system_updater_hostname_lookup_next(job)) {
+		ni_updater_job_free(job);
 		return -1;
 	}
-
-	pi->exec = do_reverse_resolve_ip_address;
-	rv = ni_process_run(pi);
-	if (rv == NI_PROCESS_SUCCESS) {
-		job->process = pi;
-		pi->user_data = ni_updater_job_ref(job);
-		pi->notify_callback = ni_system_updater_notify;
-		ni_debug_extension("%s: started lease %s:%s state %s %s updater (%s) with pid %d",
-				job->device.name,
-				ni_addrfamily_type_to_name(job->lease->family),
-				ni_addrconf_type_to_name(job->lease->type),
-				ni_addrconf_state_to_name(job->lease->state),
-				ni_updater_name(job->kind),
-				ni_basename(pi->process->command), pi->pid);
-	} else {
-		ni_process_free(pi);
-	}
-	return rv;
+	return 0;
 }
 static int
 ni_system_updater_hostname_lookup_wait(ni_updater_t *updater, ni_updater_job_t *job)
 {
+	if (job->lookup) {
+		ni_debug_verbose(NI_LOG_DEBUG1, NI_TRACE_EXTENSION,
+			"%s: waiting for %s job to %s lease %s:%s in state %s reverse lookup",
+			job->device.name,
+			job->state == NI_UPDATER_JOB_PENDING  ? "pending"  :
+			job->state == NI_UPDATER_JOB_RUNNING  ? "running"  :
+			job->state == NI_UPDATER_JOB_FINISHED ? "finished" : "broken state",
+			job->flow  == NI_UPDATER_FLOW_INSTALL ? "install"  :
+			job->flow  == NI_UPDATER_FLOW_REMOVAL ? "remove"   : "broken flow",
+			ni_addrfamily_type_to_name(job->lease->family),
+			ni_addrconf_type_to_name(job->lease->type),
+			ni_addrconf_state_to_name(job->lease->state));
+		return 1;
+	}
+
 	return ni_system_updater_process_wait(updater, job, __func__);
 }
 
@@ -1768,6 +1848,30 @@ ni_updater_job_set_timeout(ni_updater_job_t *job, unsigned int timeout)
 		updater->timeout = timeout;
 }
 
+/*
+ * Delay the start of an updater call until the settle window since
+ * the job has been queued is over, so pending jobs can be merged.
+ */
+static unsigned int
+ni_updater_job_settle_left(const ni_updater_t *updater, const ni_updater_job_t *job)
+{
+	struct timeval now, end, left;
+
+	if (!updater->settle || !updater->proc_batch)
+		return 0;
+
+	end.tv_sec  = updater->settle / 1000;
+	end.tv_usec = (updater->settle % 1000) * 1000;
+	timeradd(&job->queued, &end, &end);
+
+	ni_timer_get_time(&now);
+	if (!timercmp(&now, &end, <))
+		return 0;
+
+	timersub(&end, &now, &left);
+	return left.tv_sec * 1000 + (left.tv_usec + 999) / 1000;
+}
+
 static int
 ni_updater_job_action_call(ni_updater_t *updater, ni_updater_job_t *job)
 {
@@ -1812,8 +1916,19 @@ ni_updater_job_execute(ni_updater_job_t *job)
 		updater = &updaters[job->kind];
 
 		if (updater && updater->enabled && can_update_type(job->lease, job->kind)) {
-			if (!job->actions)
+			if (!job->actions) {
+				unsigned int settle;
+
+				if ((settle = ni_updater_job_settle_left(updater, job))) {
+					ni_debug_verbose(NI_LOG_DEBUG2, NI_TRACE_EXTENSION,
+						"settle %s for %u msec",
+						ni_updater_job_info(&out, job), settle);
+					ni_stringbuf_destroy(&out);
+					ni_updater_job_set_timeout(job, settle);
+					return 1;
+				}
 				job->actions = system_updater_action_table(job->kind, job->flow);
+			}
 
 			ni_updater_job_set_timeout(job, 5 * 1000);
 			if (ni_updater_job_action_call(updater, job) > 0)
@@ -1891,3 +2006,19 @@ ni_system_update_from_lease(const ni_addrconf_lease_t *lease, const unsigned int
 
 	return ni_updater_job_execute(job);
 }
+
+ni_bool_t
+ni_system_updater_stats(unsigned int kind, unsigned long *calls, unsigned long *merged)
+{
+	const ni_updater_t *updater;
+
+	if (kind >= __NI_ADDRCONF_UPDATER_MAX)
+		return FALSE;
+
+	updater = &updaters[kind];
+	if (calls)
+		*calls = updater->calls;
+	if (merged)
+		*merged = updater->merged;
+	return updater->enabled;
+}
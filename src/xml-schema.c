@@ -278,6 +278,9 @@ ni_xs_type_free(ni_xs_type_t *type)
 		xml_node_free(type->meta);
 	type->meta = NULL;
 
+	ni_dbus_xml_prog_free(type->dbus_prog);
+	type->dbus_prog = NULL;
+
 	ni_string_free(&type->description);
 	ni_string_free(&type->name);
 	free(type);
@@ -165,6 +165,8 @@
 
 #include <wicked/xml.h>
 
+typedef struct ni_dbus_xml_prog	ni_dbus_xml_prog_t;
+
 typedef struct ni_xs_type_array {
 	unsigned int		count;
 	ni_xs_type_t **		data;
@@ -294,6 +296,9 @@ struct ni_xs_type {
 
 	/* <meta> node holding additional information */
 	xml_node_t *		meta;
+
+	/* conversion program, compiled by dbus-xml on first use */
+	ni_dbus_xml_prog_t *	dbus_prog;
 };
 
 struct ni_xs_method {
@@ -356,6 +361,7 @@ extern int		ni_xs_process_schema(xml_node_t *, ni_xs_scope_t *);
 extern ni_xs_type_t *	ni_xs_scalar_new(const char *, unsigned int);
 extern int		ni_xs_scope_typedef(ni_xs_scope_t *, const char *, ni_xs_type_t *, const char *);
 extern void		ni_xs_type_free(ni_xs_type_t *type);
+extern void		ni_dbus_xml_prog_free(ni_dbus_xml_prog_t *);
 
 const ni_xs_type_t *	ni_xs_name_type_array_find(const ni_xs_name_type_array_t *, const char *);
 
@@ -25,22 +25,25 @@
 #include "config.h"
 #endif
 
+#include <sys/uio.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <errno.h>
+
 #include <wicked/xml.h>
 #include <wicked/logging.h>
 #include "netinfo_priv.h"
 #include "buffer.h"
 
+/*
+ * The digests identify config origins across runs, so they're still
+ * computed from the printf output (including its 255 char chunking).
+ */
 typedef struct xml_writer {
-	FILE *		file;
 	ni_hashctx_t *	hash;
-	unsigned int	noclose : 1;
-	ni_stringbuf_t	buffer;
 } xml_writer_t;
 
-static int		xml_writer_open(xml_writer_t *, const char *);
-static int		xml_writer_init_file(xml_writer_t *, FILE *);
 static int		xml_writer_init_hash(xml_writer_t *, ni_hashctx_algo_t);
-static int		xml_writer_close(xml_writer_t *);
 static int		xml_writer_destroy(xml_writer_t *);
 static int		xml_writer_destroy_get_hash(xml_writer_t *, void *, size_t);
 static void		xml_writer_printf(xml_writer_t *, const char *, ...);
@@ -50,52 +53,93 @@ static void		xml_node_output(const xml_node_t *node, xml_writer_t *, unsigned in
 static const char *	xml_escape_quote(const char *);
 static const char *	xml_escape_entities(const char *, char **);
 
+/*
+ * Output is queued as iovecs referring to the node strings, escaped
+ * in spans between the special chars, and flushed using writev.
+ * Short pieces and strings which don't outlive the call are copied
+ * to a scratch area instead, where adjacent pieces coalesce.
+ */
+#define XML_STREAM_IOV_MAX	(IOV_MAX < 1024 ? IOV_MAX : 1024)
+#define XML_STREAM_SCRATCH	16384
+#define XML_STREAM_INLINE	128
+
+typedef struct xml_stream_level {
+	const char *	name;
+	char *		name_copy;
+	unsigned int	indent;
+	ni_bool_t	open_tag;
+	ni_bool_t	newline;
+	ni_bool_t	content;
+} xml_stream_level_t;
+
+struct xml_stream {
+	int			fd;
+	FILE *			file;
+	ni_bool_t		noclose;
+	ni_stringbuf_t		buffer;
+	ni_bool_t		memory;
+	ni_bool_t		error;
+
+	unsigned int		depth;
+	unsigned int		levels;
+	xml_stream_level_t *	level;
+
+	unsigned int		iovcnt;
+	struct iovec		iov[XML_STREAM_IOV_MAX];
+	size_t			scratch_len;
+	char			scratch[XML_STREAM_SCRATCH];
+};
+
+static const char	xml_stream_header[] = "<?xml version=\"1.0\" encoding=\"utf8\"?>\n";
+static const char	xml_stream_spaces[] = "                                "
+					      "                                ";
+
+static void		xml_stream_node_output(xml_stream_t *, const xml_node_t *);
+
 int
 xml_document_write(const xml_document_t *doc, const char *filename)
 {
-	xml_writer_t writer;
+	xml_stream_t *ws;
+	int fd;
 
-	if (xml_writer_open(&writer, filename) < 0)
+	fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+	if (fd < 0) {
+		ni_error("xml_writer: cannot open %s for writing: %m", filename);
 		return -1;
+	}
 
-	xml_document_output(doc, &writer);
-	return xml_writer_destroy(&writer);
+	if (!(ws = xml_stream_open_fd(fd))) {
+		close(fd);
+		return -1;
+	}
+	ws->noclose = FALSE;
+
+	xml_stream_document(ws, doc);
+	return xml_stream_close(ws);
 }
 
 int
 xml_document_print(const xml_document_t *doc, FILE *fp)
 {
-	xml_writer_t writer;
+	xml_stream_t *ws;
 
-	if (xml_writer_init_file(&writer, fp? fp : stdout) < 0)
+	if (!(ws = xml_stream_open_file(fp ? fp : stdout)))
 		return -1;
 
-	xml_document_output(doc, &writer);
-	return xml_writer_destroy(&writer);
+	xml_stream_document(ws, doc);
+	return xml_stream_close(ws);
 }
 
 char *
 xml_document_sprint(const xml_document_t *doc)
 {
-	char *string = NULL;
-	size_t size = 0;
-	FILE *fp;
-	int rv;
-
-	if ((fp = open_memstream(&string, &size)) == NULL) {
-		ni_error("%s: unable to open memstream", __func__);
-		return NULL;
-	}
-
-	rv = xml_document_print(doc, fp);
-	fclose(fp);
+	xml_stream_t *ws;
 
-	if (rv < 0) {
-		free(string);
+	if (!(ws = xml_stream_open_buffer()))
 		return NULL;
-	}
 
-	return string;
+	xml_stream_document(ws, doc);
+	return xml_stream_close_string(ws);
 }
 
 int
@@ -146,39 +190,25 @@ xml_document_output(const xml_document_t *doc, xml_writer_t *writer)
 int
 xml_node_print(const xml_node_t *node, FILE *fp)
 {
-	xml_writer_t writer;
-	int rv = 0;
+	xml_stream_t *ws;
 
-	if (xml_writer_init_file(&writer, fp? fp : stdout) >= 0) {
-		xml_node_output(node, &writer, 0);
-		rv = xml_writer_destroy(&writer);
-	}
+	if (!(ws = xml_stream_open_file(fp ? fp : stdout)))
+		return 0;
 
-	return rv;
+	xml_stream_node(ws, node);
+	return xml_stream_close(ws);
 }
 
 char *
 xml_node_sprint(const xml_node_t *node)
 {
-	char *string = NULL;
-	size_t size = 0;
-	FILE *fp;
-	int rv;
+	xml_stream_t *ws;
 
-	if ((fp = open_memstream(&string, &size)) == NULL) {
-		ni_error("%s: unable to open memstream", __func__);
+	if (!(ws = xml_stream_open_buffer()))
 		return NULL;
-	}
 
-	rv = xml_node_print(node, fp);
-	fclose(fp);
-
-	if (rv < 0) {
-		free(string);
-		return NULL;
-	}
-
-	return string;
+	xml_stream_node(ws, node);
+	return xml_stream_close_string(ws);
 }
 
 int
@@ -243,27 +273,19 @@ xml_node_content_uuid(const xml_node_t *node, unsigned int version,
 int
 xml_node_print_fn(const xml_node_t *node, void (*writefn)(const char *, void *), void *user_data)
 {
-	char *membuf = NULL;
-	size_t memsz = 0;
-	FILE *memf;
-	int rv;
+	char *membuf, *s, *t;
 
-	memf = open_memstream(&membuf, &memsz);
-	rv = xml_node_print(node, memf);
-	fclose(memf);
-
-	if (rv >= 0) {
-		char *s, *t;
+	if (!(membuf = xml_node_sprint(node)))
+		return -1;
 
-		for (s = membuf; s; s = t) {
-			if ((t = strchr(s, '\n')) != NULL)
-				*t++ = '\0';
-			writefn(s, user_data);
-		}
+	for (s = membuf; s; s = t) {
+		if ((t = strchr(s, '\n')) != NULL)
+			*t++ = '\0';
+		writefn(s, user_data);
 	}
 
 	free(membuf);
-	return rv;
+	return 0;
 }
 
 /*
@@ -396,30 +418,459 @@ xml_escape_quote(const char *string)
 }
 
 /*
- * xml_writer object
+ * xml_stream object
  */
+static xml_stream_t *
+xml_stream_new(void)
+{
+	xml_stream_t *ws;
+
+	ws = xcalloc(1, sizeof(*ws));
+	ws->fd = -1;
+	ws->noclose = TRUE;
+	ni_stringbuf_init(&ws->buffer);
+	return ws;
+}
+
+xml_stream_t *
+xml_stream_open_fd(int fd)
+{
+	xml_stream_t *ws;
+
+	if (fd < 0)
+		return NULL;
+
+	ws = xml_stream_new();
+	ws->fd = fd;
+	return ws;
+}
+
+xml_stream_t *
+xml_stream_open_file(FILE *file)
+{
+	xml_stream_t *ws;
+
+	if (!file)
+		return NULL;
+
+	ws = xml_stream_new();
+	ws->file = file;
+	return ws;
+}
+
+xml_stream_t *
+xml_stream_open_buffer(void)
+{
+	xml_stream_t *ws;
+
+	ws = xml_stream_new();
+	ws->memory = TRUE;
+	return ws;
+}
+
+static int
+xml_stream_writev(int fd, struct iovec *iov, unsigned int iovcnt)
+{
+	ssize_t len;
+
+	while (iovcnt) {
+		len = writev(fd, iov, iovcnt);
+		if (len < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+
+		/* skip over what went out, resume a partial write */
+		while (iovcnt && (size_t)len >= iov->iov_len) {
+			len -= iov->iov_len;
+			iov++;
+			iovcnt--;
+		}
+		if (iovcnt && len) {
+			iov->iov_base = (char *)iov->iov_base + len;
+			iov->iov_len -= len;
+		}
+	}
+	return 0;
+}
+
 int
-xml_writer_open(xml_writer_t *writer, const char *filename)
+xml_stream_flush(xml_stream_t *ws)
 {
-	memset(writer, 0, sizeof(*writer));
-	writer->file = fopen(filename, "w");
-	if (!writer->file) {
-		ni_error("xml_writer: cannot open %s for writing: %m", filename);
+	unsigned int i;
+	int fd;
+
+	if (!ws)
 		return -1;
+
+	if (!ws->iovcnt || ws->error)
+		goto done;
+
+	if (ws->memory) {
+		size_t total = 0;
+
+		/* grow geometrically, stringbuf itself only adds chunks */
+		for (i = 0; i < ws->iovcnt; ++i)
+			total += ws->iov[i].iov_len;
+		if (ws->buffer.len + total >= ws->buffer.size)
+			ni_stringbuf_grow(&ws->buffer, max_t(size_t, total, ws->buffer.len));
+
+		for (i = 0; i < ws->iovcnt; ++i)
+			ni_stringbuf_put(&ws->buffer, ws->iov[i].iov_base, ws->iov[i].iov_len);
+	} else
+	if (ws->file && (fd = fileno(ws->file)) < 0) {
+		/* memstream and friends don't have a descriptor */
+		for (i = 0; i < ws->iovcnt; ++i) {
+			if (fwrite(ws->iov[i].iov_base, ws->iov[i].iov_len, 1, ws->file) != 1) {
+				ws->error = TRUE;
+				break;
+			}
+		}
+	} else {
+		if (ws->file) {
+			if (fflush(ws->file) != 0)
+				ws->error = TRUE;
+		} else {
+			fd = ws->fd;
+		}
+		if (!ws->error && xml_stream_writev(fd, ws->iov, ws->iovcnt) < 0) {
+			ni_error("xml_writer: write error: %m");
+			ws->error = TRUE;
+		}
 	}
 
-	return 0;
+done:
+	ws->iovcnt = 0;
+	ws->scratch_len = 0;
+	return ws->error ? -1 : 0;
+}
+
+/*
+ * Queue len bytes at ptr. Unless copy is set, the data has
+ * to stay valid until the stream is flushed.
+ */
+static void
+xml_stream_put(xml_stream_t *ws, const char *ptr, size_t len, ni_bool_t copy)
+{
+	struct iovec *last;
+
+	if (!len)
+		return;
+
+	if (ws->iovcnt == XML_STREAM_IOV_MAX)
+		xml_stream_flush(ws);
+
+	if (copy || len < XML_STREAM_INLINE) {
+		if (len > XML_STREAM_SCRATCH - ws->scratch_len)
+			xml_stream_flush(ws);
+
+		if (len > XML_STREAM_SCRATCH) {
+			ws->iov[ws->iovcnt].iov_base = (char *)ptr;
+			ws->iov[ws->iovcnt].iov_len = len;
+			ws->iovcnt++;
+			xml_stream_flush(ws);
+			return;
+		}
+
+		memcpy(ws->scratch + ws->scratch_len, ptr, len);
+		ptr = ws->scratch + ws->scratch_len;
+		ws->scratch_len += len;
+	}
+
+	if (ws->iovcnt) {
+		last = &ws->iov[ws->iovcnt - 1];
+		if ((char *)last->iov_base + last->iov_len == ptr) {
+			last->iov_len += len;
+			return;
+		}
+	}
+
+	ws->iov[ws->iovcnt].iov_base = (char *)ptr;
+	ws->iov[ws->iovcnt].iov_len = len;
+	ws->iovcnt++;
+}
+
+static inline void
+xml_stream_puts(xml_stream_t *ws, const char *str, ni_bool_t copy)
+{
+	if (str)
+		xml_stream_put(ws, str, strlen(str), copy);
+}
+
+static void
+xml_stream_indent(xml_stream_t *ws, unsigned int indent)
+{
+	size_t len;
+
+	while (indent) {
+		len = sizeof(xml_stream_spaces) - 1;
+		if (len > indent)
+			len = indent;
+		xml_stream_put(ws, xml_stream_spaces, len, FALSE);
+		indent -= len;
+	}
+}
+
+static void
+xml_stream_escape(xml_stream_t *ws, const char *cdata, ni_bool_t copy)
+{
+	size_t len;
+
+	for (;;) {
+		len = strcspn(cdata, "<>&");
+		xml_stream_put(ws, cdata, len, copy);
+
+		switch (cdata[len]) {
+		case '<': xml_stream_put(ws, "&lt;", 4, FALSE);  break;
+		case '>': xml_stream_put(ws, "&gt;", 4, FALSE);  break;
+		case '&': xml_stream_put(ws, "&amp;", 5, FALSE); break;
+		default:
+			return;
+		}
+		cdata += len + 1;
+	}
+}
+
+static xml_stream_level_t *
+xml_stream_top(xml_stream_t *ws)
+{
+	return ws->depth ? &ws->level[ws->depth - 1] : NULL;
+}
+
+/*
+ * Terminate the open tag of the current element before
+ * it gets some content.
+ */
+static void
+xml_stream_content(xml_stream_level_t *cur, xml_stream_t *ws)
+{
+	if (cur->open_tag) {
+		xml_stream_put(ws, ">", 1, FALSE);
+		cur->open_tag = FALSE;
+	}
+	cur->content = TRUE;
+}
+
+static void
+__xml_stream_begin(xml_stream_t *ws, const char *name, ni_bool_t copy)
+{
+	xml_stream_level_t *cur, *parent;
+	unsigned int indent = 0;
+
+	if ((parent = xml_stream_top(ws))) {
+		xml_stream_content(parent, ws);
+		if (!parent->newline) {
+			xml_stream_put(ws, "\n", 1, FALSE);
+			parent->newline = TRUE;
+		}
+		indent = parent->name ? parent->indent + 2 : parent->indent;
+	}
+
+	if (ws->depth == ws->levels) {
+		ws->levels += 8;
+		ws->level = xrealloc(ws->level, ws->levels * sizeof(ws->level[0]));
+	}
+
+	cur = &ws->level[ws->depth++];
+	memset(cur, 0, sizeof(*cur));
+	cur->indent = indent;
+
+	if (name == NULL) {
+		cur->newline = TRUE;
+		return;
+	}
+
+	if (copy)
+		cur->name = cur->name_copy = xstrdup(name);
+	else
+		cur->name = name;
+
+	xml_stream_indent(ws, indent);
+	xml_stream_put(ws, "<", 1, FALSE);
+	xml_stream_puts(ws, name, copy);
+	cur->open_tag = TRUE;
+}
+
+static void
+__xml_stream_attr(xml_stream_t *ws, const char *name, const char *value, ni_bool_t copy)
+{
+	xml_stream_level_t *cur;
+
+	if (!(cur = xml_stream_top(ws)) || !cur->open_tag || !name)
+		return;
+
+	xml_stream_put(ws, " ", 1, FALSE);
+	xml_stream_puts(ws, name, copy);
+	if (value) {
+		xml_stream_put(ws, "=\"", 2, FALSE);
+		xml_stream_puts(ws, xml_escape_quote(value), copy);
+		xml_stream_put(ws, "\"", 1, FALSE);
+	}
+}
+
+static void
+__xml_stream_cdata(xml_stream_t *ws, const char *cdata, ni_bool_t copy)
+{
+	xml_stream_level_t *cur;
+	size_t len;
+
+	if (!(cur = xml_stream_top(ws)) || !cdata)
+		return;
+
+	xml_stream_content(cur, ws);
+	if (strchr(cdata, '\n')) {
+		xml_stream_put(ws, "\n", 1, FALSE);
+		cur->newline = TRUE;
+	}
+	xml_stream_escape(ws, cdata, copy);
+
+	if (cur->newline) {
+		len = strlen(cdata);
+		if (len && cdata[len - 1] != '\n')
+			xml_stream_put(ws, "\n", 1, FALSE);
+	}
+}
+
+static void
+__xml_stream_end(xml_stream_t *ws)
+{
+	xml_stream_level_t *cur;
+
+	if (!(cur = xml_stream_top(ws)))
+		return;
+
+	if (cur->name) {
+		if (!cur->content) {
+			xml_stream_put(ws, "/>\n", 3, FALSE);
+		} else {
+			if (cur->newline)
+				xml_stream_indent(ws, cur->indent);
+			xml_stream_put(ws, "</", 2, FALSE);
+			xml_stream_puts(ws, cur->name, !!cur->name_copy);
+			xml_stream_put(ws, ">\n", 2, FALSE);
+		}
+	}
+
+	ni_string_free(&cur->name_copy);
+	ws->depth--;
+}
+
+void
+xml_stream_element_begin(xml_stream_t *ws, const char *name)
+{
+	if (ws && name)
+		__xml_stream_begin(ws, name, TRUE);
+}
+
+void
+xml_stream_element_attr(xml_stream_t *ws, const char *name, const char *value)
+{
+	if (ws)
+		__xml_stream_attr(ws, name, value, TRUE);
+}
+
+void
+xml_stream_element_cdata(xml_stream_t *ws, const char *cdata)
+{
+	if (ws)
+		__xml_stream_cdata(ws, cdata, TRUE);
+}
+
+void
+xml_stream_element_end(xml_stream_t *ws)
+{
+	if (ws)
+		__xml_stream_end(ws);
+}
+
+/*
+ * Node strings are queued by reference, so flush before
+ * returning to the caller, who may free the node next.
+ */
+static void
+xml_stream_node_output(xml_stream_t *ws, const xml_node_t *node)
+{
+	const xml_node_t *child;
+	const ni_var_t *attr;
+	unsigned int i;
+
+	__xml_stream_begin(ws, node->name, FALSE);
+	if (node->name) {
+		for (i = 0, attr = node->attrs.data; i < node->attrs.count; ++i, ++attr)
+			__xml_stream_attr(ws, attr->name, attr->value, FALSE);
+	}
+	__xml_stream_cdata(ws, node->cdata, FALSE);
+	for (child = node->children; child; child = child->next)
+		xml_stream_node_output(ws, child);
+	__xml_stream_end(ws);
+}
+
+void
+xml_stream_node(xml_stream_t *ws, const xml_node_t *node)
+{
+	if (!ws || !node)
+		return;
+
+	xml_stream_node_output(ws, node);
+	xml_stream_flush(ws);
+}
+
+void
+xml_stream_document(xml_stream_t *ws, const xml_document_t *doc)
+{
+	if (!ws || !doc)
+		return;
+
+	xml_stream_puts(ws, xml_stream_header, FALSE);
+	if (doc->root)
+		xml_stream_node_output(ws, doc->root);
+	xml_stream_flush(ws);
 }
 
 int
-xml_writer_init_file(xml_writer_t *writer, FILE *file)
+xml_stream_close(xml_stream_t *ws)
 {
-	memset(writer, 0, sizeof(*writer));
-	writer->file = file;
-	writer->noclose = 1;
-	return 0;
+	int rv;
+
+	if (!ws)
+		return -1;
+
+	rv = xml_stream_flush(ws);
+	if (ws->file && ferror(ws->file))
+		rv = -1;
+	if (ws->fd >= 0 && !ws->noclose && close(ws->fd) < 0)
+		rv = -1;
+
+	while (ws->depth--)
+		free(ws->level[ws->depth].name_copy);
+	free(ws->level);
+	ni_stringbuf_destroy(&ws->buffer);
+	free(ws);
+	return rv;
 }
 
+char *
+xml_stream_close_string(xml_stream_t *ws)
+{
+	char *string = NULL;
+
+	if (!ws)
+		return NULL;
+
+	if (xml_stream_flush(ws) == 0) {
+		string = ws->buffer.string ? ws->buffer.string : xstrdup("");
+		ws->buffer.string = NULL;
+		ni_stringbuf_init(&ws->buffer);
+	}
+
+	xml_stream_close(ws);
+	return string;
+}
+
+/*
+ * xml_writer object
+ */
 int
 xml_writer_init_hash(xml_writer_t *writer, ni_hashctx_algo_t algo)
 {
@@ -431,28 +882,13 @@ xml_writer_init_hash(xml_writer_t *writer, ni_hashctx_algo_t algo)
 }
 
 int
-xml_writer_close(xml_writer_t *writer)
+xml_writer_destroy(xml_writer_t *writer)
 {
-	int rv = 0;
-
-	if (writer->file && ferror(writer->file))
-		rv = -1;
-	if (writer->file && !writer->noclose) {
-		fclose(writer->file);
-		writer->file = NULL;
-	}
 	if (writer->hash) {
 		ni_hashctx_free(writer->hash);
 		writer->hash = NULL;
 	}
-	return rv;
-}
-
-int
-xml_writer_destroy(xml_writer_t *writer)
-{
-	ni_stringbuf_destroy(&writer->buffer);
-	return xml_writer_close(writer);
+	return 0;
 }
 
 int
@@ -476,14 +912,7 @@ xml_writer_printf(xml_writer_t *writer, const char *fmt, ...)
 	va_list ap;
 
 	va_start(ap, fmt);
-	if (writer->file) {
-		vfprintf(writer->file, fmt, ap);
-	} else {
-		vsnprintf(temp, sizeof(temp), fmt, ap);
-		if (writer->hash)
-			ni_hashctx_puts(writer->hash, temp);
-		else
-			ni_stringbuf_puts(&writer->buffer, temp);
-	}
+	vsnprintf(temp, sizeof(temp), fmt, ap);
+	ni_hashctx_puts(writer->hash, temp);
 	va_end(ap);
 }
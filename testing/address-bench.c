@@ -0,0 +1,204 @@
+/*
+ *	Lease address matching benchmark
+ *
+ *	Copyright (C) 2026 SUSE Linux GmbH, Nuernberg, Germany.
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	This program is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along
+ *	with this program; if not, see <http://www.gnu.org/licenses/> or write
+ *	to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *	Boston, MA 02110-1301 USA.
+ *
+ *	Usage:
+ *		address-bench [-n addresses]
+ *
+ *	Creates a device with <addresses> (default 10000) IPv4 addresses,
+ *	half of them point-to-point with a peer, and a static lease with
+ *	most of them plus some new ones. A dhcp and an auto lease co-own
+ *	a quarter of the addresses each. Some lease addresses appear twice,
+ *	with a different peer and prefix.
+ *	Then matches every device address against the static lease and
+ *	looks up its owning lease, the way applying the static lease
+ *	does: with the list searches and with the address indexes.
+ *	Reports both times and fails if the results differ.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <arpa/inet.h>
+
+#include <wicked/util.h>
+#include <wicked/logging.h>
+#include <wicked/netinfo.h>
+#include <wicked/addrconf.h>
+#include "netinfo_priv.h"
+#include "util_priv.h"
+
+static ni_address_t *
+bench_address_add(ni_address_t **list, unsigned int n, unsigned int prefixlen, ni_bool_t ptp)
+{
+	ni_sockaddr_t local;
+	ni_address_t *ap;
+
+	memset(&local, 0, sizeof(local));
+	local.sin.sin_family = AF_INET;
+	local.sin.sin_addr.s_addr = htonl(0x0a000000 + n);
+	ap = ni_address_new(AF_INET, prefixlen, &local, list);
+	if (ap && ptp) {
+		ap->peer_addr = local;
+		ap->peer_addr.sin.sin_addr.s_addr = htonl(0x0b000000 + n);
+	}
+	return ap;
+}
+
+static ni_addrconf_lease_t *
+bench_lease_new(ni_netdev_t *dev, int type, unsigned int beg, unsigned int end, unsigned int step)
+{
+	ni_addrconf_lease_t *lease;
+	unsigned int n;
+
+	lease = ni_addrconf_lease_new(type, AF_INET);
+	lease->state = NI_ADDRCONF_STATE_GRANTED;
+	for (n = beg; n < end; n += step)
+		bench_address_add(&lease->addrs, n, n % 3 ? 16 : 24, n & 1);
+	/* some of the addresses once more, with another peer and prefix */
+	for (n = beg; n < end; n += 97 * step)
+		bench_address_add(&lease->addrs, n, n % 3 ? 24 : 16, !(n & 1));
+	ni_netdev_set_lease(dev, lease);
+	return lease;
+}
+
+/* the list search __ni_netdev_update_addrs used before */
+static ni_address_t *
+bench_address_in_list(ni_address_t *list, const ni_address_t *ap)
+{
+	ni_address_t *ap2;
+
+	for (ap2 = list; ap2; ap2 = ap2->next) {
+		if (ap2->local_addr.ss_family != AF_INET)
+			continue;
+		if (ap->local_addr.sin.sin_addr.s_addr != ap2->local_addr.sin.sin_addr.s_addr)
+			continue;
+		if (!ni_sockaddr_equal(&ap->peer_addr, &ap2->peer_addr))
+			continue;
+		return ap2;
+	}
+	return NULL;
+}
+
+static ni_address_t *
+bench_address_in_index(const ni_address_index_t *index, const ni_address_t *ap)
+{
+	unsigned int pos = 0;
+	ni_address_t *ap2;
+
+	while ((ap2 = ni_address_index_find(index, &ap->local_addr, &pos))) {
+		if (ni_sockaddr_equal(&ap->peer_addr, &ap2->peer_addr))
+			return ap2;
+	}
+	return NULL;
+}
+
+static double
+bench_usecs(const struct timeval *beg, const struct timeval *end)
+{
+	return (end->tv_sec - beg->tv_sec) * 1e6 + (end->tv_usec - beg->tv_usec);
+}
+
+int
+main(int argc, char **argv)
+{
+	unsigned int count = 10000, naddrs, i, n, differ = 0;
+	ni_addrconf_lease_t *lease, **list_owner, **index_owner;
+	ni_address_t **list_match, **index_match, *ap;
+	ni_address_index_t new_addrs = NI_ADDRESS_INDEX_INIT;
+	ni_lease_address_index_t leases;
+	struct timeval beg, end;
+	double list_usecs, index_usecs;
+	ni_netdev_t *dev;
+	int c;
+
+	while ((c = getopt(argc, argv, "n:")) != EOF) {
+		switch (c) {
+		case 'n':
+			count = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-n addresses]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (count < 16)
+		return 1;
+
+	ni_log_init();
+
+	dev = ni_netdev_new("bench0", 2);
+	for (n = 0; n < count; ++n)
+		bench_address_add(&dev->addrs, n, n % 3 ? 16 : 24, n & 1);
+	naddrs = ni_address_list_count(dev->addrs);
+
+	lease = bench_lease_new(dev, NI_ADDRCONF_STATIC, count / 10, count + count / 10, 1);
+	bench_lease_new(dev, NI_ADDRCONF_DHCP, 0, count, 4);
+	bench_lease_new(dev, NI_ADDRCONF_AUTOCONF, 1, count, 4);
+
+	list_match  = xcalloc(naddrs, sizeof(list_match[0]));
+	list_owner  = xcalloc(naddrs, sizeof(list_owner[0]));
+	index_match = xcalloc(naddrs, sizeof(index_match[0]));
+	index_owner = xcalloc(naddrs, sizeof(index_owner[0]));
+
+	gettimeofday(&beg, NULL);
+	for (ap = dev->addrs, i = 0; ap; ap = ap->next, ++i) {
+		list_match[i] = bench_address_in_list(lease->addrs, ap);
+		list_owner[i] = __ni_netdev_address_to_lease(dev, ap, 0);
+	}
+	gettimeofday(&end, NULL);
+	list_usecs = bench_usecs(&beg, &end);
+
+	gettimeofday(&beg, NULL);
+	ni_address_index_add_list(&new_addrs, lease->addrs);
+	ni_lease_address_index_init(&leases, dev, AF_INET);
+	for (ap = dev->addrs, i = 0; ap; ap = ap->next, ++i) {
+		index_match[i] = bench_address_in_index(&new_addrs, ap);
+		index_owner[i] = ni_lease_address_index_find(&leases, ap, 0);
+	}
+	ni_lease_address_index_destroy(&leases);
+	ni_address_index_destroy(&new_addrs);
+	gettimeofday(&end, NULL);
+	index_usecs = bench_usecs(&beg, &end);
+
+	for (i = 0; i < naddrs; ++i) {
+		if (list_match[i] != index_match[i] || list_owner[i] != index_owner[i])
+			differ++;
+	}
+
+	printf("%u device addresses, %u lease addresses\n", naddrs,
+			ni_address_list_count(lease->addrs));
+	printf("  list search: %12.1f usec\n", list_usecs);
+	printf("  index:       %12.1f usec\n", index_usecs);
+	if (differ)
+		printf("%u addresses matched differently\n", differ);
+	printf("%s\n", differ ? "FAILED" : "OK");
+
+	free(list_match);
+	free(list_owner);
+	free(index_match);
+	free(index_owner);
+	ni_netdev_put(dev);
+	return differ ? 1 : 0;
+}
@@ -0,0 +1,200 @@
+/*
+ *	DBus dict and property table lookup test
+ *
+ *	Copyright (C) 2026 SUSE Linux GmbH, Nuernberg, Germany.
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	This program is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along
+ *	with this program; if not, see <http://www.gnu.org/licenses/> or write
+ *	to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *	Boston, MA 02110-1301 USA.
+ *
+ *	Checks that the hashed lookups in large dicts and property tables
+ *	find the same entries as a linear search would: the first one of
+ *	a given name, including entries appended or deleted after the
+ *	dict has been indexed. Reports the time needed to look up every
+ *	key of a dict with <count> (default 10000) entries.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <wicked/util.h>
+#include <wicked/logging.h>
+#include <wicked/dbus.h>
+#include <wicked/dbus-service.h>
+
+static unsigned int		failed;
+
+#define CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			fprintf(stderr, "%s:%u: check failed: %s\n", __FILE__, __LINE__, #cond); \
+			failed++; \
+		} \
+	} while (0)
+
+static char **
+dict_keys(unsigned int count)
+{
+	char **keys = calloc(count, sizeof(keys[0]));
+	char buf[32];
+	unsigned int i;
+
+	for (i = 0; i < count; ++i) {
+		snprintf(buf, sizeof(buf), "key-%u", i);
+		keys[i] = strdup(buf);
+	}
+	return keys;
+}
+
+static void
+dict_fill(ni_dbus_variant_t *dict, char **keys, unsigned int beg, unsigned int end)
+{
+	unsigned int i;
+
+	for (i = beg; i < end; ++i)
+		ni_dbus_dict_add_uint32(dict, keys[i], i);
+}
+
+static dbus_bool_t
+dict_value(const ni_dbus_variant_t *dict, const char *key, uint32_t expect)
+{
+	uint32_t value;
+
+	return ni_dbus_dict_get_uint32(dict, key, &value) && value == expect;
+}
+
+static void
+test_dict(unsigned int count)
+{
+	ni_dbus_variant_t dict = NI_DBUS_VARIANT_INIT;
+	char **keys = dict_keys(count);
+	struct timeval beg, end;
+	unsigned int i, found;
+
+	/* small dicts are searched linearly */
+	ni_dbus_variant_init_dict(&dict);
+	dict_fill(&dict, keys, 0, 4);
+	ni_dbus_dict_add_uint32(&dict, keys[1], 100);
+	CHECK(dict_value(&dict, keys[1], 1));
+	CHECK(ni_dbus_dict_get(&dict, "nonexistent") == NULL);
+
+	/* grow it beyond the index size and add the duplicate again */
+	dict_fill(&dict, keys, 4, count / 2);
+	ni_dbus_dict_add_uint32(&dict, keys[2], 200);
+	for (i = 0; i < count / 2; ++i)
+		CHECK(dict_value(&dict, keys[i], i));
+	CHECK(ni_dbus_dict_get(&dict, "nonexistent") == NULL);
+
+	/* append to the indexed dict */
+	dict_fill(&dict, keys, count / 2, count);
+	CHECK(dict_value(&dict, keys[count - 1], count - 1));
+	CHECK(dict_value(&dict, keys[count / 2], count / 2));
+
+	/* deleting the first entry of a name exposes the duplicate */
+	CHECK(ni_dbus_dict_delete_entry(&dict, keys[1]));
+	CHECK(dict_value(&dict, keys[1], 100));
+	CHECK(ni_dbus_dict_delete_entry(&dict, keys[2]));
+	CHECK(dict_value(&dict, keys[2], 200));
+	CHECK(ni_dbus_dict_delete_entry(&dict, keys[3]));
+	CHECK(ni_dbus_dict_get(&dict, keys[3]) == NULL);
+	CHECK(dict_value(&dict, keys[4], 4));
+
+	gettimeofday(&beg, NULL);
+	for (i = 4, found = 0; i < count; ++i) {
+		if (dict_value(&dict, keys[i], i))
+			found++;
+	}
+	gettimeofday(&end, NULL);
+	CHECK(found == count - 4);
+
+	printf("%u dict lookups: %.1f usec\n", count - 4,
+		(end.tv_sec - beg.tv_sec) * 1e6 + (end.tv_usec - beg.tv_usec));
+
+	ni_dbus_variant_destroy(&dict);
+	for (i = 0; i < count; ++i)
+		free(keys[i]);
+	free(keys);
+}
+
+static const ni_dbus_property_t	test_child_properties[] = {
+	{ .name = "mtu",	.signature = DBUS_TYPE_UINT32_AS_STRING },
+	{ .name = "name",	.signature = DBUS_TYPE_STRING_AS_STRING },
+	{ NULL }
+};
+
+static const ni_dbus_property_t	test_properties[] = {
+	{ .name = "name",	.signature = DBUS_TYPE_STRING_AS_STRING },
+	{ .name = "index",	.signature = DBUS_TYPE_UINT32_AS_STRING },
+	{ .name = "status",	.signature = DBUS_TYPE_UINT32_AS_STRING },
+	{ .name = "link",	.signature = NI_DBUS_DICT_SIGNATURE,
+	  .generic = { .u = { .dict_children = test_child_properties } } },
+	{ .name = "index",	.signature = DBUS_TYPE_STRING_AS_STRING },
+	{ .name = "metric",	.signature = DBUS_TYPE_UINT32_AS_STRING },
+	{ NULL }
+};
+
+static const ni_dbus_service_t	test_service = {
+	.name		= "org.opensuse.Network.Test",
+	.properties	= test_properties,
+};
+
+static void
+test_properties_lookup(void)
+{
+	const ni_dbus_property_t *property, *child;
+	ni_dbus_variant_t dict = NI_DBUS_VARIANT_INIT;
+	ni_dbus_variant_t *link;
+
+	for (property = test_properties; property->name; ++property) {
+		if (property == &test_properties[4])
+			continue;
+		CHECK(ni_dbus_service_get_property(&test_service, property->name) == property);
+	}
+	CHECK(ni_dbus_service_get_property(&test_service, "index") == &test_properties[1]);
+	CHECK(ni_dbus_service_get_property(&test_service, "mtu") == NULL);
+
+	/* dict children have tables of their own */
+	ni_dbus_variant_init_dict(&dict);
+	child = ni_dbus_service_create_property(&test_service, "link.mtu", &dict, &link);
+	CHECK(child == &test_child_properties[0]);
+	CHECK(link == ni_dbus_dict_get(&dict, "link"));
+	child = ni_dbus_service_create_property(&test_service, "link.name", &dict, &link);
+	CHECK(child == &test_child_properties[1]);
+	CHECK(ni_dbus_service_create_property(&test_service, "link.index", &dict, NULL) == NULL);
+	ni_dbus_variant_destroy(&dict);
+}
+
+int
+main(int argc, char **argv)
+{
+	unsigned int count = 10000;
+
+	if (argc > 1)
+		count = strtoul(argv[1], NULL, 0);
+	if (count < 64)
+		count = 64;
+
+	ni_log_init();
+
+	test_dict(count);
+	test_properties_lookup();
+
+	printf("%s\n", failed ? "FAILED" : "OK");
+	return failed ? 1 : 0;
+}
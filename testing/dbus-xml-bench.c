@@ -0,0 +1,261 @@
+/*
+ *	Schema based xml <-> dbus variant conversion benchmark
+ *
+ *	Copyright (C) 2026 SUSE Linux GmbH, Nuernberg, Germany.
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	This program is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along
+ *	with this program; if not, see <http://www.gnu.org/licenses/> or write
+ *	to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *	Boston, MA 02110-1301 USA.
+ *
+ *	Usage:
+ *		dbus-xml-bench [-n interfaces] [-r rounds] [schema-file]
+ *
+ *	Loads the dbus xml schema (default: the installed wicked.xml),
+ *	generates interface and ethernet properties for <interfaces>
+ *	(default 2000) devices and converts them into dbus variants and
+ *	back again <rounds> times, the way the client and server do it
+ *	for method arguments and property reports.
+ *	Reports the time used by both directions and fails when the xml
+ *	obtained back from the variants differs from the input.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include <wicked/util.h>
+#include <wicked/logging.h>
+#include <wicked/xml.h>
+#include <wicked/dbus.h>
+#include "xml-schema.h"
+#include "util_priv.h"
+
+/*
+ * The element names are the short service names, which get
+ * mapped to the dbus interface names the properties belong to.
+ */
+static const struct bench_service {
+	const char *	name;
+	const char *	interface;
+} bench_services[] = {
+	{ "interface",	"org.opensuse.Network.Interface"	},
+	{ "ethernet",	"org.opensuse.Network.Ethernet"		},
+	{ NULL }
+};
+
+static xml_document_t *
+bench_properties(unsigned int count)
+{
+	ni_stringbuf_t buf = NI_STRINGBUF_INIT_DYNAMIC;
+	xml_document_t *doc;
+	unsigned int i, a;
+
+	ni_stringbuf_puts(&buf, "<objects>\n");
+	for (i = 0; i < count; ++i) {
+		ni_stringbuf_printf(&buf,
+			"<object>\n"
+			" <interface>\n"
+			"  <name>eth%u</name>\n"
+			"  <status>device-up, link-up, network-up, broadcast, multicast</status>\n"
+			"  <link-type>ethernet</link-type>\n"
+			"  <index>%u</index>\n"
+			"  <metric>0</metric>\n"
+			"  <txqlen>1000</txqlen>\n"
+			"  <mtu>1500</mtu>\n"
+			"  <ipv4><enabled>true</enabled><forwarding>false</forwarding></ipv4>\n"
+			"  <ipv6><enabled>true</enabled><forwarding>false</forwarding></ipv6>\n"
+			"  <addresses>\n",
+			i, i + 2);
+		for (a = 0; a < 4; ++a) {
+			ni_stringbuf_printf(&buf,
+			"   <assigned-address>\n"
+			"    <local>10.%u.%u.%u/24</local>\n"
+			"    <broadcast>10.%u.%u.255</broadcast>\n"
+			"    <scope>universe</scope>\n"
+			"    <flags>128</flags>\n"
+			"    <cache-info><valid-lifetime>4294967295</valid-lifetime>"
+				"<preferred-lifetime>4294967295</preferred-lifetime></cache-info>\n"
+			"    <owner>static</owner>\n"
+			"   </assigned-address>\n",
+			i / 256, i % 256, a + 1, i / 256, i % 256);
+		}
+		ni_stringbuf_printf(&buf,
+			"  </addresses>\n"
+			"  <routes>\n"
+			"   <assigned-route>\n"
+			"    <destination>10.%u.%u.0/24</destination>\n"
+			"    <pref-source>10.%u.%u.1</pref-source>\n"
+			"    <priority>100</priority>\n"
+			"    <kern><table>main</table><type>unicast</type><scope>link</scope>"
+				"<protocol>kernel</protocol></kern>\n"
+			"    <owner>static</owner>\n"
+			"   </assigned-route>\n"
+			"  </routes>\n"
+			" </interface>\n"
+			" <ethernet>\n"
+			"  <address>02:00:00:00:%02x:%02x</address>\n"
+			"  <permanent-address>02:00:00:00:%02x:%02x</permanent-address>\n"
+			" </ethernet>\n"
+			"</object>\n",
+			i / 256, i % 256, i / 256, i % 256,
+			(i >> 8) & 0xff, i & 0xff, (i >> 8) & 0xff, i & 0xff);
+	}
+	ni_stringbuf_puts(&buf, "</objects>\n");
+
+	doc = xml_document_from_string(buf.string, "bench");
+	ni_stringbuf_destroy(&buf);
+	return doc;
+}
+
+static char *
+bench_children_sprint(const xml_node_t *node)
+{
+	ni_stringbuf_t buf = NI_STRINGBUF_INIT_DYNAMIC;
+	const xml_node_t *child;
+	char *str;
+
+	for (child = node->children; child; child = child->next) {
+		if ((str = xml_node_sprint(child)))
+			ni_stringbuf_puts(&buf, str);
+		free(str);
+	}
+	return buf.string;
+}
+
+static double
+bench_usecs(const struct timeval *beg, const struct timeval *end)
+{
+	return (end->tv_sec - beg->tv_sec) * 1e6 + (end->tv_usec - beg->tv_usec);
+}
+
+int
+main(int argc, char **argv)
+{
+	const char *filename = WICKED_SCHEMADIR "/wicked.xml";
+	unsigned int count = 2000, rounds = 5, nprops, r, i;
+	double ser = 0, deser = 0;
+	ni_dbus_variant_t *vars;
+	xml_node_t *object, *prop, **props, **nodes;
+	xml_document_t *doc;
+	struct timeval beg, end;
+	ni_xs_scope_t *schema;
+	int c, ret = 0;
+
+	while ((c = getopt(argc, argv, "n:r:")) != EOF) {
+		switch (c) {
+		case 'n':
+			count = strtoul(optarg, NULL, 0);
+			break;
+		case 'r':
+			rounds = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-n interfaces] [-r rounds] [schema-file]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (optind < argc)
+		filename = argv[optind];
+	if (!count || !rounds)
+		return 1;
+
+	ni_log_init();
+
+	schema = ni_dbus_xml_init();
+	if (ni_xs_process_schema_file(filename, schema) < 0) {
+		fprintf(stderr, "Cannot load schema %s\n", filename);
+		return 77;
+	}
+
+	doc = bench_properties(count);
+	if (!doc || !doc->root || !doc->root->children) {
+		fprintf(stderr, "Cannot generate interface properties\n");
+		return 1;
+	}
+
+	props = xcalloc(2 * count, sizeof(props[0]));
+	object = doc->root->children->children;
+	for (nprops = 0; object; object = object->next) {
+		for (prop = object->children; prop; prop = prop->next) {
+			for (i = 0; bench_services[i].name; ++i) {
+				if (ni_string_eq(prop->name, bench_services[i].name))
+					ni_string_dup(&prop->name, bench_services[i].interface);
+			}
+			props[nprops++] = prop;
+		}
+	}
+	vars = xcalloc(nprops, sizeof(vars[0]));
+	nodes = xcalloc(nprops, sizeof(nodes[0]));
+
+	for (r = 0; r < rounds; ++r) {
+		gettimeofday(&beg, NULL);
+		for (i = 0; i < nprops; ++i) {
+			if (ni_dbus_xml_serialize_properties(schema, &vars[i], props[i]) < 0) {
+				fprintf(stderr, "Cannot serialize %s properties\n", props[i]->name);
+				return 1;
+			}
+		}
+		gettimeofday(&end, NULL);
+		ser += bench_usecs(&beg, &end);
+
+		gettimeofday(&beg, NULL);
+		for (i = 0; i < nprops; ++i) {
+			nodes[i] = ni_dbus_xml_deserialize_properties(schema, props[i]->name, &vars[i], NULL);
+			if (!nodes[i]) {
+				fprintf(stderr, "Cannot deserialize %s properties\n", props[i]->name);
+				return 1;
+			}
+		}
+		gettimeofday(&end, NULL);
+		deser += bench_usecs(&beg, &end);
+
+		if (r == 0) {
+			for (i = 0; i < nprops; ++i) {
+				char *orig = bench_children_sprint(props[i]);
+				char *copy = bench_children_sprint(nodes[i]);
+
+				if (!ni_string_eq(orig, copy)) {
+					fprintf(stderr, "%s properties differ after conversion:\n%s\n--\n%s\n",
+							props[i]->name, orig, copy);
+					ret = 1;
+				}
+				free(orig);
+				free(copy);
+				if (ret)
+					break;
+			}
+		}
+
+		for (i = 0; i < nprops; ++i) {
+			ni_dbus_variant_destroy(&vars[i]);
+			xml_node_free(nodes[i]);
+		}
+	}
+
+	printf("%u interfaces, %u property sets, %u rounds\n", count, nprops, rounds);
+	printf("  xml -> dbus: %10.1f usec/round, %6.2f usec/set\n", ser / rounds, ser / rounds / nprops);
+	printf("  dbus -> xml: %10.1f usec/round, %6.2f usec/set\n", deser / rounds, deser / rounds / nprops);
+	printf("%s\n", ret ? "FAILED" : "OK");
+
+	free(nodes);
+	free(vars);
+	free(props);
+	xml_document_free(doc);
+	return ret;
+}
@@ -0,0 +1,1425 @@
+/*
+ *	DHCPv4/DHCPv6 client scale test over veth pairs
+ *
+ *	Copyright (C) 2026 SUSE Linux GmbH, Nuernberg, Germany.
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	This program is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along
+ *	with this program; if not, see <http://www.gnu.org/licenses/> or write
+ *	to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *	Boston, MA 02110-1301 USA.
+ *
+ *	Usage:
+ *		dhcp-scale-test [-d] [-4|-6] [-n <clients>] [-r <renewals>]
+ *				[-T <renew-time>] [-t <timeout>]
+ *
+ *	Creates <clients> veth pairs in a private network namespace and
+ *	moves the peer ends into a second one, where a forked minimal
+ *	DHCPv4/DHCPv6 responder answers on all of them using a single
+ *	packet socket. The client ends are run by the in-process dhcp4
+ *	and dhcp6 supplicants, which acquire, renew <renewals> times and
+ *	finally release their leases concurrently.
+ *
+ *	Reports the per phase latency distribution, the packet rate seen
+ *	by the responder and the cpu time used by the supplicants and by
+ *	the responder. Exits with 77 (skipped) when not permitted to
+ *	create network namespaces.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <poll.h>
+#include <dirent.h>
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <net/if.h>
+#include <net/if_arp.h>
+#include <net/ethernet.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <netinet/ip6.h>
+#include <netinet/udp.h>
+#include <arpa/inet.h>
+#include <linux/if_packet.h>
+#include <linux/veth.h>
+#include <netlink/netlink.h>
+#include <netlink/msg.h>
+
+#include <wicked/netinfo.h>
+#include <wicked/logging.h>
+#include <wicked/socket.h>
+#include <wicked/system.h>
+#include <wicked/addrconf.h>
+
+#include "netinfo_priv.h"
+#include "appconfig.h"
+#include "kernel.h"
+#include "buffer.h"
+#include "dhcp4/dhcp4.h"
+#include "dhcp4/protocol.h"
+#include "dhcp6/dhcp6.h"
+#include "dhcp6/protocol.h"
+#include "dhcp6/options.h"
+
+#define SCALE_CLIENT_IFNAME		"dsc%u"
+#define SCALE_SERVER_IFNAME		"dsp%u"
+
+#define SCALE_DHCP4_SERVER_ID		0x0a000001	/* 10.0.0.1		*/
+#define SCALE_DHCP4_NETWORK		0x0a010000	/* 10.1.0.0 + ifindex	*/
+#define SCALE_DHCP4_NETMASK		0xff000000	/* /8			*/
+#define SCALE_DHCP6_NETWORK		"fd00:5ca1:e::"	/* + ifindex		*/
+
+#define SCALE_LINK_TIMEOUT		10		/* sec			*/
+
+enum {
+	SCALE_DHCP4,
+	SCALE_DHCP6,
+
+	SCALE_FAMILY_MAX
+};
+
+enum {
+	SCALE_PHASE_ACQUIRE,
+	SCALE_PHASE_RENEW,
+	SCALE_PHASE_RELEASE,
+	SCALE_PHASE_DONE,
+
+	SCALE_PHASE_MAX = SCALE_PHASE_DONE
+};
+
+static const char *	scale_family_names[SCALE_FAMILY_MAX] = {
+	"dhcp4", "dhcp6"
+};
+static const char *	scale_phase_names[SCALE_PHASE_MAX] = {
+	"acquire", "renew", "release"
+};
+
+typedef struct scale_client	scale_client_t;
+
+typedef struct scale_state {
+	scale_client_t *	client;
+	unsigned int		family;
+
+	unsigned int		phase;
+	unsigned int		renewals;
+	struct timeval		start;		/* phase start or renew due time */
+	const ni_timer_t *	timer;
+	ni_bool_t		failed;
+} scale_state_t;
+
+struct scale_client {
+	char			ifname[IFNAMSIZ];
+	unsigned int		ifindex;
+
+	ni_dhcp4_device_t *	dev4;
+	ni_dhcp6_device_t *	dev6;
+	ni_uuid_t		uuid;
+
+	scale_state_t		state[SCALE_FAMILY_MAX];
+};
+
+typedef struct scale_samples {
+	unsigned int		count;
+	double *		data;
+} scale_samples_t;
+
+typedef struct scale_responder_stats {
+	unsigned long		rx;
+	unsigned long		tx;
+	unsigned long		arp;
+	unsigned long		dhcp4[DHCP4_INFORM + 1];
+	unsigned long		dhcp6[NI_DHCP6_INFO_REQUEST + 1];
+	struct timeval		utime;
+	struct timeval		stime;
+} scale_responder_stats_t;
+
+typedef struct scale_responder_link {
+	ni_bool_t		valid;
+	unsigned char		hwaddr[ETH_ALEN];
+} scale_responder_link_t;
+
+typedef struct scale_responder {
+	int			fd;
+	unsigned int		nlinks;
+	scale_responder_link_t *links;
+	scale_responder_stats_t	stats;
+} scale_responder_t;
+
+static struct scale_options {
+	unsigned int		count;
+	unsigned int		renewals;
+	unsigned int		renew_time;
+	unsigned int		timeout;
+	ni_bool_t		family[SCALE_FAMILY_MAX];
+} opts = {
+	.count		= 16,
+	.renewals	= 1,
+	.renew_time	= 2,
+	.timeout	= 60,
+	.family		= { TRUE, TRUE },
+};
+
+static scale_client_t *		clients;
+static scale_client_t **	clients_by_index;
+static unsigned int		clients_max_index;
+static unsigned int		clients_pending;
+static scale_samples_t		samples[SCALE_FAMILY_MAX][SCALE_PHASE_MAX];
+
+/*
+ * Helpers
+ */
+static double
+scale_timeval_msec(const struct timeval *tv)
+{
+	return tv->tv_sec * 1000.0 + tv->tv_usec / 1000.0;
+}
+
+static double
+scale_elapsed_msec(const struct timeval *beg, const struct timeval *end)
+{
+	return scale_timeval_msec(end) - scale_timeval_msec(beg);
+}
+
+static void
+scale_samples_add(scale_samples_t *s, double value)
+{
+	if ((s->count % 64) == 0)
+		s->data = xrealloc(s->data, (s->count + 64) * sizeof(double));
+	s->data[s->count++] = value;
+}
+
+static int
+scale_samples_cmp(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static double
+scale_samples_percentile(const scale_samples_t *s, unsigned int pct)
+{
+	unsigned int idx;
+
+	if (!s->count)
+		return 0.0;
+	idx = (s->count * pct + 99) / 100;
+	return s->data[idx ? idx - 1 : 0];
+}
+
+static int
+scale_sysctl_set(const char *path, const char *value)
+{
+	int fd, ret = 0;
+
+	if ((fd = open(path, O_WRONLY)) < 0)
+		return -1;
+	if (write(fd, value, strlen(value)) < 0)
+		ret = -1;
+	close(fd);
+	return ret;
+}
+
+static void
+scale_sysctl_setup(void)
+{
+	/* no DAD delays on the link-local addresses and no RA/RS noise */
+	scale_sysctl_set("/proc/sys/net/ipv6/conf/default/accept_dad", "0");
+	scale_sysctl_set("/proc/sys/net/ipv6/conf/default/accept_ra", "0");
+	scale_sysctl_set("/proc/sys/net/ipv6/conf/default/router_solicitations", "0");
+}
+
+static int
+scale_link_set_up(int sock, const char *ifname)
+{
+	struct ifreq ifr;
+
+	memset(&ifr, 0, sizeof(ifr));
+	strncpy(ifr.ifr_name, ifname, sizeof(ifr.ifr_name) - 1);
+	if (ioctl(sock, SIOCGIFFLAGS, &ifr) < 0)
+		return -1;
+	ifr.ifr_flags |= IFF_UP;
+	return ioctl(sock, SIOCSIFFLAGS, &ifr);
+}
+
+/*
+ * Responder, running in the peer network namespace
+ */
+static scale_responder_link_t *
+scale_responder_link(scale_responder_t *srv, unsigned int ifindex)
+{
+	scale_responder_link_t *link;
+	struct ifreq ifr;
+
+	if (ifindex >= srv->nlinks) {
+		unsigned int n = ifindex + 256;
+
+		srv->links = xrealloc(srv->links, n * sizeof(*srv->links));
+		memset(srv->links + srv->nlinks, 0, (n - srv->nlinks) * sizeof(*srv->links));
+		srv->nlinks = n;
+	}
+
+	link = &srv->links[ifindex];
+	if (!link->valid) {
+		memset(&ifr, 0, sizeof(ifr));
+		if (!if_indextoname(ifindex, ifr.ifr_name))
+			return NULL;
+		if (ioctl(srv->fd, SIOCGIFHWADDR, &ifr) < 0)
+			return NULL;
+		memcpy(link->hwaddr, ifr.ifr_hwaddr.sa_data, ETH_ALEN);
+		link->valid = TRUE;
+	}
+	return link;
+}
+
+static void
+scale_responder_send(scale_responder_t *srv, const struct sockaddr_ll *from,
+			uint16_t protocol, const void *data, size_t len)
+{
+	struct sockaddr_ll sll;
+
+	memset(&sll, 0, sizeof(sll));
+	sll.sll_family = AF_PACKET;
+	sll.sll_protocol = htons(protocol);
+	sll.sll_ifindex = from->sll_ifindex;
+	sll.sll_halen = ETH_ALEN;
+	memcpy(sll.sll_addr, from->sll_addr, ETH_ALEN);
+
+	if (sendto(srv->fd, data, len, 0, (struct sockaddr *)&sll, sizeof(sll)) < 0)
+		ni_error("responder: sendto failed: %m");
+	else
+		srv->stats.tx++;
+}
+
+static void
+scale_responder_arp(scale_responder_t *srv, const struct sockaddr_ll *from,
+			const unsigned char *pkt, size_t len)
+{
+	const scale_responder_link_t *link;
+	unsigned char reply[sizeof(struct arphdr) + 2 * (ETH_ALEN + 4)];
+	const struct arphdr *arp = (const struct arphdr *)pkt;
+	const unsigned char *sha, *spa, *tpa;
+	struct arphdr *hdr = (struct arphdr *)reply;
+	uint32_t server_id = htonl(SCALE_DHCP4_SERVER_ID);
+
+	if (len < sizeof(reply) || ntohs(arp->ar_op) != ARPOP_REQUEST ||
+	    arp->ar_hln != ETH_ALEN || arp->ar_pln != 4)
+		return;
+
+	sha = pkt + sizeof(*arp);
+	spa = sha + ETH_ALEN;
+	tpa = spa + 4 + ETH_ALEN;
+	if (memcmp(tpa, &server_id, 4))
+		return;
+
+	if (!(link = scale_responder_link(srv, from->sll_ifindex)))
+		return;
+
+	srv->stats.arp++;
+	memcpy(hdr, arp, sizeof(*hdr));
+	hdr->ar_op = htons(ARPOP_REPLY);
+	memcpy(reply + sizeof(*hdr), link->hwaddr, ETH_ALEN);
+	memcpy(reply + sizeof(*hdr) + ETH_ALEN, &server_id, 4);
+	memcpy(reply + sizeof(*hdr) + ETH_ALEN + 4, sha, ETH_ALEN + 4);
+	scale_responder_send(srv, from, ETH_P_ARP, reply, sizeof(reply));
+}
+
+static void
+scale_dhcp4_option_put(ni_buffer_t *bp, unsigned int code, const void *data, size_t len)
+{
+	ni_buffer_putc(bp, code);
+	ni_buffer_putc(bp, len);
+	ni_buffer_put(bp, data, len);
+}
+
+static void
+scale_dhcp4_option_put_u32(ni_buffer_t *bp, unsigned int code, uint32_t value)
+{
+	value = htonl(value);
+	scale_dhcp4_option_put(bp, code, &value, sizeof(value));
+}
+
+static void
+scale_responder_dhcp4(scale_responder_t *srv, const struct sockaddr_ll *from,
+			const unsigned char *pkt, size_t len)
+{
+	const struct ip *ip = (const struct ip *)pkt;
+	const struct udphdr *udp;
+	const ni_dhcp4_message_t *msg;
+	const unsigned char *opt, *end;
+	unsigned int type = 0, hlen, ulen;
+	uint32_t server_id = 0, requested = 0, address;
+	unsigned char frame[1024] __attribute__((aligned(8)));
+	ni_dhcp4_message_t *reply;
+	struct in_addr src, dst;
+	ni_buffer_t buf;
+
+	if (len < sizeof(*ip) || ip->ip_v != 4 || ip->ip_p != IPPROTO_UDP)
+		return;
+	hlen = ip->ip_hl * 4;
+	if (len < hlen + sizeof(*udp))
+		return;
+	udp = (const struct udphdr *)(pkt + hlen);
+	ulen = ntohs(udp->uh_ulen);
+	if (ntohs(udp->uh_dport) != DHCP4_SERVER_PORT || ulen < sizeof(*udp) + sizeof(*msg) ||
+	    hlen + ulen > len)
+		return;
+
+	msg = (const ni_dhcp4_message_t *)(udp + 1);
+	if (msg->op != DHCP4_BOOTREQUEST || msg->cookie != htonl(MAGIC_COOKIE))
+		return;
+
+	end = (const unsigned char *)udp + ulen;
+	for (opt = (const unsigned char *)(msg + 1); opt < end && *opt != DHCP4_END; ) {
+		if (*opt == DHCP4_PAD) {
+			opt++;
+			continue;
+		}
+		if (opt + 2 > end || opt + 2 + opt[1] > end)
+			return;
+		if (opt[0] == DHCP4_MESSAGETYPE && opt[1] == 1)
+			type = opt[2];
+		else if (opt[0] == DHCP4_SERVERIDENTIFIER && opt[1] == 4)
+			memcpy(&server_id, opt + 2, 4);
+		else if (opt[0] == DHCP4_ADDRESS && opt[1] == 4)
+			memcpy(&requested, opt + 2, 4);
+		opt += 2 + opt[1];
+	}
+	if (!type || type > DHCP4_INFORM)
+		return;
+	srv->stats.dhcp4[type]++;
+
+	address = htonl(SCALE_DHCP4_NETWORK + from->sll_ifindex);
+	switch (type) {
+	case DHCP4_DISCOVER:
+		type = DHCP4_OFFER;
+		break;
+	case DHCP4_REQUEST:
+		if (server_id && server_id != htonl(SCALE_DHCP4_SERVER_ID))
+			return;
+		if (requested != address && msg->ciaddr != address)
+			type = DHCP4_NAK;
+		else
+			type = DHCP4_ACK;
+		break;
+	default:
+		return;
+	}
+
+	ni_buffer_init(&buf, frame, sizeof(frame));
+	if (ni_buffer_reserve_head(&buf, sizeof(struct ip) + sizeof(struct udphdr)) < 0)
+		return;
+	if (!(reply = ni_buffer_push_tail(&buf, sizeof(*reply))))
+		return;
+	memset(reply, 0, sizeof(*reply));
+	reply->op = DHCP4_BOOTREPLY;
+	reply->hwtype = msg->hwtype;
+	reply->hwlen = msg->hwlen;
+	reply->xid = msg->xid;
+	reply->flags = msg->flags;
+	reply->ciaddr = msg->ciaddr;
+	if (type != DHCP4_NAK)
+		reply->yiaddr = address;
+	memcpy(reply->chaddr, msg->chaddr, sizeof(reply->chaddr));
+	reply->cookie = htonl(MAGIC_COOKIE);
+
+	ni_buffer_putc(&buf, DHCP4_MESSAGETYPE);
+	ni_buffer_putc(&buf, 1);
+	ni_buffer_putc(&buf, type);
+	scale_dhcp4_option_put_u32(&buf, DHCP4_SERVERIDENTIFIER, SCALE_DHCP4_SERVER_ID);
+	if (type != DHCP4_NAK) {
+		scale_dhcp4_option_put_u32(&buf, DHCP4_LEASETIME, opts.renew_time * 30);
+		scale_dhcp4_option_put_u32(&buf, DHCP4_RENEWALTIME, opts.renew_time);
+		scale_dhcp4_option_put_u32(&buf, DHCP4_REBINDTIME, opts.renew_time * 20);
+		scale_dhcp4_option_put_u32(&buf, DHCP4_NETMASK, SCALE_DHCP4_NETMASK);
+	}
+	ni_buffer_putc(&buf, DHCP4_END);
+
+	src.s_addr = htonl(SCALE_DHCP4_SERVER_ID);
+	dst.s_addr = type == DHCP4_NAK ? htonl(INADDR_BROADCAST) : address;
+	if (ni_capture_build_udp_header(&buf, src, DHCP4_SERVER_PORT, dst, DHCP4_CLIENT_PORT) < 0)
+		return;
+
+	scale_responder_send(srv, from, ETH_P_IP, ni_buffer_head(&buf), ni_buffer_count(&buf));
+}
+
+static void
+scale_dhcp6_option_put(ni_buffer_t *bp, unsigned int code, const void *data, size_t len)
+{
+	uint16_t hdr[2];
+
+	hdr[0] = htons(code);
+	hdr[1] = htons(len);
+	ni_buffer_put(bp, hdr, sizeof(hdr));
+	if (len)
+		ni_buffer_put(bp, data, len);
+}
+
+static uint16_t
+scale_udp6_checksum(const struct ip6_hdr *ip6, const void *data, size_t len)
+{
+	const uint8_t *ptr;
+	uint32_t sum = 0;
+	size_t i;
+
+	ptr = (const uint8_t *)&ip6->ip6_src;
+	for (i = 0; i < 2 * sizeof(struct in6_addr); i += 2)
+		sum += (ptr[i] << 8) | ptr[i + 1];
+	sum += len;
+	sum += IPPROTO_UDP;
+
+	ptr = data;
+	for (i = 0; i + 1 < len; i += 2)
+		sum += (ptr[i] << 8) | ptr[i + 1];
+	if (len & 1)
+		sum += ptr[len - 1] << 8;
+
+	while (sum >> 16)
+		sum = (sum & 0xffff) + (sum >> 16);
+	sum = ~sum & 0xffff;
+	return htons(sum ? sum : 0xffff);
+}
+
+static void
+scale_responder_dhcp6(scale_responder_t *srv, const struct sockaddr_ll *from,
+			const unsigned char *pkt, size_t len)
+{
+	const struct ip6_hdr *ip6 = (const struct ip6_hdr *)pkt;
+	const scale_responder_link_t *link;
+	const struct udphdr *udp;
+	const unsigned char *msg, *opt, *end;
+	const unsigned char *clientid = NULL, *serverid = NULL;
+	unsigned int type, ulen, clientid_len = 0, serverid_len = 0;
+	unsigned char duid[4 + ETH_ALEN], ia[12 + 4 + 24];
+	unsigned char frame[1024] __attribute__((aligned(8)));
+	struct in6_addr address;
+	uint32_t iaid = 0, val;
+	uint16_t status = 0;
+	struct ip6_hdr *rip6;
+	struct udphdr *rudp;
+	ni_bool_t have_ia = FALSE;
+	ni_buffer_t buf;
+
+	if (len < sizeof(*ip6) + sizeof(*udp) || ip6->ip6_nxt != IPPROTO_UDP)
+		return;
+	udp = (const struct udphdr *)(ip6 + 1);
+	ulen = ntohs(udp->uh_ulen);
+	if (ntohs(udp->uh_dport) != NI_DHCP6_SERVER_PORT || ulen < sizeof(*udp) + 4 ||
+	    sizeof(*ip6) + ulen > len)
+		return;
+
+	msg = (const unsigned char *)(udp + 1);
+	end = (const unsigned char *)udp + ulen;
+	type = msg[0];
+	if (!type || type > NI_DHCP6_INFO_REQUEST)
+		return;
+	srv->stats.dhcp6[type]++;
+
+	for (opt = msg + 4; opt + 4 <= end; ) {
+		unsigned int code = (opt[0] << 8) | opt[1];
+		unsigned int olen = (opt[2] << 8) | opt[3];
+
+		if (opt + 4 + olen > end)
+			return;
+		switch (code) {
+		case NI_DHCP6_OPTION_CLIENTID:
+			clientid = opt + 4;
+			clientid_len = olen;
+			break;
+		case NI_DHCP6_OPTION_SERVERID:
+			serverid = opt + 4;
+			serverid_len = olen;
+			break;
+		case NI_DHCP6_OPTION_IA_NA:
+			if (olen >= 12 && !have_ia) {
+				memcpy(&iaid, opt + 4, 4);
+				have_ia = TRUE;
+			}
+			break;
+		default:
+			break;
+		}
+		opt += 4 + olen;
+	}
+	if (!clientid)
+		return;
+
+	if (!(link = scale_responder_link(srv, from->sll_ifindex)))
+		return;
+
+	/* DUID-LL of the link we're answering on */
+	duid[0] = 0;
+	duid[1] = 3;
+	duid[2] = 0;
+	duid[3] = ARPHRD_ETHER;
+	memcpy(duid + 4, link->hwaddr, ETH_ALEN);
+
+	switch (type) {
+	case NI_DHCP6_SOLICIT:
+		if (!have_ia)
+			return;
+		type = NI_DHCP6_ADVERTISE;
+		break;
+	case NI_DHCP6_REQUEST:
+	case NI_DHCP6_RENEW:
+	case NI_DHCP6_RELEASE:
+		if (serverid_len != sizeof(duid) || memcmp(serverid, duid, sizeof(duid)))
+			return;
+		/* fall through */
+	case NI_DHCP6_REBIND:
+		if (type != NI_DHCP6_RELEASE && !have_ia)
+			return;
+		if (type == NI_DHCP6_RELEASE)
+			have_ia = FALSE;
+		type = NI_DHCP6_REPLY;
+		break;
+	default:
+		return;
+	}
+
+	/* room for the ipv6 and udp headers prepended below */
+	ni_buffer_init(&buf, frame, sizeof(frame));
+	if (ni_buffer_reserve_head(&buf, sizeof(struct ip6_hdr) + sizeof(struct udphdr)) < 0)
+		return;
+	ni_buffer_putc(&buf, type);
+	ni_buffer_put(&buf, msg + 1, 3);
+	scale_dhcp6_option_put(&buf, NI_DHCP6_OPTION_SERVERID, duid, sizeof(duid));
+	scale_dhcp6_option_put(&buf, NI_DHCP6_OPTION_CLIENTID, clientid, clientid_len);
+	if (type == NI_DHCP6_ADVERTISE) {
+		unsigned char pref = 255;
+		scale_dhcp6_option_put(&buf, NI_DHCP6_OPTION_PREFERENCE, &pref, 1);
+	}
+	if (have_ia) {
+		inet_pton(AF_INET6, SCALE_DHCP6_NETWORK, &address);
+		val = htonl(from->sll_ifindex);
+		memcpy(&address.s6_addr[12], &val, 4);
+
+		memcpy(ia, &iaid, 4);
+		val = htonl(opts.renew_time);
+		memcpy(ia + 4, &val, 4);
+		val = htonl(opts.renew_time * 20);
+		memcpy(ia + 8, &val, 4);
+		ia[12] = 0;
+		ia[13] = NI_DHCP6_OPTION_IA_ADDRESS;
+		ia[14] = 0;
+		ia[15] = 24;
+		memcpy(ia + 16, &address, 16);
+		val = htonl(opts.renew_time * 30);
+		memcpy(ia + 32, &val, 4);
+		memcpy(ia + 36, &val, 4);
+		scale_dhcp6_option_put(&buf, NI_DHCP6_OPTION_IA_NA, ia, sizeof(ia));
+	} else {
+		scale_dhcp6_option_put(&buf, NI_DHCP6_OPTION_STATUS_CODE, &status, sizeof(status));
+	}
+
+	if (buf.overflow || !(rudp = ni_buffer_push_head(&buf, sizeof(*rudp))))
+		return;
+	rudp->uh_sport = htons(NI_DHCP6_SERVER_PORT);
+	rudp->uh_dport = htons(NI_DHCP6_CLIENT_PORT);
+	rudp->uh_ulen = htons(ni_buffer_count(&buf));
+	rudp->uh_sum = 0;
+
+	if (!(rip6 = ni_buffer_push_head(&buf, sizeof(*rip6))))
+		return;
+	memset(rip6, 0, sizeof(*rip6));
+	rip6->ip6_flow = htonl(6 << 28);
+	rip6->ip6_plen = rudp->uh_ulen;
+	rip6->ip6_nxt = IPPROTO_UDP;
+	rip6->ip6_hops = 255;
+	rip6->ip6_dst = ip6->ip6_src;
+	/* fe80::/64 + modified EUI-64 of the link */
+	rip6->ip6_src.s6_addr[0] = 0xfe;
+	rip6->ip6_src.s6_addr[1] = 0x80;
+	rip6->ip6_src.s6_addr[8] = link->hwaddr[0] ^ 0x02;
+	rip6->ip6_src.s6_addr[9] = link->hwaddr[1];
+	rip6->ip6_src.s6_addr[10] = link->hwaddr[2];
+	rip6->ip6_src.s6_addr[11] = 0xff;
+	rip6->ip6_src.s6_addr[12] = 0xfe;
+	rip6->ip6_src.s6_addr[13] = link->hwaddr[3];
+	rip6->ip6_src.s6_addr[14] = link->hwaddr[4];
+	rip6->ip6_src.s6_addr[15] = link->hwaddr[5];
+	rudp->uh_sum = scale_udp6_checksum(rip6, rudp, ntohs(rudp->uh_ulen));
+
+	scale_responder_send(srv, from, ETH_P_IPV6, ni_buffer_head(&buf), ni_buffer_count(&buf));
+}
+
+static void
+scale_responder_recv(scale_responder_t *srv)
+{
+	unsigned char pkt[2048] __attribute__((aligned(8)));
+	struct sockaddr_ll sll;
+	socklen_t slen;
+	ssize_t len;
+
+	while (TRUE) {
+		slen = sizeof(sll);
+		len = recvfrom(srv->fd, pkt, sizeof(pkt), MSG_DONTWAIT,
+				(struct sockaddr *)&sll, &slen);
+		if (len < 0)
+			return;
+		if (sll.sll_pkttype == PACKET_OUTGOING)
+			continue;
+
+		srv->stats.rx++;
+		switch (ntohs(sll.sll_protocol)) {
+		case ETH_P_ARP:
+			scale_responder_arp(srv, &sll, pkt, len);
+			break;
+		case ETH_P_IP:
+			scale_responder_dhcp4(srv, &sll, pkt, len);
+			break;
+		case ETH_P_IPV6:
+			scale_responder_dhcp6(srv, &sll, pkt, len);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+static int
+scale_responder_links_up(scale_responder_t *srv)
+{
+	struct if_nameindex *ifs, *ifp;
+	int ret = 0;
+
+	if (!(ifs = if_nameindex()))
+		return -1;
+	for (ifp = ifs; ifp->if_index; ++ifp) {
+		if (scale_link_set_up(srv->fd, ifp->if_name) < 0) {
+			ni_error("responder: cannot set %s up: %m", ifp->if_name);
+			ret = -1;
+		}
+	}
+	if_freenameindex(ifs);
+	return ret;
+}
+
+static int
+scale_responder_run(int ctl)
+{
+	scale_responder_t srv;
+	struct pollfd pfd[2];
+	struct rusage ru;
+	char cc = 0;
+	int bufsize = 4 << 20;
+
+	memset(&srv, 0, sizeof(srv));
+	if (unshare(CLONE_NEWNET) < 0)
+		return 1;
+	scale_sysctl_setup();
+
+	srv.fd = socket(AF_PACKET, SOCK_DGRAM, htons(ETH_P_ALL));
+	if (srv.fd < 0)
+		return 1;
+	setsockopt(srv.fd, SOL_SOCKET, SO_RCVBUF, &bufsize, sizeof(bufsize));
+
+	/* namespace ready, wait until the peers are moved in */
+	if (write(ctl, &cc, 1) != 1 || read(ctl, &cc, 1) != 1)
+		return 1;
+	if (scale_responder_links_up(&srv) < 0)
+		return 1;
+	if (write(ctl, &cc, 1) != 1)
+		return 1;
+
+	pfd[0].fd = srv.fd;
+	pfd[0].events = POLLIN;
+	pfd[1].fd = ctl;
+	pfd[1].events = POLLIN;
+	while (poll(pfd, 2, -1) >= 0 || errno == EINTR) {
+		if (pfd[0].revents & POLLIN)
+			scale_responder_recv(&srv);
+		if (pfd[1].revents)
+			break;
+	}
+
+	getrusage(RUSAGE_SELF, &ru);
+	srv.stats.utime = ru.ru_utime;
+	srv.stats.stime = ru.ru_stime;
+	if (write(ctl, &srv.stats, sizeof(srv.stats)) != sizeof(srv.stats))
+		return 1;
+	return 0;
+}
+
+/*
+ * Client side network namespace setup
+ */
+static int
+scale_veth_create(const char *ifname, const char *peer, pid_t netns_pid)
+{
+	struct nlattr *linkinfo, *infodata, *peerinfo;
+	struct ifinfomsg ifi;
+	struct nl_msg *msg;
+	int err;
+
+	memset(&ifi, 0, sizeof(ifi));
+	ifi.ifi_family = AF_UNSPEC;
+
+	msg = nlmsg_alloc_simple(RTM_NEWLINK, NLM_F_CREATE | NLM_F_EXCL);
+	if (nlmsg_append(msg, &ifi, sizeof(ifi), NLMSG_ALIGNTO) < 0)
+		goto nla_put_failure;
+
+	NLA_PUT_STRING(msg, IFLA_IFNAME, ifname);
+	if (!(linkinfo = nla_nest_start(msg, IFLA_LINKINFO)))
+		goto nla_put_failure;
+	NLA_PUT_STRING(msg, IFLA_INFO_KIND, "veth");
+	if (!(infodata = nla_nest_start(msg, IFLA_INFO_DATA)))
+		goto nla_put_failure;
+	if (!(peerinfo = nla_nest_start(msg, VETH_INFO_PEER)))
+		goto nla_put_failure;
+	if (nlmsg_append(msg, &ifi, sizeof(ifi), NLMSG_ALIGNTO) < 0)
+		goto nla_put_failure;
+	NLA_PUT_STRING(msg, IFLA_IFNAME, peer);
+	NLA_PUT_U32(msg, IFLA_NET_NS_PID, netns_pid);
+	nla_nest_end(msg, peerinfo);
+	nla_nest_end(msg, infodata);
+	nla_nest_end(msg, linkinfo);
+
+	if ((err = ni_nl_talk(msg, NULL)) < 0)
+		ni_error("%s: cannot create veth with peer %s: %s",
+				ifname, peer, ni_strerror(err));
+	nlmsg_free(msg);
+	return err;
+
+nla_put_failure:
+	ni_error("%s: failed to encode netlink message", ifname);
+	nlmsg_free(msg);
+	return -1;
+}
+
+static int
+scale_address_add(unsigned int ifindex, struct in_addr addr, struct in_addr mask)
+{
+	ni_netconfig_t *nc = ni_global_state_handle(0);
+	struct ifaddrmsg ifa;
+	struct nl_msg *msg;
+	ni_netdev_t *ifp;
+	int err;
+
+	memset(&ifa, 0, sizeof(ifa));
+	ifa.ifa_family = AF_INET;
+	ifa.ifa_prefixlen = __builtin_popcount(mask.s_addr);
+	ifa.ifa_scope = RT_SCOPE_UNIVERSE;
+	ifa.ifa_index = ifindex;
+
+	msg = nlmsg_alloc_simple(RTM_NEWADDR, NLM_F_CREATE | NLM_F_REPLACE);
+	if (nlmsg_append(msg, &ifa, sizeof(ifa), NLMSG_ALIGNTO) < 0)
+		goto nla_put_failure;
+	NLA_PUT(msg, IFA_LOCAL, sizeof(addr), &addr);
+	NLA_PUT(msg, IFA_ADDRESS, sizeof(addr), &addr);
+
+	err = ni_nl_talk(msg, NULL);
+	nlmsg_free(msg);
+
+	/* we don't listen to events, but the supplicant checks the address */
+	if (err == 0 && (ifp = ni_netdev_by_index(nc, ifindex)))
+		err = __ni_system_refresh_interface(nc, ifp);
+	return err;
+
+nla_put_failure:
+	nlmsg_free(msg);
+	return -1;
+}
+
+static scale_client_t *
+scale_client_by_index(unsigned int ifindex)
+{
+	return ifindex <= clients_max_index ? clients_by_index[ifindex] : NULL;
+}
+
+static int
+scale_clients_create(pid_t peer)
+{
+	char ifname[IFNAMSIZ], peername[IFNAMSIZ];
+	unsigned int i;
+	ni_netconfig_t *nc;
+	ni_netdev_t *ifp;
+
+	/* opens the netlink socket we're talking over */
+	if (!ni_global_state_handle(0))
+		return -1;
+
+	clients = xcalloc(opts.count, sizeof(*clients));
+	for (i = 0; i < opts.count; ++i) {
+		snprintf(ifname, sizeof(ifname), SCALE_CLIENT_IFNAME, i);
+		snprintf(peername, sizeof(peername), SCALE_SERVER_IFNAME, i);
+		if (scale_veth_create(ifname, peername, peer) < 0)
+			return -1;
+	}
+
+	if (!(nc = ni_global_state_handle(1)))
+		return -1;
+
+	for (i = 0; i < opts.count; ++i) {
+		scale_client_t *client = &clients[i];
+		unsigned int f;
+
+		snprintf(client->ifname, sizeof(client->ifname), SCALE_CLIENT_IFNAME, i);
+		if (!(ifp = ni_netdev_by_name(nc, client->ifname)))
+			return -1;
+
+		client->ifindex = ifp->link.ifindex;
+		if (client->ifindex > clients_max_index)
+			clients_max_index = client->ifindex;
+		for (f = 0; f < SCALE_FAMILY_MAX; ++f) {
+			client->state[f].client = client;
+			client->state[f].family = f;
+		}
+	}
+
+	clients_by_index = xcalloc(clients_max_index + 1, sizeof(*clients_by_index));
+	for (i = 0; i < opts.count; ++i)
+		clients_by_index[clients[i].ifindex] = &clients[i];
+	return 0;
+}
+
+static int
+scale_clients_link_up(void)
+{
+	ni_netdev_req_t *ifreq;
+	ni_netconfig_t *nc;
+	ni_netdev_t *ifp;
+	struct timeval start;
+	unsigned int i, ready;
+	int ret = 0;
+
+	nc = ni_global_state_handle(0);
+	ifreq = ni_netdev_req_new();
+	ifreq->ifflags = NI_IFF_LINK_UP | NI_IFF_NETWORK_UP;
+	for (i = 0; i < opts.count && ret == 0; ++i) {
+		if (!(ifp = ni_netdev_by_index(nc, clients[i].ifindex)) ||
+		    ni_system_interface_link_change(ifp, ifreq) < 0) {
+			ni_error("%s: unable to set up link", clients[i].ifname);
+			ret = -1;
+		}
+	}
+	ni_netdev_req_free(ifreq);
+	if (ret)
+		return ret;
+
+	ni_timer_get_time(&start);
+	do {
+		if (!(nc = ni_global_state_handle(1)))
+			return -1;
+
+		for (ready = 0, i = 0; i < opts.count; ++i) {
+			scale_client_t *client = &clients[i];
+
+			if (!(ifp = ni_netdev_by_index(nc, client->ifindex)))
+				return -1;
+			if (!ni_netdev_link_is_up(ifp))
+				continue;
+
+			if (opts.family[SCALE_DHCP4] && !client->dev4 &&
+			    !(client->dev4 = ni_dhcp4_device_new(ifp->name, &ifp->link)))
+				return -1;
+			if (opts.family[SCALE_DHCP6] && !client->dev6 &&
+			    !(client->dev6 = ni_dhcp6_device_new(ifp->name, &ifp->link)))
+				return -1;
+			if (client->dev6 && !ni_dhcp6_device_check_ready(client->dev6))
+				continue;
+			ready++;
+		}
+		if (ready == opts.count)
+			return 0;
+
+		usleep(100000);
+	} while (ni_lifetime_left(SCALE_LINK_TIMEOUT, &start, NULL) > 0);
+
+	ni_error("only %u of %u links came up", ready, opts.count);
+	return -1;
+}
+
+/*
+ * Client side lease phase tracking
+ */
+static void
+scale_state_fail(scale_state_t *st, const char *reason)
+{
+	if (st->phase == SCALE_PHASE_DONE)
+		return;
+
+	ni_error("%s: %s %s failed: %s", st->client->ifname,
+			scale_family_names[st->family],
+			scale_phase_names[st->phase], reason);
+	st->failed = TRUE;
+	st->phase = SCALE_PHASE_DONE;
+	clients_pending--;
+}
+
+static void
+scale_state_release(void *user_data, const ni_timer_t *timer)
+{
+	scale_state_t *st = user_data;
+	scale_client_t *client = st->client;
+	int rv;
+
+	if (st->timer != timer)
+		return;
+	st->timer = NULL;
+
+	ni_timer_get_time(&st->start);
+	if (st->family == SCALE_DHCP4)
+		rv = ni_dhcp4_release(client->dev4, &client->uuid);
+	else
+		rv = ni_dhcp6_release(client->dev6, &client->uuid);
+	if (rv < 0)
+		scale_state_fail(st, ni_strerror(rv));
+}
+
+static void
+scale_state_acquired(scale_state_t *st, unsigned int renewal_time)
+{
+	struct timeval now;
+
+	ni_timer_get_time(&now);
+	switch (st->phase) {
+	case SCALE_PHASE_ACQUIRE:
+		break;
+	case SCALE_PHASE_RENEW:
+		st->renewals++;
+		break;
+	default:
+		return;
+	}
+	scale_samples_add(&samples[st->family][st->phase],
+			scale_elapsed_msec(&st->start, &now));
+
+	if (st->renewals < opts.renewals) {
+		/* the renew latency counts from the T1 timer expiry */
+		st->phase = SCALE_PHASE_RENEW;
+		st->start = now;
+		st->start.tv_sec += renewal_time;
+	} else {
+		/* don't release from within the supplicant's callback */
+		st->phase = SCALE_PHASE_RELEASE;
+		st->timer = ni_timer_register(0, scale_state_release, st);
+	}
+}
+
+static void
+scale_state_released(scale_state_t *st)
+{
+	struct timeval now;
+
+	if (st->phase != SCALE_PHASE_RELEASE)
+		return;
+
+	ni_timer_get_time(&now);
+	scale_samples_add(&samples[st->family][st->phase],
+			scale_elapsed_msec(&st->start, &now));
+	st->phase = SCALE_PHASE_DONE;
+	clients_pending--;
+}
+
+static void
+scale_dhcp4_event(enum ni_dhcp4_event ev, const ni_dhcp4_device_t *dev,
+		ni_addrconf_lease_t *lease)
+{
+	scale_client_t *client;
+	scale_state_t *st;
+	struct in_addr mask;
+
+	if (!(client = scale_client_by_index(dev->link.ifindex)))
+		return;
+
+	st = &client->state[SCALE_DHCP4];
+	switch (ev) {
+	case NI_DHCP4_EVENT_ACQUIRED:
+		if (!lease || lease->state != NI_ADDRCONF_STATE_GRANTED)
+			break;
+
+		/* apply the address as wickedd would, so we can renew via unicast */
+		if (st->phase == SCALE_PHASE_ACQUIRE) {
+			mask = lease->dhcp4.netmask;
+			if (!mask.s_addr)
+				mask.s_addr = htonl(SCALE_DHCP4_NETMASK);
+			if (scale_address_add(client->ifindex, lease->dhcp4.address, mask) < 0) {
+				scale_state_fail(st, "cannot apply lease address");
+				break;
+			}
+		}
+		scale_state_acquired(st, lease->dhcp4.renewal_time);
+		break;
+
+	case NI_DHCP4_EVENT_RELEASED:
+		scale_state_released(st);
+		break;
+
+	case NI_DHCP4_EVENT_LOST:
+		scale_state_fail(st, "lease lost");
+		break;
+
+	default:
+		break;
+	}
+}
+
+static void
+scale_dhcp6_event(enum ni_dhcp6_event ev, const ni_dhcp6_device_t *dev,
+		ni_addrconf_lease_t *lease)
+{
+	unsigned int renewal_time = 0, t1;
+	scale_client_t *client;
+	scale_state_t *st;
+	ni_dhcp6_ia_t *ia;
+
+	if (!(client = scale_client_by_index(dev->link.ifindex)))
+		return;
+
+	st = &client->state[SCALE_DHCP6];
+	switch (ev) {
+	case NI_DHCP6_EVENT_ACQUIRED:
+		if (!lease || lease->state != NI_ADDRCONF_STATE_GRANTED)
+			break;
+
+		for (ia = lease->dhcp6.ia_list; ia; ia = ia->next) {
+			t1 = ni_dhcp6_ia_get_renewal_time(ia);
+			if (!renewal_time || t1 < renewal_time)
+				renewal_time = t1;
+		}
+		scale_state_acquired(st, renewal_time);
+		break;
+
+	case NI_DHCP6_EVENT_RELEASED:
+		scale_state_released(st);
+		break;
+
+	case NI_DHCP6_EVENT_LOST:
+		scale_state_fail(st, "lease lost");
+		break;
+
+	default:
+		break;
+	}
+}
+
+static int
+scale_clients_start(void)
+{
+	ni_dhcp4_request_t *req4 = NULL;
+	ni_dhcp6_request_t *req6 = NULL;
+	char *errdetail = NULL;
+	unsigned int i;
+	int rv, ret = 0;
+
+	if (opts.family[SCALE_DHCP4]) {
+		ni_dhcp4_set_event_handler(scale_dhcp4_event);
+		req4 = ni_dhcp4_request_new();
+		req4->dry_run = NI_DHCP4_RUN_NORMAL;
+		req4->acquire_timeout = opts.timeout;
+		req4->release_lease = TRUE;
+	}
+	if (opts.family[SCALE_DHCP6]) {
+		ni_dhcp6_set_event_handler(scale_dhcp6_event);
+		req6 = ni_dhcp6_request_new();
+		req6->enabled = TRUE;
+		req6->dry_run = NI_DHCP6_RUN_NORMAL;
+		req6->mode = NI_BIT(NI_DHCP6_MODE_MANAGED);
+		req6->acquire_timeout = opts.timeout;
+		req6->release_lease = TRUE;
+	}
+
+	for (i = 0; i < opts.count; ++i) {
+		scale_client_t *client = &clients[i];
+
+		ni_uuid_generate(&client->uuid);
+		if (req4) {
+			req4->uuid = client->uuid;
+			req4->update = ni_config_addrconf_update(client->ifname,
+						NI_ADDRCONF_DHCP, AF_INET);
+
+			ni_timer_get_time(&client->state[SCALE_DHCP4].start);
+			if ((rv = ni_dhcp4_acquire(client->dev4, req4)) < 0) {
+				scale_state_fail(&client->state[SCALE_DHCP4], ni_strerror(rv));
+				ret = -1;
+			}
+		}
+		if (req6) {
+			req6->uuid = client->uuid;
+			req6->update = ni_config_addrconf_update(client->ifname,
+						NI_ADDRCONF_DHCP, AF_INET6);
+
+			ni_timer_get_time(&client->state[SCALE_DHCP6].start);
+			if ((rv = ni_dhcp6_acquire(client->dev6, req6, &errdetail)) < 0) {
+				scale_state_fail(&client->state[SCALE_DHCP6],
+						errdetail ? errdetail : ni_strerror(rv));
+				ni_string_free(&errdetail);
+				ret = -1;
+			}
+		}
+	}
+
+	if (req4)
+		ni_dhcp4_request_free(req4);
+	if (req6)
+		ni_dhcp6_request_free(req6);
+	return ret;
+}
+
+static void
+scale_clients_free(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < opts.count; ++i) {
+		if (clients[i].dev4)
+			ni_dhcp4_device_put(clients[i].dev4);
+		if (clients[i].dev6)
+			ni_dhcp6_device_put(clients[i].dev6);
+	}
+	free(clients_by_index);
+	free(clients);
+}
+
+/*
+ * Report
+ */
+static double
+scale_cpu_msec(const struct timeval *utime, const struct timeval *stime)
+{
+	return scale_timeval_msec(utime) + scale_timeval_msec(stime);
+}
+
+static unsigned int
+scale_report(const scale_responder_stats_t *stats, double wall_msec,
+		const struct rusage *ru_beg, const struct rusage *ru_end)
+{
+	struct timeval utime, stime;
+	unsigned int f, p, i, failed = 0, done;
+	double cpu;
+
+	for (f = 0; f < SCALE_FAMILY_MAX; ++f) {
+		if (!opts.family[f])
+			continue;
+
+		for (done = 0, i = 0; i < opts.count; ++i) {
+			const scale_state_t *st = &clients[i].state[f];
+
+			if (st->phase != SCALE_PHASE_DONE || st->failed)
+				failed++;
+			else
+				done++;
+		}
+		printf("%s: %u clients, %u completed %u renewal%s, %u failed\n",
+				scale_family_names[f], opts.count, done, opts.renewals,
+				opts.renewals == 1 ? "" : "s", opts.count - done);
+
+		for (p = 0; p < SCALE_PHASE_MAX; ++p) {
+			scale_samples_t *s = &samples[f][p];
+			double sum = 0.0;
+
+			if (!s->count)
+				continue;
+			qsort(s->data, s->count, sizeof(double), scale_samples_cmp);
+			for (i = 0; i < s->count; ++i)
+				sum += s->data[i];
+			printf("  %-8s %6u  min %8.2f  avg %8.2f  p50 %8.2f  p90 %8.2f  p99 %8.2f  max %8.2f ms\n",
+					scale_phase_names[p], s->count, s->data[0],
+					sum / s->count,
+					scale_samples_percentile(s, 50),
+					scale_samples_percentile(s, 90),
+					scale_samples_percentile(s, 99),
+					s->data[s->count - 1]);
+		}
+	}
+
+	if (stats) {
+		printf("responder: %lu packets received, %lu sent, %.0f packets/sec\n",
+				stats->rx, stats->tx,
+				wall_msec > 0 ? (stats->rx + stats->tx) * 1000.0 / wall_msec : 0.0);
+		printf("  dhcp4 discover %lu request %lu release %lu, arp %lu\n",
+				stats->dhcp4[DHCP4_DISCOVER], stats->dhcp4[DHCP4_REQUEST],
+				stats->dhcp4[DHCP4_RELEASE], stats->arp);
+		printf("  dhcp6 solicit %lu request %lu renew %lu rebind %lu release %lu\n",
+				stats->dhcp6[NI_DHCP6_SOLICIT], stats->dhcp6[NI_DHCP6_REQUEST],
+				stats->dhcp6[NI_DHCP6_RENEW], stats->dhcp6[NI_DHCP6_REBIND],
+				stats->dhcp6[NI_DHCP6_RELEASE]);
+	}
+
+	timersub(&ru_end->ru_utime, &ru_beg->ru_utime, &utime);
+	timersub(&ru_end->ru_stime, &ru_beg->ru_stime, &stime);
+	cpu = scale_cpu_msec(&utime, &stime);
+	printf("cpu: supplicants %.2f ms user, %.2f ms sys (%.1f%% of %.2f ms wall)\n",
+			scale_timeval_msec(&utime), scale_timeval_msec(&stime),
+			wall_msec > 0 ? cpu * 100.0 / wall_msec : 0.0, wall_msec);
+	if (stats) {
+		printf("cpu: responder %.2f ms user, %.2f ms sys\n",
+				scale_timeval_msec(&stats->utime),
+				scale_timeval_msec(&stats->stime));
+	}
+
+	return failed;
+}
+
+static void
+scale_statedir_remove(const char *path)
+{
+	struct dirent *de;
+	char *file = NULL;
+	DIR *dir;
+
+	if (!(dir = opendir(path)))
+		return;
+	while ((de = readdir(dir))) {
+		if (de->d_name[0] == '.')
+			continue;
+		if (ni_string_printf(&file, "%s/%s", path, de->d_name))
+			unlink(file);
+	}
+	closedir(dir);
+	ni_string_free(&file);
+	rmdir(path);
+}
+
+int main(int argc, char *argv[])
+{
+	char statedir[] = "/tmp/dhcp-scale-test.XXXXXX";
+	scale_responder_stats_t stats, *have_stats = NULL;
+	struct rusage ru_beg, ru_end;
+	struct timeval beg, end, deadline;
+	unsigned int failed;
+	int ctl[2], status, c;
+	pid_t pid;
+	char cc = 0;
+
+	while ((c = getopt(argc, argv, "46dn:r:T:t:")) != EOF) {
+		switch (c) {
+		case '4':
+			opts.family[SCALE_DHCP6] = FALSE;
+			break;
+		case '6':
+			opts.family[SCALE_DHCP4] = FALSE;
+			break;
+		case 'd':
+			ni_enable_debug("dhcp");
+			break;
+		case 'n':
+			opts.count = strtoul(optarg, NULL, 0);
+			break;
+		case 'r':
+			opts.renewals = strtoul(optarg, NULL, 0);
+			break;
+		case 'T':
+			opts.renew_time = strtoul(optarg, NULL, 0);
+			break;
+		case 't':
+			opts.timeout = strtoul(optarg, NULL, 0);
+			break;
+		default:
+		usage:
+			fprintf(stderr, "Usage: %s [-d] [-4|-6] [-n clients] [-r renewals]"
+					" [-T renew-time] [-t timeout]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (!opts.count || !opts.renew_time || !opts.timeout ||
+	    !(opts.family[SCALE_DHCP4] || opts.family[SCALE_DHCP6]))
+		goto usage;
+
+	/* everything we open from now on has to live in the new namespace */
+	if (unshare(CLONE_NEWNET) < 0) {
+		fprintf(stderr, "%s: cannot create network namespace: %m, skipped\n", argv[0]);
+		return 77;
+	}
+	scale_sysctl_setup();
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, ctl) < 0)
+		return 1;
+	if ((pid = fork()) < 0)
+		return 1;
+	if (pid == 0) {
+		close(ctl[0]);
+		_exit(scale_responder_run(ctl[1]));
+	}
+	close(ctl[1]);
+
+	if (ni_init("dhcp-scale-test") < 0)
+		goto failure;
+	if (!mkdtemp(statedir))
+		goto failure;
+	ni_string_dup(&ni_global.config->statedir.path, statedir);
+	ni_string_dup(&ni_global.config->storedir.path, statedir);
+
+	if (read(ctl[0], &cc, 1) != 1) {
+		fprintf(stderr, "%s: responder failed to start\n", argv[0]);
+		goto failure;
+	}
+	if (scale_clients_create(pid) < 0)
+		goto failure;
+	if (write(ctl[0], &cc, 1) != 1 || read(ctl[0], &cc, 1) != 1)
+		goto failure;
+	if (scale_clients_link_up() < 0)
+		goto failure;
+
+	getrusage(RUSAGE_SELF, &ru_beg);
+	ni_timer_get_time(&beg);
+	deadline = beg;
+	deadline.tv_sec += opts.timeout;
+
+	clients_pending = opts.count * (opts.family[SCALE_DHCP4] + opts.family[SCALE_DHCP6]);
+	scale_clients_start();
+
+	while (clients_pending && !ni_caught_terminal_signal()) {
+		long timeout, left;
+
+		ni_timer_get_time(&end);
+		if ((left = scale_elapsed_msec(&end, &deadline)) <= 0)
+			break;
+
+		/* expired timers may have completed the last client */
+		timeout = ni_timer_next_timeout();
+		if (!clients_pending)
+			break;
+		if (timeout < 0 || timeout > left)
+			timeout = left;
+		if (ni_socket_wait(timeout) != 0)
+			break;
+	}
+	ni_timer_get_time(&end);
+	getrusage(RUSAGE_SELF, &ru_end);
+
+	/* ask the responder for its counters */
+	shutdown(ctl[0], SHUT_WR);
+	if (read(ctl[0], &stats, sizeof(stats)) == sizeof(stats))
+		have_stats = &stats;
+	waitpid(pid, &status, 0);
+	pid = 0;
+
+	failed = scale_report(have_stats, scale_elapsed_msec(&beg, &end), &ru_beg, &ru_end);
+
+	ni_socket_deactivate_all();
+	scale_clients_free();
+	scale_statedir_remove(statedir);
+	return failed ? 1 : 0;
+
+failure:
+	if (pid > 0) {
+		kill(pid, SIGTERM);
+		waitpid(pid, &status, 0);
+	}
+	if (statedir[strlen(statedir) - 1] != 'X')
+		scale_statedir_remove(statedir);
+	return 1;
+}
@@ -0,0 +1,461 @@
+/*
+ *	DHCPv4 option parser test, fuzz and throughput program
+ *
+ *	Copyright (C) 2026 SUSE Linux GmbH, Nuernberg, Germany.
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	This program is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along
+ *	with this program; if not, see <http://www.gnu.org/licenses/> or write
+ *	to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *	Boston, MA 02110-1301 USA.
+ *
+ *	Usage:
+ *		dhcp4-test [-f <rounds>] [-b <rounds>] testing/dhcp4/<packet>.hex ...
+ *
+ *	Builds a reply with options longer than 255 bytes and checks that
+ *	they survive the RFC 3396 split and concatenation. Then parses the
+ *	recorded DHCPv4 server packets (hex dumps of the bootp message
+ *	starting at the op field), prints the resulting lease and compares
+ *	it to the expected values of known packets; any mismatch makes the
+ *	program exit with 1.
+ *	With -f, each packet is parsed again with random mutations and
+ *	truncations applied; with -b, the parse throughput is measured.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+
+#include <wicked/netinfo.h>
+#include <wicked/logging.h>
+#include <wicked/addrconf.h>
+#include <wicked/route.h>
+#include <wicked/resolver.h>
+#include <wicked/xml.h>
+#include "dhcp4/dhcp4.h"
+#include "dhcp4/protocol.h"
+#include "buffer.h"
+
+static const struct dhcp4_expect {
+	const char *		packet;		/* basename of the .hex file */
+	int			msg;
+	const char *		address;
+	const char *		server_id;
+	const char *		netmask;
+	const char *		routes;
+	const char *		hostname;
+	const char *		domain;
+	unsigned int		dns_count;
+	const char *		dns_first;
+	const char *		dns_last;
+	const char *		message;
+} dhcp4_expect[] = {
+	{	/* domain in sname, dns-server split across options and file */
+		.packet		= "ack-overload.hex",
+		.msg		= DHCP4_ACK,
+		.address	= "10.0.3.7",
+		.server_id	= "10.0.0.1",
+		.netmask	= "255.255.0.0",
+		.routes		= "default via 10.0.0.1",
+		.domain		= "overload.example",
+		.dns_count	= 80,
+		.dns_first	= "10.0.0.1",
+		.dns_last	= "10.0.0.80",
+	},
+	{
+		.packet		= "ack-plain.hex",
+		.msg		= DHCP4_ACK,
+		.address	= "192.168.122.50",
+		.server_id	= "192.168.122.1",
+		.netmask	= "255.255.255.0",
+		.routes		= "10.0.0.0/24 via 192.168.122.1, default via 192.168.122.1",
+		.hostname	= "client1",
+		.domain		= "example.com",
+		.dns_count	= 2,
+		.dns_first	= "192.168.122.1",
+		.dns_last	= "192.168.122.2",
+	},
+	{
+		.packet		= "nak.hex",
+		.msg		= DHCP4_NAK,
+		.server_id	= "192.168.1.1",
+		.message	= "wrong network",
+	},
+	{ NULL }
+};
+
+static size_t
+load_hex_packet(const char *filename, unsigned char *data, size_t size)
+{
+	char line[512], *ptr, *end;
+	size_t len = 0;
+	FILE *fp;
+
+	if (!(fp = fopen(filename, "r"))) {
+		fprintf(stderr, "ERR: cannot open %s: %m\n", filename);
+		return 0;
+	}
+
+	while (fgets(line, sizeof(line), fp)) {
+		if (line[0] == '#')
+			continue;
+
+		for (ptr = line; *ptr; ptr = end) {
+			unsigned long byte;
+
+			while (isspace((unsigned char)*ptr))
+				ptr++;
+			if (!*ptr)
+				break;
+
+			byte = strtoul(ptr, &end, 16);
+			if (end == ptr || byte > 0xff || len >= size) {
+				fprintf(stderr, "ERR: %s: invalid hex data\n", filename);
+				fclose(fp);
+				return 0;
+			}
+			data[len++] = byte;
+		}
+	}
+	fclose(fp);
+	return len;
+}
+
+static int
+parse_packet(const ni_dhcp4_config_t *config, unsigned char *data, size_t len,
+		ni_addrconf_lease_t **lease)
+{
+	ni_dhcp4_message_t *message;
+	ni_buffer_t buf;
+
+	ni_buffer_init_reader(&buf, data, len);
+	if (!(message = ni_buffer_pull_head(&buf, sizeof(*message))))
+		return -1;
+
+	return ni_dhcp4_parse_response(config, message, &buf, lease);
+}
+
+static const char *
+format_routes(ni_stringbuf_t *out, const ni_addrconf_lease_t *lease)
+{
+	const ni_route_table_t *tab;
+	unsigned int i;
+
+	for (tab = lease->routes; tab; tab = tab->next) {
+		for (i = 0; i < tab->routes.count; ++i) {
+			const ni_route_t *rp = tab->routes.data[i];
+
+			if (out->len)
+				ni_stringbuf_printf(out, ", ");
+			if (rp->prefixlen)
+				ni_stringbuf_printf(out, "%s/%u",
+					ni_sockaddr_print(&rp->destination), rp->prefixlen);
+			else
+				ni_stringbuf_printf(out, "default");
+			ni_stringbuf_printf(out, " via %s", ni_sockaddr_print(&rp->nh.gateway));
+		}
+	}
+	return out->string;
+}
+
+static unsigned int
+check_string(const char *name, const char *what, const char *expect, const char *value)
+{
+	if (!expect || ni_string_eq(expect, value))
+		return 0;
+
+	fprintf(stderr, "FAIL: %s: %s is '%s', expected '%s'\n", name, what,
+			value ? value : "", expect);
+	return 1;
+}
+
+static unsigned int
+check_lease(const char *name, int msg, const ni_addrconf_lease_t *lease)
+{
+	const struct dhcp4_expect *exp;
+	const ni_string_array_t *dns;
+	ni_stringbuf_t routes = NI_STRINGBUF_INIT_DYNAMIC;
+	const char *base;
+	unsigned int failed = 0;
+
+	base = (base = strrchr(name, '/')) ? base + 1 : name;
+	for (exp = dhcp4_expect; exp->packet; ++exp) {
+		if (ni_string_eq(exp->packet, base))
+			break;
+	}
+	if (!exp->packet)
+		return 0;
+
+	if (msg != exp->msg) {
+		fprintf(stderr, "FAIL: %s: message is %s, expected %s\n", name,
+				ni_dhcp4_message_name(msg), ni_dhcp4_message_name(exp->msg));
+		failed++;
+	}
+	failed += check_string(name, "address", exp->address,
+				inet_ntoa(lease->dhcp4.address));
+	failed += check_string(name, "server-id", exp->server_id,
+				inet_ntoa(lease->dhcp4.server_id));
+	failed += check_string(name, "netmask", exp->netmask,
+				inet_ntoa(lease->dhcp4.netmask));
+	failed += check_string(name, "routes", exp->routes,
+				format_routes(&routes, lease));
+	failed += check_string(name, "hostname", exp->hostname, lease->hostname);
+	failed += check_string(name, "message", exp->message, lease->dhcp4.message);
+	ni_stringbuf_destroy(&routes);
+
+	if (exp->domain || exp->dns_count) {
+		if (!lease->resolver) {
+			fprintf(stderr, "FAIL: %s: no resolver info\n", name);
+			return failed + 1;
+		}
+		dns = &lease->resolver->dns_servers;
+		failed += check_string(name, "domain", exp->domain,
+					lease->resolver->default_domain);
+		if (dns->count != exp->dns_count) {
+			fprintf(stderr, "FAIL: %s: %u dns servers, expected %u\n",
+					name, dns->count, exp->dns_count);
+			failed++;
+		} else if (dns->count) {
+			failed += check_string(name, "first dns server",
+					exp->dns_first, dns->data[0]);
+			failed += check_string(name, "last dns server",
+					exp->dns_last, dns->data[dns->count - 1]);
+		}
+	}
+	return failed;
+}
+
+/*
+ * Build a reply carrying a dns-server option written in one go and
+ * a classless routes option assembled with begin/end, both too long
+ * for a single option, and check that the parser joins them again.
+ */
+#define LONG_DNS_SERVERS	100
+#define LONG_CSR_ROUTES		40
+
+static unsigned int
+check_long_options(const ni_dhcp4_config_t *config)
+{
+	unsigned char data[1500];
+	uint32_t servers[LONG_DNS_SERVERS];
+	ni_dhcp4_message_t *message;
+	ni_addrconf_lease_t *lease = NULL;
+	ni_stringbuf_t routes = NI_STRINGBUF_INIT_DYNAMIC;
+	ni_stringbuf_t expect = NI_STRINGBUF_INIT_DYNAMIC;
+	struct in_addr addr;
+	unsigned char type = DHCP4_ACK;
+	unsigned int pos, i, failed = 0;
+	ni_buffer_t buf;
+	int msg;
+
+	ni_buffer_init(&buf, data, sizeof(data));
+	message = ni_buffer_push_tail(&buf, sizeof(*message));
+	memset(message, 0, sizeof(*message));
+	message->op = DHCP4_BOOTREPLY;
+	message->cookie = htonl(MAGIC_COOKIE);
+	message->yiaddr = inet_addr("192.168.0.10");
+
+	ni_dhcp4_option_put(&buf, DHCP4_MESSAGETYPE, &type, 1);
+	addr.s_addr = inet_addr("192.168.0.1");
+	ni_dhcp4_option_put(&buf, DHCP4_SERVERIDENTIFIER, &addr, 4);
+
+	for (i = 0; i < LONG_DNS_SERVERS; ++i)
+		servers[i] = htonl(0x0a000001 + i);
+	ni_dhcp4_option_put(&buf, DHCP4_DNSSERVER, servers, sizeof(servers));
+
+	pos = ni_dhcp4_option_begin(&buf, DHCP4_CSR);
+	for (i = 0; i < LONG_CSR_ROUTES; ++i) {
+		unsigned char route[] = { 24, 10, 1 + i, 0, 192, 168, 0, 1 };
+
+		ni_buffer_put(&buf, route, sizeof(route));
+	}
+	ni_dhcp4_option_end(&buf, pos);
+	ni_buffer_putc(&buf, DHCP4_END);
+
+	if (buf.overflow || buf.tail <= sizeof(*message) + 2 * 255) {
+		fprintf(stderr, "FAIL: long options: unable to build the message\n");
+		return 1;
+	}
+
+	if ((msg = parse_packet(config, data, buf.tail, &lease)) != DHCP4_ACK) {
+		fprintf(stderr, "FAIL: long options: unable to parse the message\n");
+		ni_addrconf_lease_free(lease);
+		return 1;
+	}
+
+	if (!lease->resolver || lease->resolver->dns_servers.count != LONG_DNS_SERVERS) {
+		fprintf(stderr, "FAIL: long options: %u dns servers, expected %u\n",
+				lease->resolver ? lease->resolver->dns_servers.count : 0,
+				LONG_DNS_SERVERS);
+		failed++;
+	} else {
+		for (i = 0; i < LONG_DNS_SERVERS; ++i) {
+			addr.s_addr = servers[i];
+			failed += check_string("long options", "dns server",
+					inet_ntoa(addr), lease->resolver->dns_servers.data[i]);
+		}
+	}
+
+	for (i = 0; i < LONG_CSR_ROUTES; ++i) {
+		ni_stringbuf_printf(&expect, "%s10.%u.0.0/24 via 192.168.0.1",
+				i ? ", " : "", 1 + i);
+	}
+	failed += check_string("long options", "routes", expect.string,
+				format_routes(&routes, lease));
+	ni_stringbuf_destroy(&expect);
+	ni_stringbuf_destroy(&routes);
+	ni_addrconf_lease_free(lease);
+
+	printf("long options: %s\n", failed ? "FAILED" : "OK");
+	return failed;
+}
+
+static void
+print_lease(const ni_addrconf_lease_t *lease)
+{
+	xml_node_t *node = NULL;
+
+	if (ni_addrconf_lease_to_xml(lease, &node, NULL) == 0) {
+		xml_node_print(node, stdout);
+		xml_node_free(node);
+	}
+}
+
+static unsigned int
+fuzz_packet(const ni_dhcp4_config_t *config, const unsigned char *orig, size_t len,
+		unsigned int rounds)
+{
+	unsigned char data[len];
+	unsigned int r, n, parsed = 0;
+
+	for (r = 0; r < rounds; ++r) {
+		ni_addrconf_lease_t *lease = NULL;
+		size_t flen = len;
+
+		memcpy(data, orig, len);
+
+		/* flip a few random bytes in the option area */
+		for (n = random() % 8; n; --n)
+			data[sizeof(ni_dhcp4_message_t) + random() % (len - sizeof(ni_dhcp4_message_t))] = random();
+
+		/* ... and sometimes truncate it */
+		if (random() % 4 == 0)
+			flen = sizeof(ni_dhcp4_message_t) + random() % (len - sizeof(ni_dhcp4_message_t));
+
+		if (parse_packet(config, data, flen, &lease) >= 0) {
+			ni_addrconf_lease_free(lease);
+			parsed++;
+		}
+	}
+	return parsed;
+}
+
+static void
+bench_packet(const char *name, const ni_dhcp4_config_t *config,
+		const unsigned char *orig, size_t len, unsigned int rounds)
+{
+	unsigned char data[len];
+	struct timeval beg, end;
+	unsigned int r;
+	double secs;
+
+	gettimeofday(&beg, NULL);
+	for (r = 0; r < rounds; ++r) {
+		ni_addrconf_lease_t *lease = NULL;
+
+		memcpy(data, orig, len);
+		if (parse_packet(config, data, len, &lease) >= 0)
+			ni_addrconf_lease_free(lease);
+	}
+	gettimeofday(&end, NULL);
+
+	secs = (end.tv_sec - beg.tv_sec) + (end.tv_usec - beg.tv_usec) / 1000000.0;
+	printf("%s: parsed %u packets in %.3f sec, %.0f packets/sec\n",
+			name, rounds, secs, secs > 0 ? rounds / secs : 0.0);
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int fuzz_rounds = 0, bench_rounds = 0;
+	ni_dhcp4_config_t config;
+	unsigned char data[4096];
+	int c, ret = 0;
+
+	while ((c = getopt(argc, argv, "f:b:d")) != EOF) {
+		switch (c) {
+		case 'f':
+			fuzz_rounds = strtoul(optarg, NULL, 0);
+			break;
+		case 'b':
+			bench_rounds = strtoul(optarg, NULL, 0);
+			break;
+		case 'd':
+			ni_enable_debug("dhcp");
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-d] [-f rounds] [-b rounds] packet.hex ...\n", argv[0]);
+			return 1;
+		}
+	}
+
+	memset(&config, 0, sizeof(config));
+	srandom(42);
+
+	if (check_long_options(&config))
+		ret = 1;
+
+	for (; optind < argc; ++optind) {
+		const char *name = argv[optind];
+		ni_addrconf_lease_t *lease = NULL;
+		size_t len;
+		int msg;
+
+		if (!(len = load_hex_packet(name, data, sizeof(data)))) {
+			ret = 1;
+			continue;
+		}
+
+		msg = parse_packet(&config, data, len, &lease);
+		if (msg < 0) {
+			printf("%s: unable to parse packet\n", name);
+			ret = 1;
+			continue;
+		}
+		printf("%s: %s\n", name, ni_dhcp4_message_name(msg));
+		print_lease(lease);
+		if (check_lease(name, msg, lease))
+			ret = 1;
+		ni_addrconf_lease_free(lease);
+
+		if (fuzz_rounds && len > sizeof(ni_dhcp4_message_t)) {
+			printf("%s: fuzzed %u rounds, %u parsed\n", name, fuzz_rounds,
+				fuzz_packet(&config, data, len, fuzz_rounds));
+
+			/* the mutations must not leak into later parses */
+			lease = NULL;
+			msg = parse_packet(&config, data, len, &lease);
+			if (msg < 0 || check_lease(name, msg, lease))
+				ret = 1;
+			ni_addrconf_lease_free(lease);
+		}
+		if (bench_rounds)
+			bench_packet(name, &config, data, len, bench_rounds);
+	}
+	return ret;
+}
@@ -0,0 +1,351 @@
+/*
+ *	Extension worker protocol test
+ *
+ *	Copyright (C) 2026 SUSE Linux GmbH, Nuernberg, Germany.
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	This program is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along
+ *	with this program; if not, see <http://www.gnu.org/licenses/> or write
+ *	to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *	Boston, MA 02110-1301 USA.
+ *
+ *	Usage:
+ *		extension-test
+ *
+ *	Runs the test binary itself as a mock extension worker on the socket
+ *	pair of the persistent worker and checks the length framed protocol
+ *	with replies split across writes, several calls in flight answered
+ *	in reverse order, a worker closing its socket while still running
+ *	and the fall back to action scripts after repeated worker failures.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include <wicked/util.h>
+#include <wicked/logging.h>
+#include <wicked/socket.h>
+#include <wicked/xml.h>
+#include "appconfig.h"
+#include "process.h"
+#include "buffer.h"
+
+#define TEST_TIMEOUT		3000	/* msec */
+#define TEST_CALLS		4
+
+static unsigned int		failed;
+
+#define CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			fprintf(stderr, "%s:%u: check failed: %s\n", __FILE__, __LINE__, #cond); \
+			failed++; \
+		} \
+	} while (0)
+
+struct test_result {
+	ni_bool_t		done;
+	char *			method;
+	char *			echo;
+	unsigned int		order;
+	struct timeval		finished;
+};
+
+static unsigned int		test_completed;
+
+/*
+ * The mock worker, running on stdin and stdout of the child
+ */
+static char *
+worker_read_frame(void)
+{
+	char line[32], *data;
+	unsigned long len;
+	size_t i, off;
+	ssize_t cnt;
+
+	for (i = 0; i < sizeof(line) - 1; ++i) {
+		if (read(0, &line[i], 1) != 1)
+			return NULL;
+		if (line[i] == '\n')
+			break;
+	}
+	line[i] = '\0';
+	len = strtoul(line, NULL, 10);
+
+	data = xcalloc(1, len + 1);
+	for (off = 0; off < len; off += cnt) {
+		if ((cnt = read(0, data + off, len - off)) <= 0) {
+			free(data);
+			return NULL;
+		}
+	}
+	return data;
+}
+
+static void
+worker_write_reply(const char *call)
+{
+	char *reply = NULL, head[32];
+	const char *method;
+	unsigned int id;
+	xml_document_t *doc;
+	xml_node_t *node;
+	size_t len, half;
+
+	doc = xml_document_from_string(call, NULL);
+	node = doc ? xml_node_get_child(xml_document_root(doc), "call") : NULL;
+	if (!node || !xml_node_get_attr_uint(node, "id", &id) ||
+	    !(method = xml_node_get_attr(node, "method")))
+		exit(1);
+
+	ni_string_printf(&reply, "<reply id=\"%u\" status=\"0\"><return><echo>%s</echo></return></reply>",
+			id, method);
+	xml_document_free(doc);
+
+	/* split the frame so the daemon has to collect it */
+	len = strlen(reply);
+	half = len / 2;
+	snprintf(head, sizeof(head), "%zu", len);
+	if (write(1, head, strlen(head)) < 0)
+		exit(1);
+	usleep(10000);
+	if (write(1, "\n", 1) < 0 || write(1, reply, half) < 0)
+		exit(1);
+	usleep(10000);
+	if (write(1, reply + half, len - half) < 0)
+		exit(1);
+	free(reply);
+}
+
+static int
+worker_main(const char *mode)
+{
+	char *calls[TEST_CALLS];
+	unsigned int i;
+
+	if (ni_string_eq(mode, "exit"))
+		return 1;
+
+	if (ni_string_eq(mode, "eof")) {
+		if (!(calls[0] = worker_read_frame()))
+			return 1;
+		free(calls[0]);
+		shutdown(1, SHUT_WR);
+		sleep(30);
+		return 0;
+	}
+
+	/* answer each batch of calls in reverse order */
+	for (;;) {
+		for (i = 0; i < TEST_CALLS; ++i) {
+			if (!(calls[i] = worker_read_frame()))
+				return 0;
+		}
+		while (i--) {
+			worker_write_reply(calls[i]);
+			free(calls[i]);
+		}
+	}
+}
+
+/*
+ * The daemon side
+ */
+static long
+test_msecs(const struct timeval *beg, const struct timeval *end)
+{
+	return (end->tv_sec - beg->tv_sec) * 1000 + (end->tv_usec - beg->tv_usec) / 1000;
+}
+
+static void
+test_done(void *user_data, const xml_node_t *reply)
+{
+	struct test_result *res = user_data;
+	const xml_node_t *node;
+
+	CHECK(!res->done);
+	res->done = TRUE;
+	res->order = test_completed++;
+	ni_timer_get_time(&res->finished);
+
+	if (reply && (node = xml_node_get_child(reply, "return")) &&
+	    (node = xml_node_get_child(node, "echo")))
+		ni_string_dup(&res->echo, node->cdata);
+}
+
+static void
+test_wait(struct test_result *res, unsigned int count, long timeout)
+{
+	struct timeval beg, now;
+	unsigned int i;
+
+	ni_timer_get_time(&beg);
+	do {
+		for (i = 0; i < count && res[i].done; ++i)
+			;
+		if (i == count)
+			return;
+
+		if (ni_socket_wait(50) < 0)
+			return;
+		ni_timer_get_time(&now);
+	} while (test_msecs(&beg, &now) < timeout);
+}
+
+static ni_bool_t
+test_call(ni_extension_t *ex, const char *method, struct test_result *res)
+{
+	xml_node_t *call;
+	ni_bool_t rv;
+
+	memset(res, 0, sizeof(*res));
+	ni_string_dup(&res->method, method);
+
+	call = xml_node_new("call", NULL);
+	xml_node_add_attr(call, "interface", ex->interface);
+	xml_node_add_attr(call, "method", method);
+	rv = ni_extension_worker_call(ex, call, test_done, res);
+	xml_node_free(call);
+	return rv;
+}
+
+static void
+test_result_destroy(struct test_result *res)
+{
+	ni_string_free(&res->method);
+	ni_string_free(&res->echo);
+}
+
+static ni_extension_t *
+test_extension_new(ni_extension_t **list, const char *self, const char *mode)
+{
+	ni_string_array_t args = NI_STRING_ARRAY_INIT;
+	ni_extension_t *ex;
+
+	ni_string_array_append(&args, self);
+	ni_string_array_append(&args, "-w");
+	ni_string_array_append(&args, mode);
+
+	ex = ni_extension_new(list, "org.opensuse.Network.Test");
+	ex->worker_cmd = ni_shellcmd_new(&args);
+	ni_string_array_destroy(&args);
+	return ex;
+}
+
+static void
+test_calls_in_flight(ni_extension_t *ex)
+{
+	static const char *methods[TEST_CALLS] = { "first", "second", "third", "fourth" };
+	struct test_result res[TEST_CALLS];
+	unsigned int i, round;
+
+	/* twice, to check the worker keeps serving on the same socket */
+	for (round = 0; round < 2; ++round) {
+		test_completed = 0;
+		for (i = 0; i < TEST_CALLS; ++i)
+			CHECK(test_call(ex, methods[i], &res[i]));
+
+		test_wait(res, TEST_CALLS, TEST_TIMEOUT);
+		for (i = 0; i < TEST_CALLS; ++i) {
+			CHECK(res[i].done);
+			CHECK(ni_string_eq(res[i].echo, res[i].method));
+			CHECK(res[i].order == TEST_CALLS - 1 - i);
+			test_result_destroy(&res[i]);
+		}
+	}
+	ni_extension_worker_stop(ex);
+}
+
+static void
+test_worker_eof(ni_extension_t *ex)
+{
+	struct test_result res;
+	struct timeval beg;
+
+	ni_timer_get_time(&beg);
+	CHECK(test_call(ex, "closing", &res));
+	test_wait(&res, 1, TEST_TIMEOUT);
+
+	/* failed on EOF while the worker still sleeps */
+	CHECK(res.done);
+	CHECK(res.echo == NULL);
+	CHECK(res.done && test_msecs(&beg, &res.finished) < TEST_TIMEOUT / 2);
+	test_result_destroy(&res);
+}
+
+static void
+test_worker_fallback(ni_extension_t *ex)
+{
+	struct test_result res;
+	unsigned int starts;
+
+	for (starts = 0; starts < 10; ++starts) {
+		if (!test_call(ex, "exiting", &res))
+			break;
+		test_wait(&res, 1, TEST_TIMEOUT);
+		CHECK(res.done);
+		CHECK(res.echo == NULL);
+		test_result_destroy(&res);
+	}
+	CHECK(starts == 3);
+	test_result_destroy(&res);
+}
+
+int
+main(int argc, char **argv)
+{
+	ni_extension_t *list = NULL, *ex;
+	char self[PATH_MAX];
+	ssize_t len;
+	int c;
+
+	while ((c = getopt(argc, argv, "w:")) != EOF) {
+		switch (c) {
+		case 'w':
+			return worker_main(optarg);
+		default:
+			fprintf(stderr, "Usage: %s\n", argv[0]);
+			return 1;
+		}
+	}
+
+	ni_log_init();
+
+	if ((len = readlink("/proc/self/exe", self, sizeof(self) - 1)) < 0) {
+		fprintf(stderr, "Cannot find the test executable: %m\n");
+		return 77;
+	}
+	self[len] = '\0';
+
+	ex = test_extension_new(&list, self, "reverse");
+	test_calls_in_flight(ex);
+
+	ex = test_extension_new(&list, self, "eof");
+	test_worker_eof(ex);
+
+	ex = test_extension_new(&list, self, "exit");
+	test_worker_fallback(ex);
+
+	ni_extension_list_destroy(&list);
+
+	printf("%s\n", failed ? "FAILED" : "OK");
+	return failed ? 1 : 0;
+}
@@ -26,8 +26,55 @@
 #include "config.h"
 #endif
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
 #include "json.h"
 
+/*
+ * Count the allocations done by the parsers, where we can
+ */
+static unsigned long		alloc_count;
+
+#if defined(__GLIBC__)
+extern void *			__libc_malloc(size_t);
+extern void *			__libc_calloc(size_t, size_t);
+extern void *			__libc_realloc(void *, size_t);
+
+void *
+malloc(size_t size)
+{
+	alloc_count++;
+	return __libc_malloc(size);
+}
+
+void *
+calloc(size_t nmemb, size_t size)
+{
+	alloc_count++;
+	return __libc_calloc(nmemb, size);
+}
+
+void *
+realloc(void *ptr, size_t size)
+{
+	alloc_count++;
+	return __libc_realloc(ptr, size);
+}
+#endif
+
+static double
+elapsed_ms(const struct timespec *beg)
+{
+	struct timespec end;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_sec - beg->tv_sec) * 1000.0 +
+		(end.tv_nsec - beg->tv_nsec) / 1000000.0;
+}
+
 static ni_json_t *
 init1_1(void)
 {
@@ -190,14 +237,183 @@ test_case2()
 	ni_json_free(json);
 }
 
+/*
+ * A teamd like config dump with many ports
+ */
+#define LARGE_PORTS	5000
+
+static char *
+init_large(void)
+{
+	ni_stringbuf_t buf = NI_STRINGBUF_INIT_DYNAMIC;
+	ni_json_t *json, *ports, *port, *runner;
+	char name[32];
+	unsigned int i;
+
+	json = ni_json_new_object();
+	ni_json_object_set(json, "device", ni_json_new_string("team0"));
+	runner = ni_json_new_object();
+	ni_json_object_set(runner, "name", ni_json_new_string("lacp"));
+	ni_json_object_set(runner, "fast_rate", ni_json_new_bool(TRUE));
+	ni_json_object_set(json, "runner", runner);
+
+	ports = ni_json_new_object();
+	for (i = 0; i < LARGE_PORTS; ++i) {
+		port = ni_json_new_object();
+		ni_json_object_set(port, "prio", ni_json_new_int64(i));
+		ni_json_object_set(port, "sticky", ni_json_new_bool(i % 2));
+		ni_json_object_set(port, "lacp_key", ni_json_new_int64(i % 7));
+		snprintf(name, sizeof(name), "eth%u", i);
+		ni_json_object_set(ports, name, port);
+	}
+	ni_json_object_set(json, "ports", ports);
+
+	ni_json_format_string(&buf, json, NULL);
+	ni_json_free(json);
+	return buf.string;
+}
+
+static ni_bool_t
+count_event(const ni_json_event_t *ev, void *user_data)
+{
+	unsigned int *count = user_data;
+
+	(*count)++;
+	return TRUE;
+}
+
+int
+test_case3(void)
+{
+	ni_json_t *json, *value;
+	char name[32];
+	unsigned int i;
+	int64_t prio;
+	int ret = 0;
+
+	json = ni_json_new_object();
+	for (i = 0; i < LARGE_PORTS; ++i) {
+		snprintf(name, sizeof(name), "eth%u", i);
+		ni_json_object_set(json, name, ni_json_new_int64(i));
+	}
+
+	/* hashed lookup of all members, also after a removal */
+	for (i = 0; i < LARGE_PORTS; ++i) {
+		snprintf(name, sizeof(name), "eth%u", i);
+		value = ni_json_object_get_value(json, name);
+		if (!ni_json_int64_get(value, &prio) || prio != i) {
+			printf("j3: lookup of %s failed\n", name);
+			ret = 1;
+		}
+	}
+	ni_json_object_delete(json, "eth42");
+	ni_json_object_set(json, "eth42", ni_json_new_int64(-42));
+	ni_json_object_set(json, "eth43", ni_json_new_int64(-43));
+	if (ni_json_object_entries(json) != LARGE_PORTS ||
+	    !ni_json_int64_get(ni_json_object_get_value(json, "eth42"), &prio) || prio != -42 ||
+	    !ni_json_int64_get(ni_json_object_get_value(json, "eth43"), &prio) || prio != -43 ||
+	    ni_json_object_get_value(json, "eth-none")) {
+		printf("j3: lookup after modification failed\n");
+		ret = 1;
+	}
+	printf("#--> j3: %u member object lookup %s\n", LARGE_PORTS, ret ? "FAILED" : "OK");
+
+	ni_json_free(json);
+	return ret;
+}
+
+int
+test_case4(void)
+{
+	static const char *paths[] = {
+		"/runner/name", "/ports/eth4999/prio", "/ports/eth7", "/missing", NULL
+	};
+	ni_json_t *values[5], *json;
+	struct timespec beg;
+	unsigned long allocs;
+	unsigned int events = 0, i;
+	const char *name;
+	int64_t prio;
+	double ms;
+	char *doc;
+	int ret = 0;
+
+	doc = init_large();
+
+	/* parse into a tree */
+	clock_gettime(CLOCK_MONOTONIC, &beg);
+	allocs = alloc_count;
+	json = ni_json_parse_string(doc);
+	allocs = alloc_count - allocs;
+	ms = elapsed_ms(&beg);
+	printf("#--> j4: parse %zu bytes: %.2fms, %lu allocations\n",
+			strlen(doc), ms, allocs);
+	if (!json) {
+		printf("j4: parse failed\n");
+		free(doc);
+		return 1;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &beg);
+	for (i = 0; i < LARGE_PORTS; i += 7) {
+		char port[32];
+
+		snprintf(port, sizeof(port), "eth%u", i);
+		if (!ni_json_int64_get(ni_json_object_get_value(ni_json_object_get_value(
+				ni_json_object_get_value(json, "ports"), port), "prio"), &prio) ||
+		    prio != i)
+			ret = 1;
+	}
+	printf("#--> j4: tree lookups: %.2fms\n", elapsed_ms(&beg));
+	ni_json_free(json);
+
+	/* scan without building anything */
+	clock_gettime(CLOCK_MONOTONIC, &beg);
+	allocs = alloc_count;
+	if (ni_json_scan_string(doc, count_event, &events) < 0)
+		ret = 1;
+	allocs = alloc_count - allocs;
+	ms = elapsed_ms(&beg);
+	printf("#--> j4: scan %u events: %.2fms, %lu allocations\n", events, ms, allocs);
+
+	/* extract selected paths */
+	clock_gettime(CLOCK_MONOTONIC, &beg);
+	allocs = alloc_count;
+	if (ni_json_extract_string(doc, paths, values) != 3)
+		ret = 1;
+	allocs = alloc_count - allocs;
+	ms = elapsed_ms(&beg);
+	printf("#--> j4: extract %u paths: %.2fms, %lu allocations\n", 4, ms, allocs);
+
+	if (!(name = ni_json_string_value(values[0])) || strcmp(name, "lacp"))
+		ret = 1;
+	if (!ni_json_int64_get(values[1], &prio) || prio != 4999)
+		ret = 1;
+	if (!ni_json_int64_get(ni_json_object_get_value(values[2], "lacp_key"), &prio) || prio != 0)
+		ret = 1;
+	if (values[3])
+		ret = 1;
+	for (i = 0; i < 4; ++i)
+		ni_json_free(values[i]);
+
+	if (ni_json_extract_string("{ \"a\": [ 1, 2 ", paths, values) != -1)
+		ret = 1;
+
+	printf("#--> j4: %s\n", ret ? "FAILED" : "OK");
+	free(doc);
+	return ret;
+}
+
 int
 main(int argc, char **argv)
 {
-	int n;
+	int n, ret = 0;
 
 	if (argc == 1) {
 		test_case1();
 		test_case2();
+		ret |= test_case3();
+		ret |= test_case4();
 	}
 
 	for (n = 1; n < argc; ++n) {
@@ -206,6 +422,6 @@ main(int argc, char **argv)
 		printf("\n");
 	}
 
-	return 0;
+	return ret;
 }
 
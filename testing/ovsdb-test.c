@@ -0,0 +1,622 @@
+/*
+ *	OVSDB client test against a forked minimal OVSDB server
+ *
+ *	Copyright (C) 2026 SUSE Linux GmbH, Nuernberg, Germany.
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	This program is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along
+ *	with this program; if not, see <http://www.gnu.org/licenses/> or write
+ *	to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *	Boston, MA 02110-1301 USA.
+ *
+ *	The server implements "monitor" and "transact" with the insert,
+ *	mutate and delete operations on the Open_vSwitch, Bridge, Port
+ *	and Interface tables including the garbage collection of the
+ *	unreferenced rows. It sends the update notification before the
+ *	transact reply as ovsdb-server does and exits with the number
+ *	of transactions, which is used to verify that no-op requests
+ *	are served from the client cache.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include <wicked/netinfo.h>
+#include <wicked/logging.h>
+#include <wicked/ovs.h>
+
+#include "ovs.h"
+#include "json.h"
+
+/*
+ * Mock server
+ */
+static ni_json_t *		mock_db;
+static unsigned int		mock_uuids;
+static unsigned int		mock_transacts;
+
+static const char *		mock_tables[] = {
+	"Open_vSwitch", "Bridge", "Port", "Interface", NULL
+};
+
+static char *
+mock_format(ni_json_t *json)
+{
+	ni_stringbuf_t buf = NI_STRINGBUF_INIT_DYNAMIC;
+
+	ni_json_format_string(&buf, json, NULL);
+	return buf.string;
+}
+
+static void
+mock_send(int fd, ni_json_t *msg)
+{
+	char *str = mock_format(msg);
+
+	if (str && write(fd, str, strlen(str)) < 0)
+		_exit(255);
+	free(str);
+	ni_json_free(msg);
+}
+
+static ni_json_t *
+mock_uuid(const char *type, const char *uuid)
+{
+	ni_json_t *atom = ni_json_new_array();
+
+	ni_json_array_append(atom, ni_json_new_string(type));
+	ni_json_array_append(atom, ni_json_new_string(uuid));
+	return atom;
+}
+
+/* collect the uuids of a column value into an array of strings */
+static void
+mock_uuids_get(ni_json_t *value, ni_string_array_t *uuids)
+{
+	const char *type = ni_json_string_value(ni_json_array_get(value, 0));
+	ni_json_t *atom;
+	unsigned int i;
+
+	if (ni_string_eq(type, "uuid")) {
+		ni_string_array_append(uuids, ni_json_string_value(ni_json_array_get(value, 1)));
+	} else
+	if (ni_string_eq(type, "set")) {
+		for (i = 0; (atom = ni_json_array_get(ni_json_array_get(value, 1), i)); ++i)
+			ni_string_array_append(uuids, ni_json_string_value(ni_json_array_get(atom, 1)));
+	}
+}
+
+/* a set with one element is sent as a bare atom */
+static ni_json_t *
+mock_uuids_set(const ni_string_array_t *uuids)
+{
+	ni_json_t *set, *elems;
+	unsigned int i;
+
+	if (uuids->count == 1)
+		return mock_uuid("uuid", uuids->data[0]);
+
+	elems = ni_json_new_array();
+	for (i = 0; i < uuids->count; ++i)
+		ni_json_array_append(elems, mock_uuid("uuid", uuids->data[i]));
+	set = ni_json_new_array();
+	ni_json_array_append(set, ni_json_new_string("set"));
+	ni_json_array_append(set, elems);
+	return set;
+}
+
+/* replace ["named-uuid", name] references with real uuids */
+static ni_json_t *
+mock_resolve(ni_json_t *value, ni_json_t *names)
+{
+	unsigned int i;
+
+	if (ni_json_is_array(value)) {
+		if (ni_string_eq(ni_json_string_value(ni_json_array_get(value, 0)), "named-uuid")) {
+			const char *name = ni_json_string_value(ni_json_array_get(value, 1));
+			ni_json_t *atom;
+
+			atom = mock_uuid("uuid", ni_json_string_value(ni_json_object_get_value(names, name)));
+			ni_json_free(value);
+			return atom;
+		}
+		for (i = 0; i < ni_json_array_entries(value); ++i)
+			ni_json_array_set(value, i, mock_resolve(ni_json_array_ref(value, i), names));
+	} else
+	if (ni_json_is_object(value)) {
+		for (i = 0; i < ni_json_object_entries(value); ++i) {
+			ni_json_pair_t *pair = ni_json_object_get_pair_at(value, i);
+
+			ni_json_pair_set_value(pair, mock_resolve(ni_json_pair_ref_value(pair), names));
+		}
+	}
+	return value;
+}
+
+static void
+mock_collect_refs(const char *table, const char *column, ni_string_array_t *refs)
+{
+	ni_json_t *rows = ni_json_object_get_value(mock_db, table);
+	unsigned int i;
+
+	for (i = 0; i < ni_json_object_entries(rows); ++i) {
+		ni_json_t *row = ni_json_pair_get_value(ni_json_object_get_pair_at(rows, i));
+
+		mock_uuids_get(ni_json_object_get_value(row, column), refs);
+	}
+}
+
+/* remove rows which are not referenced any more */
+static void
+mock_garbage_collect(void)
+{
+	static const struct { const char *table, *parent, *column; } gc[] = {
+		{ "Bridge",	"Open_vSwitch",	"bridges"	},
+		{ "Port",	"Bridge",	"ports"		},
+		{ "Interface",	"Port",		"interfaces"	},
+		{ NULL, NULL, NULL }
+	};
+	unsigned int i, n;
+
+	for (i = 0; gc[i].table; ++i) {
+		ni_string_array_t refs = NI_STRING_ARRAY_INIT;
+		ni_json_t *rows = ni_json_object_get_value(mock_db, gc[i].table);
+
+		mock_collect_refs(gc[i].parent, gc[i].column, &refs);
+		for (n = ni_json_object_entries(rows); n-- > 0; ) {
+			ni_json_pair_t *pair = ni_json_object_get_pair_at(rows, n);
+
+			if (ni_string_array_index(&refs, ni_json_pair_get_name(pair)) < 0)
+				ni_json_object_delete_at(rows, n);
+		}
+		ni_string_array_destroy(&refs);
+	}
+}
+
+static ni_bool_t
+mock_where_match(ni_json_t *where, const char *uuid)
+{
+	ni_json_t *cond = ni_json_array_get(where, 0);
+
+	if (!cond)
+		return TRUE;
+	return ni_string_eq(ni_json_string_value(ni_json_array_get(ni_json_array_get(cond, 2), 1)), uuid);
+}
+
+static void
+mock_op_mutate(ni_json_t *op, ni_json_t *names)
+{
+	ni_json_t *rows = ni_json_object_get_value(mock_db, ni_json_string_value(ni_json_object_get_value(op, "table")));
+	ni_json_t *where = ni_json_object_get_value(op, "where");
+	ni_json_t *mutations = ni_json_object_get_value(op, "mutations");
+	ni_json_t *mutation;
+	unsigned int i, m;
+
+	for (i = 0; i < ni_json_object_entries(rows); ++i) {
+		ni_json_pair_t *pair = ni_json_object_get_pair_at(rows, i);
+		ni_json_t *row = ni_json_pair_get_value(pair);
+
+		if (!mock_where_match(where, ni_json_pair_get_name(pair)))
+			continue;
+
+		for (m = 0; (mutation = ni_json_array_get(mutations, m)); ++m) {
+			ni_string_array_t have = NI_STRING_ARRAY_INIT;
+			ni_string_array_t args = NI_STRING_ARRAY_INIT;
+			const char *column = ni_json_string_value(ni_json_array_get(mutation, 0));
+			const char *mutator = ni_json_string_value(ni_json_array_get(mutation, 1));
+			unsigned int a;
+
+			mock_uuids_get(ni_json_object_get_value(row, column), &have);
+			mock_uuids_get(mock_resolve(ni_json_array_get(mutation, 2), names), &args);
+			for (a = 0; a < args.count; ++a) {
+				int pos = ni_string_array_index(&have, args.data[a]);
+
+				if (ni_string_eq(mutator, "insert") && pos < 0)
+					ni_string_array_append(&have, args.data[a]);
+				else if (ni_string_eq(mutator, "delete") && pos >= 0)
+					ni_string_array_remove_index(&have, pos);
+			}
+			ni_json_object_set(row, column, mock_uuids_set(&have));
+			ni_string_array_destroy(&have);
+			ni_string_array_destroy(&args);
+		}
+	}
+}
+
+static ni_json_t *
+mock_op_insert(ni_json_t *op, ni_json_t *names)
+{
+	const char *table = ni_json_string_value(ni_json_object_get_value(op, "table"));
+	const char *uuid_name = ni_json_string_value(ni_json_object_get_value(op, "uuid-name"));
+	ni_json_t *row, *result;
+	char uuid[64];
+
+	snprintf(uuid, sizeof(uuid), "00000000-0000-0000-0000-%012u", ++mock_uuids);
+	if (uuid_name)
+		ni_json_object_set(names, uuid_name, ni_json_new_string(uuid));
+
+	row = mock_resolve(ni_json_object_ref_value(op, "row"), names);
+	ni_json_object_set(ni_json_object_get_value(mock_db, table), uuid, row);
+
+	result = ni_json_new_object();
+	ni_json_object_set(result, "uuid", mock_uuid("uuid", uuid));
+	return result;
+}
+
+/* table updates for the rows differing between old and the current db */
+static ni_json_t *
+mock_updates(ni_json_t *old)
+{
+	ni_json_t *updates = ni_json_new_object();
+	const char **table;
+	unsigned int i;
+
+	for (table = mock_tables; *table; ++table) {
+		ni_json_t *orows = ni_json_object_get_value(old, *table);
+		ni_json_t *nrows = ni_json_object_get_value(mock_db, *table);
+		ni_json_t *tupd = ni_json_new_object();
+
+		for (i = 0; i < ni_json_object_entries(nrows); ++i) {
+			ni_json_pair_t *pair = ni_json_object_get_pair_at(nrows, i);
+			ni_json_t *orow = ni_json_object_get_value(orows, ni_json_pair_get_name(pair));
+			char *a = orow ? mock_format(orow) : NULL;
+			char *b = mock_format(ni_json_pair_get_value(pair));
+
+			if (!ni_string_eq(a, b)) {
+				ni_json_t *upd = ni_json_new_object();
+
+				ni_json_object_set(upd, "new", ni_json_pair_ref_value(pair));
+				ni_json_object_set(tupd, ni_json_pair_get_name(pair), upd);
+			}
+			free(a);
+			free(b);
+		}
+		for (i = 0; i < ni_json_object_entries(orows); ++i) {
+			ni_json_pair_t *pair = ni_json_object_get_pair_at(orows, i);
+
+			if (!ni_json_object_get_value(nrows, ni_json_pair_get_name(pair))) {
+				ni_json_t *upd = ni_json_new_object();
+
+				ni_json_object_set(upd, "old", ni_json_pair_ref_value(pair));
+				ni_json_object_set(tupd, ni_json_pair_get_name(pair), upd);
+			}
+		}
+		if (ni_json_object_entries(tupd))
+			ni_json_object_set(updates, *table, tupd);
+		else
+			ni_json_free(tupd);
+	}
+	return updates;
+}
+
+static ni_json_t *
+mock_transact(int fd, ni_json_t *params)
+{
+	ni_json_t *old, *names, *result, *op, *notify, *nparams;
+	const char *name;
+	unsigned int i;
+
+	mock_transacts++;
+	old = ni_json_clone(mock_db);
+	names = ni_json_new_object();
+	result = ni_json_new_array();
+
+	for (i = 1; (op = ni_json_array_get(params, i)); ++i) {
+		name = ni_json_string_value(ni_json_object_get_value(op, "op"));
+		if (ni_string_eq(name, "insert")) {
+			ni_json_array_append(result, mock_op_insert(op, names));
+		} else
+		if (ni_string_eq(name, "mutate")) {
+			mock_op_mutate(op, names);
+			ni_json_array_append(result, ni_json_new_object());
+		} else {
+			ni_json_t *error = ni_json_new_object();
+
+			ni_json_object_set(error, "error", ni_json_new_string("not supported"));
+			ni_json_array_append(result, error);
+		}
+	}
+	mock_garbage_collect();
+
+	nparams = ni_json_new_array();
+	ni_json_array_append(nparams, ni_json_new_null());
+	ni_json_array_append(nparams, mock_updates(old));
+	notify = ni_json_new_object();
+	ni_json_object_set(notify, "id", ni_json_new_null());
+	ni_json_object_set(notify, "method", ni_json_new_string("update"));
+	ni_json_object_set(notify, "params", nparams);
+	mock_send(fd, notify);
+
+	ni_json_free(names);
+	ni_json_free(old);
+	return result;
+}
+
+static ni_json_t *
+mock_monitor(void)
+{
+	ni_json_t *empty = ni_json_new_object();
+	ni_json_t *result = mock_updates(empty);
+
+	ni_json_free(empty);
+	return result;
+}
+
+static void
+mock_request(int fd, ni_json_t *msg)
+{
+	const char *method = ni_json_string_value(ni_json_object_get_value(msg, "method"));
+	ni_json_t *params = ni_json_object_get_value(msg, "params");
+	ni_json_t *reply, *result;
+
+	if (ni_string_eq(method, "monitor"))
+		result = mock_monitor();
+	else if (ni_string_eq(method, "transact"))
+		result = mock_transact(fd, params);
+	else if (ni_string_eq(method, "echo"))
+		result = ni_json_ref(params);
+	else
+		result = ni_json_new_null();
+
+	reply = ni_json_new_object();
+	ni_json_object_set(reply, "id", ni_json_object_ref_value(msg, "id"));
+	ni_json_object_set(reply, "result", result);
+	ni_json_object_set(reply, "error", ni_json_new_null());
+	mock_send(fd, reply);
+}
+
+static int
+mock_server_run(int fd)
+{
+	char buf[65536];
+	size_t len = 0, pos;
+	unsigned int depth;
+	ni_bool_t string, escape;
+	const char **table;
+	ni_json_t *msg;
+	ssize_t cnt;
+	char save;
+
+	mock_db = ni_json_new_object();
+	for (table = mock_tables; *table; ++table)
+		ni_json_object_set(mock_db, *table, ni_json_new_object());
+	ni_json_object_set(ni_json_object_get_value(mock_db, "Open_vSwitch"),
+			"00000000-0000-0000-0000-000000000000", ni_json_new_object());
+
+	while ((cnt = read(fd, buf + len, sizeof(buf) - len - 1)) > 0) {
+		len += cnt;
+		for (;;) {
+			depth = 0;
+			string = escape = FALSE;
+			for (pos = 0; pos < len; ++pos) {
+				if (string) {
+					if (escape)
+						escape = FALSE;
+					else if (buf[pos] == '\\')
+						escape = TRUE;
+					else if (buf[pos] == '"')
+						string = FALSE;
+				} else if (buf[pos] == '"') {
+					string = TRUE;
+				} else if (buf[pos] == '{') {
+					depth++;
+				} else if (buf[pos] == '}' && --depth == 0) {
+					break;
+				}
+			}
+			if (pos >= len)
+				break;
+
+			save = buf[++pos];
+			buf[pos] = '\0';
+			if (!(msg = ni_json_parse_string(buf)))
+				return 255;
+			buf[pos] = save;
+			mock_request(fd, msg);
+			ni_json_free(msg);
+
+			len -= pos;
+			memmove(buf, buf + pos, len);
+		}
+	}
+	return mock_transacts;
+}
+
+/*
+ * Client test cases
+ */
+static unsigned int		failed;
+
+#define CHECK(cond)	do { \
+		if (!(cond)) { \
+			ni_error("%s:%d: check failed: %s", __FILE__, __LINE__, #cond); \
+			failed++; \
+		} \
+	} while (0)
+
+static ni_bool_t
+check_ports(const char *brname, const char *expected)
+{
+	ni_stringbuf_t names = NI_STRINGBUF_INIT_DYNAMIC;
+	ni_ovs_bridge_port_array_t ports;
+	ni_bool_t ret = FALSE;
+	unsigned int i;
+
+	ni_ovs_bridge_port_array_init(&ports);
+
+	if (ni_ovsdb_bridge_ports(brname, &ports) == 0) {
+		for (i = 0; i < ports.count; ++i) {
+			if (names.len)
+				ni_stringbuf_putc(&names, ' ');
+			ni_stringbuf_puts(&names, ports.data[i]->device.name);
+		}
+		ret = ni_string_eq(names.string ?: "", expected);
+		if (!ret)
+			ni_error("%s: ports '%s', expected '%s'", brname, names.string ?: "", expected);
+	}
+	ni_stringbuf_destroy(&names);
+	ni_ovs_bridge_port_array_destroy(&ports);
+	return ret;
+}
+
+static ni_bool_t
+check_port_bridge(const char *pname, const char *expected)
+{
+	char *brname = NULL;
+	ni_bool_t ret;
+
+	ret = ni_ovsdb_bridge_port_to_bridge(pname, &brname) == 0 &&
+		ni_string_eq(brname, expected);
+	ni_string_free(&brname);
+	return ret;
+}
+
+static ni_netdev_t *
+bridge_config(const char *name, const char *parent, uint16_t tag, const char *port, ...)
+{
+	ni_netdev_t *cfg = ni_netdev_new(name, 0);
+	va_list ap;
+
+	cfg->link.type = NI_IFTYPE_OVS_BRIDGE;
+	cfg->ovsbr = ni_ovs_bridge_new();
+	if (parent) {
+		ni_string_dup(&cfg->ovsbr->config.vlan.parent.name, parent);
+		cfg->ovsbr->config.vlan.tag = tag;
+	}
+	va_start(ap, port);
+	for (; port; port = va_arg(ap, const char *))
+		ni_ovs_bridge_port_array_add_new(&cfg->ovsbr->ports, port);
+	va_end(ap);
+	return cfg;
+}
+
+static void
+run_tests(void)
+{
+	ni_ovs_bridge_port_config_t pconf;
+	ni_netdev_t *cfg, *dev;
+	char *parent = NULL;
+	uint16_t vlan = 0;
+
+	CHECK(ni_ovsdb_bridge_exists("br0") < 0);
+
+	/* bridge with its ports in one transaction */
+	cfg = bridge_config("br0", NULL, 0, "eth0", "eth1", NULL);
+	CHECK(ni_ovsdb_bridge_add(cfg, TRUE) == 0);
+	CHECK(ni_ovsdb_bridge_exists("br0") == 0);
+	CHECK(check_ports("br0", "eth0 eth1"));
+	CHECK(ni_ovsdb_bridge_to_parent("br0", &parent) == 0 && parent == NULL);
+	CHECK(ni_ovsdb_bridge_to_vlan("br0", &vlan) == 0 && vlan == 0);
+	/* served from cache */
+	CHECK(ni_ovsdb_bridge_add(cfg, TRUE) == 0);
+	CHECK(ni_ovsdb_bridge_add(cfg, FALSE) < 0);
+	ni_netdev_put(cfg);
+
+	/* fake vlan bridge */
+	cfg = bridge_config("br0.10", "br0", 10, "eth2", NULL);
+	CHECK(ni_ovsdb_bridge_add(cfg, TRUE) == 0);
+	ni_netdev_put(cfg);
+	CHECK(ni_ovsdb_bridge_exists("br0.10") == 0);
+	CHECK(ni_ovsdb_bridge_to_parent("br0.10", &parent) == 0 && ni_string_eq(parent, "br0"));
+	CHECK(ni_ovsdb_bridge_to_vlan("br0.10", &vlan) == 0 && vlan == 10);
+	ni_string_free(&parent);
+	CHECK(check_ports("br0.10", "eth2"));
+	CHECK(check_ports("br0", "eth0 eth1"));
+	CHECK(check_port_bridge("eth0", "br0"));
+	CHECK(check_port_bridge("eth2", "br0.10"));
+
+	/* ports */
+	ni_ovs_bridge_port_config_init(&pconf);
+	ni_string_dup(&pconf.bridge.name, "br0");
+	CHECK(ni_ovsdb_bridge_port_add("eth0", &pconf, TRUE) == 0);
+	CHECK(ni_ovsdb_bridge_port_add("eth0", &pconf, FALSE) < 0);
+	CHECK(ni_ovsdb_bridge_port_add("eth2", &pconf, TRUE) < 0);
+	ni_string_dup(&pconf.bridge.name, "br0.10");
+	CHECK(ni_ovsdb_bridge_port_add("eth3", &pconf, TRUE) == 0);
+	ni_ovs_bridge_port_config_destroy(&pconf);
+	CHECK(check_port_bridge("eth3", "br0.10"));
+	CHECK(check_ports("br0.10", "eth2 eth3"));
+
+	CHECK(ni_ovsdb_bridge_port_del("br0", "eth1") == 0);
+	CHECK(check_ports("br0", "eth0"));
+	CHECK(ni_ovsdb_bridge_port_del("br0", "eth2") < 0);
+
+	/* discovery */
+	dev = ni_netdev_new("br0.10", 0);
+	dev->link.type = NI_IFTYPE_OVS_BRIDGE;
+	CHECK(ni_ovs_bridge_discover(dev, NULL) == 0);
+	CHECK(dev->ovsbr && dev->ovsbr->config.vlan.tag == 10 &&
+		ni_string_eq(dev->ovsbr->config.vlan.parent.name, "br0") &&
+		dev->ovsbr->ports.count == 2);
+	ni_netdev_put(dev);
+
+	/* removal */
+	CHECK(ni_ovsdb_bridge_del("br0.10") == 0);
+	CHECK(ni_ovsdb_bridge_exists("br0.10") < 0);
+	CHECK(check_ports("br0", "eth0"));
+	CHECK(ni_ovsdb_bridge_del("br0") == 0);
+	CHECK(ni_ovsdb_bridge_exists("br0") < 0);
+	CHECK(ni_ovsdb_bridge_del("br0") == 0);
+}
+
+int main(int argc, char *argv[])
+{
+	int sv[2], status;
+	pid_t pid;
+
+	(void)argc;
+	(void)argv;
+
+	if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) < 0)
+		return 1;
+
+	if ((pid = fork()) < 0)
+		return 1;
+	if (pid == 0) {
+		close(sv[0]);
+		_exit(mock_server_run(sv[1]));
+	}
+	close(sv[1]);
+
+	ni_log_init();
+	if (ni_init("ovsdb-test") < 0)
+		return 1;
+
+	if (!ni_ovsdb_connect_fd(sv[0])) {
+		ni_error("unable to monitor the ovsdb tables");
+		return 1;
+	}
+	run_tests();
+	ni_ovsdb_disconnect();
+
+	if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status)) {
+		ni_error("ovsdb server did not exit properly");
+		return 1;
+	}
+	/* add br0, add br0.10, add eth3, del eth1, del br0.10, del br0 */
+	if (WEXITSTATUS(status) != 6) {
+		ni_error("ovsdb server received %u transactions, expected 6",
+				WEXITSTATUS(status));
+		failed++;
+	}
+
+	printf("%s\n", failed ? "FAILED" : "OK");
+	return failed ? 1 : 0;
+}
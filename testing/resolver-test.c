@@ -0,0 +1,649 @@
+/*
+ *	In-process reverse resolver test
+ *
+ *	Copyright (C) 2026 SUSE Linux GmbH, Nuernberg, Germany.
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	This program is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along
+ *	with this program; if not, see <http://www.gnu.org/licenses/> or write
+ *	to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *	Boston, MA 02110-1301 USA.
+ *
+ *	Usage:
+ *		resolver-test [-n lookups]
+ *
+ *	Runs two fake nameservers on 127.0.0.1 and 127.0.0.2 in the event
+ *	loop of the test itself, points the reverse resolver to them using
+ *	a temporary resolv.conf and hosts file and checks answers, negative
+ *	and failing replies, retransmits, timeouts, cancelation and hosts
+ *	file entries. Then reports the time needed to resolve <lookups>
+ *	(default 1000) addresses concurrently.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <wicked/util.h>
+#include <wicked/logging.h>
+#include <wicked/address.h>
+#include <wicked/resolver.h>
+#include <wicked/socket.h>
+#include "socket_priv.h"
+#include "util_priv.h"
+
+#define TEST_TIMEOUT		1000	/* msec per lookup */
+#define TEST_SERVERS		2
+
+static unsigned int		failed;
+
+#define CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			fprintf(stderr, "%s:%u: check failed: %s\n", __FILE__, __LINE__, #cond); \
+			failed++; \
+		} \
+	} while (0)
+
+enum {
+	TEST_ANSWER = 0,
+	TEST_NXDOMAIN,
+	TEST_DROP,
+	TEST_DROP_FIRST,
+	TEST_SERVFAIL_FIRST,
+	TEST_WRONG_ID_FIRST,
+	TEST_BAD_NAME,
+};
+
+static const struct test_entry {
+	const char *		address;
+	int			action;
+	const char *		hostname;
+} test_entries[] = {
+	{ "192.0.2.1",		TEST_ANSWER,		"host1.example.com"	},
+	{ "192.0.2.2",		TEST_NXDOMAIN,		NULL			},
+	{ "192.0.2.3",		TEST_DROP,		NULL			},
+	{ "192.0.2.4",		TEST_SERVFAIL_FIRST,	"host4.example.com"	},
+	{ "192.0.2.5",		TEST_DROP_FIRST,	"host5.example.com"	},
+	{ "192.0.2.6",		TEST_WRONG_ID_FIRST,	"host6.example.com"	},
+	{ "192.0.2.7",		TEST_BAD_NAME,		NULL			},
+	{ "2001:db8::1",	TEST_ANSWER,		"host1.example.org"	},
+	{ NULL }
+};
+
+static struct test_server {
+	ni_socket_t *		sock;
+	unsigned int		queries;
+} test_servers[TEST_SERVERS];
+
+static struct {
+	char			name[256];
+	unsigned int		seen;
+} test_seen[16];
+
+/* distinct source ports the queries came from */
+static struct {
+	unsigned char		seen[65536 / 8];
+	unsigned int		count;
+} test_ports;
+
+struct test_result {
+	ni_bool_t		done;
+	char *			hostname;
+	struct timeval		finished;
+};
+
+/*
+ * The in-process nameserver side
+ */
+static const struct test_entry *
+test_entry_find(const char *qname, char *hostname, size_t size)
+{
+	ni_sockaddr_t addr;
+	const struct test_entry *e;
+	unsigned int a, b;
+	char ptr[128];
+	int end = 0;
+
+	/* the bulk addresses 10.0.a.b resolve to h-a-b.example.com */
+	if (sscanf(qname, "%u.%u.0.10.in-addr.arpa%n", &b, &a, &end) == 2 &&
+	    end == (int)strlen(qname)) {
+		static const struct test_entry bulk = { NULL, TEST_ANSWER, NULL };
+
+		snprintf(hostname, size, "h-%u-%u.example.com", a, b);
+		return &bulk;
+	}
+
+	for (e = test_entries; e->address; ++e) {
+		const unsigned char *ap;
+		int i;
+
+		if (ni_sockaddr_parse(&addr, e->address, AF_UNSPEC) < 0)
+			continue;
+
+		if (addr.ss_family == AF_INET) {
+			ap = (const unsigned char *)&addr.sin.sin_addr;
+			snprintf(ptr, sizeof(ptr), "%u.%u.%u.%u.in-addr.arpa",
+					ap[3], ap[2], ap[1], ap[0]);
+		} else {
+			ap = (const unsigned char *)&addr.six.sin6_addr;
+			for (ptr[0] = '\0', i = 15; i >= 0; --i)
+				snprintf(ptr + strlen(ptr), sizeof(ptr) - strlen(ptr),
+						"%x.%x.", ap[i] & 0x0f, ap[i] >> 4);
+			strncat(ptr, "ip6.arpa", sizeof(ptr) - strlen(ptr) - 1);
+		}
+		if (strcasecmp(ptr, qname))
+			continue;
+
+		snprintf(hostname, size, "%s", e->hostname ? e->hostname : "bad_name!");
+		return e;
+	}
+	return NULL;
+}
+
+static unsigned int
+test_seen_count(const char *qname)
+{
+	unsigned int i;
+
+	for (i = 0; i < sizeof(test_seen) / sizeof(test_seen[0]); ++i) {
+		if (!test_seen[i].seen) {
+			snprintf(test_seen[i].name, sizeof(test_seen[i].name), "%s", qname);
+			return ++test_seen[i].seen;
+		}
+		if (!strcmp(test_seen[i].name, qname))
+			return ++test_seen[i].seen;
+	}
+	return 1;
+}
+
+static size_t
+test_put_name(unsigned char *msg, size_t len, const char *name)
+{
+	const char *label = name, *dot;
+	size_t n;
+
+	do {
+		dot = strchr(label, '.');
+		n = dot ? (size_t)(dot - label) : strlen(label);
+		msg[len++] = n;
+		memcpy(msg + len, label, n);
+		len += n;
+		label = dot + 1;
+	} while (dot);
+	msg[len++] = 0;
+	return len;
+}
+
+static void
+test_server_reply(ni_socket_t *sock, const ni_sockaddr_t *from, socklen_t alen,
+			const unsigned char *query, size_t qlen, unsigned int id,
+			unsigned int rcode, const char *hostname)
+{
+	unsigned char msg[1024];
+	size_t len = qlen, rdata;
+
+	memcpy(msg, query, qlen);
+	msg[0] = id >> 8;
+	msg[1] = id & 0xff;
+	msg[2] = 0x81;			/* response, recursion desired */
+	msg[3] = 0x80 | rcode;		/* recursion available */
+	msg[6] = 0;
+	msg[7] = hostname ? 1 : 0;
+	msg[8] = msg[9] = msg[10] = msg[11] = 0;
+
+	if (hostname) {
+		/* owner compressed to the question, type PTR class IN ttl 60 */
+		static const unsigned char rr[] = {
+			0xc0, 0x0c, 0x00, 0x0c, 0x00, 0x01, 0x00, 0x00, 0x00, 0x3c
+		};
+
+		memcpy(msg + len, rr, sizeof(rr));
+		len += sizeof(rr);
+		rdata = len;
+		len = test_put_name(msg, len + 2, hostname);
+		msg[rdata] = (len - rdata - 2) >> 8;
+		msg[rdata + 1] = (len - rdata - 2) & 0xff;
+	}
+	if (sendto(sock->__fd, msg, len, 0, &from->sa, alen) < 0)
+		fprintf(stderr, "test server cannot send: %m\n");
+}
+
+static void
+test_server_query(struct test_server *srv, ni_socket_t *sock, unsigned char *msg,
+			size_t len, const ni_sockaddr_t *from, socklen_t alen)
+{
+	unsigned int server = srv - test_servers;
+	const struct test_entry *e;
+	char qname[256], hostname[256];
+	unsigned int id, seen;
+	size_t pos, n, qlen;
+
+	srv->queries++;
+	id = (msg[0] << 8) | msg[1];
+
+	n = ntohs(from->ss_family == AF_INET6 ? from->six.sin6_port : from->sin.sin_port);
+	if (!(test_ports.seen[n / 8] & (1 << (n % 8)))) {
+		test_ports.seen[n / 8] |= 1 << (n % 8);
+		test_ports.count++;
+	}
+
+	for (pos = 12, qname[0] = '\0'; pos < len && msg[pos]; pos += n + 1) {
+		n = msg[pos];
+		if (pos + 1 + n > len || strlen(qname) + n + 2 > sizeof(qname))
+			return;
+		if (qname[0])
+			strcat(qname, ".");
+		strncat(qname, (const char *)msg + pos + 1, n);
+	}
+	qlen = pos + 5;
+	if (qlen > len)
+		return;
+
+	if (!(e = test_entry_find(qname, hostname, sizeof(hostname)))) {
+		test_server_reply(sock, from, alen, msg, qlen, id, 3, NULL);
+		return;
+	}
+
+	seen = e->address ? test_seen_count(qname) : 1;
+	switch (e->action) {
+	case TEST_NXDOMAIN:
+		test_server_reply(sock, from, alen, msg, qlen, id, 3, NULL);
+		break;
+	case TEST_DROP:
+		break;
+	case TEST_DROP_FIRST:
+		if (seen > 1)
+			test_server_reply(sock, from, alen, msg, qlen, id, 0, hostname);
+		break;
+	case TEST_SERVFAIL_FIRST:
+		if (server == 0)
+			test_server_reply(sock, from, alen, msg, qlen, id, 2, NULL);
+		else
+			test_server_reply(sock, from, alen, msg, qlen, id, 0, hostname);
+		break;
+	case TEST_WRONG_ID_FIRST:
+		test_server_reply(sock, from, alen, msg, qlen, id ^ 0x5a5a, 0, "wrong.example.com");
+		/* fall through */
+	default:
+		test_server_reply(sock, from, alen, msg, qlen, id, 0, hostname);
+		break;
+	}
+}
+
+static void
+test_server_recv(ni_socket_t *sock)
+{
+	struct test_server *srv = sock->user_data;
+	unsigned char msg[1024];
+	ni_sockaddr_t from;
+	socklen_t alen;
+	ssize_t len;
+
+	alen = sizeof(from);
+	while ((len = recvfrom(sock->__fd, msg, sizeof(msg), 0, &from.sa, &alen)) >= 0) {
+		if (len >= 12)
+			test_server_query(srv, sock, msg, len, &from, alen);
+		alen = sizeof(from);
+	}
+}
+
+static uint16_t
+test_servers_start(void)
+{
+	const char *addrs[TEST_SERVERS] = { "127.0.0.1", "127.0.0.2" };
+	uint16_t port = 0;
+	unsigned int i;
+
+	for (i = 0; i < TEST_SERVERS; ++i) {
+		ni_sockaddr_t addr;
+		socklen_t alen = sizeof(addr.sin);
+		int fd;
+
+		ni_sockaddr_parse(&addr, addrs[i], AF_INET);
+		addr.sin.sin_port = htons(port);
+		if ((fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) < 0 ||
+		    bind(fd, &addr.sa, alen) < 0 ||
+		    getsockname(fd, &addr.sa, &alen) < 0) {
+			fprintf(stderr, "Cannot bind test server to %s: %m\n", addrs[i]);
+			if (fd >= 0)
+				close(fd);
+			return 0;
+		}
+		port = ntohs(addr.sin.sin_port);
+
+		test_servers[i].sock = ni_socket_wrap(fd, SOCK_DGRAM);
+		test_servers[i].sock->user_data = &test_servers[i];
+		test_servers[i].sock->receive = test_server_recv;
+		ni_socket_activate(test_servers[i].sock);
+	}
+	return port;
+}
+
+static void
+test_servers_stop(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < TEST_SERVERS; ++i) {
+		if (test_servers[i].sock)
+			ni_socket_close(test_servers[i].sock);
+		test_servers[i].sock = NULL;
+	}
+}
+
+static unsigned int
+test_queries(void)
+{
+	unsigned int i, n = 0;
+
+	for (i = 0; i < TEST_SERVERS; ++i)
+		n += test_servers[i].queries;
+	return n;
+}
+
+static void
+test_queries_reset(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < TEST_SERVERS; ++i)
+		test_servers[i].queries = 0;
+}
+
+/*
+ * The resolver side
+ */
+static void
+test_done(ni_resolve_reverse_t *req, const char *hostname, void *user_data)
+{
+	struct test_result *res = user_data;
+
+	(void)req;
+	CHECK(!res->done);
+	res->done = TRUE;
+	ni_string_dup(&res->hostname, hostname);
+	ni_timer_get_time(&res->finished);
+}
+
+static long
+test_msecs(const struct timeval *beg, const struct timeval *end)
+{
+	return (end->tv_sec - beg->tv_sec) * 1000 + (end->tv_usec - beg->tv_usec) / 1000;
+}
+
+static void
+test_wait(struct test_result *res, unsigned int count, long timeout)
+{
+	struct timeval beg, now;
+	unsigned int i;
+
+	ni_timer_get_time(&beg);
+	do {
+		for (i = 0; i < count && res[i].done; ++i)
+			;
+		if (i == count)
+			return;
+
+		if (ni_socket_wait(50) < 0)
+			return;
+		ni_timer_get_time(&now);
+	} while (test_msecs(&beg, &now) < timeout);
+}
+
+static long
+test_lookup(const char *address, struct test_result *res)
+{
+	struct timeval beg;
+	ni_sockaddr_t addr;
+
+	memset(res, 0, sizeof(*res));
+	ni_sockaddr_parse(&addr, address, AF_UNSPEC);
+	ni_timer_get_time(&beg);
+	if (!ni_resolve_reverse_start(&addr, TEST_TIMEOUT, test_done, res))
+		return -1;
+
+	test_wait(res, 1, 3 * TEST_TIMEOUT);
+	CHECK(res->done);
+	return res->done ? test_msecs(&beg, &res->finished) : -1;
+}
+
+static void
+test_reverse_lookups(void)
+{
+	struct test_result res;
+	const struct test_entry *e;
+	long msecs;
+
+	for (e = test_entries; e->address; ++e) {
+		test_queries_reset();
+		msecs = test_lookup(e->address, &res);
+		if (!ni_string_eq(res.hostname, e->hostname)) {
+			fprintf(stderr, "%s resolved to %s instead of %s\n", e->address,
+					res.hostname ? res.hostname : "nothing",
+					e->hostname ? e->hostname : "nothing");
+			failed++;
+		}
+
+		switch (e->action) {
+		case TEST_DROP:
+			/* both servers asked twice until the timeout */
+			CHECK(msecs >= TEST_TIMEOUT - 10);
+			CHECK(test_servers[0].queries == 2);
+			CHECK(test_servers[1].queries == 2);
+			break;
+		case TEST_DROP_FIRST:
+			/* retransmitted to the second one */
+			CHECK(msecs >= TEST_TIMEOUT / 4 - 10 && msecs < TEST_TIMEOUT);
+			CHECK(test_servers[1].queries == 1);
+			break;
+		case TEST_SERVFAIL_FIRST:
+			/* asks the second one right away */
+			CHECK(msecs < TEST_TIMEOUT / 4);
+			CHECK(test_queries() == 2);
+			break;
+		default:
+			CHECK(msecs >= 0 && msecs < TEST_TIMEOUT / 4);
+			CHECK(test_servers[0].queries == 1);
+			break;
+		}
+		ni_string_free(&res.hostname);
+	}
+}
+
+static void
+test_hosts_lookup(void)
+{
+	struct test_result res;
+	ni_sockaddr_t addr;
+	char *name = NULL;
+
+	test_queries_reset();
+	test_lookup("192.0.2.10", &res);
+	CHECK(ni_string_eq(res.hostname, "hosts-entry.example.net"));
+	ni_string_free(&res.hostname);
+
+	test_lookup("2001:db8::10", &res);
+	CHECK(ni_string_eq(res.hostname, "hosts-entry6.example.net"));
+	ni_string_free(&res.hostname);
+	CHECK(test_queries() == 0);
+
+	/* the synchronous variant does not need the event loop */
+	ni_sockaddr_parse(&addr, "192.0.2.10", AF_UNSPEC);
+	CHECK(ni_resolve_reverse_timed(&addr, &name, 1) == 0);
+	CHECK(ni_string_eq(name, "hosts-entry.example.net"));
+	ni_string_free(&name);
+
+	/* ... and does not dispatch other sockets while waiting */
+	ni_sockaddr_parse(&addr, "192.0.2.1", AF_UNSPEC);
+	CHECK(ni_resolve_reverse_timed(&addr, &name, 1) < 0);
+	CHECK(name == NULL);
+	CHECK(test_queries() == 0);
+}
+
+static void
+test_cancel(void)
+{
+	struct test_result res[2];
+	ni_resolve_reverse_t *req;
+	ni_sockaddr_t addr;
+
+	memset(res, 0, sizeof(res));
+	ni_sockaddr_parse(&addr, "192.0.2.3", AF_UNSPEC);
+	req = ni_resolve_reverse_start(&addr, TEST_TIMEOUT / 2, test_done, &res[0]);
+	CHECK(req != NULL);
+	ni_sockaddr_parse(&addr, "192.0.2.1", AF_UNSPEC);
+	CHECK(ni_resolve_reverse_start(&addr, TEST_TIMEOUT / 2, test_done, &res[1]) != NULL);
+
+	ni_resolve_reverse_cancel(req);
+	test_wait(&res[1], 1, TEST_TIMEOUT);
+	CHECK(res[1].done && ni_string_eq(res[1].hostname, "host1.example.com"));
+
+	test_wait(&res[0], 1, TEST_TIMEOUT);
+	CHECK(!res[0].done);
+	ni_string_free(&res[1].hostname);
+}
+
+static void
+test_resolv_conf_reload(const char *resolv_conf)
+{
+	struct test_result res;
+	FILE *fp;
+
+	if (!(fp = fopen(resolv_conf, "w")))
+		return;
+	fprintf(fp, "# second server only\nnameserver 127.0.0.2\n");
+	fclose(fp);
+
+	test_queries_reset();
+	test_lookup("192.0.2.1", &res);
+	CHECK(ni_string_eq(res.hostname, "host1.example.com"));
+	CHECK(test_servers[0].queries == 0 && test_servers[1].queries == 1);
+	ni_string_free(&res.hostname);
+}
+
+static void
+test_bulk(unsigned int count)
+{
+	struct test_result *res;
+	struct timeval beg, end;
+	unsigned int i, resolved = 0;
+	char name[64];
+
+	res = xcalloc(count, sizeof(res[0]));
+	memset(&test_ports, 0, sizeof(test_ports));
+	ni_timer_get_time(&beg);
+	for (i = 0; i < count; ++i) {
+		ni_sockaddr_t addr;
+
+		memset(&addr, 0, sizeof(addr));
+		addr.sin.sin_family = AF_INET;
+		addr.sin.sin_addr.s_addr = htonl(0x0a000000 + i + 1);
+		CHECK(ni_resolve_reverse_start(&addr, 5 * TEST_TIMEOUT, test_done, &res[i]) != NULL);
+	}
+	test_wait(res, count, 10 * TEST_TIMEOUT);
+	ni_timer_get_time(&end);
+
+	for (i = 0; i < count; ++i) {
+		snprintf(name, sizeof(name), "h-%u-%u.example.com", (i + 1) >> 8, (i + 1) & 0xff);
+		if (ni_string_eq(res[i].hostname, name))
+			resolved++;
+		ni_string_free(&res[i].hostname);
+	}
+	CHECK(resolved == count);
+
+	/* each query is sent from a socket of its own, port reuse is rare */
+	CHECK(test_ports.count > count / 2);
+	printf("%u concurrent lookups: %u resolved in %ld msec from %u source ports\n",
+			count, resolved, test_msecs(&beg, &end), test_ports.count);
+	free(res);
+}
+
+static char *
+test_tempfile(const char *content)
+{
+	char path[] = "/tmp/resolver-test.XXXXXX";
+	int fd;
+
+	if ((fd = mkstemp(path)) < 0)
+		return NULL;
+	if (write(fd, content, strlen(content)) < 0) {
+		close(fd);
+		unlink(path);
+		return NULL;
+	}
+	close(fd);
+	return xstrdup(path);
+}
+
+int
+main(int argc, char **argv)
+{
+	char *resolv_conf, *hosts, buf[128];
+	unsigned int count = 1000;
+	uint16_t port;
+	int c;
+
+	while ((c = getopt(argc, argv, "n:")) != EOF) {
+		switch (c) {
+		case 'n':
+			count = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-n lookups]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (!count || count > 0xffff)
+		return 1;
+
+	ni_log_init();
+
+	if (!(port = test_servers_start()))
+		return 77;
+
+	snprintf(buf, sizeof(buf), "search example.com\nnameserver 127.0.0.1\nnameserver 127.0.0.2\n");
+	resolv_conf = test_tempfile(buf);
+	hosts = test_tempfile("127.0.0.1\tlocalhost\n"
+			"# 192.0.2.1\tcommented.example.net\n"
+			"192.0.2.10\thosts-entry.example.net hosts-entry\n"
+			"2001:db8::10\thosts-entry6.example.net\n");
+	if (!resolv_conf || !hosts) {
+		fprintf(stderr, "Cannot create temporary files\n");
+		return 1;
+	}
+	ni_resolve_reverse_set_config(resolv_conf, hosts, port);
+
+	test_reverse_lookups();
+	test_hosts_lookup();
+	test_cancel();
+	test_bulk(count);
+	test_resolv_conf_reload(resolv_conf);
+
+	test_servers_stop();
+	unlink(resolv_conf);
+	unlink(hosts);
+	free(resolv_conf);
+	free(hosts);
+
+	printf("%s\n", failed ? "FAILED" : "OK");
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,383 @@
+#!/bin/bash
+#
+#	ifup/ifreload/ifdown scale benchmark
+#
+#	Copyright (C) 2026 SUSE Linux GmbH, Nuernberg, Germany.
+#
+#	This program is free software; you can redistribute it and/or modify
+#	it under the terms of the GNU General Public License as published by
+#	the Free Software Foundation; either version 2 of the License, or
+#	(at your option) any later version.
+#
+#	This program is distributed in the hope that it will be useful,
+#	but WITHOUT ANY WARRANTY; without even the implied warranty of
+#	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#	GNU General Public License for more details.
+#
+#	Usage:
+#		ifup-bench.sh [-n scale] [-p ports] [-b bindir] [-C configdir]
+#			      [-o report] [-l label] [-t timeout] [-k]
+#
+#	Runs in a private network and mount namespace with a private
+#	D-Bus system bus, generates <scale> dummy interfaces, <scale>/4
+#	vlans over veth pairs, <scale>/20 bridges with <ports> ports each
+#	and <scale>/20 active-backup bonds with two slaves each, starts
+#	wickedd and wickedd-nanny and times "wicked ifup all", "wicked
+#	ifreload all" (after changing the address of every dummy)
+#	and "wicked ifdown all".
+#
+#	Writes a JSON report with the wall time, the daemon cpu time and
+#	the number of D-Bus messages per phase and the peak RSS of both
+#	daemons, to stdout or to the <report> file. Exits with 77 (skip)
+#	when the namespaces or the D-Bus daemon are not available.
+#
+
+SCALE=100
+PORTS=8
+BINDIR=""
+CONFDIR="/etc/wicked"
+REPORT=""
+LABEL=""
+TIMEOUT=300
+KEEP=false
+
+usage()
+{
+	echo "Usage: `basename $0` [-n scale] [-p ports] [-b bindir] [-C configdir]"
+	echo "                     [-o report] [-l label] [-t timeout] [-k]"
+	exit ${1:-1}
+}
+
+while getopts "n:p:b:C:o:l:t:kh" opt ; do
+	case $opt in
+	n)	SCALE=$OPTARG ;;
+	p)	PORTS=$OPTARG ;;
+	b)	BINDIR=$OPTARG ;;
+	C)	CONFDIR=$OPTARG ;;
+	o)	REPORT=$OPTARG ;;
+	l)	LABEL=$OPTARG ;;
+	t)	TIMEOUT=$OPTARG ;;
+	k)	KEEP=true ;;
+	h)	usage 0 ;;
+	*)	usage ;;
+	esac
+done
+
+number='^[0-9]+$'
+if [[ ! $SCALE =~ $number || ! $PORTS =~ $number || ! $TIMEOUT =~ $number ]]; then
+	usage
+fi
+
+#
+# Re-execute ourself in a private network and mount namespace
+#
+if [ -z "$__IFUP_BENCH_NS" ]; then
+	if [ `id -u` -ne 0 ]; then
+		echo "SKIP: network namespaces require root" >&2
+		exit 77
+	fi
+	if ! unshare --mount --net --propagation private true 2>/dev/null ; then
+		echo "SKIP: unable to create network namespace" >&2
+		exit 77
+	fi
+	export __IFUP_BENCH_NS=1
+	exec unshare --mount --net --propagation private -- "$0" "$@"
+fi
+
+find_binary()
+{
+	local name=$1 dir
+
+	for dir in $BINDIR /usr/sbin /usr/lib/wicked/bin /usr/libexec/wicked/bin ; do
+		if [ -x "$dir/$name" ]; then
+			echo "$dir/$name"
+			return 0
+		fi
+	done
+	type -P "$name"
+}
+
+WICKED=`find_binary wicked`
+WICKEDD=`find_binary wickedd`
+NANNY=`find_binary wickedd-nanny`
+DBUS_DAEMON=`type -P dbus-daemon`
+DBUS_MONITOR=`type -P dbus-monitor`
+DBUS_SEND=`type -P dbus-send`
+
+for bin in "$WICKED" "$WICKEDD" "$NANNY" ; do
+	if [ -z "$bin" ]; then
+		echo "ERR: wicked binaries not found, use -b <bindir>" >&2
+		exit 1
+	fi
+done
+if [ -z "$DBUS_DAEMON" -o -z "$DBUS_MONITOR" -o -z "$DBUS_SEND" ]; then
+	echo "SKIP: dbus-daemon, dbus-monitor or dbus-send not available" >&2
+	exit 77
+fi
+if [ -z "$LABEL" ]; then
+	LABEL=`git -C "$(dirname $0)" describe --always --dirty 2>/dev/null`
+fi
+
+WORKDIR=`mktemp -d /tmp/ifup-bench.XXXXXX` || exit 1
+IFCONFIG=$WORKDIR/ifconfig
+BUS_ADDRESS="unix:path=$WORKDIR/system_bus_socket"
+CLK_TCK=`getconf CLK_TCK`
+PIDS=""
+
+cleanup()
+{
+	local pid
+
+	for pid in $PIDS ; do
+		kill $pid 2>/dev/null
+	done
+	wait 2>/dev/null
+	if $KEEP ; then
+		echo "Logs and configs kept in $WORKDIR" >&2
+	else
+		rm -rf "$WORKDIR"
+	fi
+}
+trap cleanup EXIT
+
+#
+# Private state directories and D-Bus system bus
+#
+mount -t tmpfs tmpfs /run || exit 1
+mkdir -p /run/wicked
+if [ -d /var/lib/wicked ]; then
+	mount -t tmpfs tmpfs /var/lib/wicked || exit 1
+fi
+ip link set lo up
+
+cat > $WORKDIR/bus.conf <<EOF
+<!DOCTYPE busconfig PUBLIC "-//freedesktop//DTD D-Bus Bus Configuration 1.0//EN"
+ "http://www.freedesktop.org/standards/dbus/1.0/busconfig.dtd">
+<busconfig>
+  <type>system</type>
+  <listen>$BUS_ADDRESS</listen>
+  <auth>EXTERNAL</auth>
+  <policy context="default">
+    <allow user="*"/>
+    <allow own="*"/>
+    <allow send_destination="*" eavesdrop="true"/>
+    <allow eavesdrop="true"/>
+  </policy>
+</busconfig>
+EOF
+
+DBUS_PID=`$DBUS_DAEMON --config-file=$WORKDIR/bus.conf --fork --print-pid` || {
+	echo "SKIP: unable to start private dbus-daemon" >&2
+	exit 77
+}
+PIDS="$DBUS_PID"
+export DBUS_SYSTEM_BUS_ADDRESS=$BUS_ADDRESS
+
+#
+# Interface configurations
+#
+NVLANS=$(( SCALE / 4 ))
+NBRIDGES=$(( SCALE / 20 ))
+NBONDS=$(( SCALE / 20 ))
+
+dummy_config()
+{
+	local name=$1 address=$2 master=$3
+
+	echo "<interface>"
+	echo "  <name>$name</name>"
+	if [ -n "$master" ]; then
+		echo "  <link><master>$master</master></link>"
+	fi
+	echo "  <dummy/>"
+	if [ -n "$address" ]; then
+		echo "  <ipv4:static><address><local>$address</local></address></ipv4:static>"
+	fi
+	echo "</interface>"
+}
+
+generate_configs()
+{
+	local octet=$1 i j
+
+	rm -rf $IFCONFIG
+	mkdir -p $IFCONFIG
+
+	for (( i = 0; i < SCALE; ++i )) ; do
+		dummy_config bd$i 10.$(( 64 + i / 256 )).$(( i % 256 )).$octet/24
+	done > $IFCONFIG/dummy.xml
+
+	for (( i = 0; i < NVLANS; ++i )) ; do
+		echo "<interface><name>bv$i</name></interface>"
+		echo "<interface>"
+		echo "  <name>bv$i.100</name>"
+		echo "  <vlan><device>bv$i</device><tag>100</tag></vlan>"
+		echo "  <ipv4:static><address><local>10.32.$i.1/24</local></address></ipv4:static>"
+		echo "</interface>"
+	done > $IFCONFIG/vlan.xml
+
+	for (( i = 0; i < NBRIDGES; ++i )) ; do
+		echo "<interface>"
+		echo "  <name>bbr$i</name>"
+		echo "  <bridge><stp>false</stp><forward-delay>0</forward-delay><ports>"
+		for (( j = 0; j < PORTS; ++j )) ; do
+			echo "    <port><device>bbr${i}p$j</device></port>"
+		done
+		echo "  </ports></bridge>"
+		echo "  <ipv4:static><address><local>10.33.$i.1/24</local></address></ipv4:static>"
+		echo "</interface>"
+		for (( j = 0; j < PORTS; ++j )) ; do
+			dummy_config bbr${i}p$j "" bbr$i
+		done
+	done > $IFCONFIG/bridge.xml
+
+	for (( i = 0; i < NBONDS; ++i )) ; do
+		echo "<interface>"
+		echo "  <name>bbo$i</name>"
+		echo "  <bond><mode>active-backup</mode>"
+		echo "    <miimon><frequency>100</frequency></miimon>"
+		echo "    <slaves><slave><device>bbo${i}s0</device><primary>true</primary></slave>"
+		echo "    <slave><device>bbo${i}s1</device></slave></slaves>"
+		echo "  </bond>"
+		echo "  <ipv4:static><address><local>10.34.$i.1/24</local></address></ipv4:static>"
+		echo "</interface>"
+		dummy_config bbo${i}s0 "" bbo$i
+		dummy_config bbo${i}s1 "" bbo$i
+	done > $IFCONFIG/bond.xml
+}
+
+# wicked does not create veth pairs, they stand in for the hardware
+for (( i = 0; i < NVLANS; ++i )) ; do
+	ip link add bv$i type veth peer name bvp$i || exit 1
+done
+generate_configs 1
+
+#
+# Daemons
+#
+wait_for_name()
+{
+	local name=$1 n
+
+	for (( n = 0; n < 100; ++n )) ; do
+		if $DBUS_SEND --system --print-reply --dest=org.freedesktop.DBus \
+			/org/freedesktop/DBus org.freedesktop.DBus.NameHasOwner \
+			string:$name 2>/dev/null | grep -q "boolean true" ; then
+			return 0
+		fi
+		sleep 0.1
+	done
+	echo "ERR: $name did not appear on the bus" >&2
+	return 1
+}
+
+$WICKEDD --foreground --config $CONFDIR/server.xml \
+	--log-target stderr > $WORKDIR/wickedd.log 2>&1 &
+WICKEDD_PID=$!
+PIDS="$WICKEDD_PID $PIDS"
+wait_for_name org.opensuse.Network || exit 1
+
+$NANNY --foreground --config $CONFDIR/nanny.xml \
+	--log-target stderr > $WORKDIR/nanny.log 2>&1 &
+NANNY_PID=$!
+PIDS="$NANNY_PID $PIDS"
+wait_for_name org.opensuse.Network.Nanny || exit 1
+
+$DBUS_MONITOR --system --profile > $WORKDIR/dbus.log 2>/dev/null &
+PIDS="$! $PIDS"
+
+#
+# Measurements
+#
+now_ms()
+{
+	echo $(( `date +%s%N` / 1000000 ))
+}
+
+cpu_ms()
+{
+	local pid=$1 stat
+
+	stat=(`sed -e 's/^.*) //' /proc/$pid/stat 2>/dev/null`)
+	if [ ${#stat[@]} -lt 13 ]; then
+		echo 0
+		return
+	fi
+	# utime and stime are fields 14 and 15, we cut off the first two
+	echo $(( (stat[11] + stat[12]) * 1000 / CLK_TCK ))
+}
+
+peak_rss_kb()
+{
+	local pid=$1
+
+	sed -n -e 's/^VmHWM:[[:space:]]*\([0-9]*\) kB/\1/p' /proc/$pid/status 2>/dev/null || echo 0
+}
+
+dbus_messages()
+{
+	# skip the monitor's own header lines
+	grep -c -v '^#' $WORKDIR/dbus.log
+}
+
+PHASES=""
+
+run_phase()
+{
+	local phase=$1 ; shift
+	local beg end wcpu ncpu msgs status
+
+	sleep 0.5
+	msgs=`dbus_messages`
+	wcpu=`cpu_ms $WICKEDD_PID`
+	ncpu=`cpu_ms $NANNY_PID`
+	beg=`now_ms`
+
+	timeout $TIMEOUT $WICKED --config $CONFDIR/client.xml "$@" \
+		>> $WORKDIR/client.log 2>&1
+	status=$?
+
+	end=`now_ms`
+	sleep 0.5
+
+	[ -n "$PHASES" ] && PHASES="$PHASES,"
+	PHASES="$PHASES
+    \"$phase\": {
+      \"status\": $status,
+      \"wall-ms\": $(( end - beg )),
+      \"wickedd-cpu-ms\": $(( `cpu_ms $WICKEDD_PID` - wcpu )),
+      \"nanny-cpu-ms\": $(( `cpu_ms $NANNY_PID` - ncpu )),
+      \"dbus-messages\": $(( `dbus_messages` - msgs ))
+    }"
+	echo "$phase: status $status, $(( end - beg )) ms" >&2
+}
+
+run_phase ifup ifup --ifconfig $IFCONFIG all
+generate_configs 2
+run_phase ifreload ifreload --ifconfig $IFCONFIG all
+run_phase ifdown ifdown all
+
+OUTPUT="{
+  \"label\": \"$LABEL\",
+  \"date\": \"`date -u +%Y-%m-%dT%H:%M:%SZ`\",
+  \"interfaces\": {
+    \"dummy\": $SCALE,
+    \"vlan\": $NVLANS,
+    \"bridge\": $NBRIDGES,
+    \"bridge-ports\": $(( NBRIDGES * PORTS )),
+    \"bond\": $NBONDS,
+    \"bond-slaves\": $(( NBONDS * 2 ))
+  },
+  \"phases\": {$PHASES
+  },
+  \"peak-rss-kb\": {
+    \"wickedd\": `peak_rss_kb $WICKEDD_PID`,
+    \"nanny\": `peak_rss_kb $NANNY_PID`
+  }
+}"
+
+if [ -n "$REPORT" ]; then
+	echo "$OUTPUT" > "$REPORT"
+else
+	echo "$OUTPUT"
+fi
@@ -0,0 +1,164 @@
+/*
+ *	Subprocess launch latency benchmark
+ *
+ *	Copyright (C) 2026 SUSE Linux GmbH, Nuernberg, Germany.
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	This program is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along
+ *	with this program; if not, see <http://www.gnu.org/licenses/> or write
+ *	to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *	Boston, MA 02110-1301 USA.
+ *
+ *	Usage:
+ *		spawn-bench [-f] [-n rounds] [-c command] [heap-MB ...]
+ *
+ *	Grows the heap to each of the given sizes (default 0 256 1024 MB)
+ *	and measures how long ni_process_run_and_wait needs to start the
+ *	command (default /bin/true) and collect its exit status. With -f,
+ *	the command is started via an exec callback, which forces the fork
+ *	code path, for comparison.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include <wicked/util.h>
+#include <wicked/logging.h>
+#include "process.h"
+
+static int
+exec_command(int argc, char *const argv[], char *const envp[])
+{
+	execve(argv[0], argv, envp);
+	return -1;
+}
+
+static unsigned long
+resident_kb(void)
+{
+	unsigned long size = 0, resident = 0;
+	FILE *fp;
+
+	if ((fp = fopen("/proc/self/statm", "r")) != NULL) {
+		if (fscanf(fp, "%lu %lu", &size, &resident) != 2)
+			resident = 0;
+		fclose(fp);
+	}
+	return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static int
+bench_spawn(ni_shellcmd_t *cmd, ni_bool_t use_fork, unsigned int rounds)
+{
+	struct timeval beg, end;
+	double usecs, total = 0, max = 0;
+	unsigned int r;
+
+	for (r = 0; r < rounds; ++r) {
+		ni_process_t *pi;
+		int rv;
+
+		if (!(pi = ni_process_new(cmd)))
+			return -1;
+		if (use_fork)
+			pi->exec = exec_command;
+
+		gettimeofday(&beg, NULL);
+		rv = ni_process_run_and_wait(pi);
+		gettimeofday(&end, NULL);
+		ni_process_free(pi);
+
+		if (rv != 0) {
+			fprintf(stderr, "ERR: %s failed with status %d\n", cmd->command, rv);
+			return -1;
+		}
+
+		usecs = (end.tv_sec - beg.tv_sec) * 1000000.0 + (end.tv_usec - beg.tv_usec);
+		total += usecs;
+		if (usecs > max)
+			max = usecs;
+	}
+
+	printf("%-5s rss %8lu kB: %u runs, avg %8.1f usec, max %8.1f usec\n",
+		use_fork ? "fork" : "spawn", resident_kb(), rounds,
+		total / rounds, max);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *command = "/bin/true";
+	unsigned int rounds = 100;
+	ni_bool_t use_fork = FALSE;
+	static const char *defsizes[] = { "0", "256", "1024", NULL };
+	const char **sizes = defsizes;
+	ni_shellcmd_t *cmd;
+	size_t heap = 0;
+	char *mem = NULL;
+	int c;
+
+	while ((c = getopt(argc, argv, "fn:c:d")) != EOF) {
+		switch (c) {
+		case 'f':
+			use_fork = TRUE;
+			break;
+		case 'n':
+			rounds = strtoul(optarg, NULL, 0);
+			break;
+		case 'c':
+			command = optarg;
+			break;
+		case 'd':
+			ni_enable_debug("extension");
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-f] [-n rounds] [-c command] [heap-MB ...]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (optind < argc)
+		sizes = (const char **)&argv[optind];
+	if (!rounds)
+		rounds = 1;
+
+	if (!(cmd = ni_shellcmd_parse(command))) {
+		fprintf(stderr, "ERR: cannot parse command '%s'\n", command);
+		return 1;
+	}
+
+	for (; *sizes; ++sizes) {
+		size_t size = strtoul(*sizes, NULL, 0) << 20;
+
+		/* grow the heap and touch it, so it is resident */
+		if (size > heap) {
+			if (!(mem = realloc(mem, size))) {
+				fprintf(stderr, "ERR: cannot allocate %s MB\n", *sizes);
+				return 1;
+			}
+			memset(mem + heap, 0x5a, size - heap);
+			heap = size;
+		}
+
+		if (bench_spawn(cmd, use_fork, rounds) < 0)
+			return 1;
+	}
+
+	free(mem);
+	ni_shellcmd_release(cmd);
+	return 0;
+}
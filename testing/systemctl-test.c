@@ -0,0 +1,474 @@
+/*
+ *	systemd D-Bus client test against a mock manager on a private bus
+ *
+ *	Copyright (C) 2026 SUSE Linux GmbH, Nuernberg, Germany.
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	This program is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along
+ *	with this program; if not, see <http://www.gnu.org/licenses/> or write
+ *	to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *	Boston, MA 02110-1301 USA.
+ *
+ *	Starts a dbus-daemon on a private socket, which is used as the
+ *	system bus, and a forked mock of the org.freedesktop.systemd1
+ *	manager. The mock implements Subscribe, StartUnit, StopUnit and
+ *	LoadUnit; each job completes with a JobRemoved signal after a
+ *	fixed delay, units with "fail" in their name fail. The unit
+ *	objects provide the SubState and BusName properties.
+ *
+ *	Exits with 77 (skipped) when dbus-daemon is not available.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <ctype.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+#include <wicked/util.h>
+#include <wicked/logging.h>
+#include <wicked/netinfo.h>
+#include <wicked/socket.h>
+#include <wicked/dbus.h>
+#include <wicked/dbus-service.h>
+
+#include "dbus-server.h"
+#include "systemctl.h"
+#include "util_priv.h"
+
+#define MOCK_BUS_NAME		"org.freedesktop.systemd1"
+#define MOCK_MANAGER_INTERFACE	MOCK_BUS_NAME ".Manager"
+#define MOCK_JOB_MSEC		200
+#define MOCK_PARALLEL_UNITS	8
+
+/*
+ * Mock systemd manager
+ */
+typedef struct mock_unit {
+	char *			name;
+	char *			state;
+	char *			bus_name;
+	char *			path;
+} mock_unit_t;
+
+typedef struct mock_job {
+	unsigned int		id;
+	char *			path;
+	mock_unit_t *		unit;
+	ni_bool_t		start;
+} mock_job_t;
+
+static ni_dbus_server_t *	mock_server;
+static ni_dbus_object_t *	mock_manager;
+static mock_unit_t *		mock_units[64];
+static unsigned int		mock_nunits;
+static unsigned int		mock_jobs;
+
+static ni_dbus_class_t		mock_unit_class = {
+	.name = "mock-unit",
+};
+
+static dbus_bool_t
+mock_unit_get_substate(const ni_dbus_object_t *object, const ni_dbus_property_t *property,
+			ni_dbus_variant_t *result, DBusError *error)
+{
+	mock_unit_t *unit = ni_dbus_object_get_handle(object);
+
+	ni_dbus_variant_set_string(result, unit->state);
+	return TRUE;
+}
+
+static dbus_bool_t
+mock_unit_get_busname(const ni_dbus_object_t *object, const ni_dbus_property_t *property,
+			ni_dbus_variant_t *result, DBusError *error)
+{
+	mock_unit_t *unit = ni_dbus_object_get_handle(object);
+
+	ni_dbus_variant_set_string(result, unit->bus_name);
+	return TRUE;
+}
+
+static const ni_dbus_property_t	mock_unit_properties[] = {
+	{ .name = "SubState", .signature = "s", .get = mock_unit_get_substate },
+	{ NULL }
+};
+static const ni_dbus_property_t	mock_service_properties[] = {
+	{ .name = "BusName", .signature = "s", .get = mock_unit_get_busname },
+	{ NULL }
+};
+static ni_dbus_service_t	mock_unit_service = {
+	.name		= MOCK_BUS_NAME ".Unit",
+	.properties	= mock_unit_properties,
+};
+static ni_dbus_service_t	mock_service_service = {
+	.name		= MOCK_BUS_NAME ".Service",
+	.properties	= mock_service_properties,
+};
+
+/* teamd@team0.service -> unit/teamd_40team0_2eservice */
+static mock_unit_t *
+mock_unit_get(const char *name)
+{
+	ni_stringbuf_t path = NI_STRINGBUF_INIT_DYNAMIC;
+	ni_dbus_object_t *object;
+	mock_unit_t *unit;
+	const char *inst;
+	unsigned int i;
+
+	for (i = 0; i < mock_nunits; ++i) {
+		if (ni_string_eq(mock_units[i]->name, name))
+			return mock_units[i];
+	}
+	if (mock_nunits >= sizeof(mock_units)/sizeof(mock_units[0]))
+		return NULL;
+
+	unit = xcalloc(1, sizeof(*unit));
+	ni_string_dup(&unit->name, name);
+	ni_string_dup(&unit->state, "dead");
+	if ((inst = strchr(name, '@')))
+		ni_string_printf(&unit->bus_name, "org.libteam.teamd.%.*s",
+				(int)strcspn(inst + 1, "."), inst + 1);
+
+	ni_stringbuf_puts(&path, "unit/");
+	for (; *name; ++name) {
+		if (isalnum((unsigned char)*name))
+			ni_stringbuf_putc(&path, *name);
+		else
+			ni_stringbuf_printf(&path, "_%02x", (unsigned char)*name);
+	}
+	object = ni_dbus_server_register_object(mock_server, path.string, &mock_unit_class, unit);
+	ni_dbus_object_register_service(object, &mock_unit_service);
+	ni_dbus_object_register_service(object, &mock_service_service);
+	ni_string_dup(&unit->path, object->path);
+	ni_stringbuf_destroy(&path);
+
+	mock_units[mock_nunits++] = unit;
+	return unit;
+}
+
+static void
+mock_job_complete(void *user_data, const ni_timer_t *timer)
+{
+	ni_dbus_variant_t args[4] = {
+		NI_DBUS_VARIANT_INIT, NI_DBUS_VARIANT_INIT,
+		NI_DBUS_VARIANT_INIT, NI_DBUS_VARIANT_INIT
+	};
+	mock_job_t *job = user_data;
+	const char *result = "done";
+	unsigned int i;
+
+	if (strstr(job->unit->name, "fail"))
+		result = "failed";
+	else
+		ni_string_dup(&job->unit->state, job->start ? "running" : "dead");
+
+	ni_dbus_variant_set_uint32(&args[0], job->id);
+	ni_dbus_variant_set_object_path(&args[1], job->path);
+	ni_dbus_variant_set_string(&args[2], job->unit->name);
+	ni_dbus_variant_set_string(&args[3], result);
+	ni_dbus_server_send_signal(mock_server, mock_manager,
+			MOCK_MANAGER_INTERFACE, "JobRemoved", 4, args);
+
+	for (i = 0; i < 4; ++i)
+		ni_dbus_variant_destroy(&args[i]);
+	ni_string_free(&job->path);
+	free(job);
+}
+
+static dbus_bool_t
+mock_manager_job(ni_dbus_object_t *object, const ni_dbus_method_t *method,
+			unsigned int argc, const ni_dbus_variant_t *argv,
+			ni_dbus_message_t *reply, DBusError *error)
+{
+	const char *name = NULL;
+	mock_job_t *job;
+
+	if (argc != 2 || !ni_dbus_variant_get_string(&argv[0], &name)) {
+		dbus_set_error(error, DBUS_ERROR_INVALID_ARGS, "bad arguments");
+		return FALSE;
+	}
+
+	job = xcalloc(1, sizeof(*job));
+	job->id = ++mock_jobs;
+	job->unit = mock_unit_get(name);
+	job->start = ni_string_eq(method->name, "StartUnit");
+	ni_string_printf(&job->path, "/org/freedesktop/systemd1/job/%u", job->id);
+
+	ni_timer_register(MOCK_JOB_MSEC, mock_job_complete, job);
+	return ni_dbus_message_append_object_path(reply, job->path);
+}
+
+static dbus_bool_t
+mock_manager_load(ni_dbus_object_t *object, const ni_dbus_method_t *method,
+			unsigned int argc, const ni_dbus_variant_t *argv,
+			ni_dbus_message_t *reply, DBusError *error)
+{
+	const char *name = NULL;
+	mock_unit_t *unit;
+
+	if (argc != 1 || !ni_dbus_variant_get_string(&argv[0], &name) ||
+	    !(unit = mock_unit_get(name))) {
+		dbus_set_error(error, DBUS_ERROR_INVALID_ARGS, "bad arguments");
+		return FALSE;
+	}
+	return ni_dbus_message_append_object_path(reply, unit->path);
+}
+
+static dbus_bool_t
+mock_manager_subscribe(ni_dbus_object_t *object, const ni_dbus_method_t *method,
+			unsigned int argc, const ni_dbus_variant_t *argv,
+			ni_dbus_message_t *reply, DBusError *error)
+{
+	return TRUE;
+}
+
+static const ni_dbus_method_t	mock_manager_methods[] = {
+	{ "Subscribe",	"",	.handler = mock_manager_subscribe	},
+	{ "StartUnit",	"ss",	.handler = mock_manager_job		},
+	{ "StopUnit",	"ss",	.handler = mock_manager_job		},
+	{ "LoadUnit",	"s",	.handler = mock_manager_load		},
+	{ NULL }
+};
+static const ni_dbus_method_t	mock_manager_signals[] = {
+	{ "JobRemoved",	"uoss"	},
+	{ NULL }
+};
+static ni_dbus_service_t	mock_manager_service = {
+	.name		= MOCK_MANAGER_INTERFACE,
+	.methods	= mock_manager_methods,
+	.signals	= mock_manager_signals,
+};
+
+static int
+mock_manager_run(int ready)
+{
+	if (!(mock_server = ni_dbus_server_open("system", MOCK_BUS_NAME, NULL)))
+		return 1;
+
+	mock_manager = ni_dbus_server_get_root_object(mock_server);
+	ni_dbus_object_register_service(mock_manager, &mock_manager_service);
+
+	if (write(ready, "", 1) != 1)
+		return 1;
+	close(ready);
+
+	/* until the test terminates us */
+	for (;;)
+		ni_socket_wait(ni_timer_next_timeout());
+	return 0;
+}
+
+/*
+ * Private bus
+ */
+static pid_t
+bus_daemon_start(const char *dir, char **address)
+{
+	char *config = NULL, *arg = NULL, *fdarg = NULL;
+	char buf[512];
+	ssize_t len = 0, cnt;
+	int pfd[2];
+	FILE *fp;
+	pid_t pid;
+
+	ni_string_printf(&config, "%s/bus.conf", dir);
+	if (!(fp = fopen(config, "w")) || pipe(pfd) < 0)
+		return -1;
+	fprintf(fp,	"<busconfig>\n"
+			" <type>system</type>\n"
+			" <listen>unix:path=%s/bus</listen>\n"
+			" <auth>EXTERNAL</auth>\n"
+			" <policy context=\"default\">\n"
+			"  <allow user=\"*\"/>\n"
+			"  <allow own=\"*\"/>\n"
+			"  <allow send_destination=\"*\"/>\n"
+			"  <allow receive_sender=\"*\"/>\n"
+			" </policy>\n"
+			"</busconfig>\n", dir);
+	fclose(fp);
+
+	/* the daemon prints the address when it is ready to accept clients */
+	ni_string_printf(&arg, "--config-file=%s", config);
+	ni_string_printf(&fdarg, "--print-address=%d", pfd[1]);
+	if ((pid = fork()) == 0) {
+		close(pfd[0]);
+		execlp("dbus-daemon", "dbus-daemon", "--nofork", "--nopidfile",
+				arg, fdarg, NULL);
+		_exit(127);
+	}
+	close(pfd[1]);
+
+	while (pid > 0 && len < (ssize_t)sizeof(buf) - 1 &&
+	       (cnt = read(pfd[0], buf + len, sizeof(buf) - 1 - len)) > 0) {
+		len += cnt;
+		if (memchr(buf, '\n', len))
+			break;
+	}
+	close(pfd[0]);
+	buf[len] = '\0';
+	buf[strcspn(buf, "\n")] = '\0';
+
+	if (pid > 0 && !*buf) {
+		kill(pid, SIGTERM);
+		waitpid(pid, NULL, 0);
+		pid = -1;
+	}
+
+	ni_string_dup(address, buf);
+	unlink(config);
+	ni_string_free(&config);
+	ni_string_free(&fdarg);
+	ni_string_free(&arg);
+	return pid;
+}
+
+/*
+ * Client test cases
+ */
+static unsigned int		failed;
+
+#define CHECK(cond)	do { \
+		if (!(cond)) { \
+			ni_error("%s:%d: check failed: %s", __FILE__, __LINE__, #cond); \
+			failed++; \
+		} \
+	} while (0)
+
+static ni_bool_t
+check_property(const char *service, const char *property, const char *expected)
+{
+	char *value = NULL;
+	ni_bool_t ret;
+
+	ret = ni_systemctl_service_show_property(service, property, &value) &&
+		ni_string_eq(value, expected);
+	if (!ret)
+		ni_error("%s: %s='%s', expected '%s'", service, property,
+				value ?: "", expected);
+	ni_string_free(&value);
+	return ret;
+}
+
+static long
+elapsed_msec(const struct timeval *since)
+{
+	struct timeval now, delta;
+
+	ni_timer_get_time(&now);
+	timersub(&now, since, &delta);
+	return delta.tv_sec * 1000 + delta.tv_usec / 1000;
+}
+
+static void
+run_tests(void)
+{
+	ni_string_array_t units = NI_STRING_ARRAY_INIT;
+	struct timeval start;
+	char *value = NULL;
+	unsigned int i;
+	long msec;
+
+	CHECK(ni_systemctl_service_start("teamd@team0.service") == 0);
+	CHECK(check_property("teamd@team0.service", "SubState", "running"));
+	CHECK(check_property("teamd@team0.service", "BusName", "org.libteam.teamd.team0"));
+	CHECK(ni_systemctl_service_show_property("teamd@team0.service", "NoSuchProperty", &value) == NULL);
+
+	/* jobs run in parallel: all of them finish within about one job delay */
+	for (i = 0; i < MOCK_PARALLEL_UNITS; ++i) {
+		char *unit = NULL;
+
+		ni_string_printf(&unit, "pppd@ppp%u.service", i);
+		ni_string_array_append(&units, unit);
+		ni_string_free(&unit);
+	}
+	ni_timer_get_time(&start);
+	CHECK(ni_systemctl_services_start(&units) == 0);
+	msec = elapsed_msec(&start);
+	printf("started %u units in %ld msec\n", units.count, msec);
+	CHECK(msec < MOCK_PARALLEL_UNITS * MOCK_JOB_MSEC / 2);
+	for (i = 0; i < units.count; ++i)
+		CHECK(check_property(units.data[i], "SubState", "running"));
+
+	CHECK(ni_systemctl_services_stop(&units) == 0);
+	CHECK(check_property(units.data[0], "SubState", "dead"));
+
+	/* a failing job fails the batch, the others are still done */
+	ni_string_array_append(&units, "fail@ppp9.service");
+	CHECK(ni_systemctl_services_start(&units) < 0);
+	CHECK(check_property(units.data[0], "SubState", "running"));
+	CHECK(ni_systemctl_service_start("fail@ppp9.service") < 0);
+	ni_string_array_destroy(&units);
+
+	/* the connection is reopened after a failure */
+	CHECK(ni_systemctl_service_stop("teamd@team0.service") == 0);
+	CHECK(check_property("teamd@team0.service", "SubState", "dead"));
+}
+
+int main(int argc, char *argv[])
+{
+	char dir[] = "/tmp/systemctl-test.XXXXXX";
+	char *address = NULL;
+	pid_t daemon, mock;
+	int ready[2];
+	char c;
+
+	(void)argc;
+	(void)argv;
+
+	ni_log_init();
+	if (ni_init("systemctl-test") < 0)
+		return 1;
+
+	if (!mkdtemp(dir))
+		return 1;
+
+	if ((daemon = bus_daemon_start(dir, &address)) < 0) {
+		ni_warn("unable to start a private dbus-daemon, skipping");
+		rmdir(dir);
+		return 77;
+	}
+	setenv("DBUS_SYSTEM_BUS_ADDRESS", address, 1);
+	ni_string_free(&address);
+
+	if (pipe(ready) < 0)
+		return 1;
+	if ((mock = fork()) == 0) {
+		close(ready[0]);
+		_exit(mock_manager_run(ready[1]));
+	}
+	close(ready[1]);
+
+	if (mock < 0 || read(ready[0], &c, 1) != 1) {
+		ni_error("unable to start mock systemd manager");
+		failed++;
+	} else {
+		run_tests();
+	}
+	close(ready[0]);
+
+	if (mock > 0) {
+		kill(mock, SIGTERM);
+		waitpid(mock, NULL, 0);
+	}
+	kill(daemon, SIGTERM);
+	waitpid(daemon, NULL, 0);
+	ni_file_remove_recursively(dir);
+
+	printf("%s\n", failed ? "FAILED" : "OK");
+	return failed ? 1 : 0;
+}